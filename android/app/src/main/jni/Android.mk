@@ -7,7 +7,25 @@ GST_PATH := $(LOCAL_PATH)/../../../../../
 LOCAL_MODULE    := gstplayer
 LOCAL_SRC_FILES := player.c  \
     $(GST_PATH)/lib/gst/player/gstplayer.c \
-    $(GST_PATH)/lib/gst/player/gstplayer-media-info.c
+    $(GST_PATH)/lib/gst/player/gstplayer-media-info.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-subtitle-index.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-cache.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-keyframe-index.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-discoverer.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-playlist.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-resume-store.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-mmap-src.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-media-bytes.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-http-cache.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-abr.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-group.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-frame-cache.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-shared-decode.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-mosaic.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-audio-mixer.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-clip-cache.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-remote-protocol.c \
+    $(GST_PATH)/lib/gst/player/gstplayer-remote-src.c
 LOCAL_C_INCLUDES := $(GST_PATH)/lib
 LOCAL_SHARED_LIBRARIES := gstreamer_android
 LOCAL_LDLIBS := -llog -landroid
@@ -27,6 +45,6 @@ GSTREAMER_NDK_BUILD_PATH  := $(GSTREAMER_ROOT)/share/gst-android/ndk-build/
 
 include $(GSTREAMER_NDK_BUILD_PATH)/plugins.mk
 GSTREAMER_PLUGINS         := $(GSTREAMER_PLUGINS_CORE) $(GSTREAMER_PLUGINS_PLAYBACK) $(GSTREAMER_PLUGINS_CODECS) $(GSTREAMER_PLUGINS_NET) $(GSTREAMER_PLUGINS_SYS) $(GSTREAMER_CODECS_RESTRICTED) $(GSTREAMER_CODECS_GPL) $(GSTREAMER_PLUGINS_ENCODING) $(GSTREAMER_PLUGINS_VIS) $(GSTREAMER_PLUGINS_EFFECTS) $(GSTREAMER_PLUGINS_NET_RESTRICTED)
-GSTREAMER_EXTRA_DEPS      := gstreamer-video-1.0 glib-2.0
+GSTREAMER_EXTRA_DEPS      := gstreamer-video-1.0 gstreamer-net-1.0 glib-2.0 gio-2.0
 
 include $(GSTREAMER_NDK_BUILD_PATH)/gstreamer-1.0.mk
@@ -0,0 +1,456 @@
+/* GStreamer command line playback testing utility - media scanning helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gst-play-scan.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/base/gsttypefindhelper.h>
+
+/* Directories are listed and files are typefound by a pool of threads, so
+ * that slow (network) file systems are accessed concurrently. Results are
+ * collected in a tree that mirrors the directories and are handed out in
+ * tree order as soon as everything before them is known, which keeps the
+ * playlist sorted and lets playback start before the scan is complete */
+
+#define PROBE_SIZE (16 * 1024)
+
+typedef enum
+{
+  SCAN_NODE_PENDING,
+  SCAN_NODE_FILE,
+  SCAN_NODE_DIRECTORY
+} ScanNodeState;
+
+typedef struct _ScanNode ScanNode;
+
+struct _ScanNode
+{
+  ScanNode *parent;
+  guint index;                  /* position in the parent */
+  gchar *path;
+
+  ScanNodeState state;
+  gchar *uri;                   /* NULL for files that are not media */
+  GPtrArray *children;          /* sorted directory entries */
+  guint next_child;             /* first child not handed out yet */
+};
+
+struct _GstPlayScan
+{
+  GThreadPool *pool;
+  /* Demuxers, decoders and parsers, the elements decodebin starts with */
+  GList *factories;
+
+  GMutex lock;
+  ScanNode *root;
+  ScanNode *cursor;
+  gboolean closed;
+  gboolean cancelled;
+  gboolean done;
+  GQueue results;
+  GSource *dispatch_source;
+
+  GstPlayScanFunc scan_func;
+  gpointer user_data;
+};
+
+static void
+scan_node_free (ScanNode * node)
+{
+  if (node->children)
+    g_ptr_array_unref (node->children);
+  g_free (node->path);
+  g_free (node->uri);
+  g_free (node);
+}
+
+static ScanNode *
+scan_node_new (ScanNode * parent, const gchar * path)
+{
+  ScanNode *node;
+
+  node = g_new0 (ScanNode, 1);
+  node->parent = parent;
+  node->path = g_strdup (path);
+  node->state = SCAN_NODE_PENDING;
+
+  if (parent) {
+    node->index = parent->children->len;
+    g_ptr_array_add (parent->children, node);
+  }
+
+  return node;
+}
+
+static guint
+scan_node_depth (const ScanNode * node)
+{
+  guint depth = 0;
+
+  for (; node->parent != NULL; node = node->parent)
+    depth++;
+
+  return depth;
+}
+
+/* Orders nodes like the playlist, so that the pool works on the entries
+ * that are needed first */
+static gint
+scan_node_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const ScanNode *node_a = a, *node_b = b;
+  guint depth_a = scan_node_depth (node_a);
+  guint depth_b = scan_node_depth (node_b);
+  guint depth;
+
+  for (depth = depth_a; depth > depth_b; depth--)
+    node_a = node_a->parent;
+  for (depth = depth_b; depth > depth_a; depth--)
+    node_b = node_b->parent;
+
+  /* A directory comes before its entries */
+  if (node_a == node_b) {
+    if (depth_a == depth_b)
+      return 0;
+    return depth_a < depth_b ? -1 : 1;
+  }
+
+  while (node_a->parent != node_b->parent) {
+    node_a = node_a->parent;
+    node_b = node_b->parent;
+  }
+
+  if (node_a->index == node_b->index)
+    return 0;
+  return node_a->index < node_b->index ? -1 : 1;
+}
+
+static gboolean
+scan_dispatch (gpointer user_data)
+{
+  GstPlayScan *scan = user_data;
+  GQueue results;
+  gboolean done;
+  gchar *uri;
+
+  g_mutex_lock (&scan->lock);
+  results = scan->results;
+  g_queue_init (&scan->results);
+  done = scan->done;
+  g_source_unref (scan->dispatch_source);
+  scan->dispatch_source = NULL;
+  g_mutex_unlock (&scan->lock);
+
+  while ((uri = g_queue_pop_head (&results))) {
+    scan->scan_func (uri, scan->user_data);
+    g_free (uri);
+  }
+
+  if (done)
+    scan->scan_func (NULL, scan->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Hands out the URIs of all entries up to the first one that is not
+ * scanned yet. Must be called with the lock held */
+static void
+scan_advance (GstPlayScan * scan)
+{
+  ScanNode *node = scan->cursor;
+  gboolean queued = FALSE;
+
+  while (!scan->done) {
+    ScanNode *child;
+
+    if (node->next_child == node->children->len) {
+      if (node == scan->root) {
+        if (scan->closed) {
+          scan->done = TRUE;
+          queued = TRUE;
+        }
+        break;
+      }
+
+      /* Directory is complete, its entries are not needed anymore */
+      g_ptr_array_set_size (node->children, 0);
+      node->next_child = 0;
+      node = node->parent;
+      continue;
+    }
+
+    child = g_ptr_array_index (node->children, node->next_child);
+    if (child->state == SCAN_NODE_PENDING)
+      break;
+
+    node->next_child++;
+    if (child->state == SCAN_NODE_DIRECTORY) {
+      node = child;
+    } else if (child->uri) {
+      g_queue_push_tail (&scan->results, child->uri);
+      child->uri = NULL;
+      queued = TRUE;
+    }
+  }
+  scan->cursor = node;
+
+  if (queued && !scan->dispatch_source) {
+    scan->dispatch_source = g_idle_source_new ();
+    g_source_set_callback (scan->dispatch_source, scan_dispatch, scan, NULL);
+    g_source_attach (scan->dispatch_source, NULL);
+  }
+}
+
+static gint
+compare_entries (gconstpointer a, gconstpointer b)
+{
+  return strcmp (((gchar * const *) a)[0], ((gchar * const *) b)[0]);
+}
+
+/* Returns the paths of all entries of @path, sorted by display name */
+static GPtrArray *
+scan_list_directory (const gchar * path)
+{
+  GPtrArray *paths = g_ptr_array_new_with_free_func (g_free);
+  GArray *entries;
+  const gchar *name;
+  GError *err = NULL;
+  GDir *dir;
+  guint i;
+
+  dir = g_dir_open (path, 0, &err);
+  if (!dir) {
+    g_warning ("Could not read directory '%s': %s", path, err->message);
+    g_error_free (err);
+    return paths;
+  }
+
+  /* Pairs of collation key and path */
+  entries = g_array_new (FALSE, FALSE, sizeof (gchar *) * 2);
+  while ((name = g_dir_read_name (dir))) {
+    gchar *display_name = g_filename_display_name (name);
+    gchar *entry[2];
+
+    entry[0] = g_utf8_collate_key_for_filename (display_name, -1);
+    entry[1] = g_build_filename (path, name, NULL);
+    g_array_append_vals (entries, entry, 1);
+    g_free (display_name);
+  }
+  g_dir_close (dir);
+
+  g_array_sort (entries, compare_entries);
+  for (i = 0; i < entries->len; i++) {
+    gchar **entry = &g_array_index (entries, gchar *, 2 * i);
+
+    g_free (entry[0]);
+    g_ptr_array_add (paths, entry[1]);
+  }
+  g_array_free (entries, TRUE);
+
+  return paths;
+}
+
+static gboolean
+scan_caps_are_media (GstPlayScan * scan, GstCaps * caps)
+{
+  const gchar *name;
+  GList *factories;
+  gboolean ret;
+
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+
+  /* Playable, but not on their own in a playlist */
+  if (g_str_has_prefix (name, "text/") || g_str_has_prefix (name, "image/")
+      || g_str_has_prefix (name, "application/x-subtitle"))
+    return FALSE;
+
+  factories = gst_element_factory_list_filter (scan->factories, caps,
+      GST_PAD_SINK, FALSE);
+  ret = factories != NULL;
+  gst_plugin_feature_list_free (factories);
+
+  return ret;
+}
+
+/* Returns the URI of @path if it is media we have elements for */
+static gchar *
+scan_probe (GstPlayScan * scan, const gchar * path)
+{
+  guint8 *data;
+  gsize size = 0;
+  GstCaps *caps = NULL;
+  gchar *uri = NULL;
+  FILE *file;
+
+  file = g_fopen (path, "rb");
+  if (!file)
+    return NULL;
+
+  data = g_malloc (PROBE_SIZE);
+  size = fread (data, 1, PROBE_SIZE, file);
+  fclose (file);
+
+  if (size > 0)
+    caps = gst_type_find_helper_for_data (NULL, data, size, NULL);
+  g_free (data);
+
+  if (caps) {
+    if (scan_caps_are_media (scan, caps))
+      uri = gst_filename_to_uri (path, NULL);
+    else
+      GST_DEBUG ("Skipping %s: %" GST_PTR_FORMAT, path, caps);
+    gst_caps_unref (caps);
+  }
+
+  return uri;
+}
+
+static void
+scan_node_process (ScanNode * node, GstPlayScan * scan)
+{
+  GPtrArray *paths = NULL;
+  gchar *uri = NULL;
+  guint i;
+
+  if (g_file_test (node->path, G_FILE_TEST_IS_DIR)) {
+    paths = scan_list_directory (node->path);
+  } else if (node->parent == scan->root) {
+    /* Given explicitly, so tried even if it doesn't look like media */
+    uri = gst_filename_to_uri (node->path, NULL);
+    if (!uri)
+      g_warning ("Could not make URI out of filename '%s'", node->path);
+  } else {
+    uri = scan_probe (scan, node->path);
+  }
+
+  g_mutex_lock (&scan->lock);
+  if (paths) {
+    node->children =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) scan_node_free);
+    for (i = 0; i < paths->len; i++) {
+      ScanNode *child = scan_node_new (node, g_ptr_array_index (paths, i));
+
+      if (!scan->cancelled)
+        g_thread_pool_push (scan->pool, child, NULL);
+    }
+    node->state = SCAN_NODE_DIRECTORY;
+    g_ptr_array_unref (paths);
+  } else {
+    node->uri = uri;
+    node->state = SCAN_NODE_FILE;
+  }
+  scan_advance (scan);
+  g_mutex_unlock (&scan->lock);
+}
+
+/* At most @max_probes files or directories are accessed at the same time.
+ * @scan_func is called from the default main context */
+GstPlayScan *
+gst_play_scan_new (guint max_probes, GstPlayScanFunc scan_func,
+    gpointer user_data)
+{
+  GstPlayScan *scan;
+
+  scan = g_new0 (GstPlayScan, 1);
+  scan->scan_func = scan_func;
+  scan->user_data = user_data;
+  scan->factories =
+      gst_element_factory_list_get_elements (GST_ELEMENT_FACTORY_TYPE_DEMUXER
+      | GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_PARSER,
+      GST_RANK_MARGINAL);
+
+  g_mutex_init (&scan->lock);
+  g_queue_init (&scan->results);
+  scan->root = scan_node_new (NULL, NULL);
+  scan->root->children =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) scan_node_free);
+  scan->root->state = SCAN_NODE_DIRECTORY;
+  scan->cursor = scan->root;
+
+  scan->pool = g_thread_pool_new ((GFunc) scan_node_process, scan,
+      MAX (max_probes, 1), FALSE, NULL);
+  g_thread_pool_set_sort_function (scan->pool, scan_node_compare, NULL);
+
+  return scan;
+}
+
+/* Adds a file, directory or URI. Results are handed out in the order in
+ * which they were added */
+void
+gst_play_scan_add (GstPlayScan * scan, const gchar * filename)
+{
+  ScanNode *node;
+
+  g_return_if_fail (!scan->closed);
+
+  g_mutex_lock (&scan->lock);
+  node = scan_node_new (scan->root, filename);
+  if (gst_uri_is_valid (filename)) {
+    node->uri = g_strdup (filename);
+    node->state = SCAN_NODE_FILE;
+    scan_advance (scan);
+  } else {
+    g_thread_pool_push (scan->pool, node, NULL);
+  }
+  g_mutex_unlock (&scan->lock);
+}
+
+/* No more inputs are added, the scan completes once they are scanned */
+void
+gst_play_scan_close (GstPlayScan * scan)
+{
+  g_mutex_lock (&scan->lock);
+  scan->closed = TRUE;
+  scan_advance (scan);
+  g_mutex_unlock (&scan->lock);
+}
+
+/* Cancels the scan if it is still running. Must not be called from the
+ * scan function */
+void
+gst_play_scan_free (GstPlayScan * scan)
+{
+  gchar *uri;
+
+  g_mutex_lock (&scan->lock);
+  scan->cancelled = TRUE;
+  g_mutex_unlock (&scan->lock);
+
+  g_thread_pool_free (scan->pool, TRUE, TRUE);
+
+  if (scan->dispatch_source) {
+    g_source_destroy (scan->dispatch_source);
+    g_source_unref (scan->dispatch_source);
+  }
+
+  while ((uri = g_queue_pop_head (&scan->results)))
+    g_free (uri);
+
+  scan_node_free (scan->root);
+  gst_plugin_feature_list_free (scan->factories);
+  g_mutex_clear (&scan->lock);
+  g_free (scan);
+}
@@ -0,0 +1,38 @@
+/* GStreamer command line playback testing utility - media scanning helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef __GST_PLAY_SCAN_INCLUDED__
+#define __GST_PLAY_SCAN_INCLUDED__
+
+#include <glib.h>
+
+typedef struct _GstPlayScan GstPlayScan;
+
+/* Called from the default main context for every media URI found, in
+ * playlist order, and with a NULL @uri once the scan is complete */
+typedef void (*GstPlayScanFunc) (const gchar * uri, gpointer user_data);
+
+GstPlayScan * gst_play_scan_new (guint max_probes, GstPlayScanFunc scan_func,
+    gpointer user_data);
+
+void gst_play_scan_add (GstPlayScan * scan, const gchar * filename);
+
+void gst_play_scan_close (GstPlayScan * scan);
+
+void gst_play_scan_free (GstPlayScan * scan);
+
+#endif /* __GST_PLAY_SCAN_INCLUDED__ */
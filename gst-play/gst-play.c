@@ -30,28 +30,36 @@
 #include <math.h>
 
 #include "gst-play-kb.h"
+#include "gst-play-scan.h"
 #include <gst/player/player.h>
 
 #define VOLUME_STEPS 20
 
+/* Files and directories accessed in parallel while scanning */
+#define SCAN_MAX_PROBES 8
+
 GST_DEBUG_CATEGORY (play_debug);
 #define GST_CAT_DEFAULT play_debug
 
 typedef struct
 {
-  gchar **uris;
-  guint num_uris;
-  gint cur_idx;
+  GstPlayerPlaylist *playlist;
+
+  /* Entries are still being added to the playlist */
+  gboolean scanning;
+  /* Waiting for the scan to play the next entry */
+  gboolean waiting;
 
   GstPlayer *player;
   GstState desired_state;
 
-  gboolean repeat;
+  gboolean shuffle;
 
   GMainLoop *loop;
 } GstPlay;
 
 static gboolean play_next (GstPlay * play);
+static gboolean play_advance (GstPlay * play);
 static gboolean play_prev (GstPlay * play);
 static void play_reset (GstPlay * play);
 static void play_set_relative_volume (GstPlay * play, gdouble volume_step);
@@ -61,7 +69,7 @@ end_of_stream_cb (GstPlayer * player, GstPlay * play)
 {
   g_print ("\n");
   /* and switch to next item in list */
-  if (!play_next (play)) {
+  if (!play_advance (play)) {
     g_print ("Reached end of play list.\n");
     g_main_loop_quit (play->loop);
   }
@@ -70,10 +78,15 @@ end_of_stream_cb (GstPlayer * player, GstPlay * play)
 static void
 error_cb (GstPlayer * player, GError * err, GstPlay * play)
 {
-  g_printerr ("ERROR %s for %s\n", err->message, play->uris[play->cur_idx]);
+  gchar *uri = gst_player_playlist_get_current_uri (play->playlist);
+
+  g_printerr ("ERROR %s for %s\n", err->message, uri);
+  g_free (uri);
 
   /* if looping is enabled, then disable it else will keep looping forever */
-  play->repeat = FALSE;
+  gst_player_playlist_set_repeat_mode (play->playlist,
+      GST_PLAYER_PLAYLIST_REPEAT_NONE);
+  gst_player_unset_loop (play->player);
 
   /* try next item in list then */
   if (!play_next (play)) {
@@ -341,17 +354,17 @@ media_info_cb (GstPlayer * player, GstPlayerMediaInfo * info, GstPlay * play)
 }
 
 static GstPlay *
-play_new (gchar ** uris, gdouble initial_volume)
+play_new (gdouble initial_volume)
 {
   GstPlay *play;
 
   play = g_new0 (GstPlay, 1);
 
-  play->uris = uris;
-  play->num_uris = g_strv_length (uris);
-  play->cur_idx = -1;
+  play->scanning = TRUE;
+  play->waiting = TRUE;
 
   play->player = gst_player_new ();
+  play->playlist = gst_player_playlist_new (play->player);
 
   g_object_set (play->player, "dispatch-to-main-context", TRUE, NULL);
   g_signal_connect (play->player, "position-updated",
@@ -379,11 +392,11 @@ play_free (GstPlay * play)
 {
   play_reset (play);
 
+  g_object_unref (play->playlist);
   gst_object_unref (play->player);
 
   g_main_loop_unref (play->loop);
 
-  g_strfreev (play->uris);
   g_free (play);
 }
 
@@ -441,97 +454,98 @@ play_uri (GstPlay * play, const gchar * next_uri)
 
 /* returns FALSE if we have reached the end of the playlist */
 static gboolean
-play_next (GstPlay * play)
+play_next_uri (GstPlay * play, gchar * (*next_func) (GstPlayerPlaylist *))
 {
-  if ((play->cur_idx + 1) >= play->num_uris) {
-    if (play->repeat) {
-      g_print ("Looping playlist \n");
-      play->cur_idx = -1;
-    }
-    else
-    return FALSE;
+  gchar *uri;
+
+  /* entries are added in order while scanning, wait for the next one
+   * instead of wrapping around */
+  if (play->scanning && gst_player_playlist_get_current_index (play->playlist)
+      + 1 >= gst_player_playlist_get_length (play->playlist)) {
+    /* continued from scan_cb() once the next entry is found */
+    play->waiting = TRUE;
+    return TRUE;
   }
 
-  play_uri (play, play->uris[++play->cur_idx]);
+  uri = next_func (play->playlist);
+  if (uri == NULL)
+    return FALSE;
+
+  play->waiting = FALSE;
+  play_uri (play, uri);
+  g_free (uri);
   return TRUE;
 }
 
-/* returns FALSE if we have reached the beginning of the playlist */
+/* returns FALSE if we have reached the end of the playlist */
 static gboolean
-play_prev (GstPlay * play)
+play_next (GstPlay * play)
 {
-  if (play->cur_idx == 0 || play->num_uris <= 1)
-    return FALSE;
-
-  play_uri (play, play->uris[--play->cur_idx]);
-  return TRUE;
+  return play_next_uri (play, gst_player_playlist_next);
 }
 
-static void
-do_play (GstPlay * play)
+/* like play_next() but after the current entry ended */
+static gboolean
+play_advance (GstPlay * play)
 {
-  gint i;
+  return play_next_uri (play, gst_player_playlist_advance);
+}
 
-  /* dump playlist */
-  for (i = 0; i < play->num_uris; ++i)
-    GST_INFO ("%4u : %s", i, play->uris[i]);
+/* returns FALSE if we have reached the beginning of the playlist */
+static gboolean
+play_prev (GstPlay * play)
+{
+  gchar *uri;
 
-  if (!play_next (play))
-    return;
+  uri = gst_player_playlist_previous (play->playlist);
+  if (uri == NULL)
+    return FALSE;
 
-  g_main_loop_run (play->loop);
+  play->waiting = FALSE;
+  play_uri (play, uri);
+  g_free (uri);
+  return TRUE;
 }
 
+/* Playback starts with the first entry found, unless the playlist is
+ * shuffled which needs all of them */
 static void
-add_to_playlist (GPtrArray * playlist, const gchar * filename)
+scan_cb (const gchar * uri, gpointer user_data)
 {
-  GDir *dir;
-  gchar *uri;
+  GstPlay *play = user_data;
+
+  if (uri != NULL) {
+    GST_INFO ("%4u : %s", gst_player_playlist_get_length (play->playlist),
+        uri);
+    gst_player_playlist_add_uri (play->playlist, uri);
 
-  if (gst_uri_is_valid (filename)) {
-    g_ptr_array_add (playlist, g_strdup (filename));
+    if (play->waiting && !play->shuffle)
+      play_next (play);
     return;
   }
 
-  if ((dir = g_dir_open (filename, 0, NULL))) {
-    const gchar *entry;
-
-    /* FIXME: sort entries for each directory? */
-    while ((entry = g_dir_read_name (dir))) {
-      gchar *path;
+  play->scanning = FALSE;
 
-      path = g_strconcat (filename, G_DIR_SEPARATOR_S, entry, NULL);
-      add_to_playlist (playlist, path);
-      g_free (path);
-    }
+  /* A single repeated entry loops without a gap instead of being reloaded
+   * at every EOS */
+  if (gst_player_playlist_get_length (play->playlist) == 1
+      && gst_player_playlist_get_repeat_mode (play->playlist) !=
+      GST_PLAYER_PLAYLIST_REPEAT_NONE)
+    gst_player_set_loop (play->player, 0, GST_CLOCK_TIME_NONE);
 
-    g_dir_close (dir);
-    return;
+  if (play->waiting && !play_next (play)) {
+    if (gst_player_playlist_get_length (play->playlist) == 0)
+      g_printerr ("No media found.\n");
+    else
+      g_print ("Reached end of play list.\n");
+    g_main_loop_quit (play->loop);
   }
-
-  uri = gst_filename_to_uri (filename, NULL);
-  if (uri != NULL)
-    g_ptr_array_add (playlist, uri);
-  else
-    g_warning ("Could not make URI out of filename '%s'", filename);
 }
 
 static void
-shuffle_uris (gchar ** uris, guint num)
+do_play (GstPlay * play)
 {
-  gchar *tmp;
-  guint i, j;
-
-  if (num < 2)
-    return;
-
-  for (i = 0; i < num; i++) {
-    /* gets equally distributed random number in 0..num-1 [0;num[ */
-    j = g_random_int_range (0, num);
-    tmp = uris[j];
-    uris[j] = uris[i];
-    uris[i] = tmp;
-  }
+  g_main_loop_run (play->loop);
 }
 
 static void
@@ -554,6 +568,14 @@ toggle_paused (GstPlay * play)
     gst_player_pause (play->player);
 }
 
+/* Stepping pauses playback */
+static void
+step_frames (GstPlay * play, gint n_frames)
+{
+  play->desired_state = GST_STATE_PAUSED;
+  gst_player_step (play->player, n_frames);
+}
+
 static void
 relative_seek (GstPlay * play, gdouble percent)
 {
@@ -611,6 +633,12 @@ keyboard_cb (const gchar * key_input, gpointer user_data)
     case '<':
       play_prev (play);
       break;
+    case '.':
+      step_frames (play, 1);
+      break;
+    case ',':
+      step_frames (play, -1);
+      break;
     case 27:                   /* ESC */
       if (key_input[1] == '\0') {
         g_main_loop_quit (play->loop);
@@ -639,14 +667,15 @@ int
 main (int argc, char **argv)
 {
   GstPlay *play;
+  GstPlayScan *scan;
   GPtrArray *playlist;
   gboolean print_version = FALSE;
   gboolean interactive = FALSE; /* FIXME: maybe enable by default? */
   gboolean shuffle = FALSE;
   gboolean repeat = FALSE;
   gdouble volume = 1.0;
+  gint frame_cache = 0;
   gchar **filenames = NULL;
-  gchar **uris;
   guint num, i;
   GError *err = NULL;
   GOptionContext *ctx;
@@ -663,6 +692,9 @@ main (int argc, char **argv)
     {"playlist", 0, 0, G_OPTION_ARG_FILENAME, &playlist_file,
         "Playlist file containing input media files", NULL},
     {"loop", 0, 0, G_OPTION_ARG_NONE, &repeat, "Repeat all", NULL},
+    {"frame-cache", 0, 0, G_OPTION_ARG_INT, &frame_cache,
+        "Megabytes of decoded video frames to keep for stepping back and "
+          "seeking (default: 0, disabled)", "MB"},
     {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL},
     {NULL}
   };
@@ -693,7 +725,8 @@ main (int argc, char **argv)
     return 0;
   }
 
-  playlist = g_ptr_array_new ();
+  /* files, directories and URIs to scan */
+  playlist = g_ptr_array_new_with_free_func (g_free);
 
   if (playlist_file != NULL) {
     gchar *playlist_contents = NULL;
@@ -706,7 +739,7 @@ main (int argc, char **argv)
       for (i = 0; i < num; i++) {
         if (lines[i][0] != '\0') {
           GST_LOG ("Playlist[%d]: %s", i + 1, lines[i]);
-          add_to_playlist (playlist, lines[i]);
+          g_ptr_array_add (playlist, g_strdup (lines[i]));
         }
       }
       g_strfreev (lines);
@@ -736,22 +769,27 @@ main (int argc, char **argv)
     num = g_strv_length (filenames);
     for (i = 0; i < num; ++i) {
       GST_LOG ("command line argument: %s", filenames[i]);
-      add_to_playlist (playlist, filenames[i]);
+      g_ptr_array_add (playlist, g_strdup (filenames[i]));
     }
     g_strfreev (filenames);
   }
 
-  num = playlist->len;
-  g_ptr_array_add (playlist, NULL);
-
-  uris = (gchar **) g_ptr_array_free (playlist, FALSE);
-
-  if (shuffle)
-    shuffle_uris (uris, num);
-
   /* prepare */
-  play = play_new (uris, volume);
-  play->repeat = repeat;
+  play = play_new (volume);
+  play->shuffle = shuffle;
+  gst_player_playlist_set_shuffle (play->playlist, shuffle);
+  if (frame_cache > 0)
+    gst_player_set_frame_cache_size (play->player,
+        (guint64) frame_cache * 1024 * 1024);
+  if (repeat)
+    gst_player_playlist_set_repeat_mode (play->playlist,
+        GST_PLAYER_PLAYLIST_REPEAT_ALL);
+
+  scan = gst_play_scan_new (SCAN_MAX_PROBES, scan_cb, play);
+  for (i = 0; i < playlist->len; ++i)
+    gst_play_scan_add (scan, g_ptr_array_index (playlist, i));
+  gst_play_scan_close (scan);
+  g_ptr_array_unref (playlist);
 
   if (interactive) {
     if (gst_play_kb_set_key_handler (keyboard_cb, play)) {
@@ -765,6 +803,7 @@ main (int argc, char **argv)
   do_play (play);
 
   /* clean up */
+  gst_play_scan_free (scan);
   play_free (play);
 
   g_print ("\n");
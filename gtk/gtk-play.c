@@ -24,6 +24,7 @@
 
 #include <gst/gst.h>
 #include <gst/tag/tag.h>
+#include <gst/video/video.h>
 #include <gst/video/videooverlay.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
@@ -42,6 +43,9 @@
 
 #define APP_NAME "gtk-play"
 
+/* Cover art is decoded by the player to at most this size */
+#define COVER_ART_SIZE 1024
+
 typedef GtkApplication GtkPlayApp;
 typedef GtkApplicationClass GtkPlayAppClass;
 
@@ -54,8 +58,9 @@ typedef struct
   GstPlayer *player;
   gchar *uri;
 
+  /* Initial URIs, moved to the playlist on construction */
   GList *uris;
-  GList *current_uri;
+  GstPlayerPlaylist *playlist;
 
   guint inhibit_cookie;
 
@@ -71,7 +76,12 @@ typedef struct
   GtkWidget *toolbar;
   GdkCursor *default_cursor;
   gulong seekbar_value_changed_signal_id;
+  gboolean scrubbing;
   GdkPixbuf *image_pixbuf;
+  /* At most one cover art is decoded at a time. While it is, only the
+   * media whose cover art was requested last is remembered */
+  gboolean cover_art_pending;
+  GstPlayerMediaInfo *cover_art_wanted;
   gboolean playing;
   gboolean loop;
   gboolean fullscreen;
@@ -196,7 +206,34 @@ play_pause_clicked_cb (GtkButton * button, GtkPlay * play)
 }
 
 static void
-play_current_uri (GtkPlay * play, GList * uri, const gchar * ext_suburi)
+update_skip_buttons (GtkPlay * play)
+{
+  gtk_widget_set_sensitive (play->prev_button,
+      gst_player_playlist_has_previous (play->playlist));
+  gtk_widget_set_sensitive (play->next_button,
+      gst_player_playlist_has_next (play->playlist));
+}
+
+/* A single repeated entry loops without a gap instead of being reloaded
+ * at every EOS */
+static void
+update_loop (GtkPlay * play)
+{
+  gboolean loop = gst_player_playlist_get_length (play->playlist) == 1
+      && gst_player_playlist_get_repeat_mode (play->playlist) !=
+      GST_PLAYER_PLAYLIST_REPEAT_NONE;
+
+  if (loop == gst_player_get_loop (play->player, NULL, NULL))
+    return;
+
+  if (loop)
+    gst_player_set_loop (play->player, 0, GST_CLOCK_TIME_NONE);
+  else
+    gst_player_unset_loop (play->player);
+}
+
+static void
+play_current_uri (GtkPlay * play, const gchar * uri, const gchar * ext_suburi)
 {
   /* reset the button/widget state to default */
   if (play->image_pixbuf)
@@ -204,15 +241,14 @@ play_current_uri (GtkPlay * play, GList * uri, const gchar * ext_suburi)
   play->image_pixbuf = NULL;
   gtk_widget_set_sensitive (play->media_info_button, FALSE);
   gtk_range_set_range (GTK_RANGE (play->seekbar), 0, 0);
-  gtk_widget_set_sensitive (play->prev_button, g_list_previous (uri) != NULL);
-  gtk_widget_set_sensitive (play->next_button, g_list_next (uri) != NULL);
+  update_skip_buttons (play);
+  update_loop (play);
 
   /* set uri or suburi */
   if (ext_suburi)
     gst_player_set_subtitle_uri (play->player, ext_suburi);
   else
-    gst_player_set_uri (play->player, uri->data);
-  play->current_uri = uri;
+    gst_player_set_uri (play->player, uri);
   if (play->playing) {
     if (play->inhibit_cookie)
       gtk_application_uninhibit (GTK_APPLICATION (g_application_get_default ()),
@@ -228,18 +264,19 @@ play_current_uri (GtkPlay * play, GList * uri, const gchar * ext_suburi)
           play->inhibit_cookie);
     play->inhibit_cookie = 0;
   }
-  set_title (play, uri->data);
+  set_title (play, uri);
 }
 
 static void
 skip_prev_clicked_cb (GtkButton * button, GtkPlay * play)
 {
-  GList *prev;
+  gchar *prev;
 
-  prev = g_list_previous (play->current_uri);
+  prev = gst_player_playlist_previous (play->playlist);
   g_return_if_fail (prev != NULL);
 
   play_current_uri (play, prev, NULL);
+  g_free (prev);
 }
 
 static gboolean
@@ -376,27 +413,33 @@ open_file_dialog (GtkPlay * play, gboolean multi)
 static void
 open_file_clicked_cb (GtkWidget * unused, GtkPlay * play)
 {
-  GList *uris;
+  GList *uris, *l;
+  gchar *uri;
 
   uris = open_file_dialog (play, TRUE);
   if (uris) {
-    /* free existing playlist */
-    g_list_free_full (play->uris, g_free);
-
-    play->uris = uris;
-    play_current_uri (play, g_list_first (play->uris), NULL);
+    /* replace existing playlist */
+    gst_player_playlist_clear (play->playlist);
+    for (l = uris; l != NULL; l = l->next)
+      gst_player_playlist_add_uri (play->playlist, l->data);
+    g_list_free_full (uris, g_free);
+
+    uri = gst_player_playlist_set_current_index (play->playlist, 0);
+    play_current_uri (play, uri, NULL);
+    g_free (uri);
   }
 }
 
 static void
 skip_next_clicked_cb (GtkButton * button, GtkPlay * play)
 {
-  GList *next;
+  gchar *next;
 
-  next = g_list_next (play->current_uri);
+  next = gst_player_playlist_next (play->playlist);
   g_return_if_fail (next != NULL);
 
   play_current_uri (play, next, NULL);
+  g_free (next);
 }
 
 static const gchar *
@@ -738,6 +781,16 @@ toolbar_hide_func (GtkPlay * play)
   return FALSE;
 }
 
+static void
+repeat_toggle_cb (GtkToggleButton * widget, GtkPlay * play)
+{
+  gst_player_playlist_set_repeat_mode (play->playlist,
+      gtk_toggle_button_get_active (widget) ?
+      GST_PLAYER_PLAYLIST_REPEAT_ALL : GST_PLAYER_PLAYLIST_REPEAT_NONE);
+  update_skip_buttons (play);
+  update_loop (play);
+}
+
 static void
 fullscreen_toggle_cb (GtkToggleButton * widget, GtkPlay * play)
 {
@@ -771,7 +824,36 @@ static void
 seekbar_value_changed_cb (GtkRange * range, GtkPlay * play)
 {
   gdouble value = gtk_range_get_value (GTK_RANGE (play->seekbar));
-  gst_player_seek (play->player, gst_util_uint64_scale (value, GST_SECOND, 1));
+  GstClockTime position = gst_util_uint64_scale (value, GST_SECOND, 1);
+
+  if (play->scrubbing)
+    gst_player_scrub_update (play->player, position);
+  else
+    gst_player_seek (play->player, position);
+}
+
+static gboolean
+seekbar_button_press_cb (GtkWidget * widget, GdkEventButton * event,
+    GtkPlay * play)
+{
+  if (!play->scrubbing) {
+    play->scrubbing = TRUE;
+    gst_player_scrub_begin (play->player);
+  }
+
+  return FALSE;
+}
+
+static gboolean
+seekbar_button_release_cb (GtkWidget * widget, GdkEventButton * event,
+    GtkPlay * play)
+{
+  if (play->scrubbing) {
+    play->scrubbing = FALSE;
+    gst_player_scrub_end (play->player);
+  }
+
+  return FALSE;
 }
 
 void
@@ -847,10 +929,13 @@ static void
 new_subtitle_clicked_cb (GtkWidget * unused, GtkPlay * play)
 {
   GList *uri;
+  gchar *current_uri;
 
   uri = open_file_dialog (play, FALSE);
   if (uri) {
-    play_current_uri (play, play->current_uri, uri->data);
+    current_uri = gst_player_playlist_get_current_uri (play->playlist);
+    play_current_uri (play, current_uri, uri->data);
+    g_free (current_uri);
     g_list_free_full (uri, g_free);
   }
 }
@@ -1169,10 +1254,10 @@ gtk_player_popup_menu_create (GtkPlay * play, GdkEventButton * event)
     gtk_widget_set_sensitive (sub, FALSE);
   }
 
-  gtk_widget_set_sensitive (next, g_list_next
-      (play->current_uri) ? TRUE : FALSE);
-  gtk_widget_set_sensitive (prev, g_list_previous
-      (play->current_uri) ? TRUE : FALSE);
+  gtk_widget_set_sensitive (next,
+      gtk_widget_get_sensitive (play->next_button));
+  gtk_widget_set_sensitive (prev,
+      gtk_widget_get_sensitive (play->prev_button));
   gtk_widget_set_sensitive (info, media_info ? TRUE : FALSE);
   gtk_widget_set_sensitive (cb, gst_player_has_color_balance (play->player) ?
       TRUE : FALSE);
@@ -1377,6 +1462,10 @@ create_ui (GtkPlay * play)
   play->seekbar_value_changed_signal_id =
       g_signal_connect (G_OBJECT (play->seekbar), "value-changed",
       G_CALLBACK (seekbar_value_changed_cb), play);
+  g_signal_connect (G_OBJECT (play->seekbar), "button-press-event",
+      G_CALLBACK (seekbar_button_press_cb), play);
+  g_signal_connect (G_OBJECT (play->seekbar), "button-release-event",
+      G_CALLBACK (seekbar_button_release_cb), play);
 
   /* Skip backward button */
   play->prev_button =
@@ -1399,6 +1488,8 @@ create_ui (GtkPlay * play)
   image = gtk_image_new_from_icon_name ("media-playlist-repeat",
       GTK_ICON_SIZE_BUTTON);
   gtk_button_set_image (GTK_BUTTON (play->repeat_button), image);
+  g_signal_connect (G_OBJECT (play->repeat_button), "toggled",
+      G_CALLBACK (repeat_toggle_cb), play);
   if (play->loop)
     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (play->repeat_button),
         TRUE);
@@ -1465,6 +1556,10 @@ duration_changed_cb (GstPlayer * unused, GstClockTime duration, GtkPlay * play)
 static void
 position_updated_cb (GstPlayer * unused, GstClockTime position, GtkPlay * play)
 {
+  /* Don't move the slider away from under the user */
+  if (play->scrubbing)
+    return;
+
   g_signal_handler_block (play->seekbar, play->seekbar_value_changed_signal_id);
   gtk_range_set_value (GTK_RANGE (play->seekbar),
       (gdouble) position / GST_SECOND);
@@ -1476,15 +1571,12 @@ static void
 eos_cb (GstPlayer * unused, GtkPlay * play)
 {
   if (play->playing) {
-    GList *next = NULL;
-
-    next = g_list_next (play->current_uri);
-    if (!next && gtk_toggle_button_get_active
-        (GTK_TOGGLE_BUTTON (play->repeat_button)))
-      next = g_list_first (play->uris);
+    gchar *next;
 
+    next = gst_player_playlist_advance (play->playlist);
     if (next) {
       play_current_uri (play, next, NULL);
+      g_free (next);
     } else {
       GtkWidget *image;
 
@@ -1516,18 +1608,12 @@ _has_active_stream (GtkPlay * play, void *(*func) (GstPlayer * player))
   return FALSE;
 }
 
-static GdkPixbuf *
-gst_sample_to_pixbuf (GtkPlay * play, GstSample * sample)
+static gboolean
+is_front_cover (GstSample * sample)
 {
-  GdkPixbufLoader *loader;
-  GdkPixbuf *pixbuf = NULL;
-  GError *err = NULL;
-  GstMapInfo info;
-  GstBuffer *buffer;
   const GstStructure *caps_struct;
   GstTagImageType type = GST_TAG_IMAGE_TYPE_UNDEFINED;
 
-  buffer = gst_sample_get_buffer (sample);
   caps_struct = gst_sample_get_info (sample);
 
   /* if sample is retrieved from preview-image tag then caps struct
@@ -1541,30 +1627,94 @@ gst_sample_to_pixbuf (GtkPlay * play, GstSample * sample)
       (type != GST_TAG_IMAGE_TYPE_UNDEFINED) &&
       (type != GST_TAG_IMAGE_TYPE_NONE)) {
     g_print ("unsupport type ... %d \n", type);
-    return NULL;
+    return FALSE;
   }
 
-  if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
-    g_print ("failed to map gst buffer \n");
+  return TRUE;
+}
+
+/* Wraps the RGB cover art decoded by the player, nothing is decoded here */
+static GdkPixbuf *
+gst_sample_to_pixbuf (GstSample * sample)
+{
+  GdkPixbuf *pixbuf, *copy;
+  GstVideoFrame frame;
+  GstVideoInfo info;
+
+  if (!gst_video_info_from_caps (&info, gst_sample_get_caps (sample)) ||
+      !gst_video_frame_map (&frame, &info, gst_sample_get_buffer (sample),
+          GST_MAP_READ)) {
+    g_print ("failed to map cover art \n");
     return NULL;
   }
 
-  loader = gdk_pixbuf_loader_new ();
-  if (gdk_pixbuf_loader_write (loader, info.data, info.size, &err) &&
-      gdk_pixbuf_loader_close (loader, &err)) {
-    pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
-    if (pixbuf) {
-      g_object_ref (pixbuf);
-    } else {
-      g_print ("failed to convert gst buffer to pixbuf %s \n", err->message);
-      g_error_free (err);
-    }
-  }
+  pixbuf = gdk_pixbuf_new_from_data (GST_VIDEO_FRAME_PLANE_DATA (&frame, 0),
+      GDK_COLORSPACE_RGB, FALSE, 8, GST_VIDEO_FRAME_WIDTH (&frame),
+      GST_VIDEO_FRAME_HEIGHT (&frame), GST_VIDEO_FRAME_PLANE_STRIDE (&frame,
+          0), NULL, NULL);
+  copy = gdk_pixbuf_copy (pixbuf);
+  g_object_unref (pixbuf);
+  gst_video_frame_unmap (&frame);
 
-  g_object_unref (loader);
-  gst_buffer_unmap (buffer, &info);
+  return copy;
+}
 
-  return pixbuf;
+static void
+set_cover_art (GtkPlay * play, GstSample * sample)
+{
+  if (play->image_pixbuf)
+    g_object_unref (play->image_pixbuf);
+  play->image_pixbuf = sample ? gst_sample_to_pixbuf (sample) : NULL;
+
+  gtk_widget_queue_draw (play->image_area);     /* send expose event to widget */
+}
+
+static void
+set_cover_art_wanted (GtkPlay * play, GstPlayerMediaInfo * media_info)
+{
+  if (play->cover_art_wanted)
+    g_object_unref (play->cover_art_wanted);
+  play->cover_art_wanted = media_info ? g_object_ref (media_info) : NULL;
+}
+
+static void
+request_cover_art (GtkPlay * play, GstPlayerMediaInfo * media_info)
+{
+  set_cover_art_wanted (play, media_info);
+  if (play->cover_art_pending)
+    return;
+
+  play->cover_art_pending = TRUE;
+  gst_player_request_cover_art (play->player, media_info, COVER_ART_SIZE,
+      COVER_ART_SIZE);
+}
+
+static void
+cover_art_ready_cb (GstPlayer * player, GstPlayerMediaInfo * media_info,
+    GstSample * sample, GtkPlay * play)
+{
+  GstPlayerMediaInfo *wanted;
+  gchar *uri;
+
+  play->cover_art_pending = FALSE;
+
+  /* media changed while decoding, skip to the last requested one */
+  wanted = play->cover_art_wanted;
+  play->cover_art_wanted = NULL;
+  if (wanted && g_strcmp0 (gst_player_media_info_get_uri (wanted),
+          gst_player_media_info_get_uri (media_info))) {
+    request_cover_art (play, wanted);
+    g_object_unref (wanted);
+    return;
+  }
+  if (wanted)
+    g_object_unref (wanted);
+
+  /* ignore results for media that is not playing anymore */
+  uri = gst_player_get_uri (player);
+  if (!g_strcmp0 (uri, gst_player_media_info_get_uri (media_info)))
+    set_cover_art (play, sample);
+  g_free (uri);
 }
 
 static void
@@ -1581,14 +1731,28 @@ display_cover_art (GtkPlay * play, GstPlayerMediaInfo * media_info)
   if (!media_info)
     temp_media_info = media_info = gst_player_get_media_info (play->player);
 
+  /* nothing to decode for this media, unless requested below */
+  set_cover_art_wanted (play, NULL);
+
   sample = gst_player_media_info_get_image_sample (media_info);
   if (!sample)
     goto cleanup;
 
-  if (play->image_pixbuf)
-    g_object_unref (play->image_pixbuf);
+  if (!is_front_cover (sample)) {
+    set_cover_art (play, NULL);
+    goto cleanup;
+  }
 
-  play->image_pixbuf = gst_sample_to_pixbuf (play, sample);
+  /* decoded already, otherwise it is decoded in the background and shown
+   * from cover_art_ready_cb() */
+  sample = gst_player_media_info_get_cover_art (media_info, COVER_ART_SIZE,
+      COVER_ART_SIZE);
+  if (sample) {
+    set_cover_art (play, sample);
+    gst_sample_unref (sample);
+  } else {
+    request_cover_art (play, media_info);
+  }
 
 cleanup:
   gtk_widget_queue_draw (play->image_area);     /* send expose event to widget */
@@ -1694,11 +1858,14 @@ static void
 show_cb (GtkWidget * widget, gpointer user_data)
 {
   GtkPlay *self = (GtkPlay *) widget;
+  gchar *uri;
 
   self->default_cursor = gdk_window_get_cursor
       (gtk_widget_get_window (GTK_WIDGET (self)));
 
-  play_current_uri (self, g_list_first (self->uris), NULL);
+  uri = gst_player_playlist_set_current_index (self->playlist, 0);
+  play_current_uri (self, uri, NULL);
+  g_free (uri);
 }
 
 static GObject *
@@ -1706,6 +1873,7 @@ gtk_play_constructor (GType type, guint n_construct_params,
     GObjectConstructParam * construct_params)
 {
   GtkPlay *self;
+  GList *l;
 
   self =
       (GtkPlay *) G_OBJECT_CLASS (gtk_play_parent_class)->constructor (type,
@@ -1714,6 +1882,12 @@ gtk_play_constructor (GType type, guint n_construct_params,
   self->player = gst_player_new ();
   self->playing = TRUE;
 
+  self->playlist = gst_player_playlist_new (self->player);
+  for (l = self->uris; l != NULL; l = l->next)
+    gst_player_playlist_add_uri (self->playlist, l->data);
+  g_list_free_full (self->uris, g_free);
+  self->uris = NULL;
+
   if (self->inhibit_cookie)
     gtk_application_uninhibit (GTK_APPLICATION (g_application_get_default ()),
         self->inhibit_cookie);
@@ -1745,6 +1919,8 @@ gtk_play_constructor (GType type, guint n_construct_params,
   g_signal_connect (self->player, "end-of-stream", G_CALLBACK (eos_cb), self);
   g_signal_connect (self->player, "media-info-updated",
       G_CALLBACK (media_info_updated_cb), self);
+  g_signal_connect (self->player, "cover-art-ready",
+      G_CALLBACK (cover_art_ready_cb), self);
   g_signal_connect (self->player, "volume-changed",
       G_CALLBACK (player_volume_changed_cb), self);
 
@@ -1770,6 +1946,12 @@ gtk_play_dispose (GObject * object)
   if (self->uris)
     g_list_free_full (self->uris, g_free);
   self->uris = NULL;
+  if (self->playlist)
+    g_object_unref (self->playlist);
+  self->playlist = NULL;
+  if (self->cover_art_wanted)
+    g_object_unref (self->cover_art_wanted);
+  self->cover_art_wanted = NULL;
   if (self->player) {
     gst_player_stop (self->player);
     g_object_unref (self->player);
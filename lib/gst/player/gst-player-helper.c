@@ -0,0 +1,622 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Decoding process of the remote decoding source of GstPlayer.
+ *
+ * Decodes the URI given on the command line and sends the decoded streams
+ * to the player over the socket it inherits as GST_PLAYER_REMOTE_FD. The
+ * data of every stream is written into a ring in shared memory, the
+ * player wraps it in its buffers and sends the space back once they are
+ * gone. Decoding waits while the ring of a stream is full. The process
+ * exits when the player closes the socket. */
+
+#include <gst/gst.h>
+
+#include "gstplayer-remote-protocol.h"
+
+#ifdef G_OS_UNIX
+#include <gst/video/video.h>
+#include <glib-unix.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* Rings hold at least this much, and a few frames of video */
+#define RING_MIN_SIZE (1024 * 1024)
+#define RING_VIDEO_FRAMES 8
+/* Offset alignment of the buffers in a ring */
+#define RING_ALIGN 64
+
+GST_DEBUG_CATEGORY_STATIC (helper_debug);
+#define GST_CAT_DEFAULT helper_debug
+
+typedef struct
+{
+  guint64 offset;
+  guint64 size;
+  gboolean released;
+} Chunk;
+
+typedef struct _GstPlayerHelper GstPlayerHelper;
+
+typedef struct
+{
+  GstPlayerHelper *helper;
+  guint index;
+  guint8 *ring;
+  gsize ring_size;
+
+  /* Protected by the lock of the helper */
+  GQueue chunks;                /* Chunk, oldest first */
+  guint64 head;
+  guint epoch;
+  gboolean flushing;
+} Stream;
+
+struct _GstPlayerHelper
+{
+  gint fd;
+  GMainLoop *loop;
+  GstElement *pipeline;
+
+  /* Serializes the messages of all threads */
+  GMutex send_lock;
+
+  GMutex lock;
+  GCond cond;
+  /* Protected by lock */
+  GPtrArray *streams;
+  guint epoch;
+  gboolean stopping;
+  GstClockTime duration;
+  gboolean seekable;
+};
+
+static void
+stream_free (Stream * stream)
+{
+  g_queue_foreach (&stream->chunks, (GFunc) g_free, NULL);
+  g_queue_clear (&stream->chunks);
+  if (stream->ring)
+    munmap (stream->ring, stream->ring_size);
+  g_free (stream);
+}
+
+static void
+helper_send (GstPlayerHelper * helper, GstPlayerRemoteMessageType type,
+    guint stream, guint epoch, gconstpointer payload, gsize payload_size,
+    gconstpointer data, gsize data_size, gint pass_fd)
+{
+  g_mutex_lock (&helper->send_lock);
+  if (!gst_player_remote_send (helper->fd, type, stream, epoch, payload,
+          payload_size, data, data_size, pass_fd))
+    GST_DEBUG ("Failed to send message %d, player is gone", type);
+  g_mutex_unlock (&helper->send_lock);
+}
+
+/* Sends a message about @stream, stamped with its current epoch */
+static void
+stream_send (Stream * stream, GstPlayerRemoteMessageType type,
+    gconstpointer payload, gsize payload_size, gconstpointer data,
+    gsize data_size)
+{
+  GstPlayerHelper *helper = stream->helper;
+  guint epoch;
+
+  g_mutex_lock (&helper->lock);
+  epoch = stream->epoch;
+  g_mutex_unlock (&helper->lock);
+
+  helper_send (helper, type, stream->index, epoch, payload, payload_size,
+      data, data_size, -1);
+}
+
+/* Takes @size bytes of the ring, returns FALSE if they are not free */
+static gboolean
+ring_alloc_locked (Stream * stream, gsize size, guint64 * offset)
+{
+  Chunk *tail, *chunk;
+  guint64 start;
+
+  tail = g_queue_peek_head (&stream->chunks);
+  if (!tail) {
+    start = 0;
+  } else if (stream->head > tail->offset) {
+    if (stream->head + size <= stream->ring_size) {
+      start = stream->head;
+    } else if (size < tail->offset) {
+      /* Buffers are contiguous, the end of the ring is skipped */
+      chunk = g_new0 (Chunk, 1);
+      chunk->offset = stream->head;
+      chunk->size = stream->ring_size - stream->head;
+      chunk->released = TRUE;
+      g_queue_push_tail (&stream->chunks, chunk);
+      start = 0;
+    } else {
+      return FALSE;
+    }
+  } else if (stream->head + size < tail->offset) {
+    start = stream->head;
+  } else {
+    return FALSE;
+  }
+
+  chunk = g_new0 (Chunk, 1);
+  chunk->offset = start;
+  chunk->size = size;
+  g_queue_push_tail (&stream->chunks, chunk);
+  stream->head = start + size;
+  *offset = start;
+
+  return TRUE;
+}
+
+static void
+ring_release_locked (Stream * stream, guint64 offset)
+{
+  Chunk *chunk;
+  GList *l;
+
+  for (l = stream->chunks.head; l; l = l->next) {
+    chunk = l->data;
+    if (chunk->offset == offset && !chunk->released) {
+      chunk->released = TRUE;
+      break;
+    }
+  }
+
+  /* Buffers may be released in any order, the space only becomes free
+   * up to the oldest one still in use */
+  while ((chunk = g_queue_peek_head (&stream->chunks)) && chunk->released)
+    g_free (g_queue_pop_head (&stream->chunks));
+}
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    Stream * stream)
+{
+  GstPlayerHelper *helper = stream->helper;
+  GstPlayerRemoteBuffer msg;
+  GstMapInfo map;
+  guint64 offset = 0;
+  gsize size;
+  guint epoch;
+
+  size = gst_buffer_get_size (buffer);
+  msg.size = size;
+  msg.pts = GST_BUFFER_PTS (buffer);
+  msg.dts = GST_BUFFER_DTS (buffer);
+  msg.duration = GST_BUFFER_DURATION (buffer);
+  msg.flags = GST_BUFFER_FLAGS (buffer);
+
+  /* Buffers taking more than half of the ring would stall decoding until
+   * the player released nearly all others */
+  if (size == 0 || size > stream->ring_size / 2) {
+    GST_LOG ("Sending buffer of %" G_GSIZE_FORMAT " bytes of stream %u "
+        "inline", size, stream->index);
+    gst_buffer_map (buffer, &map, GST_MAP_READ);
+    msg.offset = GST_PLAYER_REMOTE_INLINE;
+    msg.sent_time = g_get_monotonic_time ();
+    stream_send (stream, GST_PLAYER_REMOTE_BUFFER, &msg, sizeof (msg),
+        map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+    return;
+  }
+
+  g_mutex_lock (&helper->lock);
+  while (!stream->flushing && !helper->stopping
+      && !ring_alloc_locked (stream, GST_ROUND_UP_N (size, RING_ALIGN),
+          &offset))
+    g_cond_wait (&helper->cond, &helper->lock);
+  if (stream->flushing || helper->stopping) {
+    g_mutex_unlock (&helper->lock);
+    return;
+  }
+  epoch = stream->epoch;
+  g_mutex_unlock (&helper->lock);
+
+  /* The only copy on the way to the player */
+  gst_buffer_extract (buffer, 0, stream->ring + offset, size);
+
+  msg.offset = offset;
+  msg.sent_time = g_get_monotonic_time ();
+  helper_send (helper, GST_PLAYER_REMOTE_BUFFER, stream->index, epoch, &msg,
+      sizeof (msg), NULL, 0, -1);
+}
+
+static GstPadProbeReturn
+event_probe_cb (GstPad * pad, GstPadProbeInfo * info, Stream * stream)
+{
+  GstPlayerHelper *helper = stream->helper;
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  GstPlayerRemoteTags tags;
+  const GstSegment *segment;
+  GstTagList *list;
+  GstCaps *caps;
+  gchar *str;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+      gst_event_parse_caps (event, &caps);
+      str = gst_caps_to_string (caps);
+      stream_send (stream, GST_PLAYER_REMOTE_CAPS, NULL, 0, str,
+          strlen (str) + 1);
+      g_free (str);
+      break;
+    case GST_EVENT_SEGMENT:
+      gst_event_parse_segment (event, &segment);
+      stream_send (stream, GST_PLAYER_REMOTE_SEGMENT, segment,
+          sizeof (*segment), NULL, 0);
+      break;
+    case GST_EVENT_TAG:
+      gst_event_parse_tag (event, &list);
+      tags.scope = gst_tag_list_get_scope (list);
+      str = gst_tag_list_to_string (list);
+      stream_send (stream, GST_PLAYER_REMOTE_TAGS, &tags, sizeof (tags), str,
+          strlen (str) + 1);
+      g_free (str);
+      break;
+    case GST_EVENT_EOS:
+      stream_send (stream, GST_PLAYER_REMOTE_EOS, NULL, 0, NULL, 0);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      /* Everything from now on is after the last seek of the player */
+      g_mutex_lock (&helper->lock);
+      stream->epoch = helper->epoch;
+      stream->flushing = FALSE;
+      g_mutex_unlock (&helper->lock);
+      break;
+    default:
+      break;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+send_error (GstPlayerHelper * helper, const GError * err, const gchar * debug)
+{
+  GstStructure *s;
+  gchar *str;
+
+  s = gst_structure_new ("error", "domain", G_TYPE_STRING,
+      g_quark_to_string (err->domain), "code", G_TYPE_INT, err->code,
+      "message", G_TYPE_STRING, err->message, "debug", G_TYPE_STRING, debug,
+      NULL);
+  str = gst_structure_to_string (s);
+  helper_send (helper, GST_PLAYER_REMOTE_ERROR, 0, 0, NULL, 0, str,
+      strlen (str) + 1, -1);
+  g_free (str);
+  gst_structure_free (s);
+}
+
+static void
+pad_added_cb (GstElement * decodebin, GstPad * pad, GstPlayerHelper * helper)
+{
+  GstPlayerRemoteStream msg;
+  GstVideoInfo info;
+  GstElement *sink;
+  GstPad *sinkpad;
+  GstCaps *caps;
+  Stream *stream;
+  gchar *str;
+  gint fd;
+
+  caps = gst_pad_get_current_caps (pad);
+  if (!caps)
+    caps = gst_pad_query_caps (pad, NULL);
+
+  stream = g_new0 (Stream, 1);
+  stream->helper = helper;
+  g_queue_init (&stream->chunks);
+  stream->ring_size = RING_MIN_SIZE;
+  if (gst_video_info_from_caps (&info, caps))
+    stream->ring_size = MAX (stream->ring_size,
+        RING_VIDEO_FRAMES * GST_ROUND_UP_N (GST_VIDEO_INFO_SIZE (&info),
+            RING_ALIGN));
+
+  fd = gst_player_remote_ring_new (stream->ring_size);
+  if (fd >= 0) {
+    stream->ring = mmap (NULL, stream->ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    if (stream->ring == MAP_FAILED)
+      stream->ring = NULL;
+  }
+  if (!stream->ring) {
+    GError *err = g_error_new (GST_RESOURCE_ERROR,
+        GST_RESOURCE_ERROR_NO_SPACE_LEFT,
+        "Failed to allocate %" G_GSIZE_FORMAT " bytes of shared memory",
+        stream->ring_size);
+
+    send_error (helper, err, NULL);
+    g_error_free (err);
+    if (fd >= 0)
+      close (fd);
+    gst_caps_unref (caps);
+    g_free (stream);
+    return;
+  }
+
+  g_mutex_lock (&helper->lock);
+  stream->index = helper->streams->len;
+  stream->epoch = helper->epoch;
+  g_ptr_array_add (helper->streams, stream);
+  g_mutex_unlock (&helper->lock);
+
+  GST_DEBUG ("Stream %u with caps %" GST_PTR_FORMAT ", ring of %"
+      G_GSIZE_FORMAT " bytes", stream->index, caps, stream->ring_size);
+
+  msg.ring_size = stream->ring_size;
+  str = gst_caps_to_string (caps);
+  helper_send (helper, GST_PLAYER_REMOTE_STREAM, stream->index,
+      stream->epoch, &msg, sizeof (msg), str, strlen (str) + 1, fd);
+  g_free (str);
+  gst_caps_unref (caps);
+  close (fd);
+
+  /* As fast as the player releases the rings */
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      "enable-last-sample", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), stream);
+  gst_bin_add (GST_BIN (helper->pipeline), sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (sinkpad,
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      (GstPadProbeCallback) event_probe_cb, stream, NULL);
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    GST_WARNING ("Failed to link stream %u", stream->index);
+  gst_object_unref (sinkpad);
+
+  gst_element_sync_state_with_parent (sink);
+}
+
+static void
+no_more_pads_cb (GstElement * decodebin, GstPlayerHelper * helper)
+{
+  helper_send (helper, GST_PLAYER_REMOTE_NO_MORE_STREAMS, 0, 0, NULL, 0,
+      NULL, 0, -1);
+}
+
+static void
+update_duration (GstPlayerHelper * helper)
+{
+  GstPlayerRemoteDuration msg;
+  GstQuery *query;
+  gint64 duration;
+  gboolean seekable = FALSE;
+
+  if (!gst_element_query_duration (helper->pipeline, GST_FORMAT_TIME,
+          &duration))
+    duration = GST_CLOCK_TIME_NONE;
+
+  query = gst_query_new_seeking (GST_FORMAT_TIME);
+  if (gst_element_query (helper->pipeline, query))
+    gst_query_parse_seeking (query, NULL, &seekable, NULL, NULL);
+  gst_query_unref (query);
+
+  g_mutex_lock (&helper->lock);
+  if (duration == helper->duration && seekable == helper->seekable) {
+    g_mutex_unlock (&helper->lock);
+    return;
+  }
+  helper->duration = duration;
+  helper->seekable = seekable;
+  g_mutex_unlock (&helper->lock);
+
+  msg.duration = duration;
+  msg.seekable = seekable;
+  helper_send (helper, GST_PLAYER_REMOTE_DURATION, 0, 0, &msg, sizeof (msg),
+      NULL, 0, -1);
+}
+
+/* Called from the thread posting @msg, the player learns about the
+ * duration before the first buffers are decoded */
+static GstBusSyncReply
+bus_sync_cb (GstBus * bus, GstMessage * msg, GstPlayerHelper * helper)
+{
+  GError *err;
+  gchar *debug;
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:
+      /* The player stops, which ends the helper */
+      gst_message_parse_error (msg, &err, &debug);
+      GST_WARNING ("Decoding failed: %s", err->message);
+      send_error (helper, err, debug);
+      g_error_free (err);
+      g_free (debug);
+      break;
+    case GST_MESSAGE_ASYNC_DONE:
+    case GST_MESSAGE_DURATION_CHANGED:
+      update_duration (helper);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BUS_DROP;
+}
+
+static void
+handle_seek (GstPlayerHelper * helper, guint epoch,
+    const GstPlayerRemoteSeek * seek)
+{
+  Stream *stream;
+  guint i;
+
+  GST_DEBUG ("Seeking to %" GST_TIME_FORMAT " for epoch %u",
+      GST_TIME_ARGS (seek->start), epoch);
+
+  /* Nothing waits for ring space while flushing */
+  g_mutex_lock (&helper->lock);
+  helper->epoch = epoch;
+  for (i = 0; i < helper->streams->len; i++) {
+    stream = g_ptr_array_index (helper->streams, i);
+    stream->flushing = TRUE;
+  }
+  g_cond_broadcast (&helper->cond);
+  g_mutex_unlock (&helper->lock);
+
+  if (!gst_element_seek (helper->pipeline, seek->rate, seek->format,
+          seek->flags | GST_SEEK_FLAG_FLUSH, seek->start_type, seek->start,
+          seek->stop_type, seek->stop))
+    GST_WARNING ("Seek failed");
+
+  /* Streams that were not flushed, or all if the seek failed, continue
+   * where they are */
+  g_mutex_lock (&helper->lock);
+  for (i = 0; i < helper->streams->len; i++) {
+    stream = g_ptr_array_index (helper->streams, i);
+    stream->flushing = FALSE;
+    stream->epoch = epoch;
+  }
+  g_mutex_unlock (&helper->lock);
+}
+
+static gboolean
+control_cb (gint fd, GIOCondition condition, GstPlayerHelper * helper)
+{
+  GstPlayerRemoteHeader header;
+  const GstPlayerRemoteRelease *release;
+  Stream *stream;
+  guint8 *payload;
+
+  if (!gst_player_remote_receive (fd, &header, &payload, NULL)) {
+    GST_DEBUG ("Player is gone");
+    g_main_loop_quit (helper->loop);
+    return G_SOURCE_REMOVE;
+  }
+
+  if (!gst_player_remote_payload_is_valid (&header)) {
+    GST_WARNING ("Dropping short message %u", header.type);
+    g_free (payload);
+    return G_SOURCE_CONTINUE;
+  }
+
+  switch (header.type) {
+    case GST_PLAYER_REMOTE_SEEK:
+      handle_seek (helper, header.epoch,
+          (const GstPlayerRemoteSeek *) payload);
+      break;
+    case GST_PLAYER_REMOTE_RELEASE:
+      release = (const GstPlayerRemoteRelease *) payload;
+      g_mutex_lock (&helper->lock);
+      if (header.stream < helper->streams->len) {
+        stream = g_ptr_array_index (helper->streams, header.stream);
+        ring_release_locked (stream, release->offset);
+        g_cond_broadcast (&helper->cond);
+      }
+      g_mutex_unlock (&helper->lock);
+      break;
+    default:
+      GST_WARNING ("Unexpected message %u", header.type);
+      break;
+  }
+  g_free (payload);
+
+  return G_SOURCE_CONTINUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  GstPlayerHelper helper;
+  GstElement *decodebin;
+  GstBus *bus;
+
+  gst_init (&argc, &argv);
+
+  GST_DEBUG_CATEGORY_INIT (helper_debug, "gst-player-helper", 0,
+      "GstPlayer decoding process");
+
+  if (argc != 2 || !gst_uri_is_valid (argv[1])) {
+    g_printerr ("Usage: %s URI\n"
+        "Decodes URI for GstPlayer, only started by it.\n", argv[0]);
+    return 1;
+  }
+
+  if (fcntl (GST_PLAYER_REMOTE_FD, F_GETFD) < 0) {
+    g_printerr ("No connection to a player\n");
+    return 1;
+  }
+
+  decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  if (!decodebin) {
+    g_printerr ("Missing element 'uridecodebin'\n");
+    return 1;
+  }
+
+  memset (&helper, 0, sizeof (helper));
+  helper.fd = GST_PLAYER_REMOTE_FD;
+  helper.loop = g_main_loop_new (NULL, FALSE);
+  helper.pipeline = gst_pipeline_new ("remote-decode");
+  g_mutex_init (&helper.send_lock);
+  g_mutex_init (&helper.lock);
+  g_cond_init (&helper.cond);
+  helper.streams = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      stream_free);
+  helper.duration = GST_CLOCK_TIME_NONE;
+
+  g_object_set (decodebin, "uri", argv[1], NULL);
+  g_signal_connect (decodebin, "pad-added", G_CALLBACK (pad_added_cb),
+      &helper);
+  g_signal_connect (decodebin, "no-more-pads", G_CALLBACK (no_more_pads_cb),
+      &helper);
+  gst_bin_add (GST_BIN (helper.pipeline), decodebin);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (helper.pipeline));
+  gst_bus_set_sync_handler (bus, (GstBusSyncHandler) bus_sync_cb, &helper,
+      NULL);
+
+  g_unix_fd_add (helper.fd, G_IO_IN | G_IO_HUP | G_IO_ERR,
+      (GUnixFDSourceFunc) control_cb, &helper);
+
+  gst_element_set_state (helper.pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (helper.loop);
+
+  g_mutex_lock (&helper.lock);
+  helper.stopping = TRUE;
+  g_cond_broadcast (&helper.cond);
+  g_mutex_unlock (&helper.lock);
+
+  gst_element_set_state (helper.pipeline, GST_STATE_NULL);
+  gst_bus_set_sync_handler (bus, NULL, NULL, NULL);
+  gst_object_unref (bus);
+  gst_object_unref (helper.pipeline);
+
+  g_ptr_array_free (helper.streams, TRUE);
+  g_cond_clear (&helper.cond);
+  g_mutex_clear (&helper.lock);
+  g_mutex_clear (&helper.send_lock);
+  g_main_loop_unref (helper.loop);
+  close (helper.fd);
+
+  return 0;
+}
+#else
+int
+main (int argc, char **argv)
+{
+  g_printerr ("Decoding in a separate process is not supported here\n");
+
+  return 1;
+}
+#endif
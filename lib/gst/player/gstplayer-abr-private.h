@@ -0,0 +1,38 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_ABR_PRIVATE_H__
+#define __GST_PLAYER_ABR_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerAbr GstPlayerAbr;
+
+G_GNUC_INTERNAL GstPlayerAbr * gst_player_abr_new          (void);
+G_GNUC_INTERNAL void           gst_player_abr_free         (GstPlayerAbr *abr);
+G_GNUC_INTERNAL void           gst_player_abr_reset        (GstPlayerAbr *abr);
+G_GNUC_INTERNAL void           gst_player_abr_add_sample   (GstPlayerAbr *abr,
+                                                            guint64 bytes,
+                                                            GstClockTime download_time);
+G_GNUC_INTERNAL guint64        gst_player_abr_get_estimate (GstPlayerAbr *abr);
+G_GNUC_INTERNAL guint64        gst_player_abr_select       (GstPlayerAbr *abr,
+                                                            gint buffering,
+                                                            guint64 min_bitrate,
+                                                            guint64 max_bitrate);
+
+#endif /* __GST_PLAYER_ABR_PRIVATE_H__ */
@@ -0,0 +1,174 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Adaptive bitrate policy. The throughput is estimated from the fragment
+ * downloads of the adaptive demuxer with two exponentially weighted moving
+ * averages, a fast one that reacts to drops and a slow one that keeps
+ * single fast downloads from causing upswitches. The lower of both is
+ * used.
+ *
+ * The bitrate the demuxer may select is a fraction of the estimate that
+ * depends on how full the buffer is: little of it when the buffer drains,
+ * close to all of it when it is full. Switching up additionally needs a
+ * healthy buffer, switching down happens right away. Until enough was
+ * downloaded for an estimate the lowest allowed bitrate is used, so
+ * playback starts fast and switches up from there. */
+
+#include "gstplayer-abr-private.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Half-lives of the averages, in seconds of download time */
+#define ABR_FAST_HALF_LIFE 2.0
+#define ABR_SLOW_HALF_LIFE 5.0
+/* Downloads smaller than this are dominated by latency */
+#define ABR_MIN_SAMPLE_BYTES (16 * 1024)
+/* Download time needed before the estimate is used */
+#define ABR_MIN_TOTAL_TIME 0.5
+/* Buffer fill below which the selection switches down more aggressively */
+#define ABR_LOW_BUFFER 25
+/* Buffer fill needed to switch up */
+#define ABR_UPSWITCH_BUFFER 50
+/* Relative change of the selection below which it is kept */
+#define ABR_MIN_CHANGE 0.1
+
+typedef struct
+{
+  gdouble half_life;
+  gdouble estimate;
+  gdouble total_weight;
+} Ewma;
+
+struct _GstPlayerAbr
+{
+  Ewma fast;
+  Ewma slow;
+  gdouble total_time;
+  guint64 selected;
+};
+
+static void
+ewma_sample (Ewma * ewma, gdouble weight, gdouble value)
+{
+  gdouble alpha = pow (0.5, weight / ewma->half_life);
+
+  ewma->estimate = value * (1 - alpha) + alpha * ewma->estimate;
+  ewma->total_weight += weight;
+}
+
+/* Corrected for the zero the average starts from */
+static gdouble
+ewma_get (Ewma * ewma)
+{
+  gdouble zero_factor = 1 - pow (0.5, ewma->total_weight / ewma->half_life);
+
+  return zero_factor > 0 ? ewma->estimate / zero_factor : 0;
+}
+
+GstPlayerAbr *
+gst_player_abr_new (void)
+{
+  GstPlayerAbr *abr = g_new0 (GstPlayerAbr, 1);
+
+  gst_player_abr_reset (abr);
+
+  return abr;
+}
+
+void
+gst_player_abr_free (GstPlayerAbr * abr)
+{
+  g_free (abr);
+}
+
+void
+gst_player_abr_reset (GstPlayerAbr * abr)
+{
+  memset (abr, 0, sizeof (GstPlayerAbr));
+  abr->fast.half_life = ABR_FAST_HALF_LIFE;
+  abr->slow.half_life = ABR_SLOW_HALF_LIFE;
+}
+
+void
+gst_player_abr_add_sample (GstPlayerAbr * abr, guint64 bytes,
+    GstClockTime download_time)
+{
+  gdouble seconds, bitrate;
+
+  if (bytes < ABR_MIN_SAMPLE_BYTES || download_time == 0
+      || !GST_CLOCK_TIME_IS_VALID (download_time))
+    return;
+
+  seconds = (gdouble) download_time / GST_SECOND;
+  bitrate = bytes * 8 / seconds;
+
+  ewma_sample (&abr->fast, seconds, bitrate);
+  ewma_sample (&abr->slow, seconds, bitrate);
+  abr->total_time += seconds;
+}
+
+/* Returns the estimated throughput in bits per second, 0 if not known
+ * yet */
+guint64
+gst_player_abr_get_estimate (GstPlayerAbr * abr)
+{
+  if (abr->total_time < ABR_MIN_TOTAL_TIME)
+    return 0;
+
+  return MIN (ewma_get (&abr->fast), ewma_get (&abr->slow));
+}
+
+/* Returns the highest bitrate the demuxer should select at @buffering
+ * percent of buffer fill, within @min_bitrate and @max_bitrate (0 for no
+ * limit) */
+guint64
+gst_player_abr_select (GstPlayerAbr * abr, gint buffering,
+    guint64 min_bitrate, guint64 max_bitrate)
+{
+  guint64 estimate = gst_player_abr_get_estimate (abr);
+  guint64 target;
+  gdouble factor;
+
+  if (estimate == 0) {
+    target = min_bitrate;
+  } else {
+    if (buffering < ABR_LOW_BUFFER)
+      factor = 0.5;
+    else if (buffering < 100)
+      factor = 0.75;
+    else
+      factor = 0.9;
+    target = estimate * factor;
+
+    if (abr->selected > 0) {
+      if (target > abr->selected && buffering < ABR_UPSWITCH_BUFFER)
+        target = abr->selected;
+      else if (ABS ((gdouble) target - abr->selected) <
+          abr->selected * ABR_MIN_CHANGE)
+        target = abr->selected;
+    }
+  }
+
+  if (max_bitrate > 0)
+    target = MIN (target, max_bitrate);
+  target = MAX (target, min_bitrate);
+  abr->selected = target;
+
+  return target;
+}
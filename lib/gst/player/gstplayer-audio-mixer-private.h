@@ -0,0 +1,43 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_AUDIO_MIXER_PRIVATE_H__
+#define __GST_PLAYER_AUDIO_MIXER_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerAudioMixerVoices GstPlayerAudioMixerVoices;
+
+G_GNUC_INTERNAL GstElement * gst_player_audio_mixer_sink_new (void);
+G_GNUC_INTERNAL gboolean     gst_player_audio_mixer_sink_get_stats
+                                                  (GstElement *element,
+                                                   guint *players);
+G_GNUC_INTERNAL GstCaps *    gst_player_audio_mixer_get_caps (void);
+
+G_GNUC_INTERNAL GstPlayerAudioMixerVoices *
+                             gst_player_audio_mixer_voices_new
+                                                  (GError **error);
+G_GNUC_INTERNAL void         gst_player_audio_mixer_voices_free
+                                                  (GstPlayerAudioMixerVoices *voices);
+G_GNUC_INTERNAL gboolean     gst_player_audio_mixer_voices_play
+                                                  (GstPlayerAudioMixerVoices *voices,
+                                                   GstBuffer *pcm,
+                                                   gdouble volume,
+                                                   GError **error);
+
+#endif /* __GST_PLAYER_AUDIO_MIXER_PRIVATE_H__ */
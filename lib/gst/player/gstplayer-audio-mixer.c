@@ -0,0 +1,847 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Audio output shared by the players of a process.
+ *
+ * Instead of an audio sink with a device, ring buffer and thread of its
+ * own, every player using it gets a sink that hands its audio to a
+ * single mixing pipeline of the process. That pipeline mixes the audio of
+ * all of these players and plays it on one device, however many of them
+ * there are. It runs while at least one of them is started.
+ *
+ * The sinks only take the format the mixer runs at, so playbin converts
+ * and resamples in the streaming thread of each player. As they have no
+ * volume of their own, playbin applies the volume and mute of each player
+ * there as well.
+ *
+ * Both pipelines use the system clock. A sink renders its buffers when
+ * they are due in its player, early by the latency of the mixing
+ * pipeline, and passes them on timestamped with the running time of the
+ * mixing pipeline at that moment. The mixer then plays them when they are
+ * due in the player.
+ *
+ * Clips are played by voices, inputs of the mixer that stay linked while
+ * the player has them. Playing a clip only queues its samples in an idle
+ * voice, timestamped right behind what the mixer already mixed, so they
+ * are heard within a buffer of the mixer output. */
+
+#include "gstplayer-audio-mixer-private.h"
+
+#include <gst/base/gstbasesink.h>
+#include <gst/base/gstbasesrc.h>
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define MIXER_FORMAT "S16LE"
+#else
+#define MIXER_FORMAT "S16BE"
+#endif
+#define MIXER_RATE 48000
+#define MIXER_CHANNELS 2
+#define MIXER_BPF (2 * MIXER_CHANNELS)
+#define MIXER_CAPS \
+  "audio/x-raw, format = (string) " MIXER_FORMAT ", " \
+  "layout = (string) interleaved, " \
+  "rate = (int) " G_STRINGIFY (MIXER_RATE) ", " \
+  "channels = (int) " G_STRINGIFY (MIXER_CHANNELS)
+
+/* Latency of the mixing pipeline, the time the buffers of the players
+ * have to get from their sink into the mixer */
+#define MIXER_LATENCY (50 * GST_MSECOND)
+/* Buffers of a player that are rendered this far from where the previous
+ * one ended start over with a discontinuity, smaller differences are
+ * jitter of the rendering and ignored */
+#define MIXER_RESYNC_THRESHOLD (20 * GST_MSECOND)
+/* How far a mixer input may fall behind before its oldest buffers are
+ * dropped */
+#define MIXER_QUEUE_MAX_TIME (500 * GST_MSECOND)
+/* Duration of the buffers the mixer outputs, a clip waits at most this
+ * long for the mixer to get to it */
+#define MIXER_OUTPUT_DURATION (5 * GST_MSECOND)
+/* Clips are mixed in right behind what the mixer already mixed, this much
+ * is left for pushing them */
+#define VOICE_START_MARGIN (2 * GST_MSECOND)
+/* Clips of a player that can play at the same time */
+#define MAX_VOICES 16
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_audio_mixer_debug);
+#define GST_CAT_DEFAULT gst_player_audio_mixer_debug
+
+/* Mixing pipeline */
+
+typedef struct
+{
+  /* Protected by mixer_lock */
+  gint refcount;
+
+  GstElement *pipeline;
+  GstElement *mixer;
+
+  GMutex lock;
+  /* Protected by lock */
+  GList *sinks;
+  GError *error;
+  gchar *error_debug;
+} SharedMixer;
+
+static GMutex mixer_lock;
+static SharedMixer *shared_mixer;
+
+/* Called with the lock of the mixer */
+static void
+post_error (GstElement * sink, const GError * error, const gchar * debug)
+{
+  GError *err = g_error_copy (error);
+
+  gst_element_post_message (sink,
+      gst_message_new_error (GST_OBJECT (sink), err, debug));
+  g_error_free (err);
+}
+
+static GstBusSyncReply
+mixer_bus_sync_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  SharedMixer *mixer = user_data;
+  GError *err;
+  gchar *debug;
+  GList *l;
+
+  /* Nothing watches the bus, errors are passed on to the players */
+  if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_ERROR)
+    return GST_BUS_DROP;
+
+  gst_message_parse_error (msg, &err, &debug);
+  GST_WARNING ("Audio mixer failed: %s", err->message);
+
+  g_mutex_lock (&mixer->lock);
+  if (!mixer->error) {
+    for (l = mixer->sinks; l; l = l->next)
+      post_error (l->data, err, debug);
+    mixer->error = err;
+    mixer->error_debug = debug;
+  } else {
+    g_error_free (err);
+    g_free (debug);
+  }
+  g_mutex_unlock (&mixer->lock);
+
+  return GST_BUS_DROP;
+}
+
+/* Returns the mixer of the process, starting it if no player uses it yet */
+static SharedMixer *
+shared_mixer_get (void)
+{
+  static const gchar *element_names[] = {
+    "audiotestsrc", "capsfilter", "audiomixer", "capsfilter", "audioconvert",
+    "audioresample", "autoaudiosink"
+  };
+  GstElement *elements[G_N_ELEMENTS (element_names)];
+  SharedMixer *mixer;
+  GstCaps *caps;
+  GstClock *clock;
+  GstBus *bus;
+  guint i;
+
+  g_mutex_lock (&mixer_lock);
+  if (shared_mixer) {
+    shared_mixer->refcount++;
+    g_mutex_unlock (&mixer_lock);
+    return shared_mixer;
+  }
+
+  mixer = g_new0 (SharedMixer, 1);
+  mixer->refcount = 1;
+  g_mutex_init (&mixer->lock);
+  shared_mixer = mixer;
+
+  mixer->pipeline = gst_pipeline_new ("shared-audio-mixer");
+  for (i = 0; i < G_N_ELEMENTS (element_names); i++) {
+    elements[i] = gst_element_factory_make (element_names[i], NULL);
+    if (!elements[i]) {
+      mixer->error = g_error_new (GST_CORE_ERROR,
+          GST_CORE_ERROR_MISSING_PLUGIN, "Missing element '%s'",
+          element_names[i]);
+      g_mutex_unlock (&mixer_lock);
+      return mixer;
+    }
+    gst_bin_add (GST_BIN (mixer->pipeline), elements[i]);
+  }
+  mixer->mixer = elements[2];
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (mixer->mixer),
+          "output-buffer-duration"))
+    g_object_set (mixer->mixer, "output-buffer-duration",
+        (guint64) MIXER_OUTPUT_DURATION, NULL);
+
+  /* Silence keeps the output running while no player plays, in buffers as
+   * long as the latency the inputs of the players report so adding these
+   * does not change the latency */
+  gst_util_set_object_arg (G_OBJECT (elements[0]), "wave", "silence");
+  g_object_set (elements[0], "is-live", TRUE, "samplesperbuffer",
+      (gint) gst_util_uint64_scale_int (MIXER_LATENCY, MIXER_RATE,
+          GST_SECOND), NULL);
+
+  caps = gst_caps_from_string (MIXER_CAPS);
+  g_object_set (elements[1], "caps", caps, NULL);
+  g_object_set (elements[3], "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  if (!gst_element_link_many (elements[0], elements[1], elements[2],
+          elements[3], elements[4], elements[5], elements[6], NULL)) {
+    mixer->error = g_error_new (GST_CORE_ERROR, GST_CORE_ERROR_NEGOTIATION,
+        "Failed to link the audio mixer");
+    g_mutex_unlock (&mixer_lock);
+    return mixer;
+  }
+
+  /* The players use the system clock too */
+  clock = gst_system_clock_obtain ();
+  gst_pipeline_use_clock (GST_PIPELINE (mixer->pipeline), clock);
+  gst_object_unref (clock);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (mixer->pipeline));
+  gst_bus_set_sync_handler (bus, mixer_bus_sync_cb, mixer, NULL);
+  gst_object_unref (bus);
+
+  GST_DEBUG ("Starting the audio mixer");
+  gst_element_set_state (mixer->pipeline, GST_STATE_PLAYING);
+  g_mutex_unlock (&mixer_lock);
+
+  return mixer;
+}
+
+static void
+shared_mixer_ref (SharedMixer * mixer)
+{
+  g_mutex_lock (&mixer_lock);
+  mixer->refcount++;
+  g_mutex_unlock (&mixer_lock);
+}
+
+/* Stops the mixer and closes the device when the last player leaves */
+static void
+shared_mixer_unref (SharedMixer * mixer)
+{
+  GstBus *bus;
+
+  g_mutex_lock (&mixer_lock);
+  if (--mixer->refcount > 0) {
+    g_mutex_unlock (&mixer_lock);
+    return;
+  }
+  shared_mixer = NULL;
+  g_mutex_unlock (&mixer_lock);
+
+  GST_DEBUG ("Stopping the audio mixer");
+  gst_element_set_state (mixer->pipeline, GST_STATE_NULL);
+  bus = gst_pipeline_get_bus (GST_PIPELINE (mixer->pipeline));
+  gst_bus_set_sync_handler (bus, NULL, NULL, NULL);
+  gst_object_unref (bus);
+  gst_object_unref (mixer->pipeline);
+
+  g_list_free (mixer->sinks);
+  g_clear_error (&mixer->error);
+  g_free (mixer->error_debug);
+  g_mutex_clear (&mixer->lock);
+  g_free (mixer);
+}
+
+/* Inputs of the mixer */
+
+#define GST_TYPE_PLAYER_MIXER_SRC (gst_player_mixer_src_get_type ())
+#define GST_PLAYER_MIXER_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_MIXER_SRC, GstPlayerMixerSrc))
+
+typedef struct
+{
+  GstBaseSrc parent;
+
+  GMutex lock;
+  GCond cond;
+  /* Protected by lock */
+  GQueue buffers;
+  gboolean flushing;
+} GstPlayerMixerSrc;
+
+typedef GstBaseSrcClass GstPlayerMixerSrcClass;
+
+static GstStaticPadTemplate mixer_src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (MIXER_CAPS));
+
+G_GNUC_INTERNAL GType gst_player_mixer_src_get_type (void);
+G_DEFINE_TYPE (GstPlayerMixerSrc, gst_player_mixer_src, GST_TYPE_BASE_SRC);
+
+static void
+mixer_src_push (GstPlayerMixerSrc * src, GstBuffer * buffer)
+{
+  GstBuffer *head;
+  gboolean dropped = FALSE;
+
+  g_mutex_lock (&src->lock);
+  if (src->flushing) {
+    g_mutex_unlock (&src->lock);
+    gst_buffer_unref (buffer);
+    return;
+  }
+
+  g_queue_push_tail (&src->buffers, buffer);
+  while ((head = g_queue_peek_head (&src->buffers))
+      && GST_CLOCK_DIFF (GST_BUFFER_PTS (head),
+          GST_BUFFER_PTS (buffer)) > MIXER_QUEUE_MAX_TIME) {
+    gst_buffer_unref (g_queue_pop_head (&src->buffers));
+    dropped = TRUE;
+  }
+  if (dropped) {
+    GST_LOG_OBJECT (src, "Dropped buffers the mixer did not take in time");
+    GST_BUFFER_FLAG_SET (head, GST_BUFFER_FLAG_DISCONT);
+  }
+
+  g_cond_broadcast (&src->cond);
+  g_mutex_unlock (&src->lock);
+}
+
+static GstFlowReturn
+gst_player_mixer_src_create (GstBaseSrc * bsrc, guint64 offset, guint size,
+    GstBuffer ** buf)
+{
+  GstPlayerMixerSrc *src = GST_PLAYER_MIXER_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  while (!src->flushing && g_queue_is_empty (&src->buffers))
+    g_cond_wait (&src->cond, &src->lock);
+  if (src->flushing) {
+    g_mutex_unlock (&src->lock);
+    return GST_FLOW_FLUSHING;
+  }
+  *buf = g_queue_pop_head (&src->buffers);
+  g_mutex_unlock (&src->lock);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_player_mixer_src_unlock (GstBaseSrc * bsrc)
+{
+  GstPlayerMixerSrc *src = GST_PLAYER_MIXER_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  src->flushing = TRUE;
+  g_cond_broadcast (&src->cond);
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_mixer_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstPlayerMixerSrc *src = GST_PLAYER_MIXER_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  src->flushing = FALSE;
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_mixer_src_stop (GstBaseSrc * bsrc)
+{
+  GstPlayerMixerSrc *src = GST_PLAYER_MIXER_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  g_queue_foreach (&src->buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_queue_clear (&src->buffers);
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_mixer_src_query (GstBaseSrc * bsrc, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_LATENCY) {
+    gst_query_set_latency (query, TRUE, MIXER_LATENCY, GST_CLOCK_TIME_NONE);
+    return TRUE;
+  }
+
+  return GST_BASE_SRC_CLASS (gst_player_mixer_src_parent_class)->query (bsrc,
+      query);
+}
+
+static void
+gst_player_mixer_src_finalize (GObject * object)
+{
+  GstPlayerMixerSrc *src = GST_PLAYER_MIXER_SRC (object);
+
+  g_queue_foreach (&src->buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_queue_clear (&src->buffers);
+  g_mutex_clear (&src->lock);
+  g_cond_clear (&src->cond);
+
+  G_OBJECT_CLASS (gst_player_mixer_src_parent_class)->finalize (object);
+}
+
+static void
+gst_player_mixer_src_init (GstPlayerMixerSrc * src)
+{
+  g_mutex_init (&src->lock);
+  g_cond_init (&src->cond);
+  g_queue_init (&src->buffers);
+
+  gst_base_src_set_live (GST_BASE_SRC (src), TRUE);
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
+}
+
+static void
+gst_player_mixer_src_class_init (GstPlayerMixerSrcClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseSrcClass *basesrc_class = (GstBaseSrcClass *) klass;
+
+  gobject_class->finalize = gst_player_mixer_src_finalize;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&mixer_src_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player audio mixer source", "Source/Audio",
+      "Feeds the audio of a player into the shared audio mixer", "GstPlayer");
+
+  basesrc_class->create = gst_player_mixer_src_create;
+  basesrc_class->unlock = gst_player_mixer_src_unlock;
+  basesrc_class->unlock_stop = gst_player_mixer_src_unlock_stop;
+  basesrc_class->stop = gst_player_mixer_src_stop;
+  basesrc_class->query = gst_player_mixer_src_query;
+}
+
+/* Adds an input to @mixer, the buffers pushed into the returned source
+ * are mixed from their timestamp on */
+static GstElement *
+mixer_add_input (SharedMixer * mixer, GstPad ** mixer_pad)
+{
+  GstElement *src;
+  GstPad *srcpad;
+
+  src = gst_object_ref (g_object_new (GST_TYPE_PLAYER_MIXER_SRC, NULL));
+  gst_bin_add (GST_BIN (mixer->pipeline), src);
+
+  *mixer_pad = gst_element_get_request_pad (mixer->mixer, "sink_%u");
+  srcpad = gst_element_get_static_pad (src, "src");
+  if (!*mixer_pad || gst_pad_link (srcpad, *mixer_pad) != GST_PAD_LINK_OK)
+    GST_WARNING_OBJECT (src, "Failed to link to the audio mixer");
+  gst_object_unref (srcpad);
+
+  gst_element_sync_state_with_parent (src);
+
+  return src;
+}
+
+static void
+mixer_remove_input (SharedMixer * mixer, GstElement * src, GstPad * mixer_pad)
+{
+  gst_element_set_locked_state (src, TRUE);
+  gst_element_set_state (src, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN (mixer->pipeline), src);
+  gst_object_unref (src);
+  if (mixer_pad) {
+    gst_element_release_request_pad (mixer->mixer, mixer_pad);
+    gst_object_unref (mixer_pad);
+  }
+}
+
+/* Running time of the mixer now */
+static GstClockTime
+mixer_get_running_time (SharedMixer * mixer)
+{
+  GstClock *clock;
+  GstClockTime now;
+
+  clock = gst_system_clock_obtain ();
+  now = gst_clock_get_time (clock) -
+      gst_element_get_base_time (mixer->pipeline);
+  gst_object_unref (clock);
+
+  return now;
+}
+
+/* Sink of the players */
+
+#define GST_TYPE_PLAYER_AUDIO_MIXER_SINK (gst_player_audio_mixer_sink_get_type ())
+#define GST_PLAYER_AUDIO_MIXER_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_AUDIO_MIXER_SINK, GstPlayerAudioMixerSink))
+#define GST_IS_PLAYER_AUDIO_MIXER_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_AUDIO_MIXER_SINK))
+
+typedef struct
+{
+  GstBaseSink parent;
+
+  /* Protected by object lock, only changed while stopped */
+  SharedMixer *mixer;
+  GstElement *src;
+  GstPad *mixer_pad;
+
+  /* Only accessed from the streaming thread */
+  GstClockTime next_pts;
+} GstPlayerAudioMixerSink;
+
+typedef GstBaseSinkClass GstPlayerAudioMixerSinkClass;
+
+static GstStaticPadTemplate audio_mixer_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (MIXER_CAPS));
+
+G_GNUC_INTERNAL GType gst_player_audio_mixer_sink_get_type (void);
+G_DEFINE_TYPE (GstPlayerAudioMixerSink, gst_player_audio_mixer_sink,
+    GST_TYPE_BASE_SINK);
+
+static gboolean
+gst_player_audio_mixer_sink_start (GstBaseSink * bsink)
+{
+  GstPlayerAudioMixerSink *sink = GST_PLAYER_AUDIO_MIXER_SINK (bsink);
+  SharedMixer *mixer;
+  GstElement *src;
+  GstPad *mixer_pad;
+
+  mixer = shared_mixer_get ();
+
+  g_mutex_lock (&mixer->lock);
+  if (mixer->error) {
+    post_error (GST_ELEMENT (sink), mixer->error, mixer->error_debug);
+    g_mutex_unlock (&mixer->lock);
+    shared_mixer_unref (mixer);
+    return FALSE;
+  }
+  mixer->sinks = g_list_prepend (mixer->sinks, sink);
+  GST_DEBUG_OBJECT (sink, "Mixing with %u other players",
+      g_list_length (mixer->sinks) - 1);
+  g_mutex_unlock (&mixer->lock);
+
+  src = mixer_add_input (mixer, &mixer_pad);
+
+  GST_OBJECT_LOCK (sink);
+  sink->mixer = mixer;
+  sink->src = src;
+  sink->mixer_pad = mixer_pad;
+  GST_OBJECT_UNLOCK (sink);
+
+  sink->next_pts = GST_CLOCK_TIME_NONE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_audio_mixer_sink_stop (GstBaseSink * bsink)
+{
+  GstPlayerAudioMixerSink *sink = GST_PLAYER_AUDIO_MIXER_SINK (bsink);
+  SharedMixer *mixer;
+  GstElement *src;
+  GstPad *mixer_pad;
+
+  GST_OBJECT_LOCK (sink);
+  mixer = sink->mixer;
+  src = sink->src;
+  mixer_pad = sink->mixer_pad;
+  sink->mixer = NULL;
+  sink->src = NULL;
+  sink->mixer_pad = NULL;
+  GST_OBJECT_UNLOCK (sink);
+
+  if (!mixer)
+    return TRUE;
+
+  g_mutex_lock (&mixer->lock);
+  mixer->sinks = g_list_remove (mixer->sinks, sink);
+  g_mutex_unlock (&mixer->lock);
+
+  mixer_remove_input (mixer, src, mixer_pad);
+  shared_mixer_unref (mixer);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_player_audio_mixer_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
+{
+  GstPlayerAudioMixerSink *sink = GST_PLAYER_AUDIO_MIXER_SINK (bsink);
+  GstClockTime now, pts, duration;
+  gboolean discont;
+
+  /* Nothing resamples for other rates, these play muted like trick
+   * modes */
+  if (bsink->segment.rate != 1.0) {
+    sink->next_pts = GST_CLOCK_TIME_NONE;
+    return GST_FLOW_OK;
+  }
+
+  now = mixer_get_running_time (sink->mixer);
+  duration = gst_util_uint64_scale_int (gst_buffer_get_size (buffer) /
+      MIXER_BPF, GST_SECOND, MIXER_RATE);
+
+  /* Consecutive buffers stay consecutive for the mixer, anything else
+   * starts over at the running time of the mixer now */
+  discont = !GST_CLOCK_TIME_IS_VALID (sink->next_pts)
+      || ABS (GST_CLOCK_DIFF (sink->next_pts, now)) > MIXER_RESYNC_THRESHOLD;
+  if (discont) {
+    GST_LOG_OBJECT (sink, "Mixing from %" GST_TIME_FORMAT " on",
+        GST_TIME_ARGS (now));
+    pts = now;
+  } else {
+    pts = sink->next_pts;
+  }
+  sink->next_pts = pts + duration;
+
+  /* Only the metadata is copied, the memory goes on to the mixer */
+  buffer = gst_buffer_copy (buffer);
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buffer) = duration;
+  GST_BUFFER_OFFSET (buffer) = GST_BUFFER_OFFSET_NONE;
+  GST_BUFFER_OFFSET_END (buffer) = GST_BUFFER_OFFSET_NONE;
+  if (discont)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  else
+    GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DISCONT);
+
+  mixer_src_push (GST_PLAYER_MIXER_SRC (sink->src), buffer);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_player_audio_mixer_sink_init (GstPlayerAudioMixerSink * sink)
+{
+  GstBaseSink *bsink = GST_BASE_SINK (sink);
+
+  /* Rendered early by the latency of the mixer, the other sinks of the
+   * player wait for it */
+  gst_base_sink_set_sync (bsink, TRUE);
+  gst_base_sink_set_render_delay (bsink, MIXER_LATENCY);
+  gst_base_sink_set_last_sample_enabled (bsink, FALSE);
+
+  sink->next_pts = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_player_audio_mixer_sink_class_init (GstPlayerAudioMixerSinkClass * klass)
+{
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseSinkClass *basesink_class = (GstBaseSinkClass *) klass;
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_audio_mixer_debug,
+      "gst-player-audio-mixer", 0, "GstPlayer shared audio mixer");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&audio_mixer_sink_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player audio mixer sink", "Sink/Audio",
+      "Plays audio through the audio mixer shared by all players",
+      "GstPlayer");
+
+  basesink_class->start = gst_player_audio_mixer_sink_start;
+  basesink_class->stop = gst_player_audio_mixer_sink_stop;
+  basesink_class->render = gst_player_audio_mixer_sink_render;
+}
+
+/* Returns a new audio sink that plays through the audio mixer shared by
+ * all players of the process */
+GstElement *
+gst_player_audio_mixer_sink_new (void)
+{
+  return g_object_new (GST_TYPE_PLAYER_AUDIO_MIXER_SINK, NULL);
+}
+
+/* Gets the number of players playing through the audio mixer, including
+ * the one of @element, returns FALSE if @element is not the sink of the
+ * audio mixer */
+gboolean
+gst_player_audio_mixer_sink_get_stats (GstElement * element, guint * players)
+{
+  GstPlayerAudioMixerSink *sink;
+  SharedMixer *mixer;
+
+  if (!GST_IS_PLAYER_AUDIO_MIXER_SINK (element))
+    return FALSE;
+
+  sink = GST_PLAYER_AUDIO_MIXER_SINK (element);
+  GST_OBJECT_LOCK (sink);
+  mixer = sink->mixer;
+  if (mixer)
+    shared_mixer_ref (mixer);
+  GST_OBJECT_UNLOCK (sink);
+
+  *players = 0;
+  if (mixer) {
+    g_mutex_lock (&mixer->lock);
+    *players = g_list_length (mixer->sinks);
+    g_mutex_unlock (&mixer->lock);
+    shared_mixer_unref (mixer);
+  }
+
+  return TRUE;
+}
+
+/* Voices playing clips */
+
+typedef struct
+{
+  GstElement *src;
+  GstPad *mixer_pad;
+  GstClockTime end;
+} Voice;
+
+struct _GstPlayerAudioMixerVoices
+{
+  SharedMixer *mixer;
+  GArray *voices;
+};
+
+/* Returns the caps of the audio mixed by the audio mixer */
+GstCaps *
+gst_player_audio_mixer_get_caps (void)
+{
+  return gst_caps_from_string (MIXER_CAPS);
+}
+
+/* Returns the voices of a player, starting the audio mixer if no player
+ * uses it yet. Must only be used from one thread */
+GstPlayerAudioMixerVoices *
+gst_player_audio_mixer_voices_new (GError ** error)
+{
+  GstPlayerAudioMixerVoices *voices;
+  SharedMixer *mixer;
+
+  mixer = shared_mixer_get ();
+
+  g_mutex_lock (&mixer->lock);
+  if (mixer->error) {
+    g_propagate_error (error, g_error_copy (mixer->error));
+    g_mutex_unlock (&mixer->lock);
+    shared_mixer_unref (mixer);
+    return NULL;
+  }
+  g_mutex_unlock (&mixer->lock);
+
+  voices = g_new0 (GstPlayerAudioMixerVoices, 1);
+  voices->mixer = mixer;
+  voices->voices = g_array_new (FALSE, FALSE, sizeof (Voice));
+
+  return voices;
+}
+
+void
+gst_player_audio_mixer_voices_free (GstPlayerAudioMixerVoices * voices)
+{
+  Voice *voice;
+  guint i;
+
+  for (i = 0; i < voices->voices->len; i++) {
+    voice = &g_array_index (voices->voices, Voice, i);
+    mixer_remove_input (voices->mixer, voice->src, voice->mixer_pad);
+  }
+  g_array_free (voices->voices, TRUE);
+  shared_mixer_unref (voices->mixer);
+  g_free (voices);
+}
+
+/* Copy of @pcm with the samples scaled by @volume */
+static GstBuffer *
+scale_samples (GstBuffer * pcm, gdouble volume)
+{
+  GstBuffer *buffer;
+  GstMapInfo in, out;
+  const gint16 *src;
+  gint16 *dest;
+  gint sample;
+  gsize i;
+
+  gst_buffer_map (pcm, &in, GST_MAP_READ);
+  buffer = gst_buffer_new_allocate (NULL, in.size, NULL);
+  gst_buffer_map (buffer, &out, GST_MAP_WRITE);
+
+  src = (const gint16 *) in.data;
+  dest = (gint16 *) out.data;
+  for (i = 0; i < in.size / sizeof (gint16); i++) {
+    sample = (gint) (src[i] * volume);
+    dest[i] = CLAMP (sample, G_MININT16, G_MAXINT16);
+  }
+
+  gst_buffer_unmap (buffer, &out);
+  gst_buffer_unmap (pcm, &in);
+
+  return buffer;
+}
+
+/* Starts playing @pcm, audio in the caps of the audio mixer, at @volume.
+ * Clips that are still playing keep playing along with it */
+gboolean
+gst_player_audio_mixer_voices_play (GstPlayerAudioMixerVoices * voices,
+    GstBuffer * pcm, gdouble volume, GError ** error)
+{
+  SharedMixer *mixer = voices->mixer;
+  Voice *voice = NULL, new_voice;
+  GstClockTime now, start, duration;
+  GstBuffer *buffer;
+  guint i;
+
+  g_mutex_lock (&mixer->lock);
+  if (mixer->error) {
+    g_propagate_error (error, g_error_copy (mixer->error));
+    g_mutex_unlock (&mixer->lock);
+    return FALSE;
+  }
+  g_mutex_unlock (&mixer->lock);
+
+  now = mixer_get_running_time (mixer);
+  start = now > MIXER_LATENCY ? now - MIXER_LATENCY + VOICE_START_MARGIN : now;
+  duration = gst_util_uint64_scale_int (gst_buffer_get_size (pcm) /
+      MIXER_BPF, GST_SECOND, MIXER_RATE);
+
+  for (i = 0; i < voices->voices->len && !voice; i++) {
+    if (g_array_index (voices->voices, Voice, i).end <= start)
+      voice = &g_array_index (voices->voices, Voice, i);
+  }
+  if (!voice) {
+    if (voices->voices->len == MAX_VOICES) {
+      g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
+          "Too many clips playing at the same time");
+      return FALSE;
+    }
+    new_voice.src = mixer_add_input (mixer, &new_voice.mixer_pad);
+    new_voice.end = 0;
+    g_array_append_val (voices->voices, new_voice);
+    voice = &g_array_index (voices->voices, Voice, voices->voices->len - 1);
+    GST_DEBUG ("Added voice %u", voices->voices->len);
+  }
+
+  /* The samples are shared with the cache unless scaled */
+  if (volume == 1.0)
+    buffer = gst_buffer_copy (pcm);
+  else
+    buffer = scale_samples (pcm, volume);
+  GST_BUFFER_PTS (buffer) = start;
+  GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buffer) = duration;
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+
+  mixer_src_push (GST_PLAYER_MIXER_SRC (voice->src), buffer);
+  voice->end = start + duration;
+
+  return TRUE;
+}
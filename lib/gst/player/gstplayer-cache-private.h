@@ -0,0 +1,29 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_CACHE_PRIVATE_H__
+#define __GST_PLAYER_CACHE_PRIVATE_H__
+
+#include <glib.h>
+
+G_GNUC_INTERNAL gchar*  gst_player_cache_get_filename
+                        (const gchar *subdir, const gchar *key);
+G_GNUC_INTERNAL gchar*  gst_player_cache_make_file_key
+                        (const gchar *uri);
+
+#endif /* __GST_PLAYER_CACHE_PRIVATE_H__ */
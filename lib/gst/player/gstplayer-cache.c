@@ -0,0 +1,67 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "gstplayer-cache-private.h"
+
+#include <glib/gstdio.h>
+
+/* Returns the file for @key in the @subdir of the per-user gst-player cache
+ * directory, creating the directory if needed */
+gchar *
+gst_player_cache_get_filename (const gchar * subdir, const gchar * key)
+{
+  gchar *dir, *filename;
+
+  dir = g_build_filename (g_get_user_cache_dir (), "gst-player", subdir, NULL);
+  if (g_mkdir_with_parents (dir, 0700) < 0) {
+    g_free (dir);
+    return NULL;
+  }
+
+  filename = g_build_filename (dir, key, NULL);
+  g_free (dir);
+
+  return filename;
+}
+
+/* Cache key for data derived from the local file at @uri. It changes
+ * whenever the file is modified, so stale entries are never used. Returns
+ * NULL for non-local URIs */
+gchar *
+gst_player_cache_make_file_key (const gchar * uri)
+{
+  GStatBuf st;
+  gchar *filename, *str, *key;
+
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  if (!filename)
+    return NULL;
+
+  if (g_stat (filename, &st) < 0) {
+    g_free (filename);
+    return NULL;
+  }
+  g_free (filename);
+
+  str = g_strdup_printf ("%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT, uri,
+      (gint64) st.st_size, (gint64) st.st_mtime);
+  key = g_compute_checksum_for_string (G_CHECKSUM_SHA1, str, -1);
+  g_free (str);
+
+  return key;
+}
@@ -0,0 +1,36 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_CLIP_CACHE_PRIVATE_H__
+#define __GST_PLAYER_CLIP_CACHE_PRIVATE_H__
+
+#include <gst/gst.h>
+
+/* Called from the context passed to gst_player_clip_cache_decode(), @pcm
+ * is NULL and @error set if the clip could not be decoded */
+typedef void (*GstPlayerClipCacheDoneFunc) (const gchar * uri,
+    GstBuffer * pcm, const GError * error, gpointer user_data);
+
+G_GNUC_INTERNAL GstBuffer * gst_player_clip_cache_lookup (const gchar *uri);
+G_GNUC_INTERNAL void        gst_player_clip_cache_decode (const gchar *uri,
+                                                         GMainContext *context,
+                                                         GstPlayerClipCacheDoneFunc done,
+                                                         gpointer user_data,
+                                                         GDestroyNotify notify);
+
+#endif /* __GST_PLAYER_CLIP_CACHE_PRIVATE_H__ */
@@ -0,0 +1,442 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Decoded short clips, shared by the players of a process.
+ *
+ * A clip is decoded completely into the format of the audio mixer the
+ * first time it is played and kept in memory, so playing it again needs
+ * neither a pipeline nor decoding. Clips are decoded by a few worker
+ * threads, requests for a clip that is being decoded already wait for
+ * that decoding. Clips that decode to more than CLIP_MAX_SIZE are
+ * refused. Once the clips exceed CLIP_CACHE_MAX_SIZE the least recently
+ * played ones are dropped. Local files are cached by their size and
+ * modification time as well, a changed file is decoded again. */
+
+#include "gstplayer-clip-cache-private.h"
+#include "gstplayer-audio-mixer-private.h"
+#include "gstplayer-cache-private.h"
+#include "gstplayer.h"
+
+/* About 10 seconds in the format of the mixer */
+#define CLIP_MAX_SIZE (2 * 1024 * 1024)
+#define CLIP_CACHE_MAX_SIZE (16 * 1024 * 1024)
+/* Decoding a clip that takes longer than this has failed */
+#define CLIP_DECODE_TIMEOUT (10 * GST_SECOND)
+/* Clips decoded at the same time */
+#define CLIP_DECODE_THREADS 2
+
+typedef struct
+{
+  gchar *key;
+  GstBuffer *pcm;
+} Clip;
+
+typedef struct
+{
+  GMainContext *context;
+  GstPlayerClipCacheDoneFunc done;
+  gpointer user_data;
+  GDestroyNotify notify;
+} ClipWaiter;
+
+typedef struct
+{
+  gchar *key;
+  gchar *uri;
+  GList *waiters;               /* ClipWaiter */
+} ClipDecode;
+
+typedef struct
+{
+  ClipWaiter *waiter;
+  gchar *uri;
+  GstBuffer *pcm;
+  GError *error;
+} ClipDone;
+
+static GMutex cache_lock;
+/* Protected by cache_lock */
+static GHashTable *clips;       /* key -> link in lru */
+static GQueue lru;              /* Clip, least recently used first */
+static gsize cache_size;
+static GHashTable *decodes;     /* key -> ClipDecode */
+static GThreadPool *decode_pool;
+
+typedef struct
+{
+  GByteArray *data;
+  gboolean too_long;
+} ClipDecoder;
+
+static void
+clip_free (Clip * clip)
+{
+  gst_buffer_unref (clip->pcm);
+  g_free (clip->key);
+  g_free (clip);
+}
+
+static void
+decoder_pad_added_cb (GstElement * decodebin, GstPad * pad,
+    GstElement * convert)
+{
+  GstPad *sinkpad;
+
+  /* Only the first audio stream is played */
+  sinkpad = gst_element_get_static_pad (convert, "sink");
+  if (!gst_pad_is_linked (sinkpad))
+    gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+static void
+decoder_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    ClipDecoder * decoder)
+{
+  GstMapInfo map;
+  GstBus *bus;
+
+  if (decoder->too_long)
+    return;
+
+  if (decoder->data->len + gst_buffer_get_size (buffer) > CLIP_MAX_SIZE) {
+    decoder->too_long = TRUE;
+    bus = gst_element_get_bus (sink);
+    gst_bus_post (bus, gst_message_new_application (GST_OBJECT (sink),
+            gst_structure_new_empty ("clip-too-long")));
+    gst_object_unref (bus);
+    return;
+  }
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  g_byte_array_append (decoder->data, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+}
+
+static gboolean
+decoder_run (ClipDecoder * decoder, const gchar * uri, GError ** error)
+{
+  GstElement *pipeline, *decodebin, *convert, *resample, *filter, *sink;
+  GstStateChangeReturn state_ret;
+  GstCaps *caps;
+  GstMessage *msg;
+  GstBus *bus;
+  gboolean ret = TRUE;
+
+  pipeline = gst_pipeline_new (NULL);
+  decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  convert = gst_element_factory_make ("audioconvert", NULL);
+  resample = gst_element_factory_make ("audioresample", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!decodebin || !convert || !resample || !filter || !sink) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Missing elements for decoding clips");
+    if (decodebin)
+      gst_object_unref (decodebin);
+    if (convert)
+      gst_object_unref (convert);
+    if (resample)
+      gst_object_unref (resample);
+    if (filter)
+      gst_object_unref (filter);
+    if (sink)
+      gst_object_unref (sink);
+    gst_object_unref (pipeline);
+    return FALSE;
+  }
+
+  gst_bin_add_many (GST_BIN (pipeline), decodebin, convert, resample, filter,
+      sink, NULL);
+  if (!gst_element_link_many (convert, resample, filter, sink, NULL)) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Failed to link clip decoder");
+    gst_object_unref (pipeline);
+    return FALSE;
+  }
+
+  caps = gst_caps_new_empty_simple ("audio/x-raw");
+  g_object_set (decodebin, "uri", uri, "caps", caps, "expose-all-streams",
+      FALSE, NULL);
+  gst_caps_unref (caps);
+  g_signal_connect (decodebin, "pad-added",
+      G_CALLBACK (decoder_pad_added_cb), convert);
+
+  caps = gst_player_audio_mixer_get_caps ();
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (decoder_handoff_cb),
+      decoder);
+
+  bus = gst_element_get_bus (pipeline);
+  state_ret = gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  if (state_ret == GST_STATE_CHANGE_FAILURE)
+    msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  else
+    msg = gst_bus_timed_pop_filtered (bus, CLIP_DECODE_TIMEOUT,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_APPLICATION);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  if (msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Failed to decode clip: %s", err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  } else if (msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_APPLICATION) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Clip '%s' is too long, at most %u bytes can be cached", uri,
+        CLIP_MAX_SIZE);
+    ret = FALSE;
+  } else if (!msg) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Failed to decode clip '%s'", uri);
+    ret = FALSE;
+  }
+
+  if (msg)
+    gst_message_unref (msg);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  return ret;
+}
+
+static GstBuffer *
+decode_clip (const gchar * uri, GError ** error)
+{
+  ClipDecoder decoder;
+  gsize size;
+
+  decoder.data = g_byte_array_new ();
+  decoder.too_long = FALSE;
+
+  if (!decoder_run (&decoder, uri, error) || decoder.data->len == 0) {
+    if (error && !*error)
+      g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+          "No audio found in '%s'", uri);
+    g_byte_array_free (decoder.data, TRUE);
+    return NULL;
+  }
+
+  size = decoder.data->len;
+  return gst_buffer_new_wrapped (g_byte_array_free (decoder.data, FALSE),
+      size);
+}
+
+static gchar *
+make_key (const gchar * uri)
+{
+  gchar *key = gst_player_cache_make_file_key (uri);
+
+  return key ? key : g_strdup (uri);
+}
+
+/* Must be called with cache_lock */
+static GstBuffer *
+lookup_locked (const gchar * key)
+{
+  GList *link;
+
+  if (!clips || !(link = g_hash_table_lookup (clips, key)))
+    return NULL;
+
+  g_queue_unlink (&lru, link);
+  g_queue_push_tail_link (&lru, link);
+
+  return gst_buffer_ref (((Clip *) link->data)->pcm);
+}
+
+/* Must be called with cache_lock */
+static void
+store_locked (const gchar * key, GstBuffer * pcm)
+{
+  Clip *clip;
+
+  if (!clips)
+    clips = g_hash_table_new (g_str_hash, g_str_equal);
+
+  if (g_hash_table_contains (clips, key))
+    return;
+
+  clip = g_new0 (Clip, 1);
+  clip->key = g_strdup (key);
+  clip->pcm = gst_buffer_ref (pcm);
+  g_queue_push_tail (&lru, clip);
+  g_hash_table_insert (clips, clip->key, lru.tail);
+  cache_size += gst_buffer_get_size (pcm);
+
+  while (cache_size > CLIP_CACHE_MAX_SIZE && lru.length > 1) {
+    clip = g_queue_pop_head (&lru);
+    g_hash_table_remove (clips, clip->key);
+    cache_size -= gst_buffer_get_size (clip->pcm);
+    clip_free (clip);
+  }
+}
+
+static gboolean
+clip_done_cb (gpointer user_data)
+{
+  ClipDone *done = user_data;
+
+  done->waiter->done (done->uri, done->pcm, done->error,
+      done->waiter->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+clip_done_free (ClipDone * done)
+{
+  if (done->waiter->notify)
+    done->waiter->notify (done->waiter->user_data);
+  g_main_context_unref (done->waiter->context);
+  g_free (done->waiter);
+  g_free (done->uri);
+  if (done->pcm)
+    gst_buffer_unref (done->pcm);
+  if (done->error)
+    g_error_free (done->error);
+  g_free (done);
+}
+
+static void
+waiter_finish (ClipWaiter * waiter, const gchar * uri, GstBuffer * pcm,
+    const GError * error)
+{
+  ClipDone *done;
+  GSource *source;
+
+  done = g_new0 (ClipDone, 1);
+  done->waiter = waiter;
+  done->uri = g_strdup (uri);
+  done->pcm = pcm ? gst_buffer_ref (pcm) : NULL;
+  done->error = error ? g_error_copy (error) : NULL;
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, clip_done_cb, done,
+      (GDestroyNotify) clip_done_free);
+  g_source_attach (source, waiter->context);
+  g_source_unref (source);
+}
+
+static void
+decode_thread_func (gpointer data, gpointer user_data)
+{
+  ClipDecode *decode = data;
+  GError *error = NULL;
+  GstBuffer *pcm;
+  GList *waiters, *l;
+
+  pcm = decode_clip (decode->uri, &error);
+
+  g_mutex_lock (&cache_lock);
+  if (pcm)
+    store_locked (decode->key, pcm);
+  g_hash_table_remove (decodes, decode->key);
+  waiters = decode->waiters;
+  g_mutex_unlock (&cache_lock);
+
+  for (l = waiters; l; l = l->next)
+    waiter_finish (l->data, decode->uri, pcm, error);
+  g_list_free (waiters);
+
+  if (pcm)
+    gst_buffer_unref (pcm);
+  g_clear_error (&error);
+  g_free (decode->key);
+  g_free (decode->uri);
+  g_free (decode);
+}
+
+/* Returns the samples of the clip at @uri in the format of the audio
+ * mixer if it is cached, or NULL */
+GstBuffer *
+gst_player_clip_cache_lookup (const gchar * uri)
+{
+  GstBuffer *pcm;
+  gchar *key;
+
+  key = make_key (uri);
+  g_mutex_lock (&cache_lock);
+  pcm = lookup_locked (key);
+  g_mutex_unlock (&cache_lock);
+  g_free (key);
+
+  return pcm;
+}
+
+/* Decodes the clip at @uri in a worker thread, or waits for the decoding
+ * of it that is running already. Once it is cached or failed @done is
+ * called from @context, and @notify with @user_data afterwards */
+void
+gst_player_clip_cache_decode (const gchar * uri, GMainContext * context,
+    GstPlayerClipCacheDoneFunc done, gpointer user_data,
+    GDestroyNotify notify)
+{
+  ClipDecode *decode;
+  ClipWaiter *waiter;
+  GstBuffer *pcm;
+  gchar *key;
+
+  waiter = g_new0 (ClipWaiter, 1);
+  waiter->context = g_main_context_ref (context);
+  waiter->done = done;
+  waiter->user_data = user_data;
+  waiter->notify = notify;
+
+  key = make_key (uri);
+  g_mutex_lock (&cache_lock);
+
+  /* Cached by a decoding that finished meanwhile */
+  pcm = lookup_locked (key);
+  if (pcm) {
+    g_mutex_unlock (&cache_lock);
+    waiter_finish (waiter, uri, pcm, NULL);
+    gst_buffer_unref (pcm);
+    g_free (key);
+    return;
+  }
+
+  if (!decodes)
+    decodes = g_hash_table_new (g_str_hash, g_str_equal);
+
+  decode = g_hash_table_lookup (decodes, key);
+  if (decode) {
+    decode->waiters = g_list_append (decode->waiters, waiter);
+    g_mutex_unlock (&cache_lock);
+    g_free (key);
+    return;
+  }
+
+  if (!decode_pool)
+    decode_pool = g_thread_pool_new (decode_thread_func, NULL,
+        CLIP_DECODE_THREADS, FALSE, NULL);
+
+  decode = g_new0 (ClipDecode, 1);
+  decode->key = key;
+  decode->uri = g_strdup (uri);
+  decode->waiters = g_list_append (NULL, waiter);
+  g_hash_table_insert (decodes, decode->key, decode);
+  g_thread_pool_push (decode_pool, decode, NULL);
+  g_mutex_unlock (&cache_lock);
+}
@@ -0,0 +1,33 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_DISCOVERER_PRIVATE_H__
+#define __GST_PLAYER_DISCOVERER_PRIVATE_H__
+
+#include <gst/pbutils/pbutils.h>
+
+#include "gstplayer-media-info-private.h"
+
+G_GNUC_INTERNAL GstPlayerMediaInfo*  gst_player_media_info_new_from_discoverer_info
+                                     (GstDiscovererInfo *dinfo);
+G_GNUC_INTERNAL GstPlayerMediaInfo*  gst_player_media_info_cache_lookup
+                                     (const gchar *uri);
+G_GNUC_INTERNAL void                 gst_player_media_info_cache_store
+                                     (GstPlayerMediaInfo *info);
+
+#endif /* __GST_PLAYER_DISCOVERER_PRIVATE_H__ */
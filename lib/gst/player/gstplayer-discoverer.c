@@ -0,0 +1,488 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Media info of files that are not played: conversion from discoverer
+ * results, and a per-file cache of them. Each cache entry is a serialized
+ * GVariant that is memory-mapped on lookup, so repeated lookups cost one
+ * stat() and one mmap() */
+
+#include "gstplayer-discoverer-private.h"
+#include "gstplayer-cache-private.h"
+
+#define MEDIA_INFO_CACHE_DIR "media-info"
+#define MEDIA_INFO_CACHE_VERSION 1
+
+/* type, index, caps, tags, codec, width, height, framerate, pixel aspect
+ * ratio, bitrate, max bitrate, channels, sample rate, language */
+#define STREAM_FORMAT "(uisssiiiiiiuuiis)"
+
+/* version, uri, title, container, tags, seekable, duration, playable,
+ * image caps, image data, streams */
+#define MEDIA_INFO_FORMAT "(ussssbtbsaya" STREAM_FORMAT ")"
+#define MEDIA_INFO_BUILD_FORMAT "(ussssbtbs@aya" STREAM_FORMAT ")"
+
+enum
+{
+  STREAM_TYPE_VIDEO,
+  STREAM_TYPE_AUDIO,
+  STREAM_TYPE_SUBTITLE
+};
+
+static void
+media_info_add_stream (GstPlayerMediaInfo * info, GstPlayerStreamInfo * s)
+{
+  info->stream_list = g_list_append (info->stream_list, s);
+
+  if (GST_IS_PLAYER_AUDIO_INFO (s))
+    info->audio_stream_list = g_list_append (info->audio_stream_list, s);
+  else if (GST_IS_PLAYER_VIDEO_INFO (s))
+    info->video_stream_list = g_list_append (info->video_stream_list, s);
+  else
+    info->subtitle_stream_list = g_list_append (info->subtitle_stream_list, s);
+}
+
+static gchar *
+stream_get_codec (GstPlayerStreamInfo * s, const gchar * tag)
+{
+  gchar *codec = NULL;
+
+  if (s->tags) {
+    gst_tag_list_get_string (s->tags, tag, &codec);
+    if (!codec)
+      gst_tag_list_get_string (s->tags, GST_TAG_CODEC, &codec);
+  }
+
+  if (!codec && s->caps)
+    codec = gst_pb_utils_get_codec_description (s->caps);
+
+  return codec;
+}
+
+static GstPlayerStreamInfo *
+stream_info_new_from_discoverer (GstDiscovererStreamInfo * dstream,
+    gint index, GType type)
+{
+  GstPlayerStreamInfo *s;
+  const GstTagList *tags;
+  const gchar *codec_tag;
+
+  s = gst_player_stream_info_new (index, type);
+  s->caps = gst_discoverer_stream_info_get_caps (dstream);
+  tags = gst_discoverer_stream_info_get_tags (dstream);
+  if (tags)
+    s->tags = gst_tag_list_copy (tags);
+
+  if (type == GST_TYPE_PLAYER_VIDEO_INFO) {
+    GstPlayerVideoInfo *video = (GstPlayerVideoInfo *) s;
+    GstDiscovererVideoInfo *dvideo = (GstDiscovererVideoInfo *) dstream;
+
+    video->width = gst_discoverer_video_info_get_width (dvideo);
+    video->height = gst_discoverer_video_info_get_height (dvideo);
+    video->framerate_num = gst_discoverer_video_info_get_framerate_num (dvideo);
+    video->framerate_denom =
+        gst_discoverer_video_info_get_framerate_denom (dvideo);
+    video->par_num = gst_discoverer_video_info_get_par_num (dvideo);
+    video->par_denom = gst_discoverer_video_info_get_par_denom (dvideo);
+    video->bitrate = gst_discoverer_video_info_get_bitrate (dvideo);
+    video->max_bitrate = gst_discoverer_video_info_get_max_bitrate (dvideo);
+    codec_tag = GST_TAG_VIDEO_CODEC;
+  } else if (type == GST_TYPE_PLAYER_AUDIO_INFO) {
+    GstPlayerAudioInfo *audio = (GstPlayerAudioInfo *) s;
+    GstDiscovererAudioInfo *daudio = (GstDiscovererAudioInfo *) dstream;
+
+    audio->channels = gst_discoverer_audio_info_get_channels (daudio);
+    audio->sample_rate = gst_discoverer_audio_info_get_sample_rate (daudio);
+    audio->bitrate = gst_discoverer_audio_info_get_bitrate (daudio);
+    audio->max_bitrate = gst_discoverer_audio_info_get_max_bitrate (daudio);
+    audio->language =
+        g_strdup (gst_discoverer_audio_info_get_language (daudio));
+    codec_tag = GST_TAG_AUDIO_CODEC;
+  } else {
+    GstPlayerSubtitleInfo *subtitle = (GstPlayerSubtitleInfo *) s;
+
+    subtitle->language =
+        g_strdup (gst_discoverer_subtitle_info_get_language (
+            (GstDiscovererSubtitleInfo *) dstream));
+    codec_tag = GST_TAG_SUBTITLE_CODEC;
+  }
+
+  s->codec = stream_get_codec (s, codec_tag);
+
+  return s;
+}
+
+static void
+media_info_add_discoverer_streams (GstPlayerMediaInfo * info,
+    GList * dstreams, GType type)
+{
+  GList *l;
+  gint i;
+
+  for (l = dstreams, i = 0; l != NULL; l = l->next, i++)
+    media_info_add_stream (info, stream_info_new_from_discoverer (l->data, i,
+            type));
+
+  gst_discoverer_stream_info_list_free (dstreams);
+}
+
+/* Builds the same media info the player creates after preroll from the
+ * result of a GstDiscoverer run */
+GstPlayerMediaInfo *
+gst_player_media_info_new_from_discoverer_info (GstDiscovererInfo * dinfo)
+{
+  GstPlayerMediaInfo *info;
+  GstDiscovererStreamInfo *dstream;
+  const GstTagList *tags;
+
+  info = gst_player_media_info_new (gst_discoverer_info_get_uri (dinfo));
+  info->duration = gst_discoverer_info_get_duration (dinfo);
+  info->seekable = gst_discoverer_info_get_seekable (dinfo);
+  info->playable = gst_discoverer_info_get_result (dinfo) !=
+      GST_DISCOVERER_MISSING_PLUGINS;
+
+  tags = gst_discoverer_info_get_tags (dinfo);
+  if (tags) {
+    info->tags = gst_tag_list_copy (tags);
+    gst_tag_list_get_string (tags, GST_TAG_TITLE, &info->title);
+    gst_tag_list_get_string (tags, GST_TAG_CONTAINER_FORMAT, &info->container);
+    gst_tag_list_get_sample (tags, GST_TAG_IMAGE, &info->image_sample);
+    if (!info->image_sample)
+      gst_tag_list_get_sample (tags, GST_TAG_PREVIEW_IMAGE,
+          &info->image_sample);
+  }
+
+  if (!info->container) {
+    dstream = gst_discoverer_info_get_stream_info (dinfo);
+    if (dstream && GST_IS_DISCOVERER_CONTAINER_INFO (dstream)) {
+      GstCaps *caps = gst_discoverer_stream_info_get_caps (dstream);
+
+      if (caps) {
+        info->container = gst_pb_utils_get_codec_description (caps);
+        gst_caps_unref (caps);
+      }
+    }
+    if (dstream)
+      gst_discoverer_stream_info_unref (dstream);
+  }
+
+  media_info_add_discoverer_streams (info,
+      gst_discoverer_info_get_video_streams (dinfo),
+      GST_TYPE_PLAYER_VIDEO_INFO);
+  media_info_add_discoverer_streams (info,
+      gst_discoverer_info_get_audio_streams (dinfo),
+      GST_TYPE_PLAYER_AUDIO_INFO);
+  media_info_add_discoverer_streams (info,
+      gst_discoverer_info_get_subtitle_streams (dinfo),
+      GST_TYPE_PLAYER_SUBTITLE_INFO);
+
+  return info;
+}
+
+static gchar *
+media_info_cache_get_filename (const gchar * uri)
+{
+  gchar *key, *filename;
+
+  key = gst_player_cache_make_file_key (uri);
+  if (!key)
+    return NULL;
+
+  filename = gst_player_cache_get_filename (MEDIA_INFO_CACHE_DIR, key);
+  g_free (key);
+
+  return filename;
+}
+
+static const gchar *
+str_or_empty (const gchar * str)
+{
+  return str ? str : "";
+}
+
+static gchar *
+dup_or_null (const gchar * str)
+{
+  return *str ? g_strdup (str) : NULL;
+}
+
+/* Images are stored separately in raw form */
+static gchar *
+tags_to_string (const GstTagList * tags)
+{
+  GstTagList *copy;
+  gchar *str;
+
+  if (!tags)
+    return g_strdup ("");
+
+  copy = gst_tag_list_copy (tags);
+  gst_tag_list_remove_tag (copy, GST_TAG_IMAGE);
+  gst_tag_list_remove_tag (copy, GST_TAG_PREVIEW_IMAGE);
+  str = gst_tag_list_to_string (copy);
+  gst_tag_list_unref (copy);
+
+  return str;
+}
+
+static GstTagList *
+tags_from_string (const gchar * str)
+{
+  return *str ? gst_tag_list_new_from_string (str) : NULL;
+}
+
+static GstCaps *
+caps_from_string (const gchar * str)
+{
+  return *str ? gst_caps_from_string (str) : NULL;
+}
+
+/* Stores @info for lookups by its URI until the file is modified. Only
+ * local files are cached */
+void
+gst_player_media_info_cache_store (GstPlayerMediaInfo * info)
+{
+  GVariantBuilder streams;
+  GVariant *variant, *image;
+  gchar *filename, *tags, *image_caps = NULL;
+  GstMapInfo map;
+  GList *l;
+
+  filename = media_info_cache_get_filename (info->uri);
+  if (!filename)
+    return;
+
+  g_variant_builder_init (&streams, G_VARIANT_TYPE ("a" STREAM_FORMAT));
+  for (l = info->stream_list; l != NULL; l = l->next) {
+    GstPlayerStreamInfo *s = l->data;
+    gint width = 0, height = 0, fps_n = 0, fps_d = 0, par_n = 0, par_d = 0;
+    gint channels = 0, rate = 0;
+    guint bitrate = 0, max_bitrate = 0;
+    const gchar *language = NULL;
+    gchar *caps, *stream_tags;
+    guint type;
+
+    if (GST_IS_PLAYER_VIDEO_INFO (s)) {
+      GstPlayerVideoInfo *video = (GstPlayerVideoInfo *) s;
+
+      type = STREAM_TYPE_VIDEO;
+      width = video->width;
+      height = video->height;
+      fps_n = video->framerate_num;
+      fps_d = video->framerate_denom;
+      par_n = video->par_num;
+      par_d = video->par_denom;
+      bitrate = video->bitrate;
+      max_bitrate = video->max_bitrate;
+    } else if (GST_IS_PLAYER_AUDIO_INFO (s)) {
+      GstPlayerAudioInfo *audio = (GstPlayerAudioInfo *) s;
+
+      type = STREAM_TYPE_AUDIO;
+      channels = audio->channels;
+      rate = audio->sample_rate;
+      bitrate = audio->bitrate;
+      max_bitrate = audio->max_bitrate;
+      language = audio->language;
+    } else {
+      type = STREAM_TYPE_SUBTITLE;
+      language = ((GstPlayerSubtitleInfo *) s)->language;
+    }
+
+    caps = s->caps ? gst_caps_to_string (s->caps) : g_strdup ("");
+    stream_tags = tags_to_string (s->tags);
+    g_variant_builder_add (&streams, STREAM_FORMAT, type, s->stream_index,
+        caps, stream_tags, str_or_empty (s->codec), width, height, fps_n,
+        fps_d, par_n, par_d, bitrate, max_bitrate, channels, rate,
+        str_or_empty (language));
+    g_free (caps);
+    g_free (stream_tags);
+  }
+
+  if (info->image_sample && gst_sample_get_buffer (info->image_sample)
+      && gst_buffer_map (gst_sample_get_buffer (info->image_sample), &map,
+          GST_MAP_READ)) {
+    GstCaps *caps = gst_sample_get_caps (info->image_sample);
+
+    image = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, map.data,
+        map.size, 1);
+    gst_buffer_unmap (gst_sample_get_buffer (info->image_sample), &map);
+    if (caps)
+      image_caps = gst_caps_to_string (caps);
+  } else {
+    image = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, NULL, 0, 1);
+  }
+
+  tags = tags_to_string (info->tags);
+  variant = g_variant_new (MEDIA_INFO_BUILD_FORMAT, MEDIA_INFO_CACHE_VERSION,
+      info->uri, str_or_empty (info->title), str_or_empty (info->container),
+      tags, info->seekable, (guint64) info->duration, info->playable,
+      str_or_empty (image_caps), image, &streams);
+  g_variant_ref_sink (variant);
+
+  /* Written atomically, lookups never see partial entries */
+  g_file_set_contents (filename, g_variant_get_data (variant),
+      g_variant_get_size (variant), NULL);
+
+  g_variant_unref (variant);
+  g_free (tags);
+  g_free (image_caps);
+  g_free (filename);
+}
+
+static GstSample *
+image_sample_new (const gchar * caps_str, GVariant * data)
+{
+  GstBuffer *buffer;
+  GstCaps *caps;
+  GstSample *sample;
+  gconstpointer bytes;
+  gsize size;
+
+  bytes = g_variant_get_fixed_array (data, &size, 1);
+  if (size == 0)
+    return NULL;
+
+  buffer = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_fill (buffer, 0, bytes, size);
+  caps = caps_from_string (caps_str);
+  sample = gst_sample_new (buffer, caps, NULL, NULL);
+  gst_buffer_unref (buffer);
+  if (caps)
+    gst_caps_unref (caps);
+
+  return sample;
+}
+
+static GstPlayerMediaInfo *
+media_info_new_from_variant (const gchar * uri, GVariant * variant)
+{
+  GstPlayerMediaInfo *info;
+  GVariantIter *streams;
+  GVariant *image;
+  const gchar *cached_uri, *title, *container, *tags, *image_caps;
+  const gchar *caps, *stream_tags, *codec, *language;
+  gint index, width, height, fps_n, fps_d, par_n, par_d, channels, rate;
+  guint version, type, bitrate, max_bitrate;
+  gboolean seekable, playable;
+  guint64 duration;
+
+  g_variant_get (variant, "(u&s&s&s&sbtb&s@aya" STREAM_FORMAT ")", &version,
+      &cached_uri, &title, &container, &tags, &seekable, &duration, &playable,
+      &image_caps, &image, &streams);
+
+  /* Keys are hashes, make sure this really is the entry for @uri */
+  if (version != MEDIA_INFO_CACHE_VERSION || g_strcmp0 (cached_uri, uri)) {
+    g_variant_unref (image);
+    g_variant_iter_free (streams);
+    return NULL;
+  }
+
+  info = gst_player_media_info_new (uri);
+  info->title = dup_or_null (title);
+  info->container = dup_or_null (container);
+  info->tags = tags_from_string (tags);
+  info->seekable = seekable;
+  info->duration = duration;
+  info->playable = playable;
+  info->image_sample = image_sample_new (image_caps, image);
+  if (info->image_sample) {
+    if (!info->tags)
+      info->tags = gst_tag_list_new_empty ();
+    gst_tag_list_add (info->tags, GST_TAG_MERGE_APPEND, GST_TAG_IMAGE,
+        info->image_sample, NULL);
+  }
+  g_variant_unref (image);
+
+  while (g_variant_iter_next (streams, "(ui&s&s&siiiiiiuuii&s)", &type,
+          &index, &caps, &stream_tags, &codec, &width, &height, &fps_n,
+          &fps_d, &par_n, &par_d, &bitrate, &max_bitrate, &channels, &rate,
+          &language)) {
+    GstPlayerStreamInfo *s;
+
+    if (type == STREAM_TYPE_VIDEO) {
+      GstPlayerVideoInfo *video;
+
+      s = gst_player_stream_info_new (index, GST_TYPE_PLAYER_VIDEO_INFO);
+      video = (GstPlayerVideoInfo *) s;
+      video->width = width;
+      video->height = height;
+      video->framerate_num = fps_n;
+      video->framerate_denom = fps_d;
+      video->par_num = par_n;
+      video->par_denom = par_d;
+      video->bitrate = bitrate;
+      video->max_bitrate = max_bitrate;
+    } else if (type == STREAM_TYPE_AUDIO) {
+      GstPlayerAudioInfo *audio;
+
+      s = gst_player_stream_info_new (index, GST_TYPE_PLAYER_AUDIO_INFO);
+      audio = (GstPlayerAudioInfo *) s;
+      audio->channels = channels;
+      audio->sample_rate = rate;
+      audio->bitrate = bitrate;
+      audio->max_bitrate = max_bitrate;
+      audio->language = dup_or_null (language);
+    } else {
+      s = gst_player_stream_info_new (index, GST_TYPE_PLAYER_SUBTITLE_INFO);
+      ((GstPlayerSubtitleInfo *) s)->language = dup_or_null (language);
+    }
+
+    s->caps = caps_from_string (caps);
+    s->tags = tags_from_string (stream_tags);
+    s->codec = dup_or_null (codec);
+    media_info_add_stream (info, s);
+  }
+  g_variant_iter_free (streams);
+
+  return info;
+}
+
+/* Returns the cached media info for @uri, or NULL if there is none or the
+ * file changed since it was stored */
+GstPlayerMediaInfo *
+gst_player_media_info_cache_lookup (const gchar * uri)
+{
+  GstPlayerMediaInfo *info = NULL;
+  GMappedFile *file;
+  GVariant *variant;
+  GBytes *bytes;
+  gchar *filename;
+
+  filename = media_info_cache_get_filename (uri);
+  if (!filename)
+    return NULL;
+
+  file = g_mapped_file_new (filename, FALSE, NULL);
+  g_free (filename);
+  if (!file)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (file);
+  g_mapped_file_unref (file);
+
+  variant = g_variant_new_from_bytes (G_VARIANT_TYPE (MEDIA_INFO_FORMAT),
+      bytes, FALSE);
+  g_variant_ref_sink (variant);
+  g_bytes_unref (bytes);
+
+  /* Cache files are not trusted, a corrupt one reads as default values */
+  if (g_variant_is_normal_form (variant))
+    info = media_info_new_from_variant (uri, variant);
+  g_variant_unref (variant);
+
+  return info;
+}
@@ -0,0 +1,64 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_FRAME_CACHE_PRIVATE_H__
+#define __GST_PLAYER_FRAME_CACHE_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerFrameCache GstPlayerFrameCache;
+
+G_GNUC_INTERNAL GstPlayerFrameCache * gst_player_frame_cache_new
+                                      (void);
+G_GNUC_INTERNAL void           gst_player_frame_cache_free
+                                      (GstPlayerFrameCache *cache);
+G_GNUC_INTERNAL void           gst_player_frame_cache_set_max_size
+                                      (GstPlayerFrameCache *cache,
+                                       guint64 max_size);
+G_GNUC_INTERNAL void           gst_player_frame_cache_clear
+                                      (GstPlayerFrameCache *cache);
+G_GNUC_INTERNAL void           gst_player_frame_cache_discont
+                                      (GstPlayerFrameCache *cache);
+G_GNUC_INTERNAL void           gst_player_frame_cache_add
+                                      (GstPlayerFrameCache *cache,
+                                       GstBuffer *buffer,
+                                       GstCaps *caps,
+                                       const GstSegment *segment);
+G_GNUC_INTERNAL gboolean       gst_player_frame_cache_get_current
+                                      (GstPlayerFrameCache *cache,
+                                       GstClockTime *position,
+                                       GstClockTime *duration);
+G_GNUC_INTERNAL void           gst_player_frame_cache_set_shown
+                                      (GstPlayerFrameCache *cache,
+                                       GstClockTime position);
+G_GNUC_INTERNAL GstClockTime   gst_player_frame_cache_get_shown
+                                      (GstPlayerFrameCache *cache);
+G_GNUC_INTERNAL GstSample *    gst_player_frame_cache_lookup
+                                      (GstPlayerFrameCache *cache,
+                                       GstClockTime position,
+                                       GstClockTime *frame_position);
+G_GNUC_INTERNAL GList *        gst_player_frame_cache_get_before
+                                      (GstPlayerFrameCache *cache,
+                                       GstClockTime position,
+                                       GstClockTime *first_position);
+G_GNUC_INTERNAL void           gst_player_frame_cache_get_stats
+                                      (GstPlayerFrameCache *cache,
+                                       guint64 *hits,
+                                       guint64 *misses);
+
+#endif /* __GST_PLAYER_FRAME_CACHE_PRIVATE_H__ */
@@ -0,0 +1,421 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Bounded cache of decoded video frames, grouped by GOP. Frames are
+ * recorded as they reach the video sink, so stepping backwards and seeks
+ * into the recently shown part of the media can show a frame again
+ * instead of decoding everything from the previous keyframe up to it.
+ *
+ * Reverse playback starts with the cached frames before the position as
+ * well, only the media before them is decoded.
+ *
+ * A GOP here is a run of consecutive frames that starts at a keyframe or
+ * at a discontinuity, e.g. after a seek. Frames keep a reference to the
+ * decoded buffers, only those from a pool with a maximum number of
+ * buffers are copied as holding on to them would starve the decoder. Once
+ * the frames exceed the maximum size whole GOPs are evicted, the least
+ * recently used first. */
+
+#include "gstplayer-frame-cache-private.h"
+
+typedef struct
+{
+  GstClockTime position;        /* stream time */
+  GstClockTime duration;
+  GstSample *sample;
+} Frame;
+
+typedef struct
+{
+  GArray *frames;               /* Frame, by position */
+  guint64 size;
+} Gop;
+
+struct _GstPlayerFrameCache
+{
+  GMutex lock;
+
+  GQueue gops;                  /* Gop, least recently used first */
+  /* Takes the next frame, unless that starts a new GOP */
+  Gop *last_gop;
+  guint64 size;
+  guint64 max_size;
+
+  /* Last frame that reached the sink */
+  GstClockTime current;
+  GstClockTime current_duration;
+  /* Cached frame that was shown last, while nothing was decoded since */
+  GstClockTime shown;
+
+  guint64 hits;
+  guint64 misses;
+};
+
+static void
+frame_clear (Frame * frame)
+{
+  gst_sample_unref (frame->sample);
+}
+
+/* Pools without a maximum allocate new buffers while others are held */
+static gboolean
+buffer_from_bounded_pool (GstBuffer * buffer)
+{
+  GstStructure *config;
+  guint max_buffers = 0;
+
+  if (!buffer->pool)
+    return FALSE;
+
+  config = gst_buffer_pool_get_config (buffer->pool);
+  gst_buffer_pool_config_get_params (config, NULL, NULL, NULL, &max_buffers);
+  gst_structure_free (config);
+
+  return max_buffers > 0;
+}
+
+static Gop *
+gop_new (void)
+{
+  Gop *gop = g_new0 (Gop, 1);
+
+  gop->frames = g_array_new (FALSE, FALSE, sizeof (Frame));
+  g_array_set_clear_func (gop->frames, (GDestroyNotify) frame_clear);
+
+  return gop;
+}
+
+static void
+gop_free (Gop * gop)
+{
+  g_array_free (gop->frames, TRUE);
+  g_free (gop);
+}
+
+/* Until the next frame if the duration is unknown */
+static gboolean
+gop_frame_contains (Gop * gop, guint index, GstClockTime position)
+{
+  Frame *frame = &g_array_index (gop->frames, Frame, index);
+
+  if (position < frame->position)
+    return FALSE;
+  if (GST_CLOCK_TIME_IS_VALID (frame->duration))
+    return position < frame->position + frame->duration;
+  if (index + 1 < gop->frames->len)
+    return position < g_array_index (gop->frames, Frame, index + 1).position;
+
+  return position == frame->position;
+}
+
+static Frame *
+find_frame_locked (GstPlayerFrameCache * cache, GstClockTime position,
+    GList ** gop_link)
+{
+  GList *l;
+  guint i;
+
+  for (l = cache->gops.head; l; l = l->next) {
+    Gop *gop = l->data;
+
+    if (position < g_array_index (gop->frames, Frame, 0).position)
+      continue;
+
+    for (i = gop->frames->len; i > 0; i--) {
+      if (gop_frame_contains (gop, i - 1, position)) {
+        if (gop_link)
+          *gop_link = l;
+        return &g_array_index (gop->frames, Frame, i - 1);
+      }
+    }
+  }
+
+  return NULL;
+}
+
+static void
+evict_locked (GstPlayerFrameCache * cache)
+{
+  while (cache->size > cache->max_size && cache->gops.length > 0) {
+    Gop *gop = g_queue_pop_head (&cache->gops);
+
+    cache->size -= gop->size;
+    if (gop == cache->last_gop)
+      cache->last_gop = NULL;
+    gop_free (gop);
+  }
+}
+
+GstPlayerFrameCache *
+gst_player_frame_cache_new (void)
+{
+  GstPlayerFrameCache *cache = g_new0 (GstPlayerFrameCache, 1);
+
+  g_mutex_init (&cache->lock);
+  g_queue_init (&cache->gops);
+  cache->current = GST_CLOCK_TIME_NONE;
+  cache->current_duration = GST_CLOCK_TIME_NONE;
+  cache->shown = GST_CLOCK_TIME_NONE;
+
+  return cache;
+}
+
+void
+gst_player_frame_cache_free (GstPlayerFrameCache * cache)
+{
+  gst_player_frame_cache_clear (cache);
+  g_mutex_clear (&cache->lock);
+  g_free (cache);
+}
+
+/* 0 disables the cache */
+void
+gst_player_frame_cache_set_max_size (GstPlayerFrameCache * cache,
+    guint64 max_size)
+{
+  g_mutex_lock (&cache->lock);
+  cache->max_size = max_size;
+  evict_locked (cache);
+  g_mutex_unlock (&cache->lock);
+}
+
+/* Forgets all frames, e.g. for new media */
+void
+gst_player_frame_cache_clear (GstPlayerFrameCache * cache)
+{
+  g_mutex_lock (&cache->lock);
+  g_queue_foreach (&cache->gops, (GFunc) gop_free, NULL);
+  g_queue_clear (&cache->gops);
+  cache->last_gop = NULL;
+  cache->size = 0;
+  cache->current = GST_CLOCK_TIME_NONE;
+  cache->current_duration = GST_CLOCK_TIME_NONE;
+  cache->shown = GST_CLOCK_TIME_NONE;
+  cache->hits = 0;
+  cache->misses = 0;
+  g_mutex_unlock (&cache->lock);
+}
+
+/* The next frame does not follow the previous one, e.g. after a flush */
+void
+gst_player_frame_cache_discont (GstPlayerFrameCache * cache)
+{
+  g_mutex_lock (&cache->lock);
+  cache->last_gop = NULL;
+  g_mutex_unlock (&cache->lock);
+}
+
+/* Called from the streaming thread for every frame reaching the sink */
+void
+gst_player_frame_cache_add (GstPlayerFrameCache * cache, GstBuffer * buffer,
+    GstCaps * caps, const GstSegment * segment)
+{
+  GstClockTime pts, duration, position;
+  guint64 start, stop, size;
+  GstBuffer *frame_buffer;
+  GList *gop_link = NULL;
+  Frame *cached;
+  Frame frame;
+  Gop *gop;
+
+  pts = GST_BUFFER_PTS (buffer);
+  duration = GST_BUFFER_DURATION (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (pts) || segment->format != GST_FORMAT_TIME)
+    return;
+
+  /* Frames outside of the segment are dropped by the sink */
+  stop = GST_CLOCK_TIME_IS_VALID (duration) ? pts + duration :
+      GST_CLOCK_TIME_NONE;
+  if (!gst_segment_clip (segment, GST_FORMAT_TIME, pts, stop, &start, &stop))
+    return;
+
+  /* The frame may start before the segment, e.g. after an accurate seek
+   * into the middle of it */
+  position = gst_segment_to_stream_time (segment, GST_FORMAT_TIME, start);
+  if (!GST_CLOCK_TIME_IS_VALID (position) || position < start - pts)
+    return;
+  position -= start - pts;
+
+  g_mutex_lock (&cache->lock);
+  cache->current = position;
+  cache->current_duration = duration;
+
+  size = gst_buffer_get_size (buffer);
+  if (cache->max_size == 0 || size > cache->max_size) {
+    g_mutex_unlock (&cache->lock);
+    return;
+  }
+
+  /* Decoded again, e.g. after seeking back. Following frames continue
+   * its GOP */
+  cached = find_frame_locked (cache, position, &gop_link);
+  if (cached && cached->position == position) {
+    cache->last_gop = gop_link->data;
+    g_mutex_unlock (&cache->lock);
+    return;
+  }
+
+  if (buffer_from_bounded_pool (buffer)) {
+    frame_buffer = gst_buffer_copy_region (buffer,
+        GST_BUFFER_COPY_ALL | GST_BUFFER_COPY_DEEP, 0, -1);
+    if (!frame_buffer) {
+      g_mutex_unlock (&cache->lock);
+      return;
+    }
+  } else {
+    frame_buffer = gst_buffer_ref (buffer);
+  }
+
+  gop = cache->last_gop;
+  if (!gop || GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DISCONT)
+      || !GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)
+      || position <= g_array_index (gop->frames, Frame,
+          gop->frames->len - 1).position) {
+    gop = gop_new ();
+    g_queue_push_tail (&cache->gops, gop);
+    cache->last_gop = gop;
+  }
+
+  frame.position = position;
+  frame.duration = duration;
+  frame.sample = gst_sample_new (frame_buffer, caps, segment, NULL);
+  gst_buffer_unref (frame_buffer);
+
+  g_array_append_val (gop->frames, frame);
+  gop->size += size;
+  cache->size += size;
+  evict_locked (cache);
+  g_mutex_unlock (&cache->lock);
+}
+
+/* Position and duration of the last frame that reached the sink */
+gboolean
+gst_player_frame_cache_get_current (GstPlayerFrameCache * cache,
+    GstClockTime * position, GstClockTime * duration)
+{
+  gboolean ret;
+
+  g_mutex_lock (&cache->lock);
+  ret = GST_CLOCK_TIME_IS_VALID (cache->current);
+  *position = cache->current;
+  *duration = cache->current_duration;
+  g_mutex_unlock (&cache->lock);
+
+  return ret;
+}
+
+/* Position of the cached frame that was shown instead of decoding, or
+ * GST_CLOCK_TIME_NONE once decoding continues */
+void
+gst_player_frame_cache_set_shown (GstPlayerFrameCache * cache,
+    GstClockTime position)
+{
+  g_mutex_lock (&cache->lock);
+  cache->shown = position;
+  g_mutex_unlock (&cache->lock);
+}
+
+GstClockTime
+gst_player_frame_cache_get_shown (GstPlayerFrameCache * cache)
+{
+  GstClockTime shown;
+
+  g_mutex_lock (&cache->lock);
+  shown = cache->shown;
+  g_mutex_unlock (&cache->lock);
+
+  return shown;
+}
+
+/* Returns the frame shown at @position, or NULL if it is not cached */
+GstSample *
+gst_player_frame_cache_lookup (GstPlayerFrameCache * cache,
+    GstClockTime position, GstClockTime * frame_position)
+{
+  GstSample *sample = NULL;
+  GList *gop_link = NULL;
+  Frame *frame;
+
+  g_mutex_lock (&cache->lock);
+  frame = find_frame_locked (cache, position, &gop_link);
+  if (frame) {
+    sample = gst_sample_ref (frame->sample);
+    *frame_position = frame->position;
+    cache->hits++;
+
+    /* Now the most recently used */
+    g_queue_unlink (&cache->gops, gop_link);
+    g_queue_push_tail_link (&cache->gops, gop_link);
+  } else {
+    cache->misses++;
+  }
+  g_mutex_unlock (&cache->lock);
+
+  return sample;
+}
+
+/* Returns the cached frames from the one shown at @position back to the
+ * first of the consecutive cached frames before it, latest first, or NULL
+ * if the frame at @position is not cached. @first_position is set to the
+ * position of the earliest of them */
+GList *
+gst_player_frame_cache_get_before (GstPlayerFrameCache * cache,
+    GstClockTime position, GstClockTime * first_position)
+{
+  GList *samples = NULL, *gop_link = NULL;
+  Frame *frame;
+  Gop *gop;
+  guint i;
+
+  g_mutex_lock (&cache->lock);
+  frame = find_frame_locked (cache, position, &gop_link);
+  while (frame) {
+    gop = gop_link->data;
+    i = frame - &g_array_index (gop->frames, Frame, 0);
+    do {
+      frame = &g_array_index (gop->frames, Frame, i);
+      samples = g_list_prepend (samples, gst_sample_ref (frame->sample));
+      *first_position = frame->position;
+    } while (i-- > 0);
+
+    /* Continues in another GOP if that ends right before this one */
+    if (*first_position == 0)
+      break;
+    frame = find_frame_locked (cache, *first_position - 1, &gop_link);
+    if (frame && frame->position >= *first_position)
+      frame = NULL;
+  }
+
+  if (samples)
+    cache->hits++;
+  else
+    cache->misses++;
+  g_mutex_unlock (&cache->lock);
+
+  return g_list_reverse (samples);
+}
+
+void
+gst_player_frame_cache_get_stats (GstPlayerFrameCache * cache,
+    guint64 * hits, guint64 * misses)
+{
+  g_mutex_lock (&cache->lock);
+  *hits = cache->hits;
+  *misses = cache->misses;
+  g_mutex_unlock (&cache->lock);
+}
@@ -0,0 +1,33 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_GROUP_PRIVATE_H__
+#define __GST_PLAYER_GROUP_PRIVATE_H__
+
+#include "gstplayer.h"
+
+/* Implemented by the player for its group */
+G_GNUC_INTERNAL void gst_player_set_group_clock (GstPlayer *player,
+                                                 GstClock *clock);
+G_GNUC_INTERNAL void gst_player_sync            (GstPlayer *player,
+                                                 GstClockTime position,
+                                                 gdouble rate,
+                                                 GstClockTime base_time,
+                                                 gboolean play);
+
+#endif /* __GST_PLAYER_GROUP_PRIVATE_H__ */
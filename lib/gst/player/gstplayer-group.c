@@ -0,0 +1,815 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-group
+ * @short_description: GStreamer Player Group API
+ *
+ * A #GstPlayerGroup keeps several #GstPlayer instances in sync, for example
+ * the screens of a video wall. All members run on the clock of the group
+ * with a common base time, so they render the same position at the same
+ * moment. Starting, seeking and rate changes restart all members together
+ * at the same position.
+ *
+ * While playing, the positions of the members are compared and all of
+ * them are synced again once they drifted apart by more than the drift
+ * threshold, for example after one of them stalled.
+ *
+ * Players in other processes on the same machine can follow along by
+ * running on a #GstNetClientClock of the clock provided with
+ * gst_player_group_provide_net_clock() and starting at the base time
+ * returned by gst_player_group_get_base_time() with
+ * gst_player_group_play_at().
+ *
+ * Members must only be controlled through their group.
+ */
+
+#include "gstplayer-group.h"
+#include "gstplayer-group-private.h"
+
+#include <gst/net/gstnettimeprovider.h>
+
+/* Time between a (re)start and the common base time, for all members to
+ * preroll until then */
+#define START_DELAY (500 * GST_MSECOND)
+/* Minimum time between two syncs because of drift */
+#define RESYNC_INTERVAL (5 * GST_SECOND)
+
+enum
+{
+  PROP_0,
+  PROP_CLOCK,
+  PROP_RATE,
+  PROP_DRIFT_THRESHOLD,
+  PROP_LAST
+};
+
+typedef enum
+{
+  GROUP_STOPPED,
+  GROUP_PAUSED,
+  GROUP_PLAYING
+} GroupState;
+
+typedef struct
+{
+  GstPlayer *player;
+  GstPlayerState state;
+} GroupMember;
+
+struct _GstPlayerGroup
+{
+  GstObject parent;
+
+  GstClock *clock;
+
+  /* All protected by the object lock */
+  GstNetTimeProvider *net_time_provider;
+  GPtrArray *members;
+  GroupState state;
+  gdouble rate;
+  GstClockTime base_time;
+  GstClockTime drift_threshold;
+  GstClockTime drift;
+  /* Clock time of the last sync */
+  GstClockTime last_sync;
+};
+
+struct _GstPlayerGroupClass
+{
+  GstObjectClass parent_class;
+};
+
+#define parent_class gst_player_group_parent_class
+G_DEFINE_TYPE (GstPlayerGroup, gst_player_group, GST_TYPE_OBJECT);
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+
+static void gst_player_group_dispose (GObject * object);
+static void gst_player_group_finalize (GObject * object);
+static void gst_player_group_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_player_group_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_player_group_constructed (GObject * object);
+
+static void
+gst_player_group_init (GstPlayerGroup * self)
+{
+  self->members = g_ptr_array_new ();
+  self->state = GROUP_STOPPED;
+  self->rate = 1.0;
+  self->base_time = GST_CLOCK_TIME_NONE;
+  self->drift_threshold = 20 * GST_MSECOND;
+  self->drift = 0;
+  self->last_sync = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_player_group_class_init (GstPlayerGroupClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_player_group_set_property;
+  gobject_class->get_property = gst_player_group_get_property;
+  gobject_class->dispose = gst_player_group_dispose;
+  gobject_class->finalize = gst_player_group_finalize;
+  gobject_class->constructed = gst_player_group_constructed;
+
+  param_specs[PROP_CLOCK] =
+      g_param_spec_object ("clock", "Clock",
+      "Clock all members run on", GST_TYPE_CLOCK,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_RATE] =
+      g_param_spec_double ("rate", "Rate",
+      "Playback rate of all members", -64.0, 64.0, 1.0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_DRIFT_THRESHOLD] =
+      g_param_spec_uint64 ("drift-threshold", "Drift threshold",
+      "Difference between the positions of members at which they are synced "
+      "again", 0, G_MAXUINT64, 20 * GST_MSECOND,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+}
+
+static void
+gst_player_group_constructed (GObject * object)
+{
+  GstPlayerGroup *self = GST_PLAYER_GROUP (object);
+
+  if (!self->clock)
+    self->clock = gst_system_clock_obtain ();
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
+/* Must be called with the object lock */
+static GroupMember *
+find_member_locked (GstPlayerGroup * self, GstPlayer * player, guint * index)
+{
+  guint i;
+
+  for (i = 0; i < self->members->len; i++) {
+    GroupMember *member = g_ptr_array_index (self->members, i);
+
+    if (member->player == player) {
+      if (index)
+        *index = i;
+      return member;
+    }
+  }
+
+  return NULL;
+}
+
+/* Returns the players of all members, the first one is the reference for
+ * the others. Free with free_players() */
+static GstPlayer **
+get_players (GstPlayerGroup * self, guint * n_players)
+{
+  GstPlayer **players;
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  *n_players = self->members->len;
+  players = g_new (GstPlayer *, self->members->len);
+  for (i = 0; i < self->members->len; i++)
+    players[i] = gst_object_ref (((GroupMember *)
+            g_ptr_array_index (self->members, i))->player);
+  GST_OBJECT_UNLOCK (self);
+
+  return players;
+}
+
+static void
+free_players (GstPlayer ** players, guint n_players)
+{
+  guint i;
+
+  for (i = 0; i < n_players; i++)
+    gst_object_unref (players[i]);
+  g_free (players);
+}
+
+/* Where the first member is, which the others follow */
+static GstClockTime
+get_reference_position (GstPlayerGroup * self)
+{
+  GstClockTime position = GST_CLOCK_TIME_NONE;
+  GstPlayer *player = NULL;
+
+  GST_OBJECT_LOCK (self);
+  if (self->members->len > 0)
+    player = gst_object_ref (((GroupMember *)
+            g_ptr_array_index (self->members, 0))->player);
+  GST_OBJECT_UNLOCK (self);
+
+  if (player) {
+    position = gst_player_get_position (player);
+    gst_object_unref (player);
+  }
+
+  return position;
+}
+
+/* Restarts all members at @position, or where they are if
+ * GST_CLOCK_TIME_NONE, so that they reach it at @base_time. If that is
+ * GST_CLOCK_TIME_NONE, a base time shortly after now is used */
+static void
+sync_members (GstPlayerGroup * self, GstClockTime position,
+    GstClockTime base_time, gboolean play)
+{
+  GstClockTime now = gst_clock_get_time (self->clock);
+  GstPlayer **players;
+  guint i, n_players;
+  gdouble rate;
+
+  if (!GST_CLOCK_TIME_IS_VALID (base_time))
+    base_time = now + START_DELAY;
+
+  GST_OBJECT_LOCK (self);
+  self->state = play ? GROUP_PLAYING : GROUP_PAUSED;
+  self->base_time = base_time;
+  self->last_sync = now;
+  self->drift = 0;
+  rate = self->rate;
+  GST_OBJECT_UNLOCK (self);
+
+  GST_DEBUG_OBJECT (self, "Syncing at %" GST_TIME_FORMAT " with base time %"
+      GST_TIME_FORMAT ", rate %.2lf", GST_TIME_ARGS (position),
+      GST_TIME_ARGS (base_time), rate);
+
+  players = get_players (self, &n_players);
+  for (i = 0; i < n_players; i++)
+    gst_player_sync (players[i], position, rate, base_time, play);
+  free_players (players, n_players);
+}
+
+static void
+state_changed_cb (GstPlayer * player, GstPlayerState state,
+    GstPlayerGroup * self)
+{
+  GroupMember *member;
+
+  GST_OBJECT_LOCK (self);
+  member = find_member_locked (self, player, NULL);
+  if (member)
+    member->state = state;
+  GST_OBJECT_UNLOCK (self);
+}
+
+/* Compares the positions of all members whenever the first one reports
+ * its position */
+static void
+position_updated_cb (GstPlayer * player, GstClockTime position,
+    GstPlayerGroup * self)
+{
+  GstClockTime reference, drift = 0, now;
+  GstPlayer **players;
+  guint i, n_players;
+  gboolean resync;
+
+  GST_OBJECT_LOCK (self);
+  if (self->state != GROUP_PLAYING || self->members->len < 2
+      || ((GroupMember *) g_ptr_array_index (self->members,
+              0))->player != player) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+  for (i = 0; i < self->members->len; i++) {
+    if (((GroupMember *) g_ptr_array_index (self->members,
+                i))->state != GST_PLAYER_STATE_PLAYING) {
+      GST_OBJECT_UNLOCK (self);
+      return;
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  players = get_players (self, &n_players);
+  reference = gst_player_get_position (players[0]);
+  for (i = 1; i < n_players && GST_CLOCK_TIME_IS_VALID (reference); i++) {
+    position = gst_player_get_position (players[i]);
+    if (GST_CLOCK_TIME_IS_VALID (position))
+      drift = MAX (drift, position > reference ? position - reference :
+          reference - position);
+  }
+  free_players (players, n_players);
+
+  now = gst_clock_get_time (self->clock);
+
+  GST_OBJECT_LOCK (self);
+  self->drift = drift;
+  resync = self->state == GROUP_PLAYING && drift > self->drift_threshold
+      && now >= self->last_sync + RESYNC_INTERVAL;
+  GST_OBJECT_UNLOCK (self);
+
+  if (resync) {
+    GST_DEBUG_OBJECT (self, "Members drifted apart by %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (drift));
+    sync_members (self, get_reference_position (self), GST_CLOCK_TIME_NONE,
+        TRUE);
+  }
+}
+
+static void
+remove_member (GstPlayerGroup * self, GroupMember * member)
+{
+  g_signal_handlers_disconnect_by_func (member->player, state_changed_cb,
+      self);
+  g_signal_handlers_disconnect_by_func (member->player, position_updated_cb,
+      self);
+  gst_player_set_group_clock (member->player, NULL);
+  gst_object_unref (member->player);
+  g_free (member);
+}
+
+static void
+gst_player_group_dispose (GObject * object)
+{
+  GstPlayerGroup *self = GST_PLAYER_GROUP (object);
+  guint i;
+
+  for (i = 0; i < self->members->len; i++)
+    remove_member (self, g_ptr_array_index (self->members, i));
+  g_ptr_array_set_size (self->members, 0);
+
+  if (self->net_time_provider) {
+    gst_object_unref (self->net_time_provider);
+    self->net_time_provider = NULL;
+  }
+
+  if (self->clock) {
+    gst_object_unref (self->clock);
+    self->clock = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_player_group_finalize (GObject * object)
+{
+  GstPlayerGroup *self = GST_PLAYER_GROUP (object);
+
+  g_ptr_array_unref (self->members);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_player_group_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPlayerGroup *self = GST_PLAYER_GROUP (object);
+
+  switch (prop_id) {
+    case PROP_CLOCK:
+      self->clock = g_value_dup_object (value);
+      break;
+    case PROP_RATE:
+      gst_player_group_set_rate (self, g_value_get_double (value));
+      break;
+    case PROP_DRIFT_THRESHOLD:
+      GST_OBJECT_LOCK (self);
+      self->drift_threshold = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_player_group_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPlayerGroup *self = GST_PLAYER_GROUP (object);
+
+  switch (prop_id) {
+    case PROP_CLOCK:
+      g_value_set_object (value, self->clock);
+      break;
+    case PROP_RATE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_double (value, self->rate);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_DRIFT_THRESHOLD:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->drift_threshold);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/**
+ * gst_player_group_new:
+ * @clock: (allow-none): #GstClock for all members, or %NULL for the system
+ *   clock
+ *
+ * Creates a new, empty group.
+ *
+ * Returns: a new #GstPlayerGroup instance
+ */
+GstPlayerGroup *
+gst_player_group_new (GstClock * clock)
+{
+  g_return_val_if_fail (clock == NULL || GST_IS_CLOCK (clock), NULL);
+
+  return g_object_new (GST_TYPE_PLAYER_GROUP, "clock", clock, NULL);
+}
+
+/**
+ * gst_player_group_get_clock:
+ * @group: #GstPlayerGroup instance
+ *
+ * Returns: (transfer full): the #GstClock all members run on.
+ */
+GstClock *
+gst_player_group_get_clock (GstPlayerGroup * self)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_GROUP (self), NULL);
+
+  return gst_object_ref (self->clock);
+}
+
+/**
+ * gst_player_group_provide_net_clock:
+ * @group: #GstPlayerGroup instance
+ * @address: (allow-none): address to listen on, or %NULL for all
+ * @port: port to listen on, or 0 for any free one
+ *
+ * Makes the clock of the group available to other processes, which can
+ * follow it with gst_net_client_clock_new(). Calling this again returns
+ * the port the clock is already provided on.
+ *
+ * Returns: the port the clock is provided on, or -1 on failure.
+ */
+gint
+gst_player_group_provide_net_clock (GstPlayerGroup * self,
+    const gchar * address, gint port)
+{
+  GstNetTimeProvider *provider;
+
+  g_return_val_if_fail (GST_IS_PLAYER_GROUP (self), -1);
+  g_return_val_if_fail (port >= 0 && port <= G_MAXUINT16, -1);
+
+  GST_OBJECT_LOCK (self);
+  if (!self->net_time_provider) {
+    self->net_time_provider =
+        gst_net_time_provider_new (self->clock, address, port);
+    if (!self->net_time_provider) {
+      GST_OBJECT_UNLOCK (self);
+      GST_WARNING_OBJECT (self, "Failed to provide the clock on port %d",
+          port);
+      return -1;
+    }
+  }
+  provider = gst_object_ref (self->net_time_provider);
+  GST_OBJECT_UNLOCK (self);
+
+  g_object_get (provider, "port", &port, NULL);
+  gst_object_unref (provider);
+
+  return port;
+}
+
+/**
+ * gst_player_group_add_player:
+ * @group: #GstPlayerGroup instance
+ * @player: #GstPlayer to add
+ *
+ * Adds @player to the group. It runs on the clock of the group from now
+ * on. If the group is already playing or paused, all members are synced
+ * again to include @player.
+ */
+void
+gst_player_group_add_player (GstPlayerGroup * self, GstPlayer * player)
+{
+  GroupMember *member;
+  GroupState state;
+
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+  g_return_if_fail (GST_IS_PLAYER (player));
+
+  GST_OBJECT_LOCK (self);
+  if (find_member_locked (self, player, NULL)) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+
+  member = g_new0 (GroupMember, 1);
+  member->player = gst_object_ref (player);
+  member->state = GST_PLAYER_STATE_STOPPED;
+  g_ptr_array_add (self->members, member);
+  state = self->state;
+  GST_OBJECT_UNLOCK (self);
+
+  gst_player_set_group_clock (player, self->clock);
+  g_signal_connect (player, "state-changed", G_CALLBACK (state_changed_cb),
+      self);
+  g_signal_connect (player, "position-updated",
+      G_CALLBACK (position_updated_cb), self);
+
+  if (state != GROUP_STOPPED)
+    sync_members (self, get_reference_position (self), GST_CLOCK_TIME_NONE,
+        state == GROUP_PLAYING);
+}
+
+/**
+ * gst_player_group_remove_player:
+ * @group: #GstPlayerGroup instance
+ * @player: #GstPlayer to remove
+ *
+ * Removes @player from the group. It selects its clock on its own again
+ * from the next start on.
+ */
+void
+gst_player_group_remove_player (GstPlayerGroup * self, GstPlayer * player)
+{
+  GroupMember *member;
+  guint index;
+
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+  g_return_if_fail (GST_IS_PLAYER (player));
+
+  GST_OBJECT_LOCK (self);
+  member = find_member_locked (self, player, &index);
+  if (member)
+    g_ptr_array_remove_index (self->members, index);
+  GST_OBJECT_UNLOCK (self);
+
+  if (member)
+    remove_member (self, member);
+}
+
+/**
+ * gst_player_group_play:
+ * @group: #GstPlayerGroup instance
+ *
+ * Starts all members together, shortly after now so that all of them can
+ * preroll before. Paused members continue from the position of the first
+ * member.
+ */
+void
+gst_player_group_play (GstPlayerGroup * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+
+  gst_player_group_play_at (self, GST_CLOCK_TIME_NONE);
+}
+
+/**
+ * gst_player_group_play_at:
+ * @group: #GstPlayerGroup instance
+ * @base_time: clock time at which playback starts, or
+ *   #GST_CLOCK_TIME_NONE for shortly after now
+ *
+ * Same as gst_player_group_play() but starts at @base_time, for example
+ * the base time of a group in another process that provides its clock.
+ */
+void
+gst_player_group_play_at (GstPlayerGroup * self, GstClockTime base_time)
+{
+  GstClockTime position = GST_CLOCK_TIME_NONE;
+  GroupState state;
+
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+
+  GST_OBJECT_LOCK (self);
+  state = self->state;
+  GST_OBJECT_UNLOCK (self);
+
+  if (state == GROUP_PLAYING && !GST_CLOCK_TIME_IS_VALID (base_time))
+    return;
+
+  if (state != GROUP_STOPPED)
+    position = get_reference_position (self);
+
+  sync_members (self, position, base_time, TRUE);
+}
+
+/**
+ * gst_player_group_pause:
+ * @group: #GstPlayerGroup instance
+ *
+ * Pauses all members.
+ */
+void
+gst_player_group_pause (GstPlayerGroup * self)
+{
+  GstPlayer **players;
+  guint i, n_players;
+
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+
+  GST_OBJECT_LOCK (self);
+  self->state = GROUP_PAUSED;
+  GST_OBJECT_UNLOCK (self);
+
+  players = get_players (self, &n_players);
+  for (i = 0; i < n_players; i++)
+    gst_player_pause (players[i]);
+  free_players (players, n_players);
+}
+
+/**
+ * gst_player_group_stop:
+ * @group: #GstPlayerGroup instance
+ *
+ * Stops all members.
+ */
+void
+gst_player_group_stop (GstPlayerGroup * self)
+{
+  GstPlayer **players;
+  guint i, n_players;
+
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+
+  GST_OBJECT_LOCK (self);
+  self->state = GROUP_STOPPED;
+  self->base_time = GST_CLOCK_TIME_NONE;
+  self->drift = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  players = get_players (self, &n_players);
+  for (i = 0; i < n_players; i++)
+    gst_player_stop (players[i]);
+  free_players (players, n_players);
+}
+
+/**
+ * gst_player_group_seek:
+ * @group: #GstPlayerGroup instance
+ * @position: position to seek to in nanoseconds
+ *
+ * Seeks all members to @position and restarts them together if the group
+ * is playing. A stopped group is paused at @position.
+ */
+void
+gst_player_group_seek (GstPlayerGroup * self, GstClockTime position)
+{
+  GroupState state;
+
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (position));
+
+  GST_OBJECT_LOCK (self);
+  state = self->state;
+  GST_OBJECT_UNLOCK (self);
+
+  sync_members (self, position, GST_CLOCK_TIME_NONE,
+      state == GROUP_PLAYING);
+}
+
+/**
+ * gst_player_group_set_rate:
+ * @group: #GstPlayerGroup instance
+ * @rate: playback rate
+ *
+ * Changes the playback rate of all members together, at the position of
+ * the first member.
+ */
+void
+gst_player_group_set_rate (GstPlayerGroup * self, gdouble rate)
+{
+  GroupState state;
+
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+  g_return_if_fail (rate != 0.0);
+
+  GST_OBJECT_LOCK (self);
+  if (self->rate == rate) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+  self->rate = rate;
+  state = self->state;
+  GST_OBJECT_UNLOCK (self);
+
+  if (state != GROUP_STOPPED)
+    sync_members (self, get_reference_position (self), GST_CLOCK_TIME_NONE,
+        state == GROUP_PLAYING);
+
+  g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_RATE]);
+}
+
+/**
+ * gst_player_group_get_rate:
+ * @group: #GstPlayerGroup instance
+ *
+ * Returns: the playback rate of all members.
+ */
+gdouble
+gst_player_group_get_rate (GstPlayerGroup * self)
+{
+  gdouble rate;
+
+  g_return_val_if_fail (GST_IS_PLAYER_GROUP (self), 1.0);
+
+  g_object_get (self, "rate", &rate, NULL);
+
+  return rate;
+}
+
+/**
+ * gst_player_group_get_base_time:
+ * @group: #GstPlayerGroup instance
+ *
+ * Returns: the clock time at which the members were last (re)started, or
+ *   #GST_CLOCK_TIME_NONE if the group is stopped.
+ */
+GstClockTime
+gst_player_group_get_base_time (GstPlayerGroup * self)
+{
+  GstClockTime base_time;
+
+  g_return_val_if_fail (GST_IS_PLAYER_GROUP (self), GST_CLOCK_TIME_NONE);
+
+  GST_OBJECT_LOCK (self);
+  base_time = self->base_time;
+  GST_OBJECT_UNLOCK (self);
+
+  return base_time;
+}
+
+/**
+ * gst_player_group_set_drift_threshold:
+ * @group: #GstPlayerGroup instance
+ * @threshold: difference between positions in nanoseconds
+ *
+ * Sets how far the positions of the members may differ before they are
+ * synced again. Defaults to 20 milliseconds.
+ */
+void
+gst_player_group_set_drift_threshold (GstPlayerGroup * self,
+    GstClockTime threshold)
+{
+  g_return_if_fail (GST_IS_PLAYER_GROUP (self));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (threshold));
+
+  g_object_set (self, "drift-threshold", threshold, NULL);
+}
+
+/**
+ * gst_player_group_get_drift_threshold:
+ * @group: #GstPlayerGroup instance
+ *
+ * Returns: how far the positions of the members may differ before they
+ *   are synced again.
+ */
+GstClockTime
+gst_player_group_get_drift_threshold (GstPlayerGroup * self)
+{
+  GstClockTime threshold;
+
+  g_return_val_if_fail (GST_IS_PLAYER_GROUP (self), GST_CLOCK_TIME_NONE);
+
+  g_object_get (self, "drift-threshold", &threshold, NULL);
+
+  return threshold;
+}
+
+/**
+ * gst_player_group_get_drift:
+ * @group: #GstPlayerGroup instance
+ *
+ * Returns: the largest difference between the position of the first
+ *   member and the others when they were last compared.
+ */
+GstClockTime
+gst_player_group_get_drift (GstPlayerGroup * self)
+{
+  GstClockTime drift;
+
+  g_return_val_if_fail (GST_IS_PLAYER_GROUP (self), GST_CLOCK_TIME_NONE);
+
+  GST_OBJECT_LOCK (self);
+  drift = self->drift;
+  GST_OBJECT_UNLOCK (self);
+
+  return drift;
+}
@@ -0,0 +1,73 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_GROUP_H__
+#define __GST_PLAYER_GROUP_H__
+
+#include <gst/gst.h>
+#include <gst/player/gstplayer.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstPlayerGroup GstPlayerGroup;
+typedef struct _GstPlayerGroupClass GstPlayerGroupClass;
+
+#define GST_TYPE_PLAYER_GROUP             (gst_player_group_get_type ())
+#define GST_IS_PLAYER_GROUP(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_GROUP))
+#define GST_IS_PLAYER_GROUP_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_PLAYER_GROUP))
+#define GST_PLAYER_GROUP_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_PLAYER_GROUP, GstPlayerGroupClass))
+#define GST_PLAYER_GROUP(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_GROUP, GstPlayerGroup))
+#define GST_PLAYER_GROUP_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_PLAYER_GROUP, GstPlayerGroupClass))
+#define GST_PLAYER_GROUP_CAST(obj)        ((GstPlayerGroup*)(obj))
+
+GType        gst_player_group_get_type                (void);
+
+GstPlayerGroup *
+             gst_player_group_new                     (GstClock * clock);
+
+GstClock *   gst_player_group_get_clock               (GstPlayerGroup * group);
+gint         gst_player_group_provide_net_clock       (GstPlayerGroup * group,
+                                                       const gchar * address,
+                                                       gint port);
+
+void         gst_player_group_add_player              (GstPlayerGroup * group,
+                                                       GstPlayer * player);
+void         gst_player_group_remove_player           (GstPlayerGroup * group,
+                                                       GstPlayer * player);
+
+void         gst_player_group_play                    (GstPlayerGroup * group);
+void         gst_player_group_play_at                 (GstPlayerGroup * group,
+                                                       GstClockTime base_time);
+void         gst_player_group_pause                   (GstPlayerGroup * group);
+void         gst_player_group_stop                    (GstPlayerGroup * group);
+void         gst_player_group_seek                    (GstPlayerGroup * group,
+                                                       GstClockTime position);
+void         gst_player_group_set_rate                (GstPlayerGroup * group,
+                                                       gdouble rate);
+gdouble      gst_player_group_get_rate                (GstPlayerGroup * group);
+
+GstClockTime gst_player_group_get_base_time           (GstPlayerGroup * group);
+
+void         gst_player_group_set_drift_threshold     (GstPlayerGroup * group,
+                                                       GstClockTime threshold);
+GstClockTime gst_player_group_get_drift_threshold     (GstPlayerGroup * group);
+GstClockTime gst_player_group_get_drift               (GstPlayerGroup * group);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_GROUP_H__ */
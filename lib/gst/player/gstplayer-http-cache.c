@@ -0,0 +1,1721 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* On-disk cache for media served over HTTP, used through a source element
+ * that hands out byte ranges from the cache and only downloads what is
+ * missing. Replays and seeks back are served locally.
+ *
+ * Entries are keyed by URL, validator (the ETag, or else Last-Modified)
+ * and size, so a changed resource is never served from stale data. Each
+ * entry is a sparse data file next to a metadata file listing the byte
+ * ranges it holds. When the cache grows beyond its size the least
+ * recently used entries are removed. Media without a validator is only
+ * cached while it is played.
+ *
+ * Connections are kept alive and reused by the next request to the same
+ * server, which includes the requests for the next media played.
+ *
+ * playbin only picks sources by URI protocol, so the player uses the cache
+ * by rewriting http:// and https:// URIs to protocols only this element
+ * handles. */
+
+#include "gstplayer-http-cache-private.h"
+#include "gstplayer-cache-private.h"
+
+#include <gio/gio.h>
+#include <gst/base/gstbasesrc.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#define HTTP_CACHE_PROTOCOL_PREFIX "gstplayer-cache+"
+#define HTTP_CACHE_DIR "http"
+#define HTTP_CACHE_META_SUFFIX ".meta"
+/* url, validator, size, last access, cached ranges */
+#define HTTP_CACHE_META_FORMAT "(sstxa(tt))"
+/* New data after which the metadata is written out while playing */
+#define HTTP_CACHE_SAVE_INTERVAL (4 * 1024 * 1024)
+
+#define HTTP_TIMEOUT 30
+#define HTTP_MAX_REDIRECTS 5
+#define HTTP_MAX_IDLE_CONNECTIONS 4
+#define HTTP_IDLE_TIMEOUT (30 * G_TIME_SPAN_SECOND)
+/* Gaps in front of the download position up to this are read through
+ * instead of starting a new request */
+#define HTTP_MAX_SKIP (256 * 1024)
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_http_cache_debug);
+#define GST_CAT_DEFAULT gst_player_http_cache_debug
+
+/* HTTP client */
+
+typedef struct
+{
+  gboolean tls;
+  gchar *host;
+  guint16 port;
+  gchar *path;
+} HttpUrl;
+
+static void
+http_url_clear (HttpUrl * url)
+{
+  g_free (url->host);
+  g_free (url->path);
+}
+
+static gboolean
+http_url_parse (const gchar * str, HttpUrl * url)
+{
+  const gchar *p, *path, *host_end;
+  gchar *end;
+  guint64 port;
+
+  if (g_ascii_strncasecmp (str, "http://", 7) == 0) {
+    url->tls = FALSE;
+    p = str + 7;
+  } else if (g_ascii_strncasecmp (str, "https://", 8) == 0) {
+    url->tls = TRUE;
+    p = str + 8;
+  } else {
+    return FALSE;
+  }
+
+  path = p + strcspn (p, "/?#");
+  /* User info is not supported */
+  if (memchr (p, '@', path - p))
+    return FALSE;
+
+  if (*p == '[') {
+    host_end = memchr (p, ']', path - p);
+    if (!host_end)
+      return FALSE;
+    url->host = g_strndup (p + 1, host_end - p - 1);
+    host_end++;
+  } else {
+    host_end = memchr (p, ':', path - p);
+    if (!host_end)
+      host_end = path;
+    url->host = g_strndup (p, host_end - p);
+  }
+
+  url->port = url->tls ? 443 : 80;
+  if (*host_end == ':') {
+    port = g_ascii_strtoull (host_end + 1, &end, 10);
+    if (end != path || port == 0 || port > G_MAXUINT16) {
+      g_free (url->host);
+      return FALSE;
+    }
+    url->port = port;
+  } else if (host_end != path || !*url->host) {
+    g_free (url->host);
+    return FALSE;
+  }
+
+  url->path = g_strdup_printf ("%s%.*s", *path == '/' ? "" : "/",
+      (gint) strcspn (path, "#"), path);
+
+  return TRUE;
+}
+
+/* Removes "." and ".." segments from the first @len bytes of @path, as in
+ * RFC 3986 section 5.2.4 */
+static gchar *
+http_remove_dot_segments (const gchar * path, gsize len)
+{
+  GString *out = g_string_sized_new (len);
+  const gchar *in = path, *end = path + len;
+  const gchar *last;
+  gsize left, n;
+
+  while (in < end) {
+    left = end - in;
+
+    if (left >= 3 && strncmp (in, "../", 3) == 0) {
+      in += 3;
+    } else if (left >= 2 && strncmp (in, "./", 2) == 0) {
+      in += 2;
+    } else if (left >= 3 && strncmp (in, "/./", 3) == 0) {
+      in += 2;
+    } else if (left == 2 && strncmp (in, "/.", 2) == 0) {
+      g_string_append_c (out, '/');
+      break;
+    } else if ((left >= 4 && strncmp (in, "/../", 4) == 0)
+        || (left == 3 && strncmp (in, "/..", 3) == 0)) {
+      last = strrchr (out->str, '/');
+      g_string_truncate (out, last ? last - out->str : 0);
+      if (left == 3) {
+        g_string_append_c (out, '/');
+        break;
+      }
+      in += 3;
+    } else if ((left == 1 && *in == '.') || (left == 2
+            && strncmp (in, "..", 2) == 0)) {
+      break;
+    } else {
+      /* Moves the first segment, with its leading slash */
+      n = (*in == '/') ? 1 : 0;
+      while (in + n < end && in[n] != '/')
+        n++;
+      g_string_append_len (out, in, n);
+      in += n;
+    }
+  }
+
+  return g_string_free (out, FALSE);
+}
+
+/* Resolves a Location header against the URL it was received for, as in
+ * RFC 3986 section 5.2.2. Returns NULL if it is not an HTTP(S) URL */
+static gchar *
+http_url_resolve (const HttpUrl * base, const gchar * location)
+{
+  const gchar *ref = location, *query;
+  gchar *scheme, *authority, *path, *merged, *ret;
+  gsize len, n, base_path_len, base_dir_len, query_len;
+  gboolean has_scheme, has_authority, ipv6;
+
+  /* Fragments are not part of requests */
+  len = strcspn (ref, "#");
+
+  n = strspn (ref, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+      "0123456789+-.");
+  has_scheme = n > 0 && n < len && ref[n] == ':' && g_ascii_isalpha (ref[0]);
+  if (has_scheme) {
+    scheme = g_ascii_strdown (ref, n);
+    if (strcmp (scheme, "http") != 0 && strcmp (scheme, "https") != 0) {
+      g_free (scheme);
+      return NULL;
+    }
+    ref += n + 1;
+    len -= n + 1;
+  } else {
+    scheme = g_strdup (base->tls ? "https" : "http");
+  }
+
+  has_authority = len >= 2 && ref[0] == '/' && ref[1] == '/';
+  if (has_authority) {
+    n = MIN (strcspn (ref + 2, "/?"), len - 2);
+    authority = g_strndup (ref + 2, n);
+    ref += 2 + n;
+    len -= 2 + n;
+  } else if (has_scheme) {
+    /* HTTP URLs always have an authority */
+    g_free (scheme);
+    return NULL;
+  } else {
+    ipv6 = strchr (base->host, ':') != NULL;
+    authority = g_strdup_printf ("%s%s%s:%u", ipv6 ? "[" : "", base->host,
+        ipv6 ? "]" : "", base->port);
+  }
+
+  n = MIN (strcspn (ref, "?"), len);
+  query = ref + n;
+  query_len = len - n;
+
+  base_path_len = strcspn (base->path, "?");
+  if (has_authority) {
+    path = http_remove_dot_segments (ref, n);
+  } else if (n == 0) {
+    path = g_strndup (base->path, base_path_len);
+    if (query_len == 0) {
+      query = base->path + base_path_len;
+      query_len = strlen (query);
+    }
+  } else if (ref[0] == '/') {
+    path = http_remove_dot_segments (ref, n);
+  } else {
+    /* Relative to the directory of the base path */
+    for (base_dir_len = base_path_len; base_dir_len > 0
+        && base->path[base_dir_len - 1] != '/'; base_dir_len--);
+    merged = g_strdup_printf ("%.*s%.*s", (gint) base_dir_len, base->path,
+        (gint) n, ref);
+    path = http_remove_dot_segments (merged, strlen (merged));
+    g_free (merged);
+  }
+
+  ret = g_strdup_printf ("%s://%s%s%s%.*s", scheme, authority,
+      *path == '/' ? "" : "/", path, (gint) query_len, query);
+  g_free (scheme);
+  g_free (authority);
+  g_free (path);
+
+  return ret;
+}
+
+typedef struct
+{
+  GIOStream *stream;
+  gint64 idle_since;
+} IdleConnection;
+
+static GMutex pool_lock;
+/* "host:port:tls" -> GQueue of IdleConnection, most recently used first */
+static GHashTable *pool;
+
+static gchar *
+http_pool_key (const HttpUrl * url)
+{
+  return g_strdup_printf ("%s:%u:%d", url->host, url->port, url->tls);
+}
+
+static GIOStream *
+http_pool_take (const HttpUrl * url)
+{
+  gint64 now = g_get_monotonic_time ();
+  GIOStream *stream = NULL;
+  IdleConnection *idle;
+  GQueue *queue;
+  gchar *key;
+
+  key = http_pool_key (url);
+
+  g_mutex_lock (&pool_lock);
+  queue = pool ? g_hash_table_lookup (pool, key) : NULL;
+  while (!stream && queue && (idle = g_queue_pop_head (queue))) {
+    if (now - idle->idle_since < HTTP_IDLE_TIMEOUT)
+      stream = idle->stream;
+    else
+      g_object_unref (idle->stream);
+    g_free (idle);
+  }
+  g_mutex_unlock (&pool_lock);
+
+  g_free (key);
+
+  return stream;
+}
+
+static void
+http_pool_put (const HttpUrl * url, GIOStream * stream)
+{
+  IdleConnection *idle;
+  GQueue *queue;
+  gchar *key;
+
+  idle = g_new0 (IdleConnection, 1);
+  idle->stream = stream;
+  idle->idle_since = g_get_monotonic_time ();
+
+  key = http_pool_key (url);
+
+  g_mutex_lock (&pool_lock);
+  if (!pool)
+    pool = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  queue = g_hash_table_lookup (pool, key);
+  if (!queue) {
+    queue = g_queue_new ();
+    g_hash_table_insert (pool, key, queue);
+    key = NULL;
+  }
+  g_queue_push_head (queue, idle);
+  if (g_queue_get_length (queue) > HTTP_MAX_IDLE_CONNECTIONS) {
+    idle = g_queue_pop_tail (queue);
+    g_object_unref (idle->stream);
+    g_free (idle);
+  }
+  g_mutex_unlock (&pool_lock);
+
+  g_free (key);
+}
+
+typedef struct
+{
+  HttpUrl url;
+  GIOStream *stream;
+  GDataInputStream *input;
+
+  guint status;
+  /* Lowercase names */
+  GHashTable *headers;
+  gboolean keep_alive;
+
+  gboolean chunked;
+  /* Left of the body, or of the current chunk. -1 if the body ends when
+   * the connection is closed */
+  gint64 remaining;
+  gboolean done;
+} HttpResponse;
+
+static void
+http_response_free (HttpResponse * resp)
+{
+  /* Only connections that are at the start of the next response can be
+   * used again */
+  if (resp->done && resp->keep_alive)
+    http_pool_put (&resp->url, resp->stream);
+  else
+    g_object_unref (resp->stream);
+
+  g_object_unref (resp->input);
+  g_hash_table_unref (resp->headers);
+  http_url_clear (&resp->url);
+  g_free (resp);
+}
+
+static const gchar *
+http_response_get_header (HttpResponse * resp, const gchar * name)
+{
+  return g_hash_table_lookup (resp->headers, name);
+}
+
+static gchar *
+http_read_line (GDataInputStream * input, GCancellable * cancellable,
+    GError ** error)
+{
+  GError *local_error = NULL;
+  gchar *line;
+
+  line = g_data_input_stream_read_line (input, NULL, cancellable,
+      &local_error);
+  if (!line) {
+    if (!local_error)
+      local_error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CLOSED,
+          "Connection closed by the server");
+    g_propagate_error (error, local_error);
+  }
+
+  return line;
+}
+
+/* Sends @request on @stream and reads the response head. Takes ownership
+ * of @stream, and on success of the strings of @url */
+static HttpResponse *
+http_exchange (GIOStream * stream, HttpUrl * url, const gchar * request,
+    gboolean head, GCancellable * cancellable, GError ** error)
+{
+  HttpResponse *resp;
+  GDataInputStream *input;
+  const gchar *value;
+  gchar *line, *colon, *name, *old;
+  gboolean http11;
+
+  if (!g_output_stream_write_all (g_io_stream_get_output_stream (stream),
+          request, strlen (request), NULL, cancellable, error)) {
+    g_object_unref (stream);
+    return NULL;
+  }
+
+  input = g_data_input_stream_new (g_io_stream_get_input_stream (stream));
+  g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (input),
+      FALSE);
+  g_data_input_stream_set_newline_type (input,
+      G_DATA_STREAM_NEWLINE_TYPE_ANY);
+
+  line = http_read_line (input, cancellable, error);
+  if (!line)
+    goto failed;
+  if (!g_str_has_prefix (line, "HTTP/1.") || strlen (line) < 12) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "Invalid HTTP response '%s'", line);
+    g_free (line);
+    goto failed;
+  }
+
+  resp = g_new0 (HttpResponse, 1);
+  resp->stream = stream;
+  resp->input = input;
+  resp->headers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      g_free);
+  http11 = line[7] != '0';
+  resp->status = g_ascii_strtoull (line + 9, NULL, 10);
+  g_free (line);
+
+  while ((line = http_read_line (input, cancellable, error)) && *line) {
+    colon = strchr (line, ':');
+    if (colon) {
+      name = g_ascii_strdown (line, colon - line);
+      value = g_strstrip (colon + 1);
+      /* Repeated headers are the same as one with a list of values */
+      old = g_hash_table_lookup (resp->headers, name);
+      if (old)
+        g_hash_table_insert (resp->headers, name,
+            g_strconcat (old, ", ", value, NULL));
+      else
+        g_hash_table_insert (resp->headers, name, g_strdup (value));
+    }
+    g_free (line);
+  }
+  if (!line) {
+    resp->keep_alive = FALSE;
+    http_response_free (resp);
+    return NULL;
+  }
+  g_free (line);
+
+  value = http_response_get_header (resp, "connection");
+  if (http11)
+    resp->keep_alive = !value || g_ascii_strcasecmp (value, "close") != 0;
+  else
+    resp->keep_alive = value && g_ascii_strcasecmp (value, "keep-alive") == 0;
+
+  if (head || resp->status / 100 == 1 || resp->status == 204
+      || resp->status == 304) {
+    resp->remaining = 0;
+  } else if ((value = http_response_get_header (resp, "transfer-encoding"))
+      && g_ascii_strcasecmp (value, "identity") != 0) {
+    resp->chunked = TRUE;
+  } else if ((value = http_response_get_header (resp, "content-length"))) {
+    resp->remaining = g_ascii_strtoll (value, NULL, 10);
+  } else {
+    resp->remaining = -1;
+    resp->keep_alive = FALSE;
+  }
+  resp->done = !resp->chunked && resp->remaining == 0;
+
+  resp->url = *url;
+
+  return resp;
+
+failed:
+  g_object_unref (input);
+  g_object_unref (stream);
+  return NULL;
+}
+
+static GIOStream *
+http_connect (const HttpUrl * url, GCancellable * cancellable,
+    GError ** error)
+{
+  GSocketClient *client;
+  GSocketConnection *connection;
+
+  client = g_socket_client_new ();
+  g_socket_client_set_tls (client, url->tls);
+  g_socket_client_set_timeout (client, HTTP_TIMEOUT);
+  connection = g_socket_client_connect_to_host (client, url->host, url->port,
+      cancellable, error);
+  g_object_unref (client);
+
+  return (GIOStream *) connection;
+}
+
+static HttpResponse *
+http_send (const gchar * str, gboolean head, guint64 offset,
+    const gchar * validator, GCancellable * cancellable, GError ** error)
+{
+  HttpResponse *resp = NULL;
+  GIOStream *stream;
+  GError *local_error = NULL;
+  GString *request;
+  HttpUrl url;
+
+  if (!http_url_parse (str, &url)) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+        "Unsupported URL '%s'", str);
+    return NULL;
+  }
+
+  request = g_string_new (NULL);
+  g_string_append_printf (request, "%s %s HTTP/1.1\r\n",
+      head ? "HEAD" : "GET", url.path);
+  if (strchr (url.host, ':'))
+    g_string_append_printf (request, "Host: [%s]", url.host);
+  else
+    g_string_append_printf (request, "Host: %s", url.host);
+  if (url.port != (url.tls ? 443 : 80))
+    g_string_append_printf (request, ":%u", url.port);
+  g_string_append (request, "\r\nUser-Agent: GstPlayer\r\nAccept: */*\r\n");
+  if (offset > 0)
+    g_string_append_printf (request, "Range: bytes=%" G_GUINT64_FORMAT
+        "-\r\n", offset);
+  /* The server sends the whole resource if it changed meanwhile */
+  if (offset > 0 && validator && !g_str_has_prefix (validator, "W/"))
+    g_string_append_printf (request, "If-Range: %s\r\n", validator);
+  g_string_append (request, "\r\n");
+
+  /* The server may have closed an idle connection meanwhile, which only
+   * shows when using it. These are retried once on a new connection */
+  stream = http_pool_take (&url);
+  if (stream) {
+    GST_LOG ("Reusing connection to %s:%u", url.host, url.port);
+    resp = http_exchange (stream, &url, request->str, head, cancellable,
+        &local_error);
+    if (!resp && g_cancellable_is_cancelled (cancellable)) {
+      g_propagate_error (error, local_error);
+      goto done;
+    }
+    g_clear_error (&local_error);
+  }
+
+  if (!resp) {
+    GST_DEBUG ("Connecting to %s:%u", url.host, url.port);
+    stream = http_connect (&url, cancellable, error);
+    if (stream)
+      resp = http_exchange (stream, &url, request->str, head, cancellable,
+          error);
+  }
+
+done:
+  g_string_free (request, TRUE);
+  if (!resp)
+    http_url_clear (&url);
+
+  return resp;
+}
+
+/* Sends a request for @url from @offset on, following redirects */
+static HttpResponse *
+http_request (const gchar * url, gboolean head, guint64 offset,
+    const gchar * validator, GCancellable * cancellable, GError ** error)
+{
+  HttpResponse *resp;
+  const gchar *location;
+  gchar *next = NULL;
+  gint redirects;
+
+  for (redirects = 0;; redirects++) {
+    resp = http_send (next ? next : url, head, offset, validator,
+        cancellable, error);
+    g_free (next);
+    next = NULL;
+
+    if (!resp || (resp->status != 301 && resp->status != 302
+            && resp->status != 303 && resp->status != 307
+            && resp->status != 308))
+      return resp;
+
+    location = http_response_get_header (resp, "location");
+    if (!location || redirects == HTTP_MAX_REDIRECTS) {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+          "Invalid redirect from '%s'", url);
+      http_response_free (resp);
+      return NULL;
+    }
+
+    next = http_url_resolve (&resp->url, location);
+    if (!next) {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+          "Unsupported redirect from '%s' to '%s'", url, location);
+      http_response_free (resp);
+      return NULL;
+    }
+
+    /* Never continue without TLS what was requested with it */
+    if (resp->url.tls && g_ascii_strncasecmp (next, "https://", 8) != 0) {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_PERMISSION_DENIED,
+          "Refusing redirect from '%s' to insecure '%s'", url, next);
+      g_free (next);
+      http_response_free (resp);
+      return NULL;
+    }
+
+    GST_DEBUG ("Redirected to %s", next);
+    http_response_free (resp);
+  }
+}
+
+/* Reads from the body, returns 0 at its end */
+static gssize
+http_response_read (HttpResponse * resp, guint8 * data, gsize size,
+    GCancellable * cancellable, GError ** error)
+{
+  gchar *line;
+  gssize n;
+
+  if (resp->done)
+    return 0;
+
+  if (resp->chunked && resp->remaining == 0) {
+    line = http_read_line (resp->input, cancellable, error);
+    if (!line)
+      return -1;
+    resp->remaining = g_ascii_strtoll (line, NULL, 16);
+    g_free (line);
+
+    if (resp->remaining <= 0) {
+      /* Skip the trailer */
+      while ((line = http_read_line (resp->input, cancellable, error))
+          && *line)
+        g_free (line);
+      if (!line)
+        return -1;
+      g_free (line);
+      resp->remaining = 0;
+      resp->done = TRUE;
+      return 0;
+    }
+  }
+
+  if (resp->remaining > 0)
+    size = MIN (size, resp->remaining);
+
+  n = g_input_stream_read (G_INPUT_STREAM (resp->input), data, size,
+      cancellable, error);
+  if (n < 0)
+    return -1;
+
+  if (n == 0) {
+    if (resp->remaining < 0) {
+      resp->done = TRUE;
+      return 0;
+    }
+    g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_CLOSED,
+        "Connection closed before the end of the response");
+    return -1;
+  }
+
+  if (resp->remaining > 0) {
+    resp->remaining -= n;
+    if (resp->remaining == 0 && resp->chunked) {
+      /* Line break after the chunk */
+      line = http_read_line (resp->input, cancellable, error);
+      if (!line)
+        return -1;
+      g_free (line);
+    } else if (resp->remaining == 0) {
+      resp->done = TRUE;
+    }
+  }
+
+  return n;
+}
+
+/* Cache entries */
+
+typedef struct
+{
+  guint64 start;
+  guint64 end;
+} CacheRange;
+
+typedef struct
+{
+  /* Protected by entries_lock */
+  gint refcount;
+
+  gchar *key;
+  gchar *url;
+  gchar *validator;
+  guint64 size;
+  gchar *data_filename;
+  gchar *meta_filename;
+
+  GMutex lock;
+  /* Protected by lock */
+  GFileIOStream *file;
+  GArray *ranges;               /* sorted, not overlapping or touching */
+  guint64 unsaved;
+} CacheEntry;
+
+static GMutex entries_lock;
+/* Key -> CacheEntry in use, not owning */
+static GHashTable *entries;
+
+static void
+cache_ranges_add (GArray * ranges, guint64 start, guint64 end)
+{
+  CacheRange range = { start, end };
+  CacheRange *r;
+  guint i = 0;
+
+  while (i < ranges->len && g_array_index (ranges, CacheRange, i).end < start)
+    i++;
+
+  /* Merged with all ranges it overlaps or touches */
+  while (i < ranges->len
+      && (r = &g_array_index (ranges, CacheRange, i))->start <= end) {
+    range.start = MIN (range.start, r->start);
+    range.end = MAX (range.end, r->end);
+    g_array_remove_index (ranges, i);
+  }
+
+  g_array_insert_val (ranges, i, range);
+}
+
+/* Returns the number of bytes cached from @offset on */
+static guint64
+cache_ranges_available (GArray * ranges, guint64 offset)
+{
+  guint lo = 0, hi = ranges->len, mid;
+  CacheRange *r;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    r = &g_array_index (ranges, CacheRange, mid);
+    if (offset < r->start)
+      hi = mid;
+    else if (offset >= r->end)
+      lo = mid + 1;
+    else
+      return r->end - offset;
+  }
+
+  return 0;
+}
+
+static guint64
+cache_ranges_total (GArray * ranges)
+{
+  guint64 total = 0;
+  guint i;
+
+  for (i = 0; i < ranges->len; i++) {
+    CacheRange *r = &g_array_index (ranges, CacheRange, i);
+
+    total += r->end - r->start;
+  }
+
+  return total;
+}
+
+static GVariant *
+cache_meta_load (const gchar * filename)
+{
+  GMappedFile *file;
+  GVariant *variant;
+  GBytes *bytes;
+
+  file = g_mapped_file_new (filename, FALSE, NULL);
+  if (!file)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (file);
+  g_mapped_file_unref (file);
+
+  variant = g_variant_new_from_bytes (G_VARIANT_TYPE (HTTP_CACHE_META_FORMAT),
+      bytes, FALSE);
+  g_variant_ref_sink (variant);
+  g_bytes_unref (bytes);
+
+  /* Cache files are not trusted */
+  if (!g_variant_is_normal_form (variant)) {
+    g_variant_unref (variant);
+    return NULL;
+  }
+
+  return variant;
+}
+
+/* Must be called with the entry lock */
+static void
+cache_entry_save_locked (CacheEntry * entry)
+{
+  GVariantBuilder ranges;
+  GVariant *variant;
+  guint i;
+
+  if (!entry->validator)
+    return;
+
+  g_variant_builder_init (&ranges, G_VARIANT_TYPE ("a(tt)"));
+  for (i = 0; i < entry->ranges->len; i++) {
+    CacheRange *r = &g_array_index (entry->ranges, CacheRange, i);
+
+    g_variant_builder_add (&ranges, "(tt)", r->start, r->end);
+  }
+
+  variant = g_variant_new ("(sstxa(tt))", entry->url, entry->validator,
+      entry->size, g_get_real_time (), &ranges);
+  g_variant_ref_sink (variant);
+  g_file_set_contents (entry->meta_filename, g_variant_get_data (variant),
+      g_variant_get_size (variant), NULL);
+  g_variant_unref (variant);
+
+  entry->unsaved = 0;
+}
+
+/* Opens the entry for @url with @validator and @size. Without a validator
+ * the entry is not reused by later playbacks */
+static CacheEntry *
+cache_entry_open (const gchar * url, const gchar * validator, guint64 size)
+{
+  static gint unvalidated;
+  CacheEntry *entry;
+  GVariant *meta, *ranges;
+  GFile *file;
+  gchar *str;
+  guint64 start, end;
+  GVariantIter iter;
+  gchar *key;
+
+  if (validator)
+    str = g_strdup_printf ("%s\n%s\n%" G_GUINT64_FORMAT, url, validator,
+        size);
+  else
+    str = g_strdup_printf ("%s\n%" G_GINT64_FORMAT "\n%d", url,
+        g_get_real_time (), g_atomic_int_add (&unvalidated, 1));
+  key = g_compute_checksum_for_string (G_CHECKSUM_SHA1, str, -1);
+  g_free (str);
+
+  g_mutex_lock (&entries_lock);
+  if (!entries)
+    entries = g_hash_table_new (g_str_hash, g_str_equal);
+
+  entry = g_hash_table_lookup (entries, key);
+  if (entry) {
+    entry->refcount++;
+    g_mutex_unlock (&entries_lock);
+    g_free (key);
+    return entry;
+  }
+
+  entry = g_new0 (CacheEntry, 1);
+  entry->refcount = 1;
+  entry->key = key;
+  entry->url = g_strdup (url);
+  entry->validator = g_strdup (validator);
+  entry->size = size;
+  g_mutex_init (&entry->lock);
+  entry->ranges = g_array_new (FALSE, FALSE, sizeof (CacheRange));
+
+  entry->data_filename = gst_player_cache_get_filename (HTTP_CACHE_DIR,
+      entry->key);
+  if (entry->data_filename)
+    entry->meta_filename = g_strconcat (entry->data_filename,
+        HTTP_CACHE_META_SUFFIX, NULL);
+
+  if (entry->data_filename) {
+    file = g_file_new_for_path (entry->data_filename);
+    entry->file = g_file_open_readwrite (file, NULL, NULL);
+    meta = entry->file ? cache_meta_load (entry->meta_filename) : NULL;
+    if (meta) {
+      ranges = g_variant_get_child_value (meta, 4);
+      g_variant_iter_init (&iter, ranges);
+      while (g_variant_iter_next (&iter, "(tt)", &start, &end))
+        if (start < end && end <= size)
+          cache_ranges_add (entry->ranges, start, end);
+      g_variant_unref (ranges);
+      g_variant_unref (meta);
+    }
+
+    if (!entry->file)
+      entry->file = g_file_replace_readwrite (file, NULL, FALSE,
+          G_FILE_CREATE_PRIVATE, NULL, NULL);
+    g_object_unref (file);
+  }
+
+  if (!entry->file)
+    GST_WARNING ("Failed to open cache file for %s", url);
+
+  g_hash_table_insert (entries, entry->key, entry);
+  g_mutex_unlock (&entries_lock);
+
+  GST_DEBUG ("Opened cache entry %s for %s, %" G_GUINT64_FORMAT " of %"
+      G_GUINT64_FORMAT " bytes cached", entry->key, url,
+      cache_ranges_total (entry->ranges), size);
+
+  return entry;
+}
+
+static void
+cache_entry_unref (CacheEntry * entry)
+{
+  gboolean last;
+
+  g_mutex_lock (&entries_lock);
+  last = --entry->refcount == 0;
+  if (last)
+    g_hash_table_remove (entries, entry->key);
+  g_mutex_unlock (&entries_lock);
+
+  if (!last)
+    return;
+
+  if (entry->file) {
+    cache_entry_save_locked (entry);
+    g_io_stream_close (G_IO_STREAM (entry->file), NULL, NULL);
+    g_object_unref (entry->file);
+    if (!entry->validator)
+      g_unlink (entry->data_filename);
+  }
+
+  g_array_unref (entry->ranges);
+  g_mutex_clear (&entry->lock);
+  g_free (entry->key);
+  g_free (entry->url);
+  g_free (entry->validator);
+  g_free (entry->data_filename);
+  g_free (entry->meta_filename);
+  g_free (entry);
+}
+
+/* Reads what is cached from @offset on, up to @size bytes. Returns 0 if
+ * nothing is */
+static gsize
+cache_entry_read (CacheEntry * entry, guint64 offset, guint8 * data,
+    gsize size)
+{
+  gsize n = 0;
+
+  g_mutex_lock (&entry->lock);
+  if (entry->file) {
+    size = MIN (size, cache_ranges_available (entry->ranges, offset));
+    if (size > 0 && (!g_seekable_seek (G_SEEKABLE (entry->file), offset,
+                G_SEEK_SET, NULL, NULL)
+            || !g_input_stream_read_all (g_io_stream_get_input_stream
+                (G_IO_STREAM (entry->file)), data, size, &n, NULL, NULL)))
+      n = 0;
+  }
+  g_mutex_unlock (&entry->lock);
+
+  return n;
+}
+
+static void
+cache_entry_write (CacheEntry * entry, guint64 offset, const guint8 * data,
+    gsize size)
+{
+  g_mutex_lock (&entry->lock);
+  if (entry->file) {
+    if (g_seekable_seek (G_SEEKABLE (entry->file), offset, G_SEEK_SET, NULL,
+            NULL)
+        && g_output_stream_write_all (g_io_stream_get_output_stream
+            (G_IO_STREAM (entry->file)), data, size, NULL, NULL, NULL)) {
+      cache_ranges_add (entry->ranges, offset, offset + size);
+      entry->unsaved += size;
+      if (entry->unsaved >= HTTP_CACHE_SAVE_INTERVAL)
+        cache_entry_save_locked (entry);
+    }
+  }
+  g_mutex_unlock (&entry->lock);
+}
+
+static void
+cache_entry_save (CacheEntry * entry)
+{
+  g_mutex_lock (&entry->lock);
+  if (entry->file && entry->unsaved > 0)
+    cache_entry_save_locked (entry);
+  g_mutex_unlock (&entry->lock);
+}
+
+static guint64
+cache_entry_get_cached (CacheEntry * entry)
+{
+  guint64 cached;
+
+  g_mutex_lock (&entry->lock);
+  cached = cache_ranges_total (entry->ranges);
+  g_mutex_unlock (&entry->lock);
+
+  return cached;
+}
+
+typedef struct
+{
+  gchar *key;
+  gint64 access;
+  guint64 cached;
+} CacheUsage;
+
+static gint
+cache_usage_compare_access (gconstpointer a, gconstpointer b)
+{
+  const CacheUsage *ua = a, *ub = b;
+
+  return ua->access < ub->access ? -1 : ua->access > ub->access;
+}
+
+/* Space the file at @filename takes on disk, data files have holes where
+ * nothing was downloaded yet. Sets @mtime to its modification time */
+static guint64
+cache_file_disk_size (const gchar * filename, gint64 * mtime)
+{
+  GStatBuf st;
+
+  if (g_stat (filename, &st) < 0)
+    return 0;
+
+  if (mtime)
+    *mtime = (gint64) st.st_mtime * G_USEC_PER_SEC;
+#ifdef G_OS_UNIX
+  return (guint64) st.st_blocks * 512;
+#else
+  return st.st_size;
+#endif
+}
+
+/* Removes the least recently used entries not in use until the cache is
+ * at most @max_size bytes. Every file counts, also data files whose
+ * metadata was never written, e.g. after a crash, and leftovers of
+ * interrupted metadata writes */
+static void
+cache_trim (guint64 max_size)
+{
+  GHashTable *keys;
+  GArray *usage;
+  GVariant *meta;
+  const gchar *name;
+  gchar *dir, *filename, *key;
+  guint64 total = 0;
+  gint64 mtime = 0;
+  gpointer index;
+  GDir *d;
+  guint i;
+
+  dir = gst_player_cache_get_filename (HTTP_CACHE_DIR, "");
+  d = dir ? g_dir_open (dir, 0, NULL) : NULL;
+  if (!d) {
+    g_free (dir);
+    return;
+  }
+
+  usage = g_array_new (FALSE, TRUE, sizeof (CacheUsage));
+  /* key -> index into usage + 1 */
+  keys = g_hash_table_new (g_str_hash, g_str_equal);
+  while ((name = g_dir_read_name (d))) {
+    CacheUsage *u;
+    gboolean is_meta;
+    guint64 size;
+
+    is_meta = g_str_has_suffix (name, HTTP_CACHE_META_SUFFIX);
+    key = is_meta ? g_strndup (name, strlen (name) -
+        strlen (HTTP_CACHE_META_SUFFIX)) : g_strdup (name);
+
+    index = g_hash_table_lookup (keys, key);
+    if (!index) {
+      CacheUsage new_usage = { key, 0, 0 };
+
+      g_array_append_val (usage, new_usage);
+      index = GUINT_TO_POINTER (usage->len);
+      g_hash_table_insert (keys, key, index);
+    } else {
+      g_free (key);
+    }
+    u = &g_array_index (usage, CacheUsage, GPOINTER_TO_UINT (index) - 1);
+
+    filename = g_build_filename (dir, name, NULL);
+    size = cache_file_disk_size (filename, &mtime);
+    if (is_meta) {
+      meta = cache_meta_load (filename);
+      if (meta) {
+        g_variant_get_child (meta, 3, "x", &u->access);
+        g_variant_unref (meta);
+      }
+    } else if (u->access == 0) {
+      /* Until the metadata tells when it was used last */
+      u->access = mtime;
+    }
+    g_free (filename);
+
+    u->cached += size;
+    total += size;
+  }
+  g_dir_close (d);
+  g_hash_table_unref (keys);
+
+  g_array_sort (usage, cache_usage_compare_access);
+
+  for (i = 0; i < usage->len; i++) {
+    CacheUsage *u = &g_array_index (usage, CacheUsage, i);
+    gboolean in_use;
+
+    if (total > max_size) {
+      g_mutex_lock (&entries_lock);
+      in_use = entries && g_hash_table_contains (entries, u->key);
+      g_mutex_unlock (&entries_lock);
+
+      if (!in_use) {
+        GST_DEBUG ("Removing cache entry %s", u->key);
+        filename = g_build_filename (dir, u->key, NULL);
+        g_unlink (filename);
+        g_free (filename);
+        filename = g_strconcat (dir, G_DIR_SEPARATOR_S, u->key,
+            HTTP_CACHE_META_SUFFIX, NULL);
+        g_unlink (filename);
+        g_free (filename);
+        total -= u->cached;
+      }
+    }
+    g_free (u->key);
+  }
+
+  g_array_unref (usage);
+  g_free (dir);
+}
+
+/* Source element */
+
+#define GST_TYPE_PLAYER_HTTP_CACHE_SRC (gst_player_http_cache_src_get_type ())
+#define GST_PLAYER_HTTP_CACHE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_HTTP_CACHE_SRC, GstPlayerHttpCacheSrc))
+#define GST_IS_PLAYER_HTTP_CACHE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_HTTP_CACHE_SRC))
+
+typedef struct
+{
+  GstBaseSrc parent;
+
+  /* Protected by object lock */
+  gchar *url;
+  guint64 max_size;
+  guint64 bytes_read;
+  guint64 network_bytes;
+
+  GCancellable *cancellable;
+
+  /* Only accessed from the streaming thread while started */
+  CacheEntry *entry;
+  gchar *validator;
+  guint64 size;                 /* G_MAXUINT64 if unknown */
+  gboolean seekable;
+  HttpResponse *download;
+  guint64 download_offset;
+} GstPlayerHttpCacheSrc;
+
+typedef GstBaseSrcClass GstPlayerHttpCacheSrcClass;
+
+static GstStaticPadTemplate http_cache_src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_player_http_cache_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data);
+static void gst_player_http_cache_src_trim (GstPlayerHttpCacheSrc * src);
+
+G_GNUC_INTERNAL GType gst_player_http_cache_src_get_type (void);
+G_DEFINE_TYPE_WITH_CODE (GstPlayerHttpCacheSrc, gst_player_http_cache_src,
+    GST_TYPE_BASE_SRC, G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_player_http_cache_src_uri_handler_init));
+
+static void
+gst_player_http_cache_src_finalize (GObject * object)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (object);
+
+  g_free (src->url);
+  g_object_unref (src->cancellable);
+
+  G_OBJECT_CLASS (gst_player_http_cache_src_parent_class)->finalize (object);
+}
+
+static gboolean
+status_is_success (HttpResponse * resp)
+{
+  return resp->status / 100 == 2;
+}
+
+/* Returns the offset the body of a successful response starts at, and
+ * the size of the resource if it is known */
+static guint64
+response_get_range (HttpResponse * resp, guint64 * size)
+{
+  const gchar *value;
+  guint64 start = 0;
+  gchar *end;
+
+  *size = G_MAXUINT64;
+
+  if (resp->status == 206) {
+    value = http_response_get_header (resp, "content-range");
+    if (value && g_str_has_prefix (value, "bytes ")) {
+      start = g_ascii_strtoull (value + 6, &end, 10);
+      end = strchr (end, '/');
+      if (end && end[1] != '*')
+        *size = g_ascii_strtoull (end + 1, NULL, 10);
+    }
+  } else if (!resp->chunked
+      && (value = http_response_get_header (resp, "content-length"))) {
+    *size = g_ascii_strtoull (value, NULL, 10);
+  }
+
+  return start;
+}
+
+static gchar *
+response_get_validator (HttpResponse * resp)
+{
+  const gchar *value;
+
+  value = http_response_get_header (resp, "etag");
+  if (value)
+    return g_strdup (value);
+
+  value = http_response_get_header (resp, "last-modified");
+  if (value)
+    return g_strdup (value);
+
+  return NULL;
+}
+
+static gboolean
+gst_player_http_cache_src_start (GstBaseSrc * bsrc)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (bsrc);
+  HttpResponse *resp;
+  const gchar *value;
+  GError *error = NULL;
+  guint64 start;
+  gchar *url;
+
+  GST_OBJECT_LOCK (src);
+  url = g_strdup (src->url);
+  src->bytes_read = 0;
+  src->network_bytes = 0;
+  GST_OBJECT_UNLOCK (src);
+
+  if (!url) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL), ("No URI set"));
+    return FALSE;
+  }
+
+  /* Some servers refuse HEAD requests, for these the download starts */
+  resp = http_request (url, TRUE, 0, NULL, src->cancellable, &error);
+  if (resp && !status_is_success (resp)) {
+    http_response_free (resp);
+    resp = http_request (url, FALSE, 0, NULL, src->cancellable, &error);
+  }
+
+  if (!resp || !status_is_success (resp)) {
+    if (resp)
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+          ("Request for %s failed with status %u", url, resp->status));
+    else
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+          ("Request for %s failed: %s", url, error->message));
+    if (resp)
+      http_response_free (resp);
+    g_clear_error (&error);
+    g_free (url);
+    return FALSE;
+  }
+
+  start = response_get_range (resp, &src->size);
+  src->validator = response_get_validator (resp);
+  value = http_response_get_header (resp, "accept-ranges");
+  src->seekable = resp->status == 206 || (value && strstr (value, "bytes"));
+
+  /* Without a known size the data can only be streamed through */
+  if (src->size != G_MAXUINT64) {
+    src->entry = cache_entry_open (url, src->validator, src->size);
+    if (cache_entry_get_cached (src->entry) == src->size)
+      src->seekable = TRUE;
+  }
+
+  if (resp->done) {
+    http_response_free (resp);
+  } else {
+    src->download = resp;
+    src->download_offset = start;
+  }
+
+  GST_DEBUG_OBJECT (src, "Started %s, size %" G_GUINT64_FORMAT
+      ", validator %s, seekable %d", url, src->size,
+      GST_STR_NULL (src->validator), src->seekable);
+  g_free (url);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_http_cache_src_stop (GstBaseSrc * bsrc)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (bsrc);
+
+  if (src->download) {
+    http_response_free (src->download);
+    src->download = NULL;
+  }
+
+  if (src->entry) {
+    cache_entry_unref (src->entry);
+    src->entry = NULL;
+  }
+
+  g_free (src->validator);
+  src->validator = NULL;
+
+  GST_OBJECT_LOCK (src);
+  GST_DEBUG_OBJECT (src, "Read %" G_GUINT64_FORMAT " bytes, %"
+      G_GUINT64_FORMAT " from the network", src->bytes_read,
+      src->network_bytes);
+  GST_OBJECT_UNLOCK (src);
+
+  gst_player_http_cache_src_trim (src);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_http_cache_src_get_size (GstBaseSrc * bsrc, guint64 * size)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (bsrc);
+
+  if (src->size == G_MAXUINT64)
+    return FALSE;
+
+  *size = src->size;
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_http_cache_src_is_seekable (GstBaseSrc * bsrc)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (bsrc);
+
+  return src->seekable;
+}
+
+static gboolean
+gst_player_http_cache_src_unlock (GstBaseSrc * bsrc)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (bsrc);
+
+  g_cancellable_cancel (src->cancellable);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_http_cache_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (bsrc);
+
+  g_cancellable_reset (src->cancellable);
+
+  return TRUE;
+}
+
+static void
+gst_player_http_cache_src_trim (GstPlayerHttpCacheSrc * src)
+{
+  guint64 max_size;
+
+  if (src->entry)
+    cache_entry_save (src->entry);
+
+  GST_OBJECT_LOCK (src);
+  max_size = src->max_size;
+  GST_OBJECT_UNLOCK (src);
+
+  cache_trim (max_size);
+}
+
+/* Reads from the network at @offset and stores what was read in the cache.
+ * Returns 0 at the end of the resource */
+static gssize
+gst_player_http_cache_src_fetch (GstPlayerHttpCacheSrc * src, guint64 offset,
+    guint8 * data, gsize size, GError ** error)
+{
+  guint8 skip[16 * 1024];
+  guint64 start, total;
+  gssize n;
+
+  /* Reading through a small gap is cheaper than a new request. Without
+   * range support all of it is read through */
+  if (src->download && (offset < src->download_offset || (src->seekable
+              && offset - src->download_offset > HTTP_MAX_SKIP))) {
+    http_response_free (src->download);
+    src->download = NULL;
+  }
+
+  if (!src->download) {
+    src->download = http_request (src->url, FALSE, offset, src->validator,
+        src->cancellable, error);
+    if (!src->download)
+      return -1;
+
+    if (!status_is_success (src->download)) {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+          "Request failed with status %u", src->download->status);
+      return -1;
+    }
+
+    /* A full response instead of the range means it changed meanwhile if
+     * there is a validator, the server ignored the range otherwise */
+    start = response_get_range (src->download, &total);
+    if (start != offset && src->validator && src->seekable) {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+          "The resource changed while playing");
+      return -1;
+    }
+    src->download_offset = start;
+  }
+
+  while (src->download_offset < offset) {
+    n = http_response_read (src->download, skip,
+        MIN (sizeof (skip), offset - src->download_offset),
+        src->cancellable, error);
+    if (n <= 0)
+      return n;
+    if (src->entry)
+      cache_entry_write (src->entry, src->download_offset, skip, n);
+    src->download_offset += n;
+  }
+
+  n = http_response_read (src->download, data, size, src->cancellable,
+      error);
+  if (n > 0) {
+    if (src->entry)
+      cache_entry_write (src->entry, offset, data, n);
+    src->download_offset += n;
+
+    GST_OBJECT_LOCK (src);
+    src->network_bytes += n;
+    GST_OBJECT_UNLOCK (src);
+  }
+
+  /* Handed back to the connection pool as early as possible */
+  if (n >= 0 && src->download->done) {
+    http_response_free (src->download);
+    src->download = NULL;
+
+    /* Make room for the next entry as soon as this one is complete */
+    if (src->entry && src->size != G_MAXUINT64
+        && cache_entry_get_cached (src->entry) >= src->size)
+      gst_player_http_cache_src_trim (src);
+  }
+
+  return n;
+}
+
+static GstFlowReturn
+gst_player_http_cache_src_create (GstBaseSrc * bsrc, guint64 offset,
+    guint size, GstBuffer ** buf)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (bsrc);
+  GError *error = NULL;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gsize filled = 0;
+  gssize n;
+
+  if (src->size != G_MAXUINT64) {
+    if (offset >= src->size)
+      return GST_FLOW_EOS;
+    size = MIN (size, src->size - offset);
+  }
+
+  buffer = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+
+  while (filled < size) {
+    n = src->entry ? cache_entry_read (src->entry, offset + filled,
+        map.data + filled, size - filled) : 0;
+    if (n == 0)
+      n = gst_player_http_cache_src_fetch (src, offset + filled,
+          map.data + filled, size - filled, &error);
+    if (n <= 0)
+      break;
+    filled += n;
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+  if (error) {
+    gst_buffer_unref (buffer);
+    /* The connection is in an unknown state after errors */
+    if (src->download) {
+      http_response_free (src->download);
+      src->download = NULL;
+    }
+
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_error_free (error);
+      return GST_FLOW_FLUSHING;
+    }
+
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("Failed to read %s: %s", src->url, error->message));
+    g_error_free (error);
+    return GST_FLOW_ERROR;
+  }
+
+  if (filled == 0) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_EOS;
+  }
+
+  gst_buffer_resize (buffer, 0, filled);
+  GST_BUFFER_OFFSET (buffer) = offset;
+  GST_BUFFER_OFFSET_END (buffer) = offset + filled;
+  *buf = buffer;
+
+  GST_OBJECT_LOCK (src);
+  src->bytes_read += filled;
+  GST_OBJECT_UNLOCK (src);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_player_http_cache_src_init (GstPlayerHttpCacheSrc * src)
+{
+  src->cancellable = g_cancellable_new ();
+  src->size = G_MAXUINT64;
+}
+
+static void
+gst_player_http_cache_src_class_init (GstPlayerHttpCacheSrcClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseSrcClass *basesrc_class = (GstBaseSrcClass *) klass;
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_http_cache_debug,
+      "gst-player-http-cache", 0, "GstPlayer HTTP cache");
+
+  gobject_class->finalize = gst_player_http_cache_src_finalize;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&http_cache_src_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player HTTP cache source", "Source/Network",
+      "Reads media over HTTP through an on-disk cache", "GstPlayer");
+
+  basesrc_class->start = gst_player_http_cache_src_start;
+  basesrc_class->stop = gst_player_http_cache_src_stop;
+  basesrc_class->get_size = gst_player_http_cache_src_get_size;
+  basesrc_class->is_seekable = gst_player_http_cache_src_is_seekable;
+  basesrc_class->unlock = gst_player_http_cache_src_unlock;
+  basesrc_class->unlock_stop = gst_player_http_cache_src_unlock_stop;
+  basesrc_class->create = gst_player_http_cache_src_create;
+}
+
+static GstURIType
+gst_player_http_cache_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_player_http_cache_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = {
+    HTTP_CACHE_PROTOCOL_PREFIX "http", HTTP_CACHE_PROTOCOL_PREFIX "https",
+    NULL
+  };
+
+  return protocols;
+}
+
+static gchar *
+gst_player_http_cache_src_uri_get_uri (GstURIHandler * handler)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (handler);
+  gchar *uri;
+
+  GST_OBJECT_LOCK (src);
+  uri = src->url ? g_strconcat (HTTP_CACHE_PROTOCOL_PREFIX, src->url,
+      NULL) : NULL;
+  GST_OBJECT_UNLOCK (src);
+
+  return uri;
+}
+
+static gboolean
+gst_player_http_cache_src_uri_set_uri (GstURIHandler * handler,
+    const gchar * uri, GError ** error)
+{
+  GstPlayerHttpCacheSrc *src = GST_PLAYER_HTTP_CACHE_SRC (handler);
+  const gchar *url;
+  HttpUrl parsed;
+
+  if (GST_STATE (src) > GST_STATE_READY) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+        "Changing the URI while playing is not supported");
+    return FALSE;
+  }
+
+  if (!g_str_has_prefix (uri, HTTP_CACHE_PROTOCOL_PREFIX)) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_UNSUPPORTED_PROTOCOL,
+        "Unsupported URI '%s'", uri);
+    return FALSE;
+  }
+
+  url = uri + strlen (HTTP_CACHE_PROTOCOL_PREFIX);
+  if (!http_url_parse (url, &parsed)) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+        "Invalid URI '%s'", uri);
+    return FALSE;
+  }
+  http_url_clear (&parsed);
+
+  GST_OBJECT_LOCK (src);
+  g_free (src->url);
+  src->url = g_strdup (url);
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+static void
+gst_player_http_cache_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_player_http_cache_src_uri_get_type;
+  iface->get_protocols = gst_player_http_cache_src_uri_get_protocols;
+  iface->get_uri = gst_player_http_cache_src_uri_get_uri;
+  iface->set_uri = gst_player_http_cache_src_uri_set_uri;
+}
+
+static gpointer
+register_http_cache_src (gpointer data)
+{
+  /* Nothing else handles the protocols, the rank only has to be high
+   * enough for gst_element_make_from_uri() */
+  return GINT_TO_POINTER (gst_element_register (NULL, "playerhttpcachesrc",
+          GST_RANK_PRIMARY, GST_TYPE_PLAYER_HTTP_CACHE_SRC));
+}
+
+/* Returns the URI to use for @uri with the cache, or NULL if @uri is not
+ * an HTTP URI */
+gchar *
+gst_player_http_cache_make_uri (const gchar * uri)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  if (!gst_uri_has_protocol (uri, "http")
+      && !gst_uri_has_protocol (uri, "https"))
+    return NULL;
+
+  if (!GPOINTER_TO_INT (g_once (&once, register_http_cache_src, NULL)))
+    return NULL;
+
+  return g_strconcat (HTTP_CACHE_PROTOCOL_PREFIX, uri, NULL);
+}
+
+/* Sets the size the cache is trimmed to after @element played, returns
+ * FALSE if @element is not the cache source */
+gboolean
+gst_player_http_cache_src_set_max_size (GstElement * element,
+    guint64 max_size)
+{
+  GstPlayerHttpCacheSrc *src;
+
+  if (!GST_IS_PLAYER_HTTP_CACHE_SRC (element))
+    return FALSE;
+
+  src = GST_PLAYER_HTTP_CACHE_SRC (element);
+  GST_OBJECT_LOCK (src);
+  src->max_size = max_size;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+gboolean
+gst_player_http_cache_src_get_stats (GstElement * element,
+    guint64 * bytes_read, guint64 * network_bytes)
+{
+  GstPlayerHttpCacheSrc *src;
+
+  if (!GST_IS_PLAYER_HTTP_CACHE_SRC (element))
+    return FALSE;
+
+  src = GST_PLAYER_HTTP_CACHE_SRC (element);
+  GST_OBJECT_LOCK (src);
+  *bytes_read = src->bytes_read;
+  *network_bytes = src->network_bytes;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
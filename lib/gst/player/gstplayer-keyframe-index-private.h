@@ -0,0 +1,40 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_KEYFRAME_INDEX_PRIVATE_H__
+#define __GST_PLAYER_KEYFRAME_INDEX_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerKeyframeIndexer GstPlayerKeyframeIndexer;
+
+/* Called in the indexer's main context. Takes ownership of @keyframes */
+typedef void (*GstPlayerKeyframeIndexerDoneFunc) (GstPlayerKeyframeIndexer *
+    indexer, GArray * keyframes, gpointer user_data);
+
+G_GNUC_INTERNAL GArray*   gst_player_keyframe_index_load
+                          (const gchar *uri);
+
+G_GNUC_INTERNAL GstPlayerKeyframeIndexer*  gst_player_keyframe_indexer_new
+                          (const gchar *uri, GMainContext *context,
+                           GstPlayerKeyframeIndexerDoneFunc done,
+                           gpointer user_data);
+G_GNUC_INTERNAL void      gst_player_keyframe_indexer_free
+                          (GstPlayerKeyframeIndexer *indexer);
+
+#endif /* __GST_PLAYER_KEYFRAME_INDEX_PRIVATE_H__ */
@@ -0,0 +1,460 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Builds a list of keyframe timestamps of the first video stream by
+ * demuxing the whole file once in a separate pipeline. Decoders are never
+ * plugged, so this only costs the I/O and the demuxing, and its streaming
+ * threads are its own and run at idle priority to not take CPU time from
+ * playback. The result is cached per file. */
+
+#include "gstplayer-keyframe-index-private.h"
+#include "gstplayer-cache-private.h"
+
+#include <string.h>
+
+#ifdef G_OS_WIN32
+#include <windows.h>
+#elif defined (G_OS_UNIX)
+#include <pthread.h>
+#include <sched.h>
+/* Only declared with _GNU_SOURCE */
+#if defined (__linux__) && !defined (SCHED_IDLE)
+#define SCHED_IDLE 5
+#endif
+#endif
+
+#define KEYFRAME_CACHE_DIR "keyframes"
+#define KEYFRAME_CACHE_MAGIC "GSTPLKF1"
+#define KEYFRAME_CACHE_MAGIC_LEN 8
+
+/* Values of decodebin's GstAutoplugSelectResult */
+enum
+{
+  AUTOPLUG_SELECT_TRY,
+  AUTOPLUG_SELECT_EXPOSE,
+  AUTOPLUG_SELECT_SKIP
+};
+
+struct _GstPlayerKeyframeIndexer
+{
+  gchar *uri;
+  GMainContext *context;
+  GstPlayerKeyframeIndexerDoneFunc done;
+  gpointer user_data;
+
+  GstElement *pipeline;
+  GstTaskPool *task_pool;
+  GThread *thread;
+  gint cancelled;
+
+  /* Only accessed from the streaming thread of the indexed pad, and from
+   * the indexer thread after the pipeline was shut down */
+  GArray *keyframes;
+  gint have_video;
+
+  /* Only accessed from the main context and, before it's attached, from
+   * the indexer thread */
+  GSource *done_source;
+};
+
+static gint
+clock_time_compare (gconstpointer a, gconstpointer b)
+{
+  GstClockTime ta = *(const GstClockTime *) a;
+  GstClockTime tb = *(const GstClockTime *) b;
+
+  if (ta < tb)
+    return -1;
+  if (ta > tb)
+    return 1;
+  return 0;
+}
+
+/* Returns the cached keyframes of the file at @uri, or NULL if they were
+ * not indexed yet or the file changed since */
+GArray *
+gst_player_keyframe_index_load (const gchar * uri)
+{
+  gchar *key, *filename, *contents = NULL;
+  GArray *keyframes = NULL;
+  gsize length;
+
+  key = gst_player_cache_make_file_key (uri);
+  if (!key)
+    return NULL;
+  filename = gst_player_cache_get_filename (KEYFRAME_CACHE_DIR, key);
+  g_free (key);
+  if (!filename)
+    return NULL;
+
+  if (g_file_get_contents (filename, &contents, &length, NULL)
+      && length >= KEYFRAME_CACHE_MAGIC_LEN
+      && (length - KEYFRAME_CACHE_MAGIC_LEN) % sizeof (guint64) == 0
+      && memcmp (contents, KEYFRAME_CACHE_MAGIC,
+          KEYFRAME_CACHE_MAGIC_LEN) == 0) {
+    guint n = (length - KEYFRAME_CACHE_MAGIC_LEN) / sizeof (guint64);
+
+    keyframes = g_array_sized_new (FALSE, FALSE, sizeof (GstClockTime), n);
+    g_array_set_size (keyframes, n);
+    memcpy (keyframes->data, contents + KEYFRAME_CACHE_MAGIC_LEN,
+        n * sizeof (guint64));
+  }
+
+  g_free (contents);
+  g_free (filename);
+
+  return keyframes;
+}
+
+static void
+keyframe_index_save (const gchar * uri, GArray * keyframes)
+{
+  gchar *key, *filename, *contents;
+  gsize length;
+
+  key = gst_player_cache_make_file_key (uri);
+  if (!key)
+    return;
+  filename = gst_player_cache_get_filename (KEYFRAME_CACHE_DIR, key);
+  g_free (key);
+  if (!filename)
+    return;
+
+  length = KEYFRAME_CACHE_MAGIC_LEN + keyframes->len * sizeof (guint64);
+  contents = g_malloc (length);
+  memcpy (contents, KEYFRAME_CACHE_MAGIC, KEYFRAME_CACHE_MAGIC_LEN);
+  memcpy (contents + KEYFRAME_CACHE_MAGIC_LEN, keyframes->data,
+      keyframes->len * sizeof (guint64));
+
+  /* Written atomically, concurrent players never see partial files */
+  g_file_set_contents (filename, contents, length, NULL);
+
+  g_free (contents);
+  g_free (filename);
+}
+
+static gint
+autoplug_select_cb (GstElement * decodebin, GstPad * pad, GstCaps * caps,
+    GstElementFactory * factory, gpointer user_data)
+{
+  /* Stop at the parsed, still encoded streams */
+  if (gst_element_factory_list_is_type (factory,
+          GST_ELEMENT_FACTORY_TYPE_DECODER))
+    return AUTOPLUG_SELECT_EXPOSE;
+
+  return AUTOPLUG_SELECT_TRY;
+}
+
+static GstPadProbeReturn
+keyframe_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstPlayerKeyframeIndexer *indexer = user_data;
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  GstClockTime ts;
+
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    return GST_PAD_PROBE_OK;
+
+  ts = GST_BUFFER_PTS_IS_VALID (buffer) ? GST_BUFFER_PTS (buffer) :
+      GST_BUFFER_DTS (buffer);
+  if (GST_CLOCK_TIME_IS_VALID (ts))
+    g_array_append_val (indexer->keyframes, ts);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+pad_added_cb (GstElement * decodebin, GstPad * pad, gpointer user_data)
+{
+  GstPlayerKeyframeIndexer *indexer = user_data;
+  GstElement *sink;
+  GstPad *sinkpad;
+  GstCaps *caps;
+  const gchar *name;
+
+  /* Every stream must be consumed, but only the first video is indexed */
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!sink)
+    return;
+  g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add (GST_BIN (indexer->pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+
+  caps = gst_pad_get_current_caps (pad);
+  if (!caps)
+    caps = gst_pad_query_caps (pad, NULL);
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  if (g_str_has_prefix (name, "video/")
+      && g_atomic_int_compare_and_exchange (&indexer->have_video, FALSE,
+          TRUE))
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, keyframe_probe_cb,
+        indexer, NULL);
+  gst_caps_unref (caps);
+}
+
+/* Lowers the priority of the calling thread to idle */
+static gboolean
+set_thread_idle_priority (void)
+{
+#ifdef G_OS_WIN32
+  return SetThreadPriority (GetCurrentThread (), THREAD_PRIORITY_IDLE);
+#elif defined (SCHED_IDLE)
+  struct sched_param param = { 0 };
+
+  return pthread_setschedparam (pthread_self (), SCHED_IDLE, &param) == 0;
+#elif defined (G_OS_UNIX)
+  struct sched_param param;
+  gint policy;
+
+  /* At least the lowest priority of the current policy */
+  if (pthread_getschedparam (pthread_self (), &policy, &param) != 0)
+    return FALSE;
+  param.sched_priority = sched_get_priority_min (policy);
+  return pthread_setschedparam (pthread_self (), policy, &param) == 0;
+#else
+  return FALSE;
+#endif
+}
+
+/* Runs every task in a thread of its own at idle priority. The priority
+ * of a thread can not always be raised again, so these threads are never
+ * shared with other pipelines */
+typedef GstTaskPool IdleTaskPool;
+typedef GstTaskPoolClass IdleTaskPoolClass;
+
+G_DEFINE_TYPE (IdleTaskPool, idle_task_pool, GST_TYPE_TASK_POOL);
+
+typedef struct
+{
+  GstTaskPoolFunction func;
+  gpointer data;
+} IdleTask;
+
+static gpointer
+idle_task_thread (gpointer user_data)
+{
+  IdleTask *task = user_data;
+
+  if (!set_thread_idle_priority ())
+    GST_WARNING ("Failed to lower the priority of the keyframe indexer");
+
+  task->func (task->data);
+  g_free (task);
+
+  return NULL;
+}
+
+static void
+idle_task_pool_prepare (GstTaskPool * pool, GError ** error)
+{
+}
+
+static void
+idle_task_pool_cleanup (GstTaskPool * pool)
+{
+}
+
+static gpointer
+idle_task_pool_push (GstTaskPool * pool, GstTaskPoolFunction func,
+    gpointer data, GError ** error)
+{
+  IdleTask *task;
+  GThread *thread;
+
+  task = g_new0 (IdleTask, 1);
+  task->func = func;
+  task->data = data;
+
+  thread = g_thread_try_new ("GstPlayerKeyframeIndexer", idle_task_thread,
+      task, error);
+  if (!thread)
+    g_free (task);
+
+  return thread;
+}
+
+static void
+idle_task_pool_join (GstTaskPool * pool, gpointer id)
+{
+  g_thread_join (id);
+}
+
+static void
+idle_task_pool_class_init (IdleTaskPoolClass * klass)
+{
+  klass->prepare = idle_task_pool_prepare;
+  klass->cleanup = idle_task_pool_cleanup;
+  klass->push = idle_task_pool_push;
+  klass->join = idle_task_pool_join;
+}
+
+static void
+idle_task_pool_init (IdleTaskPool * pool)
+{
+}
+
+/* Called from the thread creating the streaming tasks */
+static GstBusSyncReply
+indexer_sync_handler (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerKeyframeIndexer *indexer = user_data;
+  GstStreamStatusType type;
+  const GValue *value;
+
+  if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_STREAM_STATUS)
+    return GST_BUS_PASS;
+
+  gst_message_parse_stream_status (msg, &type, NULL);
+  value = gst_message_get_stream_status_object (msg);
+  if (type == GST_STREAM_STATUS_TYPE_CREATE && value
+      && G_VALUE_TYPE (value) == GST_TYPE_TASK)
+    gst_task_set_pool (g_value_get_object (value), indexer->task_pool);
+
+  gst_message_unref (msg);
+
+  return GST_BUS_DROP;
+}
+
+static gboolean
+keyframe_indexer_done_cb (gpointer user_data)
+{
+  GstPlayerKeyframeIndexer *indexer = user_data;
+  GArray *keyframes = indexer->keyframes;
+
+  indexer->keyframes = NULL;
+  indexer->done (indexer, keyframes, indexer->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+keyframe_indexer_thread (gpointer user_data)
+{
+  GstPlayerKeyframeIndexer *indexer = user_data;
+  gboolean success = FALSE;
+  GstMessage *msg;
+  GstBus *bus;
+  guint i, j;
+
+  bus = gst_element_get_bus (indexer->pipeline);
+  if (gst_element_set_state (indexer->pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE) {
+    msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_APPLICATION);
+    success = GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS;
+    gst_message_unref (msg);
+  }
+  gst_element_set_state (indexer->pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+
+  if (!success || g_atomic_int_get (&indexer->cancelled))
+    return NULL;
+
+  /* Demuxers output in decoding order, sort and drop duplicates */
+  g_array_sort (indexer->keyframes, clock_time_compare);
+  for (i = 0, j = 0; i < indexer->keyframes->len; i++) {
+    GstClockTime ts = g_array_index (indexer->keyframes, GstClockTime, i);
+
+    if (j == 0 || ts != g_array_index (indexer->keyframes, GstClockTime,
+            j - 1))
+      g_array_index (indexer->keyframes, GstClockTime, j++) = ts;
+  }
+  g_array_set_size (indexer->keyframes, j);
+
+  keyframe_index_save (indexer->uri, indexer->keyframes);
+
+  indexer->done_source = g_idle_source_new ();
+  g_source_set_priority (indexer->done_source, G_PRIORITY_LOW);
+  g_source_set_callback (indexer->done_source, keyframe_indexer_done_cb,
+      indexer, NULL);
+  g_source_attach (indexer->done_source, indexer->context);
+
+  return NULL;
+}
+
+/* Starts indexing the file at @uri in a new thread. Once finished @done is
+ * called from @context, unless the indexer was freed before */
+GstPlayerKeyframeIndexer *
+gst_player_keyframe_indexer_new (const gchar * uri, GMainContext * context,
+    GstPlayerKeyframeIndexerDoneFunc done, gpointer user_data)
+{
+  GstPlayerKeyframeIndexer *indexer;
+  GstElement *decodebin;
+  GstBus *bus;
+
+  decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  if (!decodebin)
+    return NULL;
+
+  indexer = g_new0 (GstPlayerKeyframeIndexer, 1);
+  indexer->uri = g_strdup (uri);
+  indexer->context = g_main_context_ref (context);
+  indexer->done = done;
+  indexer->user_data = user_data;
+  indexer->keyframes = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+
+  indexer->task_pool = g_object_new (idle_task_pool_get_type (), NULL);
+  indexer->pipeline = gst_pipeline_new ("keyframe-indexer");
+  bus = gst_element_get_bus (indexer->pipeline);
+  gst_bus_set_sync_handler (bus, indexer_sync_handler, indexer, NULL);
+  gst_object_unref (bus);
+  g_object_set (decodebin, "uri", uri, NULL);
+  g_signal_connect (decodebin, "autoplug-select",
+      G_CALLBACK (autoplug_select_cb), NULL);
+  g_signal_connect (decodebin, "pad-added", G_CALLBACK (pad_added_cb),
+      indexer);
+  gst_bin_add (GST_BIN (indexer->pipeline), decodebin);
+
+  indexer->thread = g_thread_new ("GstPlayerKeyframeIndexer",
+      keyframe_indexer_thread, indexer);
+
+  return indexer;
+}
+
+/* Must be called from the indexer's main context. Cancels indexing if it is
+ * still running */
+void
+gst_player_keyframe_indexer_free (GstPlayerKeyframeIndexer * indexer)
+{
+  GstBus *bus;
+
+  g_atomic_int_set (&indexer->cancelled, TRUE);
+  bus = gst_element_get_bus (indexer->pipeline);
+  gst_bus_post (bus, gst_message_new_application (NULL,
+          gst_structure_new_empty ("cancel")));
+  gst_object_unref (bus);
+
+  g_thread_join (indexer->thread);
+
+  if (indexer->done_source) {
+    g_source_destroy (indexer->done_source);
+    g_source_unref (indexer->done_source);
+  }
+
+  gst_object_unref (indexer->pipeline);
+  gst_object_unref (indexer->task_pool);
+  if (indexer->keyframes)
+    g_array_free (indexer->keyframes, TRUE);
+  g_main_context_unref (indexer->context);
+  g_free (indexer->uri);
+  g_free (indexer);
+}
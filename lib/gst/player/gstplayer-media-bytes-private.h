@@ -0,0 +1,44 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_MEDIA_BYTES_PRIVATE_H__
+#define __GST_PLAYER_MEDIA_BYTES_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerMediaBytes GstPlayerMediaBytes;
+
+G_GNUC_INTERNAL GstPlayerMediaBytes * gst_player_media_bytes_new
+                                      (GBytes *bytes);
+G_GNUC_INTERNAL GstPlayerMediaBytes * gst_player_media_bytes_new_stream
+                                      (void);
+G_GNUC_INTERNAL GstPlayerMediaBytes * gst_player_media_bytes_ref
+                                      (GstPlayerMediaBytes *media);
+G_GNUC_INTERNAL void                  gst_player_media_bytes_unref
+                                      (GstPlayerMediaBytes *media);
+G_GNUC_INTERNAL const gchar *         gst_player_media_bytes_get_uri
+                                      (GstPlayerMediaBytes *media);
+G_GNUC_INTERNAL gboolean              gst_player_media_bytes_push
+                                      (GstPlayerMediaBytes *media,
+                                       GBytes *bytes);
+G_GNUC_INTERNAL void                  gst_player_media_bytes_end
+                                      (GstPlayerMediaBytes *media);
+G_GNUC_INTERNAL gboolean              gst_player_media_bytes_is_uri
+                                      (const gchar *uri);
+
+#endif /* __GST_PLAYER_MEDIA_BYTES_PRIVATE_H__ */
@@ -0,0 +1,501 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Media held in memory by the application, played through a source
+ * element that wraps the memory in buffers without copying it.
+ *
+ * playbin only picks sources by URI protocol, so every block of memory is
+ * registered under a URI of a protocol only this element handles. The
+ * element looks the memory up when the URI is set on it. */
+
+#include "gstplayer-media-bytes-private.h"
+
+#include <gst/base/gstbasesrc.h>
+
+#define MEDIA_BYTES_PROTOCOL "gstplayer-bytes"
+
+struct _GstPlayerMediaBytes
+{
+  /* Protected by registry_lock */
+  gint refcount;
+
+  gchar *uri;
+  /* NULL for streams */
+  GBytes *bytes;
+
+  /* Streams only, protected by lock */
+  GMutex lock;
+  GCond cond;
+  GQueue chunks;
+  gboolean ended;
+  gboolean reading;
+};
+
+static GMutex registry_lock;
+/* URI -> GstPlayerMediaBytes, not owning */
+static GHashTable *registry;
+
+static gpointer register_bytes_src (gpointer data);
+
+static GstPlayerMediaBytes *
+media_bytes_new (GBytes * bytes)
+{
+  static GOnce once = G_ONCE_INIT;
+  static gint next_id;
+  GstPlayerMediaBytes *media;
+
+  g_once (&once, register_bytes_src, NULL);
+
+  media = g_new0 (GstPlayerMediaBytes, 1);
+  media->refcount = 1;
+  media->uri = g_strdup_printf (MEDIA_BYTES_PROTOCOL "://%d",
+      g_atomic_int_add (&next_id, 1));
+  media->bytes = bytes;
+  g_mutex_init (&media->lock);
+  g_cond_init (&media->cond);
+  g_queue_init (&media->chunks);
+
+  g_mutex_lock (&registry_lock);
+  if (!registry)
+    registry = g_hash_table_new (g_str_hash, g_str_equal);
+  g_hash_table_insert (registry, media->uri, media);
+  g_mutex_unlock (&registry_lock);
+
+  return media;
+}
+
+GstPlayerMediaBytes *
+gst_player_media_bytes_new (GBytes * bytes)
+{
+  return media_bytes_new (g_bytes_ref (bytes));
+}
+
+GstPlayerMediaBytes *
+gst_player_media_bytes_new_stream (void)
+{
+  return media_bytes_new (NULL);
+}
+
+GstPlayerMediaBytes *
+gst_player_media_bytes_ref (GstPlayerMediaBytes * media)
+{
+  g_mutex_lock (&registry_lock);
+  media->refcount++;
+  g_mutex_unlock (&registry_lock);
+
+  return media;
+}
+
+void
+gst_player_media_bytes_unref (GstPlayerMediaBytes * media)
+{
+  gboolean last;
+
+  /* Unregistered under the same lock lookups take their reference with */
+  g_mutex_lock (&registry_lock);
+  last = --media->refcount == 0;
+  if (last)
+    g_hash_table_remove (registry, media->uri);
+  g_mutex_unlock (&registry_lock);
+
+  if (!last)
+    return;
+
+  if (media->bytes)
+    g_bytes_unref (media->bytes);
+  g_queue_foreach (&media->chunks, (GFunc) g_bytes_unref, NULL);
+  g_queue_clear (&media->chunks);
+  g_mutex_clear (&media->lock);
+  g_cond_clear (&media->cond);
+  g_free (media->uri);
+  g_free (media);
+}
+
+static GstPlayerMediaBytes *
+media_bytes_lookup (const gchar * uri)
+{
+  GstPlayerMediaBytes *media = NULL;
+
+  g_mutex_lock (&registry_lock);
+  if (registry)
+    media = g_hash_table_lookup (registry, uri);
+  if (media)
+    media->refcount++;
+  g_mutex_unlock (&registry_lock);
+
+  return media;
+}
+
+const gchar *
+gst_player_media_bytes_get_uri (GstPlayerMediaBytes * media)
+{
+  return media->uri;
+}
+
+/* Appends @bytes to a stream, returns FALSE if @media is not a stream or
+ * the stream was ended already */
+gboolean
+gst_player_media_bytes_push (GstPlayerMediaBytes * media, GBytes * bytes)
+{
+  if (media->bytes)
+    return FALSE;
+
+  g_mutex_lock (&media->lock);
+  if (media->ended) {
+    g_mutex_unlock (&media->lock);
+    return FALSE;
+  }
+  if (g_bytes_get_size (bytes) > 0) {
+    g_queue_push_tail (&media->chunks, g_bytes_ref (bytes));
+    g_cond_broadcast (&media->cond);
+  }
+  g_mutex_unlock (&media->lock);
+
+  return TRUE;
+}
+
+void
+gst_player_media_bytes_end (GstPlayerMediaBytes * media)
+{
+  if (media->bytes)
+    return;
+
+  g_mutex_lock (&media->lock);
+  media->ended = TRUE;
+  g_cond_broadcast (&media->cond);
+  g_mutex_unlock (&media->lock);
+}
+
+gboolean
+gst_player_media_bytes_is_uri (const gchar * uri)
+{
+  return uri && gst_uri_has_protocol (uri, MEDIA_BYTES_PROTOCOL);
+}
+
+#define GST_TYPE_PLAYER_BYTES_SRC (gst_player_bytes_src_get_type ())
+#define GST_PLAYER_BYTES_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_BYTES_SRC, GstPlayerBytesSrc))
+
+typedef struct
+{
+  GstBaseSrc parent;
+
+  /* Protected by object lock */
+  GstPlayerMediaBytes *media;
+
+  /* Only accessed from the streaming thread while started */
+  GstPlayerMediaBytes *active;
+  guint64 offset;
+  /* Protected by the lock of the active media */
+  gboolean flushing;
+} GstPlayerBytesSrc;
+
+typedef GstBaseSrcClass GstPlayerBytesSrcClass;
+
+static GstStaticPadTemplate bytes_src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_player_bytes_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_GNUC_INTERNAL GType gst_player_bytes_src_get_type (void);
+G_DEFINE_TYPE_WITH_CODE (GstPlayerBytesSrc, gst_player_bytes_src,
+    GST_TYPE_BASE_SRC, G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_player_bytes_src_uri_handler_init));
+
+static void
+gst_player_bytes_src_finalize (GObject * object)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (object);
+
+  if (src->media)
+    gst_player_media_bytes_unref (src->media);
+
+  G_OBJECT_CLASS (gst_player_bytes_src_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_player_bytes_src_start (GstBaseSrc * bsrc)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (bsrc);
+  GstPlayerMediaBytes *media;
+
+  GST_OBJECT_LOCK (src);
+  media = src->media ? gst_player_media_bytes_ref (src->media) : NULL;
+  GST_OBJECT_UNLOCK (src);
+
+  if (!media) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL),
+        ("The media is not in memory anymore"));
+    return FALSE;
+  }
+
+  /* Data of a stream is gone once it was read */
+  if (!media->bytes) {
+    g_mutex_lock (&media->lock);
+    if (media->reading) {
+      g_mutex_unlock (&media->lock);
+      GST_ELEMENT_ERROR (src, RESOURCE, BUSY, (NULL),
+          ("The stream is already being read"));
+      gst_player_media_bytes_unref (media);
+      return FALSE;
+    }
+    media->reading = TRUE;
+    src->flushing = FALSE;
+    g_mutex_unlock (&media->lock);
+  }
+
+  src->active = media;
+  src->offset = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_bytes_src_stop (GstBaseSrc * bsrc)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (bsrc);
+  GstPlayerMediaBytes *media = src->active;
+
+  if (!media)
+    return TRUE;
+
+  if (!media->bytes) {
+    g_mutex_lock (&media->lock);
+    media->reading = FALSE;
+    g_mutex_unlock (&media->lock);
+  }
+
+  gst_player_media_bytes_unref (media);
+  src->active = NULL;
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_bytes_src_get_size (GstBaseSrc * bsrc, guint64 * size)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (bsrc);
+
+  if (!src->active || !src->active->bytes)
+    return FALSE;
+
+  *size = g_bytes_get_size (src->active->bytes);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_bytes_src_is_seekable (GstBaseSrc * bsrc)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (bsrc);
+
+  return src->active && src->active->bytes;
+}
+
+static gboolean
+gst_player_bytes_src_unlock (GstBaseSrc * bsrc)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (bsrc);
+  GstPlayerMediaBytes *media = src->active;
+
+  if (media && !media->bytes) {
+    g_mutex_lock (&media->lock);
+    src->flushing = TRUE;
+    g_cond_broadcast (&media->cond);
+    g_mutex_unlock (&media->lock);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_bytes_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (bsrc);
+  GstPlayerMediaBytes *media = src->active;
+
+  if (media && !media->bytes) {
+    g_mutex_lock (&media->lock);
+    src->flushing = FALSE;
+    g_mutex_unlock (&media->lock);
+  }
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_player_bytes_src_create (GstBaseSrc * bsrc, guint64 offset, guint size,
+    GstBuffer ** buf)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (bsrc);
+  GstPlayerMediaBytes *media = src->active;
+  GstBuffer *buffer;
+  GBytes *chunk;
+  gsize total;
+
+  if (media->bytes) {
+    total = g_bytes_get_size (media->bytes);
+    if (offset >= total)
+      return GST_FLOW_EOS;
+    size = MIN (size, total - offset);
+
+    buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        (gpointer) g_bytes_get_data (media->bytes, NULL), total, offset,
+        size, g_bytes_ref (media->bytes), (GDestroyNotify) g_bytes_unref);
+    GST_BUFFER_OFFSET (buffer) = offset;
+    GST_BUFFER_OFFSET_END (buffer) = offset + size;
+    *buf = buffer;
+
+    return GST_FLOW_OK;
+  }
+
+  /* Streams hand out the chunks as the application pushed them */
+  g_mutex_lock (&media->lock);
+  while (g_queue_is_empty (&media->chunks) && !media->ended
+      && !src->flushing)
+    g_cond_wait (&media->cond, &media->lock);
+  if (src->flushing) {
+    g_mutex_unlock (&media->lock);
+    return GST_FLOW_FLUSHING;
+  }
+  chunk = g_queue_pop_head (&media->chunks);
+  g_mutex_unlock (&media->lock);
+
+  if (!chunk)
+    return GST_FLOW_EOS;
+
+  total = g_bytes_get_size (chunk);
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      (gpointer) g_bytes_get_data (chunk, NULL), total, 0, total, chunk,
+      (GDestroyNotify) g_bytes_unref);
+  GST_BUFFER_OFFSET (buffer) = src->offset;
+  GST_BUFFER_OFFSET_END (buffer) = src->offset + total;
+  src->offset += total;
+  *buf = buffer;
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_player_bytes_src_init (GstPlayerBytesSrc * src)
+{
+}
+
+static void
+gst_player_bytes_src_class_init (GstPlayerBytesSrcClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseSrcClass *basesrc_class = (GstBaseSrcClass *) klass;
+
+  gobject_class->finalize = gst_player_bytes_src_finalize;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&bytes_src_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player memory source", "Source",
+      "Outputs media held in memory by the application", "GstPlayer");
+
+  basesrc_class->start = gst_player_bytes_src_start;
+  basesrc_class->stop = gst_player_bytes_src_stop;
+  basesrc_class->get_size = gst_player_bytes_src_get_size;
+  basesrc_class->is_seekable = gst_player_bytes_src_is_seekable;
+  basesrc_class->unlock = gst_player_bytes_src_unlock;
+  basesrc_class->unlock_stop = gst_player_bytes_src_unlock_stop;
+  basesrc_class->create = gst_player_bytes_src_create;
+}
+
+static GstURIType
+gst_player_bytes_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_player_bytes_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { MEDIA_BYTES_PROTOCOL, NULL };
+
+  return protocols;
+}
+
+static gchar *
+gst_player_bytes_src_uri_get_uri (GstURIHandler * handler)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (handler);
+  gchar *uri;
+
+  GST_OBJECT_LOCK (src);
+  uri = src->media ? g_strdup (src->media->uri) : NULL;
+  GST_OBJECT_UNLOCK (src);
+
+  return uri;
+}
+
+static gboolean
+gst_player_bytes_src_uri_set_uri (GstURIHandler * handler, const gchar * uri,
+    GError ** error)
+{
+  GstPlayerBytesSrc *src = GST_PLAYER_BYTES_SRC (handler);
+  GstPlayerMediaBytes *media, *old;
+
+  if (GST_STATE (src) > GST_STATE_READY) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+        "Changing the URI while playing is not supported");
+    return FALSE;
+  }
+
+  media = media_bytes_lookup (uri);
+  if (!media) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+        "No media in memory for URI '%s'", uri);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (src);
+  old = src->media;
+  src->media = media;
+  GST_OBJECT_UNLOCK (src);
+
+  if (old)
+    gst_player_media_bytes_unref (old);
+
+  return TRUE;
+}
+
+static void
+gst_player_bytes_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_player_bytes_src_uri_get_type;
+  iface->get_protocols = gst_player_bytes_src_uri_get_protocols;
+  iface->get_uri = gst_player_bytes_src_uri_get_uri;
+  iface->set_uri = gst_player_bytes_src_uri_set_uri;
+}
+
+static gpointer
+register_bytes_src (gpointer data)
+{
+  /* Nothing else handles the protocol, the rank only has to be high enough
+   * for gst_element_make_from_uri() */
+  return GINT_TO_POINTER (gst_element_register (NULL, "playerbytessrc",
+          GST_RANK_PRIMARY, GST_TYPE_PLAYER_BYTES_SRC));
+}
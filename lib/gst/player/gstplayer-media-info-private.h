@@ -89,6 +89,13 @@ struct _GstPlayerVideoInfoClass
   GstPlayerStreamInfoClass parent_class;
 };
 
+typedef struct
+{
+  GstClockTime start;
+  GstClockTime stop;
+  gchar *title;
+} GstPlayerChapter;
+
 struct _GstPlayerMediaInfo
 {
   GObject parent;
@@ -97,6 +104,7 @@ struct _GstPlayerMediaInfo
   gchar *title;
   gchar *container;
   gboolean seekable;
+  gboolean playable;
   GstTagList *tags;
   GstSample *image_sample;
 
@@ -105,7 +113,15 @@ struct _GstPlayerMediaInfo
   GList *video_stream_list;
   GList *subtitle_stream_list;
 
+  /* GstPlayerChapter, sorted by start time */
+  GArray *chapters;
+
+  /* Sorted GstClockTime, NULL if the media wasn't indexed */
+  GArray *keyframes;
+
   GstClockTime  duration;
+  /* Of the variant of adaptive streams, 0 if unknown */
+  guint variant_bitrate;
 };
 
 struct _GstPlayerMediaInfoClass
@@ -122,4 +138,14 @@ G_GNUC_INTERNAL GstPlayerStreamInfo*  gst_player_stream_info_new
 G_GNUC_INTERNAL GstPlayerStreamInfo*  gst_player_stream_info_copy
                                       (GstPlayerStreamInfo *ref);
 
+/* Cover art is never decoded to more than this, whatever the request */
+#define GST_PLAYER_COVER_ART_MAX_SIZE 2048
+
+G_GNUC_INTERNAL GstSample*            gst_player_cover_art_cache_lookup
+                                      (GstSample *image, gint max_width,
+                                       gint max_height);
+G_GNUC_INTERNAL void                  gst_player_cover_art_cache_store
+                                      (GstSample *image, gint max_width,
+                                       gint max_height, GstSample *cover_art);
+
 #endif /* __GST_PLAYER_MEDIA_INFO_PRIVATE_H__ */
@@ -398,11 +398,21 @@ gst_player_subtitle_info_get_language (const GstPlayerSubtitleInfo * info)
 /* Global media information */
 G_DEFINE_TYPE (GstPlayerMediaInfo, gst_player_media_info, G_TYPE_OBJECT);
 
+static void
+gst_player_chapter_clear (GstPlayerChapter * chapter)
+{
+  g_free (chapter->title);
+}
+
 static void
 gst_player_media_info_init (GstPlayerMediaInfo * info)
 {
   info->duration = -1;
   info->seekable = FALSE;
+  info->playable = TRUE;
+  info->chapters = g_array_new (FALSE, FALSE, sizeof (GstPlayerChapter));
+  g_array_set_clear_func (info->chapters,
+      (GDestroyNotify) gst_player_chapter_clear);
 }
 
 static void
@@ -436,6 +446,11 @@ gst_player_media_info_finalize (GObject * object)
   if (info->stream_list)
     g_list_free_full (info->stream_list, g_object_unref);
 
+  g_array_free (info->chapters, TRUE);
+
+  if (info->keyframes)
+    g_array_unref (info->keyframes);
+
   G_OBJECT_CLASS (gst_player_media_info_parent_class)->finalize (object);
 }
 
@@ -544,6 +559,7 @@ GstPlayerMediaInfo *
 gst_player_media_info_copy (GstPlayerMediaInfo * ref)
 {
   GList *l;
+  guint i;
   GstPlayerMediaInfo *info;
 
   if (!ref)
@@ -552,6 +568,8 @@ gst_player_media_info_copy (GstPlayerMediaInfo * ref)
   info = gst_player_media_info_new (ref->uri);
   info->duration = ref->duration;
   info->seekable = ref->seekable;
+  info->playable = ref->playable;
+  info->variant_bitrate = ref->variant_bitrate;
   if (ref->tags)
     info->tags = gst_tag_list_ref (ref->tags);
   if (ref->title)
@@ -561,6 +579,18 @@ gst_player_media_info_copy (GstPlayerMediaInfo * ref)
   if (ref->image_sample)
     info->image_sample = gst_sample_ref (ref->image_sample);
 
+  for (i = 0; i < ref->chapters->len; i++) {
+    GstPlayerChapter chapter;
+
+    chapter = g_array_index (ref->chapters, GstPlayerChapter, i);
+    chapter.title = g_strdup (chapter.title);
+    g_array_append_val (info->chapters, chapter);
+  }
+
+  /* Never modified once set, can be shared */
+  if (ref->keyframes)
+    info->keyframes = g_array_ref (ref->keyframes);
+
   for (l = ref->stream_list; l != NULL; l = l->next) {
     GstPlayerStreamInfo *s;
 
@@ -637,6 +667,21 @@ gst_player_media_info_is_seekable (const GstPlayerMediaInfo * info)
   return info->seekable;
 }
 
+/**
+ * gst_player_media_info_is_playable:
+ * @info: a #GstPlayerMediaInfo
+ *
+ * Returns: %FALSE if plugins needed to play the media are missing. Only
+ *   media info from gst_player_discover_async() can be not playable.
+ */
+gboolean
+gst_player_media_info_is_playable (const GstPlayerMediaInfo * info)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_MEDIA_INFO (info), FALSE);
+
+  return info->playable;
+}
+
 /**
  * gst_player_media_info_get_stream_list:
  * @info: a #GstPlayerMediaInfo
@@ -711,6 +756,21 @@ gst_player_media_info_get_duration (const GstPlayerMediaInfo * info)
   return info->duration;
 }
 
+/**
+ * gst_player_media_info_get_variant_bitrate:
+ * @info: a #GstPlayerMediaInfo
+ *
+ * Returns: the bitrate in bits per second of the variant of an adaptive
+ * stream that is currently played, or 0 if unknown.
+ */
+guint
+gst_player_media_info_get_variant_bitrate (const GstPlayerMediaInfo * info)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_MEDIA_INFO (info), 0);
+
+  return info->variant_bitrate;
+}
+
 /**
  * gst_player_media_info_get_tags:
  * @info: a #GstPlayerMediaInfo
@@ -769,3 +829,257 @@ gst_player_media_info_get_image_sample (const GstPlayerMediaInfo * info)
 
   return info->image_sample;
 }
+
+/* The decoded cover art is attached to the embedded image sample, which is
+ * shared by all copies of a media info. Only the last requested size is
+ * kept, never the full size decoded image. */
+typedef struct
+{
+  gint max_width, max_height;
+  GstSample *sample;
+} CoverArt;
+
+static GMutex cover_art_lock;
+
+static GQuark
+cover_art_quark (void)
+{
+  static GQuark quark;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("GstPlayerCoverArt");
+
+  return quark;
+}
+
+static void
+cover_art_free (CoverArt * art)
+{
+  gst_sample_unref (art->sample);
+  g_free (art);
+}
+
+GstSample *
+gst_player_cover_art_cache_lookup (GstSample * image, gint max_width,
+    gint max_height)
+{
+  CoverArt *art;
+  GstSample *sample = NULL;
+
+  g_mutex_lock (&cover_art_lock);
+  art = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (image),
+      cover_art_quark ());
+  if (art && art->max_width == max_width && art->max_height == max_height)
+    sample = gst_sample_ref (art->sample);
+  g_mutex_unlock (&cover_art_lock);
+
+  return sample;
+}
+
+void
+gst_player_cover_art_cache_store (GstSample * image, gint max_width,
+    gint max_height, GstSample * cover_art)
+{
+  CoverArt *art;
+
+  art = g_new (CoverArt, 1);
+  art->max_width = max_width;
+  art->max_height = max_height;
+  art->sample = gst_sample_ref (cover_art);
+
+  g_mutex_lock (&cover_art_lock);
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (image), cover_art_quark (),
+      art, (GDestroyNotify) cover_art_free);
+  g_mutex_unlock (&cover_art_lock);
+}
+
+/**
+ * gst_player_media_info_get_cover_art:
+ * @info: a #GstPlayerMediaInfo
+ * @max_width: maximum width
+ * @max_height: maximum height
+ *
+ * Function to get the cover art decoded to RGB and scaled to fit into
+ * @max_width x @max_height, if it was already decoded with
+ * gst_player_request_cover_art() for this size.
+ *
+ * Returns: (transfer full): GstSample or NULL.
+ */
+GstSample *
+gst_player_media_info_get_cover_art (const GstPlayerMediaInfo * info,
+    gint max_width, gint max_height)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_MEDIA_INFO (info), NULL);
+
+  if (!info->image_sample)
+    return NULL;
+
+  return gst_player_cover_art_cache_lookup (info->image_sample,
+      MIN (max_width, GST_PLAYER_COVER_ART_MAX_SIZE),
+      MIN (max_height, GST_PLAYER_COVER_ART_MAX_SIZE));
+}
+
+/**
+ * gst_player_media_info_get_n_chapters:
+ * @info: a #GstPlayerMediaInfo
+ *
+ * Returns: number of chapters of the media.
+ */
+guint
+gst_player_media_info_get_n_chapters (const GstPlayerMediaInfo * info)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_MEDIA_INFO (info), 0);
+
+  return info->chapters->len;
+}
+
+/**
+ * gst_player_media_info_get_chapter:
+ * @info: a #GstPlayerMediaInfo
+ * @index: chapter index, chapters are sorted by start time
+ * @start: (out) (allow-none): start time of the chapter
+ * @stop: (out) (allow-none): stop time of the chapter
+ * @title: (out) (allow-none) (transfer none): title of the chapter, or %NULL
+ *   if it has none
+ *
+ * Returns: %TRUE if @index is a valid chapter index.
+ */
+gboolean
+gst_player_media_info_get_chapter (const GstPlayerMediaInfo * info,
+    guint index, GstClockTime * start, GstClockTime * stop,
+    const gchar ** title)
+{
+  const GstPlayerChapter *chapter;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MEDIA_INFO (info), FALSE);
+
+  if (index >= info->chapters->len)
+    return FALSE;
+
+  chapter = &g_array_index (info->chapters, GstPlayerChapter, index);
+  if (start)
+    *start = chapter->start;
+  if (stop)
+    *stop = chapter->stop;
+  if (title)
+    *title = chapter->title;
+
+  return TRUE;
+}
+
+/**
+ * gst_player_media_info_get_chapter_at_position:
+ * @info: a #GstPlayerMediaInfo
+ * @position: position in nanoseconds
+ *
+ * Looks up the chapter containing @position with a binary search, so this
+ * is cheap enough to call on every position update.
+ *
+ * Returns: index of the chapter, or -1 if @position is not inside a chapter.
+ */
+gint
+gst_player_media_info_get_chapter_at_position (const GstPlayerMediaInfo *
+    info, GstClockTime position)
+{
+  const GstPlayerChapter *chapter;
+  guint lo, hi;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MEDIA_INFO (info), -1);
+
+  if (!GST_CLOCK_TIME_IS_VALID (position))
+    return -1;
+
+  /* Number of chapters starting at or before position */
+  lo = 0;
+  hi = info->chapters->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (info->chapters, GstPlayerChapter, mid).start <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == 0)
+    return -1;
+
+  chapter = &g_array_index (info->chapters, GstPlayerChapter, lo - 1);
+  if (GST_CLOCK_TIME_IS_VALID (chapter->stop) && position >= chapter->stop)
+    return -1;
+
+  return lo - 1;
+}
+
+/**
+ * gst_player_media_info_get_keyframes:
+ * @info: a #GstPlayerMediaInfo
+ * @n_keyframes: (out): number of keyframes
+ *
+ * Returns the positions of all keyframes of the media, if keyframe
+ * indexing is enabled with gst_player_set_keyframe_index_enabled() and
+ * the media was indexed already. Seeking to these positions is cheapest,
+ * e.g. seekbars can snap to them.
+ *
+ * Returns: (transfer none) (array length=n_keyframes): the sorted keyframe
+ *   positions, or %NULL if the media is not indexed.
+ */
+const GstClockTime *
+gst_player_media_info_get_keyframes (const GstPlayerMediaInfo * info,
+    guint * n_keyframes)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_MEDIA_INFO (info), NULL);
+  g_return_val_if_fail (n_keyframes != NULL, NULL);
+
+  if (!info->keyframes) {
+    *n_keyframes = 0;
+    return NULL;
+  }
+
+  *n_keyframes = info->keyframes->len;
+  return (const GstClockTime *) info->keyframes->data;
+}
+
+/**
+ * gst_player_media_info_get_nearest_keyframe:
+ * @info: a #GstPlayerMediaInfo
+ * @position: position in nanoseconds
+ *
+ * Returns: the keyframe position closest to @position, or
+ *   %GST_CLOCK_TIME_NONE if the media is not indexed or has no keyframes.
+ */
+GstClockTime
+gst_player_media_info_get_nearest_keyframe (const GstPlayerMediaInfo * info,
+    GstClockTime position)
+{
+  GstClockTime before, after;
+  guint lo, hi;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MEDIA_INFO (info), GST_CLOCK_TIME_NONE);
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (position),
+      GST_CLOCK_TIME_NONE);
+
+  if (!info->keyframes || info->keyframes->len == 0)
+    return GST_CLOCK_TIME_NONE;
+
+  /* First keyframe after position */
+  lo = 0;
+  hi = info->keyframes->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (info->keyframes, GstClockTime, mid) <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == 0)
+    return g_array_index (info->keyframes, GstClockTime, 0);
+  before = g_array_index (info->keyframes, GstClockTime, lo - 1);
+  if (lo == info->keyframes->len)
+    return before;
+  after = g_array_index (info->keyframes, GstClockTime, lo);
+
+  return position - before <= after - position ? before : after;
+}
@@ -169,8 +169,12 @@ const gchar*  gst_player_media_info_get_uri
                 (const GstPlayerMediaInfo *info);
 gboolean      gst_player_media_info_is_seekable
                 (const GstPlayerMediaInfo *info);
+gboolean      gst_player_media_info_is_playable
+                (const GstPlayerMediaInfo *info);
 GstClockTime  gst_player_media_info_get_duration
                 (const GstPlayerMediaInfo *info);
+guint         gst_player_media_info_get_variant_bitrate
+                (const GstPlayerMediaInfo *info);
 GList*        gst_player_media_info_get_stream_list
                 (const GstPlayerMediaInfo *info);
 GList*        gst_player_get_video_streams
@@ -187,6 +191,22 @@ const gchar*  gst_player_media_info_get_container_format
                 (const GstPlayerMediaInfo *info);
 GstSample*    gst_player_media_info_get_image_sample
                 (const GstPlayerMediaInfo *info);
+GstSample*    gst_player_media_info_get_cover_art
+                (const GstPlayerMediaInfo *info, gint max_width,
+                 gint max_height);
+guint         gst_player_media_info_get_n_chapters
+                (const GstPlayerMediaInfo *info);
+gboolean      gst_player_media_info_get_chapter
+                (const GstPlayerMediaInfo *info, guint index,
+                 GstClockTime *start, GstClockTime *stop,
+                 const gchar **title);
+gint          gst_player_media_info_get_chapter_at_position
+                (const GstPlayerMediaInfo *info, GstClockTime position);
+const GstClockTime *
+              gst_player_media_info_get_keyframes
+                (const GstPlayerMediaInfo *info, guint *n_keyframes);
+GstClockTime  gst_player_media_info_get_nearest_keyframe
+                (const GstPlayerMediaInfo *info, GstClockTime position);
 G_END_DECLS
 
 #endif /* __GST_PLAYER_MEDIA_INFO_H */
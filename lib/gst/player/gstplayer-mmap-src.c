@@ -0,0 +1,506 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Source for local files that hands out buffers wrapping a read-only
+ * mapping of the whole file instead of reading into newly allocated
+ * memory. Ahead of the current read position the kernel is asked to read
+ * in as much as the demuxer consumes in a few seconds.
+ *
+ * playbin only picks sources by URI protocol, so the player uses it by
+ * rewriting file:// URIs to a protocol only this element handles. */
+
+#include "gstplayer-mmap-src-private.h"
+
+#include <gst/base/gstbasesrc.h>
+#include <string.h>
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#define MMAP_SRC_PROTOCOL "gstplayer-mmap"
+
+/* Seconds of data that are read ahead at the current consumption rate */
+#define READ_AHEAD_TIME 2
+#define READ_AHEAD_MIN (512 * 1024)
+#define READ_AHEAD_MAX (64 * 1024 * 1024)
+/* Interval over which the consumption rate is measured */
+#define RATE_INTERVAL (250 * G_TIME_SPAN_MILLISECOND)
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_mmap_src_debug);
+#define GST_CAT_DEFAULT gst_player_mmap_src_debug
+
+/* Unmapped when the last buffer wrapping it is gone */
+typedef struct
+{
+  gint refcount;
+  gpointer data;
+  gsize size;
+} MmapRegion;
+
+static MmapRegion *
+mmap_region_ref (MmapRegion * region)
+{
+  g_atomic_int_inc (&region->refcount);
+
+  return region;
+}
+
+static void
+mmap_region_unref (MmapRegion * region)
+{
+  if (g_atomic_int_dec_and_test (&region->refcount)) {
+    munmap (region->data, region->size);
+    g_free (region);
+  }
+}
+
+#define GST_TYPE_PLAYER_MMAP_SRC (gst_player_mmap_src_get_type ())
+#define GST_PLAYER_MMAP_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_MMAP_SRC, GstPlayerMmapSrc))
+#define GST_IS_PLAYER_MMAP_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_MMAP_SRC))
+
+typedef struct
+{
+  GstBaseSrc parent;
+
+  /* Protected by object lock */
+  gchar *uri;
+  gchar *filename;
+
+  /* Only accessed from the streaming thread while started */
+  gint fd;
+  guint64 size;
+  MmapRegion *region;
+  gsize page_size;
+  guchar *residency;
+
+  guint64 advised_start, advised_end;
+  gint64 rate_start;
+  guint64 rate_bytes;
+  gdouble byte_rate;
+
+  /* Protected by object lock */
+  guint64 bytes_read;
+  guint64 page_faults;
+} GstPlayerMmapSrc;
+
+typedef GstBaseSrcClass GstPlayerMmapSrcClass;
+
+static GstStaticPadTemplate mmap_src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_player_mmap_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_GNUC_INTERNAL GType gst_player_mmap_src_get_type (void);
+G_DEFINE_TYPE_WITH_CODE (GstPlayerMmapSrc, gst_player_mmap_src,
+    GST_TYPE_BASE_SRC, G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_player_mmap_src_uri_handler_init));
+
+static void
+gst_player_mmap_src_finalize (GObject * object)
+{
+  GstPlayerMmapSrc *src = GST_PLAYER_MMAP_SRC (object);
+
+  g_free (src->uri);
+  g_free (src->filename);
+
+  G_OBJECT_CLASS (gst_player_mmap_src_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_player_mmap_src_start (GstBaseSrc * bsrc)
+{
+  GstPlayerMmapSrc *src = GST_PLAYER_MMAP_SRC (bsrc);
+  struct stat st;
+  gchar *filename;
+  gpointer data;
+
+  GST_OBJECT_LOCK (src);
+  filename = g_strdup (src->filename);
+  src->bytes_read = 0;
+  src->page_faults = 0;
+  GST_OBJECT_UNLOCK (src);
+
+  if (!filename) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL),
+        ("No file name specified for reading."));
+    return FALSE;
+  }
+
+  src->fd = g_open (filename, O_RDONLY, 0);
+  if (src->fd < 0) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("Could not open file \"%s\" for reading: %s", filename,
+            g_strerror (errno)));
+    g_free (filename);
+    return FALSE;
+  }
+
+  if (fstat (src->fd, &st) < 0 || !S_ISREG (st.st_mode)) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("\"%s\" is not a regular file", filename));
+    goto error;
+  }
+
+  src->size = st.st_size;
+  src->region = NULL;
+  if (src->size > G_MAXSIZE) {
+    /* Larger than the address space of 32 bit systems */
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("File \"%s\" is too large to be mapped", filename));
+    goto error;
+  }
+
+  if (src->size > 0) {
+    data = mmap (NULL, src->size, PROT_READ, MAP_SHARED, src->fd, 0);
+    if (data == MAP_FAILED) {
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+          ("Could not map file \"%s\": %s", filename, g_strerror (errno)));
+      goto error;
+    }
+
+    src->region = g_new (MmapRegion, 1);
+    src->region->refcount = 1;
+    src->region->data = data;
+    src->region->size = src->size;
+  }
+#ifdef POSIX_FADV_SEQUENTIAL
+  /* Larger kernel read-ahead for the pages we don't advise ourselves */
+  posix_fadvise (src->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  src->page_size = sysconf (_SC_PAGESIZE);
+  src->residency = NULL;
+  src->advised_start = src->advised_end = 0;
+  src->rate_start = g_get_monotonic_time ();
+  src->rate_bytes = 0;
+  src->byte_rate = 0.0;
+
+  GST_DEBUG_OBJECT (src, "Mapped %" G_GUINT64_FORMAT " bytes of %s",
+      src->size, filename);
+  g_free (filename);
+
+  return TRUE;
+
+error:
+  close (src->fd);
+  src->fd = -1;
+  g_free (filename);
+  return FALSE;
+}
+
+static gboolean
+gst_player_mmap_src_stop (GstBaseSrc * bsrc)
+{
+  GstPlayerMmapSrc *src = GST_PLAYER_MMAP_SRC (bsrc);
+
+  if (src->region) {
+    mmap_region_unref (src->region);
+    src->region = NULL;
+  }
+  if (src->fd >= 0) {
+    close (src->fd);
+    src->fd = -1;
+  }
+  g_free (src->residency);
+  src->residency = NULL;
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_mmap_src_get_size (GstBaseSrc * bsrc, guint64 * size)
+{
+  *size = GST_PLAYER_MMAP_SRC (bsrc)->size;
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_mmap_src_is_seekable (GstBaseSrc * bsrc)
+{
+  return TRUE;
+}
+
+/* Pages of [offset, offset + size) that are not in the page cache, each
+ * of them costs a major page fault when the buffer is read */
+static guint64
+count_missing_pages (GstPlayerMmapSrc * src, guint64 offset, guint size)
+{
+  guint64 start, n_pages, i;
+  guint64 missing = 0;
+
+  start = offset - offset % src->page_size;
+  n_pages = (offset + size - start + src->page_size - 1) / src->page_size;
+
+  src->residency = g_realloc (src->residency, n_pages);
+  if (mincore ((guchar *) src->region->data + start, n_pages * src->page_size,
+          (gpointer) src->residency) < 0)
+    return 0;
+
+  for (i = 0; i < n_pages; i++)
+    if (!(src->residency[i] & 1))
+      missing++;
+
+  return missing;
+}
+
+static void
+advise_read_ahead (GstPlayerMmapSrc * src, guint64 offset, guint size)
+{
+  guint64 end = offset + size, window, start, stop;
+  gint64 now, elapsed;
+
+  /* Bytes handed out per second, smoothed over a few intervals */
+  now = g_get_monotonic_time ();
+  src->rate_bytes += size;
+  elapsed = now - src->rate_start;
+  if (elapsed >= RATE_INTERVAL) {
+    gdouble rate = src->rate_bytes * (gdouble) G_TIME_SPAN_SECOND / elapsed;
+
+    src->byte_rate = src->byte_rate > 0.0 ?
+        0.75 * src->byte_rate + 0.25 * rate : rate;
+    src->rate_start = now;
+    src->rate_bytes = 0;
+  }
+
+  window = CLAMP (src->byte_rate * READ_AHEAD_TIME, READ_AHEAD_MIN,
+      READ_AHEAD_MAX);
+
+  /* Still well inside the advised range */
+  if (offset >= src->advised_start && end + window / 2 <= src->advised_end)
+    return;
+
+  start = offset >= src->advised_start
+      && end <= src->advised_end ? src->advised_end : end;
+  stop = MIN (end + window, src->size);
+  src->advised_start = offset;
+  src->advised_end = stop;
+  if (start >= stop)
+    return;
+
+  start -= start % src->page_size;
+  GST_LOG_OBJECT (src, "Reading ahead %" G_GUINT64_FORMAT " bytes at %"
+      G_GUINT64_FORMAT ", rate %.0lf bytes/s", stop - start, start,
+      src->byte_rate);
+  madvise ((guchar *) src->region->data + start, stop - start, MADV_WILLNEED);
+}
+
+static GstFlowReturn
+gst_player_mmap_src_create (GstBaseSrc * bsrc, guint64 offset, guint size,
+    GstBuffer ** buf)
+{
+  GstPlayerMmapSrc *src = GST_PLAYER_MMAP_SRC (bsrc);
+  GstBuffer *buffer;
+  guint64 missing;
+
+  if (offset >= src->size)
+    return GST_FLOW_EOS;
+
+  size = MIN (size, src->size - offset);
+
+  missing = count_missing_pages (src, offset, size);
+  advise_read_ahead (src, offset, size);
+
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      src->region->data, src->region->size, offset, size,
+      mmap_region_ref (src->region), (GDestroyNotify) mmap_region_unref);
+  GST_BUFFER_OFFSET (buffer) = offset;
+  GST_BUFFER_OFFSET_END (buffer) = offset + size;
+
+  GST_OBJECT_LOCK (src);
+  src->bytes_read += size;
+  src->page_faults += missing;
+  GST_OBJECT_UNLOCK (src);
+
+  *buf = buffer;
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_player_mmap_src_init (GstPlayerMmapSrc * src)
+{
+  src->fd = -1;
+}
+
+static void
+gst_player_mmap_src_class_init (GstPlayerMmapSrcClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseSrcClass *basesrc_class = (GstBaseSrcClass *) klass;
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_mmap_src_debug, "gst-player-mmap-src",
+      0, "GstPlayer mmap source");
+
+  gobject_class->finalize = gst_player_mmap_src_finalize;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&mmap_src_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player mmap source", "Source/File",
+      "Outputs memory mapped regions of a local file", "GstPlayer");
+
+  basesrc_class->start = gst_player_mmap_src_start;
+  basesrc_class->stop = gst_player_mmap_src_stop;
+  basesrc_class->get_size = gst_player_mmap_src_get_size;
+  basesrc_class->is_seekable = gst_player_mmap_src_is_seekable;
+  basesrc_class->create = gst_player_mmap_src_create;
+}
+
+static GstURIType
+gst_player_mmap_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_player_mmap_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { MMAP_SRC_PROTOCOL, NULL };
+
+  return protocols;
+}
+
+static gchar *
+gst_player_mmap_src_uri_get_uri (GstURIHandler * handler)
+{
+  GstPlayerMmapSrc *src = GST_PLAYER_MMAP_SRC (handler);
+  gchar *uri;
+
+  GST_OBJECT_LOCK (src);
+  uri = g_strdup (src->uri);
+  GST_OBJECT_UNLOCK (src);
+
+  return uri;
+}
+
+static gboolean
+gst_player_mmap_src_uri_set_uri (GstURIHandler * handler, const gchar * uri,
+    GError ** error)
+{
+  GstPlayerMmapSrc *src = GST_PLAYER_MMAP_SRC (handler);
+  gchar *file_uri, *filename;
+
+  if (GST_STATE (src) > GST_STATE_READY) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+        "Changing the URI while playing is not supported");
+    return FALSE;
+  }
+
+  /* The location part is the same as of the original file:// URI */
+  if (!gst_uri_has_protocol (uri, MMAP_SRC_PROTOCOL)) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_UNSUPPORTED_PROTOCOL,
+        "Unsupported URI '%s'", uri);
+    return FALSE;
+  }
+  file_uri = g_strconcat ("file", strchr (uri, ':'), NULL);
+  filename = g_filename_from_uri (file_uri, NULL, NULL);
+  g_free (file_uri);
+  if (!filename) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+        "Invalid URI '%s'", uri);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (src);
+  g_free (src->uri);
+  src->uri = g_strdup (uri);
+  g_free (src->filename);
+  src->filename = filename;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+static void
+gst_player_mmap_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_player_mmap_src_uri_get_type;
+  iface->get_protocols = gst_player_mmap_src_uri_get_protocols;
+  iface->get_uri = gst_player_mmap_src_uri_get_uri;
+  iface->set_uri = gst_player_mmap_src_uri_set_uri;
+}
+
+static gpointer
+register_mmap_src (gpointer data)
+{
+  /* Nothing else handles the protocol, the rank only has to be high enough
+   * for gst_element_make_from_uri() */
+  return GINT_TO_POINTER (gst_element_register (NULL, "playermmapsrc",
+          GST_RANK_PRIMARY, GST_TYPE_PLAYER_MMAP_SRC));
+}
+
+/* Returns the URI to use for @uri with the mmap source, or NULL if @uri
+ * is not a local file */
+gchar *
+gst_player_mmap_src_make_uri (const gchar * uri)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  if (!gst_uri_has_protocol (uri, "file"))
+    return NULL;
+
+  if (!GPOINTER_TO_INT (g_once (&once, register_mmap_src, NULL)))
+    return NULL;
+
+  return g_strconcat (MMAP_SRC_PROTOCOL, strchr (uri, ':'), NULL);
+}
+
+gboolean
+gst_player_mmap_src_get_stats (GstElement * element, guint64 * bytes_read,
+    guint64 * page_faults)
+{
+  GstPlayerMmapSrc *src;
+
+  if (!GST_IS_PLAYER_MMAP_SRC (element))
+    return FALSE;
+
+  src = GST_PLAYER_MMAP_SRC (element);
+  GST_OBJECT_LOCK (src);
+  *bytes_read = src->bytes_read;
+  *page_faults = src->page_faults;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+#else
+gchar *
+gst_player_mmap_src_make_uri (const gchar * uri)
+{
+  return NULL;
+}
+
+gboolean
+gst_player_mmap_src_get_stats (GstElement * element, guint64 * bytes_read,
+    guint64 * page_faults)
+{
+  return FALSE;
+}
+#endif
@@ -0,0 +1,1186 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-mosaic
+ * @short_description: GStreamer Player Mosaic API
+ *
+ * A #GstPlayerMosaic plays several media at once in the tiles of a grid,
+ * for example the cameras of a surveillance system. All media are decoded
+ * in a single pipeline with one clock and composited into one picture, so
+ * there is a single video sink and window instead of one per media. Each
+ * media is scaled to the size of its tile while it is decoded, in its own
+ * streaming thread, and the compositor only has to place the tiles. Audio
+ * is not played.
+ *
+ * The media of a tile can be set or replaced at any time. An error or the
+ * end of the media only stops its tile, the others go on, and a tile that
+ * failed is started again by the next gst_player_mosaic_play().
+ *
+ * The state and media information of each tile are reported by signals,
+ * which are emitted from the thread-default #GMainContext at the time the
+ * mosaic was created. That context has to be running.
+ */
+
+#include "gstplayer-mosaic.h"
+#include "gstplayer-media-info-private.h"
+
+#include <gst/video/videooverlay.h>
+
+/* How long the compositor waits for tiles of live media */
+#define MOSAIC_LATENCY (100 * GST_MSECOND)
+
+enum
+{
+  PROP_0,
+  PROP_COLUMNS,
+  PROP_ROWS,
+  PROP_TILE_WIDTH,
+  PROP_TILE_HEIGHT,
+  PROP_VIDEO_SINK,
+  PROP_WINDOW_HANDLE,
+  PROP_LAST
+};
+
+enum
+{
+  SIGNAL_TILE_STATE_CHANGED,
+  SIGNAL_TILE_MEDIA_INFO_UPDATED,
+  SIGNAL_TILE_END_OF_STREAM,
+  SIGNAL_TILE_ERROR,
+  SIGNAL_END_OF_STREAM,
+  SIGNAL_ERROR,
+  SIGNAL_LAST
+};
+
+typedef struct
+{
+  /* Only accessed from main context */
+  GstElement *bin;
+  GstPad *mixer_pad;
+  GstTagList *tags;
+
+  /* Protected by lock */
+  gchar *uri;
+  GstPlayerState state;
+  GstPlayerMediaInfo *media_info;
+} MosaicTile;
+
+struct _GstPlayerMosaic
+{
+  GstObject parent;
+
+  guint columns;
+  guint rows;
+  gint tile_width;
+  gint tile_height;
+  GstElement *video_sink;
+  MosaicTile *tiles;
+
+  GMainContext *context;
+  GstElement *pipeline;
+  GstElement *mixer;
+  GSource *bus_source;
+  /* Why the pipeline could not be built, reported when playing */
+  GError *pipeline_error;
+  /* Only accessed from main context */
+  GstState target_state;
+
+  GMutex lock;
+  /* Protected by lock */
+  guintptr window_handle;
+};
+
+struct _GstPlayerMosaicClass
+{
+  GstObjectClass parent_class;
+};
+
+#define parent_class gst_player_mosaic_parent_class
+G_DEFINE_TYPE (GstPlayerMosaic, gst_player_mosaic, GST_TYPE_OBJECT);
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+static guint signals[SIGNAL_LAST] = { 0, };
+
+static void gst_player_mosaic_dispose (GObject * object);
+static void gst_player_mosaic_finalize (GObject * object);
+static void gst_player_mosaic_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_player_mosaic_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_player_mosaic_constructed (GObject * object);
+
+static void
+gst_player_mosaic_init (GstPlayerMosaic * self)
+{
+  g_mutex_init (&self->lock);
+  self->context = g_main_context_ref_thread_default ();
+  self->target_state = GST_STATE_NULL;
+}
+
+static void
+gst_player_mosaic_class_init (GstPlayerMosaicClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_player_mosaic_set_property;
+  gobject_class->get_property = gst_player_mosaic_get_property;
+  gobject_class->dispose = gst_player_mosaic_dispose;
+  gobject_class->finalize = gst_player_mosaic_finalize;
+  gobject_class->constructed = gst_player_mosaic_constructed;
+
+  param_specs[PROP_COLUMNS] =
+      g_param_spec_uint ("columns", "Columns", "Number of columns of tiles",
+      1, G_MAXUINT16, 2,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_ROWS] =
+      g_param_spec_uint ("rows", "Rows", "Number of rows of tiles",
+      1, G_MAXUINT16, 2,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_TILE_WIDTH] =
+      g_param_spec_int ("tile-width", "Tile width", "Width of a tile in pixels",
+      2, G_MAXINT16, 320,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_TILE_HEIGHT] =
+      g_param_spec_int ("tile-height", "Tile height",
+      "Height of a tile in pixels", 2, G_MAXINT16, 240,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_VIDEO_SINK] =
+      g_param_spec_object ("video-sink", "Video sink",
+      "Sink showing the mosaic, NULL for the default one", GST_TYPE_ELEMENT,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_WINDOW_HANDLE] =
+      g_param_spec_pointer ("window-handle", "Window Handle",
+      "Window handle into which the mosaic should be rendered",
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+
+  signals[SIGNAL_TILE_STATE_CHANGED] =
+      g_signal_new ("tile-state-changed", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, G_TYPE_UINT, GST_TYPE_PLAYER_STATE);
+
+  signals[SIGNAL_TILE_MEDIA_INFO_UPDATED] =
+      g_signal_new ("tile-media-info-updated", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, G_TYPE_UINT, GST_TYPE_PLAYER_MEDIA_INFO);
+
+  signals[SIGNAL_TILE_END_OF_STREAM] =
+      g_signal_new ("tile-end-of-stream", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, G_TYPE_UINT);
+
+  signals[SIGNAL_TILE_ERROR] =
+      g_signal_new ("tile-error", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_ERROR);
+
+  signals[SIGNAL_END_OF_STREAM] =
+      g_signal_new ("end-of-stream", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 0, G_TYPE_INVALID);
+
+  signals[SIGNAL_ERROR] =
+      g_signal_new ("error", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, G_TYPE_ERROR);
+}
+
+static GstBusSyncReply
+bus_sync_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerMosaic *self = user_data;
+  guintptr window_handle;
+
+  if (!gst_is_video_overlay_prepare_window_handle_message (msg))
+    return GST_BUS_PASS;
+
+  g_mutex_lock (&self->lock);
+  window_handle = self->window_handle;
+  g_mutex_unlock (&self->lock);
+
+  if (window_handle)
+    gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (GST_MESSAGE_SRC
+            (msg)), window_handle);
+
+  return GST_BUS_PASS;
+}
+
+static gboolean bus_message_cb (GstBus * bus, GstMessage * msg,
+    gpointer user_data);
+
+static void
+gst_player_mosaic_constructed (GObject * object)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+  GstElement *filter, *convert, *sink;
+  GstCaps *caps;
+  GstBus *bus;
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+
+  self->tiles = g_new0 (MosaicTile, self->columns * self->rows);
+
+  self->pipeline = gst_pipeline_new ("mosaic");
+
+  /* compositor is the newer, faster replacement of videomixer */
+  self->mixer = gst_element_factory_make ("compositor", "mixer");
+  if (!self->mixer)
+    self->mixer = gst_element_factory_make ("videomixer", "mixer");
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  convert = gst_element_factory_make ("videoconvert", NULL);
+  sink = self->video_sink ? self->video_sink :
+      gst_element_factory_make ("autovideosink", NULL);
+
+  if (!self->mixer || !filter || !convert || !sink) {
+    self->pipeline_error = g_error_new (GST_CORE_ERROR,
+        GST_CORE_ERROR_MISSING_PLUGIN, "Missing elements for the mosaic");
+    if (self->mixer)
+      gst_object_unref (self->mixer);
+    self->mixer = NULL;
+    if (filter)
+      gst_object_unref (filter);
+    if (convert)
+      gst_object_unref (convert);
+    if (sink && sink != self->video_sink)
+      gst_object_unref (sink);
+    return;
+  }
+
+  gst_util_set_object_arg (G_OBJECT (self->mixer), "background", "black");
+  /* Live tiles are mixed in live mode, where late tiles are not waited
+   * for longer than this. videomixer has no such setting */
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (self->mixer),
+          "latency"))
+    g_object_set (self->mixer, "latency", (guint64) MOSAIC_LATENCY, NULL);
+
+  /* The tiles are converted to the same format already */
+  caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, "I420",
+      "width", G_TYPE_INT, self->tile_width * (gint) self->columns,
+      "height", G_TYPE_INT, self->tile_height * (gint) self->rows,
+      "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  gst_bin_add_many (GST_BIN (self->pipeline), self->mixer, filter, convert,
+      sink, NULL);
+  gst_element_link_many (self->mixer, filter, convert, sink, NULL);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (self->pipeline));
+  gst_bus_set_sync_handler (bus, bus_sync_cb, self, NULL);
+  self->bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (self->bus_source, (GSourceFunc) bus_message_cb,
+      self, NULL);
+  g_source_attach (self->bus_source, self->context);
+  gst_object_unref (bus);
+}
+
+static void
+tile_pad_added_cb (GstElement * decodebin, GstPad * pad, gpointer user_data)
+{
+  GstElement *bin, *scale, *sink;
+  GstPad *sinkpad;
+
+  bin = GST_ELEMENT (gst_element_get_parent (decodebin));
+  scale = gst_bin_get_by_name (GST_BIN (bin), "scale");
+  sinkpad = gst_element_get_static_pad (scale, "sink");
+
+  /* Only the first video stream is shown */
+  if (gst_pad_is_linked (sinkpad)) {
+    sink = gst_element_factory_make ("fakesink", NULL);
+    g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+    gst_bin_add (GST_BIN (bin), sink);
+    gst_element_sync_state_with_parent (sink);
+    gst_object_unref (sinkpad);
+    sinkpad = gst_element_get_static_pad (sink, "sink");
+  }
+
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    GST_WARNING_OBJECT (bin, "Failed to link %" GST_PTR_FORMAT, pad);
+
+  gst_object_unref (sinkpad);
+  gst_object_unref (scale);
+  gst_object_unref (bin);
+}
+
+static GstPadProbeReturn
+tile_eos_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstElement *bin = user_data;
+
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS)
+    gst_element_post_message (bin,
+        gst_message_new_application (GST_OBJECT (bin),
+            gst_structure_new_empty ("mosaic-tile-eos")));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstClockTime get_running_time (GstPlayerMosaic * self);
+
+/* Called from the streaming thread of a tile added while running, before
+ * its segment. Live media is timestamped in the running time of the
+ * pipeline already, other media starts at the current running time */
+static GstPadProbeReturn
+tile_offset_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstPlayerMosaic *self = user_data;
+  GstClockTime running_time;
+  gboolean live = FALSE;
+  GstQuery *query;
+
+  query = gst_query_new_latency ();
+  if (gst_pad_query (pad, query))
+    gst_query_parse_latency (query, &live, NULL, NULL);
+  gst_query_unref (query);
+
+  if (!live) {
+    running_time = get_running_time (self);
+    if (GST_CLOCK_TIME_IS_VALID (running_time))
+      gst_pad_set_offset (pad, running_time);
+  }
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Running time of the pipeline, at which new tiles start */
+static GstClockTime
+get_running_time (GstPlayerMosaic * self)
+{
+  GstClock *clock;
+  GstClockTime now, base_time;
+
+  if (GST_STATE (self->pipeline) != GST_STATE_PLAYING)
+    return gst_element_get_start_time (self->pipeline);
+
+  clock = gst_element_get_clock (self->pipeline);
+  if (!clock)
+    return GST_CLOCK_TIME_NONE;
+
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+  base_time = gst_element_get_base_time (self->pipeline);
+
+  return now > base_time ? now - base_time : 0;
+}
+
+static void
+emit_tile_state (GstPlayerMosaic * self, guint index, GstPlayerState state)
+{
+  MosaicTile *tile = &self->tiles[index];
+  gboolean changed;
+
+  g_mutex_lock (&self->lock);
+  changed = tile->state != state;
+  tile->state = state;
+  g_mutex_unlock (&self->lock);
+
+  if (changed) {
+    GST_DEBUG_OBJECT (self, "Tile %u is %s", index,
+        gst_player_state_get_name (state));
+    g_signal_emit (self, signals[SIGNAL_TILE_STATE_CHANGED], 0, index, state);
+  }
+}
+
+/* Builds the media information of a tile from what its pipeline knows */
+static void
+update_tile_media_info (GstPlayerMosaic * self, guint index)
+{
+  MosaicTile *tile = &self->tiles[index];
+  GstPlayerMediaInfo *info;
+  GstPlayerStreamInfo *stream;
+  GstPlayerVideoInfo *video;
+  GstElement *scale;
+  GstPad *pad;
+  GstCaps *caps = NULL;
+  GstStructure *s;
+  GstQuery *query;
+  gint64 duration;
+
+  scale = gst_bin_get_by_name (GST_BIN (tile->bin), "scale");
+  pad = gst_element_get_static_pad (scale, "sink");
+  caps = gst_pad_get_current_caps (pad);
+  gst_object_unref (pad);
+  gst_object_unref (scale);
+
+  g_mutex_lock (&self->lock);
+  info = gst_player_media_info_new (tile->uri);
+  g_mutex_unlock (&self->lock);
+
+  if (caps) {
+    stream = gst_player_stream_info_new (0, GST_TYPE_PLAYER_VIDEO_INFO);
+    video = (GstPlayerVideoInfo *) stream;
+    stream->caps = caps;
+    s = gst_caps_get_structure (caps, 0);
+    if (!gst_structure_get_int (s, "width", &video->width))
+      video->width = -1;
+    if (!gst_structure_get_int (s, "height", &video->height))
+      video->height = -1;
+    if (!gst_structure_get_fraction (s, "framerate", &video->framerate_num,
+            &video->framerate_denom)) {
+      video->framerate_num = 0;
+      video->framerate_denom = 1;
+    }
+    if (!gst_structure_get_fraction (s, "pixel-aspect-ratio", &video->par_num,
+            &video->par_denom)) {
+      video->par_num = 1;
+      video->par_denom = 1;
+    }
+    video->bitrate = video->max_bitrate = -1;
+    info->stream_list = g_list_append (info->stream_list, stream);
+    info->video_stream_list = g_list_append (info->video_stream_list, stream);
+  }
+
+  if (gst_element_query_duration (tile->bin, GST_FORMAT_TIME, &duration))
+    info->duration = duration;
+
+  query = gst_query_new_seeking (GST_FORMAT_TIME);
+  if (gst_element_query (tile->bin, query))
+    gst_query_parse_seeking (query, NULL, &info->seekable, NULL, NULL);
+  gst_query_unref (query);
+
+  if (tile->tags) {
+    info->tags = gst_tag_list_ref (tile->tags);
+    gst_tag_list_get_string (tile->tags, GST_TAG_TITLE, &info->title);
+    gst_tag_list_get_string (tile->tags, GST_TAG_CONTAINER_FORMAT,
+        &info->container);
+  }
+
+  g_mutex_lock (&self->lock);
+  if (tile->media_info)
+    g_object_unref (tile->media_info);
+  tile->media_info = g_object_ref (info);
+  g_mutex_unlock (&self->lock);
+
+  g_signal_emit (self, signals[SIGNAL_TILE_MEDIA_INFO_UPDATED], 0, index,
+      info);
+  g_object_unref (info);
+}
+
+/* Adds the pipeline of a tile, which decodes its media and scales it to
+ * the size of the tile */
+static void
+tile_start (GstPlayerMosaic * self, guint index)
+{
+  MosaicTile *tile = &self->tiles[index];
+  GstElement *decodebin, *scale, *convert, *filter;
+  GstCaps *caps;
+  GstPad *pad;
+  gchar *uri;
+
+  g_mutex_lock (&self->lock);
+  uri = g_strdup (tile->uri);
+  g_mutex_unlock (&self->lock);
+
+  if (!uri || tile->bin || !self->mixer) {
+    g_free (uri);
+    return;
+  }
+
+  decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  scale = gst_element_factory_make ("videoscale", "scale");
+  convert = gst_element_factory_make ("videoconvert", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  if (!decodebin || !scale || !convert || !filter) {
+    GError *err = g_error_new (GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN,
+        "Missing elements for the tile");
+
+    if (decodebin)
+      gst_object_unref (decodebin);
+    if (scale)
+      gst_object_unref (scale);
+    if (convert)
+      gst_object_unref (convert);
+    if (filter)
+      gst_object_unref (filter);
+    g_free (uri);
+    g_signal_emit (self, signals[SIGNAL_TILE_ERROR], 0, index, err);
+    g_error_free (err);
+    return;
+  }
+
+  /* Other streams are not even decoded */
+  caps = gst_caps_new_empty_simple ("video/x-raw");
+  g_object_set (decodebin, "uri", uri, "caps", caps, "expose-all-streams",
+      FALSE, NULL);
+  gst_caps_unref (caps);
+  g_free (uri);
+  g_signal_connect (decodebin, "pad-added", G_CALLBACK (tile_pad_added_cb),
+      NULL);
+
+  caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, "I420",
+      "width", G_TYPE_INT, self->tile_width, "height", G_TYPE_INT,
+      self->tile_height, "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  tile->bin = gst_object_ref (gst_bin_new (NULL));
+  gst_bin_add_many (GST_BIN (tile->bin), decodebin, scale, convert, filter,
+      NULL);
+  gst_element_link_many (scale, convert, filter, NULL);
+
+  pad = gst_element_get_static_pad (filter, "src");
+  gst_element_add_pad (tile->bin, gst_ghost_pad_new ("src", pad));
+  gst_object_unref (pad);
+
+  gst_bin_add (GST_BIN (self->pipeline), tile->bin);
+
+  tile->mixer_pad = gst_element_get_request_pad (self->mixer, "sink_%u");
+  g_object_set (tile->mixer_pad, "xpos",
+      (gint) (index % self->columns) * self->tile_width, "ypos",
+      (gint) (index / self->columns) * self->tile_height, NULL);
+
+  pad = gst_element_get_static_pad (tile->bin, "src");
+  /* Whether the media is live is only known once it streams */
+  if (GST_STATE (self->pipeline) >= GST_STATE_PAUSED)
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        tile_offset_probe_cb, self, NULL);
+  gst_pad_link (pad, tile->mixer_pad);
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      tile_eos_probe_cb, tile->bin, NULL);
+  gst_object_unref (pad);
+
+  GST_DEBUG_OBJECT (self, "Starting tile %u", index);
+  gst_element_sync_state_with_parent (tile->bin);
+}
+
+/* Removes the pipeline of a tile */
+static void
+tile_stop (GstPlayerMosaic * self, guint index)
+{
+  MosaicTile *tile = &self->tiles[index];
+
+  if (!tile->bin)
+    return;
+
+  GST_DEBUG_OBJECT (self, "Stopping tile %u", index);
+
+  gst_element_set_locked_state (tile->bin, TRUE);
+  gst_element_set_state (tile->bin, GST_STATE_NULL);
+  gst_element_release_request_pad (self->mixer, tile->mixer_pad);
+  gst_object_unref (tile->mixer_pad);
+  tile->mixer_pad = NULL;
+  gst_bin_remove (GST_BIN (self->pipeline), tile->bin);
+  gst_object_unref (tile->bin);
+  tile->bin = NULL;
+
+  if (tile->tags) {
+    gst_tag_list_unref (tile->tags);
+    tile->tags = NULL;
+  }
+
+  emit_tile_state (self, index, GST_PLAYER_STATE_STOPPED);
+}
+
+/* Returns the tile @object belongs to, or -1 */
+static gint
+find_tile (GstPlayerMosaic * self, GstObject * object)
+{
+  guint i;
+
+  for (i = 0; i < self->columns * self->rows; i++) {
+    if (self->tiles[i].bin && (object == GST_OBJECT (self->tiles[i].bin)
+            || gst_object_has_as_ancestor (object,
+                GST_OBJECT (self->tiles[i].bin))))
+      return i;
+  }
+
+  return -1;
+}
+
+static void
+stop_internal (GstPlayerMosaic * self)
+{
+  guint i;
+
+  self->target_state = GST_STATE_NULL;
+  gst_element_set_state (self->pipeline, GST_STATE_NULL);
+  for (i = 0; i < self->columns * self->rows; i++)
+    emit_tile_state (self, i, GST_PLAYER_STATE_STOPPED);
+}
+
+static gboolean
+bus_message_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayerMosaic *self = user_data;
+  GstState old_state, new_state;
+  GError *err;
+  gchar *debug;
+  GstTagList *tags;
+  gint index, percent;
+
+  /* Left over from tiles that were removed already */
+  if (GST_MESSAGE_SRC (msg) != GST_OBJECT (self->pipeline)
+      && !gst_object_has_as_ancestor (GST_MESSAGE_SRC (msg),
+          GST_OBJECT (self->pipeline)))
+    return G_SOURCE_CONTINUE;
+
+  index = find_tile (self, GST_MESSAGE_SRC (msg));
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:
+      gst_message_parse_error (msg, &err, &debug);
+      GST_WARNING_OBJECT (self, "Error from %s: %s (%s)",
+          GST_MESSAGE_SRC_NAME (msg), err->message, debug ? debug : "");
+      if (index >= 0) {
+        /* Only the tile stops, the others go on, also if its state change
+         * failed */
+        tile_stop (self, index);
+        if (self->target_state >= GST_STATE_PAUSED)
+          gst_element_set_state (self->pipeline, self->target_state);
+        g_signal_emit (self, signals[SIGNAL_TILE_ERROR], 0, index, err);
+      } else {
+        stop_internal (self);
+        g_signal_emit (self, signals[SIGNAL_ERROR], 0, err);
+      }
+      g_error_free (err);
+      g_free (debug);
+      break;
+    case GST_MESSAGE_EOS:
+      g_signal_emit (self, signals[SIGNAL_END_OF_STREAM], 0);
+      break;
+    case GST_MESSAGE_APPLICATION:
+      if (index >= 0 && gst_message_has_name (msg, "mosaic-tile-eos")) {
+        emit_tile_state (self, index, GST_PLAYER_STATE_STOPPED);
+        g_signal_emit (self, signals[SIGNAL_TILE_END_OF_STREAM], 0, index);
+      }
+      break;
+    case GST_MESSAGE_STATE_CHANGED:
+      if (index < 0
+          || GST_MESSAGE_SRC (msg) != GST_OBJECT (self->tiles[index].bin))
+        break;
+      gst_message_parse_state_changed (msg, &old_state, &new_state, NULL);
+      /* Live media only knows its streams when playing */
+      if ((new_state == GST_STATE_PAUSED && old_state == GST_STATE_READY)
+          || new_state == GST_STATE_PLAYING)
+        update_tile_media_info (self, index);
+      if (new_state == GST_STATE_PLAYING)
+        emit_tile_state (self, index, GST_PLAYER_STATE_PLAYING);
+      else if (new_state == GST_STATE_PAUSED)
+        emit_tile_state (self, index, GST_PLAYER_STATE_PAUSED);
+      break;
+    case GST_MESSAGE_BUFFERING:
+      if (index < 0)
+        break;
+      gst_message_parse_buffering (msg, &percent);
+      if (percent < 100)
+        emit_tile_state (self, index, GST_PLAYER_STATE_BUFFERING);
+      else
+        emit_tile_state (self, index,
+            GST_STATE (self->tiles[index].bin) == GST_STATE_PLAYING ?
+            GST_PLAYER_STATE_PLAYING : GST_PLAYER_STATE_PAUSED);
+      break;
+    case GST_MESSAGE_TAG:
+      if (index < 0)
+        break;
+      gst_message_parse_tag (msg, &tags);
+      if (self->tiles[index].tags) {
+        GstTagList *merged = gst_tag_list_merge (self->tiles[index].tags,
+            tags, GST_TAG_MERGE_REPLACE);
+
+        gst_tag_list_unref (self->tiles[index].tags);
+        self->tiles[index].tags = merged;
+        gst_tag_list_unref (tags);
+      } else {
+        self->tiles[index].tags = tags;
+      }
+      break;
+    default:
+      break;
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gst_player_mosaic_dispose (GObject * object)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+  GstBus *bus;
+  guint i;
+
+  if (self->bus_source) {
+    g_source_destroy (self->bus_source);
+    g_source_unref (self->bus_source);
+    self->bus_source = NULL;
+  }
+
+  if (self->pipeline) {
+    gst_element_set_state (self->pipeline, GST_STATE_NULL);
+    bus = gst_pipeline_get_bus (GST_PIPELINE (self->pipeline));
+    gst_bus_set_sync_handler (bus, NULL, NULL, NULL);
+    gst_object_unref (bus);
+
+    for (i = 0; i < self->columns * self->rows; i++) {
+      if (self->tiles[i].mixer_pad)
+        gst_object_unref (self->tiles[i].mixer_pad);
+      if (self->tiles[i].bin)
+        gst_object_unref (self->tiles[i].bin);
+      if (self->tiles[i].tags)
+        gst_tag_list_unref (self->tiles[i].tags);
+      self->tiles[i].mixer_pad = NULL;
+      self->tiles[i].bin = NULL;
+      self->tiles[i].tags = NULL;
+    }
+
+    gst_object_unref (self->pipeline);
+    self->pipeline = NULL;
+    self->mixer = NULL;
+  }
+
+  if (self->video_sink) {
+    gst_object_unref (self->video_sink);
+    self->video_sink = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_player_mosaic_finalize (GObject * object)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+  guint i;
+
+  for (i = 0; self->tiles && i < self->columns * self->rows; i++) {
+    g_free (self->tiles[i].uri);
+    if (self->tiles[i].media_info)
+      g_object_unref (self->tiles[i].media_info);
+  }
+  g_free (self->tiles);
+  g_clear_error (&self->pipeline_error);
+  g_main_context_unref (self->context);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_player_mosaic_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+  GstElement *sink;
+
+  switch (prop_id) {
+    case PROP_COLUMNS:
+      self->columns = g_value_get_uint (value);
+      break;
+    case PROP_ROWS:
+      self->rows = g_value_get_uint (value);
+      break;
+    case PROP_TILE_WIDTH:
+      self->tile_width = g_value_get_int (value);
+      break;
+    case PROP_TILE_HEIGHT:
+      self->tile_height = g_value_get_int (value);
+      break;
+    case PROP_VIDEO_SINK:
+      self->video_sink = g_value_get_object (value);
+      if (self->video_sink)
+        gst_object_ref_sink (self->video_sink);
+      break;
+    case PROP_WINDOW_HANDLE:
+      g_mutex_lock (&self->lock);
+      self->window_handle = (guintptr) g_value_get_pointer (value);
+      g_mutex_unlock (&self->lock);
+
+      /* Sinks that are already there are not asking anymore */
+      sink = self->pipeline ? gst_bin_get_by_interface (GST_BIN
+          (self->pipeline), GST_TYPE_VIDEO_OVERLAY) : NULL;
+      if (sink) {
+        gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (sink),
+            (guintptr) g_value_get_pointer (value));
+        gst_object_unref (sink);
+      }
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_player_mosaic_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPlayerMosaic *self = GST_PLAYER_MOSAIC (object);
+
+  switch (prop_id) {
+    case PROP_COLUMNS:
+      g_value_set_uint (value, self->columns);
+      break;
+    case PROP_ROWS:
+      g_value_set_uint (value, self->rows);
+      break;
+    case PROP_TILE_WIDTH:
+      g_value_set_int (value, self->tile_width);
+      break;
+    case PROP_TILE_HEIGHT:
+      g_value_set_int (value, self->tile_height);
+      break;
+    case PROP_VIDEO_SINK:
+      g_value_set_object (value, self->video_sink);
+      break;
+    case PROP_WINDOW_HANDLE:
+      g_mutex_lock (&self->lock);
+      g_value_set_pointer (value, (gpointer) self->window_handle);
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/**
+ * gst_player_mosaic_new:
+ * @columns: number of columns of the grid
+ * @rows: number of rows of the grid
+ * @tile_width: width of a tile in pixels
+ * @tile_height: height of a tile in pixels
+ * @video_sink: (allow-none) (transfer floating): sink showing the mosaic,
+ *   or %NULL for the default one
+ *
+ * Creates a new mosaic with empty tiles. The tiles are numbered from the
+ * top left to the right and then down.
+ *
+ * Returns: a new #GstPlayerMosaic instance
+ */
+GstPlayerMosaic *
+gst_player_mosaic_new (guint columns, guint rows, gint tile_width,
+    gint tile_height, GstElement * video_sink)
+{
+  g_return_val_if_fail (columns > 0 && rows > 0, NULL);
+  g_return_val_if_fail (tile_width > 0 && tile_height > 0, NULL);
+  g_return_val_if_fail (video_sink == NULL || GST_IS_ELEMENT (video_sink),
+      NULL);
+
+  return g_object_new (GST_TYPE_PLAYER_MOSAIC, "columns", columns, "rows",
+      rows, "tile-width", tile_width, "tile-height", tile_height,
+      "video-sink", video_sink, NULL);
+}
+
+/**
+ * gst_player_mosaic_get_n_tiles:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Returns: the number of tiles of the grid.
+ */
+guint
+gst_player_mosaic_get_n_tiles (GstPlayerMosaic * self)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), 0);
+
+  return self->columns * self->rows;
+}
+
+typedef struct
+{
+  GstPlayerMosaic *mosaic;
+  guint tile;
+  gchar *uri;
+} TileUriRequest;
+
+static void
+tile_uri_request_free (TileUriRequest * request)
+{
+  gst_object_unref (request->mosaic);
+  g_free (request->uri);
+  g_free (request);
+}
+
+static gboolean
+set_tile_uri_internal (gpointer user_data)
+{
+  TileUriRequest *request = user_data;
+  GstPlayerMosaic *self = request->mosaic;
+  MosaicTile *tile = &self->tiles[request->tile];
+
+  tile_stop (self, request->tile);
+
+  g_mutex_lock (&self->lock);
+  g_free (tile->uri);
+  tile->uri = g_strdup (request->uri);
+  if (tile->media_info) {
+    g_object_unref (tile->media_info);
+    tile->media_info = NULL;
+  }
+  g_mutex_unlock (&self->lock);
+
+  /* Stopped mosaics start all tiles when playing */
+  if (self->target_state >= GST_STATE_PAUSED)
+    tile_start (self, request->tile);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_mosaic_set_tile_uri:
+ * @mosaic: #GstPlayerMosaic instance
+ * @tile: index of the tile
+ * @uri: (allow-none): URI of the media to show in @tile, or %NULL to
+ *   clear it
+ *
+ * Sets the media of @tile. Media that was shown in it before is stopped,
+ * the new one starts right away if the mosaic is playing or paused.
+ */
+void
+gst_player_mosaic_set_tile_uri (GstPlayerMosaic * self, guint tile,
+    const gchar * uri)
+{
+  TileUriRequest *request;
+
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+  g_return_if_fail (tile < self->columns * self->rows);
+
+  request = g_new0 (TileUriRequest, 1);
+  request->mosaic = gst_object_ref (self);
+  request->tile = tile;
+  request->uri = g_strdup (uri);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      set_tile_uri_internal, request, (GDestroyNotify) tile_uri_request_free);
+}
+
+/**
+ * gst_player_mosaic_get_tile_uri:
+ * @mosaic: #GstPlayerMosaic instance
+ * @tile: index of the tile
+ *
+ * Returns: (transfer full): the URI of the media of @tile, or %NULL if it
+ * is empty. g_free() after usage.
+ */
+gchar *
+gst_player_mosaic_get_tile_uri (GstPlayerMosaic * self, guint tile)
+{
+  gchar *uri;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), NULL);
+  g_return_val_if_fail (tile < self->columns * self->rows, NULL);
+
+  g_mutex_lock (&self->lock);
+  uri = g_strdup (self->tiles[tile].uri);
+  g_mutex_unlock (&self->lock);
+
+  return uri;
+}
+
+/**
+ * gst_player_mosaic_get_tile_state:
+ * @mosaic: #GstPlayerMosaic instance
+ * @tile: index of the tile
+ *
+ * Returns: the state of @tile, %GST_PLAYER_STATE_STOPPED once its media
+ * ended or failed.
+ */
+GstPlayerState
+gst_player_mosaic_get_tile_state (GstPlayerMosaic * self, guint tile)
+{
+  GstPlayerState state;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self),
+      GST_PLAYER_STATE_STOPPED);
+  g_return_val_if_fail (tile < self->columns * self->rows,
+      GST_PLAYER_STATE_STOPPED);
+
+  g_mutex_lock (&self->lock);
+  state = self->tiles[tile].state;
+  g_mutex_unlock (&self->lock);
+
+  return state;
+}
+
+/**
+ * gst_player_mosaic_get_tile_media_info:
+ * @mosaic: #GstPlayerMosaic instance
+ * @tile: index of the tile
+ *
+ * Retrieves what is known about the media of @tile once it started: the
+ * video stream at the size it is decoded in, the duration, whether it is
+ * seekable and its tags.
+ *
+ * Returns: (transfer full): a #GstPlayerMediaInfo, or %NULL if it is not
+ * known yet.
+ */
+GstPlayerMediaInfo *
+gst_player_mosaic_get_tile_media_info (GstPlayerMosaic * self, guint tile)
+{
+  GstPlayerMediaInfo *info;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), NULL);
+  g_return_val_if_fail (tile < self->columns * self->rows, NULL);
+
+  g_mutex_lock (&self->lock);
+  info = self->tiles[tile].media_info ?
+      g_object_ref (self->tiles[tile].media_info) : NULL;
+  g_mutex_unlock (&self->lock);
+
+  return info;
+}
+
+static gboolean
+set_state_internal (GstPlayerMosaic * self, GstState state)
+{
+  guint i;
+
+  if (self->pipeline_error) {
+    g_signal_emit (self, signals[SIGNAL_ERROR], 0, self->pipeline_error);
+    return G_SOURCE_REMOVE;
+  }
+
+  /* Tiles that failed before are tried again */
+  if (self->target_state < GST_STATE_PAUSED) {
+    for (i = 0; i < self->columns * self->rows; i++)
+      tile_start (self, i);
+  }
+
+  GST_DEBUG_OBJECT (self, "Setting state %s",
+      gst_element_state_get_name (state));
+  self->target_state = state;
+  /* Tiles that fail post an error, their removal lets the state change go
+   * on. Other failures post an error too, which stops everything */
+  if (gst_element_set_state (self->pipeline,
+          state) == GST_STATE_CHANGE_FAILURE)
+    GST_DEBUG_OBJECT (self, "State change failed, waiting for the error");
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+play_internal (gpointer user_data)
+{
+  return set_state_internal (user_data, GST_STATE_PLAYING);
+}
+
+static gboolean
+pause_internal (gpointer user_data)
+{
+  return set_state_internal (user_data, GST_STATE_PAUSED);
+}
+
+static gboolean
+gst_player_mosaic_stop_internal (gpointer user_data)
+{
+  stop_internal (user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_mosaic_play:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Starts playing the media of all tiles.
+ */
+void
+gst_player_mosaic_play (GstPlayerMosaic * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      play_internal, gst_object_ref (self), gst_object_unref);
+}
+
+/**
+ * gst_player_mosaic_pause:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Pauses the media of all tiles.
+ */
+void
+gst_player_mosaic_pause (GstPlayerMosaic * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      pause_internal, gst_object_ref (self), gst_object_unref);
+}
+
+/**
+ * gst_player_mosaic_stop:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Stops the media of all tiles, playing starts them from the beginning
+ * again.
+ */
+void
+gst_player_mosaic_stop (GstPlayerMosaic * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_mosaic_stop_internal, gst_object_ref (self),
+      gst_object_unref);
+}
+
+/**
+ * gst_player_mosaic_set_window_handle:
+ * @mosaic: #GstPlayerMosaic instance
+ * @val: handle referencing to the platform specific window
+ *
+ * Sets the platform specific window handle into which the mosaic should
+ * be rendered.
+ */
+void
+gst_player_mosaic_set_window_handle (GstPlayerMosaic * self, gpointer val)
+{
+  g_return_if_fail (GST_IS_PLAYER_MOSAIC (self));
+
+  g_object_set (self, "window-handle", val, NULL);
+}
+
+/**
+ * gst_player_mosaic_get_window_handle:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Returns: (transfer none): The currently set, platform specific window
+ * handle
+ */
+gpointer
+gst_player_mosaic_get_window_handle (GstPlayerMosaic * self)
+{
+  gpointer val;
+
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), NULL);
+
+  g_object_get (self, "window-handle", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_player_mosaic_get_pipeline:
+ * @mosaic: #GstPlayerMosaic instance
+ *
+ * Returns: (transfer full): The internal pipeline
+ */
+GstElement *
+gst_player_mosaic_get_pipeline (GstPlayerMosaic * self)
+{
+  g_return_val_if_fail (GST_IS_PLAYER_MOSAIC (self), NULL);
+
+  return gst_object_ref (self->pipeline);
+}
@@ -0,0 +1,743 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-playlist
+ * @short_description: GStreamer Player Playlist API
+ *
+ * A #GstPlayerPlaylist keeps the URIs to play and the playback order,
+ * including shuffling and repeating. All navigation takes constant time,
+ * independent of the number of entries.
+ *
+ * If created for a #GstPlayer, the entry that follows the current one is
+ * discovered during the last seconds of playback, so that its media info
+ * is known, and cached for local files, before it is played. The entry
+ * itself is not prerolled, its pipeline is only set up once it is passed
+ * to the player.
+ */
+
+#include "gstplayer-playlist.h"
+
+/* Remaining playback time at which the next entry is discovered */
+#define DISCOVER_AHEAD_TIME (10 * GST_SECOND)
+
+enum
+{
+  PROP_0,
+  PROP_PLAYER,
+  PROP_SHUFFLE,
+  PROP_REPEAT_MODE,
+  PROP_LAST
+};
+
+struct _GstPlayerPlaylist
+{
+  GstObject parent;
+
+  GstPlayer *player;
+
+  /* All protected by the object lock */
+  GPtrArray *uris;
+  /* Playback order, the indices of the entries */
+  GArray *order;
+  /* Inverse of order, the playback position of each entry */
+  GArray *positions;
+  /* Playback position of the current entry or -1 */
+  gint current;
+  /* Index of the last entry discovered ahead or -1 */
+  gint discovered;
+
+  gboolean shuffle;
+  GstPlayerPlaylistRepeatMode repeat_mode;
+};
+
+struct _GstPlayerPlaylistClass
+{
+  GstObjectClass parent_class;
+};
+
+#define parent_class gst_player_playlist_parent_class
+G_DEFINE_TYPE (GstPlayerPlaylist, gst_player_playlist, GST_TYPE_OBJECT);
+
+static GParamSpec *param_specs[PROP_LAST] = { NULL, };
+
+static void gst_player_playlist_dispose (GObject * object);
+static void gst_player_playlist_finalize (GObject * object);
+static void gst_player_playlist_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_player_playlist_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_player_playlist_constructed (GObject * object);
+
+static void
+gst_player_playlist_init (GstPlayerPlaylist * self)
+{
+  self->uris = g_ptr_array_new_with_free_func (g_free);
+  self->order = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->positions = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->current = -1;
+  self->discovered = -1;
+  self->repeat_mode = GST_PLAYER_PLAYLIST_REPEAT_NONE;
+}
+
+static void
+gst_player_playlist_class_init (GstPlayerPlaylistClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_player_playlist_set_property;
+  gobject_class->get_property = gst_player_playlist_get_property;
+  gobject_class->dispose = gst_player_playlist_dispose;
+  gobject_class->finalize = gst_player_playlist_finalize;
+  gobject_class->constructed = gst_player_playlist_constructed;
+
+  param_specs[PROP_PLAYER] =
+      g_param_spec_object ("player", "Player",
+      "Player for which the next entry is discovered ahead", GST_TYPE_PLAYER,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_SHUFFLE] =
+      g_param_spec_boolean ("shuffle", "Shuffle",
+      "Play the entries in random order", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_REPEAT_MODE] =
+      g_param_spec_enum ("repeat-mode", "Repeat mode",
+      "Which entries are repeated", GST_TYPE_PLAYER_PLAYLIST_REPEAT_MODE,
+      GST_PLAYER_PLAYLIST_REPEAT_NONE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
+}
+
+/* Returns the index of the entry to play when the current one ended, or -1
+ * at the end of the playlist. Must be called with the object lock */
+static gint
+get_next_index_locked (GstPlayerPlaylist * self, gboolean repeat_one)
+{
+  guint position;
+
+  if (self->uris->len == 0)
+    return -1;
+
+  if (repeat_one && self->current >= 0
+      && self->repeat_mode == GST_PLAYER_PLAYLIST_REPEAT_ONE)
+    return g_array_index (self->order, guint, self->current);
+
+  position = self->current + 1;
+  if (position >= self->uris->len) {
+    if (self->repeat_mode == GST_PLAYER_PLAYLIST_REPEAT_NONE)
+      return -1;
+    position = 0;
+  }
+
+  return g_array_index (self->order, guint, position);
+}
+
+static void
+position_updated_cb (GstPlayer * player, GstClockTime position,
+    GstPlayerPlaylist * self)
+{
+  GstClockTime duration = gst_player_get_duration (player);
+  gchar *uri = NULL;
+  gint next;
+
+  if (!GST_CLOCK_TIME_IS_VALID (duration) || position + DISCOVER_AHEAD_TIME <
+      duration)
+    return;
+
+  GST_OBJECT_LOCK (self);
+  next = get_next_index_locked (self, TRUE);
+  if (next >= 0 && next != self->discovered && (self->current < 0
+          || next != g_array_index (self->order, guint, self->current))) {
+    self->discovered = next;
+    uri = g_strdup (g_ptr_array_index (self->uris, next));
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (uri) {
+    GST_DEBUG_OBJECT (self, "Discovering %s ahead", uri);
+    gst_player_discover_async (player, uri);
+    g_free (uri);
+  }
+}
+
+static void
+gst_player_playlist_constructed (GObject * object)
+{
+  GstPlayerPlaylist *self = GST_PLAYER_PLAYLIST (object);
+
+  if (self->player)
+    g_signal_connect (self->player, "position-updated",
+        G_CALLBACK (position_updated_cb), self);
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+}
+
+static void
+gst_player_playlist_dispose (GObject * object)
+{
+  GstPlayerPlaylist *self = GST_PLAYER_PLAYLIST (object);
+
+  if (self->player) {
+    g_signal_handlers_disconnect_by_func (self->player, position_updated_cb,
+        self);
+    gst_object_unref (self->player);
+    self->player = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_player_playlist_finalize (GObject * object)
+{
+  GstPlayerPlaylist *self = GST_PLAYER_PLAYLIST (object);
+
+  g_ptr_array_unref (self->uris);
+  g_array_free (self->order, TRUE);
+  g_array_free (self->positions, TRUE);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_player_playlist_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPlayerPlaylist *self = GST_PLAYER_PLAYLIST (object);
+
+  switch (prop_id) {
+    case PROP_PLAYER:
+      self->player = g_value_dup_object (value);
+      break;
+    case PROP_SHUFFLE:
+      gst_player_playlist_set_shuffle (self, g_value_get_boolean (value));
+      break;
+    case PROP_REPEAT_MODE:
+      GST_OBJECT_LOCK (self);
+      self->repeat_mode = g_value_get_enum (value);
+      self->discovered = -1;
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_player_playlist_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPlayerPlaylist *self = GST_PLAYER_PLAYLIST (object);
+
+  switch (prop_id) {
+    case PROP_PLAYER:
+      g_value_set_object (value, self->player);
+      break;
+    case PROP_SHUFFLE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->shuffle);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_REPEAT_MODE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_enum (value, self->repeat_mode);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/**
+ * gst_player_playlist_new:
+ * @player: (allow-none): #GstPlayer to discover entries for, or %NULL
+ *
+ * Creates a new, empty playlist. If @player is given, the entry after the
+ * current one is discovered with gst_player_discover_async() shortly before
+ * the current one ends, so that its #GstPlayerMediaInfo is known before
+ * it is played. The entry is not prerolled.
+ *
+ * Returns: a new #GstPlayerPlaylist instance
+ */
+GstPlayerPlaylist *
+gst_player_playlist_new (GstPlayer * player)
+{
+  g_return_val_if_fail (player == NULL || GST_IS_PLAYER (player), NULL);
+
+  return g_object_new (GST_TYPE_PLAYER_PLAYLIST, "player", player, NULL);
+}
+
+static void
+set_position_locked (GstPlayerPlaylist * self, guint position, guint index)
+{
+  g_array_index (self->order, guint, position) = index;
+  g_array_index (self->positions, guint, index) = position;
+}
+
+/**
+ * gst_player_playlist_add_uri:
+ * @playlist: #GstPlayerPlaylist instance
+ * @uri: URI to add
+ *
+ * Appends @uri to the playlist. If the playlist is shuffled, @uri is put
+ * at a random position among the entries that were not played yet.
+ */
+void
+gst_player_playlist_add_uri (GstPlayerPlaylist * self, const gchar * uri)
+{
+  guint index, position;
+
+  g_return_if_fail (GST_IS_PLAYER_PLAYLIST (self));
+  g_return_if_fail (uri != NULL);
+
+  GST_OBJECT_LOCK (self);
+  index = self->uris->len;
+  g_ptr_array_add (self->uris, g_strdup (uri));
+  g_array_set_size (self->order, index + 1);
+  g_array_set_size (self->positions, index + 1);
+
+  /* One step of an inside-out Fisher-Yates shuffle */
+  position = index;
+  if (self->shuffle)
+    position = g_random_int_range (self->current + 1, index + 1);
+  if (position != index)
+    set_position_locked (self, index, g_array_index (self->order, guint,
+            position));
+  set_position_locked (self, position, index);
+
+  self->discovered = -1;
+  GST_OBJECT_UNLOCK (self);
+}
+
+/**
+ * gst_player_playlist_clear:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Removes all entries.
+ */
+void
+gst_player_playlist_clear (GstPlayerPlaylist * self)
+{
+  g_return_if_fail (GST_IS_PLAYER_PLAYLIST (self));
+
+  GST_OBJECT_LOCK (self);
+  g_ptr_array_set_size (self->uris, 0);
+  g_array_set_size (self->order, 0);
+  g_array_set_size (self->positions, 0);
+  self->current = -1;
+  self->discovered = -1;
+  GST_OBJECT_UNLOCK (self);
+}
+
+/**
+ * gst_player_playlist_get_length:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Returns: the number of entries.
+ */
+guint
+gst_player_playlist_get_length (GstPlayerPlaylist * self)
+{
+  guint len;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), 0);
+
+  GST_OBJECT_LOCK (self);
+  len = self->uris->len;
+  GST_OBJECT_UNLOCK (self);
+
+  return len;
+}
+
+/**
+ * gst_player_playlist_get_uri:
+ * @playlist: #GstPlayerPlaylist instance
+ * @index: index of the entry, in the order the entries were added
+ *
+ * Returns: (transfer full): the URI of the entry, or %NULL if @index is out
+ *   of range. g_free() after usage.
+ */
+gchar *
+gst_player_playlist_get_uri (GstPlayerPlaylist * self, guint index)
+{
+  gchar *uri = NULL;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), NULL);
+
+  GST_OBJECT_LOCK (self);
+  if (index < self->uris->len)
+    uri = g_strdup (g_ptr_array_index (self->uris, index));
+  GST_OBJECT_UNLOCK (self);
+
+  return uri;
+}
+
+/**
+ * gst_player_playlist_get_current_index:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Returns: the index of the current entry, in the order the entries were
+ *   added, or -1 if no entry was played yet.
+ */
+gint
+gst_player_playlist_get_current_index (GstPlayerPlaylist * self)
+{
+  gint index = -1;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), -1);
+
+  GST_OBJECT_LOCK (self);
+  if (self->current >= 0)
+    index = g_array_index (self->order, guint, self->current);
+  GST_OBJECT_UNLOCK (self);
+
+  return index;
+}
+
+/* Must be called with the object lock */
+static gchar *
+set_current_locked (GstPlayerPlaylist * self, gint index)
+{
+  if (index < 0)
+    return NULL;
+
+  self->current = g_array_index (self->positions, guint, index);
+
+  return g_strdup (g_ptr_array_index (self->uris, index));
+}
+
+/**
+ * gst_player_playlist_set_current_index:
+ * @playlist: #GstPlayerPlaylist instance
+ * @index: index of the entry, in the order the entries were added
+ *
+ * Makes the entry at @index the current one, for example when it was
+ * selected by the user. Navigation continues from it.
+ *
+ * Returns: (transfer full): the URI of the entry, or %NULL if @index is out
+ *   of range. g_free() after usage.
+ */
+gchar *
+gst_player_playlist_set_current_index (GstPlayerPlaylist * self, guint index)
+{
+  gchar *uri = NULL;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), NULL);
+
+  GST_OBJECT_LOCK (self);
+  if (index < self->uris->len)
+    uri = set_current_locked (self, index);
+  GST_OBJECT_UNLOCK (self);
+
+  return uri;
+}
+
+/**
+ * gst_player_playlist_get_current_uri:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Returns: (transfer full): the URI of the current entry, or %NULL if no
+ *   entry was played yet. g_free() after usage.
+ */
+gchar *
+gst_player_playlist_get_current_uri (GstPlayerPlaylist * self)
+{
+  gchar *uri = NULL;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), NULL);
+
+  GST_OBJECT_LOCK (self);
+  if (self->current >= 0)
+    uri = g_strdup (g_ptr_array_index (self->uris,
+            g_array_index (self->order, guint, self->current)));
+  GST_OBJECT_UNLOCK (self);
+
+  return uri;
+}
+
+/**
+ * gst_player_playlist_next:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Moves to the entry after the current one in playback order, for example
+ * when the user skips the current one. After the last entry this wraps
+ * around to the first one unless the repeat mode is
+ * %GST_PLAYER_PLAYLIST_REPEAT_NONE.
+ *
+ * Returns: (transfer full): the URI of the new current entry, or %NULL at
+ *   the end of the playlist. g_free() after usage.
+ */
+gchar *
+gst_player_playlist_next (GstPlayerPlaylist * self)
+{
+  gchar *uri;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), NULL);
+
+  GST_OBJECT_LOCK (self);
+  uri = set_current_locked (self, get_next_index_locked (self, FALSE));
+  GST_OBJECT_UNLOCK (self);
+
+  return uri;
+}
+
+/**
+ * gst_player_playlist_advance:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Moves to the entry to play after the current one ended. This is the
+ * same as gst_player_playlist_next() except that the current entry is
+ * repeated in %GST_PLAYER_PLAYLIST_REPEAT_ONE mode.
+ *
+ * Returns: (transfer full): the URI of the new current entry, or %NULL at
+ *   the end of the playlist. g_free() after usage.
+ */
+gchar *
+gst_player_playlist_advance (GstPlayerPlaylist * self)
+{
+  gchar *uri;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), NULL);
+
+  GST_OBJECT_LOCK (self);
+  uri = set_current_locked (self, get_next_index_locked (self, TRUE));
+  GST_OBJECT_UNLOCK (self);
+
+  return uri;
+}
+
+/**
+ * gst_player_playlist_previous:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Moves to the entry before the current one in playback order. Before the
+ * first entry this wraps around to the last one unless the repeat mode is
+ * %GST_PLAYER_PLAYLIST_REPEAT_NONE.
+ *
+ * Returns: (transfer full): the URI of the new current entry, or %NULL at
+ *   the beginning of the playlist. g_free() after usage.
+ */
+gchar *
+gst_player_playlist_previous (GstPlayerPlaylist * self)
+{
+  gchar *uri = NULL;
+  gint position;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), NULL);
+
+  GST_OBJECT_LOCK (self);
+  position = self->current - 1;
+  if (position < 0 && self->repeat_mode != GST_PLAYER_PLAYLIST_REPEAT_NONE)
+    position = self->uris->len - 1;
+  if (position >= 0)
+    uri = set_current_locked (self, g_array_index (self->order, guint,
+            position));
+  GST_OBJECT_UNLOCK (self);
+
+  return uri;
+}
+
+/**
+ * gst_player_playlist_has_next:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Returns: %TRUE if gst_player_playlist_next() would move to another
+ *   entry, taking shuffling and the repeat mode into account.
+ */
+gboolean
+gst_player_playlist_has_next (GstPlayerPlaylist * self)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), FALSE);
+
+  GST_OBJECT_LOCK (self);
+  ret = get_next_index_locked (self, FALSE) >= 0;
+  GST_OBJECT_UNLOCK (self);
+
+  return ret;
+}
+
+/**
+ * gst_player_playlist_has_previous:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Returns: %TRUE if gst_player_playlist_previous() would move to another
+ *   entry, taking shuffling and the repeat mode into account.
+ */
+gboolean
+gst_player_playlist_has_previous (GstPlayerPlaylist * self)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), FALSE);
+
+  GST_OBJECT_LOCK (self);
+  ret = self->uris->len > 0 && (self->current > 0
+      || self->repeat_mode != GST_PLAYER_PLAYLIST_REPEAT_NONE);
+  GST_OBJECT_UNLOCK (self);
+
+  return ret;
+}
+
+/**
+ * gst_player_playlist_set_shuffle:
+ * @playlist: #GstPlayerPlaylist instance
+ * @shuffle: TRUE or FALSE
+ *
+ * Enables or disables playing the entries in random order. When enabled,
+ * all entries are shuffled uniformly and the current entry becomes the
+ * first one, so that every other entry is played once before the playlist
+ * ends or repeats. When disabled, playback continues in the order the
+ * entries were added from the current entry.
+ */
+void
+gst_player_playlist_set_shuffle (GstPlayerPlaylist * self, gboolean shuffle)
+{
+  guint i, j, tmp, len;
+  gint index;
+
+  g_return_if_fail (GST_IS_PLAYER_PLAYLIST (self));
+
+  GST_OBJECT_LOCK (self);
+  shuffle = shuffle ? TRUE : FALSE;
+  if (self->shuffle == shuffle) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+
+  self->shuffle = shuffle;
+  len = self->uris->len;
+  index = self->current >= 0 ?
+      (gint) g_array_index (self->order, guint, self->current) : -1;
+
+  for (i = 0; i < len; i++)
+    g_array_index (self->order, guint, i) = i;
+
+  if (shuffle) {
+    /* Fisher-Yates, every permutation is equally likely */
+    for (i = len; i > 1; i--) {
+      j = g_random_int_range (0, i);
+      tmp = g_array_index (self->order, guint, i - 1);
+      g_array_index (self->order, guint, i - 1) =
+          g_array_index (self->order, guint, j);
+      g_array_index (self->order, guint, j) = tmp;
+    }
+  }
+
+  for (i = 0; i < len; i++)
+    g_array_index (self->positions, guint, g_array_index (self->order,
+            guint, i)) = i;
+
+  if (shuffle && index >= 0) {
+    guint position = g_array_index (self->positions, guint, index);
+
+    set_position_locked (self, position, g_array_index (self->order, guint,
+            0));
+    set_position_locked (self, 0, index);
+  }
+
+  self->current =
+      index >= 0 ? (gint) g_array_index (self->positions, guint, index) : -1;
+  self->discovered = -1;
+  GST_OBJECT_UNLOCK (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_SHUFFLE]);
+}
+
+/**
+ * gst_player_playlist_get_shuffle:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Returns: %TRUE if the entries are played in random order.
+ */
+gboolean
+gst_player_playlist_get_shuffle (GstPlayerPlaylist * self)
+{
+  gboolean shuffle;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self), FALSE);
+
+  g_object_get (self, "shuffle", &shuffle, NULL);
+
+  return shuffle;
+}
+
+/**
+ * gst_player_playlist_set_repeat_mode:
+ * @playlist: #GstPlayerPlaylist instance
+ * @mode: the #GstPlayerPlaylistRepeatMode
+ *
+ * Sets which entries are repeated.
+ */
+void
+gst_player_playlist_set_repeat_mode (GstPlayerPlaylist * self,
+    GstPlayerPlaylistRepeatMode mode)
+{
+  g_return_if_fail (GST_IS_PLAYER_PLAYLIST (self));
+
+  g_object_set (self, "repeat-mode", mode, NULL);
+}
+
+/**
+ * gst_player_playlist_get_repeat_mode:
+ * @playlist: #GstPlayerPlaylist instance
+ *
+ * Returns: the current #GstPlayerPlaylistRepeatMode.
+ */
+GstPlayerPlaylistRepeatMode
+gst_player_playlist_get_repeat_mode (GstPlayerPlaylist * self)
+{
+  GstPlayerPlaylistRepeatMode mode;
+
+  g_return_val_if_fail (GST_IS_PLAYER_PLAYLIST (self),
+      GST_PLAYER_PLAYLIST_REPEAT_NONE);
+
+  g_object_get (self, "repeat-mode", &mode, NULL);
+
+  return mode;
+}
+
+#define C_ENUM(v) ((gint) v)
+
+GType
+gst_player_playlist_repeat_mode_get_type (void)
+{
+  static gsize id = 0;
+  static const GEnumValue values[] = {
+    {C_ENUM (GST_PLAYER_PLAYLIST_REPEAT_NONE),
+        "GST_PLAYER_PLAYLIST_REPEAT_NONE", "none"},
+    {C_ENUM (GST_PLAYER_PLAYLIST_REPEAT_ALL),
+        "GST_PLAYER_PLAYLIST_REPEAT_ALL", "all"},
+    {C_ENUM (GST_PLAYER_PLAYLIST_REPEAT_ONE),
+        "GST_PLAYER_PLAYLIST_REPEAT_ONE", "one"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&id)) {
+    GType tmp =
+        g_enum_register_static ("GstPlayerPlaylistRepeatMode", values);
+    g_once_init_leave (&id, tmp);
+  }
+
+  return (GType) id;
+}
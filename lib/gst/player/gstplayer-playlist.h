@@ -0,0 +1,82 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_PLAYLIST_H__
+#define __GST_PLAYER_PLAYLIST_H__
+
+#include <gst/gst.h>
+#include <gst/player/gstplayer.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GST_PLAYER_PLAYLIST_REPEAT_NONE,
+  GST_PLAYER_PLAYLIST_REPEAT_ALL,
+  GST_PLAYER_PLAYLIST_REPEAT_ONE
+} GstPlayerPlaylistRepeatMode;
+
+GType        gst_player_playlist_repeat_mode_get_type (void);
+#define      GST_TYPE_PLAYER_PLAYLIST_REPEAT_MODE     (gst_player_playlist_repeat_mode_get_type ())
+
+typedef struct _GstPlayerPlaylist GstPlayerPlaylist;
+typedef struct _GstPlayerPlaylistClass GstPlayerPlaylistClass;
+
+#define GST_TYPE_PLAYER_PLAYLIST             (gst_player_playlist_get_type ())
+#define GST_IS_PLAYER_PLAYLIST(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_PLAYLIST))
+#define GST_IS_PLAYER_PLAYLIST_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_PLAYER_PLAYLIST))
+#define GST_PLAYER_PLAYLIST_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_PLAYER_PLAYLIST, GstPlayerPlaylistClass))
+#define GST_PLAYER_PLAYLIST(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_PLAYLIST, GstPlayerPlaylist))
+#define GST_PLAYER_PLAYLIST_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_PLAYER_PLAYLIST, GstPlayerPlaylistClass))
+#define GST_PLAYER_PLAYLIST_CAST(obj)        ((GstPlayerPlaylist*)(obj))
+
+GType        gst_player_playlist_get_type             (void);
+
+GstPlayerPlaylist *
+             gst_player_playlist_new                  (GstPlayer    * player);
+
+void         gst_player_playlist_add_uri              (GstPlayerPlaylist * playlist,
+                                                       const gchar * uri);
+void         gst_player_playlist_clear                (GstPlayerPlaylist * playlist);
+guint        gst_player_playlist_get_length           (GstPlayerPlaylist * playlist);
+gchar *      gst_player_playlist_get_uri              (GstPlayerPlaylist * playlist,
+                                                       guint index);
+
+gint         gst_player_playlist_get_current_index    (GstPlayerPlaylist * playlist);
+gchar *      gst_player_playlist_set_current_index    (GstPlayerPlaylist * playlist,
+                                                       guint index);
+gchar *      gst_player_playlist_get_current_uri      (GstPlayerPlaylist * playlist);
+
+gchar *      gst_player_playlist_next                 (GstPlayerPlaylist * playlist);
+gchar *      gst_player_playlist_previous             (GstPlayerPlaylist * playlist);
+gchar *      gst_player_playlist_advance              (GstPlayerPlaylist * playlist);
+gboolean     gst_player_playlist_has_next             (GstPlayerPlaylist * playlist);
+gboolean     gst_player_playlist_has_previous         (GstPlayerPlaylist * playlist);
+
+void         gst_player_playlist_set_shuffle          (GstPlayerPlaylist * playlist,
+                                                       gboolean shuffle);
+gboolean     gst_player_playlist_get_shuffle          (GstPlayerPlaylist * playlist);
+
+void         gst_player_playlist_set_repeat_mode      (GstPlayerPlaylist * playlist,
+                                                       GstPlayerPlaylistRepeatMode mode);
+GstPlayerPlaylistRepeatMode
+             gst_player_playlist_get_repeat_mode      (GstPlayerPlaylist * playlist);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_PLAYLIST_H__ */
@@ -0,0 +1,325 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Messages are a header followed by the payload on a local stream socket.
+ * File descriptors are passed along with the first byte of a message. */
+
+#include "gstplayer-remote-protocol.h"
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <glib/gstdio.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+
+/* Not in the headers of older C libraries */
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_GET_SEALS 1034
+#endif
+#ifndef F_SEAL_SHRINK
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifndef MSG_CMSG_CLOEXEC
+#define MSG_CMSG_CLOEXEC 0
+#endif
+
+/* Sends a message with @payload and @data following the header, and
+ * @pass_fd unless it is -1. Blocks until everything is sent */
+gboolean
+gst_player_remote_send (gint fd, GstPlayerRemoteMessageType type,
+    guint stream, guint epoch, gconstpointer payload, gsize payload_size,
+    gconstpointer data, gsize data_size, gint pass_fd)
+{
+  GstPlayerRemoteHeader header;
+  struct iovec iov[3], *vec = iov;
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  union
+  {
+    struct cmsghdr align;
+    gchar buf[CMSG_SPACE (sizeof (gint))];
+  } control;
+  gsize left;
+  gssize n;
+
+  if (payload_size > GST_PLAYER_REMOTE_MAX_SIZE
+      || data_size > GST_PLAYER_REMOTE_MAX_SIZE - payload_size)
+    return FALSE;
+
+  header.type = type;
+  header.stream = stream;
+  header.epoch = epoch;
+  header.size = payload_size + data_size;
+
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof (header);
+  iov[1].iov_base = (gpointer) payload;
+  iov[1].iov_len = payload_size;
+  iov[2].iov_base = (gpointer) data;
+  iov[2].iov_len = data_size;
+  left = sizeof (header) + payload_size + data_size;
+
+  memset (&msg, 0, sizeof (msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = G_N_ELEMENTS (iov);
+
+  if (pass_fd >= 0) {
+    memset (&control, 0, sizeof (control));
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+    cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (gint));
+    memcpy (CMSG_DATA (cmsg), &pass_fd, sizeof (gint));
+  }
+
+  while (left > 0) {
+    n = sendmsg (fd, &msg, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return FALSE;
+    }
+
+    /* The descriptor went along with the first bytes */
+    msg.msg_control = NULL;
+    msg.msg_controllen = 0;
+
+    left -= n;
+    while (msg.msg_iovlen > 0 && (gsize) n >= vec->iov_len) {
+      n -= vec->iov_len;
+      vec++;
+      msg.msg_iovlen--;
+    }
+    if (msg.msg_iovlen > 0) {
+      vec->iov_base = (guint8 *) vec->iov_base + n;
+      vec->iov_len -= n;
+    }
+    msg.msg_iov = vec;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+read_all (gint fd, gpointer data, gsize size)
+{
+  gssize n;
+
+  while (size > 0) {
+    n = read (fd, data, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return FALSE;
+    data = (guint8 *) data + n;
+    size -= n;
+  }
+
+  return TRUE;
+}
+
+/* Receives the next message into @header and @payload, which is
+ * NUL-terminated and freed with g_free(). Descriptors passed with it are
+ * returned in @passed_fd, or closed if it is NULL. Returns FALSE once the
+ * other side is gone or sent a message larger than
+ * GST_PLAYER_REMOTE_MAX_SIZE */
+gboolean
+gst_player_remote_receive (gint fd, GstPlayerRemoteHeader * header,
+    guint8 ** payload, gint * passed_fd)
+{
+  struct iovec iov;
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  union
+  {
+    struct cmsghdr align;
+    gchar buf[CMSG_SPACE (sizeof (gint))];
+  } control;
+  gsize received = 0;
+  gint received_fd = -1, new_fd;
+  gssize n;
+
+  while (received < sizeof (*header)) {
+    iov.iov_base = (guint8 *) header + received;
+    iov.iov_len = sizeof (*header) - received;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+    n = recvmsg (fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      goto failed;
+
+    for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+          || cmsg->cmsg_len != CMSG_LEN (sizeof (gint)))
+        continue;
+      memcpy (&new_fd, CMSG_DATA (cmsg), sizeof (gint));
+      if (received_fd >= 0)
+        close (received_fd);
+      received_fd = new_fd;
+    }
+
+    received += n;
+  }
+
+  if (header->size > GST_PLAYER_REMOTE_MAX_SIZE)
+    goto failed;
+
+  *payload = g_malloc ((gsize) header->size + 1);
+  if (!read_all (fd, *payload, header->size)) {
+    g_free (*payload);
+    *payload = NULL;
+    goto failed;
+  }
+  (*payload)[header->size] = '\0';
+
+  if (passed_fd)
+    *passed_fd = received_fd;
+  else if (received_fd >= 0)
+    close (received_fd);
+
+  return TRUE;
+
+failed:
+  if (received_fd >= 0)
+    close (received_fd);
+
+  return FALSE;
+}
+
+/* Returns whether the payload of @header is large enough for the
+ * structure its type starts with */
+gboolean
+gst_player_remote_payload_is_valid (const GstPlayerRemoteHeader * header)
+{
+  gsize size;
+
+  switch (header->type) {
+    case GST_PLAYER_REMOTE_STREAM:
+      size = sizeof (GstPlayerRemoteStream);
+      break;
+    case GST_PLAYER_REMOTE_SEGMENT:
+      size = sizeof (GstSegment);
+      break;
+    case GST_PLAYER_REMOTE_TAGS:
+      size = sizeof (GstPlayerRemoteTags);
+      break;
+    case GST_PLAYER_REMOTE_BUFFER:
+      size = sizeof (GstPlayerRemoteBuffer);
+      break;
+    case GST_PLAYER_REMOTE_DURATION:
+      size = sizeof (GstPlayerRemoteDuration);
+      break;
+    case GST_PLAYER_REMOTE_SEEK:
+      size = sizeof (GstPlayerRemoteSeek);
+      break;
+    case GST_PLAYER_REMOTE_RELEASE:
+      size = sizeof (GstPlayerRemoteRelease);
+      break;
+    default:
+      size = 0;
+      break;
+  }
+
+  return header->size >= size;
+}
+
+/* Creates the shared memory of a ring of @size bytes, returns its
+ * descriptor or -1. Its size is sealed where possible */
+gint
+gst_player_remote_ring_new (gsize size)
+{
+  gchar *path;
+  gint fd = -1;
+
+#ifdef SYS_memfd_create
+  /* MFD_CLOEXEC | MFD_ALLOW_SEALING */
+  fd = syscall (SYS_memfd_create, "gst-player-ring", 1U | 2U);
+#endif
+
+  /* Anonymous files are not available everywhere, an unlinked temporary
+   * file works the same */
+  if (fd < 0) {
+    fd = g_file_open_tmp ("gst-player-ring-XXXXXX", &path, NULL);
+    if (fd < 0)
+      return -1;
+    g_unlink (path);
+    g_free (path);
+  }
+
+  if (ftruncate (fd, size) < 0) {
+    close (fd);
+    return -1;
+  }
+
+#ifdef __linux__
+  /* Temporary files can not be sealed, the player checks the size then */
+  fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW);
+#endif
+
+  return fd;
+}
+
+/* Checks that the shared memory behind @fd holds a ring of @size bytes
+ * and can not shrink below that while it is mapped */
+gboolean
+gst_player_remote_ring_check (gint fd, guint64 size)
+{
+  struct stat st;
+#ifdef __linux__
+  gint seals;
+#endif
+
+  if (size == 0 || size > G_MAXSIZE)
+    return FALSE;
+
+  if (fstat (fd, &st) < 0 || st.st_size < 0 || (guint64) st.st_size < size)
+    return FALSE;
+
+#ifdef __linux__
+  /* Fails for files that do not support sealing */
+  seals = fcntl (fd, F_GET_SEALS);
+  if (seals >= 0 && (seals & (F_SEAL_SHRINK | F_SEAL_GROW)) !=
+      (F_SEAL_SHRINK | F_SEAL_GROW))
+    return FALSE;
+#endif
+
+  return TRUE;
+}
+#endif
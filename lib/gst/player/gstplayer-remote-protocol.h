@@ -0,0 +1,129 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_REMOTE_PROTOCOL_H__
+#define __GST_PLAYER_REMOTE_PROTOCOL_H__
+
+#include <gst/gst.h>
+
+/* Messages between the remote decoding source of a player and its helper
+ * process. Both are built from the same sources, so the structures are
+ * sent as they are */
+
+/* File descriptor of the socket to the player in the helper */
+#define GST_PLAYER_REMOTE_FD 3
+
+/* Larger messages are refused, bigger buffers go through the ring */
+#define GST_PLAYER_REMOTE_MAX_SIZE (64 * 1024 * 1024)
+
+typedef enum
+{
+  /* Helper to player */
+  GST_PLAYER_REMOTE_STREAM = 1,       /* GstPlayerRemoteStream, caps, ring */
+  GST_PLAYER_REMOTE_NO_MORE_STREAMS,
+  GST_PLAYER_REMOTE_CAPS,             /* caps */
+  GST_PLAYER_REMOTE_SEGMENT,          /* GstSegment */
+  GST_PLAYER_REMOTE_TAGS,             /* GstPlayerRemoteTags, tag list */
+  GST_PLAYER_REMOTE_BUFFER,           /* GstPlayerRemoteBuffer, inline data */
+  GST_PLAYER_REMOTE_EOS,
+  GST_PLAYER_REMOTE_DURATION,         /* GstPlayerRemoteDuration */
+  GST_PLAYER_REMOTE_ERROR,            /* structure describing the error */
+
+  /* Player to helper */
+  GST_PLAYER_REMOTE_SEEK,             /* GstPlayerRemoteSeek */
+  GST_PLAYER_REMOTE_RELEASE           /* GstPlayerRemoteRelease */
+} GstPlayerRemoteMessageType;
+
+typedef struct
+{
+  guint32 type;
+  guint32 stream;
+  /* Increased by every flushing seek, older data is dropped */
+  guint32 epoch;
+  /* Size of everything following the header */
+  guint32 size;
+} GstPlayerRemoteHeader;
+
+typedef struct
+{
+  guint64 ring_size;
+} GstPlayerRemoteStream;
+
+/* Buffers are in the ring of the stream, unless they do not fit and
+ * follow the message */
+#define GST_PLAYER_REMOTE_INLINE G_MAXUINT64
+
+typedef struct
+{
+  guint64 offset;
+  guint64 size;
+  guint64 pts;
+  guint64 dts;
+  guint64 duration;
+  guint32 flags;
+  /* Monotonic time the helper sent the buffer at */
+  gint64 sent_time;
+} GstPlayerRemoteBuffer;
+
+typedef struct
+{
+  gint32 scope;
+} GstPlayerRemoteTags;
+
+typedef struct
+{
+  gint64 duration;
+  gint32 seekable;
+} GstPlayerRemoteDuration;
+
+typedef struct
+{
+  gdouble rate;
+  gint32 format;
+  gint32 flags;
+  gint32 start_type;
+  gint32 stop_type;
+  gint64 start;
+  gint64 stop;
+} GstPlayerRemoteSeek;
+
+typedef struct
+{
+  guint64 offset;
+  guint64 size;
+} GstPlayerRemoteRelease;
+
+G_GNUC_INTERNAL gboolean gst_player_remote_send (gint fd,
+                                                 GstPlayerRemoteMessageType type,
+                                                 guint stream,
+                                                 guint epoch,
+                                                 gconstpointer payload,
+                                                 gsize payload_size,
+                                                 gconstpointer data,
+                                                 gsize data_size,
+                                                 gint pass_fd);
+G_GNUC_INTERNAL gboolean gst_player_remote_receive (gint fd,
+                                                    GstPlayerRemoteHeader *header,
+                                                    guint8 **payload,
+                                                    gint *passed_fd);
+G_GNUC_INTERNAL gboolean gst_player_remote_payload_is_valid (const GstPlayerRemoteHeader *header);
+G_GNUC_INTERNAL gint     gst_player_remote_ring_new (gsize size);
+G_GNUC_INTERNAL gboolean gst_player_remote_ring_check (gint fd,
+                                                       guint64 size);
+
+#endif /* __GST_PLAYER_REMOTE_PROTOCOL_H__ */
@@ -0,0 +1,1180 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Source that decodes media in a separate process.
+ *
+ * Demuxers and decoders run in gst-player-helper, so a crash in them only
+ * ends that process and the player gets an error instead of going down
+ * with it. The player keeps its own sinks, clock and window, playbin
+ * passes the raw streams of the source directly to them.
+ *
+ * The helper writes the decoded data into a ring in shared memory for
+ * every stream. Buffers here wrap the ring without copying and hand the
+ * space back to the helper once they are freed. Everything else goes over
+ * a local socket, see gstplayer-remote-protocol.h. Seeks are passed on to
+ * the helper, data of before a seek is recognized by its epoch and
+ * dropped. */
+
+#include "gstplayer-remote-src-private.h"
+
+#ifdef G_OS_UNIX
+#include "gstplayer-remote-protocol.h"
+
+#include <gio/gio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#define REMOTE_PROTOCOL "gstplayer-remote"
+/* Overrides the installed helper, for running uninstalled */
+#define REMOTE_HELPER_ENV "GST_PLAYER_HELPER"
+/* Streams the helper may announce */
+#define REMOTE_MAX_STREAMS 64
+#ifndef GST_PLAYER_HELPER_PATH
+#define GST_PLAYER_HELPER_PATH "gst-player-helper"
+#endif
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_remote_src_debug);
+#define GST_CAT_DEFAULT gst_player_remote_src_debug
+
+/* Socket to the helper, kept until the last buffer of it is gone */
+typedef struct
+{
+  gint refcount;
+  GMutex lock;
+  /* Protected by lock, -1 once closed */
+  gint fd;
+} Connection;
+
+typedef struct
+{
+  gint refcount;
+  Connection *connection;
+  guint stream;
+  guint8 *data;
+  gsize size;
+} Ring;
+
+typedef struct
+{
+  Ring *ring;
+  guint64 offset;
+} RingSpace;
+
+static Connection *
+connection_ref (Connection * connection)
+{
+  g_atomic_int_inc (&connection->refcount);
+
+  return connection;
+}
+
+static void
+connection_unref (Connection * connection)
+{
+  if (g_atomic_int_dec_and_test (&connection->refcount)) {
+    if (connection->fd >= 0)
+      close (connection->fd);
+    g_mutex_clear (&connection->lock);
+    g_free (connection);
+  }
+}
+
+static gboolean
+connection_send (Connection * connection, GstPlayerRemoteMessageType type,
+    guint stream, guint epoch, gconstpointer payload, gsize payload_size)
+{
+  gboolean ret = FALSE;
+
+  g_mutex_lock (&connection->lock);
+  if (connection->fd >= 0)
+    ret = gst_player_remote_send (connection->fd, type, stream, epoch,
+        payload, payload_size, NULL, 0, -1);
+  g_mutex_unlock (&connection->lock);
+
+  return ret;
+}
+
+static Ring *
+ring_ref (Ring * ring)
+{
+  g_atomic_int_inc (&ring->refcount);
+
+  return ring;
+}
+
+static void
+ring_unref (Ring * ring)
+{
+  if (g_atomic_int_dec_and_test (&ring->refcount)) {
+    munmap (ring->data, ring->size);
+    connection_unref (ring->connection);
+    g_free (ring);
+  }
+}
+
+/* Hands the space of a buffer back to the helper */
+static void
+ring_space_free (RingSpace * space)
+{
+  GstPlayerRemoteRelease msg;
+
+  msg.offset = space->offset;
+  msg.size = 0;
+  connection_send (space->ring->connection, GST_PLAYER_REMOTE_RELEASE,
+      space->ring->stream, 0, &msg, sizeof (msg));
+
+  ring_unref (space->ring);
+  g_slice_free (RingSpace, space);
+}
+
+#define GST_TYPE_PLAYER_REMOTE_SRC (gst_player_remote_src_get_type ())
+#define GST_PLAYER_REMOTE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_REMOTE_SRC, GstPlayerRemoteSrc))
+#define GST_IS_PLAYER_REMOTE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_REMOTE_SRC))
+
+typedef struct _GstPlayerRemoteSrc GstPlayerRemoteSrc;
+
+typedef struct
+{
+  GstPlayerRemoteSrc *src;
+  GstPad *pad;
+  Ring *ring;
+  /* Protected by the lock of src */
+  GQueue items;
+  GstCaps *caps;
+} SrcStream;
+
+struct _GstPlayerRemoteSrc
+{
+  GstElement parent;
+
+  /* Protected by object lock */
+  gchar *uri;
+  GstClockTime transport_latency;
+
+  /* Only accessed from state changes */
+  GSubprocess *helper;
+  GThread *reader;
+
+  /* Serializes seeks from the pads */
+  GMutex seek_lock;
+
+  GMutex lock;
+  GCond cond;
+  /* Protected by lock */
+  Connection *connection;
+  GPtrArray *streams;
+  guint group_id;
+  gboolean flushing;
+  gboolean stopping;
+  guint epoch;
+  gboolean have_seqnum;
+  guint32 seqnum;
+  GstClockTime duration;
+  gboolean seekable;
+};
+
+typedef GstElementClass GstPlayerRemoteSrcClass;
+
+static GstStaticPadTemplate remote_src_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u", GST_PAD_SRC, GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_player_remote_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_GNUC_INTERNAL GType gst_player_remote_src_get_type (void);
+G_DEFINE_TYPE_WITH_CODE (GstPlayerRemoteSrc, gst_player_remote_src,
+    GST_TYPE_ELEMENT, G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_player_remote_src_uri_handler_init));
+
+static SrcStream *
+get_stream_locked (GstPlayerRemoteSrc * src, guint index)
+{
+  if (index >= src->streams->len)
+    return NULL;
+
+  return g_ptr_array_index (src->streams, index);
+}
+
+static void
+gst_player_remote_src_loop (SrcStream * stream)
+{
+  GstPlayerRemoteSrc *src = stream->src;
+  GstMiniObject *item;
+  GstFlowReturn ret;
+  gboolean eos;
+
+  g_mutex_lock (&src->lock);
+  while (!src->flushing && g_queue_is_empty (&stream->items))
+    g_cond_wait (&src->cond, &src->lock);
+  if (src->flushing) {
+    g_mutex_unlock (&src->lock);
+    gst_pad_pause_task (stream->pad);
+    return;
+  }
+  item = g_queue_pop_head (&stream->items);
+  g_mutex_unlock (&src->lock);
+
+  if (GST_IS_EVENT (item)) {
+    eos = GST_EVENT_TYPE (item) == GST_EVENT_EOS;
+    gst_pad_push_event (stream->pad, GST_EVENT_CAST (item));
+    if (eos)
+      gst_pad_pause_task (stream->pad);
+    return;
+  }
+
+  ret = gst_pad_push (stream->pad, GST_BUFFER_CAST (item));
+  if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED)
+    return;
+
+  GST_DEBUG_OBJECT (stream->pad, "Pausing task, reason %s",
+      gst_flow_get_name (ret));
+  gst_pad_pause_task (stream->pad);
+  if (ret < GST_FLOW_EOS) {
+    GST_ELEMENT_ERROR (src, STREAM, FAILED, (NULL),
+        ("Streaming stopped, reason %s", gst_flow_get_name (ret)));
+    gst_pad_push_event (stream->pad, gst_event_new_eos ());
+  }
+}
+
+static gboolean
+gst_player_remote_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstPlayerRemoteSrc *src = GST_PLAYER_REMOTE_SRC (parent);
+  SrcStream *stream = gst_pad_get_element_private (pad);
+  GstCaps *caps, *filter, *tmp;
+  GstClockTime duration;
+  GstFormat format;
+  gboolean seekable;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:
+      g_mutex_lock (&src->lock);
+      caps = stream && stream->caps ? gst_caps_ref (stream->caps) :
+          gst_caps_new_any ();
+      g_mutex_unlock (&src->lock);
+
+      gst_query_parse_caps (query, &filter);
+      if (filter) {
+        tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    case GST_QUERY_DURATION:
+      gst_query_parse_duration (query, &format, NULL);
+      g_mutex_lock (&src->lock);
+      duration = src->duration;
+      g_mutex_unlock (&src->lock);
+      if (format != GST_FORMAT_TIME || !GST_CLOCK_TIME_IS_VALID (duration))
+        return FALSE;
+      gst_query_set_duration (query, format, duration);
+      return TRUE;
+    case GST_QUERY_SEEKING:
+      gst_query_parse_seeking (query, &format, NULL, NULL, NULL);
+      g_mutex_lock (&src->lock);
+      duration = src->duration;
+      seekable = src->seekable;
+      g_mutex_unlock (&src->lock);
+      gst_query_set_seeking (query, format, format == GST_FORMAT_TIME
+          && seekable, 0, GST_CLOCK_TIME_IS_VALID (duration) ? duration : -1);
+      return TRUE;
+    case GST_QUERY_LATENCY:
+      gst_query_set_latency (query, FALSE, 0, GST_CLOCK_TIME_NONE);
+      return TRUE;
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
+static gboolean
+gst_player_remote_src_seek (GstPlayerRemoteSrc * src, GstEvent * event)
+{
+  GstPlayerRemoteSeek msg;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  GstFormat format;
+  GPtrArray *pads;
+  SrcStream *stream;
+  Connection *connection = NULL;
+  GQueue dropped = G_QUEUE_INIT;
+  gpointer item;
+  GstEvent *flush;
+  guint32 seqnum;
+  guint epoch, i;
+
+  gst_event_parse_seek (event, &msg.rate, &format, &flags, &start_type,
+      &msg.start, &stop_type, &msg.stop);
+  seqnum = gst_event_get_seqnum (event);
+
+  /* Flushing is needed to tell data from before the seek apart */
+  if (format != GST_FORMAT_TIME || !(flags & GST_SEEK_FLAG_FLUSH))
+    return FALSE;
+
+  g_mutex_lock (&src->seek_lock);
+  g_mutex_lock (&src->lock);
+  /* Every sink sends the seek of the pipeline upstream */
+  if (src->have_seqnum && src->seqnum == seqnum) {
+    g_mutex_unlock (&src->lock);
+    g_mutex_unlock (&src->seek_lock);
+    return TRUE;
+  }
+  if (src->connection && src->seekable)
+    connection = connection_ref (src->connection);
+  if (!connection) {
+    g_mutex_unlock (&src->lock);
+    g_mutex_unlock (&src->seek_lock);
+    return FALSE;
+  }
+  src->have_seqnum = TRUE;
+  src->seqnum = seqnum;
+  src->flushing = TRUE;
+  g_cond_broadcast (&src->cond);
+
+  pads = g_ptr_array_new_with_free_func (gst_object_unref);
+  for (i = 0; i < src->streams->len; i++) {
+    stream = g_ptr_array_index (src->streams, i);
+    if (stream)
+      g_ptr_array_add (pads, gst_object_ref (stream->pad));
+  }
+  g_mutex_unlock (&src->lock);
+
+  GST_DEBUG_OBJECT (src, "Seeking to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (msg.start));
+
+  for (i = 0; i < pads->len; i++) {
+    flush = gst_event_new_flush_start ();
+    gst_event_set_seqnum (flush, seqnum);
+    gst_pad_push_event (g_ptr_array_index (pads, i), flush);
+  }
+  for (i = 0; i < pads->len; i++)
+    gst_pad_pause_task (g_ptr_array_index (pads, i));
+
+  /* Queued data is from before the seek, the helper gets its ring space
+   * back when the buffers are freed */
+  g_mutex_lock (&src->lock);
+  for (i = 0; i < src->streams->len; i++) {
+    stream = g_ptr_array_index (src->streams, i);
+    while (stream && (item = g_queue_pop_head (&stream->items)))
+      g_queue_push_tail (&dropped, item);
+  }
+  epoch = ++src->epoch;
+  g_mutex_unlock (&src->lock);
+
+  g_queue_foreach (&dropped, (GFunc) gst_mini_object_unref, NULL);
+  g_queue_clear (&dropped);
+
+  msg.format = format;
+  msg.flags = flags;
+  msg.start_type = start_type;
+  msg.stop_type = stop_type;
+  connection_send (connection, GST_PLAYER_REMOTE_SEEK, 0, epoch, &msg,
+      sizeof (msg));
+  connection_unref (connection);
+
+  for (i = 0; i < pads->len; i++) {
+    flush = gst_event_new_flush_stop (TRUE);
+    gst_event_set_seqnum (flush, seqnum);
+    gst_pad_push_event (g_ptr_array_index (pads, i), flush);
+  }
+
+  g_mutex_lock (&src->lock);
+  src->flushing = src->stopping;
+  g_mutex_unlock (&src->lock);
+
+  for (i = 0; i < pads->len; i++) {
+    stream = gst_pad_get_element_private (g_ptr_array_index (pads, i));
+    if (stream)
+      gst_pad_start_task (stream->pad,
+          (GstTaskFunction) gst_player_remote_src_loop, stream, NULL);
+  }
+  g_ptr_array_free (pads, TRUE);
+  g_mutex_unlock (&src->seek_lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_remote_src_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstPlayerRemoteSrc *src = GST_PLAYER_REMOTE_SRC (parent);
+  gboolean res = TRUE;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK)
+    res = gst_player_remote_src_seek (src, event);
+  gst_event_unref (event);
+
+  return res;
+}
+
+/* Called from the reader thread */
+static void
+remote_src_add_stream (GstPlayerRemoteSrc * src, guint index, GstCaps * caps,
+    Ring * ring)
+{
+  SrcStream *stream;
+  GstEvent *event;
+  gchar *name, *stream_id;
+
+  stream = g_new0 (SrcStream, 1);
+  stream->src = src;
+  stream->ring = ring;
+  g_queue_init (&stream->items);
+
+  name = g_strdup_printf ("src_%u", index);
+  stream->pad = gst_pad_new_from_static_template (&remote_src_template, name);
+  g_free (name);
+  gst_pad_set_element_private (stream->pad, stream);
+  gst_pad_set_query_function (stream->pad, gst_player_remote_src_query);
+  gst_pad_set_event_function (stream->pad, gst_player_remote_src_event);
+
+  stream_id = gst_pad_create_stream_id_printf (stream->pad,
+      GST_ELEMENT (src), "%u", index);
+  event = gst_event_new_stream_start (stream_id);
+  g_free (stream_id);
+
+  /* The segment follows from the helper */
+  g_mutex_lock (&src->lock);
+  gst_event_set_group_id (event, src->group_id);
+  g_queue_push_tail (&stream->items, event);
+  if (caps) {
+    stream->caps = gst_caps_ref (caps);
+    g_queue_push_tail (&stream->items, gst_event_new_caps (caps));
+  }
+  if (src->streams->len <= index)
+    g_ptr_array_set_size (src->streams, index + 1);
+  g_ptr_array_index (src->streams, index) = stream;
+  g_mutex_unlock (&src->lock);
+
+  gst_pad_set_active (stream->pad, TRUE);
+  gst_element_add_pad (GST_ELEMENT (src), stream->pad);
+  gst_pad_start_task (stream->pad,
+      (GstTaskFunction) gst_player_remote_src_loop, stream, NULL);
+}
+
+static void
+handle_stream (GstPlayerRemoteSrc * src, Connection * connection,
+    const GstPlayerRemoteHeader * header, guint8 * payload, gint fd)
+{
+  const GstPlayerRemoteStream *msg;
+  GstCaps *caps;
+  Ring *ring;
+  gpointer data;
+  gboolean exists;
+
+  /* Streams are only added from this thread */
+  g_mutex_lock (&src->lock);
+  exists = get_stream_locked (src, header->stream) != NULL;
+  g_mutex_unlock (&src->lock);
+
+  if (fd < 0 || header->stream >= REMOTE_MAX_STREAMS || exists) {
+    GST_WARNING_OBJECT (src, "Invalid stream %u", header->stream);
+    if (fd >= 0)
+      close (fd);
+    return;
+  }
+
+  msg = (const GstPlayerRemoteStream *) payload;
+  if (!gst_player_remote_ring_check (fd, msg->ring_size)) {
+    GST_ELEMENT_ERROR (src, RESOURCE, FAILED, (NULL),
+        ("Invalid ring of stream %u", header->stream));
+    close (fd);
+    return;
+  }
+
+  data = mmap (NULL, msg->ring_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED) {
+    GST_ELEMENT_ERROR (src, RESOURCE, FAILED, (NULL),
+        ("Failed to map ring of stream %u: %s", header->stream,
+            g_strerror (errno)));
+    return;
+  }
+
+  ring = g_new0 (Ring, 1);
+  ring->refcount = 1;
+  ring->connection = connection_ref (connection);
+  ring->stream = header->stream;
+  ring->data = data;
+  ring->size = msg->ring_size;
+
+  caps = gst_caps_from_string ((const gchar *) payload + sizeof (*msg));
+  GST_DEBUG_OBJECT (src, "New stream %u with caps %" GST_PTR_FORMAT,
+      header->stream, caps);
+  remote_src_add_stream (src, header->stream, caps, ring);
+  if (caps)
+    gst_caps_unref (caps);
+}
+
+/* Takes ownership of @payload */
+static GstBuffer *
+make_buffer (SrcStream * stream, const GstPlayerRemoteHeader * header,
+    guint8 * payload)
+{
+  const GstPlayerRemoteBuffer *msg = (const GstPlayerRemoteBuffer *) payload;
+  gboolean in_ring = msg->offset != GST_PLAYER_REMOTE_INLINE;
+  GstBuffer *buffer;
+  RingSpace *space;
+
+  if (in_ring) {
+    if (msg->size > stream->ring->size
+        || msg->offset > stream->ring->size - msg->size) {
+      g_free (payload);
+      return NULL;
+    }
+    space = g_slice_new (RingSpace);
+    space->ring = ring_ref (stream->ring);
+    space->offset = msg->offset;
+    buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        stream->ring->data + msg->offset, msg->size, 0, msg->size, space,
+        (GDestroyNotify) ring_space_free);
+  } else {
+    /* The data follows the message */
+    if (header->size - sizeof (*msg) < msg->size) {
+      g_free (payload);
+      return NULL;
+    }
+    buffer = gst_buffer_new_wrapped_full (0, payload, header->size + 1,
+        sizeof (*msg), msg->size, payload, g_free);
+  }
+
+  GST_BUFFER_PTS (buffer) = msg->pts;
+  GST_BUFFER_DTS (buffer) = msg->dts;
+  GST_BUFFER_DURATION (buffer) = msg->duration;
+  GST_BUFFER_FLAGS (buffer) = msg->flags;
+
+  if (in_ring)
+    g_free (payload);
+
+  return buffer;
+}
+
+static void
+handle_buffer (GstPlayerRemoteSrc * src, const GstPlayerRemoteHeader * header,
+    guint8 * payload)
+{
+  const GstPlayerRemoteBuffer *msg = (const GstPlayerRemoteBuffer *) payload;
+  GstClockTime latency;
+  GstBuffer *buffer;
+  SrcStream *stream;
+
+  latency = MAX (g_get_monotonic_time () - msg->sent_time, 0) * GST_USECOND;
+  GST_OBJECT_LOCK (src);
+  if (GST_CLOCK_TIME_IS_VALID (src->transport_latency))
+    src->transport_latency = (7 * src->transport_latency + latency) / 8;
+  else
+    src->transport_latency = latency;
+  GST_OBJECT_UNLOCK (src);
+
+  /* Streams are only added and removed from this thread and while it is
+   * not running */
+  g_mutex_lock (&src->lock);
+  stream = get_stream_locked (src, header->stream);
+  g_mutex_unlock (&src->lock);
+  if (!stream) {
+    g_free (payload);
+    return;
+  }
+
+  /* Also frees buffers from before the last seek, which hands their
+   * space back */
+  buffer = make_buffer (stream, header, payload);
+  if (!buffer)
+    return;
+
+  g_mutex_lock (&src->lock);
+  if (header->epoch == src->epoch) {
+    g_queue_push_tail (&stream->items, buffer);
+    g_cond_broadcast (&src->cond);
+    buffer = NULL;
+  }
+  g_mutex_unlock (&src->lock);
+
+  if (buffer)
+    gst_buffer_unref (buffer);
+}
+
+static gboolean
+segment_is_valid (const GstSegment * segment)
+{
+  if (segment->format == GST_FORMAT_UNDEFINED
+      || !gst_format_get_details (segment->format))
+    return FALSE;
+
+  /* Also false for NaN */
+  if (!(segment->rate != 0.0 && segment->applied_rate != 0.0))
+    return FALSE;
+
+  return !GST_CLOCK_TIME_IS_VALID (segment->stop)
+      || segment->start <= segment->stop;
+}
+
+static void
+push_event (GstPlayerRemoteSrc * src, const GstPlayerRemoteHeader * header,
+    GstEvent * event, gboolean check_epoch)
+{
+  SrcStream *stream;
+
+  g_mutex_lock (&src->lock);
+  stream = get_stream_locked (src, header->stream);
+  if (stream && (!check_epoch || header->epoch == src->epoch)) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT && src->have_seqnum)
+      gst_event_set_seqnum (event, src->seqnum);
+    g_queue_push_tail (&stream->items, event);
+    g_cond_broadcast (&src->cond);
+    event = NULL;
+  }
+  g_mutex_unlock (&src->lock);
+
+  if (event)
+    gst_event_unref (event);
+}
+
+static void
+handle_caps (GstPlayerRemoteSrc * src, const GstPlayerRemoteHeader * header,
+    const gchar * str)
+{
+  SrcStream *stream;
+  GstCaps *caps;
+
+  caps = gst_caps_from_string (str);
+  if (!caps)
+    return;
+
+  /* Caps persist across seeks, they are never dropped */
+  g_mutex_lock (&src->lock);
+  stream = get_stream_locked (src, header->stream);
+  if (stream && !(stream->caps && gst_caps_is_equal (stream->caps, caps))) {
+    gst_caps_replace (&stream->caps, caps);
+    g_queue_push_tail (&stream->items, gst_event_new_caps (caps));
+    g_cond_broadcast (&src->cond);
+  }
+  g_mutex_unlock (&src->lock);
+
+  gst_caps_unref (caps);
+}
+
+static void
+handle_error (GstPlayerRemoteSrc * src, const gchar * str)
+{
+  GstStructure *s;
+  const gchar *domain = NULL, *message = NULL;
+  gint code = 0;
+  GError *err;
+
+  s = gst_structure_from_string (str, NULL);
+  if (s) {
+    domain = gst_structure_get_string (s, "domain");
+    message = gst_structure_get_string (s, "message");
+    gst_structure_get_int (s, "code", &code);
+  }
+
+  if (domain && message)
+    err = g_error_new_literal (g_quark_from_string (domain), code, message);
+  else
+    err = g_error_new_literal (GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
+        "Decoding failed");
+
+  gst_element_post_message (GST_ELEMENT (src),
+      gst_message_new_error (GST_OBJECT (src), err,
+          s ? gst_structure_get_string (s, "debug") : NULL));
+  g_error_free (err);
+  if (s)
+    gst_structure_free (s);
+}
+
+static gpointer
+gst_player_remote_src_reader (GstPlayerRemoteSrc * src)
+{
+  GstPlayerRemoteHeader header;
+  const GstPlayerRemoteDuration *duration;
+  const GstPlayerRemoteTags *tags;
+  Connection *connection;
+  GstTagList *list;
+  GstSegment segment;
+  GstEvent *event;
+  guint8 *payload;
+  gboolean stopping;
+  gint fd;
+
+  /* The descriptor stays open until this thread is joined */
+  g_mutex_lock (&src->lock);
+  connection = connection_ref (src->connection);
+  g_mutex_unlock (&src->lock);
+
+  while (gst_player_remote_receive (connection->fd, &header, &payload, &fd)) {
+    if (!gst_player_remote_payload_is_valid (&header)) {
+      GST_WARNING_OBJECT (src, "Dropping short message %u of %u bytes",
+          header.type, header.size);
+      if (fd >= 0)
+        close (fd);
+      g_free (payload);
+      continue;
+    }
+
+    switch (header.type) {
+      case GST_PLAYER_REMOTE_STREAM:
+        handle_stream (src, connection, &header, payload, fd);
+        fd = -1;
+        break;
+      case GST_PLAYER_REMOTE_NO_MORE_STREAMS:
+        gst_element_no_more_pads (GST_ELEMENT (src));
+        break;
+      case GST_PLAYER_REMOTE_CAPS:
+        handle_caps (src, &header, (const gchar *) payload);
+        break;
+      case GST_PLAYER_REMOTE_SEGMENT:
+        memcpy (&segment, payload, sizeof (GstSegment));
+        if (!segment_is_valid (&segment)) {
+          GST_WARNING_OBJECT (src, "Dropping invalid segment of stream %u",
+              header.stream);
+          break;
+        }
+        event = gst_event_new_segment (&segment);
+        if (event)
+          push_event (src, &header, event, TRUE);
+        break;
+      case GST_PLAYER_REMOTE_TAGS:
+        tags = (const GstPlayerRemoteTags *) payload;
+        list = gst_tag_list_new_from_string ((const gchar *) payload +
+            sizeof (*tags));
+        if (!list)
+          break;
+        gst_tag_list_set_scope (list, tags->scope);
+        push_event (src, &header, gst_event_new_tag (list), FALSE);
+        break;
+      case GST_PLAYER_REMOTE_BUFFER:
+        handle_buffer (src, &header, payload);
+        payload = NULL;
+        break;
+      case GST_PLAYER_REMOTE_EOS:
+        push_event (src, &header, gst_event_new_eos (), TRUE);
+        break;
+      case GST_PLAYER_REMOTE_DURATION:
+        duration = (const GstPlayerRemoteDuration *) payload;
+        g_mutex_lock (&src->lock);
+        src->duration = duration->duration;
+        src->seekable = duration->seekable;
+        g_mutex_unlock (&src->lock);
+        gst_element_post_message (GST_ELEMENT (src),
+            gst_message_new_duration_changed (GST_OBJECT (src)));
+        break;
+      case GST_PLAYER_REMOTE_ERROR:
+        handle_error (src, (const gchar *) payload);
+        break;
+      default:
+        GST_WARNING_OBJECT (src, "Unexpected message %u", header.type);
+        break;
+    }
+
+    if (fd >= 0)
+      close (fd);
+    g_free (payload);
+  }
+  connection_unref (connection);
+
+  g_mutex_lock (&src->lock);
+  stopping = src->stopping;
+  g_mutex_unlock (&src->lock);
+
+  if (!stopping)
+    GST_ELEMENT_ERROR (src, STREAM, DECODE, (NULL),
+        ("Decoding process exited unexpectedly"));
+
+  return NULL;
+}
+
+static gboolean
+gst_player_remote_src_start (GstPlayerRemoteSrc * src)
+{
+  GSubprocessLauncher *launcher;
+  GSubprocess *helper;
+  Connection *connection;
+  const gchar *path;
+  GError *err = NULL;
+  gchar *uri;
+  gint fds[2], type = SOCK_STREAM;
+
+  GST_OBJECT_LOCK (src);
+  uri = g_strdup (src->uri);
+  src->transport_latency = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK (src);
+
+  if (!uri) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL), ("No URI set"));
+    return FALSE;
+  }
+
+#ifdef SOCK_CLOEXEC
+  type |= SOCK_CLOEXEC;
+#endif
+  if (socketpair (AF_UNIX, type, 0, fds) < 0) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("Failed to create socket: %s", g_strerror (errno)));
+    g_free (uri);
+    return FALSE;
+  }
+
+  path = g_getenv (REMOTE_HELPER_ENV);
+  if (!path)
+    path = GST_PLAYER_HELPER_PATH;
+
+  /* The launcher closes the helper's end here */
+  launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_NONE);
+  g_subprocess_launcher_take_fd (launcher, fds[1], GST_PLAYER_REMOTE_FD);
+  helper = g_subprocess_launcher_spawn (launcher, &err, path, uri, NULL);
+  g_object_unref (launcher);
+  if (!helper) {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("Failed to start %s: %s", path, err->message));
+    g_clear_error (&err);
+    close (fds[0]);
+    g_free (uri);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (src, "Decoding %s in process %s", uri,
+      g_subprocess_get_identifier (helper));
+  g_free (uri);
+
+  connection = g_new0 (Connection, 1);
+  connection->refcount = 1;
+  g_mutex_init (&connection->lock);
+  connection->fd = fds[0];
+
+  g_mutex_lock (&src->lock);
+  src->connection = connection;
+  src->flushing = FALSE;
+  src->stopping = FALSE;
+  src->epoch = 0;
+  src->have_seqnum = FALSE;
+  src->duration = GST_CLOCK_TIME_NONE;
+  src->seekable = FALSE;
+  src->group_id = gst_util_group_id_next ();
+  g_mutex_unlock (&src->lock);
+
+  src->helper = helper;
+  src->reader = g_thread_new ("remote-decode",
+      (GThreadFunc) gst_player_remote_src_reader, src);
+
+  return TRUE;
+}
+
+static void
+gst_player_remote_src_stop (GstPlayerRemoteSrc * src)
+{
+  Connection *connection;
+  SrcStream *stream;
+  guint i;
+
+  g_mutex_lock (&src->lock);
+  src->stopping = TRUE;
+  src->flushing = TRUE;
+  g_cond_broadcast (&src->cond);
+  connection = src->connection;
+  src->connection = NULL;
+  g_mutex_unlock (&src->lock);
+
+  /* Wakes up the reader and anything sending, buffers still in use can
+   * no longer give their space back */
+  if (connection)
+    shutdown (connection->fd, SHUT_RDWR);
+
+  if (src->reader) {
+    g_thread_join (src->reader);
+    src->reader = NULL;
+  }
+
+  if (connection) {
+    g_mutex_lock (&connection->lock);
+    close (connection->fd);
+    connection->fd = -1;
+    g_mutex_unlock (&connection->lock);
+    connection_unref (connection);
+  }
+
+  /* Nothing is left for it to do, and a decoder that hangs must not
+   * outlive the player */
+  if (src->helper) {
+    g_subprocess_force_exit (src->helper);
+    g_object_unref (src->helper);
+    src->helper = NULL;
+  }
+
+  for (i = 0; i < src->streams->len; i++) {
+    stream = g_ptr_array_index (src->streams, i);
+    if (stream)
+      gst_pad_stop_task (stream->pad);
+  }
+}
+
+static void
+gst_player_remote_src_remove_streams (GstPlayerRemoteSrc * src)
+{
+  GPtrArray *streams;
+  SrcStream *stream;
+  guint i;
+
+  g_mutex_lock (&src->lock);
+  streams = src->streams;
+  src->streams = g_ptr_array_new ();
+  g_mutex_unlock (&src->lock);
+
+  for (i = 0; i < streams->len; i++) {
+    stream = g_ptr_array_index (streams, i);
+    if (!stream)
+      continue;
+
+    gst_pad_set_element_private (stream->pad, NULL);
+    gst_element_remove_pad (GST_ELEMENT (src), stream->pad);
+    g_queue_foreach (&stream->items, (GFunc) gst_mini_object_unref, NULL);
+    g_queue_clear (&stream->items);
+    gst_caps_replace (&stream->caps, NULL);
+    ring_unref (stream->ring);
+    g_free (stream);
+  }
+  g_ptr_array_free (streams, TRUE);
+}
+
+static GstStateChangeReturn
+gst_player_remote_src_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstPlayerRemoteSrc *src = GST_PLAYER_REMOTE_SRC (element);
+  GstStateChangeReturn ret;
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    gst_player_remote_src_stop (src);
+
+  ret =
+      GST_ELEMENT_CLASS (gst_player_remote_src_parent_class)->change_state
+      (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_player_remote_src_start (src))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_player_remote_src_remove_streams (src);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_player_remote_src_finalize (GObject * object)
+{
+  GstPlayerRemoteSrc *src = GST_PLAYER_REMOTE_SRC (object);
+
+  g_free (src->uri);
+  g_ptr_array_free (src->streams, TRUE);
+  g_mutex_clear (&src->seek_lock);
+  g_mutex_clear (&src->lock);
+  g_cond_clear (&src->cond);
+
+  G_OBJECT_CLASS (gst_player_remote_src_parent_class)->finalize (object);
+}
+
+static void
+gst_player_remote_src_init (GstPlayerRemoteSrc * src)
+{
+  g_mutex_init (&src->seek_lock);
+  g_mutex_init (&src->lock);
+  g_cond_init (&src->cond);
+  src->streams = g_ptr_array_new ();
+  src->duration = GST_CLOCK_TIME_NONE;
+  src->transport_latency = GST_CLOCK_TIME_NONE;
+
+  GST_OBJECT_FLAG_SET (src, GST_ELEMENT_FLAG_SOURCE);
+}
+
+static void
+gst_player_remote_src_class_init (GstPlayerRemoteSrcClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_remote_src_debug,
+      "gst-player-remote-src", 0, "GstPlayer remote decoding source");
+
+  gobject_class->finalize = gst_player_remote_src_finalize;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&remote_src_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player remote decoding source", "Source",
+      "Outputs media decoded in a separate process", "GstPlayer");
+
+  element_class->change_state = gst_player_remote_src_change_state;
+}
+
+static GstURIType
+gst_player_remote_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_player_remote_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { REMOTE_PROTOCOL, NULL };
+
+  return protocols;
+}
+
+static gchar *
+gst_player_remote_src_uri_get_uri (GstURIHandler * handler)
+{
+  GstPlayerRemoteSrc *src = GST_PLAYER_REMOTE_SRC (handler);
+  gchar *escaped, *uri = NULL;
+
+  GST_OBJECT_LOCK (src);
+  if (src->uri) {
+    escaped = g_uri_escape_string (src->uri, NULL, FALSE);
+    uri = g_strconcat (REMOTE_PROTOCOL "://", escaped, NULL);
+    g_free (escaped);
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  return uri;
+}
+
+static gboolean
+gst_player_remote_src_uri_set_uri (GstURIHandler * handler,
+    const gchar * uri, GError ** error)
+{
+  GstPlayerRemoteSrc *src = GST_PLAYER_REMOTE_SRC (handler);
+  gchar *decoded;
+
+  if (GST_STATE (src) > GST_STATE_READY) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+        "Changing the URI while playing is not supported");
+    return FALSE;
+  }
+
+  if (!g_str_has_prefix (uri, REMOTE_PROTOCOL "://")) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_UNSUPPORTED_PROTOCOL,
+        "Unsupported URI '%s'", uri);
+    return FALSE;
+  }
+
+  decoded = g_uri_unescape_string (uri + strlen (REMOTE_PROTOCOL "://"),
+      NULL);
+  if (!decoded || !gst_uri_is_valid (decoded)) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+        "Invalid URI '%s'", uri);
+    g_free (decoded);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (src);
+  g_free (src->uri);
+  src->uri = decoded;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+static void
+gst_player_remote_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_player_remote_src_uri_get_type;
+  iface->get_protocols = gst_player_remote_src_uri_get_protocols;
+  iface->get_uri = gst_player_remote_src_uri_get_uri;
+  iface->set_uri = gst_player_remote_src_uri_set_uri;
+}
+
+static gpointer
+register_remote_src (gpointer data)
+{
+  /* Nothing else handles the protocol, the rank only has to be high
+   * enough for gst_element_make_from_uri() */
+  return GINT_TO_POINTER (gst_element_register (NULL, "playerremotesrc",
+          GST_RANK_PRIMARY, GST_TYPE_PLAYER_REMOTE_SRC));
+}
+
+/* Returns the URI that plays @uri decoded in a separate process, or NULL
+ * if @uri is invalid */
+gchar *
+gst_player_remote_src_make_uri (const gchar * uri)
+{
+  static GOnce once = G_ONCE_INIT;
+  gchar *escaped, *remote_uri;
+
+  if (!gst_uri_is_valid (uri))
+    return NULL;
+
+  if (!GPOINTER_TO_INT (g_once (&once, register_remote_src, NULL)))
+    return NULL;
+
+  escaped = g_uri_escape_string (uri, NULL, FALSE);
+  remote_uri = g_strconcat (REMOTE_PROTOCOL "://", escaped, NULL);
+  g_free (escaped);
+
+  return remote_uri;
+}
+
+/* Gets the average delay of the buffers between the helper and @element,
+ * returns FALSE if @element is not the remote decoding source */
+gboolean
+gst_player_remote_src_get_stats (GstElement * element,
+    GstClockTime * transport_latency)
+{
+  GstPlayerRemoteSrc *src;
+
+  if (!GST_IS_PLAYER_REMOTE_SRC (element))
+    return FALSE;
+
+  src = GST_PLAYER_REMOTE_SRC (element);
+  GST_OBJECT_LOCK (src);
+  *transport_latency = src->transport_latency;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+#else
+gchar *
+gst_player_remote_src_make_uri (const gchar * uri)
+{
+  return NULL;
+}
+
+gboolean
+gst_player_remote_src_get_stats (GstElement * element,
+    GstClockTime * transport_latency)
+{
+  return FALSE;
+}
+#endif
@@ -0,0 +1,41 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_RESUME_STORE_PRIVATE_H__
+#define __GST_PLAYER_RESUME_STORE_PRIVATE_H__
+
+#include <gst/gst.h>
+
+typedef struct _GstPlayerResumeStore GstPlayerResumeStore;
+
+G_GNUC_INTERNAL GstPlayerResumeStore * gst_player_resume_store_open
+                                       (void);
+G_GNUC_INTERNAL void                   gst_player_resume_store_close
+                                       (GstPlayerResumeStore *store);
+G_GNUC_INTERNAL GstClockTime           gst_player_resume_store_lookup
+                                       (GstPlayerResumeStore *store,
+                                        const gchar *uri);
+G_GNUC_INTERNAL void                   gst_player_resume_store_save
+                                       (GstPlayerResumeStore *store,
+                                        const gchar *uri,
+                                        GstClockTime position);
+G_GNUC_INTERNAL void                   gst_player_resume_store_remove
+                                       (GstPlayerResumeStore *store,
+                                        const gchar *uri);
+
+#endif /* __GST_PLAYER_RESUME_STORE_PRIVATE_H__ */
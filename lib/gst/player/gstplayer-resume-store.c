@@ -0,0 +1,290 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Resume positions of all URIs that were played, shared by all players and
+ * processes of the user. The store is a fixed size file that is mapped
+ * into memory and used as an open addressing hash table of URIs, so
+ * lookups and updates touch a few records and never read or write the
+ * whole file. Records hold the complete URI, hash collisions are never
+ * mistaken for a match, and URIs too long for a record are not stored.
+ * When all slots a URI can use are taken, the least recently updated one
+ * is replaced. Accesses are serialized between processes with a lock on
+ * the file */
+
+#include "gstplayer-resume-store-private.h"
+#include "gstplayer-cache-private.h"
+
+#include <string.h>
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+#endif
+
+#define RESUME_STORE_MAGIC "GSTPLRS2"
+#define RESUME_STORE_SLOTS 2048
+/* Slots a URI can be stored in, starting at its hash */
+#define RESUME_STORE_PROBES 16
+/* Longest URI that is stored, records are 1024 bytes */
+#define RESUME_STORE_KEY_SIZE 992
+
+typedef struct
+{
+  gchar magic[8];
+  guint32 n_slots;
+  guint32 reserved;
+} ResumeHeader;
+
+typedef struct
+{
+  guint64 hash;                 /* 0 if the slot is free */
+  guint64 position;
+  gint64 timestamp;             /* real time of the last update */
+  guint32 key_length;
+  guint32 reserved;
+  gchar key[RESUME_STORE_KEY_SIZE];     /* the URI, not NUL-terminated */
+} ResumeRecord;
+
+struct _GstPlayerResumeStore
+{
+  gint fd;
+  gpointer data;
+  gsize size;
+  ResumeRecord *records;
+};
+
+#define RESUME_STORE_SIZE \
+    (sizeof (ResumeHeader) + RESUME_STORE_SLOTS * sizeof (ResumeRecord))
+
+/* 64 bit FNV-1a, never 0 */
+static guint64
+uri_hash (const gchar * uri)
+{
+  guint64 hash = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+
+  for (; *uri; uri++) {
+    hash ^= (guchar) * uri;
+    hash *= G_GUINT64_CONSTANT (0x100000001b3);
+  }
+
+  return hash ? hash : 1;
+}
+
+#ifdef G_OS_UNIX
+static void
+lock_store (gint fd, gboolean exclusive)
+{
+  while (flock (fd, exclusive ? LOCK_EX : LOCK_SH) < 0 && errno == EINTR);
+}
+
+static void
+unlock_store (gint fd)
+{
+  flock (fd, LOCK_UN);
+}
+
+GstPlayerResumeStore *
+gst_player_resume_store_open (void)
+{
+  GstPlayerResumeStore *store;
+  ResumeHeader *header;
+  struct stat st;
+  gchar *filename;
+  gpointer data;
+  gint fd;
+
+  filename = gst_player_cache_get_filename ("resume", "positions");
+  fd = g_open (filename, O_RDWR | O_CREAT, 0644);
+  g_free (filename);
+  if (fd < 0)
+    return NULL;
+
+  /* Other processes may be creating or resetting the file as well */
+  lock_store (fd, TRUE);
+
+  /* A new or truncated file is zero filled, which is an empty table */
+  if (fstat (fd, &st) < 0 || (st.st_size != RESUME_STORE_SIZE
+          && ftruncate (fd, RESUME_STORE_SIZE) < 0)) {
+    unlock_store (fd);
+    close (fd);
+    return NULL;
+  }
+
+  data = mmap (NULL, RESUME_STORE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+      fd, 0);
+  if (data == MAP_FAILED) {
+    unlock_store (fd);
+    close (fd);
+    return NULL;
+  }
+
+  header = data;
+  if (memcmp (header->magic, RESUME_STORE_MAGIC, sizeof (header->magic))
+      || header->n_slots != RESUME_STORE_SLOTS) {
+    memset (data, 0, RESUME_STORE_SIZE);
+    memcpy (header->magic, RESUME_STORE_MAGIC, sizeof (header->magic));
+    header->n_slots = RESUME_STORE_SLOTS;
+  }
+  unlock_store (fd);
+
+  store = g_new0 (GstPlayerResumeStore, 1);
+  store->fd = fd;
+  store->data = data;
+  store->size = RESUME_STORE_SIZE;
+  store->records = (ResumeRecord *) (header + 1);
+
+  return store;
+}
+
+void
+gst_player_resume_store_close (GstPlayerResumeStore * store)
+{
+  munmap (store->data, store->size);
+  close (store->fd);
+  g_free (store);
+}
+#else
+static void
+lock_store (gint fd, gboolean exclusive)
+{
+}
+
+static void
+unlock_store (gint fd)
+{
+}
+
+GstPlayerResumeStore *
+gst_player_resume_store_open (void)
+{
+  return NULL;
+}
+
+void
+gst_player_resume_store_close (GstPlayerResumeStore * store)
+{
+}
+#endif
+
+static gboolean
+record_matches (const ResumeRecord * record, guint64 hash, const gchar * uri,
+    gsize length)
+{
+  return record->hash == hash && record->key_length == length
+      && memcmp (record->key, uri, length) == 0;
+}
+
+/* Must be called with the store locked */
+static ResumeRecord *
+find_record (GstPlayerResumeStore * store, guint64 hash, const gchar * uri,
+    gsize length)
+{
+  guint i;
+
+  for (i = 0; i < RESUME_STORE_PROBES; i++) {
+    ResumeRecord *record =
+        &store->records[(hash + i) % RESUME_STORE_SLOTS];
+
+    if (record_matches (record, hash, uri, length))
+      return record;
+  }
+
+  return NULL;
+}
+
+/* Returns the stored position of @uri or GST_CLOCK_TIME_NONE */
+GstClockTime
+gst_player_resume_store_lookup (GstPlayerResumeStore * store,
+    const gchar * uri)
+{
+  GstClockTime position = GST_CLOCK_TIME_NONE;
+  gsize length = strlen (uri);
+  ResumeRecord *record;
+
+  if (length > RESUME_STORE_KEY_SIZE)
+    return GST_CLOCK_TIME_NONE;
+
+  lock_store (store->fd, FALSE);
+  record = find_record (store, uri_hash (uri), uri, length);
+  if (record)
+    position = record->position;
+  unlock_store (store->fd);
+
+  return position;
+}
+
+void
+gst_player_resume_store_save (GstPlayerResumeStore * store,
+    const gchar * uri, GstClockTime position)
+{
+  gsize length = strlen (uri);
+  guint64 hash = uri_hash (uri);
+  ResumeRecord *record;
+  guint i;
+
+  if (length > RESUME_STORE_KEY_SIZE)
+    return;
+
+  lock_store (store->fd, TRUE);
+  record = find_record (store, hash, uri, length);
+  if (!record) {
+    /* A free slot, or else the oldest one */
+    for (i = 0; i < RESUME_STORE_PROBES; i++) {
+      ResumeRecord *r = &store->records[(hash + i) % RESUME_STORE_SLOTS];
+
+      if (r->hash == 0) {
+        record = r;
+        break;
+      } else if (!record || r->timestamp < record->timestamp) {
+        record = r;
+      }
+    }
+
+    record->hash = hash;
+    record->key_length = length;
+    memcpy (record->key, uri, length);
+  }
+
+  record->position = position;
+  record->timestamp = g_get_real_time ();
+  unlock_store (store->fd);
+}
+
+void
+gst_player_resume_store_remove (GstPlayerResumeStore * store,
+    const gchar * uri)
+{
+  gsize length = strlen (uri);
+  ResumeRecord *record;
+
+  if (length > RESUME_STORE_KEY_SIZE)
+    return;
+
+  lock_store (store->fd, TRUE);
+  record = find_record (store, uri_hash (uri), uri, length);
+  if (record) {
+    record->hash = 0;
+    record->key_length = 0;
+  }
+  unlock_store (store->fd);
+}
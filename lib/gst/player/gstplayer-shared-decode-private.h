@@ -0,0 +1,29 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_SHARED_DECODE_PRIVATE_H__
+#define __GST_PLAYER_SHARED_DECODE_PRIVATE_H__
+
+#include <gst/gst.h>
+
+G_GNUC_INTERNAL gchar *  gst_player_shared_decode_make_uri (const gchar *uri);
+G_GNUC_INTERNAL gboolean gst_player_shared_src_get_stats
+                                                  (GstElement *element,
+                                                   guint *players);
+
+#endif /* __GST_PLAYER_SHARED_DECODE_PRIVATE_H__ */
@@ -0,0 +1,1109 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Decoding shared by the players of a process that play the same URI.
+ *
+ * The first player starts a pipeline that decodes the URI, every decoded
+ * stream of it ends in a sink that hands each buffer to all players by
+ * reference, like a tee that players can join and leave without
+ * relinking. The players read the streams from a source element for a
+ * protocol of its own, playbin passes the raw streams directly to its
+ * sinks so every player keeps its own sinks and window.
+ *
+ * The decoding pipeline runs against the system clock and the players see
+ * it as a live source: the source provides the system clock, only
+ * produces while playing and timestamps the buffers with the running time
+ * they are due at in the player's pipeline. Seeking is not possible. */
+
+#include "gstplayer-shared-decode-private.h"
+
+#include <gst/base/gstbasesink.h>
+#include <string.h>
+
+#define SHARED_DECODE_PROTOCOL "gstplayer-shared"
+/* How far a player may fall behind before its oldest buffers are dropped */
+#define SHARED_QUEUE_MAX_TIME (500 * GST_MSECOND)
+/* Latency of the players, covers handing the buffers over between the
+ * decoding thread and the streaming threads of the players */
+#define SHARED_LATENCY (100 * GST_MSECOND)
+
+GST_DEBUG_CATEGORY_STATIC (gst_player_shared_decode_debug);
+#define GST_CAT_DEFAULT gst_player_shared_decode_debug
+
+typedef struct _GstPlayerSharedSrc GstPlayerSharedSrc;
+
+static void shared_src_add_stream (GstPlayerSharedSrc * src, guint index,
+    GstCaps * caps, gboolean eos);
+static void shared_src_expose_stream (GstPlayerSharedSrc * src, guint index);
+static void shared_src_no_more_pads (GstPlayerSharedSrc * src);
+static void shared_src_push_caps (GstPlayerSharedSrc * src, guint index,
+    GstCaps * caps);
+static void shared_src_push_buffer (GstPlayerSharedSrc * src, guint index,
+    GstBuffer * buffer, const GstSegment * segment);
+static void shared_src_push_eos (GstPlayerSharedSrc * src, guint index);
+static void shared_src_post_error (GstPlayerSharedSrc * src,
+    const GError * error, const gchar * debug);
+
+/* Decoding pipelines */
+
+typedef struct
+{
+  /* Protected by registry_lock */
+  gint refcount;
+  gchar *uri;
+
+  GstElement *pipeline;
+
+  GMutex lock;
+  /* Protected by lock */
+  GPtrArray *streams;
+  gboolean complete;
+  GError *error;
+  gchar *error_debug;
+  GList *players;
+} SharedDecode;
+
+typedef struct
+{
+  SharedDecode *decode;
+  guint index;
+  /* Protected by the lock of decode */
+  GstCaps *caps;
+  gboolean eos;
+} SharedStream;
+
+static GMutex registry_lock;
+static GHashTable *registry;
+
+static void
+shared_stream_free (SharedStream * stream)
+{
+  gst_caps_replace (&stream->caps, NULL);
+  g_free (stream);
+}
+
+#define GST_TYPE_PLAYER_SHARED_SINK (gst_player_shared_sink_get_type ())
+#define GST_PLAYER_SHARED_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_SHARED_SINK, GstPlayerSharedSink))
+
+typedef struct
+{
+  GstBaseSink parent;
+
+  SharedStream *stream;
+} GstPlayerSharedSink;
+
+typedef GstBaseSinkClass GstPlayerSharedSinkClass;
+
+static GstStaticPadTemplate shared_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+G_GNUC_INTERNAL GType gst_player_shared_sink_get_type (void);
+G_DEFINE_TYPE (GstPlayerSharedSink, gst_player_shared_sink,
+    GST_TYPE_BASE_SINK);
+
+static gboolean
+gst_player_shared_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
+{
+  SharedStream *stream = GST_PLAYER_SHARED_SINK (bsink)->stream;
+  SharedDecode *decode = stream->decode;
+  GList *l;
+
+  g_mutex_lock (&decode->lock);
+  gst_caps_replace (&stream->caps, caps);
+  for (l = decode->players; l; l = l->next)
+    shared_src_push_caps (l->data, stream->index, caps);
+  g_mutex_unlock (&decode->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_shared_sink_event (GstBaseSink * bsink, GstEvent * event)
+{
+  SharedStream *stream = GST_PLAYER_SHARED_SINK (bsink)->stream;
+  SharedDecode *decode = stream->decode;
+  GList *l;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    g_mutex_lock (&decode->lock);
+    stream->eos = TRUE;
+    for (l = decode->players; l; l = l->next)
+      shared_src_push_eos (l->data, stream->index);
+    g_mutex_unlock (&decode->lock);
+  }
+
+  return
+      GST_BASE_SINK_CLASS (gst_player_shared_sink_parent_class)->event
+      (bsink, event);
+}
+
+static GstFlowReturn
+gst_player_shared_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
+{
+  SharedStream *stream = GST_PLAYER_SHARED_SINK (bsink)->stream;
+  SharedDecode *decode = stream->decode;
+  GList *l;
+
+  g_mutex_lock (&decode->lock);
+  for (l = decode->players; l; l = l->next)
+    shared_src_push_buffer (l->data, stream->index, buffer, &bsink->segment);
+  g_mutex_unlock (&decode->lock);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_player_shared_sink_init (GstPlayerSharedSink * sink)
+{
+  GstBaseSink *bsink = GST_BASE_SINK (sink);
+
+  /* Hand out every buffer when it is due, however late */
+  gst_base_sink_set_sync (bsink, TRUE);
+  gst_base_sink_set_qos_enabled (bsink, FALSE);
+  gst_base_sink_set_max_lateness (bsink, -1);
+  gst_base_sink_set_last_sample_enabled (bsink, FALSE);
+}
+
+static void
+gst_player_shared_sink_class_init (GstPlayerSharedSinkClass * klass)
+{
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseSinkClass *basesink_class = (GstBaseSinkClass *) klass;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&shared_sink_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player shared decoding sink", "Sink",
+      "Hands decoded buffers to all players of the same media", "GstPlayer");
+
+  basesink_class->set_caps = gst_player_shared_sink_set_caps;
+  basesink_class->event = gst_player_shared_sink_event;
+  basesink_class->render = gst_player_shared_sink_render;
+}
+
+static void
+decode_pad_added_cb (GstElement * decodebin, GstPad * pad,
+    SharedDecode * decode)
+{
+  SharedStream *stream;
+  GstElement *sink;
+  GstPad *sinkpad;
+  GList *players, *l;
+
+  /* Caps that are not known yet follow with the caps event, see
+   * gst_player_shared_sink_set_caps() */
+  stream = g_new0 (SharedStream, 1);
+  stream->decode = decode;
+  stream->caps = gst_pad_get_current_caps (pad);
+
+  g_mutex_lock (&decode->lock);
+  stream->index = decode->streams->len;
+  g_ptr_array_add (decode->streams, stream);
+  for (l = decode->players; l; l = l->next)
+    shared_src_add_stream (l->data, stream->index, stream->caps, FALSE);
+  players = g_list_copy (decode->players);
+  g_list_foreach (players, (GFunc) gst_object_ref, NULL);
+  g_mutex_unlock (&decode->lock);
+
+  /* Adding pads calls into the players, which must not happen with the
+   * lock of the decoding */
+  for (l = players; l; l = l->next)
+    shared_src_expose_stream (l->data, stream->index);
+  g_list_free_full (players, gst_object_unref);
+
+  sink = g_object_new (GST_TYPE_PLAYER_SHARED_SINK, NULL);
+  GST_PLAYER_SHARED_SINK (sink)->stream = stream;
+  gst_bin_add (GST_BIN (decode->pipeline), sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  if (gst_pad_link (pad, sinkpad) != GST_PAD_LINK_OK)
+    GST_WARNING ("Failed to link stream %u of %s", stream->index,
+        decode->uri);
+  gst_object_unref (sinkpad);
+
+  gst_element_sync_state_with_parent (sink);
+}
+
+static void
+decode_no_more_pads_cb (GstElement * decodebin, SharedDecode * decode)
+{
+  GList *players, *l;
+
+  g_mutex_lock (&decode->lock);
+  decode->complete = TRUE;
+  players = g_list_copy (decode->players);
+  g_list_foreach (players, (GFunc) gst_object_ref, NULL);
+  g_mutex_unlock (&decode->lock);
+
+  for (l = players; l; l = l->next)
+    shared_src_no_more_pads (l->data);
+  g_list_free_full (players, gst_object_unref);
+}
+
+static GstBusSyncReply
+decode_bus_sync_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  SharedDecode *decode = user_data;
+  GError *err;
+  gchar *debug;
+  GList *l;
+
+  /* Nothing watches the bus, errors are passed on to the players */
+  if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_ERROR)
+    return GST_BUS_DROP;
+
+  gst_message_parse_error (msg, &err, &debug);
+  GST_WARNING ("Decoding %s failed: %s", decode->uri, err->message);
+
+  g_mutex_lock (&decode->lock);
+  if (!decode->error) {
+    for (l = decode->players; l; l = l->next)
+      shared_src_post_error (l->data, err, debug);
+    decode->error = err;
+    decode->error_debug = debug;
+  } else {
+    g_error_free (err);
+    g_free (debug);
+  }
+  g_mutex_unlock (&decode->lock);
+
+  return GST_BUS_DROP;
+}
+
+/* Returns the decoding of @uri, starting it if no player shares it yet */
+static SharedDecode *
+shared_decode_get (const gchar * uri)
+{
+  SharedDecode *decode;
+  GstElement *decodebin;
+  GstBus *bus;
+  GstClock *clock;
+
+  g_mutex_lock (&registry_lock);
+  if (!registry)
+    registry = g_hash_table_new (g_str_hash, g_str_equal);
+
+  decode = g_hash_table_lookup (registry, uri);
+  if (decode) {
+    decode->refcount++;
+    g_mutex_unlock (&registry_lock);
+    return decode;
+  }
+
+  decode = g_new0 (SharedDecode, 1);
+  decode->refcount = 1;
+  decode->uri = g_strdup (uri);
+  g_mutex_init (&decode->lock);
+  decode->streams =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) shared_stream_free);
+  g_hash_table_insert (registry, decode->uri, decode);
+
+  decodebin = gst_element_factory_make ("uridecodebin", NULL);
+  if (!decodebin) {
+    decode->error = g_error_new (GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN,
+        "Missing element 'uridecodebin'");
+    g_mutex_unlock (&registry_lock);
+    return decode;
+  }
+
+  g_object_set (decodebin, "uri", uri, NULL);
+  g_signal_connect (decodebin, "pad-added",
+      G_CALLBACK (decode_pad_added_cb), decode);
+  g_signal_connect (decodebin, "no-more-pads",
+      G_CALLBACK (decode_no_more_pads_cb), decode);
+
+  decode->pipeline = gst_pipeline_new ("shared-decode");
+  gst_bin_add (GST_BIN (decode->pipeline), decodebin);
+
+  /* The players use the system clock too */
+  clock = gst_system_clock_obtain ();
+  gst_pipeline_use_clock (GST_PIPELINE (decode->pipeline), clock);
+  gst_object_unref (clock);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (decode->pipeline));
+  gst_bus_set_sync_handler (bus, decode_bus_sync_cb, decode, NULL);
+  gst_object_unref (bus);
+
+  GST_DEBUG ("Starting to decode %s", uri);
+  gst_element_set_state (decode->pipeline, GST_STATE_PLAYING);
+  g_mutex_unlock (&registry_lock);
+
+  return decode;
+}
+
+static void
+shared_decode_ref (SharedDecode * decode)
+{
+  g_mutex_lock (&registry_lock);
+  decode->refcount++;
+  g_mutex_unlock (&registry_lock);
+}
+
+/* Stops the decoding when the last player leaves */
+static void
+shared_decode_unref (SharedDecode * decode)
+{
+  GstBus *bus;
+
+  g_mutex_lock (&registry_lock);
+  if (--decode->refcount > 0) {
+    g_mutex_unlock (&registry_lock);
+    return;
+  }
+  g_hash_table_remove (registry, decode->uri);
+  g_mutex_unlock (&registry_lock);
+
+  GST_DEBUG ("Stopping to decode %s", decode->uri);
+  if (decode->pipeline) {
+    gst_element_set_state (decode->pipeline, GST_STATE_NULL);
+    bus = gst_pipeline_get_bus (GST_PIPELINE (decode->pipeline));
+    gst_bus_set_sync_handler (bus, NULL, NULL, NULL);
+    gst_object_unref (bus);
+    gst_object_unref (decode->pipeline);
+  }
+
+  g_ptr_array_free (decode->streams, TRUE);
+  g_clear_error (&decode->error);
+  g_free (decode->error_debug);
+  g_mutex_clear (&decode->lock);
+  g_free (decode->uri);
+  g_free (decode);
+}
+
+/* Source of the players */
+
+#define GST_TYPE_PLAYER_SHARED_SRC (gst_player_shared_src_get_type ())
+#define GST_PLAYER_SHARED_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_SHARED_SRC, GstPlayerSharedSrc))
+#define GST_IS_PLAYER_SHARED_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PLAYER_SHARED_SRC))
+
+typedef struct
+{
+  GstPlayerSharedSrc *src;
+  GstPad *pad;
+  /* Protected by the lock of src */
+  GQueue items;
+  GstCaps *caps;
+  gboolean exposed;
+} SrcStream;
+
+struct _GstPlayerSharedSrc
+{
+  GstElement parent;
+
+  /* Protected by object lock */
+  gchar *uri;
+  SharedDecode *decode;
+
+  /* Serializes adding pads with stopping */
+  GMutex pads_lock;
+
+  GMutex lock;
+  GCond cond;
+  /* Protected by lock */
+  GPtrArray *streams;
+  guint group_id;
+  gboolean flushing;
+  gboolean have_offset;
+  GstClockTimeDiff offset;
+};
+
+typedef GstElementClass GstPlayerSharedSrcClass;
+
+static GstStaticPadTemplate shared_src_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u", GST_PAD_SRC, GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_player_shared_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_GNUC_INTERNAL GType gst_player_shared_src_get_type (void);
+G_DEFINE_TYPE_WITH_CODE (GstPlayerSharedSrc, gst_player_shared_src,
+    GST_TYPE_ELEMENT, G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_player_shared_src_uri_handler_init));
+
+static SrcStream *
+get_stream_locked (GstPlayerSharedSrc * src, guint index)
+{
+  if (index >= src->streams->len)
+    return NULL;
+
+  return g_ptr_array_index (src->streams, index);
+}
+
+static void
+drop_buffers_locked (SrcStream * stream)
+{
+  GList *l, *next;
+
+  for (l = stream->items.head; l; l = next) {
+    next = l->next;
+    if (GST_IS_BUFFER (l->data)) {
+      gst_buffer_unref (l->data);
+      g_queue_delete_link (&stream->items, l);
+    }
+  }
+}
+
+static void
+gst_player_shared_src_loop (SrcStream * stream)
+{
+  GstPlayerSharedSrc *src = stream->src;
+  GstMiniObject *item;
+  GstFlowReturn ret;
+  gboolean eos;
+
+  g_mutex_lock (&src->lock);
+  while (!src->flushing && g_queue_is_empty (&stream->items))
+    g_cond_wait (&src->cond, &src->lock);
+  if (src->flushing) {
+    g_mutex_unlock (&src->lock);
+    gst_pad_pause_task (stream->pad);
+    return;
+  }
+  item = g_queue_pop_head (&stream->items);
+  g_mutex_unlock (&src->lock);
+
+  if (GST_IS_EVENT (item)) {
+    eos = GST_EVENT_TYPE (item) == GST_EVENT_EOS;
+    gst_pad_push_event (stream->pad, GST_EVENT_CAST (item));
+    if (eos)
+      gst_pad_pause_task (stream->pad);
+    return;
+  }
+
+  ret = gst_pad_push (stream->pad, GST_BUFFER_CAST (item));
+  if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED)
+    return;
+
+  GST_DEBUG_OBJECT (stream->pad, "Pausing task, reason %s",
+      gst_flow_get_name (ret));
+  gst_pad_pause_task (stream->pad);
+  if (ret < GST_FLOW_EOS) {
+    GST_ELEMENT_ERROR (src, STREAM, FAILED, (NULL),
+        ("Streaming stopped, reason %s", gst_flow_get_name (ret)));
+    gst_pad_push_event (stream->pad, gst_event_new_eos ());
+  }
+}
+
+static gboolean
+gst_player_shared_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstPlayerSharedSrc *src = GST_PLAYER_SHARED_SRC (parent);
+  SrcStream *stream = gst_pad_get_element_private (pad);
+  GstCaps *caps, *filter, *tmp;
+  GstFormat format;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:
+      g_mutex_lock (&src->lock);
+      caps = stream && stream->caps ? gst_caps_ref (stream->caps) :
+          gst_caps_new_any ();
+      g_mutex_unlock (&src->lock);
+
+      gst_query_parse_caps (query, &filter);
+      if (filter) {
+        tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    case GST_QUERY_LATENCY:
+      gst_query_set_latency (query, TRUE, SHARED_LATENCY,
+          GST_CLOCK_TIME_NONE);
+      return TRUE;
+    case GST_QUERY_SEEKING:
+      gst_query_parse_seeking (query, &format, NULL, NULL, NULL);
+      gst_query_set_seeking (query, format, FALSE, 0, -1);
+      return TRUE;
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
+static gboolean
+gst_player_shared_src_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  gboolean res = GST_EVENT_TYPE (event) != GST_EVENT_SEEK;
+
+  gst_event_unref (event);
+
+  return res;
+}
+
+/* Called with the lock of the decoding */
+static void
+shared_src_add_stream (GstPlayerSharedSrc * src, guint index, GstCaps * caps,
+    gboolean eos)
+{
+  SrcStream *stream;
+  GstSegment segment;
+  GstEvent *event;
+  gchar *name, *stream_id;
+
+  stream = g_new0 (SrcStream, 1);
+  stream->src = src;
+  g_queue_init (&stream->items);
+
+  name = g_strdup_printf ("src_%u", index);
+  stream->pad = gst_pad_new_from_static_template (&shared_src_template, name);
+  g_free (name);
+  gst_pad_set_element_private (stream->pad, stream);
+  gst_pad_set_query_function (stream->pad, gst_player_shared_src_query);
+  gst_pad_set_event_function (stream->pad, gst_player_shared_src_event);
+
+  stream_id = gst_pad_create_stream_id_printf (stream->pad,
+      GST_ELEMENT (src), "%u", index);
+  event = gst_event_new_stream_start (stream_id);
+  g_free (stream_id);
+
+  g_mutex_lock (&src->lock);
+  gst_event_set_group_id (event, src->group_id);
+  g_queue_push_tail (&stream->items, event);
+  if (caps) {
+    stream->caps = gst_caps_ref (caps);
+    g_queue_push_tail (&stream->items, gst_event_new_caps (caps));
+  }
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  g_queue_push_tail (&stream->items, gst_event_new_segment (&segment));
+  if (eos)
+    g_queue_push_tail (&stream->items, gst_event_new_eos ());
+
+  if (src->streams->len <= index)
+    g_ptr_array_set_size (src->streams, index + 1);
+  g_ptr_array_index (src->streams, index) = stream;
+  g_mutex_unlock (&src->lock);
+}
+
+/* Adds the pad of a stream added before and starts pushing what was
+ * queued for it. Called without the lock of the decoding */
+static void
+shared_src_expose_stream (GstPlayerSharedSrc * src, guint index)
+{
+  SrcStream *stream;
+
+  g_mutex_lock (&src->pads_lock);
+  g_mutex_lock (&src->lock);
+  stream = src->flushing ? NULL : get_stream_locked (src, index);
+  if (stream && stream->exposed)
+    stream = NULL;
+  else if (stream)
+    stream->exposed = TRUE;
+  g_mutex_unlock (&src->lock);
+
+  if (stream) {
+    gst_pad_set_active (stream->pad, TRUE);
+    gst_element_add_pad (GST_ELEMENT (src), stream->pad);
+    gst_pad_start_task (stream->pad,
+        (GstTaskFunction) gst_player_shared_src_loop, stream, NULL);
+  }
+  g_mutex_unlock (&src->pads_lock);
+}
+
+/* Called without the lock of the decoding */
+static void
+shared_src_no_more_pads (GstPlayerSharedSrc * src)
+{
+  gboolean flushing;
+
+  g_mutex_lock (&src->pads_lock);
+  g_mutex_lock (&src->lock);
+  flushing = src->flushing;
+  g_mutex_unlock (&src->lock);
+
+  if (!flushing)
+    gst_element_no_more_pads (GST_ELEMENT (src));
+  g_mutex_unlock (&src->pads_lock);
+}
+
+/* Called with the lock of the decoding */
+static void
+shared_src_push_caps (GstPlayerSharedSrc * src, guint index, GstCaps * caps)
+{
+  SrcStream *stream;
+
+  g_mutex_lock (&src->lock);
+  stream = get_stream_locked (src, index);
+  if (stream && !(stream->caps && gst_caps_is_equal (stream->caps, caps))) {
+    gst_caps_replace (&stream->caps, caps);
+    g_queue_push_tail (&stream->items, gst_event_new_caps (caps));
+    g_cond_broadcast (&src->cond);
+  }
+  g_mutex_unlock (&src->lock);
+}
+
+/* Called with the lock of the decoding */
+static void
+shared_src_push_buffer (GstPlayerSharedSrc * src, guint index,
+    GstBuffer * buffer, const GstSegment * segment)
+{
+  SrcStream *stream;
+  GstClock *clock;
+  GstClockTime running_time, now;
+  GstClockTimeDiff pts;
+  GstBuffer *head;
+  gboolean dropped = FALSE;
+
+  /* Like any live source, nothing is produced while not playing */
+  if (GST_STATE (src) != GST_STATE_PLAYING)
+    return;
+
+  running_time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+      GST_BUFFER_PTS (buffer));
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return;
+
+  clock = gst_element_get_clock (GST_ELEMENT (src));
+  if (!clock)
+    return;
+  now = gst_clock_get_time (clock) -
+      gst_element_get_base_time (GST_ELEMENT (src));
+  gst_object_unref (clock);
+
+  g_mutex_lock (&src->lock);
+  stream = get_stream_locked (src, index);
+  if (!stream || src->flushing) {
+    g_mutex_unlock (&src->lock);
+    return;
+  }
+
+  /* The first buffer after starting to play is due now, the others keep
+   * their distance to it in all streams */
+  if (!src->have_offset) {
+    src->offset = GST_CLOCK_DIFF (running_time, now);
+    src->have_offset = TRUE;
+  }
+  pts = (GstClockTimeDiff) running_time + src->offset;
+  if (pts < 0) {
+    g_mutex_unlock (&src->lock);
+    return;
+  }
+
+  /* Only the metadata is copied, the memory is shared with the other
+   * players */
+  buffer = gst_buffer_copy (buffer);
+  GST_BUFFER_PTS (buffer) = pts;
+  GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
+  g_queue_push_tail (&stream->items, buffer);
+
+  while ((head = g_queue_peek_head (&stream->items)) && GST_IS_BUFFER (head)
+      && pts - GST_BUFFER_PTS (head) > SHARED_QUEUE_MAX_TIME) {
+    gst_buffer_unref (g_queue_pop_head (&stream->items));
+    dropped = TRUE;
+  }
+  if (dropped) {
+    GST_LOG_OBJECT (src, "Dropped buffers of stream %u", index);
+    if (head && GST_IS_BUFFER (head))
+      GST_BUFFER_FLAG_SET (head, GST_BUFFER_FLAG_DISCONT);
+  }
+
+  g_cond_broadcast (&src->cond);
+  g_mutex_unlock (&src->lock);
+}
+
+/* Called with the lock of the decoding */
+static void
+shared_src_push_eos (GstPlayerSharedSrc * src, guint index)
+{
+  SrcStream *stream;
+
+  g_mutex_lock (&src->lock);
+  stream = get_stream_locked (src, index);
+  if (stream) {
+    g_queue_push_tail (&stream->items, gst_event_new_eos ());
+    g_cond_broadcast (&src->cond);
+  }
+  g_mutex_unlock (&src->lock);
+}
+
+/* Called with the lock of the decoding */
+static void
+shared_src_post_error (GstPlayerSharedSrc * src, const GError * error,
+    const gchar * debug)
+{
+  GError *err = g_error_copy (error);
+
+  gst_element_post_message (GST_ELEMENT (src),
+      gst_message_new_error (GST_OBJECT (src), err, debug));
+  g_error_free (err);
+}
+
+static gboolean
+gst_player_shared_src_start (GstPlayerSharedSrc * src)
+{
+  SharedDecode *decode;
+  SharedStream *stream;
+  gboolean complete;
+  guint i, n_streams;
+  gchar *uri;
+
+  GST_OBJECT_LOCK (src);
+  uri = g_strdup (src->uri);
+  GST_OBJECT_UNLOCK (src);
+
+  if (!uri) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL), ("No URI set"));
+    return FALSE;
+  }
+
+  decode = shared_decode_get (uri);
+  g_free (uri);
+
+  g_mutex_lock (&src->lock);
+  src->flushing = FALSE;
+  src->have_offset = FALSE;
+  src->group_id = gst_util_group_id_next ();
+  g_mutex_unlock (&src->lock);
+
+  /* Joins with the streams decoded so far */
+  g_mutex_lock (&decode->lock);
+  if (decode->error)
+    shared_src_post_error (src, decode->error, decode->error_debug);
+  n_streams = decode->streams->len;
+  for (i = 0; i < n_streams; i++) {
+    stream = g_ptr_array_index (decode->streams, i);
+    shared_src_add_stream (src, i, stream->caps, stream->eos);
+  }
+  complete = decode->complete;
+  decode->players = g_list_prepend (decode->players, src);
+  GST_DEBUG_OBJECT (src, "Sharing decoding of %s with %u other players",
+      decode->uri, g_list_length (decode->players) - 1);
+  g_mutex_unlock (&decode->lock);
+
+  GST_OBJECT_LOCK (src);
+  src->decode = decode;
+  GST_OBJECT_UNLOCK (src);
+
+  for (i = 0; i < n_streams; i++)
+    shared_src_expose_stream (src, i);
+  if (complete)
+    shared_src_no_more_pads (src);
+
+  return TRUE;
+}
+
+static void
+gst_player_shared_src_stop (GstPlayerSharedSrc * src)
+{
+  SharedDecode *decode;
+  SrcStream *stream;
+  guint i;
+
+  GST_OBJECT_LOCK (src);
+  decode = src->decode;
+  src->decode = NULL;
+  GST_OBJECT_UNLOCK (src);
+
+  /* No streams are added after leaving */
+  if (decode) {
+    g_mutex_lock (&decode->lock);
+    decode->players = g_list_remove (decode->players, src);
+    g_mutex_unlock (&decode->lock);
+    shared_decode_unref (decode);
+  }
+
+  /* Pads that are being added are started before this */
+  g_mutex_lock (&src->pads_lock);
+  g_mutex_lock (&src->lock);
+  src->flushing = TRUE;
+  g_cond_broadcast (&src->cond);
+  g_mutex_unlock (&src->lock);
+  g_mutex_unlock (&src->pads_lock);
+
+  for (i = 0; i < src->streams->len; i++) {
+    stream = g_ptr_array_index (src->streams, i);
+    if (stream)
+      gst_pad_stop_task (stream->pad);
+  }
+}
+
+static void
+gst_player_shared_src_remove_streams (GstPlayerSharedSrc * src)
+{
+  GPtrArray *streams;
+  SrcStream *stream;
+  guint i;
+
+  g_mutex_lock (&src->lock);
+  streams = src->streams;
+  src->streams = g_ptr_array_new ();
+  g_mutex_unlock (&src->lock);
+
+  for (i = 0; i < streams->len; i++) {
+    stream = g_ptr_array_index (streams, i);
+    if (!stream)
+      continue;
+
+    gst_pad_set_element_private (stream->pad, NULL);
+    gst_element_remove_pad (GST_ELEMENT (src), stream->pad);
+    g_queue_foreach (&stream->items, (GFunc) gst_mini_object_unref, NULL);
+    g_queue_clear (&stream->items);
+    gst_caps_replace (&stream->caps, NULL);
+    g_free (stream);
+  }
+  g_ptr_array_free (streams, TRUE);
+}
+
+static GstStateChangeReturn
+gst_player_shared_src_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstPlayerSharedSrc *src = GST_PLAYER_SHARED_SRC (element);
+  GstStateChangeReturn ret;
+  guint i;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      /* Timestamps start over from the new base time */
+      g_mutex_lock (&src->lock);
+      src->have_offset = FALSE;
+      for (i = 0; i < src->streams->len; i++) {
+        if (g_ptr_array_index (src->streams, i))
+          drop_buffers_locked (g_ptr_array_index (src->streams, i));
+      }
+      g_mutex_unlock (&src->lock);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_player_shared_src_stop (src);
+      break;
+    default:
+      break;
+  }
+
+  ret =
+      GST_ELEMENT_CLASS (gst_player_shared_src_parent_class)->change_state
+      (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_player_shared_src_start (src))
+        return GST_STATE_CHANGE_FAILURE;
+      ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_player_shared_src_remove_streams (src);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static GstClock *
+gst_player_shared_src_provide_clock (GstElement * element)
+{
+  /* The clock the decoding runs against */
+  return gst_system_clock_obtain ();
+}
+
+static void
+gst_player_shared_src_finalize (GObject * object)
+{
+  GstPlayerSharedSrc *src = GST_PLAYER_SHARED_SRC (object);
+
+  g_free (src->uri);
+  g_ptr_array_free (src->streams, TRUE);
+  g_mutex_clear (&src->pads_lock);
+  g_mutex_clear (&src->lock);
+  g_cond_clear (&src->cond);
+
+  G_OBJECT_CLASS (gst_player_shared_src_parent_class)->finalize (object);
+}
+
+static void
+gst_player_shared_src_init (GstPlayerSharedSrc * src)
+{
+  g_mutex_init (&src->pads_lock);
+  g_mutex_init (&src->lock);
+  g_cond_init (&src->cond);
+  src->streams = g_ptr_array_new ();
+
+  GST_OBJECT_FLAG_SET (src,
+      GST_ELEMENT_FLAG_SOURCE | GST_ELEMENT_FLAG_PROVIDE_CLOCK);
+}
+
+static void
+gst_player_shared_src_class_init (GstPlayerSharedSrcClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_shared_decode_debug,
+      "gst-player-shared-decode", 0, "GstPlayer shared decoding");
+
+  gobject_class->finalize = gst_player_shared_src_finalize;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&shared_src_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player shared decoding source", "Source",
+      "Outputs media decoded once for all players of it", "GstPlayer");
+
+  element_class->change_state = gst_player_shared_src_change_state;
+  element_class->provide_clock = gst_player_shared_src_provide_clock;
+}
+
+static GstURIType
+gst_player_shared_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_player_shared_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { SHARED_DECODE_PROTOCOL, NULL };
+
+  return protocols;
+}
+
+static gchar *
+gst_player_shared_src_uri_get_uri (GstURIHandler * handler)
+{
+  GstPlayerSharedSrc *src = GST_PLAYER_SHARED_SRC (handler);
+  gchar *escaped, *uri = NULL;
+
+  GST_OBJECT_LOCK (src);
+  if (src->uri) {
+    escaped = g_uri_escape_string (src->uri, NULL, FALSE);
+    uri = g_strconcat (SHARED_DECODE_PROTOCOL "://", escaped, NULL);
+    g_free (escaped);
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  return uri;
+}
+
+static gboolean
+gst_player_shared_src_uri_set_uri (GstURIHandler * handler,
+    const gchar * uri, GError ** error)
+{
+  GstPlayerSharedSrc *src = GST_PLAYER_SHARED_SRC (handler);
+  gchar *decoded;
+
+  if (GST_STATE (src) > GST_STATE_READY) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+        "Changing the URI while playing is not supported");
+    return FALSE;
+  }
+
+  if (!g_str_has_prefix (uri, SHARED_DECODE_PROTOCOL "://")) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_UNSUPPORTED_PROTOCOL,
+        "Unsupported URI '%s'", uri);
+    return FALSE;
+  }
+
+  decoded = g_uri_unescape_string (uri + strlen (SHARED_DECODE_PROTOCOL
+          "://"), NULL);
+  if (!decoded || !gst_uri_is_valid (decoded)) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+        "Invalid URI '%s'", uri);
+    g_free (decoded);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (src);
+  g_free (src->uri);
+  src->uri = decoded;
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+static void
+gst_player_shared_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_player_shared_src_uri_get_type;
+  iface->get_protocols = gst_player_shared_src_uri_get_protocols;
+  iface->get_uri = gst_player_shared_src_uri_get_uri;
+  iface->set_uri = gst_player_shared_src_uri_set_uri;
+}
+
+static gpointer
+register_shared_src (gpointer data)
+{
+  /* Nothing else handles the protocol, the rank only has to be high
+   * enough for gst_element_make_from_uri() */
+  return GINT_TO_POINTER (gst_element_register (NULL, "playersharedsrc",
+          GST_RANK_PRIMARY, GST_TYPE_PLAYER_SHARED_SRC));
+}
+
+/* Returns the URI that plays @uri from the decoding shared with the other
+ * players of it, or NULL if @uri is invalid */
+gchar *
+gst_player_shared_decode_make_uri (const gchar * uri)
+{
+  static GOnce once = G_ONCE_INIT;
+  gchar *escaped, *shared_uri;
+
+  if (!gst_uri_is_valid (uri))
+    return NULL;
+
+  if (!GPOINTER_TO_INT (g_once (&once, register_shared_src, NULL)))
+    return NULL;
+
+  escaped = g_uri_escape_string (uri, NULL, FALSE);
+  shared_uri = g_strconcat (SHARED_DECODE_PROTOCOL "://", escaped, NULL);
+  g_free (escaped);
+
+  return shared_uri;
+}
+
+/* Gets the number of players sharing the decoding with @element, returns
+ * FALSE if @element is not the shared decoding source */
+gboolean
+gst_player_shared_src_get_stats (GstElement * element, guint * players)
+{
+  GstPlayerSharedSrc *src;
+  SharedDecode *decode;
+
+  if (!GST_IS_PLAYER_SHARED_SRC (element))
+    return FALSE;
+
+  src = GST_PLAYER_SHARED_SRC (element);
+  GST_OBJECT_LOCK (src);
+  decode = src->decode;
+  if (decode)
+    shared_decode_ref (decode);
+  GST_OBJECT_UNLOCK (src);
+
+  *players = 0;
+  if (decode) {
+    g_mutex_lock (&decode->lock);
+    *players = g_list_length (decode->players);
+    g_mutex_unlock (&decode->lock);
+    shared_decode_unref (decode);
+  }
+
+  return TRUE;
+}
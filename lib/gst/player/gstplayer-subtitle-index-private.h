@@ -0,0 +1,46 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "gstplayer-subtitle-index.h"
+
+#ifndef __GST_PLAYER_SUBTITLE_INDEX_PRIVATE_H__
+#define __GST_PLAYER_SUBTITLE_INDEX_PRIVATE_H__
+
+typedef struct _GstPlayerSubtitleIndexer GstPlayerSubtitleIndexer;
+
+/* Called in the indexer's main context. Takes ownership of @index, which
+ * is NULL if parsing failed with @error */
+typedef void (*GstPlayerSubtitleIndexerDoneFunc) (GstPlayerSubtitleIndexer *
+    indexer, GstPlayerSubtitleIndex * index, const GError * error,
+    gpointer user_data);
+
+G_GNUC_INTERNAL GstElement*  gst_player_subtitle_index_make_source
+                             (GstPlayerSubtitleIndex *index);
+G_GNUC_INTERNAL gchar*       gst_player_subtitle_index_make_uri
+                             (GstPlayerSubtitleIndex *index);
+
+G_GNUC_INTERNAL GstPlayerSubtitleIndexer*  gst_player_subtitle_indexer_new
+                             (const gchar *uri, GMainContext *context,
+                              GstPlayerSubtitleIndexerDoneFunc done,
+                              gpointer user_data);
+G_GNUC_INTERNAL const gchar* gst_player_subtitle_indexer_get_uri
+                             (GstPlayerSubtitleIndexer *indexer);
+G_GNUC_INTERNAL void         gst_player_subtitle_indexer_free
+                             (GstPlayerSubtitleIndexer *indexer);
+
+#endif /* __GST_PLAYER_SUBTITLE_INDEX_PRIVATE_H__ */
@@ -0,0 +1,968 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstplayer-subtitleindex
+ * @short_description: GStreamer Player Subtitle Index API
+ *
+ * A #GstPlayerSubtitleIndex holds all cues of an external subtitle file,
+ * parsed once and sorted by start time. The cue texts are stored in one
+ * string arena. Finding the cues active at a position takes O(log n), which
+ * lets the player output subtitles right after seeks and lets applications
+ * implement subtitle search.
+ */
+
+#include "gstplayer-subtitle-index.h"
+#include "gstplayer-subtitle-index-private.h"
+#include "gstplayer.h"
+
+#include <gst/base/gstbasesrc.h>
+
+#include <string.h>
+
+/* Used if the parser didn't give a cue a duration and there is no next cue
+ * to end it */
+#define DEFAULT_CUE_DURATION (4 * GST_SECOND)
+
+/* Subtitle files are small, parsing one is given up on after this */
+#define INDEX_TIMEOUT (10 * GST_SECOND)
+
+#define SUBTITLE_SRC_PROTOCOL "gstplayer-subtitle"
+
+typedef struct
+{
+  GstClockTime start;
+  GstClockTime end;
+  guint32 text_offset;
+  guint32 text_size;
+} GstPlayerSubtitleCue;
+
+struct _GstPlayerSubtitleIndex
+{
+  gint refcount;
+
+  gchar *uri;
+  /* URI of the source serving the cues, protected by registry_lock */
+  gchar *source_uri;
+  GstCaps *caps;
+
+  /* Sorted by start time */
+  GstPlayerSubtitleCue *cues;
+  guint n_cues;
+
+  /* max_end[i] is the latest end time of cues[0] to cues[i] */
+  GstClockTime *max_end;
+
+  /* NUL-terminated texts of all cues */
+  gchar *arena;
+  gsize arena_size;
+};
+
+G_DEFINE_BOXED_TYPE (GstPlayerSubtitleIndex, gst_player_subtitle_index,
+    (GBoxedCopyFunc) gst_player_subtitle_index_ref,
+    (GBoxedFreeFunc) gst_player_subtitle_index_unref);
+
+static GMutex registry_lock;
+/* Source URI -> GstPlayerSubtitleIndex, not owning */
+static GHashTable *registry;
+
+typedef struct
+{
+  GArray *cues;
+  GString *arena;
+  GstCaps *caps;
+  GstElement *pipeline;
+} IndexBuilder;
+
+struct _GstPlayerSubtitleIndexer
+{
+  gchar *uri;
+  GMainContext *context;
+  GstPlayerSubtitleIndexerDoneFunc done;
+  gpointer user_data;
+
+  IndexBuilder builder;
+  GThread *thread;
+  gint cancelled;
+
+  /* Only accessed from the indexer thread until the done source is
+   * attached, then from the main context */
+  GstPlayerSubtitleIndex *index;
+  GError *error;
+  GSource *done_source;
+};
+
+static void
+index_builder_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  IndexBuilder *builder = user_data;
+  GstPlayerSubtitleCue cue;
+  GstMapInfo map;
+  gsize size;
+
+  if (!GST_BUFFER_PTS_IS_VALID (buffer))
+    return;
+
+  if (!builder->caps)
+    builder->caps = gst_pad_get_current_caps (pad);
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return;
+
+  size = map.size;
+  while (size > 0 && map.data[size - 1] == '\0')
+    size--;
+
+  if (size > 0) {
+    cue.start = GST_BUFFER_PTS (buffer);
+    if (GST_BUFFER_DURATION_IS_VALID (buffer))
+      cue.end = cue.start + GST_BUFFER_DURATION (buffer);
+    else
+      cue.end = GST_CLOCK_TIME_NONE;
+    cue.text_offset = builder->arena->len;
+    cue.text_size = size;
+
+    g_string_append_len (builder->arena, (const gchar *) map.data, size);
+    g_string_append_c (builder->arena, '\0');
+    g_array_append_val (builder->cues, cue);
+  }
+
+  gst_buffer_unmap (buffer, &map);
+}
+
+static gint
+cue_compare (gconstpointer a, gconstpointer b)
+{
+  const GstPlayerSubtitleCue *cue_a = a, *cue_b = b;
+
+  if (cue_a->start < cue_b->start)
+    return -1;
+  if (cue_a->start > cue_b->start)
+    return 1;
+  return 0;
+}
+
+/* Sets up the pipeline parsing @uri */
+static gboolean
+index_builder_init (IndexBuilder * builder, const gchar * uri,
+    GError ** error)
+{
+  GstElement *src, *parse, *sink;
+
+  builder->cues = g_array_new (FALSE, FALSE, sizeof (GstPlayerSubtitleCue));
+  builder->arena = g_string_new (NULL);
+  builder->caps = NULL;
+  builder->pipeline = NULL;
+
+  src = gst_element_make_from_uri (GST_URI_SRC, uri, NULL, error);
+  if (!src)
+    return FALSE;
+
+  parse = gst_element_factory_make ("subparse", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!parse || !sink) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Missing subparse or fakesink element");
+    gst_object_unref (src);
+    if (parse)
+      gst_object_unref (parse);
+    if (sink)
+      gst_object_unref (sink);
+    return FALSE;
+  }
+
+  builder->pipeline = gst_pipeline_new ("subtitle-indexer");
+  gst_bin_add_many (GST_BIN (builder->pipeline), src, parse, sink, NULL);
+  if (!gst_element_link_many (src, parse, sink, NULL)) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Failed to link subtitle parser");
+    return FALSE;
+  }
+
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (index_builder_handoff_cb),
+      builder);
+
+  return TRUE;
+}
+
+static void
+index_builder_clear (IndexBuilder * builder)
+{
+  if (builder->pipeline)
+    gst_object_unref (builder->pipeline);
+  builder->pipeline = NULL;
+  if (builder->cues)
+    g_array_free (builder->cues, TRUE);
+  builder->cues = NULL;
+  if (builder->arena)
+    g_string_free (builder->arena, TRUE);
+  builder->arena = NULL;
+  if (builder->caps)
+    gst_caps_unref (builder->caps);
+  builder->caps = NULL;
+}
+
+/* Runs the pipeline until the whole file is parsed, for at most
+ * INDEX_TIMEOUT. An application message on the bus cancels it */
+static gboolean
+index_builder_run (IndexBuilder * builder, GError ** error)
+{
+  GstStateChangeReturn state_ret;
+  GstMessage *msg;
+  GstBus *bus;
+  gboolean ret = TRUE;
+
+  bus = gst_element_get_bus (builder->pipeline);
+  state_ret = gst_element_set_state (builder->pipeline, GST_STATE_PLAYING);
+  if (state_ret == GST_STATE_CHANGE_FAILURE)
+    msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  else
+    msg = gst_bus_timed_pop_filtered (bus, INDEX_TIMEOUT,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR | GST_MESSAGE_APPLICATION);
+  gst_element_set_state (builder->pipeline, GST_STATE_NULL);
+
+  if (msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Failed to parse subtitle: %s", err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  } else if (msg && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_APPLICATION) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Subtitle parsing cancelled");
+    ret = FALSE;
+  } else if (!msg && state_ret == GST_STATE_CHANGE_FAILURE) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Failed to start subtitle parser");
+    ret = FALSE;
+  } else if (!msg) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "Timed out parsing subtitle");
+    ret = FALSE;
+  }
+
+  if (msg)
+    gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  return ret;
+}
+
+/* Builds the index from the parsed cues and clears @builder */
+static GstPlayerSubtitleIndex *
+index_builder_finish (IndexBuilder * builder, const gchar * uri,
+    GError ** error)
+{
+  GstPlayerSubtitleIndex *index;
+  guint i;
+
+  if (builder->cues->len == 0) {
+    g_set_error (error, GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+        "No subtitle cues found in '%s'", uri);
+    index_builder_clear (builder);
+    return NULL;
+  }
+
+  g_array_sort (builder->cues, cue_compare);
+
+  index = g_new0 (GstPlayerSubtitleIndex, 1);
+  index->refcount = 1;
+  index->uri = g_strdup (uri);
+  index->caps = builder->caps;
+  builder->caps = NULL;
+  if (!index->caps)
+    index->caps = gst_caps_new_simple ("text/x-raw", "format", G_TYPE_STRING,
+        "pango-markup", NULL);
+  index->n_cues = builder->cues->len;
+  index->cues = (GstPlayerSubtitleCue *) g_array_free (builder->cues, FALSE);
+  builder->cues = NULL;
+  index->arena_size = builder->arena->len;
+  index->arena = g_string_free (builder->arena, FALSE);
+  builder->arena = NULL;
+  index->max_end = g_new (GstClockTime, index->n_cues);
+
+  for (i = 0; i < index->n_cues; i++) {
+    GstPlayerSubtitleCue *cue = &index->cues[i];
+
+    /* Cues without duration last until the next one starts */
+    if (!GST_CLOCK_TIME_IS_VALID (cue->end)) {
+      if (i + 1 < index->n_cues && index->cues[i + 1].start > cue->start)
+        cue->end = index->cues[i + 1].start;
+      else
+        cue->end = cue->start + DEFAULT_CUE_DURATION;
+    }
+
+    if (i == 0 || cue->end > index->max_end[i - 1])
+      index->max_end[i] = cue->end;
+    else
+      index->max_end[i] = index->max_end[i - 1];
+  }
+
+  index_builder_clear (builder);
+
+  return index;
+}
+
+/**
+ * gst_player_subtitle_index_new_from_uri:
+ * @uri: URI of a subtitle file
+ * @error: return location for a #GError, or %NULL
+ *
+ * Parses all cues of the subtitle file at @uri. This blocks until the
+ * whole file is parsed, but at most 10 seconds.
+ *
+ * Returns: (transfer full): a new #GstPlayerSubtitleIndex, or %NULL if the
+ *   file could not be parsed in time or has no cues.
+ */
+GstPlayerSubtitleIndex *
+gst_player_subtitle_index_new_from_uri (const gchar * uri, GError ** error)
+{
+  IndexBuilder builder;
+
+  g_return_val_if_fail (uri != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (!index_builder_init (&builder, uri, error)
+      || !index_builder_run (&builder, error)) {
+    index_builder_clear (&builder);
+    return NULL;
+  }
+
+  return index_builder_finish (&builder, uri, error);
+}
+
+static gboolean
+subtitle_indexer_done_cb (gpointer user_data)
+{
+  GstPlayerSubtitleIndexer *indexer = user_data;
+  GstPlayerSubtitleIndex *index = indexer->index;
+  GError *error = indexer->error;
+
+  indexer->index = NULL;
+  indexer->error = NULL;
+  indexer->done (indexer, index, error, indexer->user_data);
+  g_clear_error (&error);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+subtitle_indexer_thread (gpointer user_data)
+{
+  GstPlayerSubtitleIndexer *indexer = user_data;
+
+  if (index_builder_run (&indexer->builder, &indexer->error))
+    indexer->index = index_builder_finish (&indexer->builder, indexer->uri,
+        &indexer->error);
+
+  if (g_atomic_int_get (&indexer->cancelled))
+    return NULL;
+
+  indexer->done_source = g_idle_source_new ();
+  g_source_set_callback (indexer->done_source, subtitle_indexer_done_cb,
+      indexer, NULL);
+  g_source_attach (indexer->done_source, indexer->context);
+
+  return NULL;
+}
+
+/* Starts parsing the subtitle at @uri in a new thread. Once finished @done
+ * is called from @context, unless the indexer was freed before */
+GstPlayerSubtitleIndexer *
+gst_player_subtitle_indexer_new (const gchar * uri, GMainContext * context,
+    GstPlayerSubtitleIndexerDoneFunc done, gpointer user_data)
+{
+  GstPlayerSubtitleIndexer *indexer;
+
+  indexer = g_new0 (GstPlayerSubtitleIndexer, 1);
+  indexer->uri = g_strdup (uri);
+  indexer->context = g_main_context_ref (context);
+  indexer->done = done;
+  indexer->user_data = user_data;
+
+  /* Failures to set up are reported like parse failures */
+  if (!index_builder_init (&indexer->builder, uri, &indexer->error)) {
+    index_builder_clear (&indexer->builder);
+    indexer->done_source = g_idle_source_new ();
+    g_source_set_callback (indexer->done_source, subtitle_indexer_done_cb,
+        indexer, NULL);
+    g_source_attach (indexer->done_source, indexer->context);
+    return indexer;
+  }
+
+  indexer->thread = g_thread_new ("GstPlayerSubtitleIndexer",
+      subtitle_indexer_thread, indexer);
+
+  return indexer;
+}
+
+const gchar *
+gst_player_subtitle_indexer_get_uri (GstPlayerSubtitleIndexer * indexer)
+{
+  return indexer->uri;
+}
+
+/* Must be called from the indexer's main context. Cancels parsing if it is
+ * still running */
+void
+gst_player_subtitle_indexer_free (GstPlayerSubtitleIndexer * indexer)
+{
+  GstBus *bus;
+
+  g_atomic_int_set (&indexer->cancelled, TRUE);
+  if (indexer->thread) {
+    bus = gst_element_get_bus (indexer->builder.pipeline);
+    gst_bus_post (bus, gst_message_new_application (NULL,
+            gst_structure_new_empty ("cancel")));
+    gst_object_unref (bus);
+
+    g_thread_join (indexer->thread);
+  }
+
+  if (indexer->done_source) {
+    g_source_destroy (indexer->done_source);
+    g_source_unref (indexer->done_source);
+  }
+
+  index_builder_clear (&indexer->builder);
+  if (indexer->index)
+    gst_player_subtitle_index_unref (indexer->index);
+  g_clear_error (&indexer->error);
+  g_main_context_unref (indexer->context);
+  g_free (indexer->uri);
+  g_free (indexer);
+}
+
+/**
+ * gst_player_subtitle_index_ref:
+ * @index: #GstPlayerSubtitleIndex instance
+ *
+ * Returns: (transfer full): @index with an additional reference.
+ */
+GstPlayerSubtitleIndex *
+gst_player_subtitle_index_ref (GstPlayerSubtitleIndex * index)
+{
+  g_return_val_if_fail (index != NULL, NULL);
+
+  g_atomic_int_inc (&index->refcount);
+
+  return index;
+}
+
+/**
+ * gst_player_subtitle_index_unref:
+ * @index: #GstPlayerSubtitleIndex instance
+ *
+ * Drops a reference of @index and frees it once the last reference is gone.
+ */
+void
+gst_player_subtitle_index_unref (GstPlayerSubtitleIndex * index)
+{
+  g_return_if_fail (index != NULL);
+
+  if (!g_atomic_int_dec_and_test (&index->refcount))
+    return;
+
+  /* Lookups only take a reference while it is still registered */
+  if (index->source_uri) {
+    g_mutex_lock (&registry_lock);
+    g_hash_table_remove (registry, index->source_uri);
+    g_mutex_unlock (&registry_lock);
+    g_free (index->source_uri);
+  }
+
+  g_free (index->uri);
+  gst_caps_unref (index->caps);
+  g_free (index->cues);
+  g_free (index->max_end);
+  g_free (index->arena);
+  g_free (index);
+}
+
+/**
+ * gst_player_subtitle_index_get_uri:
+ * @index: #GstPlayerSubtitleIndex instance
+ *
+ * Returns: the URI of the subtitle file.
+ */
+const gchar *
+gst_player_subtitle_index_get_uri (const GstPlayerSubtitleIndex * index)
+{
+  g_return_val_if_fail (index != NULL, NULL);
+
+  return index->uri;
+}
+
+/**
+ * gst_player_subtitle_index_get_n_cues:
+ * @index: #GstPlayerSubtitleIndex instance
+ *
+ * Returns: the number of cues in @index.
+ */
+guint
+gst_player_subtitle_index_get_n_cues (const GstPlayerSubtitleIndex * index)
+{
+  g_return_val_if_fail (index != NULL, 0);
+
+  return index->n_cues;
+}
+
+/**
+ * gst_player_subtitle_index_get_cue:
+ * @index: #GstPlayerSubtitleIndex instance
+ * @n: index of the cue
+ * @start: (out) (allow-none): start time of the cue
+ * @end: (out) (allow-none): end time of the cue
+ * @text: (out) (allow-none) (transfer none): text of the cue, possibly
+ *   with Pango markup. Valid as long as @index is.
+ *
+ * Returns: %TRUE if @n is a valid cue index.
+ */
+gboolean
+gst_player_subtitle_index_get_cue (const GstPlayerSubtitleIndex * index,
+    guint n, GstClockTime * start, GstClockTime * end, const gchar ** text)
+{
+  g_return_val_if_fail (index != NULL, FALSE);
+
+  if (n >= index->n_cues)
+    return FALSE;
+
+  if (start)
+    *start = index->cues[n].start;
+  if (end)
+    *end = index->cues[n].end;
+  if (text)
+    *text = index->arena + index->cues[n].text_offset;
+
+  return TRUE;
+}
+
+/* Number of cues starting at or before @position */
+static guint
+subtitle_index_count_started (const GstPlayerSubtitleIndex * index,
+    GstClockTime position)
+{
+  guint lo = 0, hi = index->n_cues;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (index->cues[mid].start <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/**
+ * gst_player_subtitle_index_find_cue:
+ * @index: #GstPlayerSubtitleIndex instance
+ * @position: position in nanoseconds
+ *
+ * Finds the earliest cue that is shown at @position. Further cues shown at
+ * the same time follow it, up to the first cue that starts after
+ * @position.
+ *
+ * Returns: the index of the cue, or -1 if no cue is shown at @position.
+ */
+gint
+gst_player_subtitle_index_find_cue (const GstPlayerSubtitleIndex * index,
+    GstClockTime position)
+{
+  guint lo, hi, started;
+
+  g_return_val_if_fail (index != NULL, -1);
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (position), -1);
+
+  started = subtitle_index_count_started (index, position);
+
+  /* The first cue whose prefix maximum end time is after position is the
+   * one that ends after position itself */
+  lo = 0;
+  hi = started;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (index->max_end[mid] > position)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  if (lo == started)
+    return -1;
+
+  return lo;
+}
+
+/**
+ * gst_player_subtitle_index_search:
+ * @index: #GstPlayerSubtitleIndex instance
+ * @text: text to search for
+ * @from: index of the first cue to look at
+ *
+ * Searches the cues for @text, ignoring case.
+ *
+ * Returns: the index of the first cue at or after @from containing @text,
+ *   or -1 if there is none.
+ */
+gint
+gst_player_subtitle_index_search (const GstPlayerSubtitleIndex * index,
+    const gchar * text, guint from)
+{
+  gchar *needle;
+  guint i;
+
+  g_return_val_if_fail (index != NULL, -1);
+  g_return_val_if_fail (text != NULL, -1);
+
+  needle = g_utf8_casefold (text, -1);
+  for (i = from; i < index->n_cues; i++) {
+    gchar *haystack;
+    gboolean found;
+
+    haystack = g_utf8_casefold (index->arena + index->cues[i].text_offset,
+        index->cues[i].text_size);
+    found = strstr (haystack, needle) != NULL;
+    g_free (haystack);
+
+    if (found)
+      break;
+  }
+  g_free (needle);
+
+  return i < index->n_cues ? (gint) i : -1;
+}
+
+/* Source element that outputs the cues of an index, used instead of a
+ * subtitle parser. Seeks only look up the first cue instead of parsing the
+ * file again */
+#define GST_TYPE_PLAYER_SUBTITLE_SRC (gst_player_subtitle_src_get_type ())
+#define GST_PLAYER_SUBTITLE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_PLAYER_SUBTITLE_SRC, GstPlayerSubtitleSrc))
+
+typedef struct
+{
+  GstBaseSrc parent;
+
+  GstPlayerSubtitleIndex *index;
+  guint next;
+} GstPlayerSubtitleSrc;
+
+typedef GstBaseSrcClass GstPlayerSubtitleSrcClass;
+
+static GstStaticPadTemplate subtitle_src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+G_GNUC_INTERNAL GType gst_player_subtitle_src_get_type (void);
+
+static void gst_player_subtitle_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_DEFINE_TYPE_WITH_CODE (GstPlayerSubtitleSrc, gst_player_subtitle_src,
+    GST_TYPE_BASE_SRC, G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_player_subtitle_src_uri_handler_init));
+
+/* Returns a new reference to the index served at @source_uri */
+static GstPlayerSubtitleIndex *
+subtitle_index_lookup (const gchar * source_uri)
+{
+  GstPlayerSubtitleIndex *index = NULL;
+  gint refcount;
+
+  g_mutex_lock (&registry_lock);
+  if (registry)
+    index = g_hash_table_lookup (registry, source_uri);
+  /* Skip an index whose last reference is being dropped right now */
+  while (index) {
+    refcount = g_atomic_int_get (&index->refcount);
+    if (refcount == 0)
+      index = NULL;
+    else if (g_atomic_int_compare_and_exchange (&index->refcount, refcount,
+            refcount + 1))
+      break;
+  }
+  g_mutex_unlock (&registry_lock);
+
+  return index;
+}
+
+static void
+gst_player_subtitle_src_finalize (GObject * object)
+{
+  GstPlayerSubtitleSrc *src = GST_PLAYER_SUBTITLE_SRC (object);
+
+  if (src->index)
+    gst_player_subtitle_index_unref (src->index);
+
+  G_OBJECT_CLASS (gst_player_subtitle_src_parent_class)->finalize (object);
+}
+
+static GstCaps *
+gst_player_subtitle_src_get_caps (GstBaseSrc * bsrc, GstCaps * filter)
+{
+  GstPlayerSubtitleSrc *src = GST_PLAYER_SUBTITLE_SRC (bsrc);
+  GstCaps *caps;
+
+  if (!src->index)
+    return GST_BASE_SRC_CLASS (gst_player_subtitle_src_parent_class)->get_caps
+        (bsrc, filter);
+
+  caps = gst_caps_ref (src->index->caps);
+  if (filter) {
+    GstCaps *tmp;
+
+    tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (caps);
+    caps = tmp;
+  }
+
+  return caps;
+}
+
+static gboolean
+gst_player_subtitle_src_start (GstBaseSrc * bsrc)
+{
+  GstPlayerSubtitleSrc *src = GST_PLAYER_SUBTITLE_SRC (bsrc);
+
+  if (!src->index) {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL),
+        ("No subtitle index to serve"));
+    return FALSE;
+  }
+
+  src->next = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_player_subtitle_src_is_seekable (GstBaseSrc * bsrc)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_player_subtitle_src_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
+{
+  GstPlayerSubtitleSrc *src = GST_PLAYER_SUBTITLE_SRC (bsrc);
+  gint first;
+
+  segment->time = segment->start;
+  segment->position = segment->start;
+
+  /* Cues are only output forwards */
+  if (segment->rate < 0.0) {
+    src->next = src->index->n_cues;
+    return TRUE;
+  }
+
+  first = gst_player_subtitle_index_find_cue (src->index, segment->start);
+  if (first >= 0)
+    src->next = first;
+  else
+    src->next = subtitle_index_count_started (src->index, segment->start);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_player_subtitle_src_create (GstBaseSrc * bsrc, guint64 offset, guint size,
+    GstBuffer ** buf)
+{
+  GstPlayerSubtitleSrc *src = GST_PLAYER_SUBTITLE_SRC (bsrc);
+  GstPlayerSubtitleIndex *index = src->index;
+  const GstPlayerSubtitleCue *cue;
+  GstBuffer *buffer;
+
+  if (src->next >= index->n_cues)
+    return GST_FLOW_EOS;
+
+  cue = &index->cues[src->next];
+  if (GST_CLOCK_TIME_IS_VALID (bsrc->segment.stop)
+      && cue->start >= bsrc->segment.stop)
+    return GST_FLOW_EOS;
+  src->next++;
+
+  /* The arena is immutable and outlives the buffer through the reference */
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      index->arena + cue->text_offset, cue->text_size, 0, cue->text_size,
+      gst_player_subtitle_index_ref (index),
+      (GDestroyNotify) gst_player_subtitle_index_unref);
+  GST_BUFFER_PTS (buffer) = cue->start;
+  GST_BUFFER_DURATION (buffer) = cue->end - cue->start;
+
+  *buf = buffer;
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_player_subtitle_src_init (GstPlayerSubtitleSrc * src)
+{
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
+}
+
+static void
+gst_player_subtitle_src_class_init (GstPlayerSubtitleSrcClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+  GstBaseSrcClass *basesrc_class = (GstBaseSrcClass *) klass;
+
+  gobject_class->finalize = gst_player_subtitle_src_finalize;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&subtitle_src_template));
+  gst_element_class_set_static_metadata (element_class,
+      "Player subtitle source", "Source/Subtitle",
+      "Outputs the cues of a pre-parsed subtitle index", "GstPlayer");
+
+  basesrc_class->get_caps = gst_player_subtitle_src_get_caps;
+  basesrc_class->start = gst_player_subtitle_src_start;
+  basesrc_class->is_seekable = gst_player_subtitle_src_is_seekable;
+  basesrc_class->do_seek = gst_player_subtitle_src_do_seek;
+  basesrc_class->create = gst_player_subtitle_src_create;
+}
+
+GstElement *
+gst_player_subtitle_index_make_source (GstPlayerSubtitleIndex * index)
+{
+  GstPlayerSubtitleSrc *src;
+
+  src = g_object_new (GST_TYPE_PLAYER_SUBTITLE_SRC, NULL);
+  src->index = gst_player_subtitle_index_ref (index);
+
+  return GST_ELEMENT (src);
+}
+
+static GstURIType
+gst_player_subtitle_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_player_subtitle_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { SUBTITLE_SRC_PROTOCOL, NULL };
+
+  return protocols;
+}
+
+static gchar *
+gst_player_subtitle_src_uri_get_uri (GstURIHandler * handler)
+{
+  GstPlayerSubtitleSrc *src = GST_PLAYER_SUBTITLE_SRC (handler);
+  gchar *uri = NULL;
+
+  GST_OBJECT_LOCK (src);
+  if (src->index) {
+    g_mutex_lock (&registry_lock);
+    uri = g_strdup (src->index->source_uri);
+    g_mutex_unlock (&registry_lock);
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  return uri;
+}
+
+static gboolean
+gst_player_subtitle_src_uri_set_uri (GstURIHandler * handler,
+    const gchar * uri, GError ** error)
+{
+  GstPlayerSubtitleSrc *src = GST_PLAYER_SUBTITLE_SRC (handler);
+  GstPlayerSubtitleIndex *index, *old;
+
+  if (GST_STATE (src) > GST_STATE_READY) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_STATE,
+        "Changing the URI while playing is not supported");
+    return FALSE;
+  }
+
+  index = subtitle_index_lookup (uri);
+  if (!index) {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+        "No subtitle index for '%s'", uri);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (src);
+  old = src->index;
+  src->index = index;
+  GST_OBJECT_UNLOCK (src);
+
+  if (old)
+    gst_player_subtitle_index_unref (old);
+
+  return TRUE;
+}
+
+static void
+gst_player_subtitle_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_player_subtitle_src_uri_get_type;
+  iface->get_protocols = gst_player_subtitle_src_uri_get_protocols;
+  iface->get_uri = gst_player_subtitle_src_uri_get_uri;
+  iface->set_uri = gst_player_subtitle_src_uri_set_uri;
+}
+
+static gpointer
+register_subtitle_src (gpointer data)
+{
+  /* Nothing else handles the protocol, the rank only has to be high enough
+   * for gst_element_make_from_uri() */
+  return GINT_TO_POINTER (gst_element_register (NULL, "playersubtitlesrc",
+          GST_RANK_PRIMARY, GST_TYPE_PLAYER_SUBTITLE_SRC));
+}
+
+/* Returns a URI serving the cues of @index for as long as @index exists,
+ * to be used instead of the subtitle file, or NULL */
+gchar *
+gst_player_subtitle_index_make_uri (GstPlayerSubtitleIndex * index)
+{
+  static GOnce once = G_ONCE_INIT;
+  static gint next_id;
+  gchar *uri;
+
+  if (!GPOINTER_TO_INT (g_once (&once, register_subtitle_src, NULL)))
+    return NULL;
+
+  g_mutex_lock (&registry_lock);
+  if (!index->source_uri) {
+    index->source_uri = g_strdup_printf (SUBTITLE_SRC_PROTOCOL "://%d",
+        g_atomic_int_add (&next_id, 1));
+    if (!registry)
+      registry = g_hash_table_new (g_str_hash, g_str_equal);
+    g_hash_table_insert (registry, index->source_uri, index);
+  }
+  uri = g_strdup (index->source_uri);
+  g_mutex_unlock (&registry_lock);
+
+  return uri;
+}
@@ -0,0 +1,61 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_PLAYER_SUBTITLE_INDEX_H__
+#define __GST_PLAYER_SUBTITLE_INDEX_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstPlayerSubtitleIndex:
+ *
+ * An immutable, pre-parsed index of all cues of an external subtitle file,
+ * sorted by start time.
+ */
+typedef struct _GstPlayerSubtitleIndex GstPlayerSubtitleIndex;
+
+#define GST_TYPE_PLAYER_SUBTITLE_INDEX (gst_player_subtitle_index_get_type ())
+GType gst_player_subtitle_index_get_type (void);
+
+GstPlayerSubtitleIndex * gst_player_subtitle_index_new_from_uri
+                                     (const gchar *uri, GError **error);
+GstPlayerSubtitleIndex * gst_player_subtitle_index_ref
+                                     (GstPlayerSubtitleIndex *index);
+void          gst_player_subtitle_index_unref
+                                     (GstPlayerSubtitleIndex *index);
+
+const gchar*  gst_player_subtitle_index_get_uri
+                                     (const GstPlayerSubtitleIndex *index);
+guint         gst_player_subtitle_index_get_n_cues
+                                     (const GstPlayerSubtitleIndex *index);
+gboolean      gst_player_subtitle_index_get_cue
+                                     (const GstPlayerSubtitleIndex *index,
+                                      guint n, GstClockTime *start,
+                                      GstClockTime *end, const gchar **text);
+gint          gst_player_subtitle_index_find_cue
+                                     (const GstPlayerSubtitleIndex *index,
+                                      GstClockTime position);
+gint          gst_player_subtitle_index_search
+                                     (const GstPlayerSubtitleIndex *index,
+                                      const gchar *text, guint from);
+
+G_END_DECLS
+
+#endif /* __GST_PLAYER_SUBTITLE_INDEX_H__ */
@@ -29,7 +29,6 @@
  *
  * - Equalizer
  * - Gapless playback
- * - Frame stepping
  * - Subtitle font, connection speed
  * - Deinterlacing
  * - Buffering control (-> progressive downloading)
@@ -40,8 +39,23 @@
 
 #include "gstplayer.h"
 #include "gstplayer-media-info-private.h"
+#include "gstplayer-subtitle-index-private.h"
+#include "gstplayer-keyframe-index-private.h"
+#include "gstplayer-discoverer-private.h"
+#include "gstplayer-resume-store-private.h"
+#include "gstplayer-mmap-src-private.h"
+#include "gstplayer-shared-decode-private.h"
+#include "gstplayer-remote-src-private.h"
+#include "gstplayer-audio-mixer-private.h"
+#include "gstplayer-clip-cache-private.h"
+#include "gstplayer-media-bytes-private.h"
+#include "gstplayer-http-cache-private.h"
+#include "gstplayer-abr-private.h"
+#include "gstplayer-group-private.h"
+#include "gstplayer-frame-cache-private.h"
 
 #include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
 #include <gst/video/video.h>
 #include <gst/video/colorbalance.h>
 #include <gst/tag/tag.h>
@@ -80,6 +94,20 @@ enum
   PROP_RATE,
   PROP_WINDOW_HANDLE,
   PROP_PIPELINE,
+  PROP_SEAMLESS_TRACK_SWITCH,
+  PROP_KEYFRAME_INDEX,
+  PROP_RESUME_STORE,
+  PROP_MMAP_SOURCE,
+  PROP_HTTP_CACHE_SIZE,
+  PROP_SHARED_DECODE,
+  PROP_REMOTE_DECODE,
+  PROP_SHARED_AUDIO_OUTPUT,
+  PROP_ADAPTIVE_BITRATE,
+  PROP_MIN_BITRATE,
+  PROP_MAX_BITRATE,
+  PROP_LOW_LATENCY,
+  PROP_TARGET_LATENCY,
+  PROP_FRAME_CACHE_SIZE,
   PROP_LAST
 };
 
@@ -96,6 +124,11 @@ enum
   SIGNAL_MEDIA_INFO_UPDATED,
   SIGNAL_VOLUME_CHANGED,
   SIGNAL_MUTE_CHANGED,
+  SIGNAL_TRACK_SWITCHED,
+  SIGNAL_MEDIA_INFO_DISCOVERED,
+  SIGNAL_COVER_ART_READY,
+  SIGNAL_VARIANT_SWITCHED,
+  SIGNAL_LOOP_ITERATION,
   SIGNAL_LAST
 };
 
@@ -107,6 +140,17 @@ enum
   GST_PLAY_FLAG_VIS = (1 << 3)
 };
 
+struct _GstPlayerLoadRequest
+{
+  gchar *uri;
+  gchar *suburi;
+  GstClockTime start_position;
+  gchar *audio_language;
+  gchar *subtitle_language;
+  gdouble rate;
+  gboolean paused;
+};
+
 struct _GstPlayer
 {
   GstObject parent;
@@ -137,15 +181,113 @@ struct _GstPlayer
   gint buffering;
 
   GstTagList *global_tags;
+  GstToc *global_toc;
   GstPlayerMediaInfo *media_info;
 
   GstElement *current_vis_element;
 
+  /* Only accessed atomically, bumped for every track switch request */
+  gint audio_switch_cookie;
+  gint text_switch_cookie;
+
+  /* Protected by lock */
+  gboolean seamless_track_switch;
+
+  /* External subtitle hot-added to the running pipeline, protected by lock */
+  GstElement *injected_sub_bin;
+  GstPad *injected_sub_pad;
+  /* Renders it if the media has no text stream of its own */
+  GstElement *injected_sub_overlay;
+  gint injected_sub_index;
+
+  /* Pre-parsed cues of the external subtitle, protected by lock */
+  GstPlayerSubtitleIndex *subtitle_index;
+  /* Parses the external subtitle, only accessed from main context */
+  GstPlayerSubtitleIndexer *subtitle_indexer;
+
+  /* Protected by lock */
+  gboolean keyframe_index;
+  /* Only accessed from main context */
+  GstPlayerKeyframeIndexer *keyframe_indexer;
+  /* Only accessed from main context */
+  GstDiscoverer *discoverer;
+
+  /* Protected by lock */
+  gboolean resume_store;
+  /* Only accessed from main context */
+  GstPlayerResumeStore *resume_positions;
+  gchar *resume_uri;
+  gint64 resume_last_save;
+
+  /* Protected by lock, used from the next URI change on */
+  gboolean mmap_source;
+  guint64 http_cache_size;
+  gboolean shared_decode;
+  gboolean remote_decode;
+  gboolean shared_audio_output;
+  /* Only accessed from main context */
+  GstElement *audio_mixer_sink;
+  GstElement *audio_sink_before_mixer;
+  GstPlayerAudioMixerVoices *clip_voices;
+  /* Protected by lock */
+  guint64 clip_cache_hits;
+  guint64 clip_cache_misses;
+
   /* Protected by lock */
+  gboolean adaptive_bitrate;
+  guint min_bitrate;
+  guint max_bitrate;
+  guint variant_bitrate;
+  guint64 bandwidth_estimate;
+  /* Only accessed from main context */
+  GstPlayerAbr *abr;
+  GstElement *adaptive_demux;
+  guint connection_speed;
+
+  /* Protected by lock */
+  gboolean low_latency;
+  GstClockTime target_latency;
+  GstClockTime live_edge_delay;
+  /* Only accessed from main context */
+  gboolean catching_up;
+
+  /* Protected by lock */
+  gboolean looping;
+  GstClockTime loop_start, loop_end;
+  /* Only accessed from main context */
+  guint loop_iteration;
+
+  /* Decoded frames to step back to, see gstplayer-frame-cache.c */
+  GstPlayerFrameCache *frame_cache;
+  /* Protected by lock */
+  guint64 frame_cache_size;
+  /* Only accessed from main context */
+  GstPad *frame_cache_pad;
+  gulong frame_cache_probe_id;
+  gulong cached_frame_probe_id;
+  GstPad *cached_audio_pad;
+  gulong cached_audio_probe_id;
+  GstClockTime step_target;
+
+  /* Memory backing the current URI, protected by lock */
+  GstPlayerMediaBytes *media_bytes;
   gboolean seek_pending;        /* Only set from main context */
   GstClockTime last_seek_time;  /* Only set from main context */
   GSource *seek_source;
   GstClockTime seek_position;
+  GstSeekFlags seek_flags;
+
+  /* Pending gst_player_load() request, protected by lock */
+  GstPlayerLoadRequest *load_request;
+  /* Preferred track languages until the next preroll, protected by lock */
+  gchar *audio_language;
+  gchar *subtitle_language;
+
+  /* Protected by lock */
+  gboolean scrubbing;
+  GstClockTime scrub_position;
+  /* Only accessed from main context */
+  gboolean scrub_resume;
 };
 
 struct _GstPlayerClass
@@ -171,6 +313,12 @@ static void gst_player_get_property (GObject * object, guint prop_id,
 
 static gpointer gst_player_main (gpointer data);
 
+static void update_input_selectors (GstPlayer * self, gboolean seamless);
+static gboolean is_input_selector (GstElement * element);
+static gboolean is_track_enabled (GstPlayer * self, gint pos);
+static GstPad *get_stream_pad (GstPlayer * self, gint stream_index,
+    GType type);
+
 static void gst_player_seek_internal_locked (GstPlayer * self);
 static gboolean gst_player_stop_internal (gpointer user_data);
 static gboolean gst_player_pause_internal (gpointer user_data);
@@ -199,6 +347,15 @@ static void gst_player_subtitle_info_update (GstPlayer * self,
     GstPlayerStreamInfo * stream_info);
 
 static void emit_media_info_updated_signal (GstPlayer * self);
+static void apply_track_preferences (GstPlayer * self);
+static gboolean gst_player_update_keyframe_index_internal (gpointer user_data);
+static void stop_keyframe_index (GstPlayer * self);
+static void stop_subtitle_index (GstPlayer * self);
+static void set_playbin_suburi (GstPlayer * self);
+static void configure_low_latency_sinks (GstPlayer * self);
+static void add_frame_cache_probe (GstPlayer * self, GstPad * pad);
+static void remove_frame_cache_probe (GstPlayer * self);
+static void remove_cached_frame_probe (GstPlayer * self);
 
 static void *get_title (GstTagList * tags);
 static void *get_container_format (GstTagList * tags);
@@ -218,7 +375,16 @@ gst_player_init (GstPlayer * self)
 
   self->seek_pending = FALSE;
   self->seek_position = GST_CLOCK_TIME_NONE;
+  self->seek_flags = 0;
   self->last_seek_time = GST_CLOCK_TIME_NONE;
+  self->scrub_position = GST_CLOCK_TIME_NONE;
+  self->injected_sub_index = -1;
+  self->abr = gst_player_abr_new ();
+  self->target_latency = 500 * GST_MSECOND;
+  self->live_edge_delay = GST_CLOCK_TIME_NONE;
+  self->loop_end = GST_CLOCK_TIME_NONE;
+  self->frame_cache = gst_player_frame_cache_new ();
+  self->step_target = GST_CLOCK_TIME_NONE;
   g_mutex_lock (&self->lock);
   self->thread = g_thread_new ("GstPlayer", gst_player_main, self);
   while (!self->loop || !g_main_loop_is_running (self->loop))
@@ -297,6 +463,81 @@ gst_player_class_init (GstPlayerClass * klass)
       g_param_spec_double ("rate", "rate", "Playback rate",
       -64.0, 64.0, 1.0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  param_specs[PROP_SEAMLESS_TRACK_SWITCH] =
+      g_param_spec_boolean ("seamless-track-switch", "Seamless track switch",
+      "Keep alternate audio and subtitle tracks buffered for glitch-free "
+      "track switching", FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_KEYFRAME_INDEX] =
+      g_param_spec_boolean ("keyframe-index", "Keyframe index",
+      "Index the keyframes of the media in the background after preroll",
+      FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_RESUME_STORE] =
+      g_param_spec_boolean ("resume-store", "Resume store",
+      "Remember playback positions and resume from them", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_MMAP_SOURCE] =
+      g_param_spec_boolean ("mmap-source", "mmap source",
+      "Read local files from a memory mapping instead of copying them",
+      FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_HTTP_CACHE_SIZE] =
+      g_param_spec_uint64 ("http-cache-size", "HTTP cache size",
+      "Size of the on-disk cache for HTTP media in bytes, 0 to disable it",
+      0, G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_SHARED_DECODE] =
+      g_param_spec_boolean ("shared-decode", "Shared decode",
+      "Share decoding with the other players of the same URI", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_REMOTE_DECODE] =
+      g_param_spec_boolean ("remote-decode", "Remote decode",
+      "Demux and decode media in a separate process", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_SHARED_AUDIO_OUTPUT] =
+      g_param_spec_boolean ("shared-audio-output", "Shared audio output",
+      "Play audio through one mixer and device shared by all players of the "
+      "process", FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_ADAPTIVE_BITRATE] =
+      g_param_spec_boolean ("adaptive-bitrate", "Adaptive bitrate",
+      "Select the variant of adaptive streams from the measured throughput "
+      "and the buffer level", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_MIN_BITRATE] =
+      g_param_spec_uint ("min-bitrate", "Minimum bitrate",
+      "Lowest bitrate adaptive bitrate selection goes down to in bits/s",
+      0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_MAX_BITRATE] =
+      g_param_spec_uint ("max-bitrate", "Maximum bitrate",
+      "Highest bitrate adaptive bitrate selection goes up to in bits/s, "
+      "0 for no limit", 0, G_MAXUINT, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_LOW_LATENCY] =
+      g_param_spec_boolean ("low-latency", "Low latency",
+      "Keep live playback close to the live edge", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_TARGET_LATENCY] =
+      g_param_spec_uint64 ("target-latency", "Target latency",
+      "Delay behind the live edge to keep live playback at in low-latency "
+      "mode", 0, G_MAXUINT64, 500 * GST_MSECOND,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  param_specs[PROP_FRAME_CACHE_SIZE] =
+      g_param_spec_uint64 ("frame-cache-size", "Frame cache size",
+      "Maximum size of the decoded video frames kept to step back to in "
+      "bytes, 0 to disable", 0, G_MAXUINT64, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
 
   signals[SIGNAL_POSITION_UPDATED] =
@@ -353,6 +594,32 @@ gst_player_class_init (GstPlayerClass * klass)
       g_signal_new ("warning", G_TYPE_FROM_CLASS (klass),
       G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
       NULL, NULL, G_TYPE_NONE, 1, G_TYPE_ERROR);
+
+  signals[SIGNAL_TRACK_SWITCHED] =
+      g_signal_new ("track-switched", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, GST_TYPE_PLAYER_STREAM_INFO,
+      GST_TYPE_CLOCK_TIME);
+
+  signals[SIGNAL_MEDIA_INFO_DISCOVERED] =
+      g_signal_new ("media-info-discovered", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, G_TYPE_STRING, GST_TYPE_PLAYER_MEDIA_INFO);
+
+  signals[SIGNAL_COVER_ART_READY] =
+      g_signal_new ("cover-art-ready", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 2, GST_TYPE_PLAYER_MEDIA_INFO, GST_TYPE_SAMPLE);
+
+  signals[SIGNAL_VARIANT_SWITCHED] =
+      g_signal_new ("variant-switched", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, G_TYPE_UINT);
+
+  signals[SIGNAL_LOOP_ITERATION] =
+      g_signal_new ("loop-iteration", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS, 0, NULL,
+      NULL, NULL, G_TYPE_NONE, 1, G_TYPE_UINT);
 }
 
 static void
@@ -369,30 +636,243 @@ gst_player_finalize (GObject * object)
   g_free (self->uri);
   if (self->suburi)
     g_free (self->suburi);
+  g_free (self->audio_language);
+  g_free (self->subtitle_language);
+  if (self->load_request)
+    gst_player_load_request_free (self->load_request);
+  if (self->media_bytes)
+    gst_player_media_bytes_unref (self->media_bytes);
   if (self->global_tags)
     gst_tag_list_unref (self->global_tags);
+  if (self->global_toc)
+    gst_toc_unref (self->global_toc);
   if (self->application_context)
     g_main_context_unref (self->application_context);
   if (self->current_vis_element)
     gst_object_unref (self->current_vis_element);
+  if (self->subtitle_index)
+    gst_player_subtitle_index_unref (self->subtitle_index);
+  gst_player_abr_free (self->abr);
+  gst_player_frame_cache_free (self->frame_cache);
   g_mutex_clear (&self->lock);
   g_cond_clear (&self->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+/* Positions are saved at most this often during playback */
+#define RESUME_SAVE_INTERVAL (5 * G_USEC_PER_SEC)
+/* Positions this close to the start or the end are not worth resuming */
+#define RESUME_MIN_POSITION (10 * GST_SECOND)
+#define RESUME_END_MARGIN (10 * GST_SECOND)
+#define RESUME_SEEK_FLAGS (GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_BEFORE)
+
+/* Returns the resume store if enabled, it is opened on first use. Must be
+ * called from the main context */
+static GstPlayerResumeStore *
+get_resume_store (GstPlayer * self)
+{
+  gboolean enabled;
+
+  g_mutex_lock (&self->lock);
+  enabled = self->resume_store;
+  g_mutex_unlock (&self->lock);
+
+  if (!enabled)
+    return NULL;
+
+  if (!self->resume_positions) {
+    self->resume_positions = gst_player_resume_store_open ();
+    if (!self->resume_positions)
+      GST_WARNING_OBJECT (self, "Failed to open resume store");
+  }
+
+  return self->resume_positions;
+}
+
+/* Saves @position as resume position of the current URI, or forgets it
+ * for GST_CLOCK_TIME_NONE. Unless @force is set this happens at most every
+ * RESUME_SAVE_INTERVAL. Must be called from the main context */
+static void
+update_resume_position (GstPlayer * self, GstClockTime position,
+    gboolean force)
+{
+  GstPlayerResumeStore *store;
+  gint64 now = g_get_monotonic_time ();
+  gint64 duration = -1;
+  gboolean seekable, seeking;
+
+  if (!self->resume_uri || (!force
+          && now - self->resume_last_save < RESUME_SAVE_INTERVAL))
+    return;
+
+  store = get_resume_store (self);
+  if (!store)
+    return;
+
+  g_mutex_lock (&self->lock);
+  seekable = self->media_info && self->media_info->seekable;
+  seeking = self->seek_pending
+      || GST_CLOCK_TIME_IS_VALID (self->seek_position);
+  g_mutex_unlock (&self->lock);
+
+  /* The position is meaningless until the seek is done */
+  if (seeking && GST_CLOCK_TIME_IS_VALID (position))
+    return;
+
+  self->resume_last_save = now;
+  gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
+
+  if (!seekable || !GST_CLOCK_TIME_IS_VALID (position)
+      || position < RESUME_MIN_POSITION || (duration > 0
+          && position + RESUME_END_MARGIN > duration)) {
+    gst_player_resume_store_remove (store, self->resume_uri);
+  } else {
+    GST_LOG_OBJECT (self, "Saving resume position %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (position));
+    gst_player_resume_store_save (store, self->resume_uri, position);
+  }
+}
+
+/* Lets the adaptive demuxer select variants up to the bitrate the ABR
+ * policy allows. Before the demuxer is known this is set on playbin, which
+ * passes it on when creating the demuxer. Must be called from the main
+ * context */
+static void
+update_connection_speed (GstPlayer * self)
+{
+  gboolean enabled;
+  guint min_bitrate, max_bitrate, speed;
+  guint64 bitrate;
+
+  g_mutex_lock (&self->lock);
+  enabled = self->adaptive_bitrate;
+  min_bitrate = self->min_bitrate;
+  max_bitrate = self->max_bitrate;
+  g_mutex_unlock (&self->lock);
+
+  if (!enabled)
+    return;
+
+  bitrate = gst_player_abr_select (self->abr, self->buffering, min_bitrate,
+      max_bitrate);
+
+  /* In kbps, 0 would let the demuxer decide on its own */
+  speed = MAX (bitrate / 1000, 1);
+  if (speed == self->connection_speed)
+    return;
+  self->connection_speed = speed;
+
+  GST_DEBUG_OBJECT (self, "Allowing variants up to %u kbps, estimated %"
+      G_GUINT64_FORMAT " bits/s", speed, gst_player_abr_get_estimate
+      (self->abr));
+
+  if (self->adaptive_demux)
+    g_object_set (self->adaptive_demux, "connection-speed", speed, NULL);
+  else
+    g_object_set (self->playbin, "connection-speed", (guint64) speed, NULL);
+}
+
+/* Drops the memory of the previous URI once the URI changed. The source
+ * keeps its own reference while it is still reading. Must be called with
+ * lock */
+static void
+drop_media_bytes_locked (GstPlayer * self)
+{
+  if (self->media_bytes && g_strcmp0 (self->uri,
+          gst_player_media_bytes_get_uri (self->media_bytes)) != 0) {
+    gst_player_media_bytes_unref (self->media_bytes);
+    self->media_bytes = NULL;
+  }
+}
+
+/* Sets the URI on playbin, rewritten for shared or remote decoding, the
+ * mmap source or the HTTP cache if these are used. Must be called with
+ * lock */
+static void
+set_playbin_uri_locked (GstPlayer * self)
+{
+  gchar *uri = NULL;
+
+  if (self->shared_decode && self->uri)
+    uri = gst_player_shared_decode_make_uri (self->uri);
+  if (self->remote_decode && self->uri && !uri)
+    uri = gst_player_remote_src_make_uri (self->uri);
+  if (self->mmap_source && self->uri && !uri)
+    uri = gst_player_mmap_src_make_uri (self->uri);
+  if (self->http_cache_size > 0 && self->uri && !uri)
+    uri = gst_player_http_cache_make_uri (self->uri);
+
+  g_object_set (self->playbin, "uri", uri ? uri : self->uri, NULL);
+  g_free (uri);
+}
+
+/* Swaps the audio sink of playbin for the one of the shared audio output
+ * or back to the previous one. Must be called from the main context while
+ * stopped */
+static void
+update_audio_mixer_sink (GstPlayer * self)
+{
+  gboolean enabled;
+
+  g_mutex_lock (&self->lock);
+  enabled = self->shared_audio_output;
+  g_mutex_unlock (&self->lock);
+
+  if (enabled == (self->audio_mixer_sink != NULL))
+    return;
+
+  if (enabled) {
+    g_object_get (self->playbin, "audio-sink", &self->audio_sink_before_mixer,
+        NULL);
+    self->audio_mixer_sink =
+        gst_object_ref_sink (gst_player_audio_mixer_sink_new ());
+    g_object_set (self->playbin, "audio-sink", self->audio_mixer_sink, NULL);
+  } else {
+    g_object_set (self->playbin, "audio-sink", self->audio_sink_before_mixer,
+        NULL);
+    gst_object_unref (self->audio_mixer_sink);
+    self->audio_mixer_sink = NULL;
+    if (self->audio_sink_before_mixer)
+      gst_object_unref (self->audio_sink_before_mixer);
+    self->audio_sink_before_mixer = NULL;
+  }
+}
+
 static gboolean
 gst_player_set_uri_internal (gpointer user_data)
 {
   GstPlayer *self = user_data;
+  GstPlayerResumeStore *resume_store;
+  GstClockTime resume_position = GST_CLOCK_TIME_NONE;
 
   gst_player_stop_internal (self);
+  update_audio_mixer_sink (self);
+
+  resume_store = get_resume_store (self);
 
   g_mutex_lock (&self->lock);
 
   GST_DEBUG_OBJECT (self, "Changing URI to '%s'", GST_STR_NULL (self->uri));
 
-  g_object_set (self->playbin, "uri", self->uri, NULL);
+  set_playbin_uri_locked (self);
+
+  /* Memory URIs are only valid in this process, nothing to resume */
+  g_free (self->resume_uri);
+  self->resume_uri = NULL;
+  if (self->uri && !gst_player_media_bytes_is_uri (self->uri))
+    self->resume_uri = g_strdup (self->uri);
+  if (resume_store && self->resume_uri)
+    resume_position = gst_player_resume_store_lookup (resume_store, self->uri);
+
+  /* playbin can't seek before the first preroll, this is applied as soon
+   * as it is PAUSED, before anything is played or a position reported */
+  if (GST_CLOCK_TIME_IS_VALID (resume_position)) {
+    GST_DEBUG_OBJECT (self, "Resuming at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (resume_position));
+    self->seek_position = resume_position;
+    self->seek_flags = RESUME_SEEK_FLAGS;
+  }
 
   /* if have suburi from previous playback then free it */
   if (self->suburi) {
@@ -400,2991 +880,7722 @@ gst_player_set_uri_internal (gpointer user_data)
     self->suburi = NULL;
     g_object_set (self->playbin, "suburi", NULL, NULL);
   }
+  if (self->subtitle_index) {
+    gst_player_subtitle_index_unref (self->subtitle_index);
+    self->subtitle_index = NULL;
+  }
+
+  self->variant_bitrate = 0;
+  self->bandwidth_estimate = 0;
+  self->live_edge_delay = GST_CLOCK_TIME_NONE;
 
   g_mutex_unlock (&self->lock);
 
+  stop_subtitle_index (self);
+
+  /* Adaptive streams start low again */
+  gst_player_abr_reset (self->abr);
+  if (self->adaptive_demux) {
+    gst_object_unref (self->adaptive_demux);
+    self->adaptive_demux = NULL;
+  }
+  self->connection_speed = 0;
+  self->catching_up = FALSE;
+  self->loop_iteration = 0;
+  g_object_set (self->playbin, "connection-speed", G_GUINT64_CONSTANT (0),
+      NULL);
+  update_connection_speed (self);
+
   return G_SOURCE_REMOVE;
 }
 
-static gboolean
-gst_player_set_suburi_internal (gpointer user_data)
+static GstPadProbeReturn
+injected_subtitle_flush_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
 {
-  GstPlayer *self = user_data;
-  GstClockTime position;
-  GstState target_state;
+  /* After a flushing seek the subtitle segment is aligned with the main
+   * streams again, the initial running time offset is not needed anymore */
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_FLUSH_STOP)
+    gst_pad_set_offset (pad, 0);
 
-  /* save the state and position */
-  target_state = self->target_state;
-  position = gst_player_get_position (self);
+  return GST_PAD_PROBE_OK;
+}
 
-  gst_player_stop_internal (self);
-  g_mutex_lock (&self->lock);
+/* Moves the video from the sink to the overlay in front of it. Called
+ * once the pad feeding the video sink is idle */
+static GstPadProbeReturn
+subtitle_overlay_link_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstElement *overlay = user_data;
+  GstPad *sinkpad, *videopad, *srcpad;
 
-  GST_DEBUG_OBJECT (self, "Changing SUBURI to '%s'",
-      GST_STR_NULL (self->suburi));
+  sinkpad = gst_pad_get_peer (pad);
+  if (!sinkpad)
+    return GST_PAD_PROBE_REMOVE;
 
-  g_object_set (self->playbin, "suburi", self->suburi, NULL);
-  g_object_set (self->playbin, "uri", self->uri, NULL);
+  videopad = gst_element_get_static_pad (overlay, "video_sink");
+  srcpad = gst_element_get_static_pad (overlay, "src");
 
-  g_mutex_unlock (&self->lock);
+  gst_pad_unlink (pad, sinkpad);
+  if (gst_pad_link (pad, videopad) != GST_PAD_LINK_OK
+      || gst_pad_link (srcpad, sinkpad) != GST_PAD_LINK_OK) {
+    GST_WARNING_OBJECT (overlay, "Failed to link subtitle overlay");
+    gst_pad_unlink (pad, videopad);
+    gst_pad_link (pad, sinkpad);
+  }
 
-  /* restore state and position */
-  if (position != GST_CLOCK_TIME_NONE)
-    gst_player_seek (self, position);
-  if (target_state == GST_STATE_PAUSED)
-    gst_player_pause_internal (self);
-  else if (target_state == GST_STATE_PLAYING)
-    gst_player_play_internal (self);
+  gst_object_unref (srcpad);
+  gst_object_unref (videopad);
+  gst_object_unref (sinkpad);
 
-  return G_SOURCE_REMOVE;
+  return GST_PAD_PROBE_REMOVE;
 }
 
-static void
-gst_player_set_property (GObject * object, guint prop_id,
-    const GValue * value, GParamSpec * pspec)
+/* Takes the overlay out of the video path again and drops it. Called
+ * once the pad feeding it is idle */
+static GstPadProbeReturn
+subtitle_overlay_unlink_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
 {
-  GstPlayer *self = GST_PLAYER (object);
-
-  switch (prop_id) {
-    case PROP_DISPATCH_TO_MAIN_CONTEXT:
-      self->dispatch_to_main_context = g_value_get_boolean (value);
-      self->application_context = g_main_context_ref_thread_default ();
-      break;
-    case PROP_URI:{
-      g_mutex_lock (&self->lock);
-      if (self->uri)
-        g_free (self->uri);
+  GstElement *overlay = user_data;
+  GstObject *parent;
+  GstPad *sinkpad, *videopad, *srcpad;
 
-      self->uri = g_value_dup_string (value);
-      GST_DEBUG_OBJECT (self, "Set uri=%s", self->uri);
-      g_mutex_unlock (&self->lock);
+  videopad = gst_element_get_static_pad (overlay, "video_sink");
+  srcpad = gst_element_get_static_pad (overlay, "src");
 
-      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-          gst_player_set_uri_internal, self, NULL);
-      break;
+  if (gst_pad_unlink (pad, videopad)) {
+    sinkpad = gst_pad_get_peer (srcpad);
+    if (sinkpad) {
+      gst_pad_unlink (srcpad, sinkpad);
+      gst_pad_link (pad, sinkpad);
+      gst_object_unref (sinkpad);
     }
-    case PROP_SUBURI:{
-      g_mutex_lock (&self->lock);
-      if (self->suburi)
-        g_free (self->suburi);
-
-      self->suburi = g_value_dup_string (value);
-      GST_DEBUG_OBJECT (self, "Set suburi=%s", self->suburi);
-      g_mutex_unlock (&self->lock);
+  }
 
-      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-          gst_player_set_suburi_internal, self, NULL);
-      break;
-    }
-    case PROP_VOLUME:
-      GST_DEBUG_OBJECT (self, "Set volume=%lf", g_value_get_double (value));
-      g_object_set_property (G_OBJECT (self->playbin), "volume", value);
-      break;
-    case PROP_RATE:
-      g_mutex_lock (&self->lock);
-      self->rate = g_value_get_double (value);
-      GST_DEBUG_OBJECT (self, "Set rate=%lf", g_value_get_double (value));
-      g_mutex_unlock (&self->lock);
+  gst_object_unref (srcpad);
+  gst_object_unref (videopad);
 
-      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-          gst_player_set_rate_internal, self, NULL);
-      break;
-    case PROP_MUTE:
-      GST_DEBUG_OBJECT (self, "Set mute=%d", g_value_get_boolean (value));
-      g_object_set_property (G_OBJECT (self->playbin), "mute", value);
-      break;
-    case PROP_WINDOW_HANDLE:
-      GST_DEBUG_OBJECT (self, "Set window handle from %p to %p",
-          (gpointer) self->window_handle, g_value_get_pointer (value));
-      self->window_handle = (guintptr) g_value_get_pointer (value);
-      gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (self->playbin),
-          self->window_handle);
-      break;
-    default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
+  gst_element_set_state (overlay, GST_STATE_NULL);
+  parent = gst_object_get_parent (GST_OBJECT (overlay));
+  if (parent) {
+    gst_bin_remove (GST_BIN (parent), overlay);
+    gst_object_unref (parent);
   }
+
+  return GST_PAD_PROBE_REMOVE;
 }
 
-static void
-gst_player_get_property (GObject * object, guint prop_id,
-    GValue * value, GParamSpec * pspec)
+/* Returns the video sink of playbin and the pad feeding it */
+static GstElement *
+get_video_sink (GstPlayer * self, GstPad ** peer)
 {
-  GstPlayer *self = GST_PLAYER (object);
+  GstElement *sink = NULL;
+  GstPad *sinkpad;
 
-  switch (prop_id) {
-    case PROP_URI:
-      g_mutex_lock (&self->lock);
-      g_value_set_string (value, self->uri);
-      g_mutex_unlock (&self->lock);
-      break;
-      GST_TRACE_OBJECT (self, "Returning is-playing=%d",
-          g_value_get_boolean (value));
-      break;
-    case PROP_SUBURI:
-      g_mutex_lock (&self->lock);
-      g_value_set_string (value, self->suburi);
-      g_mutex_unlock (&self->lock);
-      GST_DEBUG_OBJECT (self, "Returning has-suburi=%d",
-          g_value_get_boolean (value));
-      break;
-    case PROP_POSITION:{
-      gint64 position;
+  *peer = NULL;
 
-      gst_element_query_position (self->playbin, GST_FORMAT_TIME, &position);
-      g_value_set_uint64 (value, position);
-      GST_TRACE_OBJECT (self, "Returning position=%" GST_TIME_FORMAT,
-          GST_TIME_ARGS (g_value_get_uint64 (value)));
-      break;
-    }
-    case PROP_DURATION:{
-      gint64 duration;
+  g_object_get (self->playbin, "video-sink", &sink, NULL);
+  if (!sink)
+    return NULL;
 
-      gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
-      g_value_set_uint64 (value, duration);
-      GST_TRACE_OBJECT (self, "Returning duration=%" GST_TIME_FORMAT,
-          GST_TIME_ARGS (g_value_get_uint64 (value)));
-      break;
-    }
-    case PROP_MEDIA_INFO:{
-      GstPlayerMediaInfo *media_info = gst_player_get_media_info (self);
-      g_value_set_object (value, media_info);
-      g_object_unref (media_info);
-      break;
-    }
-    case PROP_CURRENT_AUDIO_TRACK:{
-      GstPlayerAudioInfo *audio_info =
-          gst_player_get_current_audio_track (self);
-      g_value_set_object (value, audio_info);
-      g_object_unref (audio_info);
-      break;
-    }
-    case PROP_CURRENT_VIDEO_TRACK:{
-      GstPlayerVideoInfo *video_info =
-          gst_player_get_current_video_track (self);
-      g_value_set_object (value, video_info);
-      g_object_unref (video_info);
-      break;
-    }
-    case PROP_CURRENT_SUBTITLE_TRACK:{
-      GstPlayerSubtitleInfo *subtitle_info =
-          gst_player_get_current_subtitle_track (self);
-      g_value_set_object (value, subtitle_info);
-      g_object_unref (subtitle_info);
-      break;
-    }
-    case PROP_VOLUME:
-      g_object_get_property (G_OBJECT (self->playbin), "volume", value);
-      GST_TRACE_OBJECT (self, "Returning volume=%lf",
-          g_value_get_double (value));
-      break;
-    case PROP_RATE:
-      g_mutex_lock (&self->lock);
-      g_value_set_double (value, gst_player_get_rate (self));
-      g_mutex_unlock (&self->lock);
-      break;
-    case PROP_MUTE:
-      g_object_get_property (G_OBJECT (self->playbin), "mute", value);
-      GST_TRACE_OBJECT (self, "Returning mute=%d", g_value_get_boolean (value));
-      break;
-    case PROP_WINDOW_HANDLE:
-      g_value_set_pointer (value, (gpointer) self->window_handle);
-      GST_TRACE_OBJECT (self, "Returning window-handle=%p",
-          g_value_get_pointer (value));
-      break;
-    case PROP_PIPELINE:
-      g_value_set_object (value, self->playbin);
-      break;
-    default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  if (sinkpad) {
+    *peer = gst_pad_get_peer (sinkpad);
+    gst_object_unref (sinkpad);
+  }
+  if (!*peer) {
+    gst_object_unref (sink);
+    return NULL;
   }
+
+  return sink;
 }
 
-static gboolean
-main_loop_running_cb (gpointer user_data)
+/* For media without text streams playbin has no text chain to feed, so a
+ * textoverlay is put in front of its video sink instead. The video is
+ * moved over once its pad is idle, which is only after the next buffer
+ * when paused. Returns the overlay, already added next to the sink */
+static GstElement *
+insert_subtitle_overlay (GstPlayer * self)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
+  GstElement *sink, *overlay = NULL;
+  GstObject *parent = NULL;
+  GstPad *peer, *videopad;
+  GstCaps *caps;
+  gboolean accepted = TRUE;
 
-  GST_TRACE_OBJECT (self, "Main loop running now");
+  sink = get_video_sink (self, &peer);
+  if (!sink)
+    return NULL;
 
-  g_mutex_lock (&self->lock);
-  g_cond_signal (&self->cond);
-  g_mutex_unlock (&self->lock);
+  parent = gst_object_get_parent (GST_OBJECT (sink));
+  if (!parent || !GST_IS_BIN (parent))
+    goto failed;
 
-  return G_SOURCE_REMOVE;
+  overlay = gst_element_factory_make ("textoverlay", NULL);
+  if (!overlay)
+    goto failed;
+
+  /* Video in formats the overlay can't handle would need a converter too,
+   * that's left to a restart */
+  caps = gst_pad_get_current_caps (peer);
+  if (caps) {
+    videopad = gst_element_get_static_pad (overlay, "video_sink");
+    accepted = gst_pad_query_accept_caps (videopad, caps);
+    gst_object_unref (videopad);
+    gst_caps_unref (caps);
+  }
+  if (!accepted)
+    goto failed;
+
+  g_object_set (overlay, "silent",
+      !is_track_enabled (self, GST_PLAY_FLAG_SUBTITLE), NULL);
+  gst_bin_add (GST_BIN (parent), gst_object_ref (overlay));
+  gst_element_sync_state_with_parent (overlay);
+  gst_pad_add_probe (peer, GST_PAD_PROBE_TYPE_IDLE,
+      subtitle_overlay_link_probe_cb, gst_object_ref (overlay),
+      gst_object_unref);
+
+  gst_object_unref (parent);
+  gst_object_unref (peer);
+  gst_object_unref (sink);
+
+  return overlay;
+
+failed:
+  if (overlay)
+    gst_object_unref (overlay);
+  if (parent)
+    gst_object_unref (parent);
+  gst_object_unref (peer);
+  gst_object_unref (sink);
+
+  return NULL;
 }
 
-typedef struct
-{
-  GstPlayer *player;
-  GstPlayerState state;
-} StateChangedSignalData;
+/* Takes @overlay out of the video path once it is idle */
+static void
+remove_subtitle_overlay (GstPlayer * self, GstElement * overlay)
+{
+  GstPad *videopad, *peer;
+  GstElement *sink = NULL;
+
+  /* Not linked yet if the video was not idle since it was added, then the
+   * pad feeding the sink first runs the pending link */
+  videopad = gst_element_get_static_pad (overlay, "video_sink");
+  peer = gst_pad_get_peer (videopad);
+  gst_object_unref (videopad);
+  if (!peer)
+    sink = get_video_sink (self, &peer);
+
+  if (peer) {
+    gst_pad_add_probe (peer, GST_PAD_PROBE_TYPE_IDLE,
+        subtitle_overlay_unlink_probe_cb, gst_object_ref (overlay),
+        gst_object_unref);
+    gst_object_unref (peer);
+  } else {
+    gst_element_set_state (overlay, GST_STATE_NULL);
+    if (GST_OBJECT_PARENT (overlay))
+      gst_bin_remove (GST_BIN (GST_OBJECT_PARENT (overlay)), overlay);
+  }
+
+  if (sink)
+    gst_object_unref (sink);
+}
 
+/* Parses the external subtitle in a side branch and feeds it into the text
+ * input-selector of the running pipeline, or into an overlay in front of
+ * the video sink if there is no text stream yet. The demuxer and decoders
+ * of the main streams are not touched.
+ *
+ * Must be called from the main context */
 static gboolean
-state_changed_dispatch (gpointer user_data)
-{
-  StateChangedSignalData *data = user_data;
+gst_player_inject_subtitle (GstPlayer * self, const gchar * suburi)
+{
+  GstElement *selector = NULL, *overlay = NULL, *bin, *src, *parse;
+  GstPlayerSubtitleIndex *index;
+  GstPad *pad, *srcpad, *sinkpad;
+  GstBin *parent;
+  GstClock *clock;
+  GstClockTime position, running_time;
+  GstPlayerStreamInfo *info;
+  gint n_text = 0;
 
-  g_signal_emit (data->player, signals[SIGNAL_STATE_CHANGED], 0, data->state);
+  if (self->current_state < GST_STATE_PAUSED || self->is_live
+      || self->rate != 1.0)
+    return FALSE;
 
-  return G_SOURCE_REMOVE;
-}
+  position = gst_player_get_position (self);
+  if (!GST_CLOCK_TIME_IS_VALID (position))
+    return FALSE;
 
-static void
-state_changed_signal_data_free (StateChangedSignalData * data)
-{
-  g_object_unref (data->player);
-  g_free (data);
-}
+  /* Feed playbin's text chain if it has one, otherwise overlay the video */
+  g_object_get (self->playbin, "n-text", &n_text, NULL);
+  if (n_text > 0) {
+    pad = get_stream_pad (self, 0, GST_TYPE_PLAYER_SUBTITLE_INFO);
+    if (pad) {
+      selector = gst_pad_get_parent_element (pad);
+      gst_object_unref (pad);
+    }
+    if (selector && !is_input_selector (selector)) {
+      gst_object_unref (selector);
+      selector = NULL;
+    }
+  } else {
+    overlay = insert_subtitle_overlay (self);
+  }
+  if (!selector && !overlay)
+    goto failed;
 
-static void
-change_state (GstPlayer * self, GstPlayerState state)
-{
-  if (state == self->app_state)
-    return;
+  g_mutex_lock (&self->lock);
+  index = self->subtitle_index ?
+      gst_player_subtitle_index_ref (self->subtitle_index) : NULL;
+  g_mutex_unlock (&self->lock);
 
-  GST_DEBUG_OBJECT (self, "Changing app state from %s to %s",
-      gst_player_state_get_name (self->app_state),
-      gst_player_state_get_name (state));
-  self->app_state = state;
+  bin = gst_bin_new (NULL);
+  if (index && !g_strcmp0 (gst_player_subtitle_index_get_uri (index), suburi)) {
+    /* Serve the cues from the pre-parsed index, no need to parse again */
+    src = gst_player_subtitle_index_make_source (index);
+    gst_bin_add (GST_BIN (bin), src);
+    pad = gst_element_get_static_pad (src, "src");
+  } else {
+    src = gst_element_make_from_uri (GST_URI_SRC, suburi, NULL, NULL);
+    parse = gst_element_factory_make ("subparse", NULL);
+    if (!src || !parse) {
+      if (src)
+        gst_object_unref (src);
+      if (parse)
+        gst_object_unref (parse);
+      pad = NULL;
+    } else {
+      gst_bin_add_many (GST_BIN (bin), src, parse, NULL);
+      if (gst_element_link (src, parse))
+        pad = gst_element_get_static_pad (parse, "src");
+      else
+        pad = NULL;
+    }
+  }
+  if (index)
+    gst_player_subtitle_index_unref (index);
 
-  if (self->dispatch_to_main_context
-      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_STATE_CHANGED], 0, NULL, NULL, NULL) != 0) {
-    StateChangedSignalData *data = g_new (StateChangedSignalData, 1);
+  if (!pad) {
+    gst_object_unref (bin);
+    goto failed;
+  }
 
-    data->player = g_object_ref (self);
-    data->state = state;
-    g_main_context_invoke_full (self->application_context,
-        G_PRIORITY_DEFAULT, state_changed_dispatch, data,
-        (GDestroyNotify) state_changed_signal_data_free);
+  srcpad = gst_ghost_pad_new ("src", pad);
+  gst_object_unref (pad);
+  gst_element_add_pad (bin, srcpad);
+
+  /* The branch goes next to the element it feeds */
+  if (selector) {
+    parent = GST_BIN (self->playbin);
+    sinkpad = gst_element_get_request_pad (selector, "sink_%u");
   } else {
-    g_signal_emit (self, signals[SIGNAL_STATE_CHANGED], 0, state);
+    parent = GST_BIN (GST_OBJECT_PARENT (overlay));
+    sinkpad = gst_element_get_static_pad (overlay, "text_sink");
+  }
+  if (!sinkpad) {
+    gst_object_unref (bin);
+    goto failed;
   }
-}
 
-typedef struct
-{
-  GstPlayer *player;
-  GstClockTime position;
-} PositionUpdatedSignalData;
+  gst_bin_add (parent, bin);
+  if (gst_pad_link (srcpad, sinkpad) != GST_PAD_LINK_OK) {
+    if (selector)
+      gst_element_release_request_pad (selector, sinkpad);
+    gst_object_unref (sinkpad);
+    gst_bin_remove (parent, bin);
+    goto failed;
+  }
 
-static gboolean
-position_updated_dispatch (gpointer user_data)
-{
-  PositionUpdatedSignalData *data = user_data;
+  /* The subtitle parser starts with a segment at 0, map the current
+   * position to the running time the main streams are at now */
+  clock = NULL;
+  if (self->current_state == GST_STATE_PLAYING)
+    clock = gst_element_get_clock (self->playbin);
+  if (clock) {
+    running_time = gst_clock_get_time (clock) -
+        gst_element_get_base_time (self->playbin);
+    gst_object_unref (clock);
+  } else {
+    running_time = gst_element_get_start_time (self->playbin);
+  }
+  gst_pad_set_offset (srcpad, (gint64) running_time - (gint64) position);
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      injected_subtitle_flush_probe_cb, NULL, NULL);
+
+  gst_element_sync_state_with_parent (bin);
+  if (selector) {
+    g_object_set (selector, "active-pad", sinkpad, NULL);
+    gst_object_unref (selector);
+  }
 
-  if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_POSITION_UPDATED], 0,
-        data->position);
-    g_object_notify_by_pspec (G_OBJECT (data->player),
-        param_specs[PROP_POSITION]);
+  GST_DEBUG_OBJECT (self, "Injected subtitle '%s' as text stream %d",
+      suburi, n_text);
+
+  /* The language of an external file is not known */
+  info = gst_player_stream_info_new (n_text, GST_TYPE_PLAYER_SUBTITLE_INFO);
+
+  g_mutex_lock (&self->lock);
+  self->injected_sub_bin = gst_object_ref (bin);
+  self->injected_sub_pad = sinkpad;
+  self->injected_sub_overlay = overlay;
+  self->injected_sub_index = n_text;
+  if (self->media_info) {
+    self->media_info->stream_list =
+        g_list_append (self->media_info->stream_list, info);
+    self->media_info->subtitle_stream_list =
+        g_list_append (self->media_info->subtitle_stream_list, info);
+  } else {
+    g_object_unref (info);
   }
+  g_mutex_unlock (&self->lock);
 
-  return G_SOURCE_REMOVE;
-}
+  emit_media_info_updated_signal (self);
 
-static void
-position_updated_signal_data_free (PositionUpdatedSignalData * data)
-{
-  g_object_unref (data->player);
-  g_free (data);
+  return TRUE;
+
+failed:
+  GST_DEBUG_OBJECT (self, "Can't inject subtitle '%s'", suburi);
+  if (selector)
+    gst_object_unref (selector);
+  if (overlay) {
+    remove_subtitle_overlay (self, overlay);
+    gst_object_unref (overlay);
+  }
+  return FALSE;
 }
 
+/* Must be called from the main context */
 static gboolean
-tick_cb (gpointer user_data)
+gst_player_remove_injected_subtitle (GstPlayer * self)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  gint64 position;
+  GstElement *bin, *overlay, *selector = NULL;
+  GstObject *parent;
+  GstPad *sinkpad, *srcpad;
+  GstPlayerStreamInfo *info;
+  gint index;
 
-  if (self->target_state >= GST_STATE_PAUSED
-      && gst_element_query_position (self->playbin, GST_FORMAT_TIME,
-          &position)) {
-    GST_LOG_OBJECT (self, "Position %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (position));
+  g_mutex_lock (&self->lock);
+  bin = self->injected_sub_bin;
+  sinkpad = self->injected_sub_pad;
+  overlay = self->injected_sub_overlay;
+  index = self->injected_sub_index;
+  self->injected_sub_bin = NULL;
+  self->injected_sub_pad = NULL;
+  self->injected_sub_overlay = NULL;
+  self->injected_sub_index = -1;
 
-    if (self->dispatch_to_main_context
-        && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-            signals[SIGNAL_POSITION_UPDATED], 0, NULL, NULL, NULL) != 0) {
-      PositionUpdatedSignalData *data = g_new (PositionUpdatedSignalData, 1);
+  info = gst_player_stream_info_find (self, self->media_info,
+      GST_TYPE_PLAYER_SUBTITLE_INFO, index);
+  if (info) {
+    self->media_info->stream_list =
+        g_list_remove (self->media_info->stream_list, info);
+    self->media_info->subtitle_stream_list =
+        g_list_remove (self->media_info->subtitle_stream_list, info);
+    g_object_unref (info);
+  }
+  g_mutex_unlock (&self->lock);
 
-      data->player = g_object_ref (self);
-      data->position = position;
-      g_main_context_invoke_full (self->application_context,
-          G_PRIORITY_DEFAULT, position_updated_dispatch, data,
-          (GDestroyNotify) position_updated_signal_data_free);
-    } else {
-      g_signal_emit (self, signals[SIGNAL_POSITION_UPDATED], 0, position);
-      g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_POSITION]);
+  if (!bin)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (self, "Removing injected subtitle");
+
+  if (!overlay)
+    selector = gst_pad_get_parent_element (sinkpad);
+  if (selector) {
+    GstPad *active_pad = NULL;
+
+    /* Switch back to playbin's own text stream so that flushing our branch
+     * is not forwarded downstream */
+    g_object_get (selector, "active-pad", &active_pad, NULL);
+    if (active_pad == sinkpad) {
+      gint current = 0;
+      GstPad *pad;
+
+      g_object_get (self->playbin, "current-text", &current, NULL);
+      pad = get_stream_pad (self, MAX (current, 0),
+          GST_TYPE_PLAYER_SUBTITLE_INFO);
+      if (pad) {
+        g_object_set (selector, "active-pad", pad, NULL);
+        gst_object_unref (pad);
+      }
     }
+    if (active_pad)
+      gst_object_unref (active_pad);
   }
 
-  return G_SOURCE_CONTINUE;
-}
-
-static void
-add_tick_source (GstPlayer * self)
-{
-  if (self->tick_source)
-    return;
+  /* Wake up our streaming thread if it is waiting inside the selector or
+   * the overlay */
+  srcpad = gst_element_get_static_pad (bin, "src");
+  gst_pad_push_event (srcpad, gst_event_new_flush_start ());
+  gst_element_set_state (bin, GST_STATE_NULL);
+  gst_pad_unlink (srcpad, sinkpad);
+  gst_object_unref (srcpad);
+
+  if (selector) {
+    gst_element_release_request_pad (selector, sinkpad);
+    gst_object_unref (selector);
+  }
+  gst_object_unref (sinkpad);
 
-  self->tick_source = g_timeout_source_new (100);
-  g_source_set_callback (self->tick_source, (GSourceFunc) tick_cb, self, NULL);
-  g_source_attach (self->tick_source, self->context);
-}
+  parent = gst_object_get_parent (GST_OBJECT (bin));
+  if (parent) {
+    gst_bin_remove (GST_BIN (parent), bin);
+    gst_object_unref (parent);
+  }
+  gst_object_unref (bin);
 
-static void
-remove_tick_source (GstPlayer * self)
-{
-  if (!self->tick_source)
-    return;
+  if (overlay) {
+    remove_subtitle_overlay (self, overlay);
+    gst_object_unref (overlay);
+  }
 
-  g_source_destroy (self->tick_source);
-  g_source_unref (self->tick_source);
-  self->tick_source = NULL;
+  return TRUE;
 }
 
 static gboolean
-ready_timeout_cb (gpointer user_data)
+injected_subtitle_is_active (GstPlayer * self)
 {
-  GstPlayer *self = user_data;
+  GstElement *selector = NULL;
+  GstPad *active_pad = NULL;
+  gboolean active = FALSE;
 
-  if (self->target_state <= GST_STATE_READY) {
-    GST_DEBUG_OBJECT (self, "Setting pipeline to NULL state");
-    self->target_state = GST_STATE_NULL;
-    self->current_state = GST_STATE_NULL;
-    gst_element_set_state (self->playbin, GST_STATE_NULL);
+  g_mutex_lock (&self->lock);
+  if (self->injected_sub_overlay) {
+    /* The only text stream there is, shown unless subtitles are off */
+    g_mutex_unlock (&self->lock);
+    return TRUE;
   }
+  if (self->injected_sub_pad)
+    selector = gst_pad_get_parent_element (self->injected_sub_pad);
+  g_mutex_unlock (&self->lock);
 
-  return G_SOURCE_REMOVE;
-}
+  if (!selector)
+    return FALSE;
 
-static void
-add_ready_timeout_source (GstPlayer * self)
-{
-  if (self->ready_timeout_source)
-    return;
+  g_object_get (selector, "active-pad", &active_pad, NULL);
+  if (active_pad) {
+    g_mutex_lock (&self->lock);
+    active = (active_pad == self->injected_sub_pad);
+    g_mutex_unlock (&self->lock);
+    gst_object_unref (active_pad);
+  }
+  gst_object_unref (selector);
 
-  self->ready_timeout_source = g_timeout_source_new_seconds (60);
-  g_source_set_callback (self->ready_timeout_source,
-      (GSourceFunc) ready_timeout_cb, self, NULL);
-  g_source_attach (self->ready_timeout_source, self->context);
+  return active;
 }
 
 static void
-remove_ready_timeout_source (GstPlayer * self)
+gst_player_restart_with_suburi (GstPlayer * self)
 {
-  if (!self->ready_timeout_source)
-    return;
+  GstClockTime position;
+  GstState target_state;
 
-  g_source_destroy (self->ready_timeout_source);
-  g_source_unref (self->ready_timeout_source);
-  self->ready_timeout_source = NULL;
-}
+  /* save the state and position */
+  target_state = self->target_state;
+  position = gst_player_get_position (self);
 
-typedef struct
-{
-  GstPlayer *player;
-  GError *err;
-} ErrorSignalData;
+  gst_player_stop_internal (self);
+  set_playbin_suburi (self);
+  g_mutex_lock (&self->lock);
 
-static gboolean
-error_dispatch (gpointer user_data)
-{
-  ErrorSignalData *data = user_data;
+  GST_DEBUG_OBJECT (self, "Changing SUBURI to '%s'",
+      GST_STR_NULL (self->suburi));
 
-  g_signal_emit (data->player, signals[SIGNAL_ERROR], 0, data->err);
+  set_playbin_uri_locked (self);
 
-  return G_SOURCE_REMOVE;
-}
+  g_mutex_unlock (&self->lock);
 
-static void
-free_error_signal_data (ErrorSignalData * data)
-{
-  g_object_unref (data->player);
-  g_clear_error (&data->err);
-  g_free (data);
+  /* restore state and position */
+  if (position != GST_CLOCK_TIME_NONE)
+    gst_player_seek (self, position);
+  if (target_state == GST_STATE_PAUSED)
+    gst_player_pause_internal (self);
+  else if (target_state == GST_STATE_PLAYING)
+    gst_player_play_internal (self);
 }
 
+/* Sets the subtitle of the next preroll on playbin. Once it is indexed
+ * playbin gets the cues from the index, so that seeks only look them up
+ * instead of parsing the file again */
 static void
-emit_error (GstPlayer * self, GError * err)
+set_playbin_suburi (GstPlayer * self)
 {
-  GST_ERROR_OBJECT (self, "Error: %s (%s, %d)", err->message,
-      g_quark_to_string (err->domain), err->code);
-
-  if (self->dispatch_to_main_context
-      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_ERROR], 0, NULL, NULL, NULL) != 0) {
-    ErrorSignalData *data = g_new (ErrorSignalData, 1);
-
-    data->player = g_object_ref (self);
-    data->err = g_error_copy (err);
-    g_main_context_invoke_full (self->application_context,
-        G_PRIORITY_DEFAULT, error_dispatch, data,
-        (GDestroyNotify) free_error_signal_data);
-  } else {
-    g_signal_emit (self, signals[SIGNAL_ERROR], 0, err);
-  }
-
-  g_error_free (err);
-
-  remove_tick_source (self);
-  remove_ready_timeout_source (self);
-
-  self->target_state = GST_STATE_NULL;
-  self->current_state = GST_STATE_NULL;
-  self->is_live = FALSE;
-  self->is_eos = FALSE;
-  gst_element_set_state (self->playbin, GST_STATE_NULL);
-  change_state (self, GST_PLAYER_STATE_STOPPED);
-  self->buffering = 100;
+  gchar *suburi = NULL;
 
   g_mutex_lock (&self->lock);
-  if (self->media_info) {
-    g_object_unref (self->media_info);
-    self->media_info = NULL;
-  }
-
-  if (self->global_tags) {
-    gst_tag_list_unref (self->global_tags);
-    self->global_tags = NULL;
-  }
-
-  self->seek_pending = FALSE;
-  if (self->seek_source) {
-    g_source_destroy (self->seek_source);
-    g_source_unref (self->seek_source);
-    self->seek_source = NULL;
-  }
-  self->seek_position = GST_CLOCK_TIME_NONE;
-  self->last_seek_time = GST_CLOCK_TIME_NONE;
+  if (self->suburi && self->subtitle_index
+      && !g_strcmp0 (gst_player_subtitle_index_get_uri (self->subtitle_index),
+          self->suburi))
+    suburi = gst_player_subtitle_index_make_uri (self->subtitle_index);
+  if (!suburi)
+    suburi = g_strdup (self->suburi);
   g_mutex_unlock (&self->lock);
+
+  g_object_set (self->playbin, "suburi", suburi, NULL);
+  g_free (suburi);
 }
 
 static void
-dump_dot_file (GstPlayer * self, const gchar * name)
+subtitle_indexer_done_cb (GstPlayerSubtitleIndexer * indexer,
+    GstPlayerSubtitleIndex * index, const GError * error, gpointer user_data)
 {
-  gchar *full_name;
-
-  full_name = g_strdup_printf ("gst-player.%p.%s", self, name);
-
-  GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS (GST_BIN (self->playbin),
-      GST_DEBUG_GRAPH_SHOW_ALL, full_name);
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstPlayerSubtitleIndex *old;
+  gboolean current;
 
-  g_free (full_name);
-}
+  if (index) {
+    GST_DEBUG_OBJECT (self, "Indexed %u subtitle cues of '%s'",
+        gst_player_subtitle_index_get_n_cues (index),
+        gst_player_subtitle_indexer_get_uri (indexer));
+  } else {
+    GST_WARNING_OBJECT (self, "Failed to index subtitle '%s': %s",
+        gst_player_subtitle_indexer_get_uri (indexer), error->message);
+  }
 
-typedef struct
-{
-  GstPlayer *player;
-  GError *err;
-} WarningSignalData;
+  gst_player_subtitle_indexer_free (indexer);
+  self->subtitle_indexer = NULL;
 
-static gboolean
-warning_dispatch (gpointer user_data)
-{
-  WarningSignalData *data = user_data;
+  g_mutex_lock (&self->lock);
+  old = self->subtitle_index;
+  self->subtitle_index = index;
+  current = index
+      && !g_strcmp0 (gst_player_subtitle_index_get_uri (index), self->suburi);
+  g_mutex_unlock (&self->lock);
 
-  g_signal_emit (data->player, signals[SIGNAL_WARNING], 0, data->err);
+  if (old)
+    gst_player_subtitle_index_unref (old);
 
-  return G_SOURCE_REMOVE;
+  /* Any later preroll, like after stopping, reads the cues from the index.
+   * A subtitle playbin is parsing already keeps its parser until then */
+  if (current)
+    set_playbin_suburi (self);
 }
 
 static void
-free_warning_signal_data (WarningSignalData * data)
+stop_subtitle_index (GstPlayer * self)
 {
-  g_object_unref (data->player);
-  g_clear_error (&data->err);
-  g_free (data);
+  if (self->subtitle_indexer) {
+    GST_DEBUG_OBJECT (self, "Cancelling subtitle indexing");
+    gst_player_subtitle_indexer_free (self->subtitle_indexer);
+    self->subtitle_indexer = NULL;
+  }
 }
 
+/* Parses the whole subtitle once in a separate thread, so that cues can be
+ * looked up after seeks without re-parsing the file. Until it is done the
+ * subtitle is parsed as usual */
 static void
-emit_warning (GstPlayer * self, GError * err)
+gst_player_update_subtitle_index (GstPlayer * self, const gchar * suburi)
 {
-  GST_ERROR_OBJECT (self, "Warning: %s (%s, %d)", err->message,
-      g_quark_to_string (err->domain), err->code);
+  GstPlayerSubtitleIndex *old;
 
-  if (self->dispatch_to_main_context
-      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_WARNING], 0, NULL, NULL, NULL) != 0) {
-    WarningSignalData *data = g_new (WarningSignalData, 1);
+  if (self->subtitle_indexer && suburi
+      && !g_strcmp0 (gst_player_subtitle_indexer_get_uri
+          (self->subtitle_indexer), suburi))
+    return;
 
-    data->player = g_object_ref (self);
-    data->err = g_error_copy (err);
-    g_main_context_invoke_full (self->application_context,
-        G_PRIORITY_DEFAULT, warning_dispatch, data,
-        (GDestroyNotify) free_warning_signal_data);
-  } else {
-    g_signal_emit (self, signals[SIGNAL_WARNING], 0, err);
+  g_mutex_lock (&self->lock);
+  if (suburi && self->subtitle_index
+      && !g_strcmp0 (gst_player_subtitle_index_get_uri (self->subtitle_index),
+          suburi)) {
+    g_mutex_unlock (&self->lock);
+    return;
   }
+  old = self->subtitle_index;
+  self->subtitle_index = NULL;
+  g_mutex_unlock (&self->lock);
 
-  g_error_free (err);
+  if (old)
+    gst_player_subtitle_index_unref (old);
+
+  stop_subtitle_index (self);
+  if (suburi)
+    self->subtitle_indexer = gst_player_subtitle_indexer_new (suburi,
+        self->context, subtitle_indexer_done_cb, self);
 }
 
-static void
-error_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+static gboolean
+gst_player_set_suburi_internal (gpointer user_data)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GError *err, *player_err;
-  gchar *name, *debug, *message, *full_message;
-
-  dump_dot_file (self, "error");
+  GstPlayer *self = user_data;
+  gchar *suburi;
+  gboolean injected;
 
-  gst_message_parse_error (msg, &err, &debug);
+  /* drop a previously hot-added subtitle, it is replaced now */
+  gst_player_remove_injected_subtitle (self);
 
-  name = gst_object_get_path_string (msg->src);
-  message = gst_error_get_message (err->domain, err->code);
+  g_mutex_lock (&self->lock);
+  suburi = g_strdup (self->suburi);
+  g_mutex_unlock (&self->lock);
 
-  if (debug)
-    full_message =
-        g_strdup_printf ("Error from element %s: %s\n%s\n%s", name, message,
-        err->message, debug);
-  else
-    full_message =
-        g_strdup_printf ("Error from element %s: %s\n%s", name, message,
-        err->message);
+  gst_player_update_subtitle_index (self, suburi);
 
-  GST_ERROR_OBJECT (self, "ERROR: from element %s: %s\n", name, err->message);
-  if (debug != NULL)
-    GST_ERROR_OBJECT (self, "Additional debug info:\n%s\n", debug);
+  injected = suburi && gst_player_inject_subtitle (self, suburi);
 
-  player_err =
-      g_error_new_literal (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-      full_message);
-  emit_error (self, player_err);
+  if (injected) {
+    /* Let playbin pick up the subtitle itself on the next preroll */
+    set_playbin_suburi (self);
+  } else {
+    gst_player_restart_with_suburi (self);
+  }
+  g_free (suburi);
 
-  g_clear_error (&err);
-  g_free (debug);
-  g_free (name);
-  g_free (full_message);
-  g_free (message);
+  return G_SOURCE_REMOVE;
 }
 
 static void
-warning_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+gst_player_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GError *err, *player_err;
-  gchar *name, *debug, *message, *full_message;
-
-  dump_dot_file (self, "warning");
-
-  gst_message_parse_warning (msg, &err, &debug);
-
-  name = gst_object_get_path_string (msg->src);
-  message = gst_error_get_message (err->domain, err->code);
+  GstPlayer *self = GST_PLAYER (object);
 
-  if (debug)
-    full_message =
-        g_strdup_printf ("Warning from element %s: %s\n%s\n%s", name, message,
-        err->message, debug);
-  else
-    full_message =
-        g_strdup_printf ("Warning from element %s: %s\n%s", name, message,
-        err->message);
+  switch (prop_id) {
+    case PROP_DISPATCH_TO_MAIN_CONTEXT:
+      self->dispatch_to_main_context = g_value_get_boolean (value);
+      self->application_context = g_main_context_ref_thread_default ();
+      break;
+    case PROP_URI:{
+      g_mutex_lock (&self->lock);
+      if (self->uri)
+        g_free (self->uri);
 
-  GST_WARNING_OBJECT (self, "WARNING: from element %s: %s\n", name,
-      err->message);
-  if (debug != NULL)
-    GST_WARNING_OBJECT (self, "Additional debug info:\n%s\n", debug);
+      self->uri = g_value_dup_string (value);
+      GST_DEBUG_OBJECT (self, "Set uri=%s", self->uri);
 
-  player_err =
-      g_error_new_literal (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-      full_message);
-  emit_warning (self, player_err);
+      /* A plain URI change replaces any load request that is not applied */
+      if (self->load_request) {
+        gst_player_load_request_free (self->load_request);
+        self->load_request = NULL;
+      }
+      g_free (self->audio_language);
+      self->audio_language = NULL;
+      g_free (self->subtitle_language);
+      self->subtitle_language = NULL;
+      drop_media_bytes_locked (self);
+      g_mutex_unlock (&self->lock);
 
-  g_clear_error (&err);
-  g_free (debug);
-  g_free (name);
-  g_free (full_message);
-  g_free (message);
-}
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_set_uri_internal, self, NULL);
+      break;
+    }
+    case PROP_SUBURI:{
+      g_mutex_lock (&self->lock);
+      if (self->suburi)
+        g_free (self->suburi);
 
-static gboolean
-eos_dispatch (gpointer user_data)
-{
-  g_signal_emit (user_data, signals[SIGNAL_END_OF_STREAM], 0);
+      self->suburi = g_value_dup_string (value);
+      GST_DEBUG_OBJECT (self, "Set suburi=%s", self->suburi);
+      g_mutex_unlock (&self->lock);
 
-  return G_SOURCE_REMOVE;
-}
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_set_suburi_internal, self, NULL);
+      break;
+    }
+    case PROP_VOLUME:
+      GST_DEBUG_OBJECT (self, "Set volume=%lf", g_value_get_double (value));
+      g_object_set_property (G_OBJECT (self->playbin), "volume", value);
+      break;
+    case PROP_RATE:
+      g_mutex_lock (&self->lock);
+      self->rate = g_value_get_double (value);
+      GST_DEBUG_OBJECT (self, "Set rate=%lf", g_value_get_double (value));
+      g_mutex_unlock (&self->lock);
 
-static void
-eos_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
-{
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_set_rate_internal, self, NULL);
+      break;
+    case PROP_MUTE:
+      GST_DEBUG_OBJECT (self, "Set mute=%d", g_value_get_boolean (value));
+      g_object_set_property (G_OBJECT (self->playbin), "mute", value);
+      break;
+    case PROP_WINDOW_HANDLE:
+      GST_DEBUG_OBJECT (self, "Set window handle from %p to %p",
+          (gpointer) self->window_handle, g_value_get_pointer (value));
+      self->window_handle = (guintptr) g_value_get_pointer (value);
+      gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (self->playbin),
+          self->window_handle);
+      break;
+    case PROP_SEAMLESS_TRACK_SWITCH:{
+      gboolean seamless = g_value_get_boolean (value);
+
+      g_mutex_lock (&self->lock);
+      self->seamless_track_switch = seamless;
+      g_mutex_unlock (&self->lock);
+
+      GST_DEBUG_OBJECT (self, "Set seamless-track-switch=%d", seamless);
+      update_input_selectors (self, seamless);
+      break;
+    }
+    case PROP_KEYFRAME_INDEX:
+      g_mutex_lock (&self->lock);
+      self->keyframe_index = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set keyframe-index=%d", self->keyframe_index);
+      g_mutex_unlock (&self->lock);
+      g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+          gst_player_update_keyframe_index_internal, self, NULL);
+      break;
+    case PROP_RESUME_STORE:
+      g_mutex_lock (&self->lock);
+      self->resume_store = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set resume-store=%d", self->resume_store);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MMAP_SOURCE:
+      g_mutex_lock (&self->lock);
+      self->mmap_source = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set mmap-source=%d", self->mmap_source);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_HTTP_CACHE_SIZE:
+      g_mutex_lock (&self->lock);
+      self->http_cache_size = g_value_get_uint64 (value);
+      GST_DEBUG_OBJECT (self, "Set http-cache-size=%" G_GUINT64_FORMAT,
+          self->http_cache_size);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_SHARED_DECODE:
+      g_mutex_lock (&self->lock);
+      self->shared_decode = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set shared-decode=%d", self->shared_decode);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_REMOTE_DECODE:
+      g_mutex_lock (&self->lock);
+      self->remote_decode = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set remote-decode=%d", self->remote_decode);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_SHARED_AUDIO_OUTPUT:
+      g_mutex_lock (&self->lock);
+      self->shared_audio_output = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set shared-audio-output=%d",
+          self->shared_audio_output);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_ADAPTIVE_BITRATE:
+      g_mutex_lock (&self->lock);
+      self->adaptive_bitrate = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set adaptive-bitrate=%d",
+          self->adaptive_bitrate);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MIN_BITRATE:
+      g_mutex_lock (&self->lock);
+      self->min_bitrate = g_value_get_uint (value);
+      GST_DEBUG_OBJECT (self, "Set min-bitrate=%u", self->min_bitrate);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MAX_BITRATE:
+      g_mutex_lock (&self->lock);
+      self->max_bitrate = g_value_get_uint (value);
+      GST_DEBUG_OBJECT (self, "Set max-bitrate=%u", self->max_bitrate);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_LOW_LATENCY:
+      g_mutex_lock (&self->lock);
+      self->low_latency = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set low-latency=%d", self->low_latency);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_TARGET_LATENCY:
+      g_mutex_lock (&self->lock);
+      self->target_latency = g_value_get_uint64 (value);
+      GST_DEBUG_OBJECT (self, "Set target-latency=%" GST_TIME_FORMAT,
+          GST_TIME_ARGS (self->target_latency));
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_FRAME_CACHE_SIZE:
+      g_mutex_lock (&self->lock);
+      self->frame_cache_size = g_value_get_uint64 (value);
+      GST_DEBUG_OBJECT (self, "Set frame-cache-size=%" G_GUINT64_FORMAT,
+          self->frame_cache_size);
+      gst_player_frame_cache_set_max_size (self->frame_cache,
+          self->frame_cache_size);
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* While a cached frame is shown, the other sinks still report the
+ * keyframe before it */
+static gboolean
+query_position (GstPlayer * self, gint64 * position)
+{
+  GstClockTime shown = gst_player_frame_cache_get_shown (self->frame_cache);
+
+  if (GST_CLOCK_TIME_IS_VALID (shown)) {
+    *position = shown;
+    return TRUE;
+  }
+
+  return gst_element_query_position (self->playbin, GST_FORMAT_TIME,
+      position);
+}
+
+static void
+gst_player_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPlayer *self = GST_PLAYER (object);
+
+  switch (prop_id) {
+    case PROP_URI:
+      g_mutex_lock (&self->lock);
+      g_value_set_string (value, self->uri);
+      g_mutex_unlock (&self->lock);
+      break;
+      GST_TRACE_OBJECT (self, "Returning is-playing=%d",
+          g_value_get_boolean (value));
+      break;
+    case PROP_SUBURI:
+      g_mutex_lock (&self->lock);
+      g_value_set_string (value, self->suburi);
+      g_mutex_unlock (&self->lock);
+      GST_DEBUG_OBJECT (self, "Returning has-suburi=%d",
+          g_value_get_boolean (value));
+      break;
+    case PROP_POSITION:{
+      gint64 position;
+
+      query_position (self, &position);
+      g_value_set_uint64 (value, position);
+      GST_TRACE_OBJECT (self, "Returning position=%" GST_TIME_FORMAT,
+          GST_TIME_ARGS (g_value_get_uint64 (value)));
+      break;
+    }
+    case PROP_DURATION:{
+      gint64 duration;
+
+      gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
+      g_value_set_uint64 (value, duration);
+      GST_TRACE_OBJECT (self, "Returning duration=%" GST_TIME_FORMAT,
+          GST_TIME_ARGS (g_value_get_uint64 (value)));
+      break;
+    }
+    case PROP_MEDIA_INFO:{
+      GstPlayerMediaInfo *media_info = gst_player_get_media_info (self);
+      g_value_set_object (value, media_info);
+      g_object_unref (media_info);
+      break;
+    }
+    case PROP_CURRENT_AUDIO_TRACK:{
+      GstPlayerAudioInfo *audio_info =
+          gst_player_get_current_audio_track (self);
+      g_value_set_object (value, audio_info);
+      g_object_unref (audio_info);
+      break;
+    }
+    case PROP_CURRENT_VIDEO_TRACK:{
+      GstPlayerVideoInfo *video_info =
+          gst_player_get_current_video_track (self);
+      g_value_set_object (value, video_info);
+      g_object_unref (video_info);
+      break;
+    }
+    case PROP_CURRENT_SUBTITLE_TRACK:{
+      GstPlayerSubtitleInfo *subtitle_info =
+          gst_player_get_current_subtitle_track (self);
+      g_value_set_object (value, subtitle_info);
+      g_object_unref (subtitle_info);
+      break;
+    }
+    case PROP_VOLUME:
+      g_object_get_property (G_OBJECT (self->playbin), "volume", value);
+      GST_TRACE_OBJECT (self, "Returning volume=%lf",
+          g_value_get_double (value));
+      break;
+    case PROP_RATE:
+      g_mutex_lock (&self->lock);
+      g_value_set_double (value, gst_player_get_rate (self));
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MUTE:
+      g_object_get_property (G_OBJECT (self->playbin), "mute", value);
+      GST_TRACE_OBJECT (self, "Returning mute=%d", g_value_get_boolean (value));
+      break;
+    case PROP_WINDOW_HANDLE:
+      g_value_set_pointer (value, (gpointer) self->window_handle);
+      GST_TRACE_OBJECT (self, "Returning window-handle=%p",
+          g_value_get_pointer (value));
+      break;
+    case PROP_PIPELINE:
+      g_value_set_object (value, self->playbin);
+      break;
+    case PROP_SEAMLESS_TRACK_SWITCH:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->seamless_track_switch);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_KEYFRAME_INDEX:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->keyframe_index);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_RESUME_STORE:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->resume_store);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MMAP_SOURCE:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->mmap_source);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_HTTP_CACHE_SIZE:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint64 (value, self->http_cache_size);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_SHARED_DECODE:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->shared_decode);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_REMOTE_DECODE:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->remote_decode);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_SHARED_AUDIO_OUTPUT:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->shared_audio_output);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_ADAPTIVE_BITRATE:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->adaptive_bitrate);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MIN_BITRATE:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->min_bitrate);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MAX_BITRATE:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->max_bitrate);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_LOW_LATENCY:
+      g_mutex_lock (&self->lock);
+      g_value_set_boolean (value, self->low_latency);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_TARGET_LATENCY:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint64 (value, self->target_latency);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_FRAME_CACHE_SIZE:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint64 (value, self->frame_cache_size);
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static gboolean
+main_loop_running_cb (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  GST_TRACE_OBJECT (self, "Main loop running now");
+
+  g_mutex_lock (&self->lock);
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  GstPlayerState state;
+} StateChangedSignalData;
+
+static gboolean
+state_changed_dispatch (gpointer user_data)
+{
+  StateChangedSignalData *data = user_data;
+
+  g_signal_emit (data->player, signals[SIGNAL_STATE_CHANGED], 0, data->state);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+state_changed_signal_data_free (StateChangedSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+change_state (GstPlayer * self, GstPlayerState state)
+{
+  if (state == self->app_state)
+    return;
+
+  GST_DEBUG_OBJECT (self, "Changing app state from %s to %s",
+      gst_player_state_get_name (self->app_state),
+      gst_player_state_get_name (state));
+  self->app_state = state;
+
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_STATE_CHANGED], 0, NULL, NULL, NULL) != 0) {
+    StateChangedSignalData *data = g_new (StateChangedSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->state = state;
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, state_changed_dispatch, data,
+        (GDestroyNotify) state_changed_signal_data_free);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_STATE_CHANGED], 0, state);
+  }
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  GstClockTime position;
+} PositionUpdatedSignalData;
+
+static gboolean
+position_updated_dispatch (gpointer user_data)
+{
+  PositionUpdatedSignalData *data = user_data;
+
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    g_signal_emit (data->player, signals[SIGNAL_POSITION_UPDATED], 0,
+        data->position);
+    g_object_notify_by_pspec (G_OBJECT (data->player),
+        param_specs[PROP_POSITION]);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+position_updated_signal_data_free (PositionUpdatedSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+/* How far behind the target live playback may fall before it speeds up,
+ * and the rate it then plays at. Mild enough to not be noticed much */
+#define LIVE_CATCH_UP_THRESHOLD (500 * GST_MSECOND)
+#define LIVE_CATCH_UP_RATE 1.1
+
+typedef struct
+{
+  GstClockTime now;
+  GstClockTime delay;
+} LiveSinkDelay;
+
+static void
+live_sink_delay_foreach (const GValue * item, gpointer user_data)
+{
+  GstElement *element = g_value_get_object (item);
+  LiveSinkDelay *data = user_data;
+  const GstSegment *segment;
+  GstClockTime running_time;
+  GstBuffer *buffer;
+  GstSample *sample;
+
+  /* Default and auto sinks are bins around the actual sink */
+  if (GST_IS_BIN (element)) {
+    GstIterator *it = gst_bin_iterate_sinks (GST_BIN (element));
+
+    while (gst_iterator_foreach (it, live_sink_delay_foreach,
+            data) == GST_ITERATOR_RESYNC)
+      gst_iterator_resync (it);
+    gst_iterator_free (it);
+    return;
+  }
+
+  if (!GST_IS_BASE_SINK (element))
+    return;
+
+  sample = gst_base_sink_get_last_sample (GST_BASE_SINK (element));
+  if (!sample)
+    return;
+
+  buffer = gst_sample_get_buffer (sample);
+  segment = gst_sample_get_segment (sample);
+  if (buffer && segment && segment->format == GST_FORMAT_TIME
+      && GST_BUFFER_PTS_IS_VALID (buffer)) {
+    running_time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+        GST_BUFFER_PTS (buffer));
+    /* The sink that is closest to the edge, sparse streams lag behind */
+    if (GST_CLOCK_TIME_IS_VALID (running_time) && data->now >= running_time
+        && (!GST_CLOCK_TIME_IS_VALID (data->delay)
+            || data->now - running_time < data->delay))
+      data->delay = data->now - running_time;
+  }
+  gst_sample_unref (sample);
+}
+
+/* Live sources timestamp their data with the running time it was captured
+ * at, so the distance of the last rendered buffers to the current running
+ * time is how far playback fell behind, including any drift between the
+ * sender and our clock. Returns GST_CLOCK_TIME_NONE before anything was
+ * rendered */
+static GstClockTime
+get_live_sink_delay (GstPlayer * self)
+{
+  LiveSinkDelay data;
+  GstIterator *it;
+  GstClock *clock;
+
+  clock = gst_element_get_clock (self->playbin);
+  if (!clock)
+    return GST_CLOCK_TIME_NONE;
+
+  data.now = gst_clock_get_time (clock) -
+      gst_element_get_base_time (self->playbin);
+  data.delay = GST_CLOCK_TIME_NONE;
+  gst_object_unref (clock);
+
+  it = gst_bin_iterate_sinks (GST_BIN (self->playbin));
+  while (gst_iterator_foreach (it, live_sink_delay_foreach,
+          &data) == GST_ITERATOR_RESYNC)
+    gst_iterator_resync (it);
+  gst_iterator_free (it);
+
+  return data.delay;
+}
+
+/* Returns how far playback is behind the live edge, or
+ * GST_CLOCK_TIME_NONE if the media is not live. For live streams with a
+ * seekable window, like live HLS or DASH, that is the distance to the end
+ * of the window and @window is set. For live sources it is measured from
+ * the timestamps of the rendered buffers, or is the latency of the
+ * pipeline until something was rendered. Must be called from the main
+ * context */
+static GstClockTime
+get_live_edge_delay (GstPlayer * self, GstClockTime position,
+    gboolean * window)
+{
+  GstClockTime min_latency, delay = GST_CLOCK_TIME_NONE;
+  gboolean seekable = FALSE, live = FALSE;
+  gint64 start, end, duration = -1;
+  GstQuery *query;
+
+  *window = FALSE;
+
+  /* Growing media has a seekable range but no duration */
+  query = gst_query_new_seeking (GST_FORMAT_TIME);
+  if (gst_element_query (self->playbin, query))
+    gst_query_parse_seeking (query, NULL, &seekable, &start, &end);
+  gst_query_unref (query);
+
+  if (seekable && end > 0 && GST_CLOCK_TIME_IS_VALID (position)
+      && (!gst_element_query_duration (self->playbin, GST_FORMAT_TIME,
+              &duration) || duration == -1)) {
+    *window = TRUE;
+    return end > position ? end - position : 0;
+  }
+
+  if (!self->is_live)
+    return GST_CLOCK_TIME_NONE;
+
+  if (self->current_state == GST_STATE_PLAYING) {
+    delay = get_live_sink_delay (self);
+    if (GST_CLOCK_TIME_IS_VALID (delay))
+      return delay;
+  }
+
+  query = gst_query_new_latency ();
+  if (gst_element_query (self->playbin, query)) {
+    gst_query_parse_latency (query, &live, &min_latency, NULL);
+    if (live)
+      delay = min_latency;
+  }
+  gst_query_unref (query);
+
+  return delay;
+}
+
+/* Changes the rate live playback catches up with. This is a non-flushing
+ * seek to the current position, so nothing that is buffered is dropped,
+ * the pipeline does not preroll again and the new rate applies from the
+ * data that follows. Must be called from the main context */
+static void
+set_live_catch_up_rate (GstPlayer * self, gdouble rate, GstClockTime position)
+{
+  GstEvent *event;
+
+  event = gst_event_new_seek (rate, GST_FORMAT_TIME, GST_SEEK_FLAG_NONE,
+      GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+  if (!gst_element_send_event (self->playbin, event))
+    GST_WARNING_OBJECT (self, "Failed to change the rate to %.2lf", rate);
+}
+
+/* Measures the live-edge delay and, in low-latency mode, plays a bit
+ * faster while it is too far above the target. That needs a seekable
+ * window, live sources are only kept at the target by their latency
+ * settings and the sinks dropping late buffers. Must be called from the
+ * main context */
+static void
+update_live_edge (GstPlayer * self, GstClockTime position)
+{
+  GstClockTime delay, target;
+  gboolean low_latency, window, catching_up, seeking;
+  gdouble rate;
+
+  delay = get_live_edge_delay (self, position, &window);
+
+  g_mutex_lock (&self->lock);
+  self->live_edge_delay = delay;
+  low_latency = self->low_latency;
+  target = self->target_latency;
+  rate = self->rate;
+  seeking = self->seek_pending || self->seek_source;
+  g_mutex_unlock (&self->lock);
+
+  /* Flushing seeks apply the catch-up rate themselves */
+  if (seeking)
+    return;
+
+  catching_up = self->catching_up;
+  if (!low_latency || !window || rate != 1.0 || self->buffering < 100)
+    catching_up = FALSE;
+  else if (delay > target + LIVE_CATCH_UP_THRESHOLD)
+    catching_up = TRUE;
+  else if (delay <= target)
+    catching_up = FALSE;
+
+  if (catching_up == self->catching_up)
+    return;
+
+  GST_DEBUG_OBJECT (self, "%s catching up, %" GST_TIME_FORMAT
+      " behind the live edge", catching_up ? "Start" : "Stop",
+      GST_TIME_ARGS (delay));
+
+  self->catching_up = catching_up;
+
+  /* The seek that changed the user rate already ignored catching up */
+  if (rate != 1.0)
+    return;
+
+  set_live_catch_up_rate (self, catching_up ? LIVE_CATCH_UP_RATE : 1.0,
+      position);
+}
+
+static gboolean
+tick_cb (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  gint64 position;
+
+  if (self->target_state >= GST_STATE_PAUSED
+      && query_position (self, &position)) {
+    GST_LOG_OBJECT (self, "Position %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (position));
+
+    update_resume_position (self, position, FALSE);
+    update_live_edge (self, position);
+
+    if (self->dispatch_to_main_context
+        && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+            signals[SIGNAL_POSITION_UPDATED], 0, NULL, NULL, NULL) != 0) {
+      PositionUpdatedSignalData *data = g_new (PositionUpdatedSignalData, 1);
+
+      data->player = g_object_ref (self);
+      data->position = position;
+      g_main_context_invoke_full (self->application_context,
+          G_PRIORITY_DEFAULT, position_updated_dispatch, data,
+          (GDestroyNotify) position_updated_signal_data_free);
+    } else {
+      g_signal_emit (self, signals[SIGNAL_POSITION_UPDATED], 0, position);
+      g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_POSITION]);
+    }
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+add_tick_source (GstPlayer * self)
+{
+  if (self->tick_source)
+    return;
+
+  self->tick_source = g_timeout_source_new (100);
+  g_source_set_callback (self->tick_source, (GSourceFunc) tick_cb, self, NULL);
+  g_source_attach (self->tick_source, self->context);
+}
+
+static void
+remove_tick_source (GstPlayer * self)
+{
+  if (!self->tick_source)
+    return;
+
+  g_source_destroy (self->tick_source);
+  g_source_unref (self->tick_source);
+  self->tick_source = NULL;
+}
+
+static gboolean
+ready_timeout_cb (gpointer user_data)
+{
+  GstPlayer *self = user_data;
+
+  if (self->target_state <= GST_STATE_READY) {
+    GST_DEBUG_OBJECT (self, "Setting pipeline to NULL state");
+    self->target_state = GST_STATE_NULL;
+    self->current_state = GST_STATE_NULL;
+    gst_element_set_state (self->playbin, GST_STATE_NULL);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+add_ready_timeout_source (GstPlayer * self)
+{
+  if (self->ready_timeout_source)
+    return;
+
+  self->ready_timeout_source = g_timeout_source_new_seconds (60);
+  g_source_set_callback (self->ready_timeout_source,
+      (GSourceFunc) ready_timeout_cb, self, NULL);
+  g_source_attach (self->ready_timeout_source, self->context);
+}
+
+static void
+remove_ready_timeout_source (GstPlayer * self)
+{
+  if (!self->ready_timeout_source)
+    return;
+
+  g_source_destroy (self->ready_timeout_source);
+  g_source_unref (self->ready_timeout_source);
+  self->ready_timeout_source = NULL;
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  GError *err;
+} ErrorSignalData;
+
+static gboolean
+error_dispatch (gpointer user_data)
+{
+  ErrorSignalData *data = user_data;
+
+  g_signal_emit (data->player, signals[SIGNAL_ERROR], 0, data->err);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+free_error_signal_data (ErrorSignalData * data)
+{
+  g_object_unref (data->player);
+  g_clear_error (&data->err);
+  g_free (data);
+}
+
+static void
+emit_error (GstPlayer * self, GError * err)
+{
+  GST_ERROR_OBJECT (self, "Error: %s (%s, %d)", err->message,
+      g_quark_to_string (err->domain), err->code);
+
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_ERROR], 0, NULL, NULL, NULL) != 0) {
+    ErrorSignalData *data = g_new (ErrorSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->err = g_error_copy (err);
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, error_dispatch, data,
+        (GDestroyNotify) free_error_signal_data);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_ERROR], 0, err);
+  }
+
+  g_error_free (err);
+
+  remove_tick_source (self);
+  remove_ready_timeout_source (self);
+  gst_player_remove_injected_subtitle (self);
+
+  self->target_state = GST_STATE_NULL;
+  self->current_state = GST_STATE_NULL;
+  self->is_live = FALSE;
+  self->is_eos = FALSE;
+  gst_element_set_state (self->playbin, GST_STATE_NULL);
+  change_state (self, GST_PLAYER_STATE_STOPPED);
+  self->buffering = 100;
+
+  g_mutex_lock (&self->lock);
+  if (self->media_info) {
+    g_object_unref (self->media_info);
+    self->media_info = NULL;
+  }
+
+  if (self->global_tags) {
+    gst_tag_list_unref (self->global_tags);
+    self->global_tags = NULL;
+  }
+
+  if (self->global_toc) {
+    gst_toc_unref (self->global_toc);
+    self->global_toc = NULL;
+  }
+
+  self->seek_pending = FALSE;
+  if (self->seek_source) {
+    g_source_destroy (self->seek_source);
+    g_source_unref (self->seek_source);
+    self->seek_source = NULL;
+  }
+  self->seek_position = GST_CLOCK_TIME_NONE;
+  self->seek_flags = 0;
+  self->last_seek_time = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+dump_dot_file (GstPlayer * self, const gchar * name)
+{
+  gchar *full_name;
+
+  full_name = g_strdup_printf ("gst-player.%p.%s", self, name);
+
+  GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS (GST_BIN (self->playbin),
+      GST_DEBUG_GRAPH_SHOW_ALL, full_name);
+
+  g_free (full_name);
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  GError *err;
+} WarningSignalData;
+
+static gboolean
+warning_dispatch (gpointer user_data)
+{
+  WarningSignalData *data = user_data;
+
+  g_signal_emit (data->player, signals[SIGNAL_WARNING], 0, data->err);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+free_warning_signal_data (WarningSignalData * data)
+{
+  g_object_unref (data->player);
+  g_clear_error (&data->err);
+  g_free (data);
+}
+
+static void
+emit_warning (GstPlayer * self, GError * err)
+{
+  GST_ERROR_OBJECT (self, "Warning: %s (%s, %d)", err->message,
+      g_quark_to_string (err->domain), err->code);
+
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_WARNING], 0, NULL, NULL, NULL) != 0) {
+    WarningSignalData *data = g_new (WarningSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->err = g_error_copy (err);
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, warning_dispatch, data,
+        (GDestroyNotify) free_warning_signal_data);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_WARNING], 0, err);
+  }
+
+  g_error_free (err);
+}
+
+static void
+error_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GError *err, *player_err;
+  gchar *name, *debug, *message, *full_message;
+  gboolean from_injected_sub;
+
+  dump_dot_file (self, "error");
+
+  g_mutex_lock (&self->lock);
+  from_injected_sub = (self->injected_sub_bin
+      && gst_object_has_as_ancestor (GST_MESSAGE_SRC (msg),
+          GST_OBJECT (self->injected_sub_bin)))
+      || (self->injected_sub_overlay
+      && GST_MESSAGE_SRC (msg) == GST_OBJECT (self->injected_sub_overlay));
+  g_mutex_unlock (&self->lock);
+
+  if (from_injected_sub) {
+    GST_WARNING_OBJECT (self, "Injected subtitle failed, restarting pipeline");
+    gst_player_remove_injected_subtitle (self);
+    gst_player_restart_with_suburi (self);
+    return;
+  }
+
+  gst_message_parse_error (msg, &err, &debug);
+
+  name = gst_object_get_path_string (msg->src);
+  message = gst_error_get_message (err->domain, err->code);
+
+  if (debug)
+    full_message =
+        g_strdup_printf ("Error from element %s: %s\n%s\n%s", name, message,
+        err->message, debug);
+  else
+    full_message =
+        g_strdup_printf ("Error from element %s: %s\n%s", name, message,
+        err->message);
+
+  GST_ERROR_OBJECT (self, "ERROR: from element %s: %s\n", name, err->message);
+  if (debug != NULL)
+    GST_ERROR_OBJECT (self, "Additional debug info:\n%s\n", debug);
+
+  player_err =
+      g_error_new_literal (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+      full_message);
+  emit_error (self, player_err);
+
+  g_clear_error (&err);
+  g_free (debug);
+  g_free (name);
+  g_free (full_message);
+  g_free (message);
+}
+
+static void
+warning_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GError *err, *player_err;
+  gchar *name, *debug, *message, *full_message;
+
+  dump_dot_file (self, "warning");
+
+  gst_message_parse_warning (msg, &err, &debug);
+
+  name = gst_object_get_path_string (msg->src);
+  message = gst_error_get_message (err->domain, err->code);
+
+  if (debug)
+    full_message =
+        g_strdup_printf ("Warning from element %s: %s\n%s\n%s", name, message,
+        err->message, debug);
+  else
+    full_message =
+        g_strdup_printf ("Warning from element %s: %s\n%s", name, message,
+        err->message);
+
+  GST_WARNING_OBJECT (self, "WARNING: from element %s: %s\n", name,
+      err->message);
+  if (debug != NULL)
+    GST_WARNING_OBJECT (self, "Additional debug info:\n%s\n", debug);
+
+  player_err =
+      g_error_new_literal (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+      full_message);
+  emit_warning (self, player_err);
+
+  g_clear_error (&err);
+  g_free (debug);
+  g_free (name);
+  g_free (full_message);
+  g_free (message);
+}
+
+static gboolean
+eos_dispatch (gpointer user_data)
+{
+  g_signal_emit (user_data, signals[SIGNAL_END_OF_STREAM], 0);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+eos_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  GST_DEBUG_OBJECT (self, "End of stream");
+
+  tick_cb (self);
+  remove_tick_source (self);
+  update_resume_position (self, GST_CLOCK_TIME_NONE, TRUE);
+
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_END_OF_STREAM], 0, NULL, NULL, NULL) != 0) {
+    g_main_context_invoke_full (self->application_context, G_PRIORITY_DEFAULT,
+        eos_dispatch, g_object_ref (self), (GDestroyNotify) g_object_unref);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_END_OF_STREAM], 0);
+  }
+  change_state (self, GST_PLAYER_STATE_STOPPED);
+  self->buffering = 100;
+  self->is_eos = TRUE;
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  guint iteration;
+} LoopIterationSignalData;
+
+static gboolean
+loop_iteration_dispatch (gpointer user_data)
+{
+  LoopIterationSignalData *data = user_data;
+
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    g_signal_emit (data->player, signals[SIGNAL_LOOP_ITERATION], 0,
+        data->iteration);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+loop_iteration_signal_data_free (LoopIterationSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+emit_loop_iteration (GstPlayer * self, guint iteration)
+{
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_LOOP_ITERATION], 0, NULL, NULL, NULL) != 0) {
+    LoopIterationSignalData *data = g_new (LoopIterationSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->iteration = iteration;
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, loop_iteration_dispatch, data,
+        (GDestroyNotify) loop_iteration_signal_data_free);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_LOOP_ITERATION], 0, iteration);
+  }
+}
+
+/* Finishes playback at @position after the last segment seek. In pull
+ * mode the demuxer task already paused at SEGMENT_DONE, so an EOS event
+ * sent into the pipeline would never arrive. A plain seek without the
+ * segment flag makes the demuxer continue and reach EOS itself */
+static void
+finish_segment (GstPlayer * self, gdouble rate, GstClockTime position)
+{
+  gint64 current;
+  gboolean ret;
+
+  if (!GST_CLOCK_TIME_IS_VALID (position)
+      && gst_element_query_position (self->playbin, GST_FORMAT_TIME, &current))
+    position = current;
+
+  if (!GST_CLOCK_TIME_IS_VALID (position))
+    ret = FALSE;
+  else if (rate >= 0.0)
+    ret = gst_element_seek (self->playbin, rate, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_NONE, GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE,
+        GST_CLOCK_TIME_NONE);
+  else
+    ret = gst_element_seek (self->playbin, rate, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_NONE, GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET,
+        position);
+
+  if (!ret) {
+    GST_WARNING_OBJECT (self, "Failed to finish segment, sending EOS");
+    gst_element_send_event (self->playbin, gst_event_new_eos ());
+  }
+}
+
+/* Posted instead of EOS at the end of a segment seek. The seek for the
+ * next iteration is not flushing, so its data directly follows the data
+ * that is still queued and playback wraps around without a gap */
+static void
+segment_done_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstClockTime start, end;
+  GstSeekFlags flags = GST_SEEK_FLAG_SEGMENT | GST_SEEK_FLAG_ACCURATE;
+  GstFormat format;
+  gint64 position;
+  gboolean loop;
+  gdouble rate;
+
+  gst_message_parse_segment_done (msg, &format, &position);
+
+  g_mutex_lock (&self->lock);
+  loop = self->looping;
+  start = self->loop_start;
+  end = self->loop_end;
+  rate = self->rate;
+  g_mutex_unlock (&self->lock);
+
+  /* Looping was disabled after the last segment seek */
+  if (!loop) {
+    GST_DEBUG_OBJECT (self, "Segment done without loop, finishing");
+    finish_segment (self, rate, format == GST_FORMAT_TIME ? position :
+        GST_CLOCK_TIME_NONE);
+    return;
+  }
+
+  if (rate != 1.0)
+    flags |= GST_SEEK_FLAG_TRICKMODE;
+
+  if (!gst_element_seek (self->playbin, rate, GST_FORMAT_TIME, flags,
+          GST_SEEK_TYPE_SET, start, GST_CLOCK_TIME_IS_VALID (end) ?
+          GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE, end)) {
+    GST_WARNING_OBJECT (self, "Failed to loop, finishing");
+    finish_segment (self, rate, format == GST_FORMAT_TIME ? position :
+        GST_CLOCK_TIME_NONE);
+    return;
+  }
+
+  self->loop_iteration++;
+  GST_DEBUG_OBJECT (self, "Loop iteration %u", self->loop_iteration);
+  emit_loop_iteration (self, self->loop_iteration);
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  gint percent;
+} BufferingSignalData;
+
+static gboolean
+buffering_dispatch (gpointer user_data)
+{
+  BufferingSignalData *data = user_data;
+
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    g_signal_emit (data->player, signals[SIGNAL_BUFFERING], 0, data->percent);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+buffering_signal_data_free (BufferingSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+buffering_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  gint percent;
+
+  if (self->target_state < GST_STATE_PAUSED)
+    return;
+  if (self->is_live)
+    return;
+
+  gst_message_parse_buffering (msg, &percent);
+  GST_LOG_OBJECT (self, "Buffering %d%%", percent);
+
+  if (percent < 100 && self->target_state >= GST_STATE_PAUSED) {
+    GstStateChangeReturn state_ret;
+
+    GST_DEBUG_OBJECT (self, "Waiting for buffering to finish");
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
+
+    if (state_ret == GST_STATE_CHANGE_FAILURE) {
+      emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+              "Failed to handle buffering"));
+      return;
+    }
+
+    change_state (self, GST_PLAYER_STATE_BUFFERING);
+  }
+
+  if (self->buffering != percent) {
+    if (self->dispatch_to_main_context
+        && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+            signals[SIGNAL_BUFFERING], 0, NULL, NULL, NULL) != 0) {
+      BufferingSignalData *data = g_new (BufferingSignalData, 1);
+
+      data->player = g_object_ref (self);
+      data->percent = percent;
+      g_main_context_invoke_full (self->application_context,
+          G_PRIORITY_DEFAULT, buffering_dispatch, data,
+          (GDestroyNotify) buffering_signal_data_free);
+    } else {
+      g_signal_emit (self, signals[SIGNAL_BUFFERING], 0, percent);
+    }
+
+    self->buffering = percent;
+    update_connection_speed (self);
+  }
+
+
+  g_mutex_lock (&self->lock);
+  if (percent == 100 && (self->seek_position != GST_CLOCK_TIME_NONE ||
+          self->seek_pending)) {
+    g_mutex_unlock (&self->lock);
+
+    GST_DEBUG_OBJECT (self, "Buffering finished - seek pending");
+  } else if (percent == 100 && self->target_state >= GST_STATE_PLAYING
+      && self->current_state >= GST_STATE_PAUSED) {
+    GstStateChangeReturn state_ret;
+
+    g_mutex_unlock (&self->lock);
+
+    GST_DEBUG_OBJECT (self, "Buffering finished - going to PLAYING");
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
+    /* Application state change is happening when the state change happened */
+    if (state_ret == GST_STATE_CHANGE_FAILURE)
+      emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+              "Failed to handle buffering"));
+  } else if (percent == 100 && self->target_state >= GST_STATE_PAUSED) {
+    g_mutex_unlock (&self->lock);
+
+    GST_DEBUG_OBJECT (self, "Buffering finished - staying PAUSED");
+    change_state (self, GST_PLAYER_STATE_PAUSED);
+  } else {
+    g_mutex_unlock (&self->lock);
+  }
+}
+
+static void
+clock_lost_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstStateChangeReturn state_ret;
+
+  GST_DEBUG_OBJECT (self, "Clock lost");
+  if (self->target_state >= GST_STATE_PLAYING) {
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
+    if (state_ret != GST_STATE_CHANGE_FAILURE)
+      state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
+
+    if (state_ret == GST_STATE_CHANGE_FAILURE)
+      emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+              "Failed to handle clock loss"));
+  }
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  gint width, height;
+} VideoDimensionsChangedSignalData;
+
+static gboolean
+video_dimensions_changed_dispatch (gpointer user_data)
+{
+  VideoDimensionsChangedSignalData *data = user_data;
+
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    g_signal_emit (data->player, signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0,
+        data->width, data->height);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+video_dimensions_changed_signal_data_free (VideoDimensionsChangedSignalData *
+    data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+check_video_dimensions_changed (GstPlayer * self)
+{
+  GstElement *video_sink;
+  GstPad *video_sink_pad;
+  GstCaps *caps;
+  GstVideoInfo info;
+  gint width = 0, height = 0;
+
+  g_object_get (self->playbin, "video-sink", &video_sink, NULL);
+  if (!video_sink)
+    goto out;
+
+  video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
+  if (!video_sink_pad) {
+    gst_object_unref (video_sink);
+    goto out;
+  }
+
+  caps = gst_pad_get_current_caps (video_sink_pad);
+
+  if (caps) {
+    if (gst_video_info_from_caps (&info, caps)) {
+      info.width = info.width * info.par_n / info.par_d;
+
+      GST_DEBUG_OBJECT (self, "Video dimensions changed: %dx%d", info.width,
+          info.height);
+      width = info.width;
+      height = info.height;
+    }
+
+    gst_caps_unref (caps);
+  }
+  gst_object_unref (video_sink_pad);
+  gst_object_unref (video_sink);
+
+out:
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0, NULL, NULL, NULL) != 0) {
+    VideoDimensionsChangedSignalData *data =
+        g_new (VideoDimensionsChangedSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->width = width;
+    data->height = height;
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, video_dimensions_changed_dispatch, data,
+        (GDestroyNotify) video_dimensions_changed_signal_data_free);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0,
+        width, height);
+  }
+}
+
+static void
+notify_caps_cb (GObject * object, GParamSpec * pspec, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  check_video_dimensions_changed (self);
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  GstClockTime duration;
+} DurationChangedSignalData;
+
+static gboolean
+duration_changed_dispatch (gpointer user_data)
+{
+  DurationChangedSignalData *data = user_data;
+
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    g_signal_emit (data->player, signals[SIGNAL_DURATION_CHANGED], 0,
+        data->duration);
+    g_object_notify_by_pspec (G_OBJECT (data->player),
+        param_specs[PROP_DURATION]);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+duration_changed_signal_data_free (DurationChangedSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+emit_duration_changed (GstPlayer * self, GstClockTime duration)
+{
+  GST_DEBUG_OBJECT (self, "Duration changed %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (duration));
+
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_DURATION_CHANGED], 0, NULL, NULL, NULL) != 0) {
+    DurationChangedSignalData *data = g_new (DurationChangedSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->duration = duration;
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, duration_changed_dispatch, data,
+        (GDestroyNotify) duration_changed_signal_data_free);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_DURATION_CHANGED], 0, duration);
+    g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_DURATION]);
+  }
+}
+
+static void
+state_changed_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstState old_state, new_state, pending_state;
+
+  gst_message_parse_state_changed (msg, &old_state, &new_state, &pending_state);
+
+  if (GST_MESSAGE_SRC (msg) == GST_OBJECT (self->playbin)) {
+    gchar *transition_name;
+
+    GST_DEBUG_OBJECT (self, "Changed state old: %s new: %s pending: %s",
+        gst_element_state_get_name (old_state),
+        gst_element_state_get_name (new_state),
+        gst_element_state_get_name (pending_state));
+
+    transition_name = g_strdup_printf ("%s_%s",
+        gst_element_state_get_name (old_state),
+        gst_element_state_get_name (new_state));
+    dump_dot_file (self, transition_name);
+    g_free (transition_name);
+
+    self->current_state = new_state;
+
+    if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED
+        && pending_state == GST_STATE_VOID_PENDING) {
+      GstElement *video_sink;
+      GstPad *video_sink_pad;
+      gint64 duration = -1;
+
+      GST_DEBUG_OBJECT (self, "Initial PAUSED - pre-rolled");
+
+      /* Last chance for tracks whose language was only known late, this
+       * happens before the initial seek and its flush */
+      apply_track_preferences (self);
+      g_mutex_lock (&self->lock);
+      g_free (self->audio_language);
+      self->audio_language = NULL;
+      g_free (self->subtitle_language);
+      self->subtitle_language = NULL;
+      g_mutex_unlock (&self->lock);
+
+      g_mutex_lock (&self->lock);
+      if (self->media_info)
+        g_object_unref (self->media_info);
+      self->media_info = gst_player_media_info_create (self);
+      g_mutex_unlock (&self->lock);
+      emit_media_info_updated_signal (self);
+      gst_player_update_keyframe_index_internal (self);
+
+      /* Looping needs a segment seek before playback starts */
+      g_mutex_lock (&self->lock);
+      if (self->looping && !self->is_live
+          && !GST_CLOCK_TIME_IS_VALID (self->seek_position))
+        self->seek_position = self->loop_start;
+      g_mutex_unlock (&self->lock);
+
+      g_object_get (self->playbin, "video-sink", &video_sink, NULL);
+
+      if (video_sink) {
+        video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
+
+        if (video_sink_pad) {
+          g_signal_connect (video_sink_pad, "notify::caps",
+              (GCallback) notify_caps_cb, self);
+          add_frame_cache_probe (self, video_sink_pad);
+          gst_object_unref (video_sink_pad);
+        }
+        gst_object_unref (video_sink);
+      }
+
+      check_video_dimensions_changed (self);
+      gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
+      emit_duration_changed (self, duration);
+    }
+
+    if (new_state == GST_STATE_PAUSED
+        && pending_state == GST_STATE_VOID_PENDING) {
+      remove_tick_source (self);
+
+      g_mutex_lock (&self->lock);
+      if (self->seek_pending) {
+        self->seek_pending = FALSE;
+
+        if (!self->media_info->seekable) {
+          GST_DEBUG_OBJECT (self, "Media is not seekable");
+          if (self->seek_source) {
+            g_source_destroy (self->seek_source);
+            g_source_unref (self->seek_source);
+            self->seek_source = NULL;
+          }
+          self->seek_position = GST_CLOCK_TIME_NONE;
+          self->seek_flags = 0;
+          self->last_seek_time = GST_CLOCK_TIME_NONE;
+        } else if (self->seek_source) {
+          GST_DEBUG_OBJECT (self, "Seek finished but new seek is pending");
+          gst_player_seek_internal_locked (self);
+        } else {
+          GST_DEBUG_OBJECT (self, "Seek finished");
+        }
+      }
+
+      if (self->seek_position != GST_CLOCK_TIME_NONE) {
+        GST_DEBUG_OBJECT (self, "Seeking now that we reached PAUSED state");
+        gst_player_seek_internal_locked (self);
+        g_mutex_unlock (&self->lock);
+      } else if (!self->seek_pending) {
+        g_mutex_unlock (&self->lock);
+
+        tick_cb (self);
+
+        if (self->target_state >= GST_STATE_PLAYING && self->buffering == 100) {
+          GstStateChangeReturn state_ret;
+
+          state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
+          if (state_ret == GST_STATE_CHANGE_FAILURE)
+            emit_error (self, g_error_new (GST_PLAYER_ERROR,
+                    GST_PLAYER_ERROR_FAILED, "Failed to play"));
+        } else if (self->buffering == 100) {
+          change_state (self, GST_PLAYER_STATE_PAUSED);
+        }
+      } else {
+        g_mutex_unlock (&self->lock);
+      }
+    } else if (new_state == GST_STATE_PLAYING
+        && pending_state == GST_STATE_VOID_PENDING) {
+
+      /* If no seek is currently pending, add the tick source. This can happen
+       * if we seeked already but the state-change message was still queued up */
+      if (!self->seek_pending) {
+        configure_low_latency_sinks (self);
+        add_tick_source (self);
+        change_state (self, GST_PLAYER_STATE_PLAYING);
+      }
+    } else if (new_state == GST_STATE_READY && old_state > GST_STATE_READY) {
+      change_state (self, GST_PLAYER_STATE_STOPPED);
+    } else {
+      /* Otherwise we neither reached PLAYING nor PAUSED, so must
+       * wait for something to happen... i.e. are BUFFERING now */
+      change_state (self, GST_PLAYER_STATE_BUFFERING);
+    }
+  }
+}
+
+static void
+duration_changed_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  gint64 duration;
+
+  if (gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration)) {
+    emit_duration_changed (self, duration);
+  }
+}
+
+static void
+latency_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  GstQuery *query;
+  gboolean live = FALSE;
+
+  GST_DEBUG_OBJECT (self, "Latency changed");
+
+  gst_bin_recalculate_latency (GST_BIN (self->playbin));
+
+  /* Also catches live sources that were only added after the state change
+   * to PAUSED */
+  query = gst_query_new_latency ();
+  if (gst_element_query (self->playbin, query))
+    gst_query_parse_latency (query, &live, NULL, NULL);
+  gst_query_unref (query);
+
+  if (live && !self->is_live) {
+    self->is_live = TRUE;
+    GST_DEBUG_OBJECT (self, "Pipeline is live");
+  }
+}
+
+static void
+request_state_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstState state;
+  GstStateChangeReturn state_ret;
+
+  gst_message_parse_request_state (msg, &state);
+
+  GST_DEBUG_OBJECT (self, "State %s requested",
+      gst_element_state_get_name (state));
+
+  self->target_state = state;
+  state_ret = gst_element_set_state (self->playbin, state);
+  if (state_ret == GST_STATE_CHANGE_FAILURE)
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to change to requested state %s",
+            gst_element_state_get_name (state)));
+}
+
+static void
+media_info_update (GstPlayer * self, GstPlayerMediaInfo * info)
+{
+  if (info->title)
+    g_free (info->title);
+  info->title = get_from_tags (self, info, get_title);
+
+  if (info->container)
+    g_free (info->container);
+  info->container = get_from_tags (self, info, get_container_format);
+
+  if (info->image_sample)
+    gst_sample_unref (info->image_sample);
+  info->image_sample = get_from_tags (self, info, get_cover_sample);
+
+  GST_DEBUG_OBJECT (self, "title: %s, container: %s "
+      "image_sample: %p", info->title, info->container, info->image_sample);
+}
+
+static void
+tags_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstTagList *tags = NULL;
+
+  gst_message_parse_tag (msg, &tags);
+
+  /*
+   * NOTE: Inorder to get global tag you must apply the following patches in
+   * your gstreamer build.
+   *
+   * http://cgit.freedesktop.org/gstreamer/gst-plugins-good/commit/?id=9119fbd774093e3ae762c8652acd80d54b2c3b45
+   * http://cgit.freedesktop.org/gstreamer/gstreamer/commit/?id=18b058100940bdcaed86fa412e3582a02871f995
+   */
+  GST_DEBUG_OBJECT (self, "recieved %s tags",
+      gst_tag_list_get_scope (tags) ==
+      GST_TAG_SCOPE_GLOBAL ? "global" : "stream");
+
+  if (gst_tag_list_get_scope (tags) == GST_TAG_SCOPE_GLOBAL) {
+    g_mutex_lock (&self->lock);
+    if (self->media_info) {
+      if (self->media_info->tags)
+        gst_tag_list_unref (self->media_info->tags);
+      self->media_info->tags = gst_tag_list_ref (tags);
+      media_info_update (self, self->media_info);
+      g_mutex_unlock (&self->lock);
+      emit_media_info_updated_signal (self);
+    } else {
+      if (self->global_tags)
+        gst_tag_list_unref (self->global_tags);
+      self->global_tags = gst_tag_list_ref (tags);
+      g_mutex_unlock (&self->lock);
+    }
+  }
+
+  gst_tag_list_unref (tags);
+}
+
+static gint
+chapter_compare (gconstpointer a, gconstpointer b)
+{
+  const GstPlayerChapter *chapter_a = a, *chapter_b = b;
+
+  if (chapter_a->start < chapter_b->start)
+    return -1;
+  if (chapter_a->start > chapter_b->start)
+    return 1;
+  return 0;
+}
+
+static void
+media_info_update_chapters (GstPlayer * self, GstPlayerMediaInfo * info,
+    GstToc * toc)
+{
+  GList *entries, *l;
+  guint i;
+
+  g_array_set_size (info->chapters, 0);
+
+  /* Only the first edition is used, others are alternative cuts */
+  entries = gst_toc_get_entries (toc);
+  while (entries && gst_toc_entry_get_entry_type (entries->data) ==
+      GST_TOC_ENTRY_TYPE_EDITION)
+    entries = gst_toc_entry_get_sub_entries (entries->data);
+
+  for (l = entries; l != NULL; l = l->next) {
+    GstTocEntry *entry = l->data;
+    GstPlayerChapter chapter;
+    GstTagList *tags;
+    gint64 start, stop;
+
+    if (gst_toc_entry_get_entry_type (entry) != GST_TOC_ENTRY_TYPE_CHAPTER)
+      continue;
+    if (!gst_toc_entry_get_start_stop_times (entry, &start, &stop)
+        || start < 0)
+      continue;
+
+    chapter.start = start;
+    chapter.stop = stop > start ? stop : GST_CLOCK_TIME_NONE;
+    chapter.title = NULL;
+    tags = gst_toc_entry_get_tags (entry);
+    if (tags)
+      gst_tag_list_get_string (tags, GST_TAG_TITLE, &chapter.title);
+
+    g_array_append_val (info->chapters, chapter);
+  }
+
+  g_array_sort (info->chapters, chapter_compare);
+
+  /* Chapters without stop time last until the next one starts */
+  for (i = 0; i < info->chapters->len; i++) {
+    GstPlayerChapter *chapter =
+        &g_array_index (info->chapters, GstPlayerChapter, i);
+
+    if (GST_CLOCK_TIME_IS_VALID (chapter->stop))
+      continue;
+
+    if (i + 1 < info->chapters->len)
+      chapter->stop =
+          g_array_index (info->chapters, GstPlayerChapter, i + 1).start;
+    else
+      chapter->stop = info->duration;
+  }
+
+  GST_DEBUG_OBJECT (self, "%u chapters", info->chapters->len);
+}
+
+static void
+toc_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstToc *toc = NULL;
+
+  gst_message_parse_toc (msg, &toc, NULL);
+
+  if (gst_toc_get_scope (toc) == GST_TOC_SCOPE_GLOBAL) {
+    g_mutex_lock (&self->lock);
+    if (self->media_info) {
+      media_info_update_chapters (self, self->media_info, toc);
+      g_mutex_unlock (&self->lock);
+      emit_media_info_updated_signal (self);
+    } else {
+      if (self->global_toc)
+        gst_toc_unref (self->global_toc);
+      self->global_toc = gst_toc_ref (toc);
+      g_mutex_unlock (&self->lock);
+    }
+  }
+
+  gst_toc_unref (toc);
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  guint bitrate;
+} VariantSwitchedSignalData;
+
+static gboolean
+variant_switched_dispatch (gpointer user_data)
+{
+  VariantSwitchedSignalData *data = user_data;
+
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    g_signal_emit (data->player, signals[SIGNAL_VARIANT_SWITCHED], 0,
+        data->bitrate);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+variant_switched_signal_data_free (VariantSwitchedSignalData * data)
+{
+  g_object_unref (data->player);
+  g_free (data);
+}
+
+static void
+emit_variant_switched (GstPlayer * self, guint bitrate)
+{
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_VARIANT_SWITCHED], 0, NULL, NULL, NULL) != 0) {
+    VariantSwitchedSignalData *data = g_new (VariantSwitchedSignalData, 1);
+
+    data->player = g_object_ref (self);
+    data->bitrate = bitrate;
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, variant_switched_dispatch, data,
+        (GDestroyNotify) variant_switched_signal_data_free);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_VARIANT_SWITCHED], 0, bitrate);
+  }
+}
+
+/* Posted by adaptive demuxers after each fragment download, and when they
+ * switch to another variant */
+static void
+adaptive_statistics_cb (GstPlayer * self, GstMessage * msg,
+    const GstStructure * s)
+{
+  GstObject *src = GST_MESSAGE_SRC (msg);
+  guint64 size, download_time;
+  gboolean switched = FALSE;
+  gint bitrate;
+
+  if (src != GST_OBJECT_CAST (self->adaptive_demux) && GST_IS_ELEMENT (src)
+      && g_object_class_find_property (G_OBJECT_GET_CLASS (src),
+          "connection-speed")) {
+    gst_object_replace ((GstObject **) & self->adaptive_demux, src);
+    /* Anything set on playbin only applies to new demuxers */
+    if (self->connection_speed > 0)
+      g_object_set (self->adaptive_demux, "connection-speed",
+          self->connection_speed, NULL);
+  }
+
+  if (gst_structure_get_uint64 (s, "fragment-size", &size)
+      && gst_structure_get_uint64 (s, "fragment-download-time",
+          &download_time)) {
+    gst_player_abr_add_sample (self->abr, size, download_time);
+
+    g_mutex_lock (&self->lock);
+    self->bandwidth_estimate = gst_player_abr_get_estimate (self->abr);
+    g_mutex_unlock (&self->lock);
+  }
+
+  if (gst_structure_get_int (s, "bitrate", &bitrate) && bitrate > 0) {
+    g_mutex_lock (&self->lock);
+    if (self->variant_bitrate != (guint) bitrate) {
+      self->variant_bitrate = bitrate;
+      if (self->media_info)
+        self->media_info->variant_bitrate = bitrate;
+      switched = TRUE;
+    }
+    g_mutex_unlock (&self->lock);
+
+    if (switched) {
+      GST_DEBUG_OBJECT (self, "Switched to variant with %d bits/s", bitrate);
+      emit_variant_switched (self, bitrate);
+      if (self->media_info)
+        emit_media_info_updated_signal (self);
+    }
+  }
+
+  update_connection_speed (self);
+}
+
+static void
+element_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  const GstStructure *s;
+
+  s = gst_message_get_structure (msg);
+  if (gst_structure_has_name (s, "redirect")) {
+    const gchar *new_location;
+
+    new_location = gst_structure_get_string (s, "new-location");
+    if (!new_location) {
+      const GValue *locations_list, *location_val;
+      guint i, size;
+
+      locations_list = gst_structure_get_value (s, "locations");
+      size = gst_value_list_get_size (locations_list);
+      for (i = 0; i < size; ++i) {
+        const GstStructure *location_s;
+
+        location_val = gst_value_list_get_value (locations_list, i);
+        if (!GST_VALUE_HOLDS_STRUCTURE (location_val))
+          continue;
+
+        location_s = (const GstStructure *) g_value_get_boxed (location_val);
+        if (!gst_structure_has_name (location_s, "redirect"))
+          continue;
+
+        new_location = gst_structure_get_string (location_s, "new-location");
+        if (new_location)
+          break;
+      }
+    }
+
+    if (new_location) {
+      GstState target_state;
+
+      GST_DEBUG_OBJECT (self, "Redirect to '%s'", new_location);
+
+      /* Remember target state and restore after setting the URI */
+      target_state = self->target_state;
+
+      g_mutex_lock (&self->lock);
+      if (self->uri)
+        g_free (self->uri);
+
+      self->uri = g_strdup (new_location);
+      g_mutex_unlock (&self->lock);
+
+      gst_player_set_uri_internal (self);
+
+      if (target_state == GST_STATE_PAUSED)
+        gst_player_pause_internal (self);
+      else if (target_state == GST_STATE_PLAYING)
+        gst_player_play_internal (self);
+    }
+  } else if (gst_structure_has_name (s, "adaptive-streaming-statistics")) {
+    adaptive_statistics_cb (self, msg, s);
+  }
+}
+
+static void
+player_set_flag (GstPlayer * self, gint pos)
+{
+  gint flags;
+
+  g_object_get (self->playbin, "flags", &flags, NULL);
+  flags |= pos;
+  g_object_set (self->playbin, "flags", flags, NULL);
+
+  GST_DEBUG_OBJECT (self, "setting flags=%#x", flags);
+}
+
+static void
+player_clear_flag (GstPlayer * self, gint pos)
+{
+  gint flags;
+
+  g_object_get (self->playbin, "flags", &flags, NULL);
+  flags &= ~pos;
+  g_object_set (self->playbin, "flags", flags, NULL);
+
+  GST_DEBUG_OBJECT (self, "setting flags=%#x", flags);
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  GstPlayerMediaInfo *info;
+} MediaInfoUpdatedSignalData;
+
+static gboolean
+media_info_updated_dispatch (gpointer user_data)
+{
+  MediaInfoUpdatedSignalData *data = user_data;
+
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    g_signal_emit (data->player, signals[SIGNAL_MEDIA_INFO_UPDATED], 0,
+        data->info);
+  }
+
+  return FALSE;
+}
+
+static void
+free_media_info_updated_signal_data (MediaInfoUpdatedSignalData * data)
+{
+  g_object_unref (data->player);
+  g_object_unref (data->info);
+  g_free (data);
+}
+
+/*
+ * emit_media_info_updated_signal:
+ *
+ * create a new copy of self->media_info object and emits the newly created
+ * copy to user application. The newly created media_info will be unref'ed
+ * as part of signal finalize method.
+ */
+static void
+emit_media_info_updated_signal (GstPlayer * self)
+{
+  if (self->dispatch_to_main_context) {
+    MediaInfoUpdatedSignalData *data = g_new (MediaInfoUpdatedSignalData, 1);
+    data->player = g_object_ref (self);
+    g_mutex_lock (&self->lock);
+    data->info = gst_player_media_info_copy (self->media_info);
+    g_mutex_unlock (&self->lock);
+
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, media_info_updated_dispatch,
+        data, (GDestroyNotify) free_media_info_updated_signal_data);
+  } else {
+    GstPlayerMediaInfo *info;
+
+    g_mutex_lock (&self->lock);
+    info = gst_player_media_info_copy (self->media_info);
+    g_mutex_unlock (&self->lock);
+
+    g_signal_emit (self, signals[SIGNAL_MEDIA_INFO_UPDATED], 0, info);
+    g_object_unref (info);
+  }
+}
+
+static GstPad *
+get_stream_pad (GstPlayer * self, gint stream_index, GType type)
+{
+  GstPad *pad = NULL;
+
+  if (type == GST_TYPE_PLAYER_VIDEO_INFO)
+    g_signal_emit_by_name (G_OBJECT (self->playbin),
+        "get-video-pad", stream_index, &pad);
+  else if (type == GST_TYPE_PLAYER_AUDIO_INFO)
+    g_signal_emit_by_name (G_OBJECT (self->playbin),
+        "get-audio-pad", stream_index, &pad);
+  else
+    g_signal_emit_by_name (G_OBJECT (self->playbin),
+        "get-text-pad", stream_index, &pad);
+
+  return pad;
+}
+
+static GstCaps *
+get_caps (GstPlayer * self, gint stream_index, GType type)
+{
+  GstPad *pad;
+  GstCaps *caps = NULL;
+
+  pad = get_stream_pad (self, stream_index, type);
+  if (pad) {
+    caps = gst_pad_get_current_caps (pad);
+    gst_object_unref (pad);
+  }
+
+  return caps;
+}
+
+static void
+gst_player_subtitle_info_update (GstPlayer * self,
+    GstPlayerStreamInfo * stream_info)
+{
+  GstPlayerSubtitleInfo *info = (GstPlayerSubtitleInfo *) stream_info;
+
+  if (stream_info->tags) {
+
+    /* free the old language info */
+    if (info->language) {
+      g_free (info->language);
+      info->language = NULL;
+    }
+
+    /* First try to get the language full name from tag, if name is not
+     * available then try language code. If we find the language code
+     * then use gstreamer api to translate code to full name.
+     */
+    gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_NAME,
+        &info->language);
+    if (!info->language) {
+      gchar *lang_code = NULL;
+
+      gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_CODE,
+          &lang_code);
+      if (lang_code) {
+        info->language = g_strdup (gst_tag_get_language_name (lang_code));
+        g_free (lang_code);
+      }
+    }
+
+    /* If we are still failed to find language name then check if external
+     * subtitle is loaded and compare the stream index between current sub
+     * stream index with our stream index and if matches then declare it as
+     * external subtitle and use the filename.
+     */
+    if (!info->language) {
+      gint text_index = -1;
+      gchar *suburi = NULL;
+
+      g_object_get (G_OBJECT (self->playbin), "current-suburi", &suburi, NULL);
+      if (suburi) {
+        g_object_get (G_OBJECT (self->playbin), "current-text", &text_index,
+            NULL);
+        if (text_index == gst_player_stream_info_get_index (stream_info))
+          info->language = g_path_get_basename (suburi);
+        g_free (suburi);
+      }
+    }
+
+  } else {
+    if (info->language) {
+      g_free (info->language);
+      info->language = NULL;
+    }
+  }
+
+  GST_DEBUG_OBJECT (self, "language=%s", info->language);
+}
+
+static void
+gst_player_video_info_update (GstPlayer * self,
+    GstPlayerStreamInfo * stream_info)
+{
+  GstPlayerVideoInfo *info = (GstPlayerVideoInfo *) stream_info;
+
+  if (stream_info->caps) {
+    GstStructure *s;
+
+    s = gst_caps_get_structure (stream_info->caps, 0);
+    if (s) {
+      gint width, height;
+      gint fps_n, fps_d;
+      gint par_n, par_d;
+
+      if (gst_structure_get_int (s, "width", &width))
+        info->width = width;
+      else
+        info->width = -1;
+
+      if (gst_structure_get_int (s, "height", &height))
+        info->height = height;
+      else
+        info->height = -1;
+
+      if (gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d)) {
+        info->framerate_num = fps_n;
+        info->framerate_denom = fps_d;
+      } else {
+        info->framerate_num = 0;
+        info->framerate_denom = 1;
+      }
+
+
+      if (gst_structure_get_fraction (s, "pixel-aspect-ratio", &par_n, &par_d)) {
+        info->par_num = par_n;
+        info->par_denom = par_d;
+      } else {
+        info->par_num = 1;
+        info->par_denom = 1;
+      }
+    }
+  } else {
+    info->width = info->height = -1;
+    info->par_num = info->par_denom = 1;
+    info->framerate_num = 0;
+    info->framerate_denom = 1;
+  }
+
+  if (stream_info->tags) {
+    guint bitrate, max_bitrate;
+
+    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_BITRATE, &bitrate))
+      info->bitrate = bitrate;
+    else
+      info->bitrate = -1;
+
+    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_MAXIMUM_BITRATE,
+            &max_bitrate) || gst_tag_list_get_uint (stream_info->tags,
+            GST_TAG_NOMINAL_BITRATE, &max_bitrate))
+      info->max_bitrate = max_bitrate;
+    else
+      info->max_bitrate = -1;
+  } else {
+    info->bitrate = info->max_bitrate = -1;
+  }
+
+  GST_DEBUG_OBJECT (self, "width=%d height=%d fps=%.2f par=%d:%d "
+      "bitrate=%d max_bitrate=%d", info->width, info->height,
+      (gdouble) info->framerate_num / info->framerate_denom,
+      info->par_num, info->par_denom, info->bitrate, info->max_bitrate);
+}
+
+static void
+gst_player_audio_info_update (GstPlayer * self,
+    GstPlayerStreamInfo * stream_info)
+{
+  GstPlayerAudioInfo *info = (GstPlayerAudioInfo *) stream_info;
+
+  if (stream_info->caps) {
+    GstStructure *s;
+
+    s = gst_caps_get_structure (stream_info->caps, 0);
+    if (s) {
+      gint rate, channels;
+
+      if (gst_structure_get_int (s, "rate", &rate))
+        info->sample_rate = rate;
+      else
+        info->sample_rate = -1;
+
+      if (gst_structure_get_int (s, "channels", &channels))
+        info->channels = channels;
+      else
+        info->channels = 0;
+    }
+  } else {
+    info->sample_rate = -1;
+    info->channels = 0;
+  }
+
+  if (stream_info->tags) {
+    guint bitrate, max_bitrate;
+
+    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_BITRATE, &bitrate))
+      info->bitrate = bitrate;
+    else
+      info->bitrate = -1;
+
+    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_MAXIMUM_BITRATE,
+            &max_bitrate) || gst_tag_list_get_uint (stream_info->tags,
+            GST_TAG_NOMINAL_BITRATE, &max_bitrate))
+      info->max_bitrate = max_bitrate;
+    else
+      info->max_bitrate = -1;
+
+    /* if we have old language the free it */
+    if (info->language) {
+      g_free (info->language);
+      info->language = NULL;
+    }
+
+    /* First try to get the language full name from tag, if name is not
+     * available then try language code. If we find the language code
+     * then use gstreamer api to translate code to full name.
+     */
+    gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_NAME,
+        &info->language);
+    if (!info->language) {
+      gchar *lang_code = NULL;
+
+      gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_CODE,
+          &lang_code);
+      if (lang_code) {
+        info->language = g_strdup (gst_tag_get_language_name (lang_code));
+        g_free (lang_code);
+      }
+    }
+  } else {
+    if (info->language) {
+      g_free (info->language);
+      info->language = NULL;
+    }
+    info->max_bitrate = info->bitrate = -1;
+  }
+
+  GST_DEBUG_OBJECT (self, "language=%s rate=%d channels=%d bitrate=%d "
+      "max_bitrate=%d", info->language, info->sample_rate, info->channels,
+      info->bitrate, info->bitrate);
+}
+
+static GstPlayerStreamInfo *
+gst_player_stream_info_find (GstPlayer * self, GstPlayerMediaInfo * media_info,
+    GType type, gint stream_index)
+{
+  GList *list, *l;
+  GstPlayerStreamInfo *info = NULL;
+
+  if (!media_info)
+    return NULL;
+
+  list = gst_player_media_info_get_stream_list (media_info);
+  for (l = list; l != NULL; l = l->next) {
+    info = (GstPlayerStreamInfo *) l->data;
+    if ((G_OBJECT_TYPE (info) == type) && (info->stream_index == stream_index)) {
+      return info;
+    }
+  }
+
+  return NULL;
+}
+
+static gboolean
+is_track_enabled (GstPlayer * self, gint pos)
+{
+  gint flags;
+
+  g_object_get (G_OBJECT (self->playbin), "flags", &flags, NULL);
+
+  if ((flags & pos))
+    return TRUE;
+
+  return FALSE;
+}
+
+static GstPlayerStreamInfo *
+gst_player_stream_info_get_current (GstPlayer * self, const gchar * prop,
+    GType type)
+{
+  gint current;
+  GstPlayerStreamInfo *info;
+
+  if (!self->media_info)
+    return NULL;
+
+  g_object_get (G_OBJECT (self->playbin), prop, &current, NULL);
+  if (type == GST_TYPE_PLAYER_SUBTITLE_INFO
+      && injected_subtitle_is_active (self))
+    current = self->injected_sub_index;
+
+  g_mutex_lock (&self->lock);
+  info = gst_player_stream_info_find (self, self->media_info, type, current);
+  if (info)
+    info = gst_player_stream_info_copy (info);
+  g_mutex_unlock (&self->lock);
+
+  return info;
+}
+
+static void
+gst_player_stream_info_update (GstPlayer * self, GstPlayerStreamInfo * s)
+{
+  if (GST_IS_PLAYER_VIDEO_INFO (s))
+    gst_player_video_info_update (self, s);
+  else if (GST_IS_PLAYER_AUDIO_INFO (s))
+    gst_player_audio_info_update (self, s);
+  else
+    gst_player_subtitle_info_update (self, s);
+}
+
+static gchar *
+stream_info_get_codec (GstPlayerStreamInfo * s)
+{
+  const gchar *type;
+  GstTagList *tags;
+  gchar *codec = NULL;
+
+  if (GST_IS_PLAYER_VIDEO_INFO (s))
+    type = GST_TAG_VIDEO_CODEC;
+  else if (GST_IS_PLAYER_AUDIO_INFO (s))
+    type = GST_TAG_AUDIO_CODEC;
+  else
+    type = GST_TAG_SUBTITLE_CODEC;
+
+  tags = gst_player_stream_info_get_tags (s);
+  if (tags) {
+    gst_tag_list_get_string (tags, type, &codec);
+    if (!codec)
+      gst_tag_list_get_string (tags, GST_TAG_CODEC, &codec);
+  }
+
+  if (!codec) {
+    GstCaps *caps;
+    caps = gst_player_stream_info_get_caps (s);
+    if (caps) {
+      codec = gst_pb_utils_get_codec_description (caps);
+    }
+  }
+
+  return codec;
+}
+
+static void
+gst_player_stream_info_update_tags_and_caps (GstPlayer * self,
+    GstPlayerStreamInfo * s)
+{
+  GstTagList *tags;
+  gint stream_index;
+
+  stream_index = gst_player_stream_info_get_index (s);
+
+  if (GST_IS_PLAYER_VIDEO_INFO (s))
+    g_signal_emit_by_name (self->playbin, "get-video-tags",
+        stream_index, &tags);
+  else if (GST_IS_PLAYER_AUDIO_INFO (s))
+    g_signal_emit_by_name (self->playbin, "get-audio-tags",
+        stream_index, &tags);
+  else
+    g_signal_emit_by_name (self->playbin, "get-text-tags", stream_index, &tags);
+
+  if (s->tags)
+    gst_tag_list_unref (s->tags);
+  s->tags = tags;
+
+  if (s->caps)
+    gst_caps_unref (s->caps);
+  s->caps = get_caps (self, stream_index, G_OBJECT_TYPE (s));
+
+  if (s->codec)
+    g_free (s->codec);
+  s->codec = stream_info_get_codec (s);
+
+  GST_DEBUG_OBJECT (self, "%s index: %d tags: %p caps: %p",
+      gst_player_stream_info_get_stream_type (s), stream_index,
+      s->tags, s->caps);
+
+  gst_player_stream_info_update (self, s);
+}
+
+static void
+gst_player_streams_info_create (GstPlayer * self,
+    GstPlayerMediaInfo * media_info, const gchar * prop, GType type)
+{
+  gint i;
+  gint total = -1;
+  GstPlayerStreamInfo *s;
+
+  if (!media_info)
+    return;
+
+  g_object_get (G_OBJECT (self->playbin), prop, &total, NULL);
+
+  GST_DEBUG_OBJECT (self, "%s: %d", prop, total);
+
+  for (i = 0; i < total; i++) {
+    /* check if stream already exist in the list */
+    s = gst_player_stream_info_find (self, media_info, type, i);
+
+    if (!s) {
+      /* create a new stream info instance */
+      s = gst_player_stream_info_new (i, type);
+
+      /* add the object in stream list */
+      media_info->stream_list = g_list_append (media_info->stream_list, s);
+
+      /* based on type, add the object in its corresponding stream_ list */
+      if (GST_IS_PLAYER_AUDIO_INFO (s))
+        media_info->audio_stream_list = g_list_append
+            (media_info->audio_stream_list, s);
+      else if (GST_IS_PLAYER_VIDEO_INFO (s))
+        media_info->video_stream_list = g_list_append
+            (media_info->video_stream_list, s);
+      else
+        media_info->subtitle_stream_list = g_list_append
+            (media_info->subtitle_stream_list, s);
+
+      GST_DEBUG_OBJECT (self, "create %s stream stream_index: %d",
+          gst_player_stream_info_get_stream_type (s), i);
+    }
+
+    gst_player_stream_info_update_tags_and_caps (self, s);
+  }
+}
+
+static gboolean
+language_matches (GstTagList * tags, const gchar * language)
+{
+  const gchar *wanted, *code_1;
+  gchar *code = NULL, *name = NULL;
+  gboolean ret = FALSE;
+
+  /* Accept ISO 639-1 and ISO 639-2 codes on both sides */
+  wanted = gst_tag_get_language_code_iso_639_1 (language);
+  if (!wanted)
+    wanted = language;
+
+  if (gst_tag_list_get_string (tags, GST_TAG_LANGUAGE_CODE, &code)) {
+    code_1 = gst_tag_get_language_code_iso_639_1 (code);
+    ret = !g_ascii_strcasecmp (code_1 ? code_1 : code, wanted);
+    g_free (code);
+  }
+
+  if (!ret && gst_tag_list_get_string (tags, GST_TAG_LANGUAGE_NAME, &name)) {
+    ret = !g_ascii_strcasecmp (name, language);
+    g_free (name);
+  }
+
+  return ret;
+}
+
+/* Selects the first stream of @language, must be called from main context */
+static void
+select_track_by_language (GstPlayer * self, const gchar * n_prop,
+    const gchar * tags_signal, const gchar * current_prop,
+    const gchar * language)
+{
+  gint i, n = 0, current = -1;
+
+  g_object_get (self->playbin, n_prop, &n, current_prop, &current, NULL);
+
+  for (i = 0; i < n; i++) {
+    GstTagList *tags = NULL;
+    gboolean match;
+
+    g_signal_emit_by_name (self->playbin, tags_signal, i, &tags);
+    if (!tags)
+      continue;
+
+    match = language_matches (tags, language);
+    gst_tag_list_unref (tags);
+
+    if (match) {
+      if (i != current) {
+        GST_DEBUG_OBJECT (self, "Selecting %s stream %d for language '%s'",
+            current_prop, i, language);
+        g_object_set (self->playbin, current_prop, i, NULL);
+      }
+      break;
+    }
+  }
+}
+
+/* Must be called from main context */
+static void
+apply_track_preferences (GstPlayer * self)
+{
+  gchar *audio_language, *subtitle_language;
+
+  g_mutex_lock (&self->lock);
+  audio_language = g_strdup (self->audio_language);
+  subtitle_language = g_strdup (self->subtitle_language);
+  g_mutex_unlock (&self->lock);
+
+  if (audio_language)
+    select_track_by_language (self, "n-audio", "get-audio-tags",
+        "current-audio", audio_language);
+  if (subtitle_language)
+    select_track_by_language (self, "n-text", "get-text-tags",
+        "current-text", subtitle_language);
+
+  g_free (audio_language);
+  g_free (subtitle_language);
+}
+
+static gboolean
+apply_track_preferences_internal (gpointer user_data)
+{
+  apply_track_preferences (GST_PLAYER (user_data));
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called from streaming threads whenever streams or their tags changed
+ * while a load request still has track preferences, selects the wanted
+ * tracks while the pipeline is prerolling */
+static void
+schedule_track_preferences (GstPlayer * self)
+{
+  gboolean pending;
+
+  g_mutex_lock (&self->lock);
+  pending = self->audio_language || self->subtitle_language;
+  g_mutex_unlock (&self->lock);
+
+  if (pending)
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+        apply_track_preferences_internal, self, NULL);
+}
+
+static void
+video_changed_cb (GObject * object, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  g_mutex_lock (&self->lock);
+  gst_player_streams_info_create (self, self->media_info,
+      "n-video", GST_TYPE_PLAYER_VIDEO_INFO);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+audio_changed_cb (GObject * object, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  g_mutex_lock (&self->lock);
+  gst_player_streams_info_create (self, self->media_info,
+      "n-audio", GST_TYPE_PLAYER_AUDIO_INFO);
+  g_mutex_unlock (&self->lock);
+
+  schedule_track_preferences (self);
+}
+
+static void
+subtitle_changed_cb (GObject * object, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  g_mutex_lock (&self->lock);
+  gst_player_streams_info_create (self, self->media_info,
+      "n-text", GST_TYPE_PLAYER_SUBTITLE_INFO);
+  g_mutex_unlock (&self->lock);
+
+  schedule_track_preferences (self);
+}
+
+static void *
+get_title (GstTagList * tags)
+{
+  gchar *title = NULL;
+
+  gst_tag_list_get_string (tags, GST_TAG_TITLE, &title);
+  if (!title)
+    gst_tag_list_get_string (tags, GST_TAG_TITLE_SORTNAME, &title);
+
+  return title;
+}
+
+static void *
+get_container_format (GstTagList * tags)
+{
+  gchar *container = NULL;
+
+  gst_tag_list_get_string (tags, GST_TAG_CONTAINER_FORMAT, &container);
+
+  /* TODO: If container is not available then maybe consider
+   * parsing caps or file extension to guess the container format.
+   */
+
+  return container;
+}
+
+static void *
+get_from_tags (GstPlayer * self, GstPlayerMediaInfo * media_info,
+    void *(*func) (GstTagList *))
+{
+  GList *l;
+  void *ret = NULL;
+
+  if (media_info->tags) {
+    ret = func (media_info->tags);
+    if (ret)
+      return ret;
+  }
+
+  /* if global tag does not exit then try video and audio streams */
+  GST_DEBUG_OBJECT (self, "trying video tags");
+  for (l = gst_player_get_video_streams (media_info); l != NULL; l = l->next) {
+    GstTagList *tags;
+
+    tags = gst_player_stream_info_get_tags ((GstPlayerStreamInfo *) l->data);
+    if (tags)
+      ret = func (tags);
+
+    if (ret)
+      return ret;
+  }
+
+  GST_DEBUG_OBJECT (self, "trying audio tags");
+  for (l = gst_player_get_audio_streams (media_info); l != NULL; l = l->next) {
+    GstTagList *tags;
+
+    tags = gst_player_stream_info_get_tags ((GstPlayerStreamInfo *) l->data);
+    if (tags)
+      ret = func (tags);
+
+    if (ret)
+      return ret;
+  }
+
+  GST_DEBUG_OBJECT (self, "failed to get the information from tags");
+  return NULL;
+}
+
+static void *
+get_cover_sample (GstTagList * tags)
+{
+  GstSample *cover_sample = NULL;
+
+  gst_tag_list_get_sample (tags, GST_TAG_IMAGE, &cover_sample);
+  if (!cover_sample)
+    gst_tag_list_get_sample (tags, GST_TAG_PREVIEW_IMAGE, &cover_sample);
+
+  return cover_sample;
+}
+
+static GstPlayerMediaInfo *
+gst_player_media_info_create (GstPlayer * self)
+{
+  GstPlayerMediaInfo *media_info;
+  GstQuery *query;
+
+  GST_DEBUG_OBJECT (self, "begin");
+  media_info = gst_player_media_info_new (self->uri);
+  media_info->duration = gst_player_get_duration (self);
+  media_info->variant_bitrate = self->variant_bitrate;
+  media_info->tags = self->global_tags;
+  self->global_tags = NULL;
+
+  query = gst_query_new_seeking (GST_FORMAT_TIME);
+  if (gst_element_query (self->playbin, query))
+    gst_query_parse_seeking (query, NULL, &media_info->seekable, NULL, NULL);
+  gst_query_unref (query);
+
+  /* create audio/video/sub streams */
+  gst_player_streams_info_create (self, media_info, "n-video",
+      GST_TYPE_PLAYER_VIDEO_INFO);
+  gst_player_streams_info_create (self, media_info, "n-audio",
+      GST_TYPE_PLAYER_AUDIO_INFO);
+  gst_player_streams_info_create (self, media_info, "n-text",
+      GST_TYPE_PLAYER_SUBTITLE_INFO);
+
+  media_info->title = get_from_tags (self, media_info, get_title);
+  media_info->container =
+      get_from_tags (self, media_info, get_container_format);
+  media_info->image_sample = get_from_tags (self, media_info, get_cover_sample);
+
+  if (self->global_toc) {
+    media_info_update_chapters (self, media_info, self->global_toc);
+    gst_toc_unref (self->global_toc);
+    self->global_toc = NULL;
+  }
+
+  GST_DEBUG_OBJECT (self, "uri: %s title: %s duration: %" GST_TIME_FORMAT
+      " seekable: %s container: %s image_sample %p",
+      media_info->uri, media_info->title, GST_TIME_ARGS (media_info->duration),
+      media_info->seekable ? "yes" : "no", media_info->container,
+      media_info->image_sample);
+
+  GST_DEBUG_OBJECT (self, "end");
+  return media_info;
+}
+
+static void
+tags_changed_cb (GstPlayer * self, gint stream_index, GType type)
+{
+  GstPlayerStreamInfo *s;
+
+  if (type != GST_TYPE_PLAYER_VIDEO_INFO)
+    schedule_track_preferences (self);
+
+  if (!self->media_info)
+    return;
+
+  /* update the stream information */
+  g_mutex_lock (&self->lock);
+  s = gst_player_stream_info_find (self, self->media_info, type, stream_index);
+  gst_player_stream_info_update_tags_and_caps (self, s);
+  g_mutex_unlock (&self->lock);
+
+  emit_media_info_updated_signal (self);
+}
+
+static void
+video_tags_changed_cb (GstElement * playbin, gint stream_index,
+    gpointer user_data)
+{
+  tags_changed_cb (GST_PLAYER (user_data), stream_index,
+      GST_TYPE_PLAYER_VIDEO_INFO);
+}
+
+static void
+audio_tags_changed_cb (GstElement * playbin, gint stream_index,
+    gpointer user_data)
+{
+  tags_changed_cb (GST_PLAYER (user_data), stream_index,
+      GST_TYPE_PLAYER_AUDIO_INFO);
+}
+
+static void
+subtitle_tags_changed_cb (GstElement * playbin, gint stream_index,
+    gpointer user_data)
+{
+  tags_changed_cb (GST_PLAYER (user_data), stream_index,
+      GST_TYPE_PLAYER_SUBTITLE_INFO);
+}
+
+static gboolean
+volume_changed_dispatch (gpointer user_data)
+{
+  g_signal_emit (user_data, signals[SIGNAL_VOLUME_CHANGED], 0);
+  g_object_notify_by_pspec (G_OBJECT (user_data), param_specs[PROP_VOLUME]);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void inline
+volume_notify_cb (GObject * obj, GParamSpec * pspec, GstPlayer * self)
+{
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_VOLUME_CHANGED], 0, NULL, NULL, NULL) != 0) {
+    g_main_context_invoke_full (self->application_context, G_PRIORITY_DEFAULT,
+        volume_changed_dispatch, g_object_ref (self),
+        (GDestroyNotify) g_object_unref);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_VOLUME_CHANGED], 0);
+    g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_VOLUME]);
+  }
+}
+
+static gboolean
+mute_changed_dispatch (gpointer user_data)
+{
+  g_signal_emit (user_data, signals[SIGNAL_MUTE_CHANGED], 0);
+  g_object_notify_by_pspec (G_OBJECT (user_data), param_specs[PROP_MUTE]);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void inline
+mute_notify_cb (GObject * obj, GParamSpec * pspec, GstPlayer * self)
+{
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_MUTE_CHANGED], 0, NULL, NULL, NULL) != 0) {
+    g_main_context_invoke_full (self->application_context, G_PRIORITY_DEFAULT,
+        mute_changed_dispatch, g_object_ref (self),
+        (GDestroyNotify) g_object_unref);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_MUTE_CHANGED], 0);
+    g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_MUTE]);
+  }
+}
+
+static gboolean
+is_input_selector (GstElement * element)
+{
+  GstElementFactory *factory = gst_element_get_factory (element);
+
+  return factory
+      && !g_strcmp0 (gst_plugin_feature_get_name (factory), "input-selector");
+}
+
+static void
+input_selector_reset_property (GstElement * selector, const gchar * name)
+{
+  GParamSpec *pspec;
+  GValue value = G_VALUE_INIT;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (selector), name);
+  if (!pspec)
+    return;
+
+  g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+  g_param_value_set_default (pspec, &value);
+  g_object_set_property (G_OBJECT (selector), name, &value);
+  g_value_unset (&value);
+}
+
+/* playbin already demuxes and decodes all alternate tracks and lets its
+ * input-selectors drop the inactive ones. Syncing the selectors to the
+ * clock and letting them cache the buffers of the inactive pads means that
+ * a switch can continue with the alternate track at the exact running time
+ * the old track stopped at, instead of waiting for the new track to catch
+ * up. */
+static void
+input_selector_set_seamless (GstElement * selector, gboolean seamless)
+{
+  GObjectClass *klass = G_OBJECT_GET_CLASS (selector);
+
+  if (seamless) {
+    if (g_object_class_find_property (klass, "sync-mode"))
+      g_object_set (selector, "sync-mode", 1 /* clock */ , NULL);
+    if (g_object_class_find_property (klass, "cache-buffers"))
+      g_object_set (selector, "cache-buffers", TRUE, NULL);
+  } else {
+    input_selector_reset_property (selector, "sync-mode");
+    input_selector_reset_property (selector, "cache-buffers");
+  }
+}
+
+static void
+update_input_selector_foreach (const GValue * item, gpointer user_data)
+{
+  GstElement *element = g_value_get_object (item);
+
+  if (is_input_selector (element))
+    input_selector_set_seamless (element, GPOINTER_TO_INT (user_data));
+}
+
+static void
+update_input_selectors (GstPlayer * self, gboolean seamless)
+{
+  GstIterator *it;
+
+  it = gst_bin_iterate_elements (GST_BIN (self->playbin));
+  while (gst_iterator_foreach (it, update_input_selector_foreach,
+          GINT_TO_POINTER (seamless)) == GST_ITERATOR_RESYNC)
+    gst_iterator_resync (it);
+  gst_iterator_free (it);
+}
+
+static void
+element_added_cb (GstBin * bin, GstElement * element, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  gboolean seamless;
+
+  if (!is_input_selector (element))
+    return;
+
+  g_mutex_lock (&self->lock);
+  seamless = self->seamless_track_switch;
+  g_mutex_unlock (&self->lock);
+
+  if (seamless) {
+    GST_DEBUG_OBJECT (self, "Configuring %" GST_PTR_FORMAT
+        " for seamless track switching", element);
+    input_selector_set_seamless (element, TRUE);
+  }
+}
+
+/* Sinks drop buffers that are later than this in low-latency mode */
+#define LOW_LATENCY_MAX_LATENESS (20 * GST_MSECOND)
+
+static void
+low_latency_sink_foreach (const GValue * item, gpointer user_data)
+{
+  GstElement *element = g_value_get_object (item);
+
+  /* Default and auto sinks are bins around the actual sink */
+  if (GST_IS_BIN (element)) {
+    GstIterator *it = gst_bin_iterate_sinks (GST_BIN (element));
+
+    while (gst_iterator_foreach (it, low_latency_sink_foreach,
+            NULL) == GST_ITERATOR_RESYNC)
+      gst_iterator_resync (it);
+    gst_iterator_free (it);
+  } else if (GST_IS_BASE_SINK (element)) {
+    gst_base_sink_set_max_lateness (GST_BASE_SINK (element),
+        LOW_LATENCY_MAX_LATENESS);
+  }
+}
+
+/* Must be called from the main context */
+static void
+configure_low_latency_sinks (GstPlayer * self)
+{
+  GstIterator *it;
+  gboolean low_latency;
+
+  g_mutex_lock (&self->lock);
+  low_latency = self->low_latency;
+  g_mutex_unlock (&self->lock);
+
+  if (!low_latency)
+    return;
+
+  it = gst_bin_iterate_sinks (GST_BIN (self->playbin));
+  while (gst_iterator_foreach (it, low_latency_sink_foreach,
+          NULL) == GST_ITERATOR_RESYNC)
+    gst_iterator_resync (it);
+  gst_iterator_free (it);
+}
+
+static void
+source_setup_cb (GstElement * playbin, GstElement * source,
+    gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GObjectClass *klass = G_OBJECT_GET_CLASS (source);
+  guint64 http_cache_size;
+  GstClockTime target_latency;
+  gboolean low_latency;
+  GParamSpec *pspec;
+
+  g_mutex_lock (&self->lock);
+  http_cache_size = self->http_cache_size;
+  low_latency = self->low_latency;
+  target_latency = self->target_latency;
+  g_mutex_unlock (&self->lock);
+
+  gst_player_http_cache_src_set_max_size (source, http_cache_size);
+
+  if (!low_latency)
+    return;
+
+  /* The jitterbuffer of RTSP and other RTP sources, in milliseconds */
+  pspec = g_object_class_find_property (klass, "latency");
+  if (pspec && pspec->value_type == G_TYPE_UINT) {
+    GST_DEBUG_OBJECT (self, "Setting latency of %" GST_PTR_FORMAT " to %"
+        GST_TIME_FORMAT, source, GST_TIME_ARGS (target_latency));
+    g_object_set (source, "latency",
+        (guint) MIN (target_latency / GST_MSECOND, G_MAXUINT), NULL);
+  }
+  pspec = g_object_class_find_property (klass, "drop-on-latency");
+  if (pspec && pspec->value_type == G_TYPE_BOOLEAN)
+    g_object_set (source, "drop-on-latency", TRUE, NULL);
+}
+
+typedef struct
+{
+  GstPlayer *player;
+  GstPlayerStreamInfo *info;
+  GstClockTime latency;
+} TrackSwitchedSignalData;
+
+static gboolean
+track_switched_dispatch (gpointer user_data)
+{
+  TrackSwitchedSignalData *data = user_data;
+
+  if (data->player->target_state >= GST_STATE_PAUSED) {
+    g_signal_emit (data->player, signals[SIGNAL_TRACK_SWITCHED], 0,
+        data->info, data->latency);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+static TrackSwitchedSignalData *
+track_switched_signal_data_new (GstPlayer * self, GstPlayerStreamInfo * info,
+    GstClockTime latency)
+{
+  TrackSwitchedSignalData *data;
+
+  data = g_new (TrackSwitchedSignalData, 1);
+  data->player = g_object_ref (self);
+  data->info = g_object_ref (info);
+  data->latency = latency;
+
+  return data;
+}
+
+static void
+track_switched_signal_data_free (TrackSwitchedSignalData * data)
+{
+  g_object_unref (data->player);
+  g_object_unref (data->info);
+  g_free (data);
+}
+
+static gboolean
+track_switched_emit (gpointer user_data)
+{
+  TrackSwitchedSignalData *data = user_data;
+  GstPlayer *self = data->player;
+
+  GST_DEBUG_OBJECT (self, "Switched to %s track %d after %" GST_TIME_FORMAT,
+      gst_player_stream_info_get_stream_type (data->info),
+      gst_player_stream_info_get_index (data->info),
+      GST_TIME_ARGS (data->latency));
+
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_TRACK_SWITCHED], 0, NULL, NULL, NULL) != 0) {
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, track_switched_dispatch,
+        track_switched_signal_data_new (self, data->info, data->latency),
+        (GDestroyNotify) track_switched_signal_data_free);
+  } else {
+    g_signal_emit (self, signals[SIGNAL_TRACK_SWITCHED], 0, data->info,
+        data->latency);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+typedef struct
+{
+  GWeakRef player;
+  GType type;
+  gint stream_index;
+  gint cookie;
+  GstClockTime start;
+} TrackSwitchProbeData;
+
+static void
+track_switch_probe_data_free (TrackSwitchProbeData * data)
+{
+  g_weak_ref_clear (&data->player);
+  g_free (data);
+}
+
+static gint *
+track_switch_cookie (GstPlayer * self, GType type)
+{
+  if (type == GST_TYPE_PLAYER_AUDIO_INFO)
+    return &self->audio_switch_cookie;
+
+  return &self->text_switch_cookie;
+}
+
+static GstPadProbeReturn
+track_switch_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  TrackSwitchProbeData *data = user_data;
+  GstPlayer *self;
+  TrackSwitchedSignalData *signal_data;
+  GstPlayerStreamInfo *stream_info;
+  gboolean active = FALSE;
+
+  /* The probe lives in the pipeline of the player, so it only holds a weak
+   * reference to not keep the player alive */
+  self = g_weak_ref_get (&data->player);
+  if (!self)
+    return GST_PAD_PROBE_REMOVE;
+
+  /* A newer switch request superseded this one */
+  if (g_atomic_int_get (track_switch_cookie (self, data->type)) !=
+      data->cookie) {
+    g_object_unref (self);
+    return GST_PAD_PROBE_REMOVE;
+  }
+
+  /* Buffers of the inactive pads still flow into the selector, wait until
+   * the first one that is actually forwarded */
+  g_object_get (pad, "active", &active, NULL);
+  if (!active) {
+    g_object_unref (self);
+    return GST_PAD_PROBE_OK;
+  }
+
+  g_mutex_lock (&self->lock);
+  stream_info = gst_player_stream_info_find (self, self->media_info,
+      data->type, data->stream_index);
+  if (stream_info)
+    stream_info = gst_player_stream_info_copy (stream_info);
+  g_mutex_unlock (&self->lock);
+
+  if (stream_info) {
+    signal_data = track_switched_signal_data_new (self, stream_info,
+        gst_util_get_timestamp () - data->start);
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+        track_switched_emit, signal_data,
+        (GDestroyNotify) track_switched_signal_data_free);
+    g_object_unref (stream_info);
+  }
+
+  g_object_unref (self);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Measures the time from the switch request at @start until the first
+ * buffer of the new track passes the selector, reported with the
+ * track-switched signal. Called before the switch so no buffer of the new
+ * track is missed */
+static void
+watch_track_switch (GstPlayer * self, GType type, gint stream_index,
+    GstClockTime start)
+{
+  TrackSwitchProbeData *data;
+  GstPad *pad;
+
+  pad = get_stream_pad (self, stream_index, type);
+  if (!pad)
+    return;
+
+  if (!g_object_class_find_property (G_OBJECT_GET_CLASS (pad), "active")) {
+    gst_object_unref (pad);
+    return;
+  }
+
+  data = g_new (TrackSwitchProbeData, 1);
+  g_weak_ref_init (&data->player, self);
+  data->type = type;
+  data->stream_index = stream_index;
+  data->cookie = g_atomic_int_add (track_switch_cookie (self, type), 1) + 1;
+  data->start = start;
+
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, track_switch_probe_cb,
+      data, (GDestroyNotify) track_switch_probe_data_free);
+  gst_object_unref (pad);
+}
+
+static void
+keyframe_indexer_done_cb (GstPlayerKeyframeIndexer * indexer,
+    GArray * keyframes, gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+
+  gst_player_keyframe_indexer_free (indexer);
+  self->keyframe_indexer = NULL;
+
+  GST_DEBUG_OBJECT (self, "Indexed %u keyframes", keyframes->len);
+
+  g_mutex_lock (&self->lock);
+  if (self->media_info && !self->media_info->keyframes) {
+    self->media_info->keyframes = keyframes;
+    g_mutex_unlock (&self->lock);
+    emit_media_info_updated_signal (self);
+  } else {
+    g_mutex_unlock (&self->lock);
+    g_array_unref (keyframes);
+  }
+}
+
+static void
+stop_keyframe_index (GstPlayer * self)
+{
+  if (self->keyframe_indexer) {
+    GST_DEBUG_OBJECT (self, "Cancelling keyframe indexing");
+    gst_player_keyframe_indexer_free (self->keyframe_indexer);
+    self->keyframe_indexer = NULL;
+  }
+}
+
+/* Starts indexing the keyframes of the current media if enabled, or loads
+ * them from the cache */
+static gboolean
+gst_player_update_keyframe_index_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GArray *keyframes = NULL;
+  gboolean enabled, indexed;
+  gchar *uri, *filename;
+
+  g_mutex_lock (&self->lock);
+  enabled = self->keyframe_index;
+  indexed = !self->media_info || self->media_info->keyframes;
+  uri = g_strdup (self->uri);
+  g_mutex_unlock (&self->lock);
+
+  if (!enabled) {
+    stop_keyframe_index (self);
+    goto out;
+  }
+
+  if (indexed || self->keyframe_indexer || self->is_live || !uri)
+    goto out;
+
+  /* Other media would have to be downloaded again */
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  if (!filename)
+    goto out;
+  g_free (filename);
+
+  keyframes = gst_player_keyframe_index_load (uri);
+  if (keyframes) {
+    GST_DEBUG_OBJECT (self, "Loaded %u cached keyframes", keyframes->len);
+
+    g_mutex_lock (&self->lock);
+    if (self->media_info && !self->media_info->keyframes) {
+      self->media_info->keyframes = keyframes;
+      g_mutex_unlock (&self->lock);
+      emit_media_info_updated_signal (self);
+    } else {
+      g_mutex_unlock (&self->lock);
+      g_array_unref (keyframes);
+    }
+  } else {
+    GST_DEBUG_OBJECT (self, "Indexing keyframes of '%s'", uri);
+    self->keyframe_indexer = gst_player_keyframe_indexer_new (uri,
+        self->context, keyframe_indexer_done_cb, self);
+  }
+
+out:
+  g_free (uri);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called from the streaming thread for everything reaching the video sink */
+static GstPadProbeReturn
+frame_cache_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
   GstPlayer *self = GST_PLAYER (user_data);
+  const GstSegment *segment;
+  GstEvent *event;
+  GstCaps *caps;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+        GST_EVENT_FLUSH_STOP)
+      gst_player_frame_cache_discont (self->frame_cache);
+    return GST_PAD_PROBE_OK;
+  }
+
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  caps = gst_pad_get_current_caps (pad);
+  if (event && caps) {
+    gst_event_parse_segment (event, &segment);
+    gst_player_frame_cache_add (self->frame_cache,
+        GST_PAD_PROBE_INFO_BUFFER (info), caps, segment);
+  }
+  if (event)
+    gst_event_unref (event);
+  if (caps)
+    gst_caps_unref (caps);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+add_frame_cache_probe (GstPlayer * self, GstPad * pad)
+{
+  remove_frame_cache_probe (self);
+
+  self->frame_cache_pad = gst_object_ref (pad);
+  self->frame_cache_probe_id = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      frame_cache_probe_cb, self, NULL);
+}
+
+static void
+remove_frame_cache_probe (GstPlayer * self)
+{
+  if (!self->frame_cache_pad)
+    return;
+
+  remove_cached_frame_probe (self);
+  gst_pad_remove_probe (self->frame_cache_pad, self->frame_cache_probe_id);
+  self->frame_cache_probe_id = 0;
+  gst_object_unref (self->frame_cache_pad);
+  self->frame_cache_pad = NULL;
+}
+
+typedef struct
+{
+  GstSample *sample;
+  /* Only buffers after the flush of the seek are replaced, and only the
+   * first of them */
+  gboolean flushed;
+  gboolean done;
+} CachedFrame;
+
+static void
+cached_frame_free (CachedFrame * frame)
+{
+  gst_sample_unref (frame->sample);
+  g_free (frame);
+}
+
+/* Called from the streaming thread of the video sink. Replaces the
+ * keyframe the seek decoded with the cached frame, which the sink then
+ * prerolls on */
+static GstPadProbeReturn
+cached_frame_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  CachedFrame *frame = user_data;
+  GstCaps *caps, *current_caps;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+        GST_EVENT_FLUSH_STOP)
+      frame->flushed = TRUE;
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (!frame->flushed || frame->done)
+    return GST_PAD_PROBE_OK;
+  frame->done = TRUE;
+
+  caps = gst_sample_get_caps (frame->sample);
+  current_caps = gst_pad_get_current_caps (pad);
+  if (!current_caps || !gst_caps_is_equal (caps, current_caps))
+    gst_pad_send_event (pad, gst_event_new_caps (caps));
+  if (current_caps)
+    gst_caps_unref (current_caps);
+
+  gst_pad_send_event (pad,
+      gst_event_new_segment (gst_sample_get_segment (frame->sample)));
+
+  gst_buffer_unref (GST_PAD_PROBE_INFO_BUFFER (info));
+  GST_PAD_PROBE_INFO_DATA (info) =
+      gst_buffer_ref (gst_sample_get_buffer (frame->sample));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+remove_cached_frame_probe (GstPlayer * self)
+{
+  if (self->cached_audio_pad) {
+    gst_pad_remove_probe (self->cached_audio_pad,
+        self->cached_audio_probe_id);
+    self->cached_audio_probe_id = 0;
+    gst_object_unref (self->cached_audio_pad);
+    self->cached_audio_pad = NULL;
+  }
+
+  if (!self->cached_frame_probe_id)
+    return;
+
+  gst_pad_remove_probe (self->frame_cache_pad, self->cached_frame_probe_id);
+  self->cached_frame_probe_id = 0;
+}
+
+typedef struct
+{
+  /* Cached frames, latest first, or NULL for the audio sink */
+  GList *samples;
+  GstClockTime first_position;
+  /* Stream time the reverse playback starts from */
+  GstClockTime position;
+  gboolean flushed;
+  gboolean segment_done;
+  gboolean done;
+  gboolean injecting;
+  /* Buffers from here on were replaced by the cached frames */
+  GstClockTime first_pts;
+} ReverseFrames;
+
+static void
+reverse_frames_free (ReverseFrames * frames)
+{
+  g_list_free_full (frames->samples, (GDestroyNotify) gst_sample_unref);
+  g_free (frames);
+}
+
+/* Sends the cached frames into the video sink before what was decoded,
+ * with the segment they were cached with converted to the current one */
+static GstFlowReturn
+push_reverse_frames (GstPad * pad, ReverseFrames * frames)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  const GstSegment *segment, *frame_segment;
+  GstCaps *caps, *current_caps;
+  GstClockTime position;
+  GstBuffer *buffer;
+  GstEvent *event;
+  GList *l;
+
+  frames->done = TRUE;
+  event = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0);
+  if (!event)
+    return GST_FLOW_OK;
+  gst_event_parse_segment (event, &segment);
+  if (segment->format != GST_FORMAT_TIME
+      || frames->first_position < segment->time) {
+    gst_event_unref (event);
+    return GST_FLOW_OK;
+  }
+  frames->first_pts = segment->start + frames->first_position -
+      segment->time;
+
+  GST_DEBUG_OBJECT (pad, "Playing %u cached frames backwards",
+      g_list_length (frames->samples));
+
+  frames->injecting = TRUE;
+  for (l = frames->samples; l && ret == GST_FLOW_OK; l = l->next) {
+    GstSample *sample = l->data;
+
+    frame_segment = gst_sample_get_segment (sample);
+    buffer = gst_sample_get_buffer (sample);
+    position = gst_segment_to_stream_time (frame_segment, GST_FORMAT_TIME,
+        GST_BUFFER_PTS (buffer));
+    if (!GST_CLOCK_TIME_IS_VALID (position) || position < segment->time)
+      continue;
+
+    caps = gst_sample_get_caps (sample);
+    current_caps = gst_pad_get_current_caps (pad);
+    if (!current_caps || !gst_caps_is_equal (caps, current_caps))
+      gst_pad_send_event (pad, gst_event_new_caps (caps));
+    if (current_caps)
+      gst_caps_unref (current_caps);
+
+    buffer = gst_buffer_copy (buffer);
+    GST_BUFFER_PTS (buffer) = segment->start + position - segment->time;
+    GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
+    if (l == frames->samples)
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    ret = gst_pad_chain (pad, buffer);
+  }
+  frames->injecting = FALSE;
+  gst_event_unref (event);
+
+  return ret;
+}
+
+/* Called from the streaming threads of the video and audio sink after a
+ * reverse seek that stops before the cached frames. Moves the end of the
+ * segment to the position the cached frames go up to, so that everything
+ * decoded plays after them, and puts the cached frames in front of the
+ * decoded video */
+static GstPadProbeReturn
+reverse_frames_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  ReverseFrames *frames = user_data;
+  const GstSegment *segment;
+  GstSegment new_segment;
+  GstBuffer *buffer;
+  GstEvent *event, *new_event;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+        GST_EVENT_FLUSH_STOP)
+      frames->flushed = TRUE;
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (!frames->flushed || frames->injecting)
+    return GST_PAD_PROBE_OK;
+
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT && !frames->segment_done) {
+      frames->segment_done = TRUE;
+      gst_event_parse_segment (event, &segment);
+      if (segment->format != GST_FORMAT_TIME || segment->rate >= 0.0
+          || frames->position < segment->time)
+        return GST_PAD_PROBE_OK;
+
+      gst_segment_copy_into (segment, &new_segment);
+      new_segment.stop = segment->start + frames->position - segment->time;
+      new_event = gst_event_new_segment (&new_segment);
+      gst_event_set_seqnum (new_event, gst_event_get_seqnum (event));
+      gst_event_unref (event);
+      GST_PAD_PROBE_INFO_DATA (info) = new_event;
+    } else if (GST_EVENT_TYPE (event) == GST_EVENT_EOS && frames->samples
+        && !frames->done) {
+      /* Nothing was before the cached frames */
+      push_reverse_frames (pad, frames);
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (!frames->samples)
+    return GST_PAD_PROBE_OK;
+
+  if (!frames->done && push_reverse_frames (pad, frames) == GST_FLOW_FLUSHING)
+    return GST_PAD_PROBE_DROP;
+
+  /* Already shown from the cache */
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  if (GST_BUFFER_PTS_IS_VALID (buffer)
+      && GST_CLOCK_TIME_IS_VALID (frames->first_pts)
+      && GST_BUFFER_PTS (buffer) >= frames->first_pts)
+    return GST_PAD_PROBE_DROP;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Prepares reverse playback from @position to start with the cached
+ * frames before it. Returns where decoding has to stop then, which is
+ * @position if nothing is cached. Must be called from main context */
+static GstClockTime
+add_reverse_frames_probes (GstPlayer * self, GstClockTime position)
+{
+  GstElement *audio_sink = NULL;
+  GstClockTime first_position;
+  ReverseFrames *frames;
+  GList *samples;
+  gboolean enabled;
+
+  g_mutex_lock (&self->lock);
+  enabled = self->frame_cache_size > 0;
+  g_mutex_unlock (&self->lock);
+
+  if (!enabled || !self->frame_cache_pad
+      || !GST_CLOCK_TIME_IS_VALID (position))
+    return position;
+
+  samples = gst_player_frame_cache_get_before (self->frame_cache, position,
+      &first_position);
+  if (!samples)
+    return position;
+
+  GST_DEBUG_OBJECT (self, "Reverse playback from %" GST_TIME_FORMAT
+      " starts with cached frames from %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (position), GST_TIME_ARGS (first_position));
+
+  frames = g_new0 (ReverseFrames, 1);
+  frames->samples = samples;
+  frames->first_position = first_position;
+  frames->position = position;
+  frames->first_pts = GST_CLOCK_TIME_NONE;
+  self->cached_frame_probe_id = gst_pad_add_probe (self->frame_cache_pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH, reverse_frames_probe_cb, frames,
+      (GDestroyNotify) reverse_frames_free);
+
+  /* The audio has to wait for the cached frames as well */
+  g_object_get (self->playbin, "audio-sink", &audio_sink, NULL);
+  if (audio_sink) {
+    self->cached_audio_pad = gst_element_get_static_pad (audio_sink, "sink");
+    gst_object_unref (audio_sink);
+  }
+  if (self->cached_audio_pad) {
+    frames = g_new0 (ReverseFrames, 1);
+    frames->position = position;
+    frames->first_pts = GST_CLOCK_TIME_NONE;
+    self->cached_audio_probe_id = gst_pad_add_probe (self->cached_audio_pad,
+        GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+        reverse_frames_probe_cb, frames,
+        (GDestroyNotify) reverse_frames_free);
+  }
+
+  return first_position;
+}
+
+/* Shows the cached frame at @position instead of decoding everything from
+ * the previous keyframe up to it. The pipeline seeks to that keyframe and
+ * only the keyframe is decoded, the video sink gets the cached frame in
+ * its place from the streaming thread and prerolls on it. Upstream of the
+ * sink continues after the keyframe, so a seek to the shown frame has to
+ * happen before playing on.
+ *
+ * Must be called with lock from main context, which is released while
+ * seeking */
+static gboolean
+show_cached_frame_locked (GstPlayer * self, GstClockTime position)
+{
+  GstClockTime frame_position;
+  CachedFrame *frame;
+  GstSample *sample;
+  GstEvent *s_event;
+
+  if (!self->frame_cache_pad || self->frame_cache_size == 0
+      || !GST_CLOCK_TIME_IS_VALID (position))
+    return FALSE;
+
+  sample = gst_player_frame_cache_lookup (self->frame_cache, position,
+      &frame_position);
+  if (!sample)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (self, "Showing cached frame at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (frame_position));
+
+  self->last_seek_time = gst_util_get_timestamp ();
+  self->seek_position = GST_CLOCK_TIME_NONE;
+  self->seek_flags = 0;
+  self->seek_pending = TRUE;
+  gst_player_frame_cache_set_shown (self->frame_cache, frame_position);
+  g_mutex_unlock (&self->lock);
+
+  remove_tick_source (self);
+  self->is_eos = FALSE;
+
+  remove_cached_frame_probe (self);
+  frame = g_new0 (CachedFrame, 1);
+  frame->sample = sample;
+  self->cached_frame_probe_id = gst_pad_add_probe (self->frame_cache_pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      cached_frame_probe_cb, frame, (GDestroyNotify) cached_frame_free);
+
+  s_event = gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT |
+      GST_SEEK_FLAG_SNAP_BEFORE, GST_SEEK_TYPE_SET, frame_position,
+      GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+  if (!gst_element_send_event (self->playbin, s_event))
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to seek to %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (frame_position)));
+
+  g_mutex_lock (&self->lock);
+
+  return TRUE;
+}
+
+static gpointer
+gst_player_main (gpointer data)
+{
+  GstPlayer *self = GST_PLAYER (data);
+  GstBus *bus;
+  GSource *source;
+  GSource *bus_source;
+  gint64 position;
+
+  GST_TRACE_OBJECT (self, "Starting main thread");
+
+  self->context = g_main_context_new ();
+  g_main_context_push_thread_default (self->context);
+
+  self->loop = g_main_loop_new (self->context, FALSE);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
+      NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  self->playbin = gst_element_factory_make ("playbin", "playbin");
+
+  self->bus = bus = gst_element_get_bus (self->playbin);
+  bus_source = gst_bus_create_watch (bus);
+  g_source_set_callback (bus_source, (GSourceFunc) gst_bus_async_signal_func,
+      NULL, NULL);
+  g_source_attach (bus_source, self->context);
 
-  GST_DEBUG_OBJECT (self, "End of stream");
+  g_signal_connect (G_OBJECT (bus), "message::error", G_CALLBACK (error_cb),
+      self);
+  g_signal_connect (G_OBJECT (bus), "message::warning", G_CALLBACK (warning_cb),
+      self);
+  g_signal_connect (G_OBJECT (bus), "message::eos", G_CALLBACK (eos_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::segment-done",
+      G_CALLBACK (segment_done_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::state-changed",
+      G_CALLBACK (state_changed_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::buffering",
+      G_CALLBACK (buffering_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::clock-lost",
+      G_CALLBACK (clock_lost_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::duration-changed",
+      G_CALLBACK (duration_changed_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::latency",
+      G_CALLBACK (latency_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::request-state",
+      G_CALLBACK (request_state_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::element",
+      G_CALLBACK (element_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::tag", G_CALLBACK (tags_cb), self);
+  g_signal_connect (G_OBJECT (bus), "message::toc", G_CALLBACK (toc_cb), self);
+
+  g_signal_connect (self->playbin, "video-changed",
+      G_CALLBACK (video_changed_cb), self);
+  g_signal_connect (self->playbin, "audio-changed",
+      G_CALLBACK (audio_changed_cb), self);
+  g_signal_connect (self->playbin, "text-changed",
+      G_CALLBACK (subtitle_changed_cb), self);
+
+  g_signal_connect (self->playbin, "video-tags-changed",
+      G_CALLBACK (video_tags_changed_cb), self);
+  g_signal_connect (self->playbin, "audio-tags-changed",
+      G_CALLBACK (audio_tags_changed_cb), self);
+  g_signal_connect (self->playbin, "text-tags-changed",
+      G_CALLBACK (subtitle_tags_changed_cb), self);
+  g_signal_connect (self->playbin, "notify::volume",
+      G_CALLBACK (volume_notify_cb), self);
+  g_signal_connect (self->playbin, "notify::mute",
+      G_CALLBACK (mute_notify_cb), self);
+  g_signal_connect (self->playbin, "element-added",
+      G_CALLBACK (element_added_cb), self);
+  g_signal_connect (self->playbin, "source-setup",
+      G_CALLBACK (source_setup_cb), self);
+
+  self->target_state = GST_STATE_NULL;
+  self->current_state = GST_STATE_NULL;
+  change_state (self, GST_PLAYER_STATE_STOPPED);
+  self->buffering = 100;
+  self->is_eos = FALSE;
+  self->is_live = FALSE;
+
+  GST_TRACE_OBJECT (self, "Starting main loop");
+  g_main_loop_run (self->loop);
+  GST_TRACE_OBJECT (self, "Stopped main loop");
+
+  if (query_position (self, &position))
+    update_resume_position (self, position, TRUE);
+
+  g_main_loop_unref (self->loop);
+  self->loop = NULL;
+
+  g_source_destroy (bus_source);
+  g_source_unref (bus_source);
+  gst_object_unref (bus);
 
-  tick_cb (self);
   remove_tick_source (self);
+  remove_ready_timeout_source (self);
+  stop_keyframe_index (self);
+  stop_subtitle_index (self);
 
-  if (self->dispatch_to_main_context
-      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_END_OF_STREAM], 0, NULL, NULL, NULL) != 0) {
-    g_main_context_invoke_full (self->application_context, G_PRIORITY_DEFAULT,
-        eos_dispatch, g_object_ref (self), (GDestroyNotify) g_object_unref);
+  if (self->discoverer) {
+    gst_discoverer_stop (self->discoverer);
+    g_object_unref (self->discoverer);
+    self->discoverer = NULL;
+  }
+
+  if (self->resume_positions) {
+    gst_player_resume_store_close (self->resume_positions);
+    self->resume_positions = NULL;
+  }
+  g_free (self->resume_uri);
+  self->resume_uri = NULL;
+
+  if (self->adaptive_demux) {
+    gst_object_unref (self->adaptive_demux);
+    self->adaptive_demux = NULL;
+  }
+
+  g_mutex_lock (&self->lock);
+  if (self->media_info) {
+    g_object_unref (self->media_info);
+    self->media_info = NULL;
+  }
+
+  if (self->seek_source)
+    g_source_unref (self->seek_source);
+  self->seek_source = NULL;
+  g_mutex_unlock (&self->lock);
+
+  g_main_context_pop_thread_default (self->context);
+  g_main_context_unref (self->context);
+  self->context = NULL;
+
+  gst_player_remove_injected_subtitle (self);
+
+  self->target_state = GST_STATE_NULL;
+  self->current_state = GST_STATE_NULL;
+  if (self->playbin) {
+    gst_element_set_state (self->playbin, GST_STATE_NULL);
+    remove_frame_cache_probe (self);
+    gst_object_unref (self->playbin);
+    self->playbin = NULL;
+  }
+  if (self->audio_mixer_sink) {
+    gst_object_unref (self->audio_mixer_sink);
+    self->audio_mixer_sink = NULL;
+  }
+  if (self->audio_sink_before_mixer) {
+    gst_object_unref (self->audio_sink_before_mixer);
+    self->audio_sink_before_mixer = NULL;
+  }
+  if (self->clip_voices) {
+    gst_player_audio_mixer_voices_free (self->clip_voices);
+    self->clip_voices = NULL;
+  }
+
+  GST_TRACE_OBJECT (self, "Stopped main thread");
+
+  return NULL;
+}
+
+static gpointer
+gst_player_init_once (gpointer user_data)
+{
+  gst_init (NULL, NULL);
+
+  GST_DEBUG_CATEGORY_INIT (gst_player_debug, "gst-player", 0, "GstPlayer");
+  gst_player_error_quark ();
+
+  return NULL;
+}
+
+/**
+ * gst_player_new:
+ *
+ * Returns: a new #GstPlayer instance
+ */
+GstPlayer *
+gst_player_new (void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, gst_player_init_once, NULL);
+
+  return g_object_new (GST_TYPE_PLAYER, NULL);
+}
+
+static gboolean
+gst_player_play_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstStateChangeReturn state_ret;
+  GstClockTime shown;
+
+  GST_DEBUG_OBJECT (self, "Play");
+
+  g_mutex_lock (&self->lock);
+  if (!self->uri) {
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_REMOVE;
+  }
+  g_mutex_unlock (&self->lock);
+
+  remove_ready_timeout_source (self);
+  self->target_state = GST_STATE_PLAYING;
+
+  if (self->current_state < GST_STATE_PAUSED)
+    change_state (self, GST_PLAYER_STATE_BUFFERING);
+
+  /* Upstream of the video sink is at the keyframe before a cached frame
+   * that was shown and has to continue from that frame first */
+  shown = gst_player_frame_cache_get_shown (self->frame_cache);
+  g_mutex_lock (&self->lock);
+  if (GST_CLOCK_TIME_IS_VALID (shown)
+      && self->current_state >= GST_STATE_PAUSED) {
+    GST_DEBUG_OBJECT (self, "Resyncing to cached frame at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (shown));
+    if (!GST_CLOCK_TIME_IS_VALID (self->seek_position)) {
+      self->seek_position = shown;
+      self->seek_flags = GST_SEEK_FLAG_ACCURATE;
+    }
+    gst_player_frame_cache_set_shown (self->frame_cache, GST_CLOCK_TIME_NONE);
+    if (!self->seek_pending)
+      gst_player_seek_internal_locked (self);
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_REMOVE;
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (self->current_state >= GST_STATE_PAUSED && !self->is_eos) {
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
   } else {
-    g_signal_emit (self, signals[SIGNAL_END_OF_STREAM], 0);
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
   }
-  change_state (self, GST_PLAYER_STATE_STOPPED);
-  self->buffering = 100;
-  self->is_eos = TRUE;
+
+  if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
+    self->is_live = TRUE;
+    GST_DEBUG_OBJECT (self, "Pipeline is live");
+  }
+
+  if (state_ret == GST_STATE_CHANGE_FAILURE) {
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to play"));
+    return G_SOURCE_REMOVE;
+  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
+    self->is_live = TRUE;
+    GST_DEBUG_OBJECT (self, "Pipeline is live");
+  }
+
+  if (self->is_eos) {
+    gboolean ret;
+
+    GST_DEBUG_OBJECT (self, "Was EOS, seeking to beginning");
+    self->is_eos = FALSE;
+    ret =
+        gst_element_seek_simple (self->playbin, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH, 0);
+    if (!ret) {
+      GST_ERROR_OBJECT (self, "Seek to beginning failed");
+      gst_player_stop_internal (self);
+      gst_player_play_internal (self);
+    }
+  }
+
+  return G_SOURCE_REMOVE;
 }
 
-typedef struct
+/**
+ * gst_player_play:
+ * @player: #GstPlayer instance
+ *
+ * Request to play the loaded stream.
+ */
+void
+gst_player_play (GstPlayer * self)
 {
-  GstPlayer *player;
-  gint percent;
-} BufferingSignalData;
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_play_internal, self, NULL);
+}
 
 static gboolean
-buffering_dispatch (gpointer user_data)
+gst_player_pause_internal (gpointer user_data)
 {
-  BufferingSignalData *data = user_data;
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstStateChangeReturn state_ret;
 
-  if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_BUFFERING], 0, data->percent);
+  GST_DEBUG_OBJECT (self, "Pause");
+
+  g_mutex_lock (&self->lock);
+  if (!self->uri) {
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_REMOVE;
+  }
+  g_mutex_unlock (&self->lock);
+
+  tick_cb (self);
+  remove_tick_source (self);
+  remove_ready_timeout_source (self);
+
+  self->target_state = GST_STATE_PAUSED;
+
+  if (self->current_state < GST_STATE_PAUSED)
+    change_state (self, GST_PLAYER_STATE_BUFFERING);
+
+  state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
+  if (state_ret == GST_STATE_CHANGE_FAILURE) {
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to pause"));
+    return G_SOURCE_REMOVE;
+  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
+    self->is_live = TRUE;
+    GST_DEBUG_OBJECT (self, "Pipeline is live");
+  }
+
+  if (self->is_eos) {
+    gboolean ret;
+
+    GST_DEBUG_OBJECT (self, "Was EOS, seeking to beginning");
+    self->is_eos = FALSE;
+    ret =
+        gst_element_seek_simple (self->playbin, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH, 0);
+    if (!ret) {
+      GST_ERROR_OBJECT (self, "Seek to beginning failed");
+      gst_player_stop_internal (self);
+      gst_player_pause_internal (self);
+    }
   }
 
   return G_SOURCE_REMOVE;
 }
 
-static void
-buffering_signal_data_free (BufferingSignalData * data)
+/**
+ * gst_player_pause:
+ * @player: #GstPlayer instance
+ *
+ * Pauses the current stream.
+ */
+void
+gst_player_pause (GstPlayer * self)
 {
-  g_object_unref (data->player);
-  g_free (data);
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_pause_internal, self, NULL);
 }
 
-static void
-buffering_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+static gboolean
+gst_player_stop_internal (gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
-  gint percent;
-
-  if (self->target_state < GST_STATE_PAUSED)
-    return;
-  if (self->is_live)
-    return;
-
-  gst_message_parse_buffering (msg, &percent);
-  GST_LOG_OBJECT (self, "Buffering %d%%", percent);
+  gboolean had_injected_sub;
+  gint64 position;
 
-  if (percent < 100 && self->target_state >= GST_STATE_PAUSED) {
-    GstStateChangeReturn state_ret;
+  GST_DEBUG_OBJECT (self, "Stop");
 
-    GST_DEBUG_OBJECT (self, "Waiting for buffering to finish");
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
+  if (query_position (self, &position))
+    update_resume_position (self, position, TRUE);
+  tick_cb (self);
+  remove_tick_source (self);
 
-    if (state_ret == GST_STATE_CHANGE_FAILURE) {
-      emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-              "Failed to handle buffering"));
-      return;
-    }
+  add_ready_timeout_source (self);
+  stop_keyframe_index (self);
 
-    change_state (self, GST_PLAYER_STATE_BUFFERING);
-  }
+  had_injected_sub = gst_player_remove_injected_subtitle (self);
 
-  if (self->buffering != percent) {
-    if (self->dispatch_to_main_context
-        && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-            signals[SIGNAL_BUFFERING], 0, NULL, NULL, NULL) != 0) {
-      BufferingSignalData *data = g_new (BufferingSignalData, 1);
+  self->target_state = GST_STATE_NULL;
+  self->current_state = GST_STATE_READY;
+  self->is_live = FALSE;
+  self->is_eos = FALSE;
+  gst_bus_set_flushing (self->bus, TRUE);
+  gst_element_set_state (self->playbin, GST_STATE_READY);
+  gst_bus_set_flushing (self->bus, FALSE);
+  remove_frame_cache_probe (self);
+  gst_player_frame_cache_clear (self->frame_cache);
 
-      data->player = g_object_ref (self);
-      data->percent = percent;
-      g_main_context_invoke_full (self->application_context,
-          G_PRIORITY_DEFAULT, buffering_dispatch, data,
-          (GDestroyNotify) buffering_signal_data_free);
-    } else {
-      g_signal_emit (self, signals[SIGNAL_BUFFERING], 0, percent);
-    }
+  /* Make sure the next preroll loads the hot-added subtitle natively */
+  if (had_injected_sub) {
+    set_playbin_suburi (self);
 
-    self->buffering = percent;
+    g_mutex_lock (&self->lock);
+    set_playbin_uri_locked (self);
+    g_mutex_unlock (&self->lock);
   }
-
-
+  change_state (self, GST_PLAYER_STATE_STOPPED);
+  self->buffering = 100;
   g_mutex_lock (&self->lock);
-  if (percent == 100 && (self->seek_position != GST_CLOCK_TIME_NONE ||
-          self->seek_pending)) {
-    g_mutex_unlock (&self->lock);
-
-    GST_DEBUG_OBJECT (self, "Buffering finished - seek pending");
-  } else if (percent == 100 && self->target_state >= GST_STATE_PLAYING
-      && self->current_state >= GST_STATE_PAUSED) {
-    GstStateChangeReturn state_ret;
+  if (self->media_info) {
+    g_object_unref (self->media_info);
+    self->media_info = NULL;
+  }
+  if (self->global_tags) {
+    gst_tag_list_unref (self->global_tags);
+    self->global_tags = NULL;
+  }
+  if (self->global_toc) {
+    gst_toc_unref (self->global_toc);
+    self->global_toc = NULL;
+  }
+  self->seek_pending = FALSE;
+  if (self->seek_source) {
+    g_source_destroy (self->seek_source);
+    g_source_unref (self->seek_source);
+    self->seek_source = NULL;
+  }
+  self->seek_position = GST_CLOCK_TIME_NONE;
+  self->seek_flags = 0;
+  self->last_seek_time = GST_CLOCK_TIME_NONE;
+  self->scrubbing = FALSE;
+  self->scrub_position = GST_CLOCK_TIME_NONE;
+  self->scrub_resume = FALSE;
+  self->rate = 1.0;
+  self->live_edge_delay = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&self->lock);
+  self->catching_up = FALSE;
+  self->step_target = GST_CLOCK_TIME_NONE;
 
-    g_mutex_unlock (&self->lock);
+  return G_SOURCE_REMOVE;
+}
 
-    GST_DEBUG_OBJECT (self, "Buffering finished - going to PLAYING");
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
-    /* Application state change is happening when the state change happened */
-    if (state_ret == GST_STATE_CHANGE_FAILURE)
-      emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-              "Failed to handle buffering"));
-  } else if (percent == 100 && self->target_state >= GST_STATE_PAUSED) {
-    g_mutex_unlock (&self->lock);
+/**
+ * gst_player_stop:
+ * @player: #GstPlayer instance
+ *
+ * Stops playing the current stream and resets to the first position
+ * in the stream.
+ */
+void
+gst_player_stop (GstPlayer * self)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-    GST_DEBUG_OBJECT (self, "Buffering finished - staying PAUSED");
-    change_state (self, GST_PLAYER_STATE_PAUSED);
-  } else {
-    g_mutex_unlock (&self->lock);
-  }
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_stop_internal, self, NULL);
 }
 
+/* Must be called with lock from main context, releases lock! */
 static void
-clock_lost_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+gst_player_seek_internal_locked (GstPlayer * self)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
+  gboolean ret, loop;
+  GstClockTime position, stop, loop_start, loop_end;
+  GstSeekType stop_type = GST_SEEK_TYPE_NONE;
+  gdouble rate;
   GstStateChangeReturn state_ret;
+  GstEvent *s_event;
+  GstSeekFlags flags;
 
-  GST_DEBUG_OBJECT (self, "Clock lost");
-  if (self->target_state >= GST_STATE_PLAYING) {
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
-    if (state_ret != GST_STATE_CHANGE_FAILURE)
-      state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
+  if (self->seek_source) {
+    g_source_destroy (self->seek_source);
+    g_source_unref (self->seek_source);
+    self->seek_source = NULL;
+  }
 
-    if (state_ret == GST_STATE_CHANGE_FAILURE)
+  /* Only seek in PAUSED */
+  if (self->current_state < GST_STATE_PAUSED) {
+    return;
+  } else if (self->current_state != GST_STATE_PAUSED) {
+    g_mutex_unlock (&self->lock);
+    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
+    if (state_ret == GST_STATE_CHANGE_FAILURE) {
       emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-              "Failed to handle clock loss"));
+              "Failed to seek"));
+      g_mutex_lock (&self->lock);
+      return;
+    }
+    g_mutex_lock (&self->lock);
+    return;
   }
-}
 
-typedef struct
-{
-  GstPlayer *player;
-  gint width, height;
-} VideoDimensionsChangedSignalData;
+  /* Paused on a frame that is still cached, nothing has to be decoded */
+  if (self->target_state == GST_STATE_PAUSED && self->rate == 1.0
+      && !self->is_live) {
+    if (show_cached_frame_locked (self, self->seek_position))
+      return;
+  }
 
-static gboolean
-video_dimensions_changed_dispatch (gpointer user_data)
-{
-  VideoDimensionsChangedSignalData *data = user_data;
+  /* Everything is flushed and restarts from the new position */
+  gst_player_frame_cache_set_shown (self->frame_cache, GST_CLOCK_TIME_NONE);
+  remove_cached_frame_probe (self);
 
-  if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0,
-        data->width, data->height);
-  }
+  self->last_seek_time = gst_util_get_timestamp ();
+  position = self->seek_position;
+  self->seek_position = GST_CLOCK_TIME_NONE;
+  flags = self->seek_flags;
+  self->seek_flags = 0;
+  self->seek_pending = TRUE;
 
-  return G_SOURCE_REMOVE;
-}
+  /* Nothing after a known keyframe has to be decoded to reach it */
+  if (!(flags & GST_SEEK_FLAG_KEY_UNIT) && self->media_info
+      && gst_player_media_info_get_nearest_keyframe (self->media_info,
+          position) == position)
+    flags |= GST_SEEK_FLAG_KEY_UNIT;
 
-static void
-video_dimensions_changed_signal_data_free (VideoDimensionsChangedSignalData *
-    data)
-{
-  g_object_unref (data->player);
-  g_free (data);
-}
+  rate = self->rate;
+  loop = self->looping;
+  loop_start = self->loop_start;
+  loop_end = self->loop_end;
+  g_mutex_unlock (&self->lock);
 
-static void
-check_video_dimensions_changed (GstPlayer * self)
-{
-  GstElement *video_sink;
-  GstPad *video_sink_pad;
-  GstCaps *caps;
-  GstVideoInfo info;
-  gint width = 0, height = 0;
+  remove_tick_source (self);
+  self->is_eos = FALSE;
 
-  g_object_get (self->playbin, "video-sink", &video_sink, NULL);
-  if (!video_sink)
-    goto out;
+  flags |= GST_SEEK_FLAG_FLUSH;
 
-  video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
-  if (!video_sink_pad) {
-    gst_object_unref (video_sink);
-    goto out;
+  /* Ends with SEGMENT_DONE instead of EOS, from where the loop continues */
+  if (loop) {
+    flags |= GST_SEEK_FLAG_SEGMENT;
+    stop_type = GST_CLOCK_TIME_IS_VALID (loop_end) ? GST_SEEK_TYPE_SET :
+        GST_SEEK_TYPE_NONE;
   }
 
-  caps = gst_pad_get_current_caps (video_sink_pad);
-
-  if (caps) {
-    if (gst_video_info_from_caps (&info, caps)) {
-      info.width = info.width * info.par_n / info.par_d;
+  if (rate != 1.0) {
+    flags |= GST_SEEK_FLAG_TRICKMODE;
+  } else if (self->catching_up) {
+    /* Everything is still decoded, this is no trick mode */
+    rate = LIVE_CATCH_UP_RATE;
+  }
 
-      GST_DEBUG_OBJECT (self, "Video dimensions changed: %dx%d", info.width,
-          info.height);
-      width = info.width;
-      height = info.height;
-    }
+  if (rate >= 0.0) {
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+        GST_SEEK_TYPE_SET, position, stop_type, loop_end);
+  } else {
+    /* Only what is before the cached frames has to be decoded */
+    stop = self->is_live ? position :
+        add_reverse_frames_probes (self, position);
+    if (loop && stop < loop_start)
+      stop = loop_start;
 
-    gst_caps_unref (caps);
+    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
+        GST_SEEK_TYPE_SET, loop ? loop_start : 0, GST_SEEK_TYPE_SET, stop);
   }
-  gst_object_unref (video_sink_pad);
-  gst_object_unref (video_sink);
 
-out:
-  if (self->dispatch_to_main_context
-      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0, NULL, NULL, NULL) != 0) {
-    VideoDimensionsChangedSignalData *data =
-        g_new (VideoDimensionsChangedSignalData, 1);
+  GST_DEBUG_OBJECT (self, "Seek with rate %.2lf to %" GST_TIME_FORMAT,
+      rate, GST_TIME_ARGS (position));
 
-    data->player = g_object_ref (self);
-    data->width = width;
-    data->height = height;
-    g_main_context_invoke_full (self->application_context,
-        G_PRIORITY_DEFAULT, video_dimensions_changed_dispatch, data,
-        (GDestroyNotify) video_dimensions_changed_signal_data_free);
-  } else {
-    g_signal_emit (self, signals[SIGNAL_VIDEO_DIMENSIONS_CHANGED], 0,
-        width, height);
-  }
+  ret = gst_element_send_event (self->playbin, s_event);
+  if (!ret)
+    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
+            "Failed to seek to %" GST_TIME_FORMAT, GST_TIME_ARGS (position)));
+
+  g_mutex_lock (&self->lock);
 }
 
-static void
-notify_caps_cb (GObject * object, GParamSpec * pspec, gpointer user_data)
+static gboolean
+gst_player_seek_internal (gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
 
-  check_video_dimensions_changed (self);
-}
+  g_mutex_lock (&self->lock);
+  gst_player_seek_internal_locked (self);
+  g_mutex_unlock (&self->lock);
 
-typedef struct
-{
-  GstPlayer *player;
-  GstClockTime duration;
-} DurationChangedSignalData;
+  return G_SOURCE_REMOVE;
+}
 
 static gboolean
-duration_changed_dispatch (gpointer user_data)
+gst_player_set_rate_internal (gpointer user_data)
 {
-  DurationChangedSignalData *data = user_data;
+  GstPlayer *self = user_data;
 
-  if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_DURATION_CHANGED], 0,
-        data->duration);
-    g_object_notify_by_pspec (G_OBJECT (data->player),
-        param_specs[PROP_DURATION]);
+  g_mutex_lock (&self->lock);
+
+  self->seek_position = gst_player_get_position (self);
+
+  /* If there is no seek being dispatch to the main context currently do that,
+   * otherwise we just updated the rate so that it will be taken by
+   * the seek handler from the main context instead of the old one.
+   */
+  if (!self->seek_source) {
+    /* If no seek is pending then create new seek source */
+    if (!self->seek_pending) {
+      self->seek_source = g_idle_source_new ();
+      g_source_set_callback (self->seek_source,
+          (GSourceFunc) gst_player_seek_internal, self, NULL);
+      g_source_attach (self->seek_source, self->context);
+    }
   }
 
+  g_mutex_unlock (&self->lock);
+
   return G_SOURCE_REMOVE;
 }
 
-static void
-duration_changed_signal_data_free (DurationChangedSignalData * data)
+/**
+ * gst_player_set_rate:
+ * @player: #GstPlayer instance
+ * @rate: playback rate
+ *
+ * Playback at specified rate
+ */
+void
+gst_player_set_rate (GstPlayer * self, gdouble rate)
 {
-  g_object_unref (data->player);
-  g_free (data);
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (rate != 0.0);
+
+  g_mutex_lock (&self->lock);
+  self->rate = rate;
+  g_mutex_unlock (&self->lock);
+
+  gst_player_set_rate_internal (self);
 }
 
-static void
-emit_duration_changed (GstPlayer * self, GstClockTime duration)
+/**
+ * gst_player_get_rate:
+ * @player: #GstPlayer instance
+ *
+ * Returns: current playback rate
+ */
+gdouble
+gst_player_get_rate (GstPlayer * self)
 {
-  GST_DEBUG_OBJECT (self, "Duration changed %" GST_TIME_FORMAT,
-      GST_TIME_ARGS (duration));
+  g_return_val_if_fail (GST_IS_PLAYER (self), 1.0);
 
-  if (self->dispatch_to_main_context
-      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_DURATION_CHANGED], 0, NULL, NULL, NULL) != 0) {
-    DurationChangedSignalData *data = g_new (DurationChangedSignalData, 1);
+  return self->rate;
+}
 
-    data->player = g_object_ref (self);
-    data->duration = duration;
-    g_main_context_invoke_full (self->application_context,
-        G_PRIORITY_DEFAULT, duration_changed_dispatch, data,
-        (GDestroyNotify) duration_changed_signal_data_free);
-  } else {
-    g_signal_emit (self, signals[SIGNAL_DURATION_CHANGED], 0, duration);
-    g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_DURATION]);
+/* Redoes the current segment with the new loop boundaries from where
+ * playback is */
+static gboolean
+gst_player_update_loop_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstClockTime position;
+
+  self->loop_iteration = 0;
+
+  /* Otherwise done with the initial seek once prerolled */
+  if (self->current_state < GST_STATE_PAUSED || self->is_live)
+    return G_SOURCE_REMOVE;
+
+  g_mutex_lock (&self->lock);
+  position = gst_player_get_position (self);
+  if (self->looping && (!GST_CLOCK_TIME_IS_VALID (position)
+          || position < self->loop_start
+          || (GST_CLOCK_TIME_IS_VALID (self->loop_end)
+              && position >= self->loop_end)))
+    position = self->loop_start;
+  self->seek_position = position;
+
+  if (!self->seek_source && !self->seek_pending) {
+    self->seek_source = g_idle_source_new ();
+    g_source_set_callback (self->seek_source,
+        (GSourceFunc) gst_player_seek_internal, self, NULL);
+    g_source_attach (self->seek_source, self->context);
   }
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
 }
 
-static void
-state_changed_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+/**
+ * gst_player_set_loop:
+ * @player: #GstPlayer instance
+ * @start: start of the loop in nanoseconds
+ * @end: end of the loop in nanoseconds, or #GST_CLOCK_TIME_NONE for the
+ *   end of the media
+ *
+ * Plays the part between @start and @end over and over again, or the whole
+ * media for 0 and #GST_CLOCK_TIME_NONE. Playback wraps around without
+ * a gap, nothing is flushed or reloaded. Each time it wraps around, the
+ * #GstPlayer::loop-iteration signal is emitted with the number of
+ * completed iterations.
+ *
+ * Applies to all following media until gst_player_unset_loop(). Playback
+ * that is already past @end continues at @start.
+ */
+void
+gst_player_set_loop (GstPlayer * self, GstClockTime start, GstClockTime end)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GstState old_state, new_state, pending_state;
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (start));
+  g_return_if_fail (!GST_CLOCK_TIME_IS_VALID (end) || end > start);
 
-  gst_message_parse_state_changed (msg, &old_state, &new_state, &pending_state);
+  g_mutex_lock (&self->lock);
+  self->looping = TRUE;
+  self->loop_start = start;
+  self->loop_end = end;
+  g_mutex_unlock (&self->lock);
 
-  if (GST_MESSAGE_SRC (msg) == GST_OBJECT (self->playbin)) {
-    gchar *transition_name;
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_update_loop_internal, self, NULL);
+}
 
-    GST_DEBUG_OBJECT (self, "Changed state old: %s new: %s pending: %s",
-        gst_element_state_get_name (old_state),
-        gst_element_state_get_name (new_state),
-        gst_element_state_get_name (pending_state));
+/**
+ * gst_player_unset_loop:
+ * @player: #GstPlayer instance
+ *
+ * Stops looping. Playback continues to the end of the media.
+ */
+void
+gst_player_unset_loop (GstPlayer * self)
+{
+  gboolean had_end;
 
-    transition_name = g_strdup_printf ("%s_%s",
-        gst_element_state_get_name (old_state),
-        gst_element_state_get_name (new_state));
-    dump_dot_file (self, transition_name);
-    g_free (transition_name);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-    self->current_state = new_state;
+  g_mutex_lock (&self->lock);
+  had_end = self->looping && GST_CLOCK_TIME_IS_VALID (self->loop_end);
+  self->looping = FALSE;
+  self->loop_start = 0;
+  self->loop_end = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&self->lock);
 
-    if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED
-        && pending_state == GST_STATE_VOID_PENDING) {
-      GstElement *video_sink;
-      GstPad *video_sink_pad;
-      gint64 duration = -1;
+  /* The last iteration of a whole media loop simply ends */
+  if (had_end)
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+        gst_player_update_loop_internal, self, NULL);
+}
 
-      GST_DEBUG_OBJECT (self, "Initial PAUSED - pre-rolled");
+/**
+ * gst_player_get_loop:
+ * @player: #GstPlayer instance
+ * @start: (out) (allow-none): start of the loop in nanoseconds
+ * @end: (out) (allow-none): end of the loop in nanoseconds, or
+ *   #GST_CLOCK_TIME_NONE for the end of the media
+ *
+ * Retrieves the loop set with gst_player_set_loop().
+ *
+ * Returns: %TRUE if playback loops.
+ */
+gboolean
+gst_player_get_loop (GstPlayer * self, GstClockTime * start,
+    GstClockTime * end)
+{
+  gboolean loop;
 
-      g_mutex_lock (&self->lock);
-      if (self->media_info)
-        g_object_unref (self->media_info);
-      self->media_info = gst_player_media_info_create (self);
-      g_mutex_unlock (&self->lock);
-      emit_media_info_updated_signal (self);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-      g_object_get (self->playbin, "video-sink", &video_sink, NULL);
+  g_mutex_lock (&self->lock);
+  loop = self->looping;
+  if (start)
+    *start = self->loop_start;
+  if (end)
+    *end = self->loop_end;
+  g_mutex_unlock (&self->lock);
 
-      if (video_sink) {
-        video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
+  return loop;
+}
 
-        if (video_sink_pad) {
-          g_signal_connect (video_sink_pad, "notify::caps",
-              (GCallback) notify_caps_cb, self);
-          gst_object_unref (video_sink_pad);
-        }
-        gst_object_unref (video_sink);
-      }
+typedef struct
+{
+  GstPlayer *player;
+  gint n_frames;
+} StepRequest;
 
-      check_video_dimensions_changed (self);
-      gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration);
-      emit_duration_changed (self, duration);
-    }
+/* From the framerate if the frames have no duration */
+static GstClockTime
+get_frame_duration (GstPlayer * self)
+{
+  GstClockTime duration = GST_CLOCK_TIME_NONE;
+  GstStructure *s;
+  GstCaps *caps;
+  gint fps_n, fps_d;
 
-    if (new_state == GST_STATE_PAUSED
-        && pending_state == GST_STATE_VOID_PENDING) {
-      remove_tick_source (self);
+  caps = gst_pad_get_current_caps (self->frame_cache_pad);
+  if (!caps)
+    return GST_CLOCK_TIME_NONE;
 
-      g_mutex_lock (&self->lock);
-      if (self->seek_pending) {
-        self->seek_pending = FALSE;
+  s = gst_caps_get_structure (caps, 0);
+  if (gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d)
+      && fps_n > 0 && fps_d > 0)
+    duration = gst_util_uint64_scale_int (GST_SECOND, fps_d, fps_n);
+  gst_caps_unref (caps);
 
-        if (!self->media_info->seekable) {
-          GST_DEBUG_OBJECT (self, "Media is not seekable");
-          if (self->seek_source) {
-            g_source_destroy (self->seek_source);
-            g_source_unref (self->seek_source);
-            self->seek_source = NULL;
-          }
-          self->seek_position = GST_CLOCK_TIME_NONE;
-          self->last_seek_time = GST_CLOCK_TIME_NONE;
-        } else if (self->seek_source) {
-          GST_DEBUG_OBJECT (self, "Seek finished but new seek is pending");
-          gst_player_seek_internal_locked (self);
-        } else {
-          GST_DEBUG_OBJECT (self, "Seek finished");
-        }
-      }
+  return duration;
+}
 
-      if (self->seek_position != GST_CLOCK_TIME_NONE) {
-        GST_DEBUG_OBJECT (self, "Seeking now that we reached PAUSED state");
-        gst_player_seek_internal_locked (self);
-        g_mutex_unlock (&self->lock);
-      } else if (!self->seek_pending) {
-        g_mutex_unlock (&self->lock);
+static gboolean
+gst_player_step_internal (gpointer user_data)
+{
+  StepRequest *request = user_data;
+  GstPlayer *self = request->player;
+  GstClockTime position, duration, offset, target, shown;
+  gboolean seeking;
 
-        tick_cb (self);
+  if (self->current_state < GST_STATE_PAUSED || self->is_live
+      || !self->frame_cache_pad) {
+    GST_DEBUG_OBJECT (self, "Can't step without prerolled video");
+    return G_SOURCE_REMOVE;
+  }
 
-        if (self->target_state >= GST_STATE_PLAYING && self->buffering == 100) {
-          GstStateChangeReturn state_ret;
+  if (!gst_player_frame_cache_get_current (self->frame_cache, &position,
+          &duration)) {
+    gint64 current = 0;
 
-          state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
-          if (state_ret == GST_STATE_CHANGE_FAILURE)
-            emit_error (self, g_error_new (GST_PLAYER_ERROR,
-                    GST_PLAYER_ERROR_FAILED, "Failed to play"));
-        } else if (self->buffering == 100) {
-          change_state (self, GST_PLAYER_STATE_PAUSED);
-        }
-      } else {
-        g_mutex_unlock (&self->lock);
-      }
-    } else if (new_state == GST_STATE_PLAYING
-        && pending_state == GST_STATE_VOID_PENDING) {
+    query_position (self, &current);
+    position = current;
+  }
+  if (!GST_CLOCK_TIME_IS_VALID (duration))
+    duration = get_frame_duration (self);
 
-      /* If no seek is currently pending, add the tick source. This can happen
-       * if we seeked already but the state-change message was still queued up */
-      if (!self->seek_pending) {
-        add_tick_source (self);
-        change_state (self, GST_PLAYER_STATE_PLAYING);
-      }
-    } else if (new_state == GST_STATE_READY && old_state > GST_STATE_READY) {
-      change_state (self, GST_PLAYER_STATE_STOPPED);
-    } else {
-      /* Otherwise we neither reached PLAYING nor PAUSED, so must
-       * wait for something to happen... i.e. are BUFFERING now */
-      change_state (self, GST_PLAYER_STATE_BUFFERING);
+  /* The frame the previous step is going to show is not known to the
+   * sink yet */
+  shown = gst_player_frame_cache_get_shown (self->frame_cache);
+  g_mutex_lock (&self->lock);
+  seeking = self->seek_pending || self->seek_source;
+  g_mutex_unlock (&self->lock);
+  if (seeking && GST_CLOCK_TIME_IS_VALID (self->step_target))
+    position = self->step_target;
+  else if (GST_CLOCK_TIME_IS_VALID (shown))
+    position = shown;
+
+  /* The next frames are decoded already, the sink only has to skip to
+   * them */
+  if (request->n_frames > 0 && self->target_state == GST_STATE_PAUSED
+      && self->current_state == GST_STATE_PAUSED
+      && !GST_CLOCK_TIME_IS_VALID (shown) && !seeking) {
+    GstElement *video_sink = NULL;
+
+    GST_DEBUG_OBJECT (self, "Stepping %d frames", request->n_frames);
+
+    g_object_get (self->playbin, "video-sink", &video_sink, NULL);
+    if (video_sink) {
+      gst_element_send_event (video_sink,
+          gst_event_new_step (GST_FORMAT_BUFFERS, request->n_frames, 1.0,
+              FALSE, FALSE));
+      gst_object_unref (video_sink);
     }
+    return G_SOURCE_REMOVE;
+  }
+
+  if (!GST_CLOCK_TIME_IS_VALID (duration)) {
+    GST_WARNING_OBJECT (self, "Can't step with unknown frame duration");
+    return G_SOURCE_REMOVE;
+  }
+
+  /* Otherwise an accurate seek to the frame, preferably to the cached
+   * one */
+  offset = ABS (request->n_frames) * duration;
+  if (request->n_frames > 0)
+    target = position + offset;
+  else if (position >= offset)
+    target = position - offset;
+  else
+    target = 0;
+  self->step_target = target;
+
+  GST_DEBUG_OBJECT (self, "Stepping %d frames to %" GST_TIME_FORMAT,
+      request->n_frames, GST_TIME_ARGS (target));
+
+  if (self->target_state != GST_STATE_PAUSED)
+    gst_player_pause_internal (self);
+
+  /* The middle of the frame is robust against rounding */
+  g_mutex_lock (&self->lock);
+  self->seek_position = target + duration / 2;
+  self->seek_flags = GST_SEEK_FLAG_ACCURATE;
+  if (!self->seek_source && !self->seek_pending) {
+    self->seek_source = g_idle_source_new ();
+    g_source_set_callback (self->seek_source,
+        (GSourceFunc) gst_player_seek_internal, self, NULL);
+    g_source_attach (self->seek_source, self->context);
   }
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
 }
 
-static void
-duration_changed_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+/**
+ * gst_player_step:
+ * @player: #GstPlayer instance
+ * @n_frames: number of video frames to step, negative to step backwards
+ *
+ * Pauses playback and steps @n_frames video frames forward or backward
+ * from the currently shown frame.
+ *
+ * Stepping backward needs the frame to be decoded again from the previous
+ * keyframe, unless it is still in the frame cache. The cache is enabled
+ * with the #GstPlayer:frame-cache-size property and also serves seeks
+ * while paused, e.g. when scrubbing over recently shown frames, and the
+ * start of reverse playback, which plays the cached frames before the
+ * position first and only decodes the media before them.
+ */
+void
+gst_player_step (GstPlayer * self, gint n_frames)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  gint64 duration;
+  StepRequest *request;
 
-  if (gst_element_query_duration (self->playbin, GST_FORMAT_TIME, &duration)) {
-    emit_duration_changed (self, duration);
-  }
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  if (n_frames == 0)
+    return;
+
+  request = g_new (StepRequest, 1);
+  request->player = self;
+  request->n_frames = n_frames;
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_step_internal, request, g_free);
 }
 
-static void
-latency_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+/* Makes the pipeline run on the clock of a #GstPlayerGroup, with the base
+ * time only set by the group, or selects the clock on its own again if
+ * @clock is %NULL. Takes effect from the next start on */
+void
+gst_player_set_group_clock (GstPlayer * self, GstClock * clock)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-
-  GST_DEBUG_OBJECT (self, "Latency changed");
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  gst_bin_recalculate_latency (GST_BIN (self->playbin));
+  if (clock) {
+    gst_pipeline_use_clock (GST_PIPELINE (self->playbin), clock);
+    gst_element_set_start_time (self->playbin, GST_CLOCK_TIME_NONE);
+  } else {
+    gst_pipeline_auto_clock (GST_PIPELINE (self->playbin));
+    gst_element_set_start_time (self->playbin, 0);
+  }
 }
 
-static void
-request_state_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+typedef struct
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GstState state;
-  GstStateChangeReturn state_ret;
+  GstPlayer *player;
+  GstClockTime position;
+  gdouble rate;
+  GstClockTime base_time;
+  gboolean play;
+} SyncRequest;
 
-  gst_message_parse_request_state (msg, &state);
+static gboolean
+gst_player_sync_internal (gpointer user_data)
+{
+  SyncRequest *request = user_data;
+  GstPlayer *self = request->player;
 
-  GST_DEBUG_OBJECT (self, "State %s requested",
-      gst_element_state_get_name (state));
+  GST_DEBUG_OBJECT (self, "Sync at %" GST_TIME_FORMAT " with base time %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (request->position),
+      GST_TIME_ARGS (request->base_time));
 
-  self->target_state = state;
-  state_ret = gst_element_set_state (self->playbin, state);
-  if (state_ret == GST_STATE_CHANGE_FAILURE)
-    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-            "Failed to change to requested state %s",
-            gst_element_state_get_name (state)));
+  /* Applied to all elements when going to PLAYING, which also happens
+   * when the pipeline recovers from the flush of the seek */
+  gst_element_set_base_time (self->playbin, request->base_time);
+
+  /* A flushing seek starts the running time from zero again, which is
+   * reached at the base time */
+  g_mutex_lock (&self->lock);
+  self->rate = request->rate;
+  if (GST_CLOCK_TIME_IS_VALID (request->position)) {
+    self->seek_position = request->position;
+    self->seek_flags = GST_SEEK_FLAG_ACCURATE;
+
+    /* Seeks happen in PAUSED and continue to the target state from there
+     * once prerolled */
+    if (self->current_state >= GST_STATE_PAUSED) {
+      self->target_state =
+          request->play ? GST_STATE_PLAYING : GST_STATE_PAUSED;
+      if (!self->seek_pending && !self->seek_source)
+        gst_player_seek_internal_locked (self);
+      g_mutex_unlock (&self->lock);
+      return G_SOURCE_REMOVE;
+    }
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (request->play)
+    gst_player_play_internal (self);
+  else
+    gst_player_pause_internal (self);
+
+  return G_SOURCE_REMOVE;
 }
 
-static void
-media_info_update (GstPlayer * self, GstPlayerMediaInfo * info)
+/* Restarts playback at @position, or where it is if GST_CLOCK_TIME_NONE,
+ * with running time zero at @base_time, for #GstPlayerGroup */
+void
+gst_player_sync (GstPlayer * self, GstClockTime position, gdouble rate,
+    GstClockTime base_time, gboolean play)
 {
-  if (info->title)
-    g_free (info->title);
-  info->title = get_from_tags (self, info, get_title);
+  SyncRequest *request;
 
-  if (info->container)
-    g_free (info->container);
-  info->container = get_from_tags (self, info, get_container_format);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  if (info->image_sample)
-    gst_sample_unref (info->image_sample);
-  info->image_sample = get_from_tags (self, info, get_cover_sample);
+  request = g_new (SyncRequest, 1);
+  request->player = self;
+  request->position = position;
+  request->rate = rate;
+  request->base_time = base_time;
+  request->play = play;
 
-  GST_DEBUG_OBJECT (self, "title: %s, container: %s "
-      "image_sample: %p", info->title, info->container, info->image_sample);
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_sync_internal, request, g_free);
 }
 
 static void
-tags_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+gst_player_seek_with_flags (GstPlayer * self, GstClockTime position,
+    GstSeekFlags flags)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GstTagList *tags = NULL;
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (position));
 
-  gst_message_parse_tag (msg, &tags);
+  g_mutex_lock (&self->lock);
+  if (self->media_info && !self->media_info->seekable) {
+    GST_DEBUG_OBJECT (self, "Media is not seekable");
+    g_mutex_unlock (&self->lock);
+    return;
+  }
 
-  /*
-   * NOTE: Inorder to get global tag you must apply the following patches in
-   * your gstreamer build.
-   *
-   * http://cgit.freedesktop.org/gstreamer/gst-plugins-good/commit/?id=9119fbd774093e3ae762c8652acd80d54b2c3b45
-   * http://cgit.freedesktop.org/gstreamer/gstreamer/commit/?id=18b058100940bdcaed86fa412e3582a02871f995
+  self->seek_position = position;
+  self->seek_flags = flags;
+
+  /* If there is no seek being dispatch to the main context currently do that,
+   * otherwise we just updated the seek position so that it will be taken by
+   * the seek handler from the main context instead of the old one.
    */
-  GST_DEBUG_OBJECT (self, "recieved %s tags",
-      gst_tag_list_get_scope (tags) ==
-      GST_TAG_SCOPE_GLOBAL ? "global" : "stream");
+  if (!self->seek_source) {
+    GstClockTime now = gst_util_get_timestamp ();
 
-  if (gst_tag_list_get_scope (tags) == GST_TAG_SCOPE_GLOBAL) {
-    g_mutex_lock (&self->lock);
-    if (self->media_info) {
-      if (self->media_info->tags)
-        gst_tag_list_unref (self->media_info->tags);
-      self->media_info->tags = gst_tag_list_ref (tags);
-      media_info_update (self, self->media_info);
-      g_mutex_unlock (&self->lock);
-      emit_media_info_updated_signal (self);
+    /* If no seek is pending or it was started more than 250 mseconds ago seek
+     * immediately, otherwise wait until the 250 mseconds have passed */
+    if (!self->seek_pending || (now - self->last_seek_time > 250 * GST_MSECOND)) {
+      self->seek_source = g_idle_source_new ();
+      g_source_set_callback (self->seek_source,
+          (GSourceFunc) gst_player_seek_internal, self, NULL);
+      GST_TRACE_OBJECT (self, "Dispatching seek to position %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (position));
+      g_source_attach (self->seek_source, self->context);
     } else {
-      if (self->global_tags)
-        gst_tag_list_unref (self->global_tags);
-      self->global_tags = gst_tag_list_ref (tags);
-      g_mutex_unlock (&self->lock);
+      guint delay = 250000 - (now - self->last_seek_time) / 1000;
+
+      /* Note that last_seek_time must be set to something at this point and
+       * it must be smaller than 250 mseconds */
+      self->seek_source = g_timeout_source_new (delay);
+      g_source_set_callback (self->seek_source,
+          (GSourceFunc) gst_player_seek_internal, self, NULL);
+
+      GST_TRACE_OBJECT (self,
+          "Delaying seek to position %" GST_TIME_FORMAT " by %u us",
+          GST_TIME_ARGS (position), delay);
+      g_source_attach (self->seek_source, self->context);
     }
   }
+  g_mutex_unlock (&self->lock);
+}
 
-  gst_tag_list_unref (tags);
+/**
+ * gst_player_seek:
+ * @player: #GstPlayer instance
+ * @position: position to seek in nanoseconds
+ *
+ * Seeks the currently-playing stream to the absolute @position time
+ * in nanoseconds.
+ */
+void
+gst_player_seek (GstPlayer * self, GstClockTime position)
+{
+  gst_player_seek_with_flags (self, position, 0);
 }
 
-static void
-element_cb (GstBus * bus, GstMessage * msg, gpointer user_data)
+/* Scrub seeks only decode and show the keyframe nearest to the position */
+#define SCRUB_SEEK_FLAGS (GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST | \
+    GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS | \
+    GST_SEEK_FLAG_TRICKMODE_NO_AUDIO)
+
+static gboolean
+gst_player_scrub_begin_internal (gpointer user_data)
 {
   GstPlayer *self = GST_PLAYER (user_data);
-  const GstStructure *s;
 
-  s = gst_message_get_structure (msg);
-  if (gst_structure_has_name (s, "redirect")) {
-    const gchar *new_location;
+  /* Stay paused while scrubbing, so every seek shows its frame at once */
+  self->scrub_resume = self->target_state == GST_STATE_PLAYING;
+  if (self->scrub_resume)
+    gst_player_pause_internal (self);
 
-    new_location = gst_structure_get_string (s, "new-location");
-    if (!new_location) {
-      const GValue *locations_list, *location_val;
-      guint i, size;
+  return G_SOURCE_REMOVE;
+}
 
-      locations_list = gst_structure_get_value (s, "locations");
-      size = gst_value_list_get_size (locations_list);
-      for (i = 0; i < size; ++i) {
-        const GstStructure *location_s;
+/**
+ * gst_player_scrub_begin:
+ * @player: #GstPlayer instance
+ *
+ * Starts scrubbing, e.g. when the user grabs the seekbar. Playback is
+ * paused until gst_player_scrub_end() is called.
+ */
+void
+gst_player_scrub_begin (GstPlayer * self)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-        location_val = gst_value_list_get_value (locations_list, i);
-        if (!GST_VALUE_HOLDS_STRUCTURE (location_val))
-          continue;
+  g_mutex_lock (&self->lock);
+  self->scrubbing = TRUE;
+  self->scrub_position = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&self->lock);
 
-        location_s = (const GstStructure *) g_value_get_boxed (location_val);
-        if (!gst_structure_has_name (location_s, "redirect"))
-          continue;
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_scrub_begin_internal, self, NULL);
+}
 
-        new_location = gst_structure_get_string (location_s, "new-location");
-        if (new_location)
-          break;
-      }
-    }
+/**
+ * gst_player_scrub_update:
+ * @player: #GstPlayer instance
+ * @position: position to show in nanoseconds
+ *
+ * Shows the keyframe nearest to @position while scrubbing. Only the
+ * keyframe is decoded and audio is skipped, so this is cheap. Updates are
+ * not throttled: while one seek is in progress only the latest position
+ * is kept and seeked to as soon as it finished.
+ *
+ * If not scrubbing, this is the same as gst_player_seek().
+ */
+void
+gst_player_scrub_update (GstPlayer * self, GstClockTime position)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (position));
+
+  g_mutex_lock (&self->lock);
+  if (!self->scrubbing) {
+    g_mutex_unlock (&self->lock);
+    gst_player_seek (self, position);
+    return;
+  }
+
+  if (self->media_info && !self->media_info->seekable) {
+    GST_DEBUG_OBJECT (self, "Media is not seekable");
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  self->scrub_position = position;
+  self->seek_position = position;
+  self->seek_flags = SCRUB_SEEK_FLAGS;
+
+  /* A running seek picks up the new position once it finished */
+  if (!self->seek_source && !self->seek_pending) {
+    self->seek_source = g_idle_source_new ();
+    g_source_set_callback (self->seek_source,
+        (GSourceFunc) gst_player_seek_internal, self, NULL);
+    g_source_attach (self->seek_source, self->context);
+  }
+  g_mutex_unlock (&self->lock);
+}
+
+static gboolean
+gst_player_scrub_end_internal (gpointer user_data)
+{
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstClockTime position;
+
+  g_mutex_lock (&self->lock);
+  position = self->scrub_position;
+  self->scrub_position = GST_CLOCK_TIME_NONE;
+
+  if (self->scrub_resume)
+    self->target_state = GST_STATE_PLAYING;
+
+  if (GST_CLOCK_TIME_IS_VALID (position)) {
+    /* Land exactly where scrubbing stopped, playback resumes from the
+     * state change handler once this seek is done */
+    self->seek_position = position;
+    self->seek_flags = GST_SEEK_FLAG_ACCURATE;
+    if (!self->seek_source && !self->seek_pending)
+      gst_player_seek_internal_locked (self);
+    g_mutex_unlock (&self->lock);
+  } else {
+    g_mutex_unlock (&self->lock);
+    if (self->scrub_resume)
+      gst_player_play_internal (self);
+  }
+  self->scrub_resume = FALSE;
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gst_player_scrub_end:
+ * @player: #GstPlayer instance
+ *
+ * Stops scrubbing with an accurate seek to the last position passed to
+ * gst_player_scrub_update(), and resumes playback if it was playing
+ * before gst_player_scrub_begin().
+ */
+void
+gst_player_scrub_end (GstPlayer * self)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_mutex_lock (&self->lock);
+  self->scrubbing = FALSE;
+  g_mutex_unlock (&self->lock);
 
-    if (new_location) {
-      GstState target_state;
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_scrub_end_internal, self, NULL);
+}
 
-      GST_DEBUG_OBJECT (self, "Redirect to '%s'", new_location);
+/* Chapter seeks snap to the next keyframe so that the new position is
+ * always inside the target chapter */
+#define CHAPTER_SEEK_FLAGS (GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_AFTER)
 
-      /* Remember target state and restore after setting the URI */
-      target_state = self->target_state;
+/* Seeking to the previous chapter restarts the current one instead if it
+ * is playing for longer than this already */
+#define PREVIOUS_CHAPTER_THRESHOLD (3 * GST_SECOND)
 
-      g_mutex_lock (&self->lock);
-      if (self->uri)
-        g_free (self->uri);
+/* Must be called with lock held */
+static gboolean
+seek_chapter_locked (GstPlayer * self, gint index)
+{
+  GstClockTime start;
 
-      self->uri = g_strdup (new_location);
-      g_mutex_unlock (&self->lock);
+  if (index < 0 || !self->media_info
+      || !gst_player_media_info_get_chapter (self->media_info, index, &start,
+          NULL, NULL))
+    return FALSE;
 
-      gst_player_set_uri_internal (self);
+  GST_DEBUG_OBJECT (self, "Seeking to chapter %d at %" GST_TIME_FORMAT, index,
+      GST_TIME_ARGS (start));
 
-      if (target_state == GST_STATE_PAUSED)
-        gst_player_pause_internal (self);
-      else if (target_state == GST_STATE_PLAYING)
-        gst_player_play_internal (self);
-    }
-  }
+  g_mutex_unlock (&self->lock);
+  gst_player_seek_with_flags (self, start, CHAPTER_SEEK_FLAGS);
+  g_mutex_lock (&self->lock);
+
+  return TRUE;
 }
 
-static void
-player_set_flag (GstPlayer * self, gint pos)
+/* Chapter navigation is relative to a pending seek if there is one, so
+ * that repeated chapter seeks advance further */
+static GstClockTime
+get_chapter_position (GstPlayer * self)
 {
-  gint flags;
+  GstClockTime position;
 
-  g_object_get (self->playbin, "flags", &flags, NULL);
-  flags |= pos;
-  g_object_set (self->playbin, "flags", flags, NULL);
+  g_mutex_lock (&self->lock);
+  position = self->seek_position;
+  g_mutex_unlock (&self->lock);
 
-  GST_DEBUG_OBJECT (self, "setting flags=%#x", flags);
+  if (!GST_CLOCK_TIME_IS_VALID (position))
+    position = gst_player_get_position (self);
+  if (!GST_CLOCK_TIME_IS_VALID (position))
+    position = 0;
+
+  return position;
 }
 
-static void
-player_clear_flag (GstPlayer * self, gint pos)
+/* Number of chapters starting at or before position */
+static guint
+count_chapters_started (GstPlayerMediaInfo * info, GstClockTime position)
 {
-  gint flags;
+  guint lo = 0, hi = info->chapters->len;
 
-  g_object_get (self->playbin, "flags", &flags, NULL);
-  flags &= ~pos;
-  g_object_set (self->playbin, "flags", flags, NULL);
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
 
-  GST_DEBUG_OBJECT (self, "setting flags=%#x", flags);
+    if (g_array_index (info->chapters, GstPlayerChapter, mid).start <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
 }
 
-typedef struct
+/**
+ * gst_player_seek_chapter:
+ * @player: #GstPlayer instance
+ * @index: index of the chapter in the #GstPlayerMediaInfo
+ *
+ * Seeks to the start of the chapter @index. This uses a key unit seek, so
+ * playback starts at the first keyframe inside the chapter.
+ *
+ * Returns: %TRUE if the chapter exists and the seek was started.
+ */
+gboolean
+gst_player_seek_chapter (GstPlayer * self, guint index)
 {
-  GstPlayer *player;
-  GstPlayerMediaInfo *info;
-} MediaInfoUpdatedSignalData;
+  gboolean ret;
 
-static gboolean
-media_info_updated_dispatch (gpointer user_data)
-{
-  MediaInfoUpdatedSignalData *data = user_data;
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  if (data->player->target_state >= GST_STATE_PAUSED) {
-    g_signal_emit (data->player, signals[SIGNAL_MEDIA_INFO_UPDATED], 0,
-        data->info);
-  }
+  g_mutex_lock (&self->lock);
+  ret = index <= G_MAXINT && seek_chapter_locked (self, index);
+  g_mutex_unlock (&self->lock);
 
-  return FALSE;
+  return ret;
 }
 
-static void
-free_media_info_updated_signal_data (MediaInfoUpdatedSignalData * data)
+/**
+ * gst_player_seek_next_chapter:
+ * @player: #GstPlayer instance
+ *
+ * Seeks to the start of the first chapter after the current position.
+ *
+ * Returns: %TRUE if there is such a chapter and the seek was started.
+ */
+gboolean
+gst_player_seek_next_chapter (GstPlayer * self)
 {
-  g_object_unref (data->player);
-  g_object_unref (data->info);
-  g_free (data);
+  GstClockTime position;
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
+
+  position = get_chapter_position (self);
+
+  g_mutex_lock (&self->lock);
+  if (self->media_info)
+    ret = seek_chapter_locked (self,
+        count_chapters_started (self->media_info, position));
+  g_mutex_unlock (&self->lock);
+
+  return ret;
 }
 
-/*
- * emit_media_info_updated_signal:
+/**
+ * gst_player_seek_previous_chapter:
+ * @player: #GstPlayer instance
  *
- * create a new copy of self->media_info object and emits the newly created
- * copy to user application. The newly created media_info will be unref'ed
- * as part of signal finalize method.
+ * Seeks to the start of the current chapter, or to the start of the
+ * previous chapter if the current one started less than 3 seconds ago.
+ *
+ * Returns: %TRUE if there is such a chapter and the seek was started.
  */
-static void
-emit_media_info_updated_signal (GstPlayer * self)
+gboolean
+gst_player_seek_previous_chapter (GstPlayer * self)
 {
-  if (self->dispatch_to_main_context) {
-    MediaInfoUpdatedSignalData *data = g_new (MediaInfoUpdatedSignalData, 1);
-    data->player = g_object_ref (self);
-    g_mutex_lock (&self->lock);
-    data->info = gst_player_media_info_copy (self->media_info);
-    g_mutex_unlock (&self->lock);
+  GstClockTime position;
+  gboolean ret = FALSE;
+  gint current;
 
-    g_main_context_invoke_full (self->application_context,
-        G_PRIORITY_DEFAULT, media_info_updated_dispatch,
-        data, (GDestroyNotify) free_media_info_updated_signal_data);
-  } else {
-    GstPlayerMediaInfo *info;
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-    g_mutex_lock (&self->lock);
-    info = gst_player_media_info_copy (self->media_info);
-    g_mutex_unlock (&self->lock);
+  position = get_chapter_position (self);
 
-    g_signal_emit (self, signals[SIGNAL_MEDIA_INFO_UPDATED], 0, info);
-    g_object_unref (info);
+  g_mutex_lock (&self->lock);
+  if (self->media_info) {
+    current = (gint) count_chapters_started (self->media_info, position) - 1;
+    if (current > 0 && position - g_array_index (self->media_info->chapters,
+            GstPlayerChapter, current).start < PREVIOUS_CHAPTER_THRESHOLD)
+      current--;
+    ret = seek_chapter_locked (self, current);
   }
+  g_mutex_unlock (&self->lock);
+
+  return ret;
 }
 
-static GstCaps *
-get_caps (GstPlayer * self, gint stream_index, GType type)
+/**
+ * gst_player_get_dispatch_to_main_context:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if the callbacks are dispatched in the thread's
+ * default main context. Otherwise, %FALSE.
+ */
+gboolean
+gst_player_get_dispatch_to_main_context (GstPlayer * self)
 {
-  GstPad *pad = NULL;
-  GstCaps *caps = NULL;
+  gboolean val;
 
-  if (type == GST_TYPE_PLAYER_VIDEO_INFO)
-    g_signal_emit_by_name (G_OBJECT (self->playbin),
-        "get-video-pad", stream_index, &pad);
-  else if (type == GST_TYPE_PLAYER_AUDIO_INFO)
-    g_signal_emit_by_name (G_OBJECT (self->playbin),
-        "get-audio-pad", stream_index, &pad);
-  else
-    g_signal_emit_by_name (G_OBJECT (self->playbin),
-        "get-text-pad", stream_index, &pad);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  if (pad) {
-    caps = gst_pad_get_current_caps (pad);
-    gst_object_unref (pad);
-  }
+  g_object_get (self, "dispatch-to-main-context", &val, NULL);
 
-  return caps;
+  return val;
 }
 
-static void
-gst_player_subtitle_info_update (GstPlayer * self,
-    GstPlayerStreamInfo * stream_info)
+/**
+ * gst_player_set_dispatch_to_main_context:
+ * @player: #GstPlayer instance
+ * @val: whether the callbacks are dispatched in the thread's default
+ * main context
+ *
+ * Sets whether the callbacks are dispatched in the thread's default
+ * main context.
+ */
+void
+gst_player_set_dispatch_to_main_context (GstPlayer * self, gboolean val)
 {
-  GstPlayerSubtitleInfo *info = (GstPlayerSubtitleInfo *) stream_info;
-
-  if (stream_info->tags) {
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-    /* free the old language info */
-    if (info->language) {
-      g_free (info->language);
-      info->language = NULL;
-    }
+  g_object_set (self, "dispatch-to-main-context", val, NULL);
+}
 
-    /* First try to get the language full name from tag, if name is not
-     * available then try language code. If we find the language code
-     * then use gstreamer api to translate code to full name.
-     */
-    gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_NAME,
-        &info->language);
-    if (!info->language) {
-      gchar *lang_code = NULL;
+/**
+ * gst_player_get_uri:
+ * @player: #GstPlayer instance
+ *
+ * Gets the URI of the currently-playing stream.
+ *
+ * Returns: (transfer full): a string containing the URI of the
+ * currently-playing stream. g_free() after usage.
+ */
+gchar *
+gst_player_get_uri (GstPlayer * self)
+{
+  gchar *val;
 
-      gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_CODE,
-          &lang_code);
-      if (lang_code) {
-        info->language = g_strdup (gst_tag_get_language_name (lang_code));
-        g_free (lang_code);
-      }
-    }
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-    /* If we are still failed to find language name then check if external
-     * subtitle is loaded and compare the stream index between current sub
-     * stream index with our stream index and if matches then declare it as
-     * external subtitle and use the filename.
-     */
-    if (!info->language) {
-      gint text_index = -1;
-      gchar *suburi = NULL;
+  g_object_get (self, "uri", &val, NULL);
 
-      g_object_get (G_OBJECT (self->playbin), "current-suburi", &suburi, NULL);
-      if (suburi) {
-        g_object_get (G_OBJECT (self->playbin), "current-text", &text_index,
-            NULL);
-        if (text_index == gst_player_stream_info_get_index (stream_info))
-          info->language = g_path_get_basename (suburi);
-        g_free (suburi);
-      }
-    }
+  return val;
+}
 
-  } else {
-    if (info->language) {
-      g_free (info->language);
-      info->language = NULL;
-    }
-  }
+/**
+ * gst_player_set_uri:
+ * @player: #GstPlayer instance
+ * @uri: next URI to play.
+ *
+ * Sets the next URI to play.
+ */
+void
+gst_player_set_uri (GstPlayer * self, const gchar * val)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  GST_DEBUG_OBJECT (self, "language=%s", info->language);
+  g_object_set (self, "uri", val, NULL);
 }
 
-static void
-gst_player_video_info_update (GstPlayer * self,
-    GstPlayerStreamInfo * stream_info)
+/**
+ * gst_player_get_position:
+ * @player: #GstPlayer instance
+ *
+ * Returns: the absolute position time, in nanoseconds, of the
+ * currently-playing stream.
+ */
+GstClockTime
+gst_player_get_position (GstPlayer * self)
 {
-  GstPlayerVideoInfo *info = (GstPlayerVideoInfo *) stream_info;
+  GstClockTime val;
 
-  if (stream_info->caps) {
-    GstStructure *s;
+  g_return_val_if_fail (GST_IS_PLAYER (self), GST_CLOCK_TIME_NONE);
 
-    s = gst_caps_get_structure (stream_info->caps, 0);
-    if (s) {
-      gint width, height;
-      gint fps_n, fps_d;
-      gint par_n, par_d;
+  g_object_get (self, "position", &val, NULL);
 
-      if (gst_structure_get_int (s, "width", &width))
-        info->width = width;
-      else
-        info->width = -1;
+  return val;
+}
 
-      if (gst_structure_get_int (s, "height", &height))
-        info->height = height;
-      else
-        info->height = -1;
+/**
+ * gst_player_get_duration:
+ * @player: #GstPlayer instance
+ *
+ * Retrieves the duration of the media stream that self represents.
+ *
+ * Returns: the duration of the currently-playing media stream, in
+ * nanoseconds.
+ */
+GstClockTime
+gst_player_get_duration (GstPlayer * self)
+{
+  GstClockTime val;
 
-      if (gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d)) {
-        info->framerate_num = fps_n;
-        info->framerate_denom = fps_d;
-      } else {
-        info->framerate_num = 0;
-        info->framerate_denom = 1;
-      }
+  g_return_val_if_fail (GST_IS_PLAYER (self), GST_CLOCK_TIME_NONE);
 
+  g_object_get (self, "duration", &val, NULL);
 
-      if (gst_structure_get_fraction (s, "pixel-aspect-ratio", &par_n, &par_d)) {
-        info->par_num = par_n;
-        info->par_denom = par_d;
-      } else {
-        info->par_num = 1;
-        info->par_denom = 1;
-      }
-    }
-  } else {
-    info->width = info->height = -1;
-    info->par_num = info->par_denom = 1;
-    info->framerate_num = 0;
-    info->framerate_denom = 1;
-  }
+  return val;
+}
 
-  if (stream_info->tags) {
-    guint bitrate, max_bitrate;
+/**
+ * gst_player_get_volume:
+ * @player: #GstPlayer instance
+ *
+ * Returns the current volume level, as a percentage between 0 and 1.
+ *
+ * Returns: the volume as percentage between 0 and 1.
+ */
+gdouble
+gst_player_get_volume (GstPlayer * self)
+{
+  gdouble val;
 
-    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_BITRATE, &bitrate))
-      info->bitrate = bitrate;
-    else
-      info->bitrate = -1;
+  g_return_val_if_fail (GST_IS_PLAYER (self), 1.0);
 
-    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_MAXIMUM_BITRATE,
-            &max_bitrate) || gst_tag_list_get_uint (stream_info->tags,
-            GST_TAG_NOMINAL_BITRATE, &max_bitrate))
-      info->max_bitrate = max_bitrate;
-    else
-      info->max_bitrate = -1;
-  } else {
-    info->bitrate = info->max_bitrate = -1;
-  }
+  g_object_get (self, "volume", &val, NULL);
 
-  GST_DEBUG_OBJECT (self, "width=%d height=%d fps=%.2f par=%d:%d "
-      "bitrate=%d max_bitrate=%d", info->width, info->height,
-      (gdouble) info->framerate_num / info->framerate_denom,
-      info->par_num, info->par_denom, info->bitrate, info->max_bitrate);
+  return val;
 }
 
-static void
-gst_player_audio_info_update (GstPlayer * self,
-    GstPlayerStreamInfo * stream_info)
+/**
+ * gst_player_set_volume:
+ * @player: #GstPlayer instance
+ * @val: the new volume level, as a percentage between 0 and 1
+ *
+ * Sets the volume level of the stream as a percentage between 0 and 1.
+ */
+void
+gst_player_set_volume (GstPlayer * self, gdouble val)
 {
-  GstPlayerAudioInfo *info = (GstPlayerAudioInfo *) stream_info;
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  if (stream_info->caps) {
-    GstStructure *s;
+  g_object_set (self, "volume", val, NULL);
+}
 
-    s = gst_caps_get_structure (stream_info->caps, 0);
-    if (s) {
-      gint rate, channels;
+/**
+ * gst_player_get_mute:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if the currently-playing stream is muted.
+ */
+gboolean
+gst_player_get_mute (GstPlayer * self)
+{
+  gboolean val;
 
-      if (gst_structure_get_int (s, "rate", &rate))
-        info->sample_rate = rate;
-      else
-        info->sample_rate = -1;
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-      if (gst_structure_get_int (s, "channels", &channels))
-        info->channels = channels;
-      else
-        info->channels = 0;
-    }
-  } else {
-    info->sample_rate = -1;
-    info->channels = 0;
-  }
+  g_object_get (self, "mute", &val, NULL);
 
-  if (stream_info->tags) {
-    guint bitrate, max_bitrate;
+  return val;
+}
 
-    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_BITRATE, &bitrate))
-      info->bitrate = bitrate;
-    else
-      info->bitrate = -1;
+/**
+ * gst_player_set_mute:
+ * @player: #GstPlayer instance
+ * @val: Mute state the should be set
+ *
+ * %TRUE if the currently-playing stream should be muted.
+ */
+void
+gst_player_set_mute (GstPlayer * self, gboolean val)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-    if (gst_tag_list_get_uint (stream_info->tags, GST_TAG_MAXIMUM_BITRATE,
-            &max_bitrate) || gst_tag_list_get_uint (stream_info->tags,
-            GST_TAG_NOMINAL_BITRATE, &max_bitrate))
-      info->max_bitrate = max_bitrate;
-    else
-      info->max_bitrate = -1;
+  g_object_set (self, "mute", val, NULL);
+}
 
-    /* if we have old language the free it */
-    if (info->language) {
-      g_free (info->language);
-      info->language = NULL;
-    }
+/**
+ * gst_player_get_window_handle:
+ * @player: #GstPlayer instance
+ *
+ * Returns: (transfer none): The currently set, platform specific window
+ * handle
+ */
+gpointer
+gst_player_get_window_handle (GstPlayer * self)
+{
+  gpointer val;
 
-    /* First try to get the language full name from tag, if name is not
-     * available then try language code. If we find the language code
-     * then use gstreamer api to translate code to full name.
-     */
-    gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_NAME,
-        &info->language);
-    if (!info->language) {
-      gchar *lang_code = NULL;
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-      gst_tag_list_get_string (stream_info->tags, GST_TAG_LANGUAGE_CODE,
-          &lang_code);
-      if (lang_code) {
-        info->language = g_strdup (gst_tag_get_language_name (lang_code));
-        g_free (lang_code);
-      }
-    }
-  } else {
-    if (info->language) {
-      g_free (info->language);
-      info->language = NULL;
-    }
-    info->max_bitrate = info->bitrate = -1;
-  }
+  g_object_get (self, "window-handle", &val, NULL);
 
-  GST_DEBUG_OBJECT (self, "language=%s rate=%d channels=%d bitrate=%d "
-      "max_bitrate=%d", info->language, info->sample_rate, info->channels,
-      info->bitrate, info->bitrate);
+  return val;
 }
 
-static GstPlayerStreamInfo *
-gst_player_stream_info_find (GstPlayer * self, GstPlayerMediaInfo * media_info,
-    GType type, gint stream_index)
+/**
+ * gst_player_set_window_handle:
+ * @player: #GstPlayer instance
+ * @val: handle referencing to the platform specific window
+ *
+ * Sets the platform specific window handle into which the video
+ * should be rendered
+ **/
+void
+gst_player_set_window_handle (GstPlayer * self, gpointer val)
 {
-  GList *list, *l;
-  GstPlayerStreamInfo *info = NULL;
-
-  if (!media_info)
-    return NULL;
-
-  list = gst_player_media_info_get_stream_list (media_info);
-  for (l = list; l != NULL; l = l->next) {
-    info = (GstPlayerStreamInfo *) l->data;
-    if ((G_OBJECT_TYPE (info) == type) && (info->stream_index == stream_index)) {
-      return info;
-    }
-  }
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  return NULL;
+  g_object_set (self, "window-handle", val, NULL);
 }
 
-static gboolean
-is_track_enabled (GstPlayer * self, gint pos)
+/**
+ * gst_player_get_pipeline:
+ * @player: #GstPlayer instance
+ *
+ * Returns: (transfer full): The internal playbin instance
+ */
+GstElement *
+gst_player_get_pipeline (GstPlayer * self)
 {
-  gint flags;
+  GstElement *val;
 
-  g_object_get (G_OBJECT (self->playbin), "flags", &flags, NULL);
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if ((flags & pos))
-    return TRUE;
+  g_object_get (self, "pipeline", &val, NULL);
 
-  return FALSE;
+  return val;
 }
 
-static GstPlayerStreamInfo *
-gst_player_stream_info_get_current (GstPlayer * self, const gchar * prop,
-    GType type)
+/**
+ * gst_player_get_media_info:
+ * @player: #GstPlayer instance
+ *
+ * A Function to get the current media info #GstPlayerMediaInfo instance.
+ *
+ * Returns: (transfer full): media info instance.
+ *
+ * The caller should free it with g_object_unref()
+ */
+GstPlayerMediaInfo *
+gst_player_get_media_info (GstPlayer * self)
 {
-  gint current;
-  GstPlayerStreamInfo *info;
+  GstPlayerMediaInfo *info;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
   if (!self->media_info)
     return NULL;
 
-  g_object_get (G_OBJECT (self->playbin), prop, &current, NULL);
   g_mutex_lock (&self->lock);
-  info = gst_player_stream_info_find (self, self->media_info, type, current);
-  if (info)
-    info = gst_player_stream_info_copy (info);
+  info = gst_player_media_info_copy (self->media_info);
   g_mutex_unlock (&self->lock);
 
   return info;
 }
 
-static void
-gst_player_stream_info_update (GstPlayer * self, GstPlayerStreamInfo * s)
-{
-  if (GST_IS_PLAYER_VIDEO_INFO (s))
-    gst_player_video_info_update (self, s);
-  else if (GST_IS_PLAYER_AUDIO_INFO (s))
-    gst_player_audio_info_update (self, s);
-  else
-    gst_player_subtitle_info_update (self, s);
-}
-
-static gchar *
-stream_info_get_codec (GstPlayerStreamInfo * s)
+/**
+ * gst_player_get_current_audio_track:
+ * @player: #GstPlayer instance
+ *
+ * A Function to get current audio #GstPlayerAudioInfo instance.
+ *
+ * Returns: (transfer full): current audio track.
+ *
+ * The caller should free it with g_object_unref()
+ */
+GstPlayerAudioInfo *
+gst_player_get_current_audio_track (GstPlayer * self)
 {
-  const gchar *type;
-  GstTagList *tags;
-  gchar *codec = NULL;
-
-  if (GST_IS_PLAYER_VIDEO_INFO (s))
-    type = GST_TAG_VIDEO_CODEC;
-  else if (GST_IS_PLAYER_AUDIO_INFO (s))
-    type = GST_TAG_AUDIO_CODEC;
-  else
-    type = GST_TAG_SUBTITLE_CODEC;
+  GstPlayerAudioInfo *info;
 
-  tags = gst_player_stream_info_get_tags (s);
-  if (tags) {
-    gst_tag_list_get_string (tags, type, &codec);
-    if (!codec)
-      gst_tag_list_get_string (tags, GST_TAG_CODEC, &codec);
-  }
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if (!codec) {
-    GstCaps *caps;
-    caps = gst_player_stream_info_get_caps (s);
-    if (caps) {
-      codec = gst_pb_utils_get_codec_description (caps);
-    }
-  }
+  if (!is_track_enabled (self, GST_PLAY_FLAG_AUDIO))
+    return NULL;
 
-  return codec;
+  info = (GstPlayerAudioInfo *) gst_player_stream_info_get_current (self,
+      "current-audio", GST_TYPE_PLAYER_AUDIO_INFO);
+  return info;
 }
 
-static void
-gst_player_stream_info_update_tags_and_caps (GstPlayer * self,
-    GstPlayerStreamInfo * s)
+/**
+ * gst_player_get_current_video_track:
+ * @player: #GstPlayer instance
+ *
+ * A Function to get current video #GstPlayerVideoInfo instance.
+ *
+ * Returns: (transfer full): current video track.
+ *
+ * The caller should free it with g_object_unref()
+ */
+GstPlayerVideoInfo *
+gst_player_get_current_video_track (GstPlayer * self)
 {
-  GstTagList *tags;
-  gint stream_index;
-
-  stream_index = gst_player_stream_info_get_index (s);
-
-  if (GST_IS_PLAYER_VIDEO_INFO (s))
-    g_signal_emit_by_name (self->playbin, "get-video-tags",
-        stream_index, &tags);
-  else if (GST_IS_PLAYER_AUDIO_INFO (s))
-    g_signal_emit_by_name (self->playbin, "get-audio-tags",
-        stream_index, &tags);
-  else
-    g_signal_emit_by_name (self->playbin, "get-text-tags", stream_index, &tags);
-
-  if (s->tags)
-    gst_tag_list_unref (s->tags);
-  s->tags = tags;
-
-  if (s->caps)
-    gst_caps_unref (s->caps);
-  s->caps = get_caps (self, stream_index, G_OBJECT_TYPE (s));
+  GstPlayerVideoInfo *info;
 
-  if (s->codec)
-    g_free (s->codec);
-  s->codec = stream_info_get_codec (s);
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  GST_DEBUG_OBJECT (self, "%s index: %d tags: %p caps: %p",
-      gst_player_stream_info_get_stream_type (s), stream_index,
-      s->tags, s->caps);
+  if (!is_track_enabled (self, GST_PLAY_FLAG_VIDEO))
+    return NULL;
 
-  gst_player_stream_info_update (self, s);
+  info = (GstPlayerVideoInfo *) gst_player_stream_info_get_current (self,
+      "current-video", GST_TYPE_PLAYER_VIDEO_INFO);
+  return info;
 }
 
-static void
-gst_player_streams_info_create (GstPlayer * self,
-    GstPlayerMediaInfo * media_info, const gchar * prop, GType type)
+/**
+ * gst_player_get_current_subtitle_track:
+ * @player: #GstPlayer instance
+ *
+ * A Function to get current subtitle #GstPlayerSubtitleInfo instance.
+ *
+ * Returns: (transfer none): current subtitle track.
+ *
+ * The caller should free it with g_object_unref()
+ */
+GstPlayerSubtitleInfo *
+gst_player_get_current_subtitle_track (GstPlayer * self)
 {
-  gint i;
-  gint total = -1;
-  GstPlayerStreamInfo *s;
-
-  if (!media_info)
-    return;
-
-  g_object_get (G_OBJECT (self->playbin), prop, &total, NULL);
-
-  GST_DEBUG_OBJECT (self, "%s: %d", prop, total);
-
-  for (i = 0; i < total; i++) {
-    /* check if stream already exist in the list */
-    s = gst_player_stream_info_find (self, media_info, type, i);
-
-    if (!s) {
-      /* create a new stream info instance */
-      s = gst_player_stream_info_new (i, type);
-
-      /* add the object in stream list */
-      media_info->stream_list = g_list_append (media_info->stream_list, s);
-
-      /* based on type, add the object in its corresponding stream_ list */
-      if (GST_IS_PLAYER_AUDIO_INFO (s))
-        media_info->audio_stream_list = g_list_append
-            (media_info->audio_stream_list, s);
-      else if (GST_IS_PLAYER_VIDEO_INFO (s))
-        media_info->video_stream_list = g_list_append
-            (media_info->video_stream_list, s);
-      else
-        media_info->subtitle_stream_list = g_list_append
-            (media_info->subtitle_stream_list, s);
-
-      GST_DEBUG_OBJECT (self, "create %s stream stream_index: %d",
-          gst_player_stream_info_get_stream_type (s), i);
-    }
+  GstPlayerSubtitleInfo *info;
 
-    gst_player_stream_info_update_tags_and_caps (self, s);
-  }
-}
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-static void
-video_changed_cb (GObject * object, gpointer user_data)
-{
-  GstPlayer *self = GST_PLAYER (user_data);
+  if (!is_track_enabled (self, GST_PLAY_FLAG_SUBTITLE))
+    return NULL;
 
-  g_mutex_lock (&self->lock);
-  gst_player_streams_info_create (self, self->media_info,
-      "n-video", GST_TYPE_PLAYER_VIDEO_INFO);
-  g_mutex_unlock (&self->lock);
+  info = (GstPlayerSubtitleInfo *) gst_player_stream_info_get_current (self,
+      "current-text", GST_TYPE_PLAYER_SUBTITLE_INFO);
+  return info;
 }
 
-static void
-audio_changed_cb (GObject * object, gpointer user_data)
+/**
+ * gst_player_set_audio_track:
+ * @player: #GstPlayer instance
+ * @stream_index: stream index
+ *
+ * Returns: %TRUE or %FALSE
+ *
+ * Sets the audio track @stream_idex.
+ */
+gboolean
+gst_player_set_audio_track (GstPlayer * self, gint stream_index)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
+  GstPlayerStreamInfo *info;
+  GstClockTime start;
 
-  g_mutex_lock (&self->lock);
-  gst_player_streams_info_create (self, self->media_info,
-      "n-audio", GST_TYPE_PLAYER_AUDIO_INFO);
-  g_mutex_unlock (&self->lock);
-}
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
 
-static void
-subtitle_changed_cb (GObject * object, gpointer user_data)
-{
-  GstPlayer *self = GST_PLAYER (user_data);
+  start = gst_util_get_timestamp ();
 
   g_mutex_lock (&self->lock);
-  gst_player_streams_info_create (self, self->media_info,
-      "n-text", GST_TYPE_PLAYER_SUBTITLE_INFO);
+  info = gst_player_stream_info_find (self, self->media_info,
+      GST_TYPE_PLAYER_AUDIO_INFO, stream_index);
   g_mutex_unlock (&self->lock);
-}
-
-static void *
-get_title (GstTagList * tags)
-{
-  gchar *title = NULL;
-
-  gst_tag_list_get_string (tags, GST_TAG_TITLE, &title);
-  if (!title)
-    gst_tag_list_get_string (tags, GST_TAG_TITLE_SORTNAME, &title);
+  if (!info) {
+    GST_ERROR_OBJECT (self, "invalid audio stream index %d", stream_index);
+    return FALSE;
+  }
 
-  return title;
+  watch_track_switch (self, GST_TYPE_PLAYER_AUDIO_INFO, stream_index, start);
+  g_object_set (G_OBJECT (self->playbin), "current-audio", stream_index, NULL);
+  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
+  return TRUE;
 }
 
-static void *
-get_container_format (GstTagList * tags)
+/**
+ * gst_player_set_video_track:
+ * @player: #GstPlayer instance
+ * @stream_index: stream index
+ *
+ * Returns: %TRUE or %FALSE
+ *
+ * Sets the video track @stream_index.
+ */
+gboolean
+gst_player_set_video_track (GstPlayer * self, gint stream_index)
 {
-  gchar *container = NULL;
+  GstPlayerStreamInfo *info;
 
-  gst_tag_list_get_string (tags, GST_TAG_CONTAINER_FORMAT, &container);
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
 
-  /* TODO: If container is not available then maybe consider
-   * parsing caps or file extension to guess the container format.
-   */
+  /* check if stream_index exist in our internal media_info list */
+  g_mutex_lock (&self->lock);
+  info = gst_player_stream_info_find (self, self->media_info,
+      GST_TYPE_PLAYER_VIDEO_INFO, stream_index);
+  g_mutex_unlock (&self->lock);
+  if (!info) {
+    GST_ERROR_OBJECT (self, "invalid video stream index %d", stream_index);
+    return FALSE;
+  }
 
-  return container;
+  g_object_set (G_OBJECT (self->playbin), "current-video", stream_index, NULL);
+  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
+  return TRUE;
 }
 
-static void *
-get_from_tags (GstPlayer * self, GstPlayerMediaInfo * media_info,
-    void *(*func) (GstTagList *))
+/**
+ * gst_player_set_subtitle_track:
+ * @player: #GstPlayer instance
+ * @stream_index: stream index
+ *
+ * Returns: %TRUE or %FALSE
+ *
+ * Sets the subtitle strack @stream_index.
+ */
+gboolean
+gst_player_set_subtitle_track (GstPlayer * self, gint stream_index)
 {
-  GList *l;
-  void *ret = NULL;
+  GstPlayerStreamInfo *info;
+  GstClockTime start;
 
-  if (media_info->tags) {
-    ret = func (media_info->tags);
-    if (ret)
-      return ret;
-  }
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
 
-  /* if global tag does not exit then try video and audio streams */
-  GST_DEBUG_OBJECT (self, "trying video tags");
-  for (l = gst_player_get_video_streams (media_info); l != NULL; l = l->next) {
-    GstTagList *tags;
+  start = gst_util_get_timestamp ();
 
-    tags = gst_player_stream_info_get_tags ((GstPlayerStreamInfo *) l->data);
-    if (tags)
-      ret = func (tags);
+  g_mutex_lock (&self->lock);
+  info = gst_player_stream_info_find (self, self->media_info,
+      GST_TYPE_PLAYER_SUBTITLE_INFO, stream_index);
+  if (info && stream_index == self->injected_sub_index) {
+    GstElement *selector = NULL;
+    GstPad *pad;
+
+    /* playbin doesn't know about the hot-added subtitle stream. Without a
+     * selector it is the only text stream and already shown */
+    pad = gst_object_ref (self->injected_sub_pad);
+    if (!self->injected_sub_overlay)
+      selector = gst_pad_get_parent_element (pad);
+    g_mutex_unlock (&self->lock);
 
-    if (ret)
-      return ret;
+    if (selector) {
+      g_object_set (selector, "active-pad", pad, NULL);
+      gst_object_unref (selector);
+    }
+    gst_object_unref (pad);
+    GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
+    return TRUE;
   }
-
-  GST_DEBUG_OBJECT (self, "trying audio tags");
-  for (l = gst_player_get_audio_streams (media_info); l != NULL; l = l->next) {
-    GstTagList *tags;
-
-    tags = gst_player_stream_info_get_tags ((GstPlayerStreamInfo *) l->data);
-    if (tags)
-      ret = func (tags);
-
-    if (ret)
-      return ret;
+  g_mutex_unlock (&self->lock);
+  if (!info) {
+    GST_ERROR_OBJECT (self, "invalid subtitle stream index %d", stream_index);
+    return FALSE;
   }
 
-  GST_DEBUG_OBJECT (self, "failed to get the information from tags");
-  return NULL;
+  watch_track_switch (self, GST_TYPE_PLAYER_SUBTITLE_INFO, stream_index,
+      start);
+  g_object_set (G_OBJECT (self->playbin), "current-text", stream_index, NULL);
+  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
+  return TRUE;
 }
 
-static void *
-get_cover_sample (GstTagList * tags)
+/**
+ * gst_player_set_audio_track_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
+ *
+ * Enable or disable the current audio track.
+ */
+void
+gst_player_set_audio_track_enabled (GstPlayer * self, gboolean enabled)
 {
-  GstSample *cover_sample = NULL;
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  gst_tag_list_get_sample (tags, GST_TAG_IMAGE, &cover_sample);
-  if (!cover_sample)
-    gst_tag_list_get_sample (tags, GST_TAG_PREVIEW_IMAGE, &cover_sample);
+  if (enabled)
+    player_set_flag (self, GST_PLAY_FLAG_AUDIO);
+  else
+    player_clear_flag (self, GST_PLAY_FLAG_AUDIO);
 
-  return cover_sample;
+  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
 }
 
-static GstPlayerMediaInfo *
-gst_player_media_info_create (GstPlayer * self)
+/**
+ * gst_player_set_video_track_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
+ *
+ * Enable or disable the current video track.
+ */
+void
+gst_player_set_video_track_enabled (GstPlayer * self, gboolean enabled)
 {
-  GstPlayerMediaInfo *media_info;
-  GstQuery *query;
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  GST_DEBUG_OBJECT (self, "begin");
-  media_info = gst_player_media_info_new (self->uri);
-  media_info->duration = gst_player_get_duration (self);
-  media_info->tags = self->global_tags;
-  self->global_tags = NULL;
+  if (enabled)
+    player_set_flag (self, GST_PLAY_FLAG_VIDEO);
+  else
+    player_clear_flag (self, GST_PLAY_FLAG_VIDEO);
 
-  query = gst_query_new_seeking (GST_FORMAT_TIME);
-  if (gst_element_query (self->playbin, query))
-    gst_query_parse_seeking (query, NULL, &media_info->seekable, NULL, NULL);
-  gst_query_unref (query);
+  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
+}
 
-  /* create audio/video/sub streams */
-  gst_player_streams_info_create (self, media_info, "n-video",
-      GST_TYPE_PLAYER_VIDEO_INFO);
-  gst_player_streams_info_create (self, media_info, "n-audio",
-      GST_TYPE_PLAYER_AUDIO_INFO);
-  gst_player_streams_info_create (self, media_info, "n-text",
-      GST_TYPE_PLAYER_SUBTITLE_INFO);
+/**
+ * gst_player_set_subtitle_track_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
+ *
+ * Enable or disable the current subtitle track.
+ */
+void
+gst_player_set_subtitle_track_enabled (GstPlayer * self, gboolean enabled)
+{
+  GstElement *overlay = NULL;
 
-  media_info->title = get_from_tags (self, media_info, get_title);
-  media_info->container =
-      get_from_tags (self, media_info, get_container_format);
-  media_info->image_sample = get_from_tags (self, media_info, get_cover_sample);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  GST_DEBUG_OBJECT (self, "uri: %s title: %s duration: %" GST_TIME_FORMAT
-      " seekable: %s container: %s image_sample %p",
-      media_info->uri, media_info->title, GST_TIME_ARGS (media_info->duration),
-      media_info->seekable ? "yes" : "no", media_info->container,
-      media_info->image_sample);
+  if (enabled)
+    player_set_flag (self, GST_PLAY_FLAG_SUBTITLE);
+  else
+    player_clear_flag (self, GST_PLAY_FLAG_SUBTITLE);
 
-  GST_DEBUG_OBJECT (self, "end");
-  return media_info;
+  /* playbin doesn't know about the overlay of a hot-added subtitle */
+  g_mutex_lock (&self->lock);
+  if (self->injected_sub_overlay)
+    overlay = gst_object_ref (self->injected_sub_overlay);
+  g_mutex_unlock (&self->lock);
+  if (overlay) {
+    g_object_set (overlay, "silent", !enabled, NULL);
+    gst_object_unref (overlay);
+  }
+
+  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
 }
 
-static void
-tags_changed_cb (GstPlayer * self, gint stream_index, GType type)
+/**
+ * gst_player_set_subtitle_uri:
+ * @player: #GstPlayer instance
+ * @uri: subtitle URI
+ *
+ * Returns: %TRUE or %FALSE
+ *
+ * Sets the external subtitle URI.
+ *
+ * While playing, the external subtitle is added to the running pipeline
+ * without interrupting playback. It is fed into the existing subtitle
+ * tracks, or overlaid on the video if the stream has none. Otherwise, for
+ * example for live streams, the pipeline is restarted at the current
+ * position.
+ */
+gboolean
+gst_player_set_subtitle_uri (GstPlayer * self, const gchar * suburi)
 {
-  GstPlayerStreamInfo *s;
-
-  if (!self->media_info)
-    return;
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
+  g_return_val_if_fail (suburi != NULL, FALSE);
 
-  /* update the stream information */
   g_mutex_lock (&self->lock);
-  s = gst_player_stream_info_find (self, self->media_info, type, stream_index);
-  gst_player_stream_info_update_tags_and_caps (self, s);
+  if (self->suburi)
+    g_free (self->suburi);
+  self->suburi = g_strdup (suburi);
   g_mutex_unlock (&self->lock);
 
-  emit_media_info_updated_signal (self);
-}
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_set_suburi_internal, self, NULL);
 
-static void
-video_tags_changed_cb (GstElement * playbin, gint stream_index,
-    gpointer user_data)
-{
-  tags_changed_cb (GST_PLAYER (user_data), stream_index,
-      GST_TYPE_PLAYER_VIDEO_INFO);
+  return TRUE;
 }
 
-static void
-audio_tags_changed_cb (GstElement * playbin, gint stream_index,
-    gpointer user_data)
+/**
+ * gst_player_get_subtitle_uri:
+ * @player: #GstPlayer instance
+ *
+ * current subtitle URI
+ *
+ * Returns: (transfer full): URI of the current external subtitle.
+ *   g_free() after usage.
+ */
+gchar *
+gst_player_get_subtitle_uri (GstPlayer * self)
 {
-  tags_changed_cb (GST_PLAYER (user_data), stream_index,
-      GST_TYPE_PLAYER_AUDIO_INFO);
+  gchar *val = NULL;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+
+  g_object_get (self, "suburi", &val, NULL);
+
+  return val;
 }
 
-static void
-subtitle_tags_changed_cb (GstElement * playbin, gint stream_index,
-    gpointer user_data)
+/**
+ * gst_player_get_subtitle_index:
+ * @player: #GstPlayer instance
+ *
+ * Returns the pre-parsed cues of the current external subtitle. The index
+ * is built in the background after the subtitle URI is set.
+ *
+ * Returns: (transfer full): the #GstPlayerSubtitleIndex of the current
+ *   external subtitle, or %NULL if there is none, it is not parsed yet or
+ *   it could not be parsed.
+ *   gst_player_subtitle_index_unref() after usage.
+ */
+GstPlayerSubtitleIndex *
+gst_player_get_subtitle_index (GstPlayer * self)
 {
-  tags_changed_cb (GST_PLAYER (user_data), stream_index,
-      GST_TYPE_PLAYER_SUBTITLE_INFO);
+  GstPlayerSubtitleIndex *index = NULL;
+
+  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+
+  g_mutex_lock (&self->lock);
+  if (self->subtitle_index)
+    index = gst_player_subtitle_index_ref (self->subtitle_index);
+  g_mutex_unlock (&self->lock);
+
+  return index;
 }
 
+#define DISCOVER_TIMEOUT (10 * GST_SECOND)
+
+typedef struct
+{
+  GstPlayer *player;
+  gchar *uri;
+  GstPlayerMediaInfo *info;
+} MediaInfoDiscoveredSignalData;
+
 static gboolean
-volume_changed_dispatch (gpointer user_data)
+media_info_discovered_dispatch (gpointer user_data)
 {
-  g_signal_emit (user_data, signals[SIGNAL_VOLUME_CHANGED], 0);
-  g_object_notify_by_pspec (G_OBJECT (user_data), param_specs[PROP_VOLUME]);
+  MediaInfoDiscoveredSignalData *data = user_data;
+
+  g_signal_emit (data->player, signals[SIGNAL_MEDIA_INFO_DISCOVERED], 0,
+      data->uri, data->info);
 
   return G_SOURCE_REMOVE;
 }
 
-static void inline
-volume_notify_cb (GObject * obj, GParamSpec * pspec, GstPlayer * self)
+static void
+free_media_info_discovered_signal_data (MediaInfoDiscoveredSignalData * data)
 {
-  if (self->dispatch_to_main_context
-      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_VOLUME_CHANGED], 0, NULL, NULL, NULL) != 0) {
-    g_main_context_invoke_full (self->application_context, G_PRIORITY_DEFAULT,
-        volume_changed_dispatch, g_object_ref (self),
-        (GDestroyNotify) g_object_unref);
-  } else {
-    g_signal_emit (self, signals[SIGNAL_VOLUME_CHANGED], 0);
-    g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_VOLUME]);
-  }
+  g_object_unref (data->player);
+  g_free (data->uri);
+  if (data->info)
+    g_object_unref (data->info);
+  g_free (data);
 }
 
-static gboolean
-mute_changed_dispatch (gpointer user_data)
+/* Takes ownership of @info */
+static void
+emit_media_info_discovered (GstPlayer * self, const gchar * uri,
+    GstPlayerMediaInfo * info)
 {
-  g_signal_emit (user_data, signals[SIGNAL_MUTE_CHANGED], 0);
-  g_object_notify_by_pspec (G_OBJECT (user_data), param_specs[PROP_MUTE]);
+  MediaInfoDiscoveredSignalData *data;
 
-  return G_SOURCE_REMOVE;
-}
+  GST_DEBUG_OBJECT (self, "Discovered %s: %s", uri, info ? "ok" : "failed");
 
-static void inline
-mute_notify_cb (GObject * obj, GParamSpec * pspec, GstPlayer * self)
-{
   if (self->dispatch_to_main_context
       && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
-          signals[SIGNAL_MUTE_CHANGED], 0, NULL, NULL, NULL) != 0) {
-    g_main_context_invoke_full (self->application_context, G_PRIORITY_DEFAULT,
-        mute_changed_dispatch, g_object_ref (self),
-        (GDestroyNotify) g_object_unref);
+          signals[SIGNAL_MEDIA_INFO_DISCOVERED], 0, NULL, NULL, NULL) != 0) {
+    data = g_new (MediaInfoDiscoveredSignalData, 1);
+    data->player = g_object_ref (self);
+    data->uri = g_strdup (uri);
+    data->info = info;
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, media_info_discovered_dispatch, data,
+        (GDestroyNotify) free_media_info_discovered_signal_data);
   } else {
-    g_signal_emit (self, signals[SIGNAL_MUTE_CHANGED], 0);
-    g_object_notify_by_pspec (G_OBJECT (self), param_specs[PROP_MUTE]);
+    g_signal_emit (self, signals[SIGNAL_MEDIA_INFO_DISCOVERED], 0, uri, info);
+    if (info)
+      g_object_unref (info);
   }
 }
 
-static gpointer
-gst_player_main (gpointer data)
+static void
+discovered_cb (G_GNUC_UNUSED GstDiscoverer * discoverer,
+    GstDiscovererInfo * dinfo, GError * err, gpointer user_data)
 {
-  GstPlayer *self = GST_PLAYER (data);
-  GstBus *bus;
-  GSource *source;
-  GSource *bus_source;
-
-  GST_TRACE_OBJECT (self, "Starting main thread");
-
-  self->context = g_main_context_new ();
-  g_main_context_push_thread_default (self->context);
-
-  self->loop = g_main_loop_new (self->context, FALSE);
-
-  source = g_idle_source_new ();
-  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
-      NULL);
-  g_source_attach (source, self->context);
-  g_source_unref (source);
-
-  self->playbin = gst_element_factory_make ("playbin", "playbin");
-
-  self->bus = bus = gst_element_get_bus (self->playbin);
-  bus_source = gst_bus_create_watch (bus);
-  g_source_set_callback (bus_source, (GSourceFunc) gst_bus_async_signal_func,
-      NULL, NULL);
-  g_source_attach (bus_source, self->context);
-
-  g_signal_connect (G_OBJECT (bus), "message::error", G_CALLBACK (error_cb),
-      self);
-  g_signal_connect (G_OBJECT (bus), "message::warning", G_CALLBACK (warning_cb),
-      self);
-  g_signal_connect (G_OBJECT (bus), "message::eos", G_CALLBACK (eos_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::state-changed",
-      G_CALLBACK (state_changed_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::buffering",
-      G_CALLBACK (buffering_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::clock-lost",
-      G_CALLBACK (clock_lost_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::duration-changed",
-      G_CALLBACK (duration_changed_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::latency",
-      G_CALLBACK (latency_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::request-state",
-      G_CALLBACK (request_state_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::element",
-      G_CALLBACK (element_cb), self);
-  g_signal_connect (G_OBJECT (bus), "message::tag", G_CALLBACK (tags_cb), self);
-
-  g_signal_connect (self->playbin, "video-changed",
-      G_CALLBACK (video_changed_cb), self);
-  g_signal_connect (self->playbin, "audio-changed",
-      G_CALLBACK (audio_changed_cb), self);
-  g_signal_connect (self->playbin, "text-changed",
-      G_CALLBACK (subtitle_changed_cb), self);
-
-  g_signal_connect (self->playbin, "video-tags-changed",
-      G_CALLBACK (video_tags_changed_cb), self);
-  g_signal_connect (self->playbin, "audio-tags-changed",
-      G_CALLBACK (audio_tags_changed_cb), self);
-  g_signal_connect (self->playbin, "text-tags-changed",
-      G_CALLBACK (subtitle_tags_changed_cb), self);
-  g_signal_connect (self->playbin, "notify::volume",
-      G_CALLBACK (volume_notify_cb), self);
-  g_signal_connect (self->playbin, "notify::mute",
-      G_CALLBACK (mute_notify_cb), self);
+  GstPlayer *self = GST_PLAYER (user_data);
+  GstDiscovererResult result = gst_discoverer_info_get_result (dinfo);
+  GstPlayerMediaInfo *info = NULL;
 
-  self->target_state = GST_STATE_NULL;
-  self->current_state = GST_STATE_NULL;
-  change_state (self, GST_PLAYER_STATE_STOPPED);
-  self->buffering = 100;
-  self->is_eos = FALSE;
-  self->is_live = FALSE;
+  /* Files that need missing plugins are still reported, only unplayable */
+  if (result == GST_DISCOVERER_OK || result == GST_DISCOVERER_MISSING_PLUGINS) {
+    info = gst_player_media_info_new_from_discoverer_info (dinfo);
+    gst_player_media_info_cache_store (info);
+  } else {
+    GST_WARNING_OBJECT (self, "Failed to discover %s: %s",
+        gst_discoverer_info_get_uri (dinfo), err ? err->message : "timeout");
+  }
 
-  GST_TRACE_OBJECT (self, "Starting main loop");
-  g_main_loop_run (self->loop);
-  GST_TRACE_OBJECT (self, "Stopped main loop");
+  emit_media_info_discovered (self, gst_discoverer_info_get_uri (dinfo), info);
+}
 
-  g_main_loop_unref (self->loop);
-  self->loop = NULL;
+typedef struct
+{
+  GstPlayer *player;
+  gchar *uri;
+} DiscoverRequest;
 
-  g_source_destroy (bus_source);
-  g_source_unref (bus_source);
-  gst_object_unref (bus);
+static void
+discover_request_free (DiscoverRequest * request)
+{
+  g_free (request->uri);
+  g_free (request);
+}
 
-  remove_tick_source (self);
-  remove_ready_timeout_source (self);
+static gboolean
+gst_player_discover_internal (gpointer user_data)
+{
+  DiscoverRequest *request = user_data;
+  GstPlayer *self = request->player;
+  GstPlayerMediaInfo *info;
+  GError *err = NULL;
 
-  g_mutex_lock (&self->lock);
-  if (self->media_info) {
-    g_object_unref (self->media_info);
-    self->media_info = NULL;
+  info = gst_player_media_info_cache_lookup (request->uri);
+  if (info) {
+    GST_DEBUG_OBJECT (self, "Media info of %s is cached", request->uri);
+    emit_media_info_discovered (self, request->uri, info);
+    return G_SOURCE_REMOVE;
   }
 
-  if (self->seek_source)
-    g_source_unref (self->seek_source);
-  self->seek_source = NULL;
-  g_mutex_unlock (&self->lock);
-
-  g_main_context_pop_thread_default (self->context);
-  g_main_context_unref (self->context);
-  self->context = NULL;
-
-  self->target_state = GST_STATE_NULL;
-  self->current_state = GST_STATE_NULL;
-  if (self->playbin) {
-    gst_element_set_state (self->playbin, GST_STATE_NULL);
-    gst_object_unref (self->playbin);
-    self->playbin = NULL;
+  if (!self->discoverer) {
+    self->discoverer = gst_discoverer_new (DISCOVER_TIMEOUT, &err);
+    if (!self->discoverer) {
+      GST_ERROR_OBJECT (self, "Failed to create discoverer: %s",
+          err->message);
+      g_error_free (err);
+      emit_media_info_discovered (self, request->uri, NULL);
+      return G_SOURCE_REMOVE;
+    }
+    g_signal_connect (self->discoverer, "discovered",
+        G_CALLBACK (discovered_cb), self);
+    /* Runs on the thread default context, which is ours */
+    gst_discoverer_start (self->discoverer);
   }
 
-  GST_TRACE_OBJECT (self, "Stopped main thread");
-
-  return NULL;
-}
-
-static gpointer
-gst_player_init_once (gpointer user_data)
-{
-  gst_init (NULL, NULL);
-
-  GST_DEBUG_CATEGORY_INIT (gst_player_debug, "gst-player", 0, "GstPlayer");
-  gst_player_error_quark ();
+  if (!gst_discoverer_discover_uri_async (self->discoverer, request->uri))
+    emit_media_info_discovered (self, request->uri, NULL);
 
-  return NULL;
+  return G_SOURCE_REMOVE;
 }
 
 /**
- * gst_player_new:
+ * gst_player_discover_async:
+ * @player: #GstPlayer instance
+ * @uri: URI of the media to discover
  *
- * Returns: a new #GstPlayer instance
+ * Retrieves the #GstPlayerMediaInfo of @uri without playing it, for example
+ * to show durations and stream information of playlist entries. Only the
+ * streams are parsed, nothing is decoded, and results of local files are
+ * cached on disk until the file changes.
+ *
+ * The result is reported with the #GstPlayer::media-info-discovered signal,
+ * with a %NULL media info if @uri could not be discovered. Requests are
+ * handled one at a time in the order they were made.
  */
-GstPlayer *
-gst_player_new (void)
+void
+gst_player_discover_async (GstPlayer * self, const gchar * uri)
 {
-  static GOnce once = G_ONCE_INIT;
+  DiscoverRequest *request;
 
-  g_once (&once, gst_player_init_once, NULL);
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (uri != NULL);
 
-  return g_object_new (GST_TYPE_PLAYER, NULL);
+  request = g_new (DiscoverRequest, 1);
+  request->player = self;
+  request->uri = g_strdup (uri);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_discover_internal, request,
+      (GDestroyNotify) discover_request_free);
 }
 
+#define COVER_ART_TIMEOUT (5 * GST_SECOND)
+
+typedef struct
+{
+  GstPlayer *player;
+  GstPlayerMediaInfo *info;
+  GstSample *sample;
+} CoverArtReadySignalData;
+
 static gboolean
-gst_player_play_internal (gpointer user_data)
+cover_art_ready_dispatch (gpointer user_data)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GstStateChangeReturn state_ret;
+  CoverArtReadySignalData *data = user_data;
 
-  GST_DEBUG_OBJECT (self, "Play");
+  g_signal_emit (data->player, signals[SIGNAL_COVER_ART_READY], 0,
+      data->info, data->sample);
 
-  g_mutex_lock (&self->lock);
-  if (!self->uri) {
-    g_mutex_unlock (&self->lock);
-    return G_SOURCE_REMOVE;
-  }
-  g_mutex_unlock (&self->lock);
+  return G_SOURCE_REMOVE;
+}
 
-  remove_ready_timeout_source (self);
-  self->target_state = GST_STATE_PLAYING;
+static void
+free_cover_art_ready_signal_data (CoverArtReadySignalData * data)
+{
+  g_object_unref (data->player);
+  g_object_unref (data->info);
+  if (data->sample)
+    gst_sample_unref (data->sample);
+  g_free (data);
+}
 
-  if (self->current_state < GST_STATE_PAUSED)
-    change_state (self, GST_PLAYER_STATE_BUFFERING);
+/* Takes ownership of @sample */
+static void
+emit_cover_art_ready (GstPlayer * self, GstPlayerMediaInfo * info,
+    GstSample * sample)
+{
+  CoverArtReadySignalData *data;
 
-  if (self->current_state >= GST_STATE_PAUSED && !self->is_eos) {
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PLAYING);
+  if (self->dispatch_to_main_context
+      && g_signal_handler_find (self, G_SIGNAL_MATCH_ID,
+          signals[SIGNAL_COVER_ART_READY], 0, NULL, NULL, NULL) != 0) {
+    data = g_new (CoverArtReadySignalData, 1);
+    data->player = g_object_ref (self);
+    data->info = g_object_ref (info);
+    data->sample = sample;
+    g_main_context_invoke_full (self->application_context,
+        G_PRIORITY_DEFAULT, cover_art_ready_dispatch, data,
+        (GDestroyNotify) free_cover_art_ready_signal_data);
   } else {
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
-  }
-
-  if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
-    self->is_live = TRUE;
-    GST_DEBUG_OBJECT (self, "Pipeline is live");
-  }
-
-  if (state_ret == GST_STATE_CHANGE_FAILURE) {
-    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-            "Failed to play"));
-    return G_SOURCE_REMOVE;
-  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
-    self->is_live = TRUE;
-    GST_DEBUG_OBJECT (self, "Pipeline is live");
+    g_signal_emit (self, signals[SIGNAL_COVER_ART_READY], 0, info, sample);
+    if (sample)
+      gst_sample_unref (sample);
   }
+}
 
-  if (self->is_eos) {
-    gboolean ret;
+typedef struct
+{
+  GWeakRef player;
+  GstPlayerMediaInfo *info;
+  gint max_width, max_height;
+} CoverArtRequest;
 
-    GST_DEBUG_OBJECT (self, "Was EOS, seeking to beginning");
-    self->is_eos = FALSE;
-    ret =
-        gst_element_seek_simple (self->playbin, GST_FORMAT_TIME,
-        GST_SEEK_FLAG_FLUSH, 0);
-    if (!ret) {
-      GST_ERROR_OBJECT (self, "Seek to beginning failed");
-      gst_player_stop_internal (self);
-      gst_player_play_internal (self);
-    }
+static void
+cover_art_request_free (CoverArtRequest * request)
+{
+  g_weak_ref_clear (&request->player);
+  g_object_unref (request->info);
+  g_free (request);
+}
+
+/* Owns @sample and @err */
+static void
+cover_art_converted_cb (GstSample * sample, GError * err, gpointer user_data)
+{
+  CoverArtRequest *request = user_data;
+  GstPlayer *self;
+
+  /* The decode may outlive the player, it only holds a weak reference as
+   * the last reference must not be dropped from the player thread */
+  self = g_weak_ref_get (&request->player);
+  if (!self) {
+    if (sample)
+      gst_sample_unref (sample);
+    if (err)
+      g_error_free (err);
+    return;
   }
 
-  return G_SOURCE_REMOVE;
+  if (sample) {
+    gst_player_cover_art_cache_store (request->info->image_sample,
+        request->max_width, request->max_height, sample);
+  } else {
+    GST_WARNING_OBJECT (self, "Failed to decode cover art: %s",
+        err ? err->message : "unknown error");
+  }
+  if (err)
+    g_error_free (err);
+
+  emit_cover_art_ready (self, request->info, sample);
+  g_object_unref (self);
 }
 
-/**
- * gst_player_play:
- * @player: #GstPlayer instance
- *
- * Request to play the loaded stream.
- */
-void
-gst_player_play (GstPlayer * self)
+static GstCaps *
+cover_art_caps_new (gint max_width, gint max_height)
 {
-  g_return_if_fail (GST_IS_PLAYER (self));
+  GstCaps *caps;
 
-  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-      gst_player_play_internal, self, NULL);
+  /* videoscale picks the largest size within the ranges that keeps the
+   * aspect ratio, and does not upscale smaller images */
+  caps = gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, "RGB",
+      "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
+  if (max_width > 1)
+    gst_caps_set_simple (caps, "width", GST_TYPE_INT_RANGE, 1, max_width,
+        NULL);
+  else
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, 1, NULL);
+  if (max_height > 1)
+    gst_caps_set_simple (caps, "height", GST_TYPE_INT_RANGE, 1, max_height,
+        NULL);
+  else
+    gst_caps_set_simple (caps, "height", G_TYPE_INT, 1, NULL);
+
+  return caps;
 }
 
 static gboolean
-gst_player_pause_internal (gpointer user_data)
+gst_player_request_cover_art_internal (gpointer user_data)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
-  GstStateChangeReturn state_ret;
-
-  GST_DEBUG_OBJECT (self, "Pause");
+  CoverArtRequest *request = user_data;
+  GstPlayer *self;
+  GstSample *image, *sample;
+  GstCaps *caps;
 
-  g_mutex_lock (&self->lock);
-  if (!self->uri) {
-    g_mutex_unlock (&self->lock);
+  self = g_weak_ref_get (&request->player);
+  if (!self) {
+    cover_art_request_free (request);
     return G_SOURCE_REMOVE;
   }
-  g_mutex_unlock (&self->lock);
-
-  tick_cb (self);
-  remove_tick_source (self);
-  remove_ready_timeout_source (self);
-
-  self->target_state = GST_STATE_PAUSED;
-
-  if (self->current_state < GST_STATE_PAUSED)
-    change_state (self, GST_PLAYER_STATE_BUFFERING);
 
-  state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
-  if (state_ret == GST_STATE_CHANGE_FAILURE) {
-    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-            "Failed to pause"));
+  image = request->info->image_sample;
+  if (!image) {
+    emit_cover_art_ready (self, request->info, NULL);
+    cover_art_request_free (request);
+    g_object_unref (self);
     return G_SOURCE_REMOVE;
-  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
-    self->is_live = TRUE;
-    GST_DEBUG_OBJECT (self, "Pipeline is live");
   }
 
-  if (self->is_eos) {
-    gboolean ret;
-
-    GST_DEBUG_OBJECT (self, "Was EOS, seeking to beginning");
-    self->is_eos = FALSE;
-    ret =
-        gst_element_seek_simple (self->playbin, GST_FORMAT_TIME,
-        GST_SEEK_FLAG_FLUSH, 0);
-    if (!ret) {
-      GST_ERROR_OBJECT (self, "Seek to beginning failed");
-      gst_player_stop_internal (self);
-      gst_player_pause_internal (self);
-    }
+  sample = gst_player_cover_art_cache_lookup (image, request->max_width,
+      request->max_height);
+  if (sample) {
+    GST_DEBUG_OBJECT (self, "Cover art is cached");
+    emit_cover_art_ready (self, request->info, sample);
+    cover_art_request_free (request);
+    g_object_unref (self);
+    return G_SOURCE_REMOVE;
   }
 
+  /* Decodes and scales in a separate pipeline, the result is reported on
+   * the thread default context, which is ours */
+  caps = cover_art_caps_new (request->max_width, request->max_height);
+  gst_video_convert_sample_async (image, caps, COVER_ART_TIMEOUT,
+      cover_art_converted_cb, request,
+      (GDestroyNotify) cover_art_request_free);
+  gst_caps_unref (caps);
+  g_object_unref (self);
+
   return G_SOURCE_REMOVE;
 }
 
 /**
- * gst_player_pause:
+ * gst_player_request_cover_art:
  * @player: #GstPlayer instance
+ * @info: #GstPlayerMediaInfo with the cover art
+ * @max_width: maximum width of the decoded image
+ * @max_height: maximum height of the decoded image
  *
- * Pauses the current stream.
+ * Decodes the cover art of @info to RGB in the background, scaled down to
+ * fit into @max_width x @max_height while keeping its aspect ratio. Only
+ * the scaled image is kept, and it is shared by all copies of @info so
+ * requesting the same size again completes immediately, see also
+ * gst_player_media_info_get_cover_art().
+ *
+ * The result is reported with the #GstPlayer::cover-art-ready signal, with
+ * a %NULL sample if @info has no cover art or it could not be decoded.
  */
 void
-gst_player_pause (GstPlayer * self)
+gst_player_request_cover_art (GstPlayer * self, GstPlayerMediaInfo * info,
+    gint max_width, gint max_height)
 {
+  CoverArtRequest *request;
+
   g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (GST_IS_PLAYER_MEDIA_INFO (info));
+  g_return_if_fail (max_width > 0 && max_height > 0);
+
+  request = g_new (CoverArtRequest, 1);
+  g_weak_ref_init (&request->player, self);
+  request->info = g_object_ref (info);
+  request->max_width = MIN (max_width, GST_PLAYER_COVER_ART_MAX_SIZE);
+  request->max_height = MIN (max_height, GST_PLAYER_COVER_ART_MAX_SIZE);
 
   g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-      gst_player_pause_internal, self, NULL);
+      gst_player_request_cover_art_internal, request, NULL);
 }
 
-static gboolean
-gst_player_stop_internal (gpointer user_data)
+/**
+ * gst_player_set_seamless_track_switch:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
+ *
+ * Keeps the alternate audio and subtitle tracks buffered in sync with the
+ * active one, so that switching tracks continues at the exact position
+ * without a gap. This needs some additional memory per alternate track.
+ *
+ * The time each switch took is reported with the #GstPlayer::track-switched
+ * signal.
+ */
+void
+gst_player_set_seamless_track_switch (GstPlayer * self, gboolean enabled)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  GST_DEBUG_OBJECT (self, "Stop");
+  g_object_set (self, "seamless-track-switch", enabled, NULL);
+}
 
-  tick_cb (self);
-  remove_tick_source (self);
+/**
+ * gst_player_get_seamless_track_switch:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if seamless track switching is enabled.
+ */
+gboolean
+gst_player_get_seamless_track_switch (GstPlayer * self)
+{
+  gboolean val;
 
-  add_ready_timeout_source (self);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  self->target_state = GST_STATE_NULL;
-  self->current_state = GST_STATE_READY;
-  self->is_live = FALSE;
-  self->is_eos = FALSE;
-  gst_bus_set_flushing (self->bus, TRUE);
-  gst_element_set_state (self->playbin, GST_STATE_READY);
-  gst_bus_set_flushing (self->bus, FALSE);
-  change_state (self, GST_PLAYER_STATE_STOPPED);
-  self->buffering = 100;
-  g_mutex_lock (&self->lock);
-  if (self->media_info) {
-    g_object_unref (self->media_info);
-    self->media_info = NULL;
-  }
-  if (self->global_tags) {
-    gst_tag_list_unref (self->global_tags);
-    self->global_tags = NULL;
-  }
-  self->seek_pending = FALSE;
-  if (self->seek_source) {
-    g_source_destroy (self->seek_source);
-    g_source_unref (self->seek_source);
-    self->seek_source = NULL;
-  }
-  self->seek_position = GST_CLOCK_TIME_NONE;
-  self->last_seek_time = GST_CLOCK_TIME_NONE;
-  self->rate = 1.0;
-  g_mutex_unlock (&self->lock);
+  g_object_get (self, "seamless-track-switch", &val, NULL);
 
-  return G_SOURCE_REMOVE;
+  return val;
 }
 
 /**
- * gst_player_stop:
+ * gst_player_set_keyframe_index_enabled:
  * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
  *
- * Stops playing the current stream and resets to the first position
- * in the stream.
+ * Enables indexing the keyframes of local media in the background after
+ * preroll. Only the streams are demuxed for this, nothing is decoded. The
+ * index is cached per file, so each file is only indexed once.
+ *
+ * Once available, the keyframes are part of the #GstPlayerMediaInfo and
+ * seeks to them need no decoding of frames in between.
  */
 void
-gst_player_stop (GstPlayer * self)
+gst_player_set_keyframe_index_enabled (GstPlayer * self, gboolean enabled)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
-      gst_player_stop_internal, self, NULL);
+  g_object_set (self, "keyframe-index", enabled, NULL);
 }
 
-/* Must be called with lock from main context, releases lock! */
-static void
-gst_player_seek_internal_locked (GstPlayer * self)
+/**
+ * gst_player_get_keyframe_index_enabled:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if keyframe indexing is enabled.
+ */
+gboolean
+gst_player_get_keyframe_index_enabled (GstPlayer * self)
 {
-  gboolean ret;
-  GstClockTime position;
-  gdouble rate;
-  GstStateChangeReturn state_ret;
-  GstEvent *s_event;
-  GstSeekFlags flags = 0;
-
-  if (self->seek_source) {
-    g_source_destroy (self->seek_source);
-    g_source_unref (self->seek_source);
-    self->seek_source = NULL;
-  }
-
-  /* Only seek in PAUSED */
-  if (self->current_state < GST_STATE_PAUSED) {
-    return;
-  } else if (self->current_state != GST_STATE_PAUSED) {
-    g_mutex_unlock (&self->lock);
-    state_ret = gst_element_set_state (self->playbin, GST_STATE_PAUSED);
-    if (state_ret == GST_STATE_CHANGE_FAILURE) {
-      emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-              "Failed to seek"));
-      g_mutex_lock (&self->lock);
-      return;
-    }
-    g_mutex_lock (&self->lock);
-    return;
-  }
-
-  self->last_seek_time = gst_util_get_timestamp ();
-  position = self->seek_position;
-  self->seek_position = GST_CLOCK_TIME_NONE;
-  self->seek_pending = TRUE;
-  rate = self->rate;
-  g_mutex_unlock (&self->lock);
-
-  remove_tick_source (self);
-  self->is_eos = FALSE;
-
-  flags |= GST_SEEK_FLAG_FLUSH;
+  gboolean val;
 
-  if (rate != 1.0) {
-    flags |= GST_SEEK_FLAG_TRICKMODE;
-  }
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  if (rate >= 0.0) {
-    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
-        GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
-  } else {
-    s_event = gst_event_new_seek (rate, GST_FORMAT_TIME, flags,
-        GST_SEEK_TYPE_SET, G_GINT64_CONSTANT (0), GST_SEEK_TYPE_SET, position);
-  }
+  g_object_get (self, "keyframe-index", &val, NULL);
 
-  GST_DEBUG_OBJECT (self, "Seek with rate %.2lf to %" GST_TIME_FORMAT,
-      rate, GST_TIME_ARGS (position));
+  return val;
+}
 
-  ret = gst_element_send_event (self->playbin, s_event);
-  if (!ret)
-    emit_error (self, g_error_new (GST_PLAYER_ERROR, GST_PLAYER_ERROR_FAILED,
-            "Failed to seek to %" GST_TIME_FORMAT, GST_TIME_ARGS (position)));
+/**
+ * gst_player_set_resume_store_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
+ *
+ * Enables remembering the playback position of seekable media while it
+ * is played and when it is stopped. When a URI is set again later,
+ * playback starts at the remembered position. Positions close to the start
+ * or the end of the media are not remembered.
+ *
+ * The positions are stored in a file shared by all players of the user.
+ */
+void
+gst_player_set_resume_store_enabled (GstPlayer * self, gboolean enabled)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_mutex_lock (&self->lock);
+  g_object_set (self, "resume-store", enabled, NULL);
 }
 
-static gboolean
-gst_player_seek_internal (gpointer user_data)
+/**
+ * gst_player_get_resume_store_enabled:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if playback positions are remembered.
+ */
+gboolean
+gst_player_get_resume_store_enabled (GstPlayer * self)
 {
-  GstPlayer *self = GST_PLAYER (user_data);
+  gboolean val;
 
-  g_mutex_lock (&self->lock);
-  gst_player_seek_internal_locked (self);
-  g_mutex_unlock (&self->lock);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  return G_SOURCE_REMOVE;
+  g_object_get (self, "resume-store", &val, NULL);
+
+  return val;
 }
 
-static gboolean
-gst_player_set_rate_internal (gpointer user_data)
+/**
+ * gst_player_set_mmap_source_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
+ *
+ * Enables reading local files from a read-only memory mapping. Buffers
+ * wrap the mapped file without copying, and the kernel is asked to read
+ * ahead as much as is consumed in a few seconds. The number of bytes read
+ * and page faults are reported by gst_player_get_stats().
+ *
+ * Takes effect from the next URI change on. Files must not be truncated
+ * while they are played this way.
+ */
+void
+gst_player_set_mmap_source_enabled (GstPlayer * self, gboolean enabled)
 {
-  GstPlayer *self = user_data;
-
-  g_mutex_lock (&self->lock);
-
-  self->seek_position = gst_player_get_position (self);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  /* If there is no seek being dispatch to the main context currently do that,
-   * otherwise we just updated the rate so that it will be taken by
-   * the seek handler from the main context instead of the old one.
-   */
-  if (!self->seek_source) {
-    /* If no seek is pending then create new seek source */
-    if (!self->seek_pending) {
-      self->seek_source = g_idle_source_new ();
-      g_source_set_callback (self->seek_source,
-          (GSourceFunc) gst_player_seek_internal, self, NULL);
-      g_source_attach (self->seek_source, self->context);
-    }
-  }
+  g_object_set (self, "mmap-source", enabled, NULL);
+}
 
-  g_mutex_unlock (&self->lock);
+/**
+ * gst_player_get_mmap_source_enabled:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if local files are read from a memory mapping.
+ */
+gboolean
+gst_player_get_mmap_source_enabled (GstPlayer * self)
+{
+  gboolean val;
 
-  return G_SOURCE_REMOVE;
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
+
+  g_object_get (self, "mmap-source", &val, NULL);
+
+  return val;
 }
 
 /**
- * gst_player_set_rate:
+ * gst_player_set_http_cache_size:
  * @player: #GstPlayer instance
- * @rate: playback rate
+ * @size: size in bytes, 0 to disable the cache
  *
- * Playback at specified rate
+ * Enables an on-disk cache for media over HTTP and HTTPS of at most @size
+ * bytes. Data that was downloaded once is read from the cache when
+ * seeking back or playing the same media again, as long as the server
+ * reports the same ETag or modification date for it. Connections to
+ * servers are kept alive and reused, also by the next media played.
+ *
+ * The cache is shared by all players of the user, when it grows beyond
+ * @size the least recently used media is removed. Takes effect from the
+ * next URI change on.
  */
 void
-gst_player_set_rate (GstPlayer * self, gdouble rate)
+gst_player_set_http_cache_size (GstPlayer * self, guint64 size)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
-  g_return_if_fail (rate != 0.0);
-
-  g_mutex_lock (&self->lock);
-  self->rate = rate;
-  g_mutex_unlock (&self->lock);
 
-  gst_player_set_rate_internal (self);
+  g_object_set (self, "http-cache-size", size, NULL);
 }
 
 /**
- * gst_player_get_rate:
+ * gst_player_get_http_cache_size:
  * @player: #GstPlayer instance
  *
- * Returns: current playback rate
+ * Returns: the size of the HTTP cache in bytes, 0 if it is disabled.
  */
-gdouble
-gst_player_get_rate (GstPlayer * self)
+guint64
+gst_player_get_http_cache_size (GstPlayer * self)
 {
-  g_return_val_if_fail (GST_IS_PLAYER (self), 1.0);
+  guint64 val;
 
-  return self->rate;
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+
+  g_object_get (self, "http-cache-size", &val, NULL);
+
+  return val;
 }
 
 /**
- * gst_player_seek:
+ * gst_player_set_shared_decode_enabled:
  * @player: #GstPlayer instance
- * @position: position to seek in nanoseconds
+ * @enabled: TRUE or FALSE
  *
- * Seeks the currently-playing stream to the absolute @position time
- * in nanoseconds.
+ * Enables sharing the decoding with the other players of the process that
+ * play the same URI with this enabled. The media is decoded once and the
+ * decoded buffers are handed to all of these players without copying,
+ * each shows them with its own sinks and window.
+ *
+ * The players show the media like a live stream: they show what is
+ * decoded at the moment, cannot seek, and drop what they miss while
+ * paused. The decoding stops when the last of them stops. The number of
+ * players sharing it is reported by gst_player_get_stats(). Takes effect
+ * from the next URI change on.
  */
 void
-gst_player_seek (GstPlayer * self, GstClockTime position)
+gst_player_set_shared_decode_enabled (GstPlayer * self, gboolean enabled)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
-  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (position));
 
-  g_mutex_lock (&self->lock);
-  if (self->media_info && !self->media_info->seekable) {
-    GST_DEBUG_OBJECT (self, "Media is not seekable");
-    g_mutex_unlock (&self->lock);
-    return;
-  }
+  g_object_set (self, "shared-decode", enabled, NULL);
+}
 
-  self->seek_position = position;
+/**
+ * gst_player_get_shared_decode_enabled:
+ * @player: #GstPlayer instance
+ *
+ * Returns: %TRUE if decoding is shared with other players of the same URI.
+ */
+gboolean
+gst_player_get_shared_decode_enabled (GstPlayer * self)
+{
+  gboolean val;
 
-  /* If there is no seek being dispatch to the main context currently do that,
-   * otherwise we just updated the seek position so that it will be taken by
-   * the seek handler from the main context instead of the old one.
-   */
-  if (!self->seek_source) {
-    GstClockTime now = gst_util_get_timestamp ();
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-    /* If no seek is pending or it was started more than 250 mseconds ago seek
-     * immediately, otherwise wait until the 250 mseconds have passed */
-    if (!self->seek_pending || (now - self->last_seek_time > 250 * GST_MSECOND)) {
-      self->seek_source = g_idle_source_new ();
-      g_source_set_callback (self->seek_source,
-          (GSourceFunc) gst_player_seek_internal, self, NULL);
-      GST_TRACE_OBJECT (self, "Dispatching seek to position %" GST_TIME_FORMAT,
-          GST_TIME_ARGS (position));
-      g_source_attach (self->seek_source, self->context);
-    } else {
-      guint delay = 250000 - (now - self->last_seek_time) / 1000;
+  g_object_get (self, "shared-decode", &val, NULL);
 
-      /* Note that last_seek_time must be set to something at this point and
-       * it must be smaller than 250 mseconds */
-      self->seek_source = g_timeout_source_new (delay);
-      g_source_set_callback (self->seek_source,
-          (GSourceFunc) gst_player_seek_internal, self, NULL);
+  return val;
+}
 
-      GST_TRACE_OBJECT (self,
-          "Delaying seek to position %" GST_TIME_FORMAT " by %u us",
-          GST_TIME_ARGS (position), delay);
-      g_source_attach (self->seek_source, self->context);
-    }
-  }
-  g_mutex_unlock (&self->lock);
+/**
+ * gst_player_set_remote_decode_enabled:
+ * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
+ *
+ * Enables demuxing and decoding the media in a separate helper process.
+ * A demuxer or decoder crashing on broken media then only ends that
+ * process, the player reports it as an error and keeps working. The
+ * player keeps its sinks, so the API, the signals and the window are the
+ * same as without it.
+ *
+ * Decoded data is passed through shared memory: the helper copies it
+ * once, the player's buffers use that memory directly. The average delay
+ * between the processes is reported by gst_player_get_stats(). Only
+ * supported on UNIX systems. Takes effect from the next URI change on.
+ */
+void
+gst_player_set_remote_decode_enabled (GstPlayer * self, gboolean enabled)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+
+  g_object_set (self, "remote-decode", enabled, NULL);
 }
 
 /**
- * gst_player_get_dispatch_to_main_context:
+ * gst_player_get_remote_decode_enabled:
  * @player: #GstPlayer instance
  *
- * Returns: %TRUE if the callbacks are dispatched in the thread's
- * default main context. Otherwise, %FALSE.
+ * Returns: %TRUE if media is decoded in a separate process.
  */
 gboolean
-gst_player_get_dispatch_to_main_context (GstPlayer * self)
+gst_player_get_remote_decode_enabled (GstPlayer * self)
 {
   gboolean val;
 
   g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  g_object_get (self, "dispatch-to-main-context", &val, NULL);
+  g_object_get (self, "remote-decode", &val, NULL);
 
   return val;
 }
 
 /**
- * gst_player_set_dispatch_to_main_context:
+ * gst_player_set_shared_audio_output_enabled:
  * @player: #GstPlayer instance
- * @val: whether the callbacks are dispatched in the thread's default
- * main context
+ * @enabled: TRUE or FALSE
  *
- * Sets whether the callbacks are dispatched in the thread's default
- * main context.
+ * Enables playing the audio through one mixer shared by all players of the
+ * process that have this enabled. Instead of opening an audio device of
+ * its own the player hands its audio to the mixer, which plays the audio
+ * of all of them on a single device with a single mixing thread.
+ *
+ * gst_player_set_volume() and gst_player_set_mute() keep applying to the
+ * audio of this player only. Audio is muted while playing at rates other
+ * than 1.0. The number of players playing through the mixer is reported
+ * by gst_player_get_stats(). Takes effect from the next URI change on.
  */
 void
-gst_player_set_dispatch_to_main_context (GstPlayer * self, gboolean val)
+gst_player_set_shared_audio_output_enabled (GstPlayer * self,
+    gboolean enabled)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_object_set (self, "dispatch-to-main-context", val, NULL);
+  g_object_set (self, "shared-audio-output", enabled, NULL);
 }
 
 /**
- * gst_player_get_uri:
+ * gst_player_get_shared_audio_output_enabled:
  * @player: #GstPlayer instance
  *
- * Gets the URI of the currently-playing stream.
- *
- * Returns: (transfer full): a string containing the URI of the
- * currently-playing stream. g_free() after usage.
+ * Returns: %TRUE if audio is played through the audio mixer shared by the
+ * players of the process.
  */
-gchar *
-gst_player_get_uri (GstPlayer * self)
+gboolean
+gst_player_get_shared_audio_output_enabled (GstPlayer * self)
 {
-  gchar *val;
+  gboolean val;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  g_object_get (self, "uri", &val, NULL);
+  g_object_get (self, "shared-audio-output", &val, NULL);
 
   return val;
 }
 
+typedef struct
+{
+  GstPlayer *player;
+  gchar *uri;
+} ClipRequest;
+
+static void
+clip_request_free (ClipRequest * request)
+{
+  g_free (request->uri);
+  g_free (request);
+}
+
+static void
+clip_player_ref_free (GWeakRef * player)
+{
+  g_weak_ref_clear (player);
+  g_free (player);
+}
+
+/* Must be called from the main context */
+static void
+play_clip_pcm (GstPlayer * self, const gchar * uri, GstBuffer * pcm)
+{
+  GError *err = NULL;
+  gdouble volume;
+  gboolean mute;
+
+  if (!self->clip_voices)
+    self->clip_voices = gst_player_audio_mixer_voices_new (&err);
+
+  if (self->clip_voices) {
+    g_object_get (self->playbin, "volume", &volume, "mute", &mute, NULL);
+    GST_DEBUG_OBJECT (self, "Playing clip '%s' at volume %lf", uri,
+        mute ? 0.0 : volume);
+    if (!mute)
+      gst_player_audio_mixer_voices_play (self->clip_voices, pcm, volume,
+          &err);
+  }
+
+  if (err) {
+    emit_warning (self, g_error_new (GST_PLAYER_ERROR,
+            GST_PLAYER_ERROR_FAILED, "Failed to play clip '%s': %s", uri,
+            err->message));
+    g_error_free (err);
+  }
+}
+
+/* Called from the main context once the clip was decoded */
+static void
+clip_decoded_cb (const gchar * uri, GstBuffer * pcm, const GError * error,
+    gpointer user_data)
+{
+  GstPlayer *self;
+
+  /* The decoding may outlive the player, it only holds a weak reference as
+   * the last reference must not be dropped from the player thread */
+  self = g_weak_ref_get ((GWeakRef *) user_data);
+  if (!self)
+    return;
+
+  g_mutex_lock (&self->lock);
+  self->clip_cache_misses++;
+  g_mutex_unlock (&self->lock);
+
+  if (pcm)
+    play_clip_pcm (self, uri, pcm);
+  else
+    emit_warning (self, g_error_new (GST_PLAYER_ERROR,
+            GST_PLAYER_ERROR_FAILED, "Failed to play clip '%s': %s", uri,
+            error ? error->message : "unknown error"));
+
+  g_object_unref (self);
+}
+
+static gboolean
+gst_player_play_clip_internal (gpointer user_data)
+{
+  ClipRequest *request = user_data;
+  GstPlayer *self = request->player;
+  GWeakRef *player;
+  GstBuffer *pcm;
+
+  pcm = gst_player_clip_cache_lookup (request->uri);
+  if (pcm) {
+    g_mutex_lock (&self->lock);
+    self->clip_cache_hits++;
+    g_mutex_unlock (&self->lock);
+
+    play_clip_pcm (self, request->uri, pcm);
+    gst_buffer_unref (pcm);
+    return G_SOURCE_REMOVE;
+  }
+
+  /* Played once decoded, the player goes on meanwhile */
+  GST_DEBUG_OBJECT (self, "Decoding clip '%s'", request->uri);
+  player = g_new0 (GWeakRef, 1);
+  g_weak_ref_init (player, self);
+  gst_player_clip_cache_decode (request->uri, self->context, clip_decoded_cb,
+      player, (GDestroyNotify) clip_player_ref_free);
+
+  return G_SOURCE_REMOVE;
+}
+
 /**
- * gst_player_set_uri:
+ * gst_player_play_clip:
  * @player: #GstPlayer instance
- * @uri: next URI to play.
+ * @uri: URI of a short clip
  *
- * Sets the next URI to play.
+ * Plays the audio of the short clip at @uri, e.g. a notification or user
+ * interface sound, without changing the URI or state of the player.
+ *
+ * Clips are played through the shared audio output, see
+ * gst_player_set_shared_audio_output_enabled(), at the current volume of
+ * the player. The first time a clip is played it is decoded completely
+ * into a cache in memory that is shared by all players, in the background,
+ * and played once decoded. Playing it again starts within a few
+ * milliseconds. Calls while the clip or other clips
+ * are still playing play along with these. Clips that decode to more than
+ * about ten seconds of audio are not played. The least recently played
+ * clips are dropped from the cache once it holds more than 16 MB.
+ *
+ * Failures are reported with the #GstPlayer::warning signal.
  */
 void
-gst_player_set_uri (GstPlayer * self, const gchar * val)
+gst_player_play_clip (GstPlayer * self, const gchar * uri)
 {
+  ClipRequest *request;
+
   g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (uri != NULL);
 
-  g_object_set (self, "uri", val, NULL);
+  request = g_new (ClipRequest, 1);
+  request->player = self;
+  request->uri = g_strdup (uri);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_play_clip_internal, request,
+      (GDestroyNotify) clip_request_free);
 }
 
 /**
- * gst_player_get_position:
+ * gst_player_set_adaptive_bitrate_enabled:
  * @player: #GstPlayer instance
+ * @enabled: TRUE or FALSE
  *
- * Returns: the absolute position time, in nanoseconds, of the
- * currently-playing stream.
+ * Enables selecting the variant of adaptive streams like HLS and DASH by
+ * the player. The throughput is estimated from the fragment downloads and
+ * the demuxer may select variants up to a part of it that depends on how
+ * full the buffer is. Playback starts with the lowest variant and
+ * switches up once the throughput is known.
+ *
+ * Switches are reported with the #GstPlayer::variant-switched signal and
+ * the current variant with gst_player_media_info_get_variant_bitrate().
+ * Takes effect from the next URI change on.
  */
-GstClockTime
-gst_player_get_position (GstPlayer * self)
+void
+gst_player_set_adaptive_bitrate_enabled (GstPlayer * self, gboolean enabled)
 {
-  GstClockTime val;
-
-  g_return_val_if_fail (GST_IS_PLAYER (self), GST_CLOCK_TIME_NONE);
-
-  g_object_get (self, "position", &val, NULL);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  return val;
+  g_object_set (self, "adaptive-bitrate", enabled, NULL);
 }
 
 /**
- * gst_player_get_duration:
+ * gst_player_get_adaptive_bitrate_enabled:
  * @player: #GstPlayer instance
  *
- * Retrieves the duration of the media stream that self represents.
- *
- * Returns: the duration of the currently-playing media stream, in
- * nanoseconds.
+ * Returns: %TRUE if the player selects the variant of adaptive streams.
  */
-GstClockTime
-gst_player_get_duration (GstPlayer * self)
+gboolean
+gst_player_get_adaptive_bitrate_enabled (GstPlayer * self)
 {
-  GstClockTime val;
+  gboolean val;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), GST_CLOCK_TIME_NONE);
+  g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  g_object_get (self, "duration", &val, NULL);
+  g_object_get (self, "adaptive-bitrate", &val, NULL);
 
   return val;
 }
 
 /**
- * gst_player_get_volume:
+ * gst_player_set_bitrate_limits:
  * @player: #GstPlayer instance
+ * @min_bitrate: lowest bitrate in bits per second
+ * @max_bitrate: highest bitrate in bits per second, 0 for no limit
  *
- * Returns the current volume level, as a percentage between 0 and 1.
+ * Limits the variants adaptive bitrate selection chooses from to the ones
+ * within @min_bitrate and @max_bitrate, as far as the stream has such.
+ * Playback starts at @min_bitrate.
+ */
+void
+gst_player_set_bitrate_limits (GstPlayer * self, guint min_bitrate,
+    guint max_bitrate)
+{
+  g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (max_bitrate == 0 || min_bitrate <= max_bitrate);
+
+  g_object_set (self, "min-bitrate", min_bitrate, "max-bitrate",
+      max_bitrate, NULL);
+}
+
+/**
+ * gst_player_get_bitrate_limits:
+ * @player: #GstPlayer instance
+ * @min_bitrate: (out) (allow-none): lowest bitrate in bits per second
+ * @max_bitrate: (out) (allow-none): highest bitrate in bits per second, 0
+ *   for no limit
  *
- * Returns: the volume as percentage between 0 and 1.
+ * Retrieves the limits set with gst_player_set_bitrate_limits().
  */
-gdouble
-gst_player_get_volume (GstPlayer * self)
+void
+gst_player_get_bitrate_limits (GstPlayer * self, guint * min_bitrate,
+    guint * max_bitrate)
 {
-  gdouble val;
+  guint min, max;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), 1.0);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_object_get (self, "volume", &val, NULL);
+  g_object_get (self, "min-bitrate", &min, "max-bitrate", &max, NULL);
 
-  return val;
+  if (min_bitrate)
+    *min_bitrate = min;
+  if (max_bitrate)
+    *max_bitrate = max;
 }
 
 /**
- * gst_player_set_volume:
+ * gst_player_set_low_latency_enabled:
  * @player: #GstPlayer instance
- * @val: the new volume level, as a percentage between 0 and 1
+ * @enabled: TRUE or FALSE
  *
- * Sets the volume level of the stream as a percentage between 0 and 1.
+ * Enables keeping live playback close to the live edge. The target latency
+ * is applied to the jitterbuffer of RTSP and other RTP sources, and the
+ * sinks drop buffers that arrive late instead of falling further behind.
+ * Live streams with a seekable window, like live HLS or DASH, are played
+ * slightly faster whenever they fell behind the target by too much.
+ *
+ * The delay is reported as "live-edge-delay" by gst_player_get_stats().
+ * Sources are configured from the next URI change on.
  */
 void
-gst_player_set_volume (GstPlayer * self, gdouble val)
+gst_player_set_low_latency_enabled (GstPlayer * self, gboolean enabled)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_object_set (self, "volume", val, NULL);
+  g_object_set (self, "low-latency", enabled, NULL);
 }
 
 /**
- * gst_player_get_mute:
+ * gst_player_get_low_latency_enabled:
  * @player: #GstPlayer instance
  *
- * Returns: %TRUE if the currently-playing stream is muted.
+ * Returns: %TRUE if live playback is kept close to the live edge.
  */
 gboolean
-gst_player_get_mute (GstPlayer * self)
+gst_player_get_low_latency_enabled (GstPlayer * self)
 {
   gboolean val;
 
   g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
 
-  g_object_get (self, "mute", &val, NULL);
+  g_object_get (self, "low-latency", &val, NULL);
 
   return val;
 }
 
 /**
- * gst_player_set_mute:
+ * gst_player_set_target_latency:
  * @player: #GstPlayer instance
- * @val: Mute state the should be set
+ * @latency: delay behind the live edge
  *
- * %TRUE if the currently-playing stream should be muted.
+ * Sets how far behind the live edge live playback is kept in low-latency
+ * mode. Defaults to 500 milliseconds.
  */
 void
-gst_player_set_mute (GstPlayer * self, gboolean val)
+gst_player_set_target_latency (GstPlayer * self, GstClockTime latency)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (latency));
 
-  g_object_set (self, "mute", val, NULL);
+  g_object_set (self, "target-latency", latency, NULL);
 }
 
 /**
- * gst_player_get_window_handle:
+ * gst_player_get_target_latency:
  * @player: #GstPlayer instance
  *
- * Returns: (transfer none): The currently set, platform specific window
- * handle
+ * Returns: the delay behind the live edge live playback is kept at in
+ *   low-latency mode.
  */
-gpointer
-gst_player_get_window_handle (GstPlayer * self)
+GstClockTime
+gst_player_get_target_latency (GstPlayer * self)
 {
-  gpointer val;
+  GstClockTime val;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_return_val_if_fail (GST_IS_PLAYER (self), GST_CLOCK_TIME_NONE);
 
-  g_object_get (self, "window-handle", &val, NULL);
+  g_object_get (self, "target-latency", &val, NULL);
 
   return val;
 }
 
 /**
- * gst_player_set_window_handle:
+ * gst_player_set_frame_cache_size:
  * @player: #GstPlayer instance
- * @val: handle referencing to the platform specific window
+ * @size: maximum size in bytes, 0 to disable
  *
- * Sets the platform specific window handle into which the video
- * should be rendered
- **/
+ * Sets how many bytes of decoded video frames are kept, so that stepping
+ * backward with gst_player_step() and seeks while paused can show them
+ * again without decoding. Frames are kept per GOP and the least recently
+ * used GOPs are dropped first, so this should fit a few GOPs of the
+ * media. Disabled by default.
+ */
 void
-gst_player_set_window_handle (GstPlayer * self, gpointer val)
+gst_player_set_frame_cache_size (GstPlayer * self, guint64 size)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_object_set (self, "window-handle", val, NULL);
+  g_object_set (self, "frame-cache-size", size, NULL);
 }
 
 /**
- * gst_player_get_pipeline:
+ * gst_player_get_frame_cache_size:
  * @player: #GstPlayer instance
  *
- * Returns: (transfer full): The internal playbin instance
+ * Returns: the maximum size of the frame cache in bytes, 0 if disabled.
  */
-GstElement *
-gst_player_get_pipeline (GstPlayer * self)
+guint64
+gst_player_get_frame_cache_size (GstPlayer * self)
 {
-  GstElement *val;
+  guint64 val;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
 
-  g_object_get (self, "pipeline", &val, NULL);
+  g_object_get (self, "frame-cache-size", &val, NULL);
 
   return val;
 }
 
 /**
- * gst_player_get_media_info:
+ * gst_player_get_stats:
  * @player: #GstPlayer instance
  *
- * A Function to get the current media info #GstPlayerMediaInfo instance.
+ * Retrieves counters of the current playback. Fields are only present if
+ * they are known:
  *
- * Returns: (transfer full): media info instance.
+ * - "bytes-read" (guint64): bytes handed out by the mmap source or the
+ *   HTTP cache
+ * - "page-faults" (guint64): pages of these bytes that were not cached
+ *   yet and had to be read from disk when accessed
+ * - "network-bytes" (guint64): bytes of these the HTTP cache had to
+ *   download
+ * - "bandwidth-estimate" (guint64): throughput in bits per second estimated
+ *   by adaptive bitrate selection
+ * - "live-edge-delay" (guint64): how far playback of live media is behind
+ *   the live edge, in nanoseconds
+ * - "frame-cache-hits" (guint64): steps and seeks while paused that showed
+ *   a frame from the frame cache
+ * - "frame-cache-misses" (guint64): those that had to decode the frame
+ * - "frame-cache-hit-rate" (gdouble): share of the hits, between 0 and 1
+ * - "shared-decode-players" (guint): players sharing the decoding of the
+ *   media, including this one
+ * - "shared-audio-output-players" (guint): players playing through the
+ *   shared audio output, including this one
+ * - "remote-transport-latency" (guint64): average time decoded buffers
+ *   take from the decoding process to the player, in nanoseconds
+ * - "clip-cache-hits" (guint64): clips played by the player that were
+ *   decoded already
+ * - "clip-cache-misses" (guint64): those that had to be decoded first
  *
- * The caller should free it with g_object_unref()
+ * Returns: (transfer full): a #GstStructure, free with gst_structure_free().
  */
-GstPlayerMediaInfo *
-gst_player_get_media_info (GstPlayer * self)
+GstStructure *
+gst_player_get_stats (GstPlayer * self)
 {
-  GstPlayerMediaInfo *info;
+  GstStructure *stats;
+  GstElement *source = NULL, *audio_sink = NULL;
+  guint64 bytes_read, page_faults, network_bytes, bandwidth;
+  guint64 frame_cache_hits, frame_cache_misses;
+  guint64 clip_cache_hits, clip_cache_misses;
+  GstClockTime live_edge_delay, transport_latency;
+  guint shared_players;
 
   g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
 
-  if (!self->media_info)
-    return NULL;
+  stats = gst_structure_new_empty ("GstPlayerStats");
+
+  g_object_get (self->playbin, "source", &source, NULL);
+  if (source) {
+    if (gst_player_mmap_src_get_stats (source, &bytes_read, &page_faults))
+      gst_structure_set (stats, "bytes-read", G_TYPE_UINT64, bytes_read,
+          "page-faults", G_TYPE_UINT64, page_faults, NULL);
+    else if (gst_player_http_cache_src_get_stats (source, &bytes_read,
+            &network_bytes))
+      gst_structure_set (stats, "bytes-read", G_TYPE_UINT64, bytes_read,
+          "network-bytes", G_TYPE_UINT64, network_bytes, NULL);
+    else if (gst_player_shared_src_get_stats (source, &shared_players))
+      gst_structure_set (stats, "shared-decode-players", G_TYPE_UINT,
+          shared_players, NULL);
+    else if (gst_player_remote_src_get_stats (source, &transport_latency)
+        && GST_CLOCK_TIME_IS_VALID (transport_latency))
+      gst_structure_set (stats, "remote-transport-latency", G_TYPE_UINT64,
+          transport_latency, NULL);
+    gst_object_unref (source);
+  }
+
+  g_object_get (self->playbin, "audio-sink", &audio_sink, NULL);
+  if (audio_sink) {
+    if (gst_player_audio_mixer_sink_get_stats (audio_sink, &shared_players))
+      gst_structure_set (stats, "shared-audio-output-players", G_TYPE_UINT,
+          shared_players, NULL);
+    gst_object_unref (audio_sink);
+  }
 
   g_mutex_lock (&self->lock);
-  info = gst_player_media_info_copy (self->media_info);
+  bandwidth = self->bandwidth_estimate;
+  live_edge_delay = self->live_edge_delay;
+  clip_cache_hits = self->clip_cache_hits;
+  clip_cache_misses = self->clip_cache_misses;
   g_mutex_unlock (&self->lock);
 
-  return info;
-}
+  gst_player_frame_cache_get_stats (self->frame_cache, &frame_cache_hits,
+      &frame_cache_misses);
+  if (frame_cache_hits + frame_cache_misses > 0)
+    gst_structure_set (stats, "frame-cache-hits", G_TYPE_UINT64,
+        frame_cache_hits, "frame-cache-misses", G_TYPE_UINT64,
+        frame_cache_misses, "frame-cache-hit-rate", G_TYPE_DOUBLE,
+        (gdouble) frame_cache_hits / (frame_cache_hits + frame_cache_misses),
+        NULL);
+  if (clip_cache_hits + clip_cache_misses > 0)
+    gst_structure_set (stats, "clip-cache-hits", G_TYPE_UINT64,
+        clip_cache_hits, "clip-cache-misses", G_TYPE_UINT64,
+        clip_cache_misses, NULL);
+  if (bandwidth > 0)
+    gst_structure_set (stats, "bandwidth-estimate", G_TYPE_UINT64,
+        bandwidth, NULL);
+  if (GST_CLOCK_TIME_IS_VALID (live_edge_delay))
+    gst_structure_set (stats, "live-edge-delay", G_TYPE_UINT64,
+        live_edge_delay, NULL);
+
+  return stats;
+}
+
+G_DEFINE_BOXED_TYPE (GstPlayerLoadRequest, gst_player_load_request,
+    (GBoxedCopyFunc) gst_player_load_request_copy,
+    (GBoxedFreeFunc) gst_player_load_request_free);
 
 /**
- * gst_player_get_current_audio_track:
- * @player: #GstPlayer instance
- *
- * A Function to get current audio #GstPlayerAudioInfo instance.
+ * gst_player_load_request_new:
+ * @uri: URI to play
  *
- * Returns: (transfer full): current audio track.
+ * Creates a new #GstPlayerLoadRequest for @uri. By default playback starts
+ * at the beginning, with the default tracks, at normal rate and playing.
  *
- * The caller should free it with g_object_unref()
+ * Returns: (transfer full): a new #GstPlayerLoadRequest, free with
+ * gst_player_load_request_free().
  */
-GstPlayerAudioInfo *
-gst_player_get_current_audio_track (GstPlayer * self)
+GstPlayerLoadRequest *
+gst_player_load_request_new (const gchar * uri)
 {
-  GstPlayerAudioInfo *info;
+  GstPlayerLoadRequest *request;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_return_val_if_fail (uri != NULL, NULL);
 
-  if (!is_track_enabled (self, GST_PLAY_FLAG_AUDIO))
-    return NULL;
+  request = g_new0 (GstPlayerLoadRequest, 1);
+  request->uri = g_strdup (uri);
+  request->start_position = GST_CLOCK_TIME_NONE;
+  request->rate = 1.0;
 
-  info = (GstPlayerAudioInfo *) gst_player_stream_info_get_current (self,
-      "current-audio", GST_TYPE_PLAYER_AUDIO_INFO);
-  return info;
+  return request;
 }
 
 /**
- * gst_player_get_current_video_track:
- * @player: #GstPlayer instance
- *
- * A Function to get current video #GstPlayerVideoInfo instance.
+ * gst_player_load_request_copy:
+ * @request: #GstPlayerLoadRequest instance
  *
- * Returns: (transfer full): current video track.
+ * Makes a copy of the #GstPlayerLoadRequest. The result must be
+ * freed using gst_player_load_request_free().
  *
- * The caller should free it with g_object_unref()
+ * Returns: (transfer full): an allocated copy of @request.
  */
-GstPlayerVideoInfo *
-gst_player_get_current_video_track (GstPlayer * self)
+GstPlayerLoadRequest *
+gst_player_load_request_copy (const GstPlayerLoadRequest * request)
 {
-  GstPlayerVideoInfo *info;
+  GstPlayerLoadRequest *ret;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_return_val_if_fail (request != NULL, NULL);
 
-  if (!is_track_enabled (self, GST_PLAY_FLAG_VIDEO))
-    return NULL;
+  ret = g_new0 (GstPlayerLoadRequest, 1);
+  ret->uri = g_strdup (request->uri);
+  ret->suburi = g_strdup (request->suburi);
+  ret->start_position = request->start_position;
+  ret->audio_language = g_strdup (request->audio_language);
+  ret->subtitle_language = g_strdup (request->subtitle_language);
+  ret->rate = request->rate;
+  ret->paused = request->paused;
 
-  info = (GstPlayerVideoInfo *) gst_player_stream_info_get_current (self,
-      "current-video", GST_TYPE_PLAYER_VIDEO_INFO);
-  return info;
+  return ret;
 }
 
 /**
- * gst_player_get_current_subtitle_track:
- * @player: #GstPlayer instance
- *
- * A Function to get current subtitle #GstPlayerSubtitleInfo instance.
- *
- * Returns: (transfer none): current subtitle track.
+ * gst_player_load_request_free:
+ * @request: #GstPlayerLoadRequest instance
  *
- * The caller should free it with g_object_unref()
+ * Frees a #GstPlayerLoadRequest.
  */
-GstPlayerSubtitleInfo *
-gst_player_get_current_subtitle_track (GstPlayer * self)
+void
+gst_player_load_request_free (GstPlayerLoadRequest * request)
 {
-  GstPlayerSubtitleInfo *info;
+  g_return_if_fail (request != NULL);
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_free (request->uri);
+  g_free (request->suburi);
+  g_free (request->audio_language);
+  g_free (request->subtitle_language);
+  g_free (request);
+}
 
-  if (!is_track_enabled (self, GST_PLAY_FLAG_SUBTITLE))
-    return NULL;
+/**
+ * gst_player_load_request_set_subtitle_uri:
+ * @request: #GstPlayerLoadRequest instance
+ * @suburi: (allow-none): external subtitle URI
+ *
+ * Sets the external subtitle to load together with the media.
+ */
+void
+gst_player_load_request_set_subtitle_uri (GstPlayerLoadRequest * request,
+    const gchar * suburi)
+{
+  g_return_if_fail (request != NULL);
 
-  info = (GstPlayerSubtitleInfo *) gst_player_stream_info_get_current (self,
-      "current-text", GST_TYPE_PLAYER_SUBTITLE_INFO);
-  return info;
+  g_free (request->suburi);
+  request->suburi = g_strdup (suburi);
 }
 
 /**
- * gst_player_set_audio_track:
- * @player: #GstPlayer instance
- * @stream_index: stream index
- *
- * Returns: %TRUE or %FALSE
+ * gst_player_load_request_set_start_position:
+ * @request: #GstPlayerLoadRequest instance
+ * @position: position to start at, or %GST_CLOCK_TIME_NONE
  *
- * Sets the audio track @stream_idex.
+ * Sets the position playback starts at. It takes precedence over a
+ * position remembered by the resume store.
  */
-gboolean
-gst_player_set_audio_track (GstPlayer * self, gint stream_index)
+void
+gst_player_load_request_set_start_position (GstPlayerLoadRequest * request,
+    GstClockTime position)
 {
-  GstPlayerStreamInfo *info;
+  g_return_if_fail (request != NULL);
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+  request->start_position = position;
+}
 
-  g_mutex_lock (&self->lock);
-  info = gst_player_stream_info_find (self, self->media_info,
-      GST_TYPE_PLAYER_AUDIO_INFO, stream_index);
-  g_mutex_unlock (&self->lock);
-  if (!info) {
-    GST_ERROR_OBJECT (self, "invalid audio stream index %d", stream_index);
-    return FALSE;
-  }
+/**
+ * gst_player_load_request_set_audio_language:
+ * @request: #GstPlayerLoadRequest instance
+ * @language: (allow-none): ISO 639 language code or language name
+ *
+ * Sets the language of the audio track to select. If no track has this
+ * language the default track is played.
+ */
+void
+gst_player_load_request_set_audio_language (GstPlayerLoadRequest * request,
+    const gchar * language)
+{
+  g_return_if_fail (request != NULL);
 
-  g_object_set (G_OBJECT (self->playbin), "current-audio", stream_index, NULL);
-  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
-  return TRUE;
+  g_free (request->audio_language);
+  request->audio_language = g_strdup (language);
 }
 
 /**
- * gst_player_set_video_track:
- * @player: #GstPlayer instance
- * @stream_index: stream index
- *
- * Returns: %TRUE or %FALSE
+ * gst_player_load_request_set_subtitle_language:
+ * @request: #GstPlayerLoadRequest instance
+ * @language: (allow-none): ISO 639 language code or language name
  *
- * Sets the video track @stream_index.
+ * Sets the language of the subtitle track to select. If no track has this
+ * language the default track is shown.
  */
-gboolean
-gst_player_set_video_track (GstPlayer * self, gint stream_index)
+void
+gst_player_load_request_set_subtitle_language (GstPlayerLoadRequest *
+    request, const gchar * language)
 {
-  GstPlayerStreamInfo *info;
+  g_return_if_fail (request != NULL);
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+  g_free (request->subtitle_language);
+  request->subtitle_language = g_strdup (language);
+}
 
-  /* check if stream_index exist in our internal media_info list */
-  g_mutex_lock (&self->lock);
-  info = gst_player_stream_info_find (self, self->media_info,
-      GST_TYPE_PLAYER_VIDEO_INFO, stream_index);
-  g_mutex_unlock (&self->lock);
-  if (!info) {
-    GST_ERROR_OBJECT (self, "invalid video stream index %d", stream_index);
-    return FALSE;
-  }
+/**
+ * gst_player_load_request_set_rate:
+ * @request: #GstPlayerLoadRequest instance
+ * @rate: initial playback rate
+ *
+ * Sets the rate playback starts with.
+ */
+void
+gst_player_load_request_set_rate (GstPlayerLoadRequest * request, gdouble rate)
+{
+  g_return_if_fail (request != NULL);
+  g_return_if_fail (rate != 0.0);
 
-  g_object_set (G_OBJECT (self->playbin), "current-video", stream_index, NULL);
-  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
-  return TRUE;
+  request->rate = rate;
 }
 
 /**
- * gst_player_set_subtitle_track:
- * @player: #GstPlayer instance
- * @stream_index: stream index
- *
- * Returns: %TRUE or %FALSE
+ * gst_player_load_request_set_paused:
+ * @request: #GstPlayerLoadRequest instance
+ * @paused: %TRUE to stay paused after loading
  *
- * Sets the subtitle strack @stream_index.
+ * Sets whether the media is only prerolled or played after loading.
  */
-gboolean
-gst_player_set_subtitle_track (GstPlayer * self, gint stream_index)
+void
+gst_player_load_request_set_paused (GstPlayerLoadRequest * request,
+    gboolean paused)
 {
-  GstPlayerStreamInfo *info;
+  g_return_if_fail (request != NULL);
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), 0);
+  request->paused = paused;
+}
+
+static gboolean
+gst_player_load_internal (gpointer user_data)
+{
+  GstPlayer *self = user_data;
+  GstPlayerLoadRequest *request;
 
   g_mutex_lock (&self->lock);
-  info = gst_player_stream_info_find (self, self->media_info,
-      GST_TYPE_PLAYER_SUBTITLE_INFO, stream_index);
+  request = self->load_request;
+  self->load_request = NULL;
   g_mutex_unlock (&self->lock);
-  if (!info) {
-    GST_ERROR_OBJECT (self, "invalid subtitle stream index %d", stream_index);
-    return FALSE;
+
+  /* Replaced by a later request or URI change */
+  if (!request)
+    return G_SOURCE_REMOVE;
+
+  gst_player_set_uri_internal (self);
+
+  g_mutex_lock (&self->lock);
+  self->suburi = g_strdup (request->suburi);
+  g_mutex_unlock (&self->lock);
+
+  gst_player_update_subtitle_index (self, request->suburi);
+  set_playbin_suburi (self);
+
+  /* Everything below is applied by the pending seek right after the first
+   * preroll, before anything is played or a position is reported */
+  g_mutex_lock (&self->lock);
+  self->rate = request->rate;
+  if (GST_CLOCK_TIME_IS_VALID (request->start_position)) {
+    self->seek_position = request->start_position;
+    self->seek_flags = 0;
+  } else if (request->rate != 1.0
+      && !GST_CLOCK_TIME_IS_VALID (self->seek_position)) {
+    self->seek_position = 0;
   }
+  g_mutex_unlock (&self->lock);
 
-  g_object_set (G_OBJECT (self->playbin), "current-text", stream_index, NULL);
-  GST_DEBUG_OBJECT (self, "set stream index '%d'", stream_index);
-  return TRUE;
+  if (request->paused)
+    gst_player_pause_internal (self);
+  else
+    gst_player_play_internal (self);
+
+  gst_player_load_request_free (request);
+
+  return G_SOURCE_REMOVE;
 }
 
 /**
- * gst_player_set_audio_track_enabled:
+ * gst_player_load:
  * @player: #GstPlayer instance
- * @enabled: TRUE or FALSE
+ * @request: #GstPlayerLoadRequest describing what to play
  *
- * Enable or disable the current audio track.
+ * Loads the media of @request and starts it as described by @request.
+ *
+ * Compared to setting the URI, seeking, switching tracks and changing the
+ * rate after the media was loaded, the preferred tracks are selected as
+ * soon as the streams are known while prerolling. The start position and
+ * the rate are applied by a single seek right after the first preroll,
+ * before anything is played or a position is reported. Only the data of
+ * that first preroll at the beginning of the media is decoded in vain.
  */
 void
-gst_player_set_audio_track_enabled (GstPlayer * self, gboolean enabled)
+gst_player_load (GstPlayer * self, const GstPlayerLoadRequest * request)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (request != NULL);
 
-  if (enabled)
-    player_set_flag (self, GST_PLAY_FLAG_AUDIO);
-  else
-    player_clear_flag (self, GST_PLAY_FLAG_AUDIO);
+  g_mutex_lock (&self->lock);
+  g_free (self->uri);
+  self->uri = g_strdup (request->uri);
+  GST_DEBUG_OBJECT (self, "Load uri=%s", self->uri);
+
+  if (self->load_request)
+    gst_player_load_request_free (self->load_request);
+  self->load_request = gst_player_load_request_copy (request);
+
+  g_free (self->audio_language);
+  self->audio_language = g_strdup (request->audio_language);
+  g_free (self->subtitle_language);
+  self->subtitle_language = g_strdup (request->subtitle_language);
+  drop_media_bytes_locked (self);
+  g_mutex_unlock (&self->lock);
 
-  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_player_load_internal, self, NULL);
+}
+
+static void
+set_media_bytes (GstPlayer * self, GstPlayerMediaBytes * media)
+{
+  g_mutex_lock (&self->lock);
+  if (self->media_bytes)
+    gst_player_media_bytes_unref (self->media_bytes);
+  self->media_bytes = media;
+  g_mutex_unlock (&self->lock);
+
+  gst_player_set_uri (self, gst_player_media_bytes_get_uri (media));
 }
 
 /**
- * gst_player_set_video_track_enabled:
+ * gst_player_set_uri_from_bytes:
  * @player: #GstPlayer instance
- * @enabled: TRUE or FALSE
+ * @bytes: the complete media
  *
- * Enable or disable the current video track.
+ * Sets media that is held in memory as the next URI to play. The memory
+ * of @bytes is played directly without copying it, and seeking works as
+ * for local files. @bytes is kept alive until it is not played anymore.
+ *
+ * gst_player_get_uri() returns an internal URI for the media afterwards,
+ * which is only valid as long as the media is the current URI.
  */
 void
-gst_player_set_video_track_enabled (GstPlayer * self, gboolean enabled)
+gst_player_set_uri_from_bytes (GstPlayer * self, GBytes * bytes)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
+  g_return_if_fail (bytes != NULL);
 
-  if (enabled)
-    player_set_flag (self, GST_PLAY_FLAG_VIDEO);
-  else
-    player_clear_flag (self, GST_PLAY_FLAG_VIDEO);
-
-  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
+  set_media_bytes (self, gst_player_media_bytes_new (bytes));
 }
 
 /**
- * gst_player_set_subtitle_track_enabled:
+ * gst_player_set_uri_from_stream:
  * @player: #GstPlayer instance
- * @enabled: TRUE or FALSE
  *
- * Enable or disable the current subtitle track.
+ * Sets media that the application provides in chunks with
+ * gst_player_push_bytes() as the next URI to play. Pushing can start
+ * right away, chunks are queued until playback reads them, and ends with
+ * gst_player_end_of_bytes().
+ *
+ * The data is not kept once it was played, so the media is not seekable
+ * and can only be played once.
  */
 void
-gst_player_set_subtitle_track_enabled (GstPlayer * self, gboolean enabled)
+gst_player_set_uri_from_stream (GstPlayer * self)
 {
   g_return_if_fail (GST_IS_PLAYER (self));
 
-  if (enabled)
-    player_set_flag (self, GST_PLAY_FLAG_SUBTITLE);
-  else
-    player_clear_flag (self, GST_PLAY_FLAG_SUBTITLE);
-
-  GST_DEBUG_OBJECT (self, "track is '%s'", enabled ? "Enabled" : "Disabled");
+  set_media_bytes (self, gst_player_media_bytes_new_stream ());
 }
 
 /**
- * gst_player_set_subtitle_uri:
+ * gst_player_push_bytes:
  * @player: #GstPlayer instance
- * @uri: subtitle URI
+ * @bytes: the next chunk of the media
  *
- * Returns: %TRUE or %FALSE
+ * Appends @bytes to the media set with gst_player_set_uri_from_stream().
+ * The memory is played without copying it and released once it was read.
  *
- * Sets the external subtitle URI.
+ * Returns: %TRUE if @bytes was queued, %FALSE if the current URI is not
+ * a stream or the stream was ended already.
  */
 gboolean
-gst_player_set_subtitle_uri (GstPlayer * self, const gchar * suburi)
+gst_player_push_bytes (GstPlayer * self, GBytes * bytes)
 {
+  GstPlayerMediaBytes *media = NULL;
+  gboolean ret = FALSE;
+
   g_return_val_if_fail (GST_IS_PLAYER (self), FALSE);
-  g_return_val_if_fail (suburi != NULL, FALSE);
+  g_return_val_if_fail (bytes != NULL, FALSE);
 
   g_mutex_lock (&self->lock);
-  if (self->suburi)
-    g_free (self->suburi);
-  self->suburi = g_strdup (suburi);
+  if (self->media_bytes)
+    media = gst_player_media_bytes_ref (self->media_bytes);
   g_mutex_unlock (&self->lock);
 
-  gst_player_set_suburi_internal (self);
+  if (media) {
+    ret = gst_player_media_bytes_push (media, bytes);
+    gst_player_media_bytes_unref (media);
+  }
 
-  return TRUE;
+  return ret;
 }
 
 /**
- * gst_player_get_subtitle_uri:
+ * gst_player_end_of_bytes:
  * @player: #GstPlayer instance
  *
- * current subtitle URI
- *
- * Returns: (transfer full): URI of the current external subtitle.
- *   g_free() after usage.
+ * Signals that all chunks of the media set with
+ * gst_player_set_uri_from_stream() were pushed. Playback reaches the end
+ * of stream once the queued chunks are played.
  */
-gchar *
-gst_player_get_subtitle_uri (GstPlayer * self)
+void
+gst_player_end_of_bytes (GstPlayer * self)
 {
-  gchar *val = NULL;
+  GstPlayerMediaBytes *media = NULL;
 
-  g_return_val_if_fail (GST_IS_PLAYER (self), NULL);
+  g_return_if_fail (GST_IS_PLAYER (self));
 
-  g_object_get (self, "suburi", &val, NULL);
+  g_mutex_lock (&self->lock);
+  if (self->media_bytes)
+    media = gst_player_media_bytes_ref (self->media_bytes);
+  g_mutex_unlock (&self->lock);
 
-  return val;
+  if (media) {
+    gst_player_media_bytes_end (media);
+    gst_player_media_bytes_unref (media);
+  }
 }
 
 G_DEFINE_BOXED_TYPE (GstPlayerVisualization, gst_player_visualization,
@@ -23,6 +23,7 @@
 
 #include <gst/gst.h>
 #include <gst/player/gstplayer-media-info.h>
+#include <gst/player/gstplayer-subtitle-index.h>
 
 G_BEGIN_DECLS
 
@@ -83,10 +84,32 @@ void         gst_player_stop                          (GstPlayer    * player);
 
 void         gst_player_seek                          (GstPlayer    * player,
                                                        GstClockTime   position);
+
+gboolean     gst_player_seek_chapter                  (GstPlayer    * player,
+                                                       guint index);
+gboolean     gst_player_seek_next_chapter             (GstPlayer    * player);
+gboolean     gst_player_seek_previous_chapter         (GstPlayer    * player);
+
+void         gst_player_scrub_begin                   (GstPlayer    * player);
+void         gst_player_scrub_update                  (GstPlayer    * player,
+                                                       GstClockTime   position);
+void         gst_player_scrub_end                     (GstPlayer    * player);
+
 void         gst_player_set_rate                      (GstPlayer    * player,
                                                        gdouble        rate);
 gdouble      gst_player_get_rate                      (GstPlayer    * player);
 
+void         gst_player_set_loop                      (GstPlayer    * player,
+                                                       GstClockTime   start,
+                                                       GstClockTime   end);
+void         gst_player_unset_loop                    (GstPlayer    * player);
+gboolean     gst_player_get_loop                      (GstPlayer    * player,
+                                                       GstClockTime * start,
+                                                       GstClockTime * end);
+
+void         gst_player_step                          (GstPlayer    * player,
+                                                       gint           n_frames);
+
 gboolean     gst_player_get_dispatch_to_main_context  (GstPlayer    * player);
 void         gst_player_set_dispatch_to_main_context  (GstPlayer    * player,
                                                        gboolean       val);
@@ -95,6 +118,50 @@ gchar *      gst_player_get_uri                       (GstPlayer    * player);
 void         gst_player_set_uri                       (GstPlayer    * player,
                                                        const gchar  * uri);
 
+/**
+ * GstPlayerLoadRequest:
+ *
+ * Describes media to load with gst_player_load(): the URI, an external
+ * subtitle, the start position, preferred track languages, the initial
+ * rate and whether to start paused.
+ */
+typedef struct _GstPlayerLoadRequest GstPlayerLoadRequest;
+
+GType        gst_player_load_request_get_type         (void);
+#define      GST_TYPE_PLAYER_LOAD_REQUEST             (gst_player_load_request_get_type ())
+
+GstPlayerLoadRequest *
+             gst_player_load_request_new              (const gchar  * uri);
+GstPlayerLoadRequest *
+             gst_player_load_request_copy             (const GstPlayerLoadRequest * request);
+void         gst_player_load_request_free             (GstPlayerLoadRequest * request);
+
+void         gst_player_load_request_set_subtitle_uri (GstPlayerLoadRequest * request,
+                                                       const gchar  * suburi);
+void         gst_player_load_request_set_start_position
+                                                      (GstPlayerLoadRequest * request,
+                                                       GstClockTime   position);
+void         gst_player_load_request_set_audio_language
+                                                      (GstPlayerLoadRequest * request,
+                                                       const gchar  * language);
+void         gst_player_load_request_set_subtitle_language
+                                                      (GstPlayerLoadRequest * request,
+                                                       const gchar  * language);
+void         gst_player_load_request_set_rate         (GstPlayerLoadRequest * request,
+                                                       gdouble        rate);
+void         gst_player_load_request_set_paused       (GstPlayerLoadRequest * request,
+                                                       gboolean       paused);
+
+void         gst_player_load                          (GstPlayer    * player,
+                                                       const GstPlayerLoadRequest * request);
+
+void         gst_player_set_uri_from_bytes            (GstPlayer    * player,
+                                                       GBytes       * bytes);
+void         gst_player_set_uri_from_stream           (GstPlayer    * player);
+gboolean     gst_player_push_bytes                    (GstPlayer    * player,
+                                                       GBytes       * bytes);
+void         gst_player_end_of_bytes                  (GstPlayer    * player);
+
 GstClockTime gst_player_get_position                  (GstPlayer    * player);
 GstClockTime gst_player_get_duration                  (GstPlayer    * player);
 
@@ -145,6 +212,76 @@ gboolean     gst_player_set_subtitle_uri              (GstPlayer    * player,
                                                        const gchar *uri);
 gchar *      gst_player_get_subtitle_uri              (GstPlayer    * player);
 
+GstPlayerSubtitleIndex *
+             gst_player_get_subtitle_index            (GstPlayer    * player);
+
+void         gst_player_discover_async                (GstPlayer    * player,
+                                                       const gchar *uri);
+
+void         gst_player_request_cover_art             (GstPlayer    * player,
+                                                       GstPlayerMediaInfo * info,
+                                                       gint max_width,
+                                                       gint max_height);
+
+void         gst_player_set_seamless_track_switch     (GstPlayer    * player,
+                                                       gboolean enabled);
+gboolean     gst_player_get_seamless_track_switch     (GstPlayer    * player);
+
+void         gst_player_set_keyframe_index_enabled    (GstPlayer    * player,
+                                                       gboolean enabled);
+gboolean     gst_player_get_keyframe_index_enabled    (GstPlayer    * player);
+
+void         gst_player_set_resume_store_enabled      (GstPlayer    * player,
+                                                       gboolean enabled);
+gboolean     gst_player_get_resume_store_enabled      (GstPlayer    * player);
+
+void         gst_player_set_mmap_source_enabled       (GstPlayer    * player,
+                                                       gboolean enabled);
+gboolean     gst_player_get_mmap_source_enabled       (GstPlayer    * player);
+
+void         gst_player_set_http_cache_size           (GstPlayer    * player,
+                                                       guint64        size);
+guint64      gst_player_get_http_cache_size           (GstPlayer    * player);
+
+void         gst_player_set_shared_decode_enabled     (GstPlayer    * player,
+                                                       gboolean       enabled);
+gboolean     gst_player_get_shared_decode_enabled     (GstPlayer    * player);
+
+void         gst_player_set_remote_decode_enabled     (GstPlayer    * player,
+                                                       gboolean       enabled);
+gboolean     gst_player_get_remote_decode_enabled     (GstPlayer    * player);
+
+void         gst_player_set_shared_audio_output_enabled
+                                                      (GstPlayer    * player,
+                                                       gboolean       enabled);
+gboolean     gst_player_get_shared_audio_output_enabled
+                                                      (GstPlayer    * player);
+
+void         gst_player_play_clip                     (GstPlayer    * player,
+                                                       const gchar  * uri);
+
+void         gst_player_set_adaptive_bitrate_enabled  (GstPlayer    * player,
+                                                       gboolean enabled);
+gboolean     gst_player_get_adaptive_bitrate_enabled  (GstPlayer    * player);
+void         gst_player_set_bitrate_limits            (GstPlayer    * player,
+                                                       guint          min_bitrate,
+                                                       guint          max_bitrate);
+void         gst_player_get_bitrate_limits            (GstPlayer    * player,
+                                                       guint        * min_bitrate,
+                                                       guint        * max_bitrate);
+
+void         gst_player_set_low_latency_enabled       (GstPlayer    * player,
+                                                       gboolean enabled);
+gboolean     gst_player_get_low_latency_enabled       (GstPlayer    * player);
+void         gst_player_set_target_latency            (GstPlayer    * player,
+                                                       GstClockTime   latency);
+GstClockTime gst_player_get_target_latency            (GstPlayer    * player);
+void         gst_player_set_frame_cache_size          (GstPlayer    * player,
+                                                       guint64        size);
+guint64      gst_player_get_frame_cache_size          (GstPlayer    * player);
+
+GstStructure * gst_player_get_stats                   (GstPlayer    * player);
+
 gboolean     gst_player_set_visualization             (GstPlayer    * player,
                                                        const gchar *name);
 
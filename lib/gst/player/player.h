@@ -23,5 +23,9 @@
 
 #include <gst/player/gstplayer.h>
 #include <gst/player/gstplayer-media-info.h>
+#include <gst/player/gstplayer-subtitle-index.h>
+#include <gst/player/gstplayer-playlist.h>
+#include <gst/player/gstplayer-group.h>
+#include <gst/player/gstplayer-mosaic.h>
 
 #endif /* __PLAYER_H__ */
@@ -60,6 +60,14 @@ G_STMT_START {                                                          \
 } G_STMT_END;
 
 #include <gst/player/gstplayer.h>
+#include <gst/player/gstplayer-playlist.h>
+#include <gst/player/gstplayer-group.h>
+#include <gst/tag/tag.h>
+#include <gst/video/video.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include "gst-play-scan.h"
 
 GST_DEBUG_CATEGORY_STATIC (test_debug);
 #define GST_CAT_DEFAULT test_debug
@@ -758,6 +766,113 @@ START_TEST (test_play_stream_selection)
 
 END_TEST;
 
+typedef struct
+{
+  TestPlayerState *state;
+  gint index;
+  gint64 requested;
+} TrackSwitchArgs;
+
+static void
+track_switched_cb (GstPlayer * player, GstPlayerStreamInfo * info,
+    GstClockTime latency, TrackSwitchArgs * args)
+{
+  GstClockTime elapsed;
+
+  elapsed = (g_get_monotonic_time () - args->requested) * GST_USECOND;
+
+  fail_unless_equals_string (gst_player_stream_info_get_stream_type (info),
+      "audio");
+  fail_unless_equals_int (gst_player_stream_info_get_index (info),
+      args->index);
+
+  /* Measured from the request on, which happened before the switch */
+  fail_unless (GST_CLOCK_TIME_IS_VALID (latency));
+  fail_unless (latency > 0);
+  fail_unless (latency <= elapsed);
+
+  args->state->test_data = GINT_TO_POINTER (2);
+  g_main_loop_quit (args->state->loop);
+}
+
+static void
+test_play_track_switched_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+
+  if (new_state->state == GST_PLAYER_STATE_PLAYING && step == 0) {
+    TrackSwitchArgs *args = g_object_get_data (G_OBJECT (player), "args");
+    GstPlayerMediaInfo *media_info;
+    GstPlayerAudioInfo *current;
+    GList *l;
+
+    media_info = gst_player_get_media_info (player);
+    current = gst_player_get_current_audio_track (player);
+    fail_unless (current != NULL);
+
+    for (l = gst_player_get_audio_streams (media_info); l; l = l->next) {
+      gint index = gst_player_stream_info_get_index (l->data);
+
+      if (index != gst_player_stream_info_get_index ((GstPlayerStreamInfo *)
+              current)) {
+        args->index = index;
+        break;
+      }
+    }
+    fail_unless (l != NULL);
+
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    args->requested = g_get_monotonic_time ();
+    fail_unless (gst_player_set_audio_track (player, args->index));
+
+    g_object_unref (current);
+    g_object_unref (media_info);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_play_track_switched)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  TrackSwitchArgs args;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_play_track_switched_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+  fail_unless (player != NULL);
+
+  memset (&args, 0, sizeof (args));
+  args.state = &state;
+  g_object_set_data (G_OBJECT (player), "args", &args);
+  g_signal_connect (player, "track-switched", G_CALLBACK (track_switched_cb),
+      &args);
+
+  gst_player_set_seamless_track_switch (player, TRUE);
+
+  uri = gst_filename_to_uri (TEST_PATH "/sintel.mkv", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
 typedef struct DisableStreamArgs
 {
   GstPlayer *player;
@@ -1071,47 +1186,2643 @@ START_TEST (test_play_error_invalid_uri_and_play)
 
 END_TEST;
 
-static Suite *
-player_suite (void)
+static void
+post_test_toc (GstPlayer * player)
 {
-  Suite *s = suite_create ("GstPlayer");
+  GstElement *pipeline;
+  GstTocEntry *edition;
+  GstToc *toc;
+  gint i;
+
+  toc = gst_toc_new (GST_TOC_SCOPE_GLOBAL);
+  edition = gst_toc_entry_new (GST_TOC_ENTRY_TYPE_EDITION, "edition");
+
+  /* Out of order on purpose, chapters must be sorted by start time */
+  for (i = 2; i >= 0; i--) {
+    GstTocEntry *chapter;
+    gchar *id, *title;
+
+    id = g_strdup_printf ("chapter%d", i);
+    title = g_strdup_printf ("Chapter %d", i);
+    chapter = gst_toc_entry_new (GST_TOC_ENTRY_TYPE_CHAPTER, id);
+    gst_toc_entry_set_start_stop_times (chapter, i * GST_SECOND,
+        i < 2 ? (i + 1) * GST_SECOND : -1);
+    gst_toc_entry_set_tags (chapter, gst_tag_list_new (GST_TAG_TITLE, title,
+            NULL));
+    gst_toc_entry_append_sub_entry (edition, chapter);
+    g_free (id);
+    g_free (title);
+  }
+  gst_toc_append_entry (toc, edition);
 
-  TCase *tc_general = tcase_create ("general");
+  pipeline = gst_player_get_pipeline (player);
+  gst_element_post_message (pipeline,
+      gst_message_new_toc (GST_OBJECT (pipeline), toc, FALSE));
+  gst_object_unref (pipeline);
+  gst_toc_unref (toc);
+}
 
-  tcase_set_timeout (tc_general, 120);
-  tcase_add_test (tc_general, test_create_and_free);
-  tcase_add_test (tc_general, test_set_and_get_uri);
-  tcase_add_test (tc_general, test_play_audio_eos);
-  tcase_add_test (tc_general, test_play_audio_video_eos);
-  tcase_add_test (tc_general, test_play_error_invalid_uri);
-  tcase_add_test (tc_general, test_play_error_invalid_uri_and_play);
-  tcase_add_test (tc_general, test_play_media_info);
-  tcase_add_test (tc_general, test_play_stream_selection);
-  tcase_add_test (tc_general, test_play_stream_disable_enable);
+static void
+test_play_chapters_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+  GstPlayerMediaInfo *media_info = new_state->media_info;
+  GstClockTime start, stop;
+  const gchar *title;
+
+  if (change == STATE_CHANGE_MEDIA_INFO_UPDATED && step == 0) {
+    post_test_toc (player);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+  } else if (change == STATE_CHANGE_MEDIA_INFO_UPDATED && step == 1
+      && gst_player_media_info_get_n_chapters (media_info) > 0) {
+    fail_unless_equals_int (gst_player_media_info_get_n_chapters (media_info),
+        3);
+
+    fail_unless (gst_player_media_info_get_chapter (media_info, 1, &start,
+            &stop, &title));
+    fail_unless_equals_uint64 (start, GST_SECOND);
+    fail_unless_equals_uint64 (stop, 2 * GST_SECOND);
+    fail_unless_equals_string (title, "Chapter 1");
+    fail_if (gst_player_media_info_get_chapter (media_info, 3, NULL, NULL,
+            NULL));
+
+    fail_unless_equals_int (gst_player_media_info_get_chapter_at_position
+        (media_info, 0), 0);
+    fail_unless_equals_int (gst_player_media_info_get_chapter_at_position
+        (media_info, 1500 * GST_MSECOND), 1);
+    fail_unless_equals_int (gst_player_media_info_get_chapter_at_position
+        (media_info, 2 * GST_SECOND), 2);
+
+    fail_unless (gst_player_seek_chapter (player, 2));
+    fail_if (gst_player_seek_chapter (player, 3));
+
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
 
-  suite_add_tcase (s, tc_general);
+START_TEST (test_play_chapters)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
 
-  return s;
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_play_chapters_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
 }
 
-int
-main (int argc, char **argv)
+END_TEST;
+
+static void
+test_play_keyframe_index_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
 {
-  int number_failed;
-  Suite *s;
-  SRunner *sr;
+  const GstClockTime *keyframes;
+  guint i, n_keyframes;
 
-  gst_init (NULL, NULL);
+  if (change == STATE_CHANGE_MEDIA_INFO_UPDATED) {
+    keyframes = gst_player_media_info_get_keyframes (new_state->media_info,
+        &n_keyframes);
+    if (!keyframes)
+      return;
+
+    fail_unless (n_keyframes > 0);
+    for (i = 1; i < n_keyframes; i++)
+      fail_unless (keyframes[i - 1] < keyframes[i]);
+
+    fail_unless_equals_uint64 (gst_player_media_info_get_nearest_keyframe
+        (new_state->media_info, keyframes[n_keyframes - 1] + GST_SECOND),
+        keyframes[n_keyframes - 1]);
+    fail_unless_equals_uint64 (gst_player_media_info_get_nearest_keyframe
+        (new_state->media_info, keyframes[0]), keyframes[0]);
+
+    new_state->test_data = GINT_TO_POINTER (1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
 
-  GST_DEBUG_CATEGORY_INIT (test_debug, "test", 0, "GstPlayer test");
+START_TEST (test_play_keyframe_index)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
 
-  s = player_suite ();
-  sr = srunner_create (s);
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_play_keyframe_index_cb;
+  state.test_data = GINT_TO_POINTER (0);
 
-  srunner_run_all (sr, CK_NORMAL);
+  player = test_player_new (&state);
 
-  number_failed = srunner_ntests_failed (sr);
+  fail_unless (player != NULL);
+
+  gst_player_set_keyframe_index_enabled (player, TRUE);
+  fail_unless (gst_player_get_keyframe_index_enabled (player));
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_play_scrub_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+
+  if (change == STATE_CHANGE_STATE_CHANGED && step == 0
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    gst_player_scrub_begin (player);
+    gst_player_scrub_update (player, 500 * GST_MSECOND);
+    gst_player_scrub_update (player, GST_SECOND);
+    gst_player_scrub_update (player, 2 * GST_SECOND);
+    gst_player_scrub_end (player);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+  } else if (change == STATE_CHANGE_POSITION_UPDATED && step == 1
+      && new_state->position >= 1500 * GST_MSECOND) {
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_play_scrub)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_play_scrub_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_discover_cb (GstPlayer * player, const gchar * uri,
+    GstPlayerMediaInfo * info, TestPlayerState * state)
+{
+  if (info)
+    state->media_info = g_object_ref (info);
+  g_main_loop_quit (state->loop);
+}
+
+static void
+test_discover_check_media_info (GstPlayerMediaInfo * info, const gchar * uri)
+{
+  fail_unless (info != NULL);
+  fail_unless_equals_string (gst_player_media_info_get_uri (info), uri);
+  fail_unless (gst_player_media_info_is_playable (info));
+  fail_unless (gst_player_media_info_is_seekable (info));
+  fail_unless (GST_CLOCK_TIME_IS_VALID (gst_player_media_info_get_duration
+          (info)));
+  fail_unless_equals_int (g_list_length
+      (gst_player_get_audio_streams (info)), 1);
+  fail_unless_equals_int (g_list_length
+      (gst_player_get_video_streams (info)), 1);
+  fail_unless_equals_int (g_list_length
+      (gst_player_get_subtitle_streams (info)), 0);
+}
+
+START_TEST (test_discover)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  GstClockTime duration = GST_CLOCK_TIME_NONE;
+  gchar *uri;
+  gint i;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+
+  player = gst_player_new ();
+  fail_unless (player != NULL);
+  g_object_set (player, "dispatch-to-main-context", TRUE, NULL);
+  g_signal_connect (player, "media-info-discovered",
+      G_CALLBACK (test_discover_cb), &state);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+
+  /* The second time the media info comes from the cache */
+  for (i = 0; i < 2; i++) {
+    gst_player_discover_async (player, uri);
+    g_main_loop_run (state.loop);
+
+    test_discover_check_media_info (state.media_info, uri);
+    if (i > 0)
+      fail_unless_equals_uint64 (gst_player_media_info_get_duration
+          (state.media_info), duration);
+    duration = gst_player_media_info_get_duration (state.media_info);
+    g_object_unref (state.media_info);
+    state.media_info = NULL;
+  }
+
+  g_free (uri);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_cover_art_cb (GstPlayer * player, GstPlayerMediaInfo * info,
+    GstSample * sample, TestPlayerState * state)
+{
+  fail_unless (info == state->media_info);
+  /* The test media has no cover art */
+  fail_unless (sample == NULL);
+  state->test_data = GINT_TO_POINTER (1);
+  g_main_loop_quit (state->loop);
+}
+
+START_TEST (test_cover_art)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+
+  player = gst_player_new ();
+  fail_unless (player != NULL);
+  g_object_set (player, "dispatch-to-main-context", TRUE, NULL);
+  g_signal_connect (player, "media-info-discovered",
+      G_CALLBACK (test_discover_cb), &state);
+  g_signal_connect (player, "cover-art-ready",
+      G_CALLBACK (test_cover_art_cb), &state);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio.ogg", NULL);
+  fail_unless (uri != NULL);
+
+  gst_player_discover_async (player, uri);
+  g_main_loop_run (state.loop);
+  fail_unless (state.media_info != NULL);
+
+  gst_player_request_cover_art (player, state.media_info, 64, 64);
+  g_main_loop_run (state.loop);
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+  fail_unless (gst_player_media_info_get_cover_art (state.media_info, 64,
+          64) == NULL);
+
+  g_object_unref (state.media_info);
+  g_free (uri);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+/* Writes a short Ogg/Vorbis file to @filename with a @width x @height PNG
+ * front cover in its comments */
+static void
+create_media_with_cover_art (const gchar * filename, gint width, gint height)
+{
+  GstElement *pipeline, *enc, *sink;
+  GstSample *raw, *png;
+  GstBuffer *buffer;
+  GstCaps *caps;
+  GstMapInfo map;
+  GstTagList *tags;
+  GstMessage *msg;
+  GError *err = NULL;
+
+  buffer = gst_buffer_new_allocate (NULL, GST_ROUND_UP_4 (width * 3) * height,
+      NULL);
+  gst_buffer_memset (buffer, 0, 0x80, gst_buffer_get_size (buffer));
+  caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, "RGB",
+      "width", G_TYPE_INT, width, "height", G_TYPE_INT, height,
+      "framerate", GST_TYPE_FRACTION, 0, 1, NULL);
+  raw = gst_sample_new (buffer, caps, NULL, NULL);
+  gst_buffer_unref (buffer);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_new_empty_simple ("image/png");
+  png = gst_video_convert_sample (raw, caps, 5 * GST_SECOND, &err);
+  fail_unless (png != NULL, "Failed to encode image: %s",
+      err ? err->message : "unknown error");
+  gst_caps_unref (caps);
+  gst_sample_unref (raw);
+
+  fail_unless (gst_buffer_map (gst_sample_get_buffer (png), &map,
+          GST_MAP_READ));
+  raw = gst_tag_image_data_to_image_sample (map.data, map.size,
+      GST_TAG_IMAGE_TYPE_FRONT_COVER);
+  gst_buffer_unmap (gst_sample_get_buffer (png), &map);
+  gst_sample_unref (png);
+  fail_unless (raw != NULL);
+  tags = gst_tag_list_new (GST_TAG_IMAGE, raw, NULL);
+  gst_sample_unref (raw);
+
+  pipeline = gst_parse_launch ("audiotestsrc num-buffers=20 ! audioconvert "
+      "! vorbisenc name=enc ! oggmux ! filesink name=sink", &err);
+  fail_unless (pipeline != NULL);
+  enc = gst_bin_get_by_name (GST_BIN (pipeline), "enc");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  gst_tag_setter_merge_tags (GST_TAG_SETTER (enc), tags,
+      GST_TAG_MERGE_REPLACE);
+  g_object_set (sink, "location", filename, NULL);
+  gst_object_unref (enc);
+  gst_object_unref (sink);
+  gst_tag_list_unref (tags);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      10 * GST_SECOND, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+static void
+test_cover_art_decoded_cb (GstPlayer * player, GstPlayerMediaInfo * info,
+    GstSample * sample, TestPlayerState * state)
+{
+  fail_unless (info == state->media_info);
+  fail_unless (sample != NULL);
+  state->test_data = gst_sample_ref (sample);
+  g_main_loop_quit (state->loop);
+}
+
+START_TEST (test_cover_art_decoded)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  GstSample *sample, *cached;
+  GstStructure *s;
+  gchar *dir, *filename, *uri;
+  gint width, height;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+
+  dir = g_dir_make_tmp ("gst-player-cover-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  filename = g_build_filename (dir, "cover.ogg", NULL);
+  create_media_with_cover_art (filename, 128, 96);
+  uri = gst_filename_to_uri (filename, NULL);
+  fail_unless (uri != NULL);
+
+  player = gst_player_new ();
+  fail_unless (player != NULL);
+  g_object_set (player, "dispatch-to-main-context", TRUE, NULL);
+  g_signal_connect (player, "media-info-discovered",
+      G_CALLBACK (test_discover_cb), &state);
+  g_signal_connect (player, "cover-art-ready",
+      G_CALLBACK (test_cover_art_decoded_cb), &state);
+
+  gst_player_discover_async (player, uri);
+  g_main_loop_run (state.loop);
+  fail_unless (state.media_info != NULL);
+  fail_unless (gst_player_media_info_get_image_sample (state.media_info) !=
+      NULL);
+
+  /* Scaled down to fit, keeping the aspect ratio */
+  gst_player_request_cover_art (player, state.media_info, 64, 64);
+  g_main_loop_run (state.loop);
+  sample = state.test_data;
+  fail_unless (sample != NULL);
+  s = gst_caps_get_structure (gst_sample_get_caps (sample), 0);
+  fail_unless_equals_string (gst_structure_get_name (s), "video/x-raw");
+  fail_unless_equals_string (gst_structure_get_string (s, "format"), "RGB");
+  fail_unless (gst_structure_get_int (s, "width", &width));
+  fail_unless (gst_structure_get_int (s, "height", &height));
+  fail_unless (width <= 64 && height <= 64);
+  fail_unless_equals_int (width * 96, height * 128);
+
+  /* The decoded image is kept with the media info */
+  cached = gst_player_media_info_get_cover_art (state.media_info, 64, 64);
+  fail_unless (cached != NULL);
+  fail_unless (gst_sample_get_buffer (cached) ==
+      gst_sample_get_buffer (sample));
+  gst_sample_unref (cached);
+  gst_sample_unref (sample);
+
+  g_object_unref (state.media_info);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+  g_unlink (filename);
+  g_rmdir (dir);
+  g_free (uri);
+  g_free (filename);
+  g_free (dir);
+}
+
+END_TEST;
+
+static void
+test_play_resume_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+  GstClockTime position;
+  gchar *uri;
+
+  if (change == STATE_CHANGE_STATE_CHANGED && step == 0
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    gst_player_seek (player, 20 * GST_SECOND);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+  } else if (change == STATE_CHANGE_POSITION_UPDATED && step == 1
+      && new_state->position >= 20 * GST_SECOND) {
+    /* Stopping saves the position, setting the URI again resumes */
+    uri = gst_player_get_uri (player);
+    gst_player_stop (player);
+    gst_player_set_uri (player, uri);
+    gst_player_pause (player);
+    g_free (uri);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+  } else if (change == STATE_CHANGE_STATE_CHANGED && step == 2
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    position = gst_player_get_position (player);
+    fail_unless (position >= 19 * GST_SECOND);
+    fail_unless (position <= 21 * GST_SECOND);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_play_resume)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_play_resume_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  gst_player_set_resume_store_enabled (player, TRUE);
+  fail_unless (gst_player_get_resume_store_enabled (player));
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 3);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+/* Asserts that @stream is tagged with @language, compared as ISO 639-1 */
+static void
+assert_stream_language (GstPlayerStreamInfo * stream, const gchar * language)
+{
+  GstTagList *tags;
+  const gchar *code_1;
+  gchar *code = NULL;
+
+  fail_unless (stream != NULL);
+  tags = gst_player_stream_info_get_tags (stream);
+  fail_unless (tags != NULL);
+  fail_unless (gst_tag_list_get_string (tags, GST_TAG_LANGUAGE_CODE, &code));
+  code_1 = gst_tag_get_language_code_iso_639_1 (code);
+  fail_unless_equals_string (code_1 ? code_1 : code, language);
+  g_free (code);
+}
+
+static void
+test_load_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+  GstPlayerAudioInfo *audio;
+  GstPlayerSubtitleInfo *subtitle;
+  GstClockTime position;
+
+  if (change == STATE_CHANGE_POSITION_UPDATED && step == 0) {
+    /* Nothing before the start position is ever reported */
+    fail_unless (new_state->position >= 9 * GST_SECOND);
+  } else if (change == STATE_CHANGE_STATE_CHANGED && step == 0
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    position = gst_player_get_position (player);
+    fail_unless (position >= 9 * GST_SECOND);
+    fail_unless (position <= 11 * GST_SECOND);
+    fail_unless (gst_player_get_rate (player) == 2.0);
+
+    /* The first subtitle stream is English, the preferred one is picked
+     * before the preroll completes */
+    audio = gst_player_get_current_audio_track (player);
+    assert_stream_language ((GstPlayerStreamInfo *) audio, "en");
+    g_object_unref (audio);
+    subtitle = gst_player_get_current_subtitle_track (player);
+    assert_stream_language ((GstPlayerStreamInfo *) subtitle, "fr");
+    fail_unless (gst_player_stream_info_get_index ((GstPlayerStreamInfo *)
+            subtitle) > 0);
+    g_object_unref (subtitle);
+
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_load)
+{
+  GstPlayer *player;
+  GstPlayerLoadRequest *request;
+  TestPlayerState state;
+  gchar *uri, *loaded_uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_load_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  uri = gst_filename_to_uri (TEST_PATH "/sintel.mkv", NULL);
+  fail_unless (uri != NULL);
+  request = gst_player_load_request_new (uri);
+  gst_player_load_request_set_start_position (request, 10 * GST_SECOND);
+  gst_player_load_request_set_audio_language (request, "en");
+  gst_player_load_request_set_subtitle_language (request, "fre");
+  gst_player_load_request_set_rate (request, 2.0);
+  gst_player_load_request_set_paused (request, TRUE);
+  gst_player_load (player, request);
+  gst_player_load_request_free (request);
+
+  loaded_uri = gst_player_get_uri (player);
+  fail_unless_equals_string (loaded_uri, uri);
+  g_free (loaded_uri);
+  g_free (uri);
+
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_play_from_bytes_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+  GstPlayerMediaInfo *media_info;
+
+  if (change == STATE_CHANGE_STATE_CHANGED && step == 0
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    media_info = gst_player_get_media_info (player);
+    fail_unless (media_info != NULL);
+    fail_unless (gst_player_media_info_is_seekable (media_info));
+    g_object_unref (media_info);
+    fail_unless (GST_CLOCK_TIME_IS_VALID (gst_player_get_duration (player)));
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_play_from_bytes)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  GBytes *bytes;
+  gchar *data;
+  gsize length;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_play_from_bytes_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  fail_unless (g_file_get_contents (TEST_PATH "/audio.ogg", &data, &length,
+          NULL));
+  bytes = g_bytes_new_take (data, length);
+  gst_player_set_uri_from_bytes (player, bytes);
+  g_bytes_unref (bytes);
+
+  /* Not a stream */
+  bytes = g_bytes_new_static ("", 1);
+  fail_if (gst_player_push_bytes (player, bytes));
+  g_bytes_unref (bytes);
+
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_play_from_stream_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+
+  if (change == STATE_CHANGE_END_OF_STREAM) {
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_play_from_stream)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  GBytes *bytes, *chunk;
+  gchar *data;
+  gsize length, offset, size;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_play_from_stream_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  fail_unless (g_file_get_contents (TEST_PATH "/audio-short.ogg", &data,
+          &length, NULL));
+  bytes = g_bytes_new_take (data, length);
+
+  gst_player_set_uri_from_stream (player);
+  gst_player_play (player);
+
+  for (offset = 0; offset < length; offset += size) {
+    size = MIN (4096, length - offset);
+    chunk = g_bytes_new_from_bytes (bytes, offset, size);
+    fail_unless (gst_player_push_bytes (player, chunk));
+    g_bytes_unref (chunk);
+  }
+  gst_player_end_of_bytes (player);
+  fail_if (gst_player_push_bytes (player, bytes));
+  g_bytes_unref (bytes);
+
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+/* Serves files over HTTP/1.1 with range requests and keep-alive */
+typedef struct
+{
+  GSocketService *service;
+  guint16 port;
+  /* Path -> GBytes */
+  GHashTable *files;
+  /* Path -> Location of a 302 response */
+  GHashTable *redirects;
+  gchar *etag;
+  gint connections;
+  gint requests;
+  gint gets;
+  /* Paths of all GET requests, protected by lock */
+  GMutex lock;
+  GPtrArray *paths;
+} TestHttpServer;
+
+static gboolean
+test_http_server_run_cb (GThreadedSocketService * service,
+    GSocketConnection * connection, GObject * source_object,
+    gpointer user_data)
+{
+  TestHttpServer *server = user_data;
+  GDataInputStream *input;
+  GOutputStream *output;
+  const guint8 *data;
+  GBytes *file;
+  gsize size;
+  const gchar *location;
+  gchar *line, *head, *path;
+  gboolean is_head, is_range;
+  guint64 start;
+
+  g_atomic_int_inc (&server->connections);
+  input =
+      g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM
+          (connection)));
+  output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+  /* Requests on the same connection until the client closes it */
+  while ((line = g_data_input_stream_read_line (input, NULL, NULL, NULL))) {
+    is_head = g_str_has_prefix (line, "HEAD ");
+    is_range = FALSE;
+    start = 0;
+    path = strchr (line, ' ');
+    path = path ? g_strndup (path + 1, strcspn (path + 1, " ")) : NULL;
+    g_free (line);
+    file = path ? g_hash_table_lookup (server->files, path) : NULL;
+    data = file ? g_bytes_get_data (file, &size) : NULL;
+    if (!file)
+      size = 0;
+    location = path ? g_hash_table_lookup (server->redirects, path) : NULL;
+
+    while ((line = g_data_input_stream_read_line (input, NULL, NULL, NULL))
+        && strcmp (line, "\r") != 0 && *line) {
+      if (g_ascii_strncasecmp (line, "Range: bytes=", 13) == 0) {
+        start = MIN (g_ascii_strtoull (line + 13, NULL, 10), size);
+        is_range = TRUE;
+      }
+      g_free (line);
+    }
+    if (!line) {
+      g_free (path);
+      break;
+    }
+    g_free (line);
+
+    g_atomic_int_inc (&server->requests);
+    if (!is_head) {
+      g_atomic_int_inc (&server->gets);
+      g_mutex_lock (&server->lock);
+      g_ptr_array_add (server->paths, g_strdup (path));
+      g_mutex_unlock (&server->lock);
+    }
+    g_free (path);
+
+    if (location)
+      head = g_strdup_printf ("HTTP/1.1 302 Found\r\nLocation: %s\r\n",
+          location);
+    else if (!file)
+      head = g_strdup ("HTTP/1.1 404 Not Found\r\n");
+    else if (is_range)
+      head = g_strdup_printf ("HTTP/1.1 206 Partial Content\r\n"
+          "Content-Range: bytes %" G_GUINT64_FORMAT "-%" G_GSIZE_FORMAT "/%"
+          G_GSIZE_FORMAT "\r\n", start, size - 1, size);
+    else
+      head = g_strdup ("HTTP/1.1 200 OK\r\n");
+    line = g_strdup_printf ("%sContent-Length: %" G_GUINT64_FORMAT "\r\n"
+        "Accept-Ranges: bytes\r\nETag: %s\r\n\r\n", head, size - start,
+        server->etag);
+    g_free (head);
+
+    if (!g_output_stream_write_all (output, line, strlen (line), NULL, NULL,
+            NULL) || (!is_head && size > start
+            && !g_output_stream_write_all (output, data + start,
+                size - start, NULL, NULL, NULL))) {
+      g_free (line);
+      break;
+    }
+    g_free (line);
+  }
+
+  g_object_unref (input);
+
+  return TRUE;
+}
+
+static TestHttpServer *
+test_http_server_new (void)
+{
+  TestHttpServer *server;
+
+  server = g_new0 (TestHttpServer, 1);
+  server->files = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) g_bytes_unref);
+  server->redirects = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      g_free);
+  g_mutex_init (&server->lock);
+  server->paths = g_ptr_array_new_with_free_func (g_free);
+  /* Nothing cached by earlier test runs is valid */
+  server->etag = g_strdup_printf ("\"%" G_GINT64_FORMAT "\"",
+      g_get_real_time ());
+  server->service = g_threaded_socket_service_new (4);
+  server->port =
+      g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER
+      (server->service), NULL, NULL);
+  fail_unless (server->port != 0);
+  g_signal_connect (server->service, "run",
+      G_CALLBACK (test_http_server_run_cb), server);
+  g_socket_service_start (server->service);
+
+  return server;
+}
+
+static void
+test_http_server_add_file (TestHttpServer * server, const gchar * path,
+    const gchar * filename)
+{
+  gchar *contents;
+  gsize length;
+
+  fail_unless (g_file_get_contents (filename, &contents, &length, NULL));
+  g_hash_table_insert (server->files, g_strdup (path),
+      g_bytes_new_take (contents, length));
+}
+
+static void
+test_http_server_add_data (TestHttpServer * server, const gchar * path,
+    const gchar * data)
+{
+  g_hash_table_insert (server->files, g_strdup (path),
+      g_bytes_new (data, strlen (data)));
+}
+
+static void
+test_http_server_add_redirect (TestHttpServer * server, const gchar * path,
+    const gchar * location)
+{
+  g_hash_table_insert (server->redirects, g_strdup (path),
+      g_strdup (location));
+}
+
+static void
+test_http_server_free (TestHttpServer * server)
+{
+  g_socket_service_stop (server->service);
+  g_socket_listener_close (G_SOCKET_LISTENER (server->service));
+  g_object_unref (server->service);
+  g_hash_table_unref (server->files);
+  g_hash_table_unref (server->redirects);
+  g_ptr_array_unref (server->paths);
+  g_mutex_clear (&server->lock);
+  g_free (server->etag);
+  g_free (server);
+}
+
+static void
+test_http_cache_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+  GstStructure *stats;
+  guint64 bytes_read = 0, network_bytes = G_MAXUINT64;
+
+  if (change == STATE_CHANGE_END_OF_STREAM && step == 0) {
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_STATE_CHANGED && step == 1
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    stats = gst_player_get_stats (player);
+    fail_unless (gst_structure_get_uint64 (stats, "bytes-read",
+            &bytes_read));
+    fail_unless (gst_structure_get_uint64 (stats, "network-bytes",
+            &network_bytes));
+    gst_structure_free (stats);
+    fail_unless (bytes_read > 0);
+    fail_unless_equals_uint64 (network_bytes, 0);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_STATE_CHANGED && step == 2
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_http_cache)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  TestHttpServer *server;
+  gchar *uri;
+  gint gets;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_http_cache_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  server = test_http_server_new ();
+  test_http_server_add_file (server, "/audio-short.ogg",
+      TEST_PATH "/audio-short.ogg");
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  gst_player_set_http_cache_size (player, 64 * 1024 * 1024);
+  fail_unless_equals_uint64 (gst_player_get_http_cache_size (player),
+      64 * 1024 * 1024);
+
+  uri = g_strdup_printf ("http://127.0.0.1:%u/audio-short.ogg",
+      server->port);
+  gst_player_set_uri (player, uri);
+
+  /* Everything is downloaded once when playing to the end */
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+  gets = g_atomic_int_get (&server->gets);
+  fail_unless (gets > 0);
+  /* The connection of the first request is reused */
+  fail_unless (g_atomic_int_get (&server->connections) <
+      g_atomic_int_get (&server->requests));
+
+  /* And read from the cache when played again */
+  gst_player_stop (player);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+  fail_unless_equals_int (g_atomic_int_get (&server->gets), gets);
+
+  /* Relative redirects are resolved against the redirecting URL */
+  test_http_server_add_redirect (server, "/a/b/redirect",
+      "./../../c/./../audio-short.ogg?from=redirect");
+  test_http_server_add_file (server, "/audio-short.ogg?from=redirect",
+      TEST_PATH "/audio-short.ogg");
+  gst_player_stop (player);
+  uri = g_strdup_printf ("http://127.0.0.1:%u/a/b/redirect", server->port);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 3);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+  test_http_server_free (server);
+}
+
+END_TEST;
+
+static void
+test_adaptive_bitrate_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+
+  if (change == STATE_CHANGE_END_OF_STREAM) {
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+#define TEST_HLS_MEDIA_PLAYLIST(segment) \
+  "#EXTM3U\n#EXT-X-TARGETDURATION:2\n#EXT-X-MEDIA-SEQUENCE:0\n" \
+  "#EXTINF:2.0,\n" segment "\n#EXT-X-ENDLIST\n"
+
+START_TEST (test_adaptive_bitrate)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  TestHttpServer *server;
+  GstElementFactory *factory;
+  guint min_bitrate, max_bitrate, i, segments = 0;
+  gchar *uri;
+
+  factory = gst_element_factory_find ("hlsdemux");
+  if (!factory)
+    return;
+  gst_object_unref (factory);
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_adaptive_bitrate_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  /* The demuxer's default is the first variant */
+  server = test_http_server_new ();
+  test_http_server_add_data (server, "/master.m3u8", "#EXTM3U\n"
+      "#EXT-X-STREAM-INF:BANDWIDTH=20000000\nhigh.m3u8\n"
+      "#EXT-X-STREAM-INF:BANDWIDTH=100000\nlow.m3u8\n");
+  test_http_server_add_data (server, "/high.m3u8",
+      TEST_HLS_MEDIA_PLAYLIST ("high.ogg"));
+  test_http_server_add_data (server, "/low.m3u8",
+      TEST_HLS_MEDIA_PLAYLIST ("low.ogg"));
+  test_http_server_add_file (server, "/high.ogg",
+      TEST_PATH "/audio-short.ogg");
+  test_http_server_add_file (server, "/low.ogg",
+      TEST_PATH "/audio-short.ogg");
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  gst_player_set_adaptive_bitrate_enabled (player, TRUE);
+  fail_unless (gst_player_get_adaptive_bitrate_enabled (player));
+  gst_player_set_bitrate_limits (player, 0, 1000000);
+  gst_player_get_bitrate_limits (player, &min_bitrate, &max_bitrate);
+  fail_unless_equals_int (min_bitrate, 0);
+  fail_unless_equals_int (max_bitrate, 1000000);
+
+  uri = g_strdup_printf ("http://127.0.0.1:%u/master.m3u8", server->port);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+
+  /* Starts low and never goes above the maximum */
+  g_mutex_lock (&server->lock);
+  for (i = 0; i < server->paths->len; i++) {
+    const gchar *path = g_ptr_array_index (server->paths, i);
+
+    if (g_str_has_suffix (path, ".ogg")) {
+      fail_unless_equals_string (path, "/low.ogg");
+      segments++;
+    }
+  }
+  g_mutex_unlock (&server->lock);
+  fail_unless (segments > 0);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+  test_http_server_free (server);
+}
+
+END_TEST;
+
+typedef struct
+{
+  GSocket *socket;
+  GSocketAddress *address;
+} TestUdpSender;
+
+/* Stands in for a live network feed, 20 ms of silence in the format the
+ * source is configured with below */
+static gboolean
+test_low_latency_send_cb (gpointer user_data)
+{
+  TestUdpSender *sender = user_data;
+  gchar samples[320] = { 0, };
+
+  g_socket_send_to (sender->socket, sender->address, samples,
+      sizeof (samples), NULL, NULL);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+test_low_latency_source_setup_cb (GstElement * playbin, GstElement * source,
+    gpointer user_data)
+{
+  GstCaps *caps = gst_caps_from_string ("audio/x-raw, format=S16LE, "
+      "layout=interleaved, rate=8000, channels=1");
+
+  g_object_set (source, "caps", caps, NULL);
+  gst_caps_unref (caps);
+}
+
+static void
+test_low_latency_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+
+  if (change == STATE_CHANGE_POSITION_UPDATED
+      && new_state->state == GST_PLAYER_STATE_PLAYING && step == 0) {
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_low_latency)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  TestUdpSender sender;
+  GInetAddress *loopback;
+  GSocketAddress *address;
+  GSocket *socket;
+  GstElement *playbin, *sink;
+  GstStructure *stats;
+  guint64 delay;
+  gint64 max_lateness;
+  guint16 port;
+  guint send_id;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_low_latency_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  /* Find a free port for the source */
+  loopback = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  address = g_inet_socket_address_new (loopback, 0);
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (g_socket_bind (socket, address, FALSE, NULL));
+  g_object_unref (address);
+  address = g_socket_get_local_address (socket, NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (address));
+  g_object_unref (address);
+  g_object_unref (socket);
+
+  sender.socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  sender.address = g_inet_socket_address_new (loopback, port);
+  g_object_unref (loopback);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  gst_player_set_low_latency_enabled (player, TRUE);
+  fail_unless (gst_player_get_low_latency_enabled (player));
+  gst_player_set_target_latency (player, 200 * GST_MSECOND);
+  fail_unless_equals_uint64 (gst_player_get_target_latency (player),
+      200 * GST_MSECOND);
+
+  playbin = gst_player_get_pipeline (player);
+  g_signal_connect (playbin, "source-setup",
+      G_CALLBACK (test_low_latency_source_setup_cb), NULL);
+
+  uri = g_strdup_printf ("udp://127.0.0.1:%u", port);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  send_id = g_timeout_add (20, test_low_latency_send_cb, &sender);
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+  g_source_remove (send_id);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+
+  stats = gst_player_get_stats (player);
+  fail_unless (gst_structure_get_uint64 (stats, "live-edge-delay", &delay));
+  fail_unless (delay < GST_SECOND);
+  gst_structure_free (stats);
+
+  /* Late buffers are dropped */
+  g_object_get (playbin, "audio-sink", &sink, NULL);
+  g_object_get (sink, "max-lateness", &max_lateness, NULL);
+  fail_unless (max_lateness == 20 * GST_MSECOND);
+  gst_object_unref (sink);
+  gst_object_unref (playbin);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+  g_object_unref (sender.address);
+  g_object_unref (sender.socket);
+}
+
+END_TEST;
+
+/* The rate the sinks currently play at, including the catch-up rate that
+ * gst_player_get_rate() does not report */
+static gdouble
+test_get_pipeline_rate (GstPlayer * player)
+{
+  GstElement *playbin;
+  GstQuery *query;
+  gdouble rate = 0.0;
+
+  playbin = gst_player_get_pipeline (player);
+  query = gst_query_new_segment (GST_FORMAT_TIME);
+  if (gst_element_query (playbin, query))
+    gst_query_parse_segment (query, &rate, NULL, NULL, NULL);
+  gst_query_unref (query);
+  gst_object_unref (playbin);
+
+  return rate;
+}
+
+static void
+test_low_latency_window_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+  gdouble rate;
+
+  if (change == STATE_CHANGE_POSITION_UPDATED
+      && new_state->state == GST_PLAYER_STATE_PLAYING) {
+    if (step == 0) {
+      /* Fall behind by going back to the start of the window */
+      new_state->test_data = GINT_TO_POINTER (step + 1);
+      gst_player_seek (player, 0);
+      return;
+    }
+
+    rate = test_get_pipeline_rate (player);
+    if (step == 1 && rate > 1.05) {
+      fail_unless (rate == 1.1);
+      fail_unless (gst_player_get_rate (player) == 1.0);
+      /* Being within the target again stops catching up */
+      new_state->test_data = GINT_TO_POINTER (step + 1);
+      gst_player_set_target_latency (player, 60 * GST_SECOND);
+    } else if (step == 2 && rate == 1.0) {
+      new_state->test_data = GINT_TO_POINTER (step + 1);
+      g_main_loop_quit (new_state->loop);
+    }
+  } else if (change == STATE_CHANGE_END_OF_STREAM
+      || change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_low_latency_window)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  TestHttpServer *server;
+  GstElementFactory *factory;
+  GString *playlist;
+  gchar *uri, *path;
+  guint i;
+
+  factory = gst_element_factory_find ("hlsdemux");
+  if (!factory)
+    return;
+  gst_object_unref (factory);
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_low_latency_window_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  /* A live playlist without an end, its window is seekable but there is
+   * no duration */
+  server = test_http_server_new ();
+  playlist = g_string_new ("#EXTM3U\n#EXT-X-TARGETDURATION:2\n"
+      "#EXT-X-MEDIA-SEQUENCE:0\n");
+  for (i = 0; i < 8; i++) {
+    g_string_append_printf (playlist, "#EXTINF:2.0,\nsegment%u.ogg\n", i);
+    path = g_strdup_printf ("/segment%u.ogg", i);
+    test_http_server_add_file (server, path, TEST_PATH "/audio-short.ogg");
+    g_free (path);
+  }
+  test_http_server_add_data (server, "/live.m3u8", playlist->str);
+  g_string_free (playlist, TRUE);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  gst_player_set_low_latency_enabled (player, TRUE);
+  gst_player_set_target_latency (player, 0);
+
+  uri = g_strdup_printf ("http://127.0.0.1:%u/live.m3u8", server->port);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+
+  /* Sped up to catch up with the live edge and back to normal */
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 3);
+  fail_unless (gst_player_get_rate (player) == 1.0);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+  test_http_server_free (server);
+}
+
+END_TEST;
+
+static void
+test_player_group_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+
+  if (change == STATE_CHANGE_END_OF_STREAM) {
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    if (step + 1 == 2)
+      g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_player_group)
+{
+  GstPlayer *players[2];
+  GstPlayerGroup *group;
+  GstElement *pipeline;
+  GstClock *clock, *pipeline_clock;
+  TestPlayerState state;
+  GstClockTime base_time;
+  gchar *uri;
+  guint i;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_player_group_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  group = gst_player_group_new (NULL);
+  fail_unless (group != NULL);
+  clock = gst_player_group_get_clock (group);
+  fail_unless (clock != NULL);
+
+  gst_player_group_set_drift_threshold (group, 40 * GST_MSECOND);
+  fail_unless_equals_uint64 (gst_player_group_get_drift_threshold (group),
+      40 * GST_MSECOND);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-short.ogg", NULL);
+  fail_unless (uri != NULL);
+
+  /* Both report to the same state, which counts the EOS */
+  for (i = 0; i < 2; i++) {
+    players[i] = test_player_new (&state);
+    fail_unless (players[i] != NULL);
+    gst_player_set_uri (players[i], uri);
+    gst_player_group_add_player (group, players[i]);
+  }
+  g_free (uri);
+
+  fail_unless (gst_player_group_get_base_time (group) == GST_CLOCK_TIME_NONE);
+  gst_player_group_play (group);
+  base_time = gst_player_group_get_base_time (group);
+  fail_unless (GST_CLOCK_TIME_IS_VALID (base_time));
+
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+  fail_unless (gst_player_group_get_drift (group) <= 40 * GST_MSECOND);
+
+  /* Both ran on the clock of the group and started together */
+  for (i = 0; i < 2; i++) {
+    pipeline = gst_player_get_pipeline (players[i]);
+    pipeline_clock = gst_pipeline_get_clock (GST_PIPELINE (pipeline));
+    fail_unless (pipeline_clock == clock);
+    gst_object_unref (pipeline_clock);
+    fail_unless_equals_uint64 (gst_element_get_base_time (pipeline),
+        base_time);
+    gst_object_unref (pipeline);
+  }
+
+  gst_player_group_stop (group);
+  fail_unless (gst_player_group_get_base_time (group) == GST_CLOCK_TIME_NONE);
+
+  gst_object_unref (clock);
+  g_object_unref (group);
+  for (i = 0; i < 2; i++)
+    g_object_unref (players[i]);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_loop_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  /* The loop never ends on its own */
+  fail_unless (change != STATE_CHANGE_END_OF_STREAM);
+
+  if (change == STATE_CHANGE_ERROR)
+    g_main_loop_quit (new_state->loop);
+}
+
+static void
+loop_iteration_cb (GstPlayer * player, guint iteration,
+    TestPlayerState * state)
+{
+  gint step = GPOINTER_TO_INT (state->test_data);
+
+  fail_unless_equals_int (iteration, step + 1);
+  state->test_data = GINT_TO_POINTER (iteration);
+
+  if (iteration == 2)
+    g_main_loop_quit (state->loop);
+}
+
+START_TEST (test_loop)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  GstClockTime start, end;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_loop_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+  fail_unless (player != NULL);
+  g_signal_connect (player, "loop-iteration", G_CALLBACK (loop_iteration_cb),
+      &state);
+
+  fail_unless (!gst_player_get_loop (player, NULL, NULL));
+  gst_player_set_loop (player, 0, GST_CLOCK_TIME_NONE);
+  fail_unless (gst_player_get_loop (player, &start, &end));
+  fail_unless_equals_uint64 (start, 0);
+  fail_unless (end == GST_CLOCK_TIME_NONE);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-short.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+
+  gst_player_unset_loop (player);
+  fail_unless (!gst_player_get_loop (player, NULL, NULL));
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_unset_loop_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  fail_unless (change != STATE_CHANGE_ERROR);
+
+  if (change == STATE_CHANGE_END_OF_STREAM) {
+    /* Only after the first iteration unset the loop */
+    fail_unless_equals_int (GPOINTER_TO_INT (new_state->test_data), 1);
+    new_state->test_data = GINT_TO_POINTER (2);
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+static void
+unset_loop_iteration_cb (GstPlayer * player, guint iteration,
+    TestPlayerState * state)
+{
+  fail_unless_equals_int (iteration, 1);
+  state->test_data = GINT_TO_POINTER (1);
+  gst_player_unset_loop (player);
+}
+
+START_TEST (test_unset_loop)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_unset_loop_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+  fail_unless (player != NULL);
+  g_signal_connect (player, "loop-iteration",
+      G_CALLBACK (unset_loop_iteration_cb), &state);
+
+  gst_player_set_loop (player, 0, GST_CLOCK_TIME_NONE);
+
+  /* Local files are demuxed in pull mode */
+  uri = gst_filename_to_uri (TEST_PATH "/audio-short.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_frame_step_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+
+  if (change == STATE_CHANGE_STATE_CHANGED && step == 0
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    gst_player_play (player);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+  } else if (change == STATE_CHANGE_POSITION_UPDATED && step == 1
+      && new_state->position >= GST_SECOND) {
+    /* Everything shown until here is cached */
+    gst_player_pause (player);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+  } else if (change == STATE_CHANGE_STATE_CHANGED && step == 2
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    gst_player_step (player, -5);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+  } else if (change == STATE_CHANGE_POSITION_UPDATED && step == 3) {
+    fail_unless (new_state->position < old_state->position);
+    fail_unless (old_state->position - new_state->position < GST_SECOND);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_frame_step)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  GstStructure *stats;
+  guint64 hits;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_frame_step_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+  fail_unless (player != NULL);
+
+  gst_player_set_frame_cache_size (player, 64 * 1024 * 1024);
+  fail_unless_equals_uint64 (gst_player_get_frame_cache_size (player),
+      64 * 1024 * 1024);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 4);
+
+  /* The frame was shown from the cache */
+  stats = gst_player_get_stats (player);
+  fail_unless (gst_structure_get_uint64 (stats, "frame-cache-hits", &hits));
+  fail_unless_equals_uint64 (hits, 1);
+  gst_structure_free (stats);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+typedef struct
+{
+  GstClockTime reverse_position;
+  gboolean reversed;
+} TestReverseState;
+
+static void
+test_reverse_cached_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  TestReverseState *reverse = new_state->test_data;
+
+  if (change == STATE_CHANGE_ERROR || change == STATE_CHANGE_END_OF_STREAM) {
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_POSITION_UPDATED) {
+    if (!GST_CLOCK_TIME_IS_VALID (reverse->reverse_position)
+        && new_state->position >= GST_SECOND) {
+      reverse->reverse_position = new_state->position;
+      gst_player_set_rate (player, -1.0);
+    } else if (GST_CLOCK_TIME_IS_VALID (reverse->reverse_position)
+        && new_state->position + 300 * GST_MSECOND <
+        reverse->reverse_position) {
+      reverse->reversed = TRUE;
+      g_main_loop_quit (new_state->loop);
+    }
+  }
+}
+
+START_TEST (test_reverse_cached)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  TestReverseState reverse;
+  GstStructure *stats;
+  guint64 hits = 0;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_reverse_cached_cb;
+  reverse.reverse_position = GST_CLOCK_TIME_NONE;
+  reverse.reversed = FALSE;
+  state.test_data = &reverse;
+
+  player = test_player_new (&state);
+  fail_unless (player != NULL);
+
+  gst_player_set_frame_cache_size (player, 64 * 1024 * 1024);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless (reverse.reversed);
+
+  /* Reverse playback started with the frames played before */
+  stats = gst_player_get_stats (player);
+  fail_unless (gst_structure_get_uint64 (stats, "frame-cache-hits", &hits));
+  fail_unless_equals_uint64 (hits, 1);
+  gst_structure_free (stats);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_play_half_second_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  if (change == STATE_CHANGE_POSITION_UPDATED
+      && new_state->position >= 500 * GST_MSECOND) {
+    new_state->test_data = GINT_TO_POINTER (1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+/* For tests that play until one of their players is half a second into
+ * its media */
+static void
+test_play_half_second_init (TestPlayerState * state)
+{
+  memset (state, 0, sizeof (*state));
+  state->loop = g_main_loop_new (NULL, FALSE);
+  state->test_callback = test_play_half_second_cb;
+  state->test_data = GINT_TO_POINTER (0);
+}
+
+static void
+test_play_half_second_run (TestPlayerState * state)
+{
+  g_main_loop_run (state->loop);
+  fail_unless_equals_int (GPOINTER_TO_INT (state->test_data), 1);
+}
+
+START_TEST (test_shared_decode)
+{
+  GstPlayer *players[2];
+  TestPlayerState state;
+  GstStructure *stats;
+  guint shared_players;
+  gchar *uri;
+  guint i;
+
+  test_play_half_second_init (&state);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+
+  for (i = 0; i < 2; i++) {
+    players[i] = test_player_new (&state);
+    fail_unless (players[i] != NULL);
+    gst_player_set_shared_decode_enabled (players[i], TRUE);
+    fail_unless (gst_player_get_shared_decode_enabled (players[i]));
+    gst_player_set_uri (players[i], uri);
+    gst_player_play (players[i]);
+  }
+  g_free (uri);
+
+  test_play_half_second_run (&state);
+
+  /* Both play from the same decoding */
+  for (i = 0; i < 2; i++) {
+    stats = gst_player_get_stats (players[i]);
+    fail_unless (gst_structure_get_uint (stats, "shared-decode-players",
+            &shared_players));
+    fail_unless_equals_int (shared_players, 2);
+    gst_structure_free (stats);
+  }
+
+  for (i = 0; i < 2; i++)
+    g_object_unref (players[i]);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+typedef struct
+{
+  gint peak;
+  gboolean probing;
+} TestAudioLevel;
+
+/* Called from the streaming thread, the audio is in the format of the
+ * mixer */
+static GstPadProbeReturn
+test_audio_level_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  TestAudioLevel *level = user_data;
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  const gint16 *samples;
+  GstMapInfo map;
+  gint peak = 0;
+  gsize i;
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return GST_PAD_PROBE_OK;
+
+  samples = (const gint16 *) map.data;
+  for (i = 0; i < map.size / sizeof (gint16); i++)
+    peak = MAX (peak, ABS ((gint) samples[i]));
+  gst_buffer_unmap (buffer, &map);
+
+  if (peak > g_atomic_int_get (&level->peak))
+    g_atomic_int_set (&level->peak, peak);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Measures what the player hands to the mixer, after its volume */
+static void
+test_audio_level_state_changed_cb (GstPlayer * player,
+    GstPlayerState player_state, TestAudioLevel * level)
+{
+  GstElement *playbin, *sink = NULL;
+  GstPad *pad;
+
+  if (player_state != GST_PLAYER_STATE_PLAYING || level->probing)
+    return;
+
+  playbin = gst_player_get_pipeline (player);
+  g_object_get (playbin, "audio-sink", &sink, NULL);
+  gst_object_unref (playbin);
+  fail_unless (sink != NULL);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      test_audio_level_probe_cb, level, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+  level->probing = TRUE;
+}
+
+START_TEST (test_shared_audio_output)
+{
+  GstPlayer *players[2];
+  TestAudioLevel levels[2];
+  TestPlayerState state;
+  GstStructure *stats;
+  guint mixed_players;
+  gchar *uri;
+  guint i;
+
+  test_play_half_second_init (&state);
+  memset (levels, 0, sizeof (levels));
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio.ogg", NULL);
+  fail_unless (uri != NULL);
+
+  for (i = 0; i < 2; i++) {
+    players[i] = test_player_new (&state);
+    fail_unless (players[i] != NULL);
+    gst_player_set_shared_audio_output_enabled (players[i], TRUE);
+    fail_unless (gst_player_get_shared_audio_output_enabled (players[i]));
+    g_signal_connect (players[i], "state-changed",
+        G_CALLBACK (test_audio_level_state_changed_cb), &levels[i]);
+    gst_player_set_uri (players[i], uri);
+    gst_player_play (players[i]);
+  }
+  g_free (uri);
+
+  /* The volume stays the one of each player */
+  gst_player_set_volume (players[0], 0.5);
+  fail_unless (gst_player_get_volume (players[0]) == 0.5);
+  fail_unless (gst_player_get_volume (players[1]) == 1.0);
+
+  test_play_half_second_run (&state);
+
+  /* Both play through the same mixer */
+  for (i = 0; i < 2; i++) {
+    stats = gst_player_get_stats (players[i]);
+    fail_unless (gst_structure_get_uint (stats, "shared-audio-output-players",
+            &mixed_players));
+    fail_unless_equals_int (mixed_players, 2);
+    gst_structure_free (stats);
+  }
+
+  /* The first player is mixed in at half the level of the other */
+  fail_unless (levels[0].peak > 0 && levels[1].peak > 0);
+  fail_unless (ABS (2 * levels[0].peak - levels[1].peak) <=
+      levels[1].peak / 5);
+
+  for (i = 0; i < 2; i++)
+    g_object_unref (players[i]);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+static void
+test_play_clip_warning_cb (GstPlayer * player, GError * err,
+    TestPlayerState * state)
+{
+  /* Only the missing clip fails */
+  fail_unless (strstr (err->message, "foo.ogg") != NULL);
+  state->test_data = GINT_TO_POINTER (1);
+  g_main_loop_quit (state->loop);
+}
+
+START_TEST (test_play_clip)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
+
+  test_play_half_second_init (&state);
+
+  player = test_player_new (&state);
+  fail_unless (player != NULL);
+  g_signal_connect (player, "warning",
+      G_CALLBACK (test_play_clip_warning_cb), &state);
+
+  /* Decoded once, then played again from the cache while still playing */
+  uri = gst_filename_to_uri (TEST_PATH "/audio-short.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_play_clip (player, uri);
+  gst_player_play_clip (player, uri);
+  g_free (uri);
+
+  uri = gst_filename_to_uri (TEST_PATH "/foo.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_play_clip (player, uri);
+  g_free (uri);
+
+  test_play_half_second_run (&state);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+typedef struct
+{
+  GMainLoop *loop;
+  GstPlayer *player;
+  /* Clips the player has to have played */
+  guint64 played;
+  guint64 hits;
+} TestClipCacheState;
+
+static gboolean
+test_clip_cache_poll_cb (gpointer user_data)
+{
+  TestClipCacheState *state = user_data;
+  GstStructure *stats;
+  guint64 misses = 0;
+
+  state->hits = 0;
+  stats = gst_player_get_stats (state->player);
+  gst_structure_get_uint64 (stats, "clip-cache-hits", &state->hits);
+  gst_structure_get_uint64 (stats, "clip-cache-misses", &misses);
+  gst_structure_free (stats);
+
+  if (state->hits + misses < state->played)
+    return G_SOURCE_CONTINUE;
+
+  g_main_loop_quit (state->loop);
+  return G_SOURCE_REMOVE;
+}
+
+START_TEST (test_play_clip_cached)
+{
+  TestClipCacheState state;
+  TestPlayerState player_state;
+  guint64 hits;
+  gchar *uri;
+
+  test_play_half_second_init (&player_state);
+  memset (&state, 0, sizeof (state));
+  state.loop = player_state.loop;
+  state.player = test_player_new (&player_state);
+  fail_unless (state.player != NULL);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-short.ogg", NULL);
+  fail_unless (uri != NULL);
+
+  /* Decoded in the background and played when done, unless an earlier
+   * test cached it already */
+  state.played = 1;
+  gst_player_play_clip (state.player, uri);
+  g_timeout_add (10, test_clip_cache_poll_cb, &state);
+  g_main_loop_run (state.loop);
+  hits = state.hits;
+
+  /* Played from the cache */
+  state.played = 2;
+  gst_player_play_clip (state.player, uri);
+  g_timeout_add (10, test_clip_cache_poll_cb, &state);
+  g_main_loop_run (state.loop);
+  fail_unless_equals_uint64 (state.hits, hits + 1);
+
+  g_free (uri);
+  g_object_unref (state.player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+typedef struct
+{
+  GMainLoop *loop;
+  gboolean playing;
+  gboolean failed;
+  gint width;
+} TestMosaicState;
+
+static void
+test_mosaic_check_done (TestMosaicState * state)
+{
+  if (state->playing && state->failed && state->width > 0)
+    g_main_loop_quit (state->loop);
+}
+
+static void
+test_mosaic_tile_state_changed_cb (GstPlayerMosaic * mosaic, guint tile,
+    GstPlayerState tile_state, TestMosaicState * state)
+{
+  if (tile == 0 && tile_state == GST_PLAYER_STATE_PLAYING) {
+    state->playing = TRUE;
+    test_mosaic_check_done (state);
+  }
+}
+
+static void
+test_mosaic_tile_media_info_updated_cb (GstPlayerMosaic * mosaic,
+    guint tile, GstPlayerMediaInfo * info, TestMosaicState * state)
+{
+  GList *streams = gst_player_get_video_streams (info);
+
+  fail_unless_equals_int (tile, 0);
+  if (streams) {
+    state->width = gst_player_video_info_get_width (streams->data);
+    test_mosaic_check_done (state);
+  }
+}
+
+static void
+test_mosaic_tile_error_cb (GstPlayerMosaic * mosaic, guint tile,
+    GError * err, TestMosaicState * state)
+{
+  /* Only the tile with the missing file fails */
+  fail_unless_equals_int (tile, 1);
+  state->failed = TRUE;
+  test_mosaic_check_done (state);
+}
+
+static void
+test_mosaic_error_cb (GstPlayerMosaic * mosaic, GError * err,
+    TestMosaicState * state)
+{
+  g_main_loop_quit (state->loop);
+}
+
+START_TEST (test_mosaic)
+{
+  GstPlayerMosaic *mosaic;
+  GstPlayerMediaInfo *info;
+  TestMosaicState state;
+  GstElement *sink;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", TRUE, NULL);
+  mosaic = gst_player_mosaic_new (2, 1, 160, 120, sink);
+  fail_unless (mosaic != NULL);
+  fail_unless_equals_int (gst_player_mosaic_get_n_tiles (mosaic), 2);
+
+  g_signal_connect (mosaic, "tile-state-changed",
+      G_CALLBACK (test_mosaic_tile_state_changed_cb), &state);
+  g_signal_connect (mosaic, "tile-media-info-updated",
+      G_CALLBACK (test_mosaic_tile_media_info_updated_cb), &state);
+  g_signal_connect (mosaic, "tile-error",
+      G_CALLBACK (test_mosaic_tile_error_cb), &state);
+  g_signal_connect (mosaic, "error", G_CALLBACK (test_mosaic_error_cb),
+      &state);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_mosaic_set_tile_uri (mosaic, 0, uri);
+  g_free (uri);
+  uri = gst_filename_to_uri (TEST_PATH "/foo.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_mosaic_set_tile_uri (mosaic, 1, uri);
+  g_free (uri);
+
+  gst_player_mosaic_play (mosaic);
+  g_main_loop_run (state.loop);
+
+  fail_unless (state.playing);
+  fail_unless (state.failed);
+  fail_unless (state.width > 0);
+
+  /* The failed tile does not stop the others */
+  fail_unless_equals_int (gst_player_mosaic_get_tile_state (mosaic, 0),
+      GST_PLAYER_STATE_PLAYING);
+  fail_unless_equals_int (gst_player_mosaic_get_tile_state (mosaic, 1),
+      GST_PLAYER_STATE_STOPPED);
+  info = gst_player_mosaic_get_tile_media_info (mosaic, 0);
+  fail_unless (info != NULL);
+  g_object_unref (info);
+
+  gst_player_mosaic_stop (mosaic);
+  g_object_unref (mosaic);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+#ifdef G_OS_UNIX
+static void
+test_mmap_source_cb (GstPlayer * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+  GstStructure *stats;
+  guint64 bytes_read = 0;
+
+  if (change == STATE_CHANGE_STATE_CHANGED && step == 0
+      && new_state->state == GST_PLAYER_STATE_PAUSED) {
+    stats = gst_player_get_stats (player);
+    fail_unless (stats != NULL);
+    fail_unless (gst_structure_get_uint64 (stats, "bytes-read", &bytes_read));
+    fail_unless (bytes_read > 0);
+    fail_unless (gst_structure_has_field (stats, "page-faults"));
+    gst_structure_free (stats);
+    fail_unless (GST_CLOCK_TIME_IS_VALID (gst_player_get_duration (player)));
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_mmap_source)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_mmap_source_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+
+  fail_unless (player != NULL);
+
+  gst_player_set_mmap_source_enabled (player, TRUE);
+  fail_unless (gst_player_get_mmap_source_enabled (player));
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_pause (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 1);
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+START_TEST (test_remote_decode)
+{
+  TestPlayerState state;
+  GstPlayer *player;
+  GstStructure *stats;
+  guint64 latency;
+  gchar *uri;
+
+  test_play_half_second_init (&state);
+
+  /* The helper of this build, not an installed one */
+  g_setenv ("GST_PLAYER_HELPER", TEST_HELPER_PATH, TRUE);
+
+  player = test_player_new (&state);
+  fail_unless (player != NULL);
+  gst_player_set_remote_decode_enabled (player, TRUE);
+  fail_unless (gst_player_get_remote_decode_enabled (player));
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_play (player);
+  test_play_half_second_run (&state);
+
+  /* Answered from what the decoding process reported */
+  fail_unless (GST_CLOCK_TIME_IS_VALID (gst_player_get_duration (player)));
+
+  stats = gst_player_get_stats (player);
+  fail_unless (gst_structure_get_uint64 (stats, "remote-transport-latency",
+          &latency));
+  fail_unless (latency < GST_SECOND);
+  gst_structure_free (stats);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+#endif
+
+START_TEST (test_playlist)
+{
+  GstPlayerPlaylist *playlist;
+  gboolean seen[100] = { FALSE, };
+  gchar *uri, *expected, *first;
+  gint i, index;
+
+  playlist = gst_player_playlist_new (NULL);
+  fail_unless (playlist != NULL);
+  fail_unless (gst_player_playlist_next (playlist) == NULL);
+
+  for (i = 0; i < 100; i++) {
+    uri = g_strdup_printf ("file:///test/%d.ogg", i);
+    gst_player_playlist_add_uri (playlist, uri);
+    g_free (uri);
+  }
+  fail_unless_equals_int (gst_player_playlist_get_length (playlist), 100);
+  fail_unless_equals_int (gst_player_playlist_get_current_index (playlist),
+      -1);
+
+  /* In order, stops at the end */
+  for (i = 0; i < 100; i++) {
+    uri = gst_player_playlist_next (playlist);
+    expected = gst_player_playlist_get_uri (playlist, i);
+    fail_unless_equals_string (uri, expected);
+    g_free (expected);
+    g_free (uri);
+    fail_unless_equals_int (gst_player_playlist_get_current_index
+        (playlist), i);
+  }
+  fail_unless (!gst_player_playlist_has_next (playlist));
+  fail_unless (gst_player_playlist_has_previous (playlist));
+  fail_unless (gst_player_playlist_next (playlist) == NULL);
+
+  /* Repeat modes */
+  gst_player_playlist_set_repeat_mode (playlist,
+      GST_PLAYER_PLAYLIST_REPEAT_ONE);
+  g_free (gst_player_playlist_advance (playlist));
+  fail_unless_equals_int (gst_player_playlist_get_current_index (playlist),
+      99);
+  gst_player_playlist_set_repeat_mode (playlist,
+      GST_PLAYER_PLAYLIST_REPEAT_ALL);
+  fail_unless (gst_player_playlist_has_next (playlist));
+  g_free (gst_player_playlist_advance (playlist));
+  fail_unless_equals_int (gst_player_playlist_get_current_index (playlist),
+      0);
+  g_free (gst_player_playlist_previous (playlist));
+  fail_unless_equals_int (gst_player_playlist_get_current_index (playlist),
+      99);
+  gst_player_playlist_set_repeat_mode (playlist,
+      GST_PLAYER_PLAYLIST_REPEAT_NONE);
+
+  /* Shuffled, the current entry stays and every other is played once */
+  first = gst_player_playlist_set_current_index (playlist, 42);
+  gst_player_playlist_set_shuffle (playlist, TRUE);
+  fail_unless (gst_player_playlist_get_shuffle (playlist));
+  fail_unless_equals_int (gst_player_playlist_get_current_index (playlist),
+      42);
+  /* First in playback order, whatever its index */
+  fail_unless (!gst_player_playlist_has_previous (playlist));
+  fail_unless (gst_player_playlist_has_next (playlist));
+  seen[42] = TRUE;
+  while ((uri = gst_player_playlist_next (playlist))) {
+    index = gst_player_playlist_get_current_index (playlist);
+    fail_unless (index >= 0 && index < 100);
+    fail_if (seen[index]);
+    seen[index] = TRUE;
+    g_free (uri);
+  }
+  for (i = 0; i < 100; i++)
+    fail_unless (seen[i]);
+
+  /* Back in order from the current entry */
+  gst_player_playlist_set_shuffle (playlist, FALSE);
+  g_free (gst_player_playlist_set_current_index (playlist, 42));
+  uri = gst_player_playlist_get_current_uri (playlist);
+  fail_unless_equals_string (uri, first);
+  g_free (uri);
+  g_free (first);
+  g_free (gst_player_playlist_next (playlist));
+  fail_unless_equals_int (gst_player_playlist_get_current_index (playlist),
+      43);
+
+  gst_player_playlist_clear (playlist);
+  fail_unless_equals_int (gst_player_playlist_get_length (playlist), 0);
+  fail_unless (gst_player_playlist_get_current_uri (playlist) == NULL);
+
+  g_object_unref (playlist);
+}
+
+END_TEST;
+
+static void
+test_play_external_subtitle_cb (GstPlayer * player,
+    TestPlayerStateChange change, TestPlayerState * old_state,
+    TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+
+  if (change == STATE_CHANGE_STATE_CHANGED && step == 0
+      && new_state->state == GST_PLAYER_STATE_PLAYING) {
+    gchar *suburi;
+
+    suburi = gst_filename_to_uri (TEST_PATH "/test.srt", NULL);
+    fail_unless (suburi != NULL);
+    fail_unless (gst_player_set_subtitle_uri (player, suburi));
+    g_free (suburi);
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+  } else if (change == STATE_CHANGE_STATE_CHANGED && step == 1) {
+    /* Hot-added without restarting the pipeline */
+    fail_unless (new_state->state != GST_PLAYER_STATE_STOPPED);
+  } else if (change == STATE_CHANGE_MEDIA_INFO_UPDATED && step == 1) {
+    GstPlayerSubtitleInfo *current;
+    GList *list;
+
+    list = gst_player_get_subtitle_streams (new_state->media_info);
+    if (!list)
+      return;
+
+    fail_unless_equals_int (g_list_length (list), 1);
+    fail_unless_equals_int (gst_player_stream_info_get_index (list->data), 0);
+    fail_unless (gst_player_subtitle_info_get_language (list->data) == NULL);
+
+    current = gst_player_get_current_subtitle_track (player);
+    fail_unless (current != NULL);
+    fail_unless_equals_int (gst_player_stream_info_get_index (
+            (GstPlayerStreamInfo *) current), 0);
+    g_object_unref (current);
+
+    new_state->test_data = GINT_TO_POINTER (step + 1);
+    g_main_loop_quit (new_state->loop);
+  } else if (change == STATE_CHANGE_END_OF_STREAM ||
+      change == STATE_CHANGE_ERROR) {
+    g_main_loop_quit (new_state->loop);
+  }
+}
+
+START_TEST (test_play_external_subtitle)
+{
+  GstPlayer *player;
+  TestPlayerState state;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.test_callback = test_play_external_subtitle_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_player_new (&state);
+  fail_unless (player != NULL);
+
+  /* No text stream of its own */
+  uri = gst_filename_to_uri (TEST_PATH "/audio-video.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_player_set_uri (player, uri);
+  g_free (uri);
+
+  gst_player_play (player);
+  g_main_loop_run (state.loop);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 2);
+
+  g_object_unref (player);
+  g_main_loop_unref (state.loop);
+}
+
+END_TEST;
+
+START_TEST (test_subtitle_index)
+{
+  GstPlayerSubtitleIndex *index;
+  GstClockTime start, end;
+  const gchar *text;
+  GError *err = NULL;
+  gchar *uri;
+
+  uri = gst_filename_to_uri (TEST_PATH "/test.srt", NULL);
+  fail_unless (uri != NULL);
+
+  index = gst_player_subtitle_index_new_from_uri (uri, &err);
+  fail_unless (index != NULL);
+  fail_unless (err == NULL);
+  fail_unless_equals_string (gst_player_subtitle_index_get_uri (index), uri);
+  fail_unless_equals_int (gst_player_subtitle_index_get_n_cues (index), 3);
+
+  fail_unless (gst_player_subtitle_index_get_cue (index, 1, &start, &end,
+          &text));
+  fail_unless_equals_uint64 (start, 2 * GST_SECOND);
+  fail_unless_equals_uint64 (end, 3 * GST_SECOND);
+  fail_unless (g_strrstr (text, "Overlapping") != NULL);
+  fail_if (gst_player_subtitle_index_get_cue (index, 3, NULL, NULL, NULL));
+
+  fail_unless_equals_int (gst_player_subtitle_index_find_cue (index, 0), -1);
+  fail_unless_equals_int (gst_player_subtitle_index_find_cue (index,
+          2500 * GST_MSECOND), 0);
+  fail_unless_equals_int (gst_player_subtitle_index_find_cue (index,
+          4 * GST_SECOND), 0);
+  fail_unless_equals_int (gst_player_subtitle_index_find_cue (index,
+          6 * GST_SECOND), -1);
+  fail_unless_equals_int (gst_player_subtitle_index_find_cue (index,
+          8 * GST_SECOND), 2);
+  fail_unless_equals_int (gst_player_subtitle_index_find_cue (index,
+          10 * GST_SECOND), -1);
+
+  fail_unless_equals_int (gst_player_subtitle_index_search (index, "GOODBYE",
+          0), 2);
+  fail_unless_equals_int (gst_player_subtitle_index_search (index, "hello",
+          1), -1);
+
+  gst_player_subtitle_index_unref (index);
+  g_free (uri);
+}
+
+END_TEST;
+
+static void
+remove_dir_recursive (const gchar * path)
+{
+  const gchar *name;
+  GDir *dir;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir) {
+    while ((name = g_dir_read_name (dir))) {
+      gchar *child = g_build_filename (path, name, NULL);
+
+      if (g_file_test (child, G_FILE_TEST_IS_DIR))
+        remove_dir_recursive (child);
+      else
+        g_unlink (child);
+      g_free (child);
+    }
+    g_dir_close (dir);
+  }
+  g_rmdir (path);
+}
+
+typedef struct
+{
+  GMainLoop *loop;
+  GPtrArray *uris;
+} TestScanState;
+
+static void
+test_scan_cb (const gchar * uri, gpointer user_data)
+{
+  TestScanState *state = user_data;
+
+  if (uri)
+    g_ptr_array_add (state->uris, g_strdup (uri));
+  else
+    g_main_loop_quit (state->loop);
+}
+
+static gchar *
+scan_tree_add (const gchar * root, const gchar * name, const gchar * contents,
+    gssize size)
+{
+  gchar *path = g_build_filename (root, name, NULL);
+  gchar *dirname = g_path_get_dirname (path);
+  gchar *uri;
+
+  fail_unless (g_mkdir_with_parents (dirname, 0755) == 0);
+  fail_unless (g_file_set_contents (path, contents, size, NULL));
+  uri = gst_filename_to_uri (path, NULL);
+  g_free (dirname);
+  g_free (path);
+
+  return uri;
+}
+
+START_TEST (test_scan_directory)
+{
+  TestScanState state;
+  GstPlayScan *scan;
+  gchar *root, *contents;
+  gchar *expected[4];
+  gsize size;
+  guint i;
+
+  fail_unless (g_file_get_contents (TEST_PATH "/audio.ogg", &contents, &size,
+          NULL));
+  root = g_dir_make_tmp ("gst-player-scan-XXXXXX", NULL);
+  fail_unless (root != NULL);
+
+  /* Entries are sorted by display name with numbers compared by value,
+   * directories are expanded in place and files that are not media or
+   * that can't be played on their own are skipped */
+  expected[0] = scan_tree_add (root, "a.ogg", contents, size);
+  expected[1] = scan_tree_add (root, "b/2.ogg", contents, size);
+  expected[2] = scan_tree_add (root, "b/10.ogg", contents, size);
+  g_free (scan_tree_add (root, "b/notes.txt", "Not media\n", -1));
+  g_free (scan_tree_add (root, "b/c/empty", "", 0));
+  expected[3] = scan_tree_add (root, "d/e/f/3.ogg", contents, size);
+
+  state.loop = g_main_loop_new (NULL, FALSE);
+  state.uris = g_ptr_array_new_with_free_func (g_free);
+
+  scan = gst_play_scan_new (4, test_scan_cb, &state);
+  gst_play_scan_add (scan, root);
+  gst_play_scan_close (scan);
+  g_main_loop_run (state.loop);
+  gst_play_scan_free (scan);
+
+  fail_unless_equals_int (state.uris->len, G_N_ELEMENTS (expected));
+  for (i = 0; i < G_N_ELEMENTS (expected); i++) {
+    fail_unless_equals_string (g_ptr_array_index (state.uris, i),
+        expected[i]);
+    g_free (expected[i]);
+  }
+
+  g_ptr_array_unref (state.uris);
+  g_main_loop_unref (state.loop);
+  remove_dir_recursive (root);
+  g_free (root);
+  g_free (contents);
+}
+
+END_TEST;
+
+static Suite *
+player_suite (void)
+{
+  Suite *s = suite_create ("GstPlayer");
+
+  TCase *tc_general = tcase_create ("general");
+
+  tcase_set_timeout (tc_general, 120);
+  tcase_add_test (tc_general, test_create_and_free);
+  tcase_add_test (tc_general, test_set_and_get_uri);
+  tcase_add_test (tc_general, test_play_audio_eos);
+  tcase_add_test (tc_general, test_play_audio_video_eos);
+  tcase_add_test (tc_general, test_play_error_invalid_uri);
+  tcase_add_test (tc_general, test_play_error_invalid_uri_and_play);
+  tcase_add_test (tc_general, test_play_media_info);
+  tcase_add_test (tc_general, test_play_stream_selection);
+  tcase_add_test (tc_general, test_play_track_switched);
+  tcase_add_test (tc_general, test_play_stream_disable_enable);
+  tcase_add_test (tc_general, test_play_external_subtitle);
+  tcase_add_test (tc_general, test_subtitle_index);
+  tcase_add_test (tc_general, test_play_chapters);
+  tcase_add_test (tc_general, test_play_keyframe_index);
+  tcase_add_test (tc_general, test_play_scrub);
+  tcase_add_test (tc_general, test_discover);
+  tcase_add_test (tc_general, test_cover_art);
+  tcase_add_test (tc_general, test_cover_art_decoded);
+  tcase_add_test (tc_general, test_playlist);
+  tcase_add_test (tc_general, test_play_resume);
+  tcase_add_test (tc_general, test_load);
+#ifdef G_OS_UNIX
+  tcase_add_test (tc_general, test_mmap_source);
+  tcase_add_test (tc_general, test_remote_decode);
+#endif
+  tcase_add_test (tc_general, test_play_from_bytes);
+  tcase_add_test (tc_general, test_play_from_stream);
+  tcase_add_test (tc_general, test_http_cache);
+  tcase_add_test (tc_general, test_adaptive_bitrate);
+  tcase_add_test (tc_general, test_low_latency);
+  tcase_add_test (tc_general, test_low_latency_window);
+  tcase_add_test (tc_general, test_player_group);
+  tcase_add_test (tc_general, test_loop);
+  tcase_add_test (tc_general, test_unset_loop);
+  tcase_add_test (tc_general, test_frame_step);
+  tcase_add_test (tc_general, test_reverse_cached);
+  tcase_add_test (tc_general, test_shared_decode);
+  tcase_add_test (tc_general, test_shared_audio_output);
+  tcase_add_test (tc_general, test_play_clip);
+  tcase_add_test (tc_general, test_play_clip_cached);
+  tcase_add_test (tc_general, test_mosaic);
+  tcase_add_test (tc_general, test_scan_directory);
+
+  suite_add_tcase (s, tc_general);
+
+  return s;
+}
+
+int
+main (int argc, char **argv)
+{
+  int number_failed;
+  gchar *cache_dir;
+  Suite *s;
+  SRunner *sr;
+
+  /* Keyframe indices, resume positions, discovered media info and HTTP
+   * downloads are cached, keep them out of the user's cache directory */
+  cache_dir = g_dir_make_tmp ("gst-player-test-XXXXXX", NULL);
+  fail_unless (cache_dir != NULL);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  gst_init (NULL, NULL);
+
+  GST_DEBUG_CATEGORY_INIT (test_debug, "test", 0, "GstPlayer test");
+
+  s = player_suite ();
+  sr = srunner_create (s);
+
+  srunner_run_all (sr, CK_NORMAL);
+
+  number_failed = srunner_ntests_failed (sr);
+
+  srunner_free (sr);
+
+  remove_dir_recursive (cache_dir);
+  g_free (cache_dir);
 
-  srunner_free (sr);
   return (number_failed == 0) ? 0 : -1;
 }